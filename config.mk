@@ -19,6 +19,11 @@ __CONFIG_LIBC_SCANF_FLOAT ?= y
 # wrap standard input/output/error functions
 __CONFIG_LIBC_WRAP_STDIO ?= y
 
+# defer stdout: printf stores the format and arguments in a ring, a low
+# priority task formats and writes them (needs __CONFIG_LIBC_WRAP_STDIO);
+# printf then returns the size of the stored record, not the output length
+__CONFIG_LIBC_STDIO_DEFERRED ?= n
+
 # heap managed by stdlib
 __CONFIG_MALLOC_USE_STDLIB ?= y
 
@@ -47,11 +52,30 @@ __CONFIG_LWIP_V1 ?= y
 #   - 0x02100000: mbed TLS 2.16.0
 __CONFIG_MBEDTLS_VER ?= 0x02100000
 
+# mbed TLS configuration, for mbed TLS 2.16.0 only
+#   - 0: config-xr-mini-cliserv.h, RSA key exchange, AES-CBC
+#   - 1: config-xr-ecdhe.h, TLS 1.2 ECDHE-ECDSA/ECDHE-RSA (P-256, X25519),
+#        AES-GCM and ChaCha20-Poly1305
+__CONFIG_MBEDTLS_PROFILE ?= 0
+
+# mbed TLS crypto engine offload, for mbed TLS 2.16.0 only
+#   - y: AES (ECB/CBC/CTR), AES-GCM, SHA-1 and SHA-256 run on the CE,
+#        needs PRJCONF_CE_EN
+#   - n: software implementation
+__CONFIG_MBEDTLS_CE_ALT ?= n
+
 # mbuf implementation mode
 #   - mode 0: continuous memory allocated from heap
 #   - mode 1: continuous memory allocated from lwip pbuf
 __CONFIG_MBUF_IMPL_MODE ?= 0
 
+# FatFs write-back sector cache with read ahead for the SD card
+# (src/fs/fatfs/driver/blk_cache.h)
+__CONFIG_FATFS_BLK_CACHE ?= n
+
+# FatFs RAM disk as physical drive 1, see RAM_disk_setup()
+__CONFIG_FATFS_RAM_DISK ?= n
+
 # wlan
 __CONFIG_WLAN ?= y
 
@@ -272,6 +296,10 @@ ifeq ($(__CONFIG_LIBC_WRAP_STDIO), y)
   CONFIG_SYMBOLS += -D__CONFIG_LIBC_WRAP_STDIO
 endif
 
+ifeq ($(__CONFIG_LIBC_STDIO_DEFERRED), y)
+  CONFIG_SYMBOLS += -D__CONFIG_LIBC_STDIO_DEFERRED
+endif
+
 ifeq ($(__CONFIG_MALLOC_USE_STDLIB), y)
   CONFIG_SYMBOLS += -D__CONFIG_MALLOC_USE_STDLIB
 endif
@@ -294,9 +322,22 @@ ifeq ($(__CONFIG_LWIP_V1), y)
 endif
 
 CONFIG_SYMBOLS += -D__CONFIG_MBEDTLS_VER=$(__CONFIG_MBEDTLS_VER)
+CONFIG_SYMBOLS += -D__CONFIG_MBEDTLS_PROFILE=$(__CONFIG_MBEDTLS_PROFILE)
+
+ifeq ($(__CONFIG_MBEDTLS_CE_ALT), y)
+  CONFIG_SYMBOLS += -D__CONFIG_MBEDTLS_CE_ALT
+endif
 
 CONFIG_SYMBOLS += -D__CONFIG_MBUF_IMPL_MODE=$(__CONFIG_MBUF_IMPL_MODE)
 
+ifeq ($(__CONFIG_FATFS_BLK_CACHE), y)
+  CONFIG_SYMBOLS += -D__CONFIG_FATFS_BLK_CACHE
+endif
+
+ifeq ($(__CONFIG_FATFS_RAM_DISK), y)
+  CONFIG_SYMBOLS += -D__CONFIG_FATFS_RAM_DISK
+endif
+
 ifeq ($(__CONFIG_WLAN), y)
   CONFIG_SYMBOLS += -D__CONFIG_WLAN
 else
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _AUDIO_DSP_BIQUAD_EQ_H_
+#define _AUDIO_DSP_BIQUAD_EQ_H_
+
+#include <stdint.h>
+#include "audio/eq/eq.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Equalizer of up to BIQUAD_EQ_BANDS_MAX biquads in cascade, for 16-bit
+ * interleaved PCM of 1 or 2 channels. The bands take the same parameters as
+ * libeq (eq_core_prms_t), so either can be used.
+ *
+ * Each band is a direct form I biquad with Q31 coefficients (with a shift
+ * per band for gains above 1) and a 64-bit accumulator. The samples run
+ * through the cascade in blocks, as 32-bit values with BIQUAD_EQ_HEADROOM
+ * bits above full scale; every band saturates rather than wraps.
+ *
+ * A band can be changed while running: its coefficients move to the new
+ * ones in steps of BIQUAD_EQ_RAMP_STEP frames over BIQUAD_EQ_RAMP frames.
+ * The state of a direct form I biquad is the signal itself, so it stays
+ * valid while the coefficients move, and a straight line between two stable
+ * filters is stable all along.
+ *
+ * The caller serializes the access, e.g. changing a band from another thread
+ * than the one processing needs a lock around both.
+ */
+
+#define BIQUAD_EQ_BANDS_MAX		10
+#define BIQUAD_EQ_CHANNELS_MAX	2
+#define BIQUAD_EQ_BLOCK			64		/* frames through the cascade at a time */
+#define BIQUAD_EQ_HEADROOM		4		/* bits, 24 dB */
+
+#ifndef BIQUAD_EQ_RAMP_STEP
+#define BIQUAD_EQ_RAMP_STEP		32		/* frames between coefficient steps */
+#endif
+
+#ifndef BIQUAD_EQ_RAMP
+#define BIQUAD_EQ_RAMP			1024	/* frames to change a band */
+#endif
+
+struct biquad_band {
+	int32_t		coef[5];	/* b0 b1 b2 -a1 -a2, Q(31 - shift) */
+	int32_t		shift;
+	int32_t		target[5];
+	int32_t		target_shift;
+	int32_t		delta[5];
+	uint16_t	steps;		/* coefficient steps left to the target */
+	uint16_t	flat;		/* coef is a pass-through, nothing to do */
+	eq_core_prms_t prms;
+};
+
+typedef struct biquad_eq {
+	uint32_t	rate;
+	uint16_t	channels;
+	uint16_t	bands;
+	uint16_t	ramp_left;	/* frames to the next coefficient step */
+	uint8_t		ramping;	/* a band or the preamp has steps left */
+	uint8_t		running;	/* processed since the reset, changes ramp */
+	int32_t		preamp;		/* Q31, <= 1 */
+	int32_t		preamp_target;
+	int32_t		preamp_delta;
+	uint16_t	preamp_steps;
+	uint16_t	auto_headroom;
+	float		preamp_db;
+	struct biquad_band band[BIQUAD_EQ_BANDS_MAX];
+	int32_t		state[BIQUAD_EQ_BANDS_MAX][BIQUAD_EQ_CHANNELS_MAX][4];	/* x1 x2 y1 y2 */
+	int32_t		buf[BIQUAD_EQ_BLOCK * BIQUAD_EQ_CHANNELS_MAX];
+} biquad_eq_t;
+
+int biquad_eq_init(biquad_eq_t *eq, uint32_t rate, uint32_t channels, uint32_t bands);
+int biquad_eq_set_band(biquad_eq_t *eq, uint32_t band, const eq_core_prms_t *prms);
+void biquad_eq_set_preamp(biquad_eq_t *eq, float db, int auto_headroom);
+float biquad_eq_peak_gain(const biquad_eq_t *eq);
+void biquad_eq_reset(biquad_eq_t *eq);
+void biquad_eq_process(biquad_eq_t *eq, int16_t *pcm, uint32_t frames);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _AUDIO_DSP_BIQUAD_EQ_H_ */
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _AUDIO_DSP_RESAMPLER_H_
+#define _AUDIO_DSP_RESAMPLER_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Sample rate converter for 16-bit interleaved PCM of 1 or 2 channels,
+ * between any two rates of RESAMPLER_RATE_MIN to RESAMPLER_RATE_MAX.
+ *
+ * Each output sample is a windowed-sinc FIR over the input, the filter phase
+ * following the output position between input samples. When the reduced
+ * ratio out/in has few enough phases they are all in the table, otherwise the
+ * table holds a power of 2 of them and the two closest are interpolated.
+ * Going down the filter cutoff follows the output rate and the filter grows
+ * with the ratio, up to RESAMPLER_TAPS_MAX.
+ *
+ * All the state lives in resampler_t, nothing is allocated, and it carries
+ * over from one resampler_process() to the next, so a stream can be fed in
+ * buffers of any size without clicks at the buffer edges.
+ */
+
+#define RESAMPLER_CHANNELS_MAX	2
+#define RESAMPLER_RATE_MIN		8000
+#define RESAMPLER_RATE_MAX		48000
+
+#ifndef RESAMPLER_TAPS
+#define RESAMPLER_TAPS			32		/* filter taps up sampling, multiple of 4 */
+#endif
+
+#ifndef RESAMPLER_TAPS_MAX
+#define RESAMPLER_TAPS_MAX		128		/* filter taps down sampling */
+#endif
+
+#ifndef RESAMPLER_COEF_MAX
+#define RESAMPLER_COEF_MAX		(33 * RESAMPLER_TAPS)	/* (phases + 1) * taps */
+#endif
+
+#define RESAMPLER_BLOCK			128		/* input frames taken at a time */
+
+typedef struct resampler {
+	uint32_t	in_rate;
+	uint32_t	out_rate;
+	uint16_t	channels;
+	uint16_t	taps;
+	uint16_t	phases;		/* rows of coef, less the last one if interp */
+	uint16_t	interp;		/* interpolate between phases */
+	uint32_t	l;			/* out / in, reduced */
+	uint32_t	m;
+	uint32_t	step;		/* whole input frames per output frame */
+	uint32_t	frac_step;	/* and the rest, in 1/l */
+	uint32_t	frac;		/* position between input frames, in 1/l */
+	uint32_t	scale;		/* frac * scale >> 17 = phase in Q15 (interp) */
+	uint32_t	pos;		/* first frame of the filter in buf */
+	uint32_t	fill;		/* frames in buf */
+	int16_t		coef[RESAMPLER_COEF_MAX] __attribute__((aligned(4)));	/* Q14 */
+	int16_t		buf[RESAMPLER_CHANNELS_MAX][RESAMPLER_TAPS_MAX + RESAMPLER_BLOCK]
+	               __attribute__((aligned(4)));
+} resampler_t;
+
+int resampler_init(resampler_t *rs, uint32_t in_rate, uint32_t out_rate, uint32_t channels);
+void resampler_reset(resampler_t *rs);
+uint32_t resampler_out_frames(const resampler_t *rs, uint32_t in_frames);
+void resampler_process(resampler_t *rs, const int16_t *in, uint32_t *in_frames,
+                       int16_t *out, uint32_t *out_frames);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _AUDIO_DSP_RESAMPLER_H_ */
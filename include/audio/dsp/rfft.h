@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _AUDIO_DSP_RFFT_H_
+#define _AUDIO_DSP_RFFT_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Fixed-point FFT of real input, RFFT_SIZE_MIN to RFFT_SIZE_MAX points, a
+ * power of 2. The n real samples are taken as n/2 complex ones and go through
+ * a radix-4 complex FFT (radix-2 for the last stage when log2(n/2) is odd),
+ * then one pass splits the result into the spectrum of the real signal.
+ * Twiddle factors come from a quarter-wave table shared by all the sizes.
+ *
+ * The transforms work in place. The spectrum of n points is packed into the
+ * same n values:
+ *   buf[0] = X[0].re, buf[1] = X[n/2].re (both are real),
+ *   buf[2k] = X[k].re, buf[2k + 1] = X[k].im for 0 < k < n/2.
+ *
+ * The forward transform gives X / n: every stage halves its result, so it
+ * cannot overflow. The inverse is not scaled, so rifft(rfft(x)) = x; a
+ * spectrum whose signal would be out of range saturates.
+ */
+
+#define RFFT_SIZE_MIN	64
+#define RFFT_SIZE_MAX	4096
+
+typedef struct rfft {
+	uint16_t	n;			/* real points */
+	uint16_t	bits;		/* log2(n / 2) */
+	uint16_t	stride;		/* RFFT_SIZE_MAX / n, table step of the split twiddles */
+} rfft_t;
+
+int rfft_init(rfft_t *fft, uint32_t n);
+void rfft_q31(const rfft_t *fft, int32_t *buf);
+void rifft_q31(const rfft_t *fft, int32_t *buf);
+void rfft_q15(const rfft_t *fft, int16_t *buf);
+void rifft_q15(const rfft_t *fft, int16_t *buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _AUDIO_DSP_RFFT_H_ */
@@ -84,5 +84,6 @@ int CedarxThreadStackSizeSet(CDX_THREAD_NAME name, int size);
 int SoundStreamListInit(void);
 int SoundStreamRegisterCard(void);
 int SoundStreamRegisterReverb(void);
+int SoundStreamRegisterTone(void);
 
 #endif
@@ -96,6 +96,8 @@ typedef enum _SoundCtrlCmd
     SOUND_CONTROL_CLEAR_OUTPUT_CONFIG,
     SOUND_CONTROL_SET_EQ_MODE,
     SOUND_CONTROL_CLEAR_EQ_MODE,
+    SOUND_CONTROL_SET_GAIN,
+    SOUND_CONTROL_SET_DUCK,
 }SoundCtrlCmd;
 
 static inline void SoundDeviceDestroy(SoundCtrl* s)
@@ -195,6 +197,7 @@ static inline int SoundDeviceControl(SoundCtrl* s, int cmd, void* para)
 }
 
 SoundCtrl* SoundDeviceCreate();
+SoundCtrl* SoundDeviceCreateTone();
 
 #ifdef __cplusplus
 }
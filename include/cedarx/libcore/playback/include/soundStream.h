@@ -44,6 +44,7 @@ typedef enum {
     STREAM_TYPE_SOUND_CARD   = 0,
     STREAM_TYPE_REVERB_PCM   = 1,
     STREAM_TYPE_CUSTOMER     = 2,
+    STREAM_TYPE_SOUND_TONE   = 3,   /* mixed over the sound card, ducking it */
 } SoundStreamType;
 
 typedef enum {
@@ -54,6 +55,8 @@ typedef enum {
     STREAM_CMD_SET_BLOCK_MODE,
     STREAM_CMD_SET_EQ_MODE,
     STREAM_CMD_CLEAR_EQ_MODE,
+    STREAM_CMD_SET_GAIN,            /* int *, dB, of a mixed stream */
+    STREAM_CMD_SET_DUCK,            /* int *, dB, other streams are lowered by while a tone plays */
 } SoundStreamCmd;
 
 typedef enum {
@@ -72,6 +72,9 @@ typedef struct cJSON
 
     /* The item's name string, if this item is the child of, or is in the list of subitems of an object. */
     char *string;
+
+    /* Key lookup table of a large object, built on demand and dropped when the object changes. Internal. */
+    struct cJSON_Index *index;
 } cJSON;
 
 typedef struct cJSON_Hooks
@@ -102,7 +105,11 @@ extern int	  cJSON_GetArraySize(const cJSON *array);
 /* Retrieve item number "item" from array "array". Returns NULL if unsuccessful. */
 extern cJSON *cJSON_GetArrayItem(const cJSON *array, int item);
 /* Get item "string" from object. Case insensitive. */
+/* Objects with many keys get a hashed index on first lookup, so repeated lookups don't walk the list. */
+/* The cJSON_* calls keep it up to date; code that relinks ->child/->next or renames ->string itself must not mix that with lookups. */
 extern cJSON *cJSON_GetObjectItem(const cJSON *object, const char *string);
+/* Same as cJSON_GetObjectItem, but the key must match exactly, which is faster. */
+extern cJSON *cJSON_GetObjectItemCaseSensitive(const cJSON *object, const char *string);
 extern int cJSON_HasObjectItem(const cJSON *object, const char *string);
 /* For analysing failed parses. This returns a pointer to the parse error. You'll probably need to look a few chars back to make sense of it. Defined when cJSON_Parse() returns 0. 0 when cJSON_Parse() succeeds. */
 extern const char *cJSON_GetErrorPtr(void);
@@ -156,6 +163,27 @@ The item->next and ->prev pointers are always zero on return from Duplicate. */
 /* ParseWithOpts allows you to require (and check) that the JSON is null terminated, and to retrieve the pointer to the final byte parsed. */
 /* If you supply a ptr in return_parse_end and parsing fails, then return_parse_end will contain a pointer to the error. If not, then cJSON_GetErrorPtr() does the job. */
 extern cJSON *cJSON_ParseWithOpts(const char *value, const char **return_parse_end, int require_null_terminated);
+/* ParseWithLength reads at most length bytes of value, which doesn't need to be null terminated (e.g. a received packet). */
+extern cJSON *cJSON_ParseWithLength(const char *value, size_t length);
+extern cJSON *cJSON_ParseWithLengthOpts(const char *value, size_t length, const char **return_parse_end, int require_null_terminated);
+
+/* Parse into a caller supplied block instead of one malloc per node and string.
+ * Trees parsed this way must not be passed to cJSON_Delete, nor to any call that frees or
+ * replaces their items; they are released all at once by cJSON_ResetArena (or by dropping the block).
+ * A failed parse gives back the arena space it used. Several trees may share one arena. */
+typedef struct cJSON_Arena
+{
+    char *block;
+    size_t size;
+    size_t used;
+} cJSON_Arena;
+
+extern void cJSON_InitArena(cJSON_Arena *arena, void *block, size_t size);
+extern void cJSON_ResetArena(cJSON_Arena *arena);
+extern cJSON *cJSON_ParseArena(cJSON_Arena *arena, const char *value, size_t length, const char **return_parse_end);
+/* InSitu also keeps the strings in value itself: they are unescaped in place and null terminated over
+ * their closing quote, so value must be writable and outlive the tree, and is clobbered even if parsing fails. */
+extern cJSON *cJSON_ParseArenaInSitu(cJSON_Arena *arena, char *value, size_t length, const char **return_parse_end);
 
 extern void cJSON_Minify(char *json);
 
@@ -0,0 +1,146 @@
+/*
+  Copyright (c) 2009 Dave Gamble
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#ifndef cJSON_Stream__h
+#define cJSON_Stream__h
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stddef.h>
+#include "cjson/cJSON.h"
+
+/* Limits how deeply objects and arrays may nest, one bit of state per level */
+#define CJSON_STREAM_NESTING_LIMIT 32
+
+/*
+ * Pull parser: feed the document in chunks as they arrive (e.g. from HTTPC_read or an MQTT
+ * payload) and call cJSON_ReaderNext until it asks for more. Neither the document nor a tree
+ * is kept in memory, only the current key, string or number in a caller supplied buffer.
+ */
+typedef enum
+{
+    cJSON_StreamNeedMore = 0,   /* chunk used up: cJSON_ReaderFeed (or cJSON_ReaderFinish) and call again */
+    cJSON_StreamObjectStart,
+    cJSON_StreamObjectEnd,
+    cJSON_StreamArrayStart,
+    cJSON_StreamArrayEnd,
+    cJSON_StreamKey,            /* token holds the key of the next value */
+    cJSON_StreamString,         /* token holds the (rest of the) string */
+    cJSON_StreamStringPart,     /* token holds a leading piece of a string longer than the buffer */
+    cJSON_StreamNumber,         /* number holds the value, token its text */
+    cJSON_StreamTrue,
+    cJSON_StreamFalse,
+    cJSON_StreamNull,
+    cJSON_StreamEnd,            /* the document is complete, later input is only checked by calling again */
+    cJSON_StreamError           /* malformed input, offset tells where */
+} cJSON_StreamEvent;
+
+typedef struct cJSON_Reader
+{
+    /* valid after an event, until the next call */
+    char *token;            /* unescaped, null terminated */
+    size_t token_length;
+    double number;
+    int depth;              /* nesting level, 1 inside the top-level container */
+    unsigned long offset;   /* input bytes consumed */
+
+    /* private */
+    const char *in;
+    size_t in_length;
+    size_t in_pos;
+    size_t token_size;
+    unsigned long containers;
+    unsigned char expect;
+    unsigned char lex;
+    unsigned char lex_count;
+    unsigned char is_key;
+    unsigned char finished;
+    unsigned char token_taken;
+    unsigned int uc;
+    unsigned int uc_high;
+} cJSON_Reader;
+
+/* buffer bounds the longest key and number, longer strings are split into StringPart events. 32 bytes minimum, */
+/* which holds any number cJSON prints. */
+extern void cJSON_ReaderInit(cJSON_Reader *reader, char *buffer, size_t size);
+/* The chunk is not copied, it must stay valid until cJSON_ReaderNext returns cJSON_StreamNeedMore. */
+extern void cJSON_ReaderFeed(cJSON_Reader *reader, const char *data, size_t length);
+/* No more input will follow, so a trailing top-level number can complete. */
+extern void cJSON_ReaderFinish(cJSON_Reader *reader);
+extern cJSON_StreamEvent cJSON_ReaderNext(cJSON_Reader *reader);
+
+/*
+ * Streaming writer: renders unformatted JSON into a fixed buffer and hands it to flush
+ * whenever it fills up, so the document never has to exist as a whole.
+ * flush returns 0 on success, anything else aborts the write.
+ */
+typedef int (*cJSON_WriterFlush)(void *arg, const char *data, size_t length);
+
+typedef struct cJSON_Writer
+{
+    char *buffer;
+    size_t size;
+    size_t length;
+    cJSON_WriterFlush flush;
+    void *arg;
+    unsigned long total;    /* bytes produced so far */
+
+    /* private */
+    unsigned long containers;
+    int depth;
+    unsigned char need_comma;
+    unsigned char in_string;
+    unsigned char done;
+    unsigned char error;
+} cJSON_Writer;
+
+extern void cJSON_WriterInit(cJSON_Writer *writer, char *buffer, size_t size, cJSON_WriterFlush flush, void *arg);
+
+/* key names the value inside an object and must be NULL anywhere else. These return 1 on success and 0 on failure, */
+/* a failure sticks until the writer is initialised again. */
+extern int cJSON_WriteObjectStart(cJSON_Writer *writer, const char *key);
+extern int cJSON_WriteObjectEnd(cJSON_Writer *writer);
+extern int cJSON_WriteArrayStart(cJSON_Writer *writer, const char *key);
+extern int cJSON_WriteArrayEnd(cJSON_Writer *writer);
+extern int cJSON_WriteString(cJSON_Writer *writer, const char *key, const char *string);
+extern int cJSON_WriteNumber(cJSON_Writer *writer, const char *key, double number);
+extern int cJSON_WriteBool(cJSON_Writer *writer, const char *key, int boolean);
+extern int cJSON_WriteNull(cJSON_Writer *writer, const char *key);
+/* json is copied verbatim, it must be a complete value */
+extern int cJSON_WriteRaw(cJSON_Writer *writer, const char *key, const char *json);
+/* Stream a string too long to hold at once (e.g. base64 of a file) as Begin, any number of Data, End */
+extern int cJSON_WriteStringBegin(cJSON_Writer *writer, const char *key);
+extern int cJSON_WriteStringData(cJSON_Writer *writer, const char *data, size_t length);
+extern int cJSON_WriteStringEnd(cJSON_Writer *writer);
+/* Render a tree (or subtree) into the stream without printing it to memory first */
+extern int cJSON_WriteItem(cJSON_Writer *writer, const char *key, const cJSON *item);
+/* Flush what is left; fails if the document is incomplete */
+extern int cJSON_WriterFinish(cJSON_Writer *writer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
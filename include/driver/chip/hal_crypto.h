@@ -399,10 +399,12 @@ HAL_Status HAL_MD5_Finish(CE_MD5_Handler *hdl, uint32_t digest[4]);
 HAL_Status HAL_SHA1_Init(CE_SHA1_Handler *hdl, CE_Hash_IVsrc src, const uint32_t iv[5]);
 HAL_Status HAL_SHA1_Append(CE_SHA1_Handler *hdl, uint8_t *data, uint32_t size);
 HAL_Status HAL_SHA1_Finish(CE_SHA1_Handler *hdl, uint32_t digest[5]);
+HAL_Status HAL_SHA1_Compress(uint32_t state[5], const uint8_t *data, uint32_t size);
 
 HAL_Status HAL_SHA256_Init(CE_SHA256_Handler *hdl, CE_Hash_IVsrc src, const uint32_t iv[8]);
 HAL_Status HAL_SHA256_Append(CE_SHA256_Handler *hdl, uint8_t *data, uint32_t size);
 HAL_Status HAL_SHA256_Finish(CE_SHA256_Handler *hdl, uint32_t digest[8]);
+HAL_Status HAL_SHA256_Compress(uint32_t state[8], const uint8_t *data, uint32_t size);
 HAL_Status HAL_PRNG_SetSeed(uint32_t seed[6]);
 HAL_Status HAL_PRNG_Generate(uint8_t *random, uint32_t size);
 
@@ -47,6 +47,21 @@
 /* This option switches fast seek function. (0:Disable or 1:Enable) */
 
 
+#define	_USE_EXTMAP		8
+/* This option sets the number of extents (runs of contiguous clusters) each file
+/  object remembers while following its cluster chain, so that seeking back or
+/  reading the file again does not walk the FAT from the top. The map is built
+/  automatically. (0:Disable) */
+
+
+#define	_EXTMAP_FILES	4
+/* This option sets how many open files of each volume can hold an extent map at
+/  a time. The maps are kept in a static table outside the FIL, which leaves the
+/  layout of FIL unchanged for prebuilt libraries. A file opened while the table
+/  is full simply follows the FAT. Each entry costs 8 + 12 * _USE_EXTMAP bytes per
+/  volume. This option has no effect when _USE_EXTMAP is 0. */
+
+
 #define	_USE_EXPAND		0
 /* This option switches f_expand function. (0:Disable or 1:Enable) */
 
@@ -146,7 +161,11 @@
 / Drive/Volume Configurations
 /---------------------------------------------------------------------------*/
 
+#ifdef __CONFIG_FATFS_RAM_DISK
+#define _VOLUMES	2
+#else
 #define _VOLUMES	1
+#endif
 /* Number of volumes (logical drives) to be used. (1-10) */
 
 
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _FS_NORFS_H_
+#define _FS_NORFS_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Flash file system for a data partition of the SPI NOR flash.
+ *
+ * The area is a log of 4K blocks. Every change is appended as a record: file
+ * data in chunks of up to NORFS_CHUNK_SIZE bytes, or the name and size of a
+ * file. Records are never rewritten, a record only counts once its state
+ * byte is written after the rest, so a power cut loses at most the records
+ * being written and never leaves a damaged file system. The file index is
+ * kept in RAM and rebuilt by reading the log at mount.
+ *
+ * Space of outdated records is reclaimed by copying the live records of the
+ * block with the most outdated data and erasing it, a reclaim cut by a power
+ * loss is undone at mount. One free block is kept for reclaiming, a full file
+ * system still deletes files. New blocks are taken in
+ * order of erase count, and blocks of data that never changes are moved now
+ * and then, so the erases spread over the whole area.
+ *
+ * Names are up to NORFS_NAME_MAX bytes, there are no directories but names
+ * may contain '/'.
+ */
+
+#define NORFS_BLOCK_SIZE	(4 * 1024)	/* erase unit */
+#define NORFS_NAME_MAX		(31)
+
+#ifndef NORFS_CHUNK_SIZE
+#define NORFS_CHUNK_SIZE	(512)		/* max data per record, 1020 at most */
+#endif
+
+#ifndef NORFS_CACHE_LINES
+#define NORFS_CACHE_LINES	(4)			/* chunks kept by the read cache */
+#endif
+
+/* error codes */
+#define NORFS_OK			(0)
+#define NORFS_ERR_IO		(-1)		/* flash access failed */
+#define NORFS_ERR_NOENT		(-2)		/* no such file */
+#define NORFS_ERR_EXIST		(-3)		/* file exists */
+#define NORFS_ERR_NOSPC		(-4)		/* no space left */
+#define NORFS_ERR_NOMEM		(-5)
+#define NORFS_ERR_INVAL		(-6)		/* invalid argument */
+#define NORFS_ERR_BUSY		(-7)		/* file is open */
+#define NORFS_ERR_NFILE		(-8)		/* too many files */
+
+/* open flags */
+#define NORFS_O_READ		(1 << 0)
+#define NORFS_O_WRITE		(1 << 1)
+#define NORFS_O_RDWR		(NORFS_O_READ | NORFS_O_WRITE)
+#define NORFS_O_CREAT		(1 << 2)	/* create the file if it does not exist */
+#define NORFS_O_EXCL		(1 << 3)	/* with NORFS_O_CREAT, fail if it exists */
+#define NORFS_O_TRUNC		(1 << 4)	/* truncate to 0 */
+#define NORFS_O_APPEND		(1 << 5)	/* every write goes to the end */
+
+typedef struct norfs norfs_t;
+typedef struct norfs_file norfs_file_t;
+
+struct norfs_info {
+	uint32_t	block_cnt;
+	uint32_t	free_size;		/* bytes of data that still fit, roughly */
+	uint32_t	file_cnt;
+	uint32_t	erase_min;		/* erase count of the least worn block */
+	uint32_t	erase_max;		/* erase count of the most worn block */
+	uint32_t	gc_cnt;			/* blocks reclaimed since mount */
+};
+
+int norfs_format(uint32_t flash, uint32_t addr, uint32_t size);
+norfs_t *norfs_mount(uint32_t flash, uint32_t addr, uint32_t size);
+int norfs_unmount(norfs_t *fs);
+int norfs_info(norfs_t *fs, struct norfs_info *info);
+
+int norfs_open(norfs_t *fs, norfs_file_t **file, const char *name, int flags);
+int norfs_read(norfs_file_t *file, void *buf, uint32_t len);
+int norfs_write(norfs_file_t *file, const void *buf, uint32_t len);
+int norfs_seek(norfs_file_t *file, uint32_t offset);
+uint32_t norfs_tell(norfs_file_t *file);
+uint32_t norfs_size(norfs_file_t *file);
+int norfs_truncate(norfs_file_t *file);
+int norfs_sync(norfs_file_t *file);
+int norfs_close(norfs_file_t *file);
+
+int norfs_remove(norfs_t *fs, const char *name);
+int norfs_rename(norfs_t *fs, const char *old_name, const char *new_name);
+int norfs_stat(norfs_t *fs, const char *name, uint32_t *size);
+int norfs_readdir(norfs_t *fs, uint32_t *index, char *name, uint32_t *size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FS_NORFS_H_ */
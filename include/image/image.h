@@ -200,6 +200,21 @@ image_val_t image_check_data(section_header_t *sh, void *body, uint32_t body_len
 image_val_t image_check_section(image_seq_t seq, uint32_t id);
 image_val_t image_check_sections(image_seq_t seq);
 
+/**
+ * @brief Record of validated images, one generation (hash of all the section
+ *        headers) per image sequence
+ */
+typedef struct image_check_cache {
+	uint32_t	gen[IMAGE_SEQ_NUM];
+} image_check_cache_t;
+
+#define IMAGE_CHECK_GEN_NONE	(0)
+
+int image_check_cache_init(uint32_t flash, uint32_t addr, uint32_t size);
+void image_check_cache_deinit(void);
+void image_check_cache_clear(image_seq_t seq);
+image_val_t image_check_sections_cached(image_seq_t seq);
+
 uint32_t image_get_size(void);
 
 int image_get_cfg(image_cfg_t *cfg);
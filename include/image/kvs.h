@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _IMAGE_KVS_H_
+#define _IMAGE_KVS_H_
+
+#include <stdint.h>
+#include "kernel/os/os_mutex.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Key-value store in a flash area of two or more 4K sectors. Every update
+ * appends a record for one key to the active sector, so changing a value
+ * costs its own size instead of an erase; the oldest sector is compacted
+ * and erased when space runs out, spreading the erases over the area.
+ * A record only counts once its state byte is written after the data, so
+ * a power cut loses at most the update in progress.
+ */
+
+#define KVS_SECTOR_SIZE		(4 * 1024)
+#define KVS_KEY_LEN_MAX		(32)
+#define KVS_VALUE_LEN_MAX	(KVS_SECTOR_SIZE - 16 - KVS_KEY_LEN_MAX)
+
+struct kvs_slot;
+
+/**
+ * @brief KVS handle definition
+ */
+typedef struct kvs_handle {
+	uint32_t	flash;
+	uint32_t	addr;
+	uint32_t	size;
+
+	/* private */
+	OS_Mutex_t	mutex;
+	struct kvs_slot *index;		/* key hash -> latest record */
+	uint16_t	index_size;		/* power of 2 */
+	uint16_t	key_max;
+	uint16_t	key_cnt;
+	uint16_t	sector_cnt;
+	uint16_t	free_cnt;		/* erased sectors */
+	uint16_t	active;			/* sector being appended to */
+	uint32_t	wp;				/* write offset in the active sector */
+	uint32_t	seq;			/* sequence of the active sector */
+	uint32_t	live;			/* bytes of the latest records */
+} kvs_handle_t;
+
+kvs_handle_t *kvs_open(uint32_t flash, uint32_t addr, uint32_t size,
+                       uint16_t key_max);
+int kvs_get(kvs_handle_t *hdl, const char *key, void *data, uint16_t data_size);
+int kvs_set(kvs_handle_t *hdl, const char *key, const void *data,
+            uint16_t data_size);
+int kvs_delete(kvs_handle_t *hdl, const char *key);
+int kvs_erase(kvs_handle_t *hdl);
+void kvs_close(kvs_handle_t *hdl);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _IMAGE_KVS_H_ */
@@ -52,6 +52,7 @@ extern "C" {
 #define OS_THREAD_PRIO_LWIP     OS_PRIORITY_NORMAL
 #define OS_THREAD_PRIO_CONSOLE  OS_PRIORITY_ABOVE_NORMAL
 #define OS_THREAD_PRIO_APP      OS_PRIORITY_NORMAL
+#define OS_THREAD_PRIO_STDIO    OS_PRIORITY_LOW
 
 /**
  * @brief Thread handle definition
@@ -16,6 +16,20 @@ void stdio_set_write(stdio_write_fn fn);
 void stdout_mutex_lock(void);
 void stdout_mutex_unlock(void);
 
+#ifdef __CONFIG_LIBC_STDIO_DEFERRED
+/*
+ * printf and friends store the message and return the size of the stored
+ * record (0 if it was dropped), not the length of the formatted output.
+ */
+
+/* write out the pending messages in the caller context */
+void stdio_deferred_flush(void);
+/* write raw records for tools/stdio_decode.py instead of text */
+void stdio_deferred_set_binary(int enable);
+/* messages lost to a full ring so far */
+unsigned int stdio_deferred_dropped(void);
+#endif
+
 #undef putc
 #undef putchar
 
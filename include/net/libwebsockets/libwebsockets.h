@@ -213,7 +213,11 @@ extern "C" {
    #endif
    #if defined(LWS_WITH_XRADIO)
     #undef MBEDTLS_CONFIG_FILE
-    #define MBEDTLS_CONFIG_FILE "mbedtls/configs/config-xr-mini-cliserv.h"
+    #if (__CONFIG_MBEDTLS_PROFILE == 1)
+     #define MBEDTLS_CONFIG_FILE "mbedtls/configs/config-xr-ecdhe.h"
+    #else
+     #define MBEDTLS_CONFIG_FILE "mbedtls/configs/config-xr-mini-cliserv.h"
+    #endif
     #include "mbedtls/ssl.h"
    #else
     #include <mbedtls/ssl.h>
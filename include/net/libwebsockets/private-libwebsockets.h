@@ -273,7 +273,11 @@ typedef struct { long double x, y; } _Float128;
  #define LWS_EISCONN EISCONN
  #define LWS_EWOULDBLOCK EWOULDBLOCK
 
- #define lws_set_blocking_send(wsi)
+ #ifdef LWS_WITH_XRADIO
+  #define lws_set_blocking_send(wsi) wsi->sock_send_blocking = 1
+ #else
+  #define lws_set_blocking_send(wsi)
+ #endif
 
  #if defined(LWS_WITH_ESP8266)
   #define lws_socket_is_valid(x) ((x) != NULL)
@@ -2074,7 +2078,7 @@ struct lws {
 #ifdef LWS_OPENSSL_SUPPORT
 	unsigned int use_ssl:4;
 #endif
-#ifdef _WIN32
+#if defined(_WIN32) || defined(LWS_WITH_XRADIO)
 	unsigned int sock_send_blocking:1;
 #endif
 #ifdef LWS_OPENSSL_SUPPORT
@@ -114,6 +114,33 @@ int mbedtls_aes_crypt_ecb( mbedtls_aes_context *ctx,
                     const unsigned char input[16],
                     unsigned char output[16] );
 
+/**
+ * \brief          AES-ECB encryption/decryption of several blocks with
+ *                 a single crypto engine request
+ *
+ * \param ctx      AES context
+ * \param mode     MBEDTLS_AES_ENCRYPT or MBEDTLS_AES_DECRYPT
+ * \param length   length of the input data, a multiple of 16
+ * \param input    buffer holding the input blocks
+ * \param output   buffer holding the output blocks, may equal input
+ *
+ * \return         0 if successful, MBEDTLS_ERR_AES_INVALID_INPUT_LENGTH
+ *                 or MBEDTLS_ERR_AES_HW_ACCEL_FAILED
+ */
+int mbedtls_aes_crypt_ecb_blocks( mbedtls_aes_context *ctx,
+                    int mode,
+                    size_t length,
+                    const unsigned char *input,
+                    unsigned char *output );
+
+/*
+ * Counter blocks encrypted per crypto engine request by AES-CTR and
+ * AES-GCM, taken from the stack of the caller (16 bytes each).
+ */
+#if !defined(MBEDTLS_AES_ALT_CTR_BLOCKS)
+#define MBEDTLS_AES_ALT_CTR_BLOCKS      16
+#endif
+
 #if defined(MBEDTLS_CIPHER_MODE_CBC)
 /**
  * \brief          AES-CBC buffer encryption/decryption
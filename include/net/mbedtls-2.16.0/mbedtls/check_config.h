@@ -119,6 +119,16 @@
 #error "MBEDTLS_ECP_RESTARTABLE defined, but it cannot coexist with an alternative ECP implementation"
 #endif
 
+#if defined(MBEDTLS_ECP_COMB_ROM_TABLES) &&                         \
+    ( !defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED) ||                 \
+      defined(MBEDTLS_ECP_ALT) ||                                   \
+      ( defined(MBEDTLS_ECP_WINDOW_SIZE) &&                         \
+        MBEDTLS_ECP_WINDOW_SIZE < 5 ) ||                            \
+      ( defined(MBEDTLS_ECP_FIXED_POINT_OPTIM) &&                   \
+        MBEDTLS_ECP_FIXED_POINT_OPTIM == 0 ) )
+#error "MBEDTLS_ECP_COMB_ROM_TABLES defined, but not all prerequisites"
+#endif
+
 #if defined(MBEDTLS_ECDSA_DETERMINISTIC) && !defined(MBEDTLS_HMAC_DRBG_C)
 #error "MBEDTLS_ECDSA_DETERMINISTIC defined, but not all prerequisites"
 #endif
@@ -175,6 +185,15 @@
 #error "MBEDTLS_GCM_C defined, but not all prerequisites"
 #endif
 
+#if defined(MBEDTLS_GCM_ALT) && !defined(MBEDTLS_AES_ALT)
+#error "MBEDTLS_GCM_ALT defined, but not all prerequisites"
+#endif
+
+#if defined(MBEDTLS_AES_ALT) && \
+    ( defined(MBEDTLS_CIPHER_MODE_OFB) || defined(MBEDTLS_CIPHER_MODE_XTS) )
+#error "MBEDTLS_AES_ALT does not provide the OFB and XTS modes"
+#endif
+
 #if defined(MBEDTLS_ECP_RANDOMIZE_JAC_ALT) && !defined(MBEDTLS_ECP_INTERNAL_ALT)
 #error "MBEDTLS_ECP_RANDOMIZE_JAC_ALT defined, but not all prerequisites"
 #endif
@@ -577,6 +596,11 @@
 #error "Illegal protocol selection"
 #endif
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH) && \
+    ( !defined(MBEDTLS_SSL_TLS_C) || defined(MBEDTLS_ZLIB_SUPPORT) )
+#error "MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH defined, but not all prerequisites"
+#endif
+
 #if defined(MBEDTLS_SSL_DTLS_HELLO_VERIFY) && !defined(MBEDTLS_SSL_PROTO_DTLS)
 #error "MBEDTLS_SSL_DTLS_HELLO_VERIFY  defined, but not all prerequisites"
 #endif
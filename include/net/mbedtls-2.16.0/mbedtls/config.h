@@ -719,6 +719,24 @@
  */
 #define MBEDTLS_ECP_NIST_OPTIM
 
+/**
+ * \def MBEDTLS_ECP_COMB_ROM_TABLES
+ *
+ * Use a precomputed comb table for the secp256r1 generator stored in ROM.
+ *
+ * Fixed-point multiplications of the generator (ECDSA signing, key
+ * generation and half of ECDHE) then skip the first-use precomputation and
+ * do not keep the 16 precomputed points on the heap for the lifetime of the
+ * group. It costs about 1kb of ROM.
+ *
+ * Requires: MBEDTLS_ECP_DP_SECP256R1_ENABLED,
+ *           MBEDTLS_ECP_FIXED_POINT_OPTIM == 1,
+ *           MBEDTLS_ECP_WINDOW_SIZE >= 5
+ *
+ * Uncomment this macro to use the precomputed secp256r1 table.
+ */
+//#define MBEDTLS_ECP_COMB_ROM_TABLES
+
 /**
  * \def MBEDTLS_ECP_RESTARTABLE
  *
@@ -1402,6 +1420,27 @@
  */
 #define MBEDTLS_SSL_MAX_FRAGMENT_LENGTH
 
+/**
+ * \def MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH
+ *
+ * Size the two internal I/O buffers after the records actually transferred
+ * instead of allocating MBEDTLS_SSL_IN_CONTENT_LEN and
+ * MBEDTLS_SSL_OUT_CONTENT_LEN bytes for the lifetime of the connection.
+ *
+ * The buffers hold MBEDTLS_SSL_VARIABLE_BUFFER_MIN_LEN bytes of content
+ * outside of a handshake, are grown to the full size for the handshake and
+ * on demand for larger application records, up to the negotiated maximum
+ * fragment length, and are shrunk again when the handshake is over and
+ * after MBEDTLS_SSL_VARIABLE_BUFFER_IDLE seconds without large records
+ * (see also mbedtls_ssl_shrink_buffers()). DTLS connections keep full size
+ * buffers.
+ *
+ * Requires: MBEDTLS_SSL_TLS_C, !MBEDTLS_ZLIB_SUPPORT
+ *
+ * Uncomment this macro to enable variable length I/O buffers
+ */
+//#define MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH
+
 /**
  * \def MBEDTLS_SSL_PROTO_SSL3
  *
@@ -3166,6 +3205,9 @@
  */
 //#define MBEDTLS_SSL_DTLS_MAX_BUFFERING             32768
 
+//#define MBEDTLS_SSL_VARIABLE_BUFFER_MIN_LEN     1024 /**< Content length of the I/O buffers between large records, see MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH */
+//#define MBEDTLS_SSL_VARIABLE_BUFFER_IDLE          10 /**< Seconds without large records before the I/O buffers are shrunk (if HAVE_TIME) */
+
 //#define MBEDTLS_SSL_DEFAULT_TICKET_LIFETIME     86400 /**< Lifetime of session tickets (if enabled) */
 //#define MBEDTLS_PSK_MAX_LEN               32 /**< Max size of TLS pre-shared keys, in bytes (default 256 bits) */
 //#define MBEDTLS_SSL_COOKIE_TIMEOUT        60 /**< Default expiration delay of DTLS cookies, in seconds if HAVE_TIME, or in number of cookies issued */
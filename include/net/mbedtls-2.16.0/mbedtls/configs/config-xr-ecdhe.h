@@ -0,0 +1,145 @@
+/*
+ *  Configuration for TLS 1.2 with ECDHE key exchange and AEAD ciphers
+ *
+ *  Copyright (C) 2006-2015, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  This file is part of mbed TLS (https://tls.mbed.org)
+ */
+/*
+ * Configuration for TLS 1.2 (RFC 5246) clients and servers, limited to
+ * forward-secret key exchanges and AEAD ciphers:
+ *   - ECDHE-ECDSA and ECDHE-RSA over secp256r1 and Curve25519 (X25519)
+ *   - AES-GCM and ChaCha20-Poly1305
+ *
+ * Selected by __CONFIG_MBEDTLS_PROFILE=1, as an alternative to
+ * config-xr-mini-cliserv.h. The secp256r1 generator comb table is kept in
+ * ROM, so ECDSA signing and ECDHE key generation do not allocate it.
+ *
+ * See README.txt for usage instructions.
+ */
+
+#ifndef MBEDTLS_CONFIG_H
+#define MBEDTLS_CONFIG_H
+/* System support */
+#define MBEDTLS_HAVE_ASM
+#define MBEDTLS_HAVE_TIME
+#define MBEDTLS_SSL_ALPN
+
+#if (__CONFIG_MBEDTLS_HEAP_MODE == 1)
+#include "driver/chip/psram/psram.h"
+#define MBEDTLS_PLATFORM_C
+#define MBEDTLS_PLATFORM_MEMORY
+#define MBEDTLS_PLATFORM_CALLOC_MACRO psram_calloc
+#define MBEDTLS_PLATFORM_FREE_MACRO psram_free
+#endif
+
+/* Save RAM at the expense of ROM */
+#define MBEDTLS_AES_ROM_TABLES
+#define MBEDTLS_ECP_COMB_ROM_TABLES
+
+/* mbed TLS feature support */
+#define MBEDTLS_ECP_DP_SECP256R1_ENABLED
+#define MBEDTLS_ECP_DP_CURVE25519_ENABLED
+#define MBEDTLS_ECP_NIST_OPTIM
+#define MBEDTLS_PKCS1_V15
+#define MBEDTLS_KEY_EXCHANGE_ECDHE_ECDSA_ENABLED
+#define MBEDTLS_KEY_EXCHANGE_ECDHE_RSA_ENABLED
+#define MBEDTLS_SSL_PROTO_TLS1_2
+#define MBEDTLS_SSL_EXTENDED_MASTER_SECRET
+#define MBEDTLS_SSL_SERVER_NAME_INDICATION
+#define MBEDTLS_SSL_SESSION_TICKETS
+#define MBEDTLS_SSL_MAX_FRAGMENT_LENGTH
+#define MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH
+//#define MBEDTLS_THREADING_C
+//#define MBEDTLS_THREADING_ALT
+
+/* Crypto engine offload, see __CONFIG_MBEDTLS_CE_ALT in config.mk */
+#ifdef __CONFIG_MBEDTLS_CE_ALT
+#define MBEDTLS_AES_ALT
+#define MBEDTLS_GCM_ALT
+#define MBEDTLS_SHA1_ALT
+#define MBEDTLS_SHA256_ALT
+#endif
+
+/* mbed TLS modules */
+#define MBEDTLS_AES_C
+#define MBEDTLS_GCM_C
+#define MBEDTLS_CHACHA20_C
+#define MBEDTLS_POLY1305_C
+#define MBEDTLS_CHACHAPOLY_C
+
+#define MBEDTLS_ASN1_PARSE_C
+#define MBEDTLS_ASN1_WRITE_C
+#define MBEDTLS_BIGNUM_C
+#define MBEDTLS_CIPHER_C
+#define MBEDTLS_CTR_DRBG_C
+#define MBEDTLS_ECDH_C
+#define MBEDTLS_ECDSA_C
+#define MBEDTLS_ECP_C
+#define MBEDTLS_ENTROPY_C
+#define MBEDTLS_MD_C
+#define MBEDTLS_NET_C
+#define MBEDTLS_OID_C
+#define MBEDTLS_PK_C
+#define MBEDTLS_PK_PARSE_C
+#define MBEDTLS_RSA_C
+#define MBEDTLS_SHA1_C
+#define MBEDTLS_SHA256_C
+#define MBEDTLS_SHA512_C
+#define MBEDTLS_SSL_CLI_C
+#define MBEDTLS_SSL_SRV_C
+#define MBEDTLS_SSL_TLS_C
+#define MBEDTLS_X509_CRT_PARSE_C
+#define MBEDTLS_X509_USE_C
+/**/
+//#define MBEDTLS_NO_PLATFORM_ENTROPY
+//#define MBEDTLS_ENTROPY_HARDWARE_ALT
+/**/
+/* For test certificates */
+#define MBEDTLS_BASE64_C
+#define MBEDTLS_CERTS_C
+#define MBEDTLS_PEM_PARSE_C
+
+/*
+ * Only secp256r1 and Curve25519 are in use, and RSA is only needed for
+ * ECDHE-RSA signatures and certificate chains (up to 4096 bits).
+ * A window of 5 matches the ROM comb table, runtime tables stay at 8 points.
+ */
+#define MBEDTLS_ECP_MAX_BITS                256
+#define MBEDTLS_ECP_WINDOW_SIZE             5
+#define MBEDTLS_ECP_FIXED_POINT_OPTIM       1
+#define MBEDTLS_MPI_MAX_SIZE                512
+
+#define MBEDTLS_SSL_MAX_CONTENT_LEN         (16*1024)   /**< Largest record, the I/O buffers grow up to it */
+
+/* Forward-secret AEAD suites only, in order of preference */
+#define MBEDTLS_SSL_CIPHERSUITES                                        \
+        MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,                \
+        MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,                  \
+        MBEDTLS_TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256,          \
+        MBEDTLS_TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256,            \
+        MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384,                \
+        MBEDTLS_TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384
+
+/* Add for XRadio */
+//#define MBEDTLS_DEBUG_C
+
+#define MBEDTLS_ON_LWIP
+
+#include "mbedtls/check_config.h"
+#include "driver/chip/hal_crypto.h"
+
+#endif /* MBEDTLS_CONFIG_H */
@@ -54,6 +54,13 @@
 //#define MBEDTLS_THREADING_C
 //#define MBEDTLS_THREADING_ALT
 
+/* Crypto engine offload, see __CONFIG_MBEDTLS_CE_ALT in config.mk */
+#ifdef __CONFIG_MBEDTLS_CE_ALT
+#define MBEDTLS_AES_ALT
+#define MBEDTLS_SHA1_ALT
+#define MBEDTLS_SHA256_ALT
+#endif
+
 /* mbed TLS modules */
 #define MBEDTLS_AES_C
 
@@ -79,6 +86,7 @@
 #define MBEDTLS_X509_CRT_PARSE_C
 #define MBEDTLS_X509_USE_C
 #define MBEDTLS_SSL_SERVER_NAME_INDICATION
+#define MBEDTLS_SSL_SESSION_TICKETS
 /**/
 //#define MBEDTLS_KEY_EXCHANGE_PSK_ENABLED
 //#define MBEDTLS_NO_PLATFORM_ENTROPY
@@ -89,8 +97,9 @@
 #define MBEDTLS_CERTS_C
 #define MBEDTLS_PEM_PARSE_C
 #define MBEDTLS_SSL_MAX_FRAGMENT_LENGTH
+#define MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH
 
-#define MBEDTLS_SSL_MAX_CONTENT_LEN         (16*1024)   /**< Size of the input / output buffer */
+#define MBEDTLS_SSL_MAX_CONTENT_LEN         (16*1024)   /**< Largest record, the I/O buffers grow up to it */
 
 /* Add for XRadio */
 //#define MBEDTLS_DEBUG_C
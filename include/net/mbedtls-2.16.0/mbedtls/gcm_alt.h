@@ -0,0 +1,66 @@
+/**
+ * \file gcm_alt.h
+ *
+ * \brief AES-GCM on the crypto engine: the counter blocks are encrypted in
+ *        batches by the CE, GHASH is computed in software.
+ *
+ *  Copyright (C) 2006-2015, ARM Limited, All Rights Reserved
+ *  SPDX-License-Identifier: Apache-2.0
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  This file is part of mbed TLS (https://tls.mbed.org)
+ */
+#ifndef MBEDTLS_GCM_ALT_H
+#define MBEDTLS_GCM_ALT_H
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#include <stdint.h>
+
+#include "aes.h"
+
+#if defined(MBEDTLS_GCM_ALT)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief          GCM context structure, only AES is supported
+ */
+typedef struct mbedtls_gcm_context
+{
+    mbedtls_aes_context aes;    /*!< AES context, key kept for the CE */
+    uint64_t HL[16];            /*!< Precalculated HTable low. */
+    uint64_t HH[16];            /*!< Precalculated HTable high. */
+    uint64_t len;               /*!< Total length of encrypted data. */
+    uint64_t add_len;           /*!< Total length of additional data. */
+    unsigned char base_ectr[16];/*!< First ECTR for tag. */
+    unsigned char y[16];        /*!< Y working value. */
+    unsigned char buf[16];      /*!< buf working value. */
+    int mode;                   /*!< Encrypt or Decrypt */
+}
+mbedtls_gcm_context;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MBEDTLS_GCM_ALT */
+
+#endif /* gcm_alt.h */
@@ -27,12 +27,17 @@
  *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#ifndef _MBEDTLS_MBEDTLS_H_
+#define _MBEDTLS_MBEDTLS_H_
+
 #include "mbedtls/debug.h"
 #include "mbedtls/x509_crt.h"
 #include "mbedtls/entropy.h"
 #include "mbedtls/ctr_drbg.h"
 #include "mbedtls/ssl.h"
 #include "mbedtls/net.h"
+#include "mbedtls/session_store.h"
+#include "mbedtls/trust_store.h"
 #include "lwip/sockets.h"
 
 /**
@@ -87,6 +92,10 @@ typedef struct
 	mbedtls_ctr_drbg_context  ctr_drbg;
 	mbedtls_ssl_context       ssl;
 	mbedtls_ssl_config        conf;
+	int                       port;     /* server port, for the session store */
+#if defined(MBEDTLS_TRUST_STORE)
+	mbedtls_trust_store      *trust;    /* shared client certificates */
+#endif
 } mbedtls_context;
 
 typedef mbedtls_net_context mbedtls_sock;
@@ -122,4 +131,6 @@ int mbedtls_recv_pending(mbedtls_context *context);
 
 int mbedtls_connect(mbedtls_context *context, mbedtls_sock* fd, struct sockaddr *name, int namelen, char *hostname);
 
-int mbedtls_accept(mbedtls_context *context, mbedtls_sock *local_fd, mbedtls_sock *remote_fd);
\ No newline at end of file
+int mbedtls_accept(mbedtls_context *context, mbedtls_sock *local_fd, mbedtls_sock *remote_fd);
+
+#endif /* _MBEDTLS_MBEDTLS_H_ */
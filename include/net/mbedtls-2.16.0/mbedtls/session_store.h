@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _MBEDTLS_SESSION_STORE_H_
+#define _MBEDTLS_SESSION_STORE_H_
+
+#include "mbedtls/ssl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(MBEDTLS_SSL_CLI_C)
+/**
+ * Client session store
+ *
+ * Sessions of successful client handshakes are kept per server (host name
+ * and port), auth mode and CA chain, and offered again on the next connection
+ * with the same ones, so that the server can resume them by session ticket
+ * (RFC 5077) or session id instead of running a full handshake. Sessions
+ * whose server certificate failed to verify are not kept. The store is shared
+ * by all TLS clients of the system.
+ */
+#define MBEDTLS_SESSION_STORE
+
+#ifndef MBEDTLS_SESSION_STORE_NUM
+#define MBEDTLS_SESSION_STORE_NUM               4
+#endif
+
+#ifndef MBEDTLS_SESSION_STORE_HOST_LEN
+#define MBEDTLS_SESSION_STORE_HOST_LEN          64
+#endif
+
+#ifndef MBEDTLS_SESSION_STORE_TIMEOUT
+#define MBEDTLS_SESSION_STORE_TIMEOUT           (24*60*60*1000) /* 24 hours */
+#endif
+
+typedef struct {
+	unsigned int full;       /* full handshakes */
+	unsigned int resumed;    /* abbreviated handshakes */
+} mbedtls_session_stats;
+
+int mbedtls_session_store_resume(mbedtls_ssl_context *ssl, const char *host, int port);
+
+void mbedtls_session_store_update(mbedtls_ssl_context *ssl, const char *host, int port, int result);
+
+int mbedtls_session_store_resume_ssl(mbedtls_ssl_context *ssl, int port);
+
+void mbedtls_session_store_update_ssl(mbedtls_ssl_context *ssl, int port, int result);
+
+void mbedtls_session_store_remove(const char *host, int port);
+
+void mbedtls_session_store_flush(void);
+
+void mbedtls_session_store_stats(mbedtls_session_stats *stats);
+#endif /* MBEDTLS_SSL_CLI_C */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MBEDTLS_SESSION_STORE_H_ */
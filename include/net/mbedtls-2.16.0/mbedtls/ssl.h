@@ -252,6 +252,19 @@
 #define MBEDTLS_SSL_DTLS_MAX_BUFFERING 32768
 #endif
 
+/*
+ * Content length of the I/O buffers outside of handshakes and large records,
+ * and seconds without large records before they are shrunk back to it,
+ * if MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH is enabled.
+ */
+#if !defined(MBEDTLS_SSL_VARIABLE_BUFFER_MIN_LEN)
+#define MBEDTLS_SSL_VARIABLE_BUFFER_MIN_LEN 1024
+#endif
+
+#if !defined(MBEDTLS_SSL_VARIABLE_BUFFER_IDLE)
+#define MBEDTLS_SSL_VARIABLE_BUFFER_IDLE    10
+#endif
+
 /* \} name SECTION: Module settings */
 
 /*
@@ -858,6 +871,9 @@ struct mbedtls_ssl_config
     /** Callback to customize X.509 certificate chain verification          */
     int (*f_vrfy)(void *, mbedtls_x509_crt *, int, uint32_t *);
     void *p_vrfy;                   /*!< context for X.509 verify calllback */
+    /** Callback to lock the CA chain and own keys while they are used      */
+    void (*f_cert_lock)(void *, int);
+    void *p_cert_lock;              /*!< context for the lock callback      */
 #endif
 
 #if defined(MBEDTLS_KEY_EXCHANGE__SOME__PSK_ENABLED)
@@ -1087,6 +1103,9 @@ struct mbedtls_ssl_context
     unsigned char *in_iv;       /*!< ivlen-byte IV                    */
     unsigned char *in_msg;      /*!< message contents (in_iv+ivlen)   */
     unsigned char *in_offt;     /*!< read offset in application data  */
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    size_t in_buf_len;          /*!< current size of the input buffer */
+#endif
 
     int in_msgtype;             /*!< record header: message type      */
     size_t in_msglen;           /*!< record header: message length    */
@@ -1122,6 +1141,13 @@ struct mbedtls_ssl_context
     unsigned char *out_len;     /*!< two-bytes message length field   */
     unsigned char *out_iv;      /*!< ivlen-byte IV                    */
     unsigned char *out_msg;     /*!< message contents (out_iv+ivlen)  */
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    size_t out_buf_len;         /*!< current size of the output buffer */
+#if defined(MBEDTLS_HAVE_TIME)
+    mbedtls_time_t buf_stamp;   /*!< last use of the I/O buffers beyond
+                                     MBEDTLS_SSL_VARIABLE_BUFFER_MIN_LEN */
+#endif
+#endif
 
     int out_msgtype;            /*!< record header: message type      */
     size_t out_msglen;          /*!< record header: message length    */
@@ -1328,6 +1354,24 @@ void mbedtls_ssl_conf_authmode( mbedtls_ssl_config *conf, int authmode );
 void mbedtls_ssl_conf_verify( mbedtls_ssl_config *conf,
                      int (*f_vrfy)(void *, mbedtls_x509_crt *, int, uint32_t *),
                      void *p_vrfy );
+
+/**
+ * \brief          Set the lock of the CA chain and own keys (Optional).
+ *
+ *                 Verifying a chain and using a private key change the
+ *                 key contexts (RSA blinding values, cached Montgomery
+ *                 and EC comb tables). When these are shared by several
+ *                 contexts without MBEDTLS_THREADING_C, the callback is
+ *                 called with 1 before and 0 after each such use, around
+ *                 the single operation only, never across I/O.
+ *
+ * \param conf     SSL configuration
+ * \param f_lock   lock function, second argument 1 to lock, 0 to unlock
+ * \param p_lock   lock parameter
+ */
+void mbedtls_ssl_conf_cert_lock( mbedtls_ssl_config *conf,
+                                 void (*f_lock)(void *, int),
+                                 void *p_lock );
 #endif /* MBEDTLS_X509_CRT_PARSE_C */
 
 /**
@@ -3153,6 +3197,20 @@ int mbedtls_ssl_read( mbedtls_ssl_context *ssl, unsigned char *buf, size_t len )
  */
 int mbedtls_ssl_write( mbedtls_ssl_context *ssl, const unsigned char *buf, size_t len );
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+/**
+ * \brief          Shrink the I/O buffers to MBEDTLS_SSL_VARIABLE_BUFFER_MIN_LEN
+ *                 bytes of content, e.g. before waiting for the next request
+ *                 on a connection which transferred large records.
+ *
+ * \param ssl      SSL context
+ *
+ * \note           Buffers which still hold unread or unsent data are kept.
+ *                 The buffers grow again on demand.
+ */
+void mbedtls_ssl_shrink_buffers( mbedtls_ssl_context *ssl );
+#endif /* MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH */
+
 /**
  * \brief           Send an alert message
  *
@@ -200,6 +200,12 @@
 #error "Bad configuration - outgoing protected record payload too large."
 #endif
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH) &&                      \
+    ( MBEDTLS_SSL_VARIABLE_BUFFER_MIN_LEN > MBEDTLS_SSL_IN_CONTENT_LEN || \
+      MBEDTLS_SSL_VARIABLE_BUFFER_MIN_LEN > MBEDTLS_SSL_OUT_CONTENT_LEN )
+#error "Bad configuration - variable buffer minimum larger than the record content."
+#endif
+
 /* Calculate buffer sizes */
 
 /* Note: Even though the TLS record header is only 5 bytes
@@ -665,6 +671,13 @@ static inline mbedtls_pk_context *mbedtls_ssl_own_key( mbedtls_ssl_context *ssl
     return( key_cert == NULL ? NULL : key_cert->key );
 }
 
+/* lock (1) or unlock (0) the CA chain and own keys, see mbedtls_ssl_conf_cert_lock() */
+static inline void mbedtls_ssl_cert_lock( const mbedtls_ssl_context *ssl, int lock )
+{
+    if( ssl->conf->f_cert_lock != NULL )
+        ssl->conf->f_cert_lock( ssl->conf->p_cert_lock, lock );
+}
+
 static inline mbedtls_x509_crt *mbedtls_ssl_own_cert( mbedtls_ssl_context *ssl )
 {
     mbedtls_ssl_key_cert *key_cert;
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _MBEDTLS_TRUST_STORE_H_
+#define _MBEDTLS_TRUST_STORE_H_
+
+#include "mbedtls/x509_crt.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/ssl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(MBEDTLS_X509_CRT_PARSE_C) && defined(MBEDTLS_PK_PARSE_C) && \
+    defined(MBEDTLS_SHA256_C)
+/**
+ * Shared trust store
+ *
+ * The CA chain and the own certificate/key of a TLS endpoint, parsed once and
+ * shared by reference by every connection configured with the same
+ * credentials. A store is looked up by the SHA-256 digest of its input, so
+ * callers only have to pass the same PEM/DER buffers again.
+ *
+ * Stores that are no longer referenced stay cached for the next connection,
+ * up to MBEDTLS_TRUST_STORE_CACHE_NUM of them.
+ *
+ * mbedtls changes key contexts while using them (RSA blinding values, cached
+ * Montgomery and EC comb tables) without locking. mbedtls_trust_store_attach()
+ * has the SSL layer lock the stores around each chain verification and private
+ * key operation.
+ */
+#define MBEDTLS_TRUST_STORE
+
+#ifndef MBEDTLS_TRUST_STORE_CACHE_NUM
+#define MBEDTLS_TRUST_STORE_CACHE_NUM           2
+#endif
+
+#define MBEDTLS_TRUST_STORE_CA_NUM              2
+
+/**
+ * Input of a trust store, all buffers are optional. Certificates may be PEM
+ * (null-terminated, length including the terminator) or DER.
+ */
+typedef struct {
+	struct {
+		const unsigned char *buf;
+		size_t               len;
+	} ca[MBEDTLS_TRUST_STORE_CA_NUM];   /* CA certificates, chained in order */
+	int                  ca_in_place;   /* ca[] are concatenated DER certificates
+	                                       which stay valid and unmodified (e.g. in
+	                                       memory-mapped flash), parsed without copy */
+	const unsigned char *cert;          /* own certificate chain */
+	size_t               cert_len;
+	const unsigned char *chain;         /* more of the own chain */
+	size_t               chain_len;
+	const unsigned char *key;           /* own private key */
+	size_t               key_len;
+	const unsigned char *pwd;           /* password of the private key */
+	size_t               pwd_len;
+} mbedtls_trust_param;
+
+typedef struct mbedtls_trust_store {
+	mbedtls_x509_crt            ca;     /* CA chain, for mbedtls_ssl_conf_ca_chain() */
+	mbedtls_x509_crt            cert;   /* own certificate, for mbedtls_ssl_conf_own_cert() */
+	mbedtls_pk_context          key;    /* own private key */
+	int                         has_own;/* cert and key are set */
+
+	/* private */
+	struct mbedtls_trust_store *next;
+	unsigned char               digest[32];
+	int                         ref;
+	unsigned int                stamp;  /* ticks of the last release */
+} mbedtls_trust_store;
+
+mbedtls_trust_store *mbedtls_trust_store_get(const mbedtls_trust_param *param);
+
+void mbedtls_trust_store_put(mbedtls_trust_store *store);
+
+int mbedtls_trust_store_attach(mbedtls_trust_store *store, mbedtls_ssl_config *conf);
+
+void mbedtls_trust_store_use(void *p, int lock);
+
+void mbedtls_trust_store_flush(void);
+#endif /* MBEDTLS_X509_CRT_PARSE_C && MBEDTLS_PK_PARSE_C && MBEDTLS_SHA256_C */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MBEDTLS_TRUST_STORE_H_ */
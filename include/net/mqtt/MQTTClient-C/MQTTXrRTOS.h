@@ -65,6 +65,7 @@ struct Network {
 	mbedtls_x509_crt *cacertl; //The ca certificate or chain
 	mbedtls_x509_crt *clicert; //The own certificate
 	mbedtls_pk_context *pkey; //The own public key
+	struct mbedtls_trust_store *trust; //The shared store of the above, if used
 };
 
 void NewNetwork(Network*);
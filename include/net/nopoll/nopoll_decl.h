@@ -105,6 +105,13 @@
 #define NOPOLL_HANDSHAKE_BUFFER_SIZE 8192
 #endif /* NOPOLL_OS_FREERTOS */
 
+/* stack buffer used to stage frame header and payload chunks on send */
+#if defined(NOPOLL_OS_FREERTOS)
+#define NOPOLL_SEND_STAGING_SIZE 512
+#else /* NOPOLL_OS_FREERTOS */
+#define NOPOLL_SEND_STAGING_SIZE 4096
+#endif /* NOPOLL_OS_FREERTOS */
+
 /* include this at this place to load GNU extensions */
 #if defined(__GNUC__)
 #  ifndef _GNU_SOURCE
@@ -51,11 +51,16 @@
 struct usr_file {
 	char *name;
 	char *body;
+	char *gz_body;                  /* optional precompressed (gzip) body */
+	unsigned long gz_size;          /* size of gz_body in bytes */
 };
 
 struct f_stat {
 	unsigned long st_size;
 	unsigned int  st_mode;
+	unsigned long st_etag;          /* body hash, used as ETag */
+	char          *st_gz_body;      /* precompressed body or NULL */
+	unsigned long st_gz_size;
 };
 
 time_t TIME(time_t *timer);
@@ -124,6 +124,8 @@ struct headers {
 	union variant   range;        /* Range:			*/
 	union variant   status;       /* Status:			*/
 	union variant   transenc;     /* Transfer-Encoding:		*/
+	union variant   inm;          /* If-None-Match:			*/
+	union variant   ae;           /* Accept-Encoding:		*/
 };
 
 /* Must go after union variant definition */
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _UTIL_SPSC_RING_H_
+#define _UTIL_SPSC_RING_H_
+
+#include <stdint.h>
+#include "compiler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Wait-free byte ring for exactly one producer and one consumer thread.
+ * Each index is written by one side only and published with release/acquire
+ * ordering, so neither side takes a lock or disables interrupts. The indices
+ * run over twice the size, which tells a full ring from an empty one without
+ * giving up a byte, so the size need not be a power of 2: make it a multiple
+ * of the frame size and frame-sized spans never wrap.
+ *
+ * Both sides can work in place:
+ *  - producer: spsc_ring_write_span() / spsc_ring_write_commit()
+ *  - consumer: spsc_ring_read_span() / spsc_ring_read_release()
+ * A read span crossing the end of the ring is made contiguous by copying its
+ * wrapped part into span_max spare bytes after the end, which only the
+ * consumer touches.
+ */
+
+#ifndef SPSC_RING_CACHE_LINE
+#define SPSC_RING_CACHE_LINE	32
+#endif
+
+#define SPSC_RING_ALIGNED	__attribute__((aligned(SPSC_RING_CACHE_LINE)))
+
+typedef struct spsc_ring {
+	/* constant after init */
+	uint8_t		   *buf;		/* size + span_max bytes */
+	uint32_t		size;
+	uint32_t		span_max;
+
+	/* written by the producer only */
+	volatile uint32_t head SPSC_RING_ALIGNED;
+	uint32_t		tail_cache;	/* tail as last seen by the producer */
+	uint32_t		overrun;	/* bytes dropped because the ring was full */
+
+	/* written by the consumer only */
+	volatile uint32_t tail SPSC_RING_ALIGNED;
+	uint32_t		head_cache;	/* head as last seen by the consumer */
+} SPSC_RING_ALIGNED spsc_ring_t;
+
+/* buf must hold size + span_max bytes, span_max may be 0 */
+void spsc_ring_init(spsc_ring_t *ring, void *buf, uint32_t size, uint32_t span_max);
+/* neither side may be running */
+void spsc_ring_reset(spsc_ring_t *ring);
+
+/* producer side */
+uint32_t spsc_ring_space(spsc_ring_t *ring);
+void *spsc_ring_write_span(spsc_ring_t *ring, uint32_t *len);
+void spsc_ring_write_commit(spsc_ring_t *ring, uint32_t len);
+uint32_t spsc_ring_write(spsc_ring_t *ring, const void *data, uint32_t len);
+
+/* consumer side */
+uint32_t spsc_ring_count(spsc_ring_t *ring);
+const void *spsc_ring_read_span(spsc_ring_t *ring, uint32_t len);
+void spsc_ring_read_release(spsc_ring_t *ring, uint32_t len);
+uint32_t spsc_ring_read(spsc_ring_t *ring, void *data, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _UTIL_SPSC_RING_H_ */
@@ -40,7 +40,16 @@
 
 #ifdef SUPPORT_FIXED_OUTPUT_CONFIG
 #include "audio/reverb/mixer.h"
-#include "audio/reverb/resample.h"
+#include "audio/dsp/resampler.h"
+#endif
+
+/* play through the sound mixer, along with the tone stream */
+#if PRJCONF_SOUND_MIXER_EN
+#define SUPPORT_MIXER
+#endif
+
+#ifdef SUPPORT_MIXER
+#include "sound_mixer.h"
 #endif
 
 #define SUPPORT_EQ
@@ -55,11 +64,18 @@
 #ifdef SUPPORT_FIXED_OUTPUT_CONFIG
 /* 8000, 11025, 12000, 16000, 22050, 24000, 32000, 44100, 48000 */
 #define SAMPLE_RATE_MAX_NUM         9
+#define RESAMPLE_OUT_FRAMES         256
 struct CardPcmConfig {
     unsigned int  channels;
     unsigned int  rate;
     unsigned int  valid;
 };
+
+/* kept from one write to the next, so the converted stream is continuous */
+struct CardResampler {
+    resampler_t rs;
+    short out[RESAMPLE_OUT_FRAMES * RESAMPLER_CHANNELS_MAX];
+};
 #endif
 
 typedef struct CardContext {
@@ -68,9 +84,11 @@ typedef struct CardContext {
 #ifdef SUPPORT_FIXED_OUTPUT_CONFIG
     struct CardPcmConfig support_cfg[SAMPLE_RATE_MAX_NUM + 1];
     struct pcm_config *output_config;
-    resample_info res_info;
-    unsigned int rate;
-    unsigned int channel;
+    struct CardResampler *resampler;
+#endif
+#ifdef SUPPORT_MIXER
+    SoundMixer *mixer;
+    SoundMixerInput *mix_input;
 #endif
 #ifdef SUPPORT_EQ
     eq_prms_t prms_config;
@@ -83,6 +101,11 @@ typedef struct CardContext {
 static int card_pcm_open(SoundStreamT *stream)
 {
     CardContext *context = (CardContext *)stream;
+#ifdef SUPPORT_FIXED_OUTPUT_CONFIG
+    if (context->resampler) {
+        resampler_reset(&context->resampler->rs);
+    }
+#endif
 #ifdef SUPPORT_EQ
     if (context->equalizer) {
         uint32_t chan, sampleRate;
@@ -109,36 +132,114 @@ static int card_pcm_open(SoundStreamT *stream)
 #endif
 #ifdef SUPPORT_FIXED_OUTPUT_CONFIG
     if (context->output_config) {
+#ifdef SUPPORT_MIXER
+        return sound_mixer_input_open(context->mix_input, context->output_config->rate,
+                                      context->output_config->channels);
+#else
         return snd_pcm_open(AUDIO_SND_CARD_DEFAULT, PCM_OUT, context->output_config);
+#endif
     }
 #endif
+#ifdef SUPPORT_MIXER
+    return sound_mixer_input_open(context->mix_input, context->input_config.rate,
+                                  context->input_config.channels);
+#else
     return snd_pcm_open(AUDIO_SND_CARD_DEFAULT, PCM_OUT, &(context->input_config));
+#endif
 }
 
 static int card_pcm_close(SoundStreamT *stream)
 {
+#ifdef SUPPORT_MIXER
+    CardContext *context = (CardContext *)stream;
+
+    return sound_mixer_input_close(context->mix_input);
+#else
     return snd_pcm_close(AUDIO_SND_CARD_DEFAULT, PCM_OUT);
+#endif
 }
 
 static int card_pcm_flush(SoundStreamT *stream)
 {
+    CardContext *context = (CardContext *)stream;
+
+#ifdef SUPPORT_FIXED_OUTPUT_CONFIG
+    if (context->resampler) {
+        resampler_reset(&context->resampler->rs);
+    }
+#endif
+#ifdef SUPPORT_MIXER
+    return sound_mixer_input_flush(context->mix_input);
+#else
+    (void)context;
     return snd_pcm_flush(AUDIO_SND_CARD_DEFAULT);
+#endif
 }
 
-static int card_pcm_write(SoundStreamT *stream, struct SscPcmConfig *config, void *data, unsigned int count)
+static int card_pcm_play(CardContext *context, void *data, unsigned int len)
 {
+#ifdef SUPPORT_EQ
+    if (context->equalizer) {
+        OS_MutexLock(&context->eq_lock, OS_WAIT_FOREVER);
+        eq_process(context->equalizer, (short*)data, len/context->radio);
+        OS_MutexUnlock(&context->eq_lock);
+    }
+#endif
+#ifdef SUPPORT_MIXER
+    return sound_mixer_input_write(context->mix_input, data, len);
+#else
+    return snd_pcm_write(AUDIO_SND_CARD_DEFAULT, data, len);
+#endif
+}
+
 #ifdef SUPPORT_FIXED_OUTPUT_CONFIG
-    int has_resample = 0;
-    resample_info *res_info;
+static int card_pcm_resample(CardContext *context, short *data, unsigned int len)
+{
+    struct CardResampler *res = context->resampler;
+    unsigned int channels = context->output_config->channels;
+    unsigned int in_rate = context->input_config.rate;
+    unsigned int out_rate = context->output_config->rate;
+    uint32_t in_frames, out_frames, frames;
+
+    if (res == NULL) {
+        res = (struct CardResampler *)malloc(sizeof(struct CardResampler));
+        if (res == NULL) {
+            return -1;
+        }
+        res->rs.channels = 0;
+        context->resampler = res;
+    }
+    if (res->rs.channels != channels || res->rs.in_rate != in_rate ||
+            res->rs.out_rate != out_rate) {
+        if (resampler_init(&res->rs, in_rate, out_rate, channels) != 0) {
+            printf("resampler init fail. %u->%u, channel:%u\n", in_rate, out_rate, channels);
+            res->rs.channels = 0;
+            return -1;
+        }
+    }
+
+    frames = len / (channels * sizeof(short));
+    while (frames) {
+        in_frames = frames;
+        out_frames = RESAMPLE_OUT_FRAMES;
+        resampler_process(&res->rs, data, &in_frames, res->out, &out_frames);
+        data += in_frames * channels;
+        frames -= in_frames;
+        if (out_frames) {
+            card_pcm_play(context, res->out, out_frames * channels * sizeof(short));
+        }
+    }
+    return 0;
+}
 #endif
+
+static int card_pcm_write(SoundStreamT *stream, struct SscPcmConfig *config, void *data, unsigned int count)
+{
     void *outData = data;
     unsigned int dataLen = count;
-#if (defined(SUPPORT_FIXED_OUTPUT_CONFIG) || defined(SUPPORT_EQ))
     CardContext *context = (CardContext *)stream;
-#endif
 
 #ifdef SUPPORT_FIXED_OUTPUT_CONFIG
-    res_info = &context->res_info;
     if (context->output_config) {
         /* convert channel */
         if (context->output_config->channels != context->input_config.channels) {
@@ -153,49 +254,17 @@ static int card_pcm_write(SoundStreamT *stream, struct SscPcmConfig *config, voi
 
         /* convert sample rate */
         if (context->output_config->rate != context->input_config.rate) {
-            unsigned int out_channel;
-            unsigned int in_rate;
-
-            has_resample = 1;
-            out_channel = context->output_config->channels;
-            in_rate = context->input_config.rate;
-            if (context->channel != out_channel || context->rate != in_rate) {
-                res_info->BitsPerSample = 16;
-                res_info->in_SampleRate = in_rate;
-                res_info->NumChannels = out_channel;
-                res_info->out_SampleRate = context->output_config->rate;
-                resample_init(res_info);
-                context->channel = out_channel;
-                context->rate = in_rate;
+            if (card_pcm_resample(context, (short *)outData, dataLen) != 0) {
+                return -1;
             }
-            resample(res_info, (short*)outData, dataLen);
-            outData = res_info->out_buffer;
-            dataLen = res_info->out_frame_indeed * (res_info->BitsPerSample / 8) * res_info->NumChannels;
+            return count;
         }
 
-#ifdef SUPPORT_EQ
-        if (context->equalizer) {
-            OS_MutexLock(&context->eq_lock, OS_WAIT_FOREVER);
-            eq_process(context->equalizer, (short*)outData, dataLen/context->radio);
-            OS_MutexUnlock(&context->eq_lock);
-        }
-#endif
-        snd_pcm_write(AUDIO_SND_CARD_DEFAULT, outData, dataLen);
-
-        if (has_resample) {
-            resample_release(res_info);
-        }
+        card_pcm_play(context, outData, dataLen);
         return count;
     }
 #endif
-#ifdef SUPPORT_EQ
-    if (context->equalizer) {
-        OS_MutexLock(&context->eq_lock, OS_WAIT_FOREVER);
-        eq_process(context->equalizer, (short*)outData, dataLen/context->radio);
-        OS_MutexUnlock(&context->eq_lock);
-    }
-#endif
-    return snd_pcm_write(AUDIO_SND_CARD_DEFAULT, outData, dataLen);
+    return card_pcm_play(context, outData, dataLen);
 }
 
 static int card_pcm_read(SoundStreamT *stream, void *data, unsigned int count)
@@ -336,6 +405,14 @@ static int card_pcm_ioctl(SoundStreamT *stream, SoundStreamCmd cmd, void *param)
             OS_MutexDelete(&context->eq_lock);
         }
         break;
+#endif
+#ifdef SUPPORT_MIXER
+    case STREAM_CMD_SET_GAIN:
+        sound_mixer_input_set_gain(context->mix_input, *(int *)param);
+        break;
+    case STREAM_CMD_SET_DUCK:
+        sound_mixer_set_duck(context->mixer, *(int *)param);
+        break;
 #endif
     default:
         break;
@@ -353,7 +430,7 @@ static const struct SoundStreamOpsS cardStreamOps =
     .soundIoctl = card_pcm_ioctl,
 };
 
-static SoundStreamT * card_pcm_create(void)
+static SoundStreamT * card_pcm_create_flags(unsigned int mix_flags)
 {
     CardContext *context;
 
@@ -363,6 +440,20 @@ static SoundStreamT * card_pcm_create(void)
     }
     memset(context, 0, sizeof(CardContext));
 
+#ifdef SUPPORT_MIXER
+    context->mixer = sound_mixer_ref();
+    if (context->mixer == NULL) {
+        free(context);
+        return NULL;
+    }
+    context->mix_input = sound_mixer_input_create(context->mixer, mix_flags);
+    if (context->mix_input == NULL) {
+        sound_mixer_unref(context->mixer);
+        free(context);
+        return NULL;
+    }
+#endif
+
 #ifdef SUPPORT_FIXED_OUTPUT_CONFIG
     /* from minimum value to maximum value */
     context->support_cfg[0].rate = 8000;
@@ -381,11 +472,31 @@ static SoundStreamT * card_pcm_create(void)
     return &context->base;
 }
 
+static SoundStreamT * card_pcm_create(void)
+{
+    return card_pcm_create_flags(0);
+}
+
+/* the same as the card stream, lowering it while playing */
+static SoundStreamT * tone_pcm_create(void)
+{
+#ifdef SUPPORT_MIXER
+    return card_pcm_create_flags(SOUND_MIXER_DUCK_OTHERS);
+#else
+    return card_pcm_create_flags(0);
+#endif
+}
+
 static void card_pcm_destroy(SoundStreamT * stream)
 {
     CardContext *context = (CardContext *)stream;
+#ifdef SUPPORT_MIXER
+    sound_mixer_input_destroy(context->mix_input);
+    sound_mixer_unref(context->mixer);
+#endif
 #ifdef SUPPORT_FIXED_OUTPUT_CONFIG
     free(context->output_config);
+    free(context->resampler);
 #endif
     free(context);
 }
@@ -396,4 +507,10 @@ const struct SoundStreamCreatorS CardStreamCtor =
     .destroy = card_pcm_destroy,
 };
 
+const struct SoundStreamCreatorS ToneStreamCtor =
+{
+    .create  = tone_pcm_create,
+    .destroy = card_pcm_destroy,
+};
+
 #endif
@@ -40,12 +40,13 @@
 
 #ifdef SUPPORT_FIXED_OUTPUT_CONFIG
 #include "audio/reverb/mixer.h"
-#include "audio/reverb/resample.h"
+#include "audio/dsp/resampler.h"
 #endif
 
 #ifdef SUPPORT_FIXED_OUTPUT_CONFIG
 #define DEFAULT_OUTPUT_SAMPLE_RATE       (16000)
 #define DEFAULT_OUTPUT_CHANNEL           (1)
+#define RESAMPLE_OUT_FRAMES              (256)
 #endif
 
 #define RING_BUF_SIZE           (4096)
@@ -68,12 +69,19 @@ struct ReverbPcmConfig {
     unsigned int  rate;
 };
 
+#ifdef SUPPORT_FIXED_OUTPUT_CONFIG
+/* kept from one write to the next, so the converted stream is continuous */
+struct ReverbResampler {
+    resampler_t rs;
+    short out[RESAMPLE_OUT_FRAMES * RESAMPLER_CHANNELS_MAX];
+};
+#endif
+
 typedef struct ReverbContext {
     SoundStreamT base;
     reverb_buffer* bufferImpl;
 #ifdef SUPPORT_FIXED_OUTPUT_CONFIG
-    resample_info res_info;
-    struct ReverbPcmConfig input_info; /* sample rate and channels of pcm before resample */
+    struct ReverbResampler *resampler;
     struct ReverbPcmConfig output_info; /* sample rate and channels of pcm after resample */
 #endif
     uint8_t put_block;
@@ -91,22 +99,73 @@ static int reverb_pcm_close(SoundStreamT *stream)
     return 0;
 }
 
+static void reverb_pcm_put(ReverbContext *context, uint8_t *data_ptr, uint32_t count)
+{
+    uint32_t len = 0;
+
+    while (count) {
+        len = reverb_buffer_put(context->bufferImpl, data_ptr, count);
+        data_ptr += len;
+        count -= len;
+        if ((count != 0) && (context->put_block)) {
+            context->waitingSem = 1;
+            RG_SemaphoreWait(&context->sem);
+            context->waitingSem = 0;
+        } else {
+            break;
+        }
+    }
+}
+
+#ifdef SUPPORT_FIXED_OUTPUT_CONFIG
+static int reverb_pcm_resample(ReverbContext *context, short *data, uint32_t count,
+                               unsigned int channel, unsigned int rate)
+{
+    struct ReverbResampler *res = context->resampler;
+    uint32_t in_frames, out_frames, frames;
+
+    if (res == NULL) {
+        res = (struct ReverbResampler *)malloc(sizeof(struct ReverbResampler));
+        if (res == NULL) {
+            return -1;
+        }
+        res->rs.channels = 0;
+        context->resampler = res;
+    }
+    if (res->rs.channels != channel || res->rs.in_rate != rate ||
+            res->rs.out_rate != context->output_info.rate) {
+        if (resampler_init(&res->rs, rate, context->output_info.rate, channel) != 0) {
+            printf("resampler init fail. %u->%u, channel:%u\n",
+                   rate, context->output_info.rate, channel);
+            res->rs.channels = 0;
+            return -1;
+        }
+    }
+
+    frames = count / (channel * sizeof(short));
+    while (frames) {
+        in_frames = frames;
+        out_frames = RESAMPLE_OUT_FRAMES;
+        resampler_process(&res->rs, data, &in_frames, res->out, &out_frames);
+        data += in_frames * channel;
+        frames -= in_frames;
+        reverb_pcm_put(context, (uint8_t *)res->out, out_frames * channel * sizeof(short));
+    }
+    return 0;
+}
+#endif
+
 static int reverb_pcm_write(SoundStreamT *stream, struct SscPcmConfig *config, void *buffer, unsigned int size)
 {
 #ifdef SUPPORT_FIXED_OUTPUT_CONFIG
-    int has_resample = 0;
-    resample_info *res_info;
     uint8_t channel = config->channels;
     uint32_t rate = config->rate;
 #endif
     uint8_t *data_ptr = buffer;
     uint32_t count = size;
-    uint32_t len = 0;
     ReverbContext *context = (ReverbContext *)stream;
 
 #ifdef SUPPORT_FIXED_OUTPUT_CONFIG
-    res_info = &context->res_info;
-
     /* convert channel */
     if ((context->output_info.channels != 0) && (context->output_info.channels != channel)) {
         /* infact, we only support convert 2 channels to 1 channels */
@@ -120,42 +179,14 @@ static int reverb_pcm_write(SoundStreamT *stream, struct SscPcmConfig *config, v
 
     /* convert sample rate */
     if ((context->output_info.rate != 0) && (context->output_info.rate != rate)) {
-        has_resample = 1;
-
-        if (context->input_info.channels != channel || context->input_info.rate != rate) {
-            res_info->BitsPerSample = 16;
-            res_info->in_SampleRate = rate;
-            res_info->NumChannels = channel;
-            res_info->out_SampleRate = context->output_info.rate;
-            resample_init(res_info);
-            context->input_info.channels = channel;
-            context->input_info.rate = rate;
+        if (reverb_pcm_resample(context, (short *)data_ptr, count, channel, rate) != 0) {
+            return -1;
         }
-        resample(res_info, (short*)data_ptr, count);
-
-        data_ptr = (uint8_t*)res_info->out_buffer;
-        count = res_info->out_frame_indeed * (res_info->BitsPerSample / 8) * res_info->NumChannels;
+        return size;
     }
 #endif
 
-    while (count) {
-        len = reverb_buffer_put(context->bufferImpl, data_ptr, count);
-        data_ptr += len;
-        count -= len;
-        if ((count != 0) && (context->put_block)) {
-            context->waitingSem = 1;
-            RG_SemaphoreWait(&context->sem);
-            context->waitingSem = 0;
-        } else {
-            break;
-        }
-    }
-
-#ifdef SUPPORT_FIXED_OUTPUT_CONFIG
-    if (has_resample) {
-        resample_release(res_info);
-    }
-#endif
+    reverb_pcm_put(context, data_ptr, count);
 
     return size;
 }
@@ -176,7 +207,14 @@ static int reverb_pcm_read(SoundStreamT *stream, void *buffer, unsigned int size
 
 static int reverb_pcm_flush(SoundStreamT *stream)
 {
-    /* not support now */
+#ifdef SUPPORT_FIXED_OUTPUT_CONFIG
+    ReverbContext *context = (ReverbContext *)stream;
+
+    /* the buffered pcm is not supported now, only the resampler history */
+    if (context->resampler) {
+        resampler_reset(&context->resampler->rs);
+    }
+#endif
     return 0;
 }
 
@@ -255,6 +293,9 @@ static void reverb_pcm_destroy(SoundStreamT *stream)
     ReverbContext *context = (ReverbContext *)stream;
     reverb_buffer_free(context->bufferImpl);
     RG_SemaphoreDeinit(&context->sem);
+#ifdef SUPPORT_FIXED_OUTPUT_CONFIG
+    free(context->resampler);
+#endif
     free(context);
 }
 
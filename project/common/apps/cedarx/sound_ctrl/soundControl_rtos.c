@@ -28,6 +28,7 @@ typedef struct SoundCtrlContext
 {
     SoundCtrl          base;
     SoundStreamCtrl    ssc;
+    SoundStreamType    type;
     enum SDSTATUS      eStatus;
     OS_Mutex_t         mutex;
 } SoundCtrlContext;
@@ -40,7 +41,7 @@ static void __Release(SoundCtrl* s)
     sc = (SoundCtrlContext*)s;
 
     OS_RecursiveMutexDelete(&sc->mutex);
-    snd_stream_destroy(sc->ssc, STREAM_TYPE_SOUND_CARD);
+    snd_stream_destroy(sc->ssc, sc->type);
 
     free(sc);
     sc = NULL;
@@ -65,7 +66,7 @@ static void __SetFormat(SoundCtrl* s, CdxPlaybkCfg* cfg)
 
     config.channels = cfg->nChannels;
     config.rate = cfg->nSamplerate;
-    snd_stream_control(sc->ssc, STREAM_TYPE_SOUND_CARD, STREAM_CMD_SET_CONFIG, &config);
+    snd_stream_control(sc->ssc, sc->type, STREAM_CMD_SET_CONFIG, &config);
 
     OS_RecursiveMutexUnlock(&sc->mutex);
 
@@ -87,7 +88,7 @@ static int __Start(SoundCtrl* s)
 
     if(sc->eStatus == SD_STATUS_STOPPED || sc->eStatus == SD_STATUS_PAUSED)
     {
-        snd_stream_open(sc->ssc, STREAM_TYPE_SOUND_CARD);
+        snd_stream_open(sc->ssc, sc->type);
     }
     sc->eStatus = SD_STATUS_STARTED;
     OS_RecursiveMutexUnlock(&sc->mutex);
@@ -121,7 +122,7 @@ static int SoundDeviceStop_l(SoundCtrlContext* sc)
     if(sc->eStatus != SD_STATUS_PAUSED)
     {
         int err;
-        if ((err = snd_stream_close(sc->ssc, STREAM_TYPE_SOUND_CARD)) < 0)
+        if ((err = snd_stream_close(sc->ssc, sc->type)) < 0)
         {
             SND_LOGE("Pcm close err..");
             return -1;
@@ -144,7 +145,7 @@ static int __Pause(SoundCtrl* s)
         OS_RecursiveMutexUnlock(&sc->mutex);
         return 0;
     }
-    if ((err = snd_stream_close(sc->ssc, STREAM_TYPE_SOUND_CARD)) < 0)
+    if ((err = snd_stream_close(sc->ssc, sc->type)) < 0)
     {
         SND_LOGE("Pcm close err..");
         OS_RecursiveMutexUnlock(&sc->mutex);
@@ -170,7 +171,7 @@ static int __Flush(SoundCtrl* s, void* block)
         OS_RecursiveMutexUnlock(&sc->mutex);
         return 0;
     }
-    if ((err = snd_stream_flush(sc->ssc, STREAM_TYPE_SOUND_CARD)) < 0)
+    if ((err = snd_stream_flush(sc->ssc, sc->type)) < 0)
     {
         OS_RecursiveMutexUnlock(&sc->mutex);
         SND_LOGE("Flush pcm data err..");
@@ -197,7 +198,7 @@ static int __Write(SoundCtrl* s, void* pData, int nDataSize)
         return 0;
     }
 
-    ret = snd_stream_write(sc->ssc, STREAM_TYPE_SOUND_CARD, pData, nDataSize);
+    ret = snd_stream_write(sc->ssc, sc->type, pData, nDataSize);
     if (ret != nDataSize) {
         OS_RecursiveMutexUnlock(&sc->mutex);
         return -1;
@@ -287,19 +288,25 @@ static int __Control(SoundCtrl* s, int cmd, void* para)
                 break;
             }
         case SOUND_CONTROL_SET_OUTPUT_CONFIG:
-            snd_stream_control(sc->ssc, STREAM_TYPE_SOUND_CARD, STREAM_CMD_SET_OUTPUT_CONFIG, para);
+            snd_stream_control(sc->ssc, sc->type, STREAM_CMD_SET_OUTPUT_CONFIG, para);
             break;
         case SOUND_CONTROL_ADD_OUTPUT_CONFIG:
-            snd_stream_control(sc->ssc, STREAM_TYPE_SOUND_CARD, STREAM_CMD_ADD_OUTPUT_CONFIG, para);
+            snd_stream_control(sc->ssc, sc->type, STREAM_CMD_ADD_OUTPUT_CONFIG, para);
             break;
         case SOUND_CONTROL_CLEAR_OUTPUT_CONFIG:
-            snd_stream_control(sc->ssc, STREAM_TYPE_SOUND_CARD, STREAM_CMD_CLEAR_OUTPUT_CONFIG, para);
+            snd_stream_control(sc->ssc, sc->type, STREAM_CMD_CLEAR_OUTPUT_CONFIG, para);
             break;
         case SOUND_CONTROL_SET_EQ_MODE:
-            snd_stream_control(sc->ssc, STREAM_TYPE_SOUND_CARD, STREAM_CMD_SET_EQ_MODE, para);
+            snd_stream_control(sc->ssc, sc->type, STREAM_CMD_SET_EQ_MODE, para);
             break;
         case SOUND_CONTROL_CLEAR_EQ_MODE:
-            snd_stream_control(sc->ssc, STREAM_TYPE_SOUND_CARD, STREAM_CMD_CLEAR_EQ_MODE, para);
+            snd_stream_control(sc->ssc, sc->type, STREAM_CMD_CLEAR_EQ_MODE, para);
+            break;
+        case SOUND_CONTROL_SET_GAIN:
+            snd_stream_control(sc->ssc, sc->type, STREAM_CMD_SET_GAIN, para);
+            break;
+        case SOUND_CONTROL_SET_DUCK:
+            snd_stream_control(sc->ssc, sc->type, STREAM_CMD_SET_DUCK, para);
             break;
         default:
             SND_LOGD("unknown command (%d)...", cmd);
@@ -325,7 +332,7 @@ static const SoundControlOpsT mSoundControlOps =
     .cdxControl       = __Control,
 };
 
-SoundCtrl* SoundDeviceCreate()
+static SoundCtrl* SoundDeviceCreateType(SoundStreamType type)
 {
     SoundCtrlContext* s;
     SND_LOGD("SoundDeviceInit");
@@ -339,7 +346,8 @@ SoundCtrl* SoundDeviceCreate()
 
     s->base.ops = &mSoundControlOps;
     s->eStatus = SD_STATUS_STOPPED;
-    s->ssc = snd_stream_create(STREAM_TYPE_SOUND_CARD);
+    s->type = type;
+    s->ssc = snd_stream_create(type);
     if (s->ssc == NULL)
     {
         SND_LOGE("snd_stream_create fail.");
@@ -351,4 +359,15 @@ SoundCtrl* SoundDeviceCreate()
     return (SoundCtrl*)s;
 }
 
-#endif
\ No newline at end of file
+SoundCtrl* SoundDeviceCreate()
+{
+    return SoundDeviceCreateType(STREAM_TYPE_SOUND_CARD);
+}
+
+/* a sink for a second player, e.g. of prompts, mixed over the first one */
+SoundCtrl* SoundDeviceCreateTone()
+{
+    return SoundDeviceCreateType(STREAM_TYPE_SOUND_TONE);
+}
+
+#endif
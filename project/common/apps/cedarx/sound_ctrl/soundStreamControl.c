@@ -77,6 +77,8 @@ struct SoundStreamNodeS
     SoundStreamT *stream;
     int create_refs;
     int open_refs;
+    int mix;        /* plays together with the other mixed streams of its priority */
+    int active;     /* opened */
 };
 
 int SoundStreamListInit(void)
@@ -86,7 +88,7 @@ int SoundStreamListInit(void)
     return 0;
 }
 
-static int SoundStreamRegister(const void *creator, SoundStreamType type, SoundStreamPriority priority)
+static int SoundStreamRegister(const void *creator, SoundStreamType type, SoundStreamPriority priority, int mix)
 {
     struct SoundStreamNodeS *streamNode;
 
@@ -95,6 +97,7 @@ static int SoundStreamRegister(const void *creator, SoundStreamType type, SoundS
     streamNode->creator = (const struct SoundStreamCreatorS *)creator;
     streamNode->type = type;
     streamNode->priority = priority;
+    streamNode->mix = mix;
 
     ListAddTail(&streamNode->node, &streamList.list);
     streamList.size++;
@@ -103,15 +106,24 @@ static int SoundStreamRegister(const void *creator, SoundStreamType type, SoundS
 
 extern const struct SoundStreamCreatorS CardStreamCtor;
 extern const struct SoundStreamCreatorS ReverbStreamCtor;
+extern const struct SoundStreamCreatorS ToneStreamCtor;
 
+/* without the sound mixer the card and tone streams take over from each other */
 int SoundStreamRegisterCard(void)
 {
-    return SoundStreamRegister(&CardStreamCtor, STREAM_TYPE_SOUND_CARD, STREAM_PRIORITY_LEVEL1);
+    return SoundStreamRegister(&CardStreamCtor, STREAM_TYPE_SOUND_CARD, STREAM_PRIORITY_LEVEL1,
+                               PRJCONF_SOUND_MIXER_EN);
 }
 
 int SoundStreamRegisterReverb(void)
 {
-    return SoundStreamRegister(&ReverbStreamCtor, STREAM_TYPE_REVERB_PCM, STREAM_PRIORITY_LEVEL2);
+    return SoundStreamRegister(&ReverbStreamCtor, STREAM_TYPE_REVERB_PCM, STREAM_PRIORITY_LEVEL2, 0);
+}
+
+int SoundStreamRegisterTone(void)
+{
+    return SoundStreamRegister(&ToneStreamCtor, STREAM_TYPE_SOUND_TONE, STREAM_PRIORITY_LEVEL1,
+                               PRJCONF_SOUND_MIXER_EN);
 }
 
 static struct SoundStreamNodeS *FindStreamNodeByType(SoundStreamType type)
@@ -238,15 +250,51 @@ static int SoundStreamDestroy(SoundStreamType type)
     return 0;
 }
 
-static int SoundStreamSelectOpen(SoundStreamType type)
+/*
+ * Of the opened streams, those of the highest priority play: all of them if
+ * they are mixed, else the last one registered.
+ */
+static int SoundStreamIsWanted(struct SoundStreamNodeS *streamNode, SoundStreamPriority priority,
+                               SoundStreamT *current)
 {
-    int ret;
-    SoundStreamT *stream;
-    SoundStreamPriority priority;
+    if (streamNode->open_refs == 0 || streamNode->priority != priority) {
+        return 0;
+    }
+    return streamNode->mix || streamNode->stream == current;
+}
+
+static void SoundStreamOpenWanted(void)
+{
+    SoundStreamT *current = FindCurrentSoundStream();
+    SoundStreamPriority priority = FindCurrentSoundStreamPriority();
     struct SoundStreamNodeS *streamNode;
 
-    stream = FindCurrentSoundStream();
-    priority = FindCurrentSoundStreamPriority();
+    ListForEachEntry(streamNode, &streamList.list, node) {
+        if (!streamNode->active && SoundStreamIsWanted(streamNode, priority, current)) {
+            if (SoundStreamOpen(streamNode->stream) == 0) {
+                streamNode->active = 1;
+            }
+        }
+    }
+}
+
+static void SoundStreamCloseUnwanted(void)
+{
+    SoundStreamT *current = FindCurrentSoundStream();
+    SoundStreamPriority priority = FindCurrentSoundStreamPriority();
+    struct SoundStreamNodeS *streamNode;
+
+    ListForEachEntry(streamNode, &streamList.list, node) {
+        if (streamNode->active && !SoundStreamIsWanted(streamNode, priority, current)) {
+            SoundStreamClose(streamNode->stream);
+            streamNode->active = 0;
+        }
+    }
+}
+
+static int SoundStreamSelectOpen(SoundStreamType type)
+{
+    struct SoundStreamNodeS *streamNode;
 
     streamNode = FindStreamNodeByType(type);
     if (streamNode == NULL) {
@@ -261,31 +309,24 @@ static int SoundStreamSelectOpen(SoundStreamType type)
 
     /*
      * if priority of new stream is lower than priority of current stream,
-     * we do nothing just return
-     * else, we will open new stream, and close current stream.
+     * it is not opened until those are closed.
+     * else, we will open new stream, and close the streams it takes over from,
+     * unless they are all mixed.
      */
-    if (streamNode->priority < priority) {
-        return 0;
-    }
-
-    ret = SoundStreamOpen(streamNode->stream);
-    if (ret) {
+    SoundStreamOpenWanted();
+    if (!streamNode->active &&
+            SoundStreamIsWanted(streamNode, FindCurrentSoundStreamPriority(), FindCurrentSoundStream())) {
         streamNode->open_refs--;
         SND_LOGE("open sound stream fail. type(%d)\n", type);
         return -1;
     }
-
-    if (stream) {
-        SoundStreamClose(stream);
-    }
+    SoundStreamCloseUnwanted();
 
     return 0;
 }
 
 static int SoundStreamSelectClose(SoundStreamType type)
 {
-    SoundStreamT *stream;
-    SoundStreamPriority priority;
     struct SoundStreamNodeS *streamNode;
 
     streamNode = FindStreamNodeByType(type);
@@ -299,24 +340,23 @@ static int SoundStreamSelectClose(SoundStreamType type)
         return 0;
     }
 
-    priority = FindCurrentSoundStreamPriority();
+    /* close this stream if it was playing, and open the ones it kept from playing */
+    SoundStreamCloseUnwanted();
+    SoundStreamOpenWanted();
 
-    /* if priority of closing stream is not highest in opened list,
-     * we will do nothing just return
-     * else, we will close this stream, and find a stream to open if we can.
-     */
-    if (streamNode->priority < priority) {
-        return 0; /* we will not close this stream, because this stream is not using, which mean not opened */
-    }
+    return 0;
+}
 
-    SoundStreamClose(streamNode->stream);
+/* a playing mixed stream is written to itself, else to the current stream */
+static SoundStreamT *SoundStreamForType(SoundStreamContext *context, SoundStreamType type)
+{
+    struct SoundStreamNodeS *streamNode;
 
-    stream = FindCurrentSoundStream();
-    if (stream) {
-        SoundStreamOpen(stream);
+    streamNode = FindStreamNodeByType(type);
+    if (streamNode && streamNode->mix && streamNode->active) {
+        return streamNode->stream;
     }
-
-    return 0;
+    return context->stream;
 }
 
 static int SoundStreamControl(SoundStreamType type, SoundStreamCmd cmd, void *param)
@@ -425,7 +465,7 @@ int snd_stream_flush(SoundStreamCtrl ssc, SoundStreamType type)
     SSC_ASSERT(FindOpenRefsByType(type) != 0);
 
     OS_RecursiveMutexLock(&context->mutex, OS_WAIT_FOREVER);
-    ret = SoundStreamFlush(context->stream);
+    ret = SoundStreamFlush(SoundStreamForType(context, type));
     OS_RecursiveMutexUnlock(&context->mutex);
     return ret;
 }
@@ -438,7 +478,7 @@ int snd_stream_write(SoundStreamCtrl ssc, SoundStreamType type, void* pData, int
     SSC_ASSERT(FindOpenRefsByType(type) != 0);
 
     /* can not lock SoundStreamWrite, because it may block, which case dead lock */
-    ret = SoundStreamWrite(context->stream, &(context->config), pData, nDataSize);
+    ret = SoundStreamWrite(SoundStreamForType(context, type), &(context->config), pData, nDataSize);
     return ret;
 }
 
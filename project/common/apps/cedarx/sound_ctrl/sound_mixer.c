@@ -0,0 +1,617 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if defined(__CONFIG_XPLAYER) && PRJCONF_SOUND_MIXER_EN
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "kernel/os/os.h"
+#include "audio/pcm/audio_pcm.h"
+#include "audio/manager/audio_manager.h"
+#include "audio/dsp/resampler.h"
+#include "sound_log.h"
+#include "sound_mixer.h"
+
+#define SOUND_MIXER_UNITY           (1 << 14)           /* gains are Q14 */
+#define SOUND_MIXER_DUCK_ATTACK     4                   /* periods to duck */
+#define SOUND_MIXER_DUCK_RELEASE    48                  /* periods to come back */
+#define SOUND_MIXER_CLOSE_TIMEOUT   2000                /* ms to play out a closing input */
+#define SOUND_MIXER_THREAD_STACK    (2 * 1024)
+#define SOUND_MIXER_CARD_PERIOD     1024
+#define SOUND_MIXER_CARD_PERIODS    2
+
+enum {
+    MIX_INPUT_IDLE,
+    MIX_INPUT_OPEN,
+    MIX_INPUT_CLOSING,      /* plays out what is queued, then idle */
+};
+
+struct SoundMixerInput {
+    SoundMixer *mixer;
+    unsigned int flags;
+    unsigned int state;
+    unsigned int channels;
+    unsigned int rate;
+    unsigned char *fifo;    /* SOUND_MIXER_FIFO_SIZE */
+    unsigned int in;        /* bytes, free running */
+    unsigned int out;
+    int gain;               /* as set */
+    int gain_cur;           /* at the end of the last period */
+    resampler_t *rs;        /* when the rate is not the card's */
+    uint8_t waiting;        /* the writer waits for room */
+    uint8_t draining;       /* the closer waits for the fifo to play out */
+    OS_Semaphore_t room;
+    OS_Semaphore_t drained;
+};
+
+struct SoundMixer {
+    int refs;
+    volatile int run;
+    OS_Thread_t thread;
+    OS_Mutex_t lock;        /* inputs and mixing */
+    OS_Mutex_t card_lock;   /* the card, held while writing a period */
+    OS_Semaphore_t wake;
+    struct pcm_config config;
+    unsigned int card_open;
+    unsigned int open_cnt;
+    int duck;
+    int duck_cur;
+    SoundMixerInput *input[SOUND_MIXER_INPUTS_MAX];
+    int acc[SOUND_MIXER_PERIOD * 2];
+    short tmp[SOUND_MIXER_PERIOD * 2];
+    short out[SOUND_MIXER_PERIOD * 2];
+};
+
+static SoundMixer *sound_mixer = NULL;
+static OS_Mutex_t sound_mixer_ref_mutex;   /* sound_mixer and its refs */
+
+static void sound_mixer_ref_lock(void)
+{
+    if (!OS_MutexIsValid(&sound_mixer_ref_mutex)) {
+        OS_ThreadSuspendScheduler();
+        if (!OS_MutexIsValid(&sound_mixer_ref_mutex)) {
+            OS_MutexCreate(&sound_mixer_ref_mutex);
+        }
+        OS_ThreadResumeScheduler();
+    }
+    OS_MutexLock(&sound_mixer_ref_mutex, OS_WAIT_FOREVER);
+}
+
+static void sound_mixer_ref_unlock(void)
+{
+    OS_MutexUnlock(&sound_mixer_ref_mutex);
+}
+
+static int sound_mixer_db_to_gain(int db)
+{
+    if (db < SOUND_MIXER_GAIN_MIN) {
+        return 0;
+    }
+    if (db > SOUND_MIXER_GAIN_MAX) {
+        db = SOUND_MIXER_GAIN_MAX;
+    }
+    return (int)(powf(10.0f, db / 20.0f) * SOUND_MIXER_UNITY + 0.5f);
+}
+
+static inline short sound_mixer_sat16(int x)
+{
+    return (short)(x > 32767 ? 32767 : (x < -32768 ? -32768 : x));
+}
+
+/* up to frames of the input at the rate of the card into tmp, the frames got */
+static unsigned int sound_mixer_pull(SoundMixer *mixer, SoundMixerInput *input,
+                                     unsigned int frames)
+{
+    unsigned int frame_size = input->channels * sizeof(short);
+    unsigned int done = 0, avail, pos, span;
+    uint32_t in_frames, out_frames;
+
+    while (done < frames) {
+        avail = (input->in - input->out) / frame_size;
+        pos = input->out % SOUND_MIXER_FIFO_SIZE;
+        span = (SOUND_MIXER_FIFO_SIZE - pos) / frame_size;
+        if (span > avail) {
+            span = avail;
+        }
+        if (span == 0) {
+            break;
+        }
+        if (input->rs == NULL) {
+            in_frames = out_frames = (span < frames - done) ? span : frames - done;
+            memcpy(mixer->tmp + done * input->channels, input->fifo + pos,
+                   in_frames * frame_size);
+        } else {
+            in_frames = span;
+            out_frames = frames - done;
+            resampler_process(input->rs, (const int16_t *)(input->fifo + pos), &in_frames,
+                              mixer->tmp + done * input->channels, &out_frames);
+        }
+        input->out += in_frames * frame_size;
+        done += out_frames;
+    }
+    return done;
+}
+
+/* acc += in * gain, the gain going from g0 to g1 over frames */
+static void sound_mixer_add(int *acc, const short *in, unsigned int n,
+                            unsigned int in_ch, unsigned int out_ch,
+                            int g0, int g1, unsigned int frames)
+{
+    int g = g0 * 256;
+    int dg = (g1 - g0) * 256 / (int)frames;
+    unsigned int i;
+
+    if (in_ch == out_ch) {
+        if (in_ch == 2) {
+            for (i = 0; i < n; i++, in += 2, acc += 2, g += dg) {
+                acc[0] += (in[0] * (g >> 8)) >> 14;
+                acc[1] += (in[1] * (g >> 8)) >> 14;
+            }
+        } else {
+            for (i = 0; i < n; i++, g += dg) {
+                acc[i] += (in[i] * (g >> 8)) >> 14;
+            }
+        }
+    } else if (in_ch == 1) {
+        for (i = 0; i < n; i++, acc += 2, g += dg) {
+            int v = (in[i] * (g >> 8)) >> 14;
+            acc[0] += v;
+            acc[1] += v;
+        }
+    } else {
+        for (i = 0; i < n; i++, in += 2, g += dg) {
+            acc[i] += ((in[0] + in[1]) * (g >> 8)) >> 15;
+        }
+    }
+}
+
+static void sound_mixer_input_idle(SoundMixer *mixer, SoundMixerInput *input)
+{
+    input->state = MIX_INPUT_IDLE;
+    mixer->open_cnt--;
+    if (input->draining) {
+        input->draining = 0;
+        OS_SemaphoreRelease(&input->drained);
+    }
+}
+
+/* one period of all the inputs, called with the lock held */
+static unsigned int sound_mixer_mix(SoundMixer *mixer, short *out, unsigned int frames)
+{
+    unsigned int ch = mixer->config.channels;
+    unsigned int i, n, ducking = 0;
+    int level, step, g1;
+    SoundMixerInput *input;
+
+    for (i = 0; i < SOUND_MIXER_INPUTS_MAX; i++) {
+        input = mixer->input[i];
+        if (input && input->state != MIX_INPUT_IDLE &&
+                (input->flags & SOUND_MIXER_DUCK_OTHERS)) {
+            ducking = 1;
+        }
+    }
+    level = ducking ? mixer->duck : SOUND_MIXER_UNITY;
+    step = (SOUND_MIXER_UNITY - mixer->duck) /
+           (ducking ? SOUND_MIXER_DUCK_ATTACK : SOUND_MIXER_DUCK_RELEASE) + 1;
+    if (mixer->duck_cur > level) {
+        mixer->duck_cur = (mixer->duck_cur - step > level) ? mixer->duck_cur - step : level;
+    } else if (mixer->duck_cur < level) {
+        mixer->duck_cur = (mixer->duck_cur + step < level) ? mixer->duck_cur + step : level;
+    }
+
+    memset(mixer->acc, 0, frames * ch * sizeof(int));
+    for (i = 0; i < SOUND_MIXER_INPUTS_MAX; i++) {
+        input = mixer->input[i];
+        if (input == NULL || input->state == MIX_INPUT_IDLE) {
+            continue;
+        }
+
+        n = sound_mixer_pull(mixer, input, frames);
+        g1 = input->gain;
+        if (!(input->flags & SOUND_MIXER_DUCK_OTHERS)) {
+            g1 = (g1 * mixer->duck_cur) >> 14;
+        }
+        sound_mixer_add(mixer->acc, mixer->tmp, n, input->channels, ch,
+                        input->gain_cur, g1, frames);
+        input->gain_cur = g1;
+
+        if (input->waiting && n) {
+            input->waiting = 0;
+            OS_SemaphoreRelease(&input->room);
+        }
+        if (input->state == MIX_INPUT_CLOSING &&
+                input->in - input->out < input->channels * sizeof(short)) {
+            sound_mixer_input_idle(mixer, input);
+        }
+    }
+
+    for (i = 0; i < frames * ch; i++) {
+        out[i] = sound_mixer_sat16(mixer->acc[i]);
+    }
+    return frames;
+}
+
+static void sound_mixer_task(void *arg)
+{
+    SoundMixer *mixer = (SoundMixer *)arg;
+    unsigned int frames;
+
+    while (mixer->run) {
+        OS_MutexLock(&mixer->lock, OS_WAIT_FOREVER);
+        if (mixer->open_cnt == 0) {
+            OS_MutexLock(&mixer->card_lock, OS_WAIT_FOREVER);
+            if (mixer->card_open) {
+                snd_pcm_close(AUDIO_SND_CARD_DEFAULT, PCM_OUT);
+                mixer->card_open = 0;
+            }
+            OS_MutexUnlock(&mixer->card_lock);
+            OS_MutexUnlock(&mixer->lock);
+            OS_SemaphoreWait(&mixer->wake, OS_WAIT_FOREVER);
+            continue;
+        }
+        frames = sound_mixer_mix(mixer, mixer->out, SOUND_MIXER_PERIOD);
+        OS_MutexUnlock(&mixer->lock);
+
+        /* blocks for about a period, the pace of the card */
+        OS_MutexLock(&mixer->card_lock, OS_WAIT_FOREVER);
+        snd_pcm_write(AUDIO_SND_CARD_DEFAULT, mixer->out,
+                      frames * mixer->config.channels * sizeof(short));
+        OS_MutexUnlock(&mixer->card_lock);
+    }
+
+    if (mixer->card_open) {
+        snd_pcm_close(AUDIO_SND_CARD_DEFAULT, PCM_OUT);
+        mixer->card_open = 0;
+    }
+    OS_ThreadDelete(&mixer->thread);
+}
+
+/**
+ * @brief Get the mixer of the default sound card, created on first use
+ */
+SoundMixer *sound_mixer_ref(void)
+{
+    SoundMixer *mixer;
+
+    sound_mixer_ref_lock();
+    mixer = sound_mixer;
+    if (mixer) {
+        mixer->refs++;
+        goto out;
+    }
+
+    mixer = (SoundMixer *)malloc(sizeof(SoundMixer));
+    if (mixer == NULL) {
+        SND_LOGE("malloc fail.\n");
+        goto out;
+    }
+    memset(mixer, 0, sizeof(SoundMixer));
+    mixer->duck = sound_mixer_db_to_gain(SOUND_MIXER_DUCK_DEFAULT);
+    mixer->duck_cur = SOUND_MIXER_UNITY;
+    OS_MutexCreate(&mixer->lock);
+    OS_MutexCreate(&mixer->card_lock);
+    OS_SemaphoreCreateBinary(&mixer->wake);
+
+    mixer->run = 1;
+    if (OS_ThreadCreate(&mixer->thread, "sound_mixer", sound_mixer_task, mixer,
+                        OS_PRIORITY_ABOVE_NORMAL, SOUND_MIXER_THREAD_STACK) != OS_OK) {
+        SND_LOGE("thread create fail.\n");
+        OS_SemaphoreDelete(&mixer->wake);
+        OS_MutexDelete(&mixer->card_lock);
+        OS_MutexDelete(&mixer->lock);
+        free(mixer);
+        mixer = NULL;
+        goto out;
+    }
+
+    mixer->refs = 1;
+    sound_mixer = mixer;
+out:
+    sound_mixer_ref_unlock();
+    return mixer;
+}
+
+void sound_mixer_unref(SoundMixer *mixer)
+{
+    sound_mixer_ref_lock();
+    if (--mixer->refs != 0) {
+        sound_mixer_ref_unlock();
+        return;
+    }
+
+    mixer->run = 0;
+    OS_SemaphoreRelease(&mixer->wake);
+    while (OS_ThreadIsValid(&mixer->thread)) {
+        OS_MSleep(1);
+    }
+
+    OS_SemaphoreDelete(&mixer->wake);
+    OS_MutexDelete(&mixer->card_lock);
+    OS_MutexDelete(&mixer->lock);
+    free(mixer);
+    sound_mixer = NULL;
+    sound_mixer_ref_unlock();
+}
+
+/**
+ * @brief Set how much the inputs are lowered while a ducking input is open
+ */
+void sound_mixer_set_duck(SoundMixer *mixer, int db)
+{
+    OS_MutexLock(&mixer->lock, OS_WAIT_FOREVER);
+    mixer->duck = sound_mixer_db_to_gain(db > 0 ? 0 : db);
+    OS_MutexUnlock(&mixer->lock);
+}
+
+SoundMixerInput *sound_mixer_input_create(SoundMixer *mixer, unsigned int flags)
+{
+    SoundMixerInput *input;
+    int i;
+
+    input = (SoundMixerInput *)malloc(sizeof(SoundMixerInput));
+    if (input == NULL) {
+        return NULL;
+    }
+    memset(input, 0, sizeof(SoundMixerInput));
+    input->fifo = (unsigned char *)malloc(SOUND_MIXER_FIFO_SIZE);
+    if (input->fifo == NULL) {
+        free(input);
+        return NULL;
+    }
+    input->mixer = mixer;
+    input->flags = flags;
+    input->gain = SOUND_MIXER_UNITY;
+    OS_SemaphoreCreateBinary(&input->room);
+    OS_SemaphoreCreateBinary(&input->drained);
+
+    OS_MutexLock(&mixer->lock, OS_WAIT_FOREVER);
+    for (i = 0; i < SOUND_MIXER_INPUTS_MAX; i++) {
+        if (mixer->input[i] == NULL) {
+            mixer->input[i] = input;
+            break;
+        }
+    }
+    OS_MutexUnlock(&mixer->lock);
+
+    if (i == SOUND_MIXER_INPUTS_MAX) {
+        SND_LOGE("too many mixer inputs.\n");
+        sound_mixer_input_destroy(input);
+        return NULL;
+    }
+    return input;
+}
+
+void sound_mixer_input_destroy(SoundMixerInput *input)
+{
+    SoundMixer *mixer = input->mixer;
+    int i;
+
+    OS_MutexLock(&mixer->lock, OS_WAIT_FOREVER);
+    if (input->state != MIX_INPUT_IDLE) {
+        sound_mixer_input_idle(mixer, input);
+    }
+    for (i = 0; i < SOUND_MIXER_INPUTS_MAX; i++) {
+        if (mixer->input[i] == input) {
+            mixer->input[i] = NULL;
+        }
+    }
+    OS_MutexUnlock(&mixer->lock);
+
+    OS_SemaphoreDelete(&input->drained);
+    OS_SemaphoreDelete(&input->room);
+    free(input->rs);
+    free(input->fifo);
+    free(input);
+}
+
+/**
+ * @brief Start an input; the first one to open sets the rate and channels of
+ *        the card, the later ones are converted to them. An input ducking the
+ *        others opens the card at SOUND_MIXER_CARD_RATE in stereo instead.
+ * @return 0 on success, -1 if the card can not be opened or the rate not be
+ *         converted
+ */
+int sound_mixer_input_open(SoundMixerInput *input, unsigned int rate, unsigned int channels)
+{
+    SoundMixer *mixer = input->mixer;
+    unsigned int card_rate = rate, card_channels = channels;
+    int ret = 0;
+
+    if (channels < 1 || channels > 2) {
+        return -1;
+    }
+    /* a tone must not bring music starting under it down to its own rate */
+    if (input->flags & SOUND_MIXER_DUCK_OTHERS) {
+        card_rate = SOUND_MIXER_CARD_RATE;
+        card_channels = 2;
+    }
+
+    OS_MutexLock(&mixer->lock, OS_WAIT_FOREVER);
+    if (input->state != MIX_INPUT_IDLE) {
+        sound_mixer_input_idle(mixer, input);
+    }
+
+    if (mixer->open_cnt == 0) {
+        OS_MutexLock(&mixer->card_lock, OS_WAIT_FOREVER);
+        if (mixer->card_open && (mixer->config.rate != card_rate ||
+                mixer->config.channels != card_channels)) {
+            snd_pcm_close(AUDIO_SND_CARD_DEFAULT, PCM_OUT);
+            mixer->card_open = 0;
+        }
+        if (!mixer->card_open) {
+            mixer->config.channels     = card_channels;
+            mixer->config.rate         = card_rate;
+            mixer->config.format       = PCM_FORMAT_S16_LE;
+            mixer->config.period_count = SOUND_MIXER_CARD_PERIODS;
+            mixer->config.period_size  = SOUND_MIXER_CARD_PERIOD;
+            if (snd_pcm_open(AUDIO_SND_CARD_DEFAULT, PCM_OUT, &mixer->config) != 0) {
+                ret = -1;
+            } else {
+                mixer->card_open = 1;
+            }
+        }
+        OS_MutexUnlock(&mixer->card_lock);
+        if (ret) {
+            goto out;
+        }
+    }
+
+    if (rate != mixer->config.rate) {
+        if (input->rs == NULL) {
+            input->rs = (resampler_t *)malloc(sizeof(resampler_t));
+        }
+        if (input->rs == NULL || resampler_init(input->rs, rate, mixer->config.rate, channels) != 0) {
+            SND_LOGE("can not convert %u to %u.\n", rate, mixer->config.rate);
+            ret = -1;
+            goto out;
+        }
+    } else {
+        free(input->rs);
+        input->rs = NULL;
+    }
+
+    input->rate = rate;
+    input->channels = channels;
+    input->in = input->out = 0;
+    input->gain_cur = 0;
+    input->waiting = 0;
+    input->draining = 0;
+    OS_SemaphoreWait(&input->room, 0);
+    OS_SemaphoreWait(&input->drained, 0);
+    input->state = MIX_INPUT_OPEN;
+    mixer->open_cnt++;
+    OS_SemaphoreRelease(&mixer->wake);
+out:
+    OS_MutexUnlock(&mixer->lock);
+    return ret;
+}
+
+/**
+ * @brief Stop an input after what is queued has played
+ */
+int sound_mixer_input_close(SoundMixerInput *input)
+{
+    SoundMixer *mixer = input->mixer;
+    int wait = 0;
+
+    OS_MutexLock(&mixer->lock, OS_WAIT_FOREVER);
+    if (input->state == MIX_INPUT_OPEN) {
+        input->state = MIX_INPUT_CLOSING;
+        input->draining = 1;
+        wait = 1;
+    }
+    OS_MutexUnlock(&mixer->lock);
+
+    if (wait && OS_SemaphoreWait(&input->drained, SOUND_MIXER_CLOSE_TIMEOUT) != OS_OK) {
+        OS_MutexLock(&mixer->lock, OS_WAIT_FOREVER);
+        if (input->state == MIX_INPUT_CLOSING) {
+            sound_mixer_input_idle(mixer, input);
+        }
+        OS_MutexUnlock(&mixer->lock);
+    }
+    return 0;
+}
+
+/**
+ * @brief Drop what is queued
+ */
+int sound_mixer_input_flush(SoundMixerInput *input)
+{
+    SoundMixer *mixer = input->mixer;
+
+    OS_MutexLock(&mixer->lock, OS_WAIT_FOREVER);
+    input->out = input->in;
+    if (input->rs) {
+        resampler_reset(input->rs);
+    }
+    if (input->waiting) {
+        input->waiting = 0;
+        OS_SemaphoreRelease(&input->room);
+    }
+    OS_MutexUnlock(&mixer->lock);
+    return 0;
+}
+
+/**
+ * @brief Queue pcm of the input, waits for room
+ * @return len, -1 if the input is not open
+ */
+int sound_mixer_input_write(SoundMixerInput *input, const void *data, unsigned int len)
+{
+    SoundMixer *mixer = input->mixer;
+    const unsigned char *p = (const unsigned char *)data;
+    unsigned int left = len, n, pos;
+
+    while (left) {
+        OS_MutexLock(&mixer->lock, OS_WAIT_FOREVER);
+        if (input->state != MIX_INPUT_OPEN) {
+            OS_MutexUnlock(&mixer->lock);
+            return -1;
+        }
+        pos = input->in % SOUND_MIXER_FIFO_SIZE;
+        n = SOUND_MIXER_FIFO_SIZE - (input->in - input->out);
+        if (n > SOUND_MIXER_FIFO_SIZE - pos) {
+            n = SOUND_MIXER_FIFO_SIZE - pos;
+        }
+        if (n > left) {
+            n = left;
+        }
+        if (n) {
+            memcpy(input->fifo + pos, p, n);
+            input->in += n;
+            p += n;
+            left -= n;
+        } else {
+            input->waiting = 1;
+        }
+        OS_MutexUnlock(&mixer->lock);
+
+        if (n == 0) {
+            OS_SemaphoreWait(&input->room, OS_WAIT_FOREVER);
+        }
+    }
+    return len;
+}
+
+/**
+ * @brief Set the gain of the input, from SOUND_MIXER_GAIN_MIN to
+ *        SOUND_MIXER_GAIN_MAX dB; it moves there over the next period
+ */
+void sound_mixer_input_set_gain(SoundMixerInput *input, int db)
+{
+    SoundMixer *mixer = input->mixer;
+
+    OS_MutexLock(&mixer->lock, OS_WAIT_FOREVER);
+    input->gain = sound_mixer_db_to_gain(db);
+    OS_MutexUnlock(&mixer->lock);
+}
+
+#endif
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _SOUND_MIXER_H_
+#define _SOUND_MIXER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Software mixer in front of the default sound card, so that several sound
+ * streams (music and tones) can play at the same time.
+ *
+ * Every input queues its pcm as written, in its own rate and channels. A
+ * thread takes one period from each open input, converts it to the rate and
+ * channels of the card, applies the gain of the input and accumulates, then
+ * writes the period to the card with one snd_pcm_write(). An input that runs
+ * dry contributes silence. The card is opened at the format of the music, the
+ * first input to open, or at SOUND_MIXER_CARD_RATE in stereo when a tone opens
+ * it, so music starting under a tone is only converted up.
+ *
+ * Gains move linearly over a period, so changing them does not click. While
+ * an input with SOUND_MIXER_DUCK_OTHERS is open the other inputs are lowered
+ * by the duck level: quickly going down, slowly coming back.
+ */
+
+#define SOUND_MIXER_INPUTS_MAX      4
+#define SOUND_MIXER_PERIOD          256                 /* frames mixed and written at a time */
+#define SOUND_MIXER_FIFO_SIZE       (8 * 1024)          /* bytes queued per input */
+#define SOUND_MIXER_CARD_RATE       48000               /* card rate when a tone opens it */
+#define SOUND_MIXER_DUCK_DEFAULT    (-12)               /* dB */
+#define SOUND_MIXER_GAIN_MAX        6                   /* dB */
+#define SOUND_MIXER_GAIN_MIN        (-60)               /* dB, muted below */
+
+#define SOUND_MIXER_DUCK_OTHERS     (1 << 0)            /* lowers the other inputs while open */
+
+typedef struct SoundMixer SoundMixer;
+typedef struct SoundMixerInput SoundMixerInput;
+
+SoundMixer *sound_mixer_ref(void);
+void sound_mixer_unref(SoundMixer *mixer);
+void sound_mixer_set_duck(SoundMixer *mixer, int db);
+
+SoundMixerInput *sound_mixer_input_create(SoundMixer *mixer, unsigned int flags);
+void sound_mixer_input_destroy(SoundMixerInput *input);
+int sound_mixer_input_open(SoundMixerInput *input, unsigned int rate, unsigned int channels);
+int sound_mixer_input_close(SoundMixerInput *input);
+int sound_mixer_input_flush(SoundMixerInput *input);
+int sound_mixer_input_write(SoundMixerInput *input, const void *data, unsigned int len);
+void sound_mixer_input_set_gain(SoundMixerInput *input, int db);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SOUND_MIXER_H_ */
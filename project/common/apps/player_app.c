@@ -47,6 +47,13 @@
 #define PLAYER_LOGW(msg, arg...)      printf("[PLAYER_WRN] <%s : %d> " msg "\n", __func__, __LINE__, ##arg)
 #define PLAYER_LOGE(msg, arg...)      printf("[PLAYER_ERR] <%s : %d> " msg "\n", __func__, __LINE__, ##arg)
 
+/* tones play on a second xplayer through the sound mixer, over the music */
+#if APP_PLAYER_SUPPORT_TONE && PRJCONF_SOUND_MIXER_EN
+#define PLAYER_TONE_MIXED   1
+#else
+#define PLAYER_TONE_MIXED   0
+#endif
+
 #if APP_PLAYER_SUPPORT_TONE
 struct tone_base
 {
@@ -80,6 +87,10 @@ typedef struct app_player
 #if APP_PLAYER_SUPPORT_TONE
     tone_base my_tone;
     tone_base *tone;
+#endif
+#if PLAYER_TONE_MIXED
+    XPlayer *tone_xplayer;
+    uint16_t tone_id;
 #endif
     int vol;
     uint16_t id;
@@ -118,12 +129,31 @@ static inline bool is_toning(app_player *impl)
 {
     return impl->tone != NULL;
 }
+
+/* the music player is taken by the tone, unless the tone has its own */
+static inline bool is_music_held(app_player *impl)
+{
+#if PLAYER_TONE_MIXED
+    return false;
+#else
+    return is_toning(impl);
+#endif
+}
+
+static inline uint16_t tone_id(app_player *impl)
+{
+#if PLAYER_TONE_MIXED
+    return impl->tone_id;
+#else
+    return impl->id;
+#endif
+}
 #endif
 
 static inline void set_player_handler(app_player *impl, void (**handler)(event_msg *msg))
 {
 #if APP_PLAYER_SUPPORT_TONE
-    if (is_toning(impl))
+    if (is_music_held(impl))
         *handler = tone_handler;
     else
 #endif
@@ -251,43 +281,61 @@ static void player_handler(event_msg *msg)
 }
 
 #if APP_PLAYER_SUPPORT_TONE
+/* the tone is over, give the music back its player */
+static void tone_end(app_player *impl)
+{
+    impl->tone = NULL;
+#if PLAYER_TONE_MIXED
+    if(XPlayerReset(impl->tone_xplayer) != 0)
+    {
+        PLAYER_LOGE("tone reset() return fail.");
+    }
+    impl->tone_id++;
+#else
+    reset(impl);
+    if (impl->state != APLAYER_STATES_STOPPED && impl->state != APLAYER_STATES_INIT)
+        set_url(impl, impl->info.url);
+#endif
+}
+
 static void tone_handler(event_msg *msg)
 {
     app_player* impl = get_player();
     player_events state = (player_events)APLAYER_GET_STATE(msg->data);
-    app_player_callback cb = impl->tone->cb;
+    app_player_callback cb;
+    void *arg;
 
     OS_RecursiveMutexLock(&impl->lock, OS_WAIT_FOREVER);
-    if (APLAYER_GET_ID(msg->data) != impl->id)
+    if (APLAYER_GET_ID(msg->data) != tone_id(impl) || !is_toning(impl))
         goto out;
+    cb = impl->tone->cb;
+    arg = impl->tone->arg;
 
     PLAYER_LOGI("tone event: %d, state: %d", (int)state, (int)impl->state);
 
     switch (state)
     {
         case PLAYER_EVENTS_MEDIA_PREPARED:
+#if PLAYER_TONE_MIXED
+            if(XPlayerStart(impl->tone_xplayer) != 0)
+            {
+                PLAYER_LOGE("tone start() return fail.");
+            }
+#else
             play(impl);
+#endif
             break;
         case PLAYER_EVENTS_TONE_STOPED:
-            impl->tone = NULL;
-            reset(impl);
-            if (impl->state != APLAYER_STATES_STOPPED && impl->state != APLAYER_STATES_INIT)
-                set_url(impl, impl->info.url);
-            cb(PLAYER_EVENTS_TONE_STOPED, NULL, impl->tone->arg);
+            tone_end(impl);
+            cb(PLAYER_EVENTS_TONE_STOPED, NULL, arg);
             break;
         case PLAYER_EVENTS_MEDIA_PLAYBACK_COMPLETE:
-            impl->tone = NULL;
-            reset(impl);
-            if (impl->state != APLAYER_STATES_STOPPED && impl->state != APLAYER_STATES_INIT)
-                set_url(impl, impl->info.url);
-            cb(PLAYER_EVENTS_TONE_COMPLETE, NULL, impl->tone->arg);
+            tone_end(impl);
+            cb(PLAYER_EVENTS_TONE_COMPLETE, NULL, arg);
             break;
         case PLAYER_EVENTS_MEDIA_ERROR:
-            impl->tone = NULL;
-            reset(impl);
-            if (impl->state != APLAYER_STATES_STOPPED && impl->state != APLAYER_STATES_INIT)
-                set_url(impl, impl->info.url);
-            cb(PLAYER_EVENTS_TONE_ERROR, NULL, impl->tone->arg);
+            tone_end(impl);
+            cb(PLAYER_EVENTS_TONE_ERROR, NULL, arg);
             break;
         default:
             break;
@@ -343,6 +391,32 @@ static int player_callback(void* pUserData, int msg, int ext1, void* param)
     return 0;
 }
 
+#if PLAYER_TONE_MIXED
+static int tone_callback(void* pUserData, int msg, int ext1, void* param)
+{
+    app_player* impl = (app_player*)pUserData;
+    player_events evt;
+
+    switch(msg)
+    {
+        case AWPLAYER_MEDIA_ERROR:
+            PLAYER_LOGW("open tone fail.");
+            evt = PLAYER_EVENTS_MEDIA_ERROR;
+            break;
+        case AWPLAYER_MEDIA_PREPARED:
+            evt = PLAYER_EVENTS_MEDIA_PREPARED;
+            break;
+        case AWPLAYER_MEDIA_PLAYBACK_COMPLETE:
+            evt = PLAYER_EVENTS_MEDIA_PLAYBACK_COMPLETE;
+            break;
+        default:
+            return 0;
+    }
+    sys_handler_send(tone_handler, APLAYER_ID_AND_STATE(impl->tone_id, evt), 10000);
+    return 0;
+}
+#endif
+
 static int player_stop(player_base *base)
 {
     void (*handler)(event_msg *);
@@ -350,7 +424,7 @@ static int player_stop(player_base *base)
 
     OS_RecursiveMutexLock(&impl->lock, OS_WAIT_FOREVER);
 #if APP_PLAYER_SUPPORT_TONE
-    if (is_toning(impl))
+    if (is_music_held(impl))
     {
         OS_RecursiveMutexUnlock(&impl->lock);
         return -1;
@@ -375,7 +449,7 @@ static int player_pause(player_base *base)
 
     OS_RecursiveMutexLock(&impl->lock, OS_WAIT_FOREVER);
 #if APP_PLAYER_SUPPORT_TONE
-    if (is_toning(impl))
+    if (is_music_held(impl))
     {
         OS_RecursiveMutexUnlock(&impl->lock);
         return -1;
@@ -395,7 +469,7 @@ static int player_resume(player_base *base)
 
     OS_RecursiveMutexLock(&impl->lock, OS_WAIT_FOREVER);
 #if APP_PLAYER_SUPPORT_TONE
-    if (is_toning(impl))
+    if (is_music_held(impl))
     {
         OS_RecursiveMutexUnlock(&impl->lock);
         return -1;
@@ -419,7 +493,7 @@ static int player_seek(player_base *base, int ms)
 
     OS_RecursiveMutexLock(&impl->lock, OS_WAIT_FOREVER);
 #if APP_PLAYER_SUPPORT_TONE
-    if (is_toning(impl))
+    if (is_music_held(impl))
     {
         OS_RecursiveMutexUnlock(&impl->lock);
         return -1;
@@ -451,7 +525,7 @@ static int player_seturl(player_base *base, const char *url)
 
     OS_RecursiveMutexLock(&impl->lock, OS_WAIT_FOREVER);
 #if APP_PLAYER_SUPPORT_TONE
-    if (is_toning(impl))
+    if (is_music_held(impl))
     {
         OS_RecursiveMutexUnlock(&impl->lock);
         return -1;
@@ -595,8 +669,10 @@ static int player_playtone(player_base *base, tone_base *drv, char *url)
         OS_RecursiveMutexUnlock(&impl->lock);
         return -1;
     }
+#if !PLAYER_TONE_MIXED
     set_current_time(impl);
     reset(impl);
+#endif
     impl->tone = drv;
     ret = drv->play(drv, url);
     OS_RecursiveMutexUnlock(&impl->lock);
@@ -625,7 +701,24 @@ static int player_stoptone(player_base *base, tone_base *drv)
 static int player_tone_play(tone_base *base, char *url)
 {
     app_player *impl = container_of(base, app_player, my_tone);
+#if PLAYER_TONE_MIXED
+    if(XPlayerSetDataSourceUrl(impl->tone_xplayer, (const char*)url, NULL, NULL) != 0)
+    {
+        PLAYER_LOGE("tone setDataSource() return fail.");
+        return -1;
+    }
+    if ((!strncmp(url, "http://", 7)) || (!strncmp(url, "https://", 8))) {
+        if(XPlayerPrepareAsync(impl->tone_xplayer) != 0)
+        {
+            PLAYER_LOGE("tone prepareAsync() return fail.");
+            return -1;
+        }
+    } else {
+        sys_handler_send(tone_handler, APLAYER_ID_AND_STATE(impl->tone_id, PLAYER_EVENTS_MEDIA_PREPARED), 10000);
+    }
+#else
     set_url(impl, url);
+#endif
     return 0;
 }
 
@@ -633,15 +726,26 @@ static int player_tone_stop(tone_base *base)
 {
     app_player *impl = container_of(base, app_player, my_tone);
 
-    void (*handler)(event_msg *);
-    set_player_handler(impl, &handler);
-    sys_handler_send(handler, APLAYER_ID_AND_STATE(impl->id, PLAYER_EVENTS_TONE_STOPED), 10000);
+    sys_handler_send(tone_handler, APLAYER_ID_AND_STATE(tone_id(impl), PLAYER_EVENTS_TONE_STOPED), 10000);
 
     return 0;
 }
 
 static int player_tone_destroy(tone_base *base)
 {
+#if PLAYER_TONE_MIXED
+    app_player *impl = container_of(base, app_player, my_tone);
+
+    OS_RecursiveMutexLock(&impl->lock, OS_WAIT_FOREVER);
+    if (impl->tone_xplayer != NULL) {
+        /* it will destroy the tone SoundDevice too */
+        XPlayerDestroy(impl->tone_xplayer);
+        impl->tone_xplayer = NULL;
+    }
+    impl->tone = NULL;
+    impl->tone_id++;
+    OS_RecursiveMutexUnlock(&impl->lock);
+#endif
     return 0;
 }
 #endif
@@ -760,6 +864,9 @@ void player_destroy(player_base *base)
     PLAYER_LOGI("destroy AwPlayer.");
     player_stop(base);
 
+#if PLAYER_TONE_MIXED
+    player_tone_destroy(&impl->my_tone);
+#endif
     OS_RecursiveMutexDelete(&impl->lock);
     if (impl->xplayer != NULL)
         XPlayerDestroy(impl->xplayer);
@@ -774,6 +881,24 @@ void player_destroy(player_base *base)
 tone_base * player_tone_create(player_base *base, app_player_callback cb, void *arg)
 {
     app_player *impl = container_of(base, app_player, base);
+#if PLAYER_TONE_MIXED
+    SoundCtrl *sound;
+
+    if (impl->tone_xplayer == NULL) {
+        impl->tone_xplayer = XPlayerCreate();
+        if (impl->tone_xplayer == NULL) {
+            return NULL;
+        }
+        XPlayerSetNotifyCallback(impl->tone_xplayer, tone_callback, (void*)impl);
+        if (XPlayerInitCheck(impl->tone_xplayer) != 0 ||
+            (sound = SoundDeviceCreateTone()) == NULL) {
+            XPlayerDestroy(impl->tone_xplayer);
+            impl->tone_xplayer = NULL;
+            return NULL;
+        }
+        XPlayerSetAudioSink(impl->tone_xplayer, (void*)sound);
+    }
+#endif
     impl->my_tone.cb = cb;
     impl->my_tone.play = player_tone_play;
     impl->my_tone.stop = player_tone_stop;
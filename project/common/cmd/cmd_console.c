@@ -27,10 +27,12 @@
  *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <stdio.h>
 #include <string.h>
 
 #include "cmd_util.h"
 #include "console/console.h"
+#include "driver/chip/hal_cmsis.h"
 
 static enum cmd_status cmd_console_enable_exec(char *cmd)
 {
@@ -90,11 +92,62 @@ static enum cmd_status cmd_console_write_exec(char *cmd)
 	return CMD_STATUS_OK;
 }
 
+/* console bench [n]: cycles spent in printf per call, measured with DWT */
+static enum cmd_status cmd_console_bench_exec(char *cmd)
+{
+	uint32_t i, n, start, cycles, min = ~0U, total = 0;
+
+	n = (*cmd == '\0') ? 16 : cmd_atoi(cmd);
+	if (n == 0) {
+		CMD_ERR("invalid cmd %s\n", cmd);
+		return CMD_STATUS_FAIL;
+	}
+#ifdef __CONFIG_LIBC_STDIO_DEFERRED
+	uint32_t dropped = stdio_deferred_dropped();
+#endif
+
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	for (i = 0; i < n; i++) {
+		start = DWT->CYCCNT;
+		printf("bench %u %s 0x%08x\n", i, "log", start);
+		cycles = DWT->CYCCNT - start;
+		total += cycles;
+		if (cycles < min)
+			min = cycles;
+	}
+#ifdef __CONFIG_LIBC_STDIO_DEFERRED
+	fflush(stdout);
+	printf("deferred, %u dropped\n", stdio_deferred_dropped() - dropped);
+#endif
+	printf("%u calls, cycles per call: avg %u, min %u\n", n, total / n, min);
+
+	return CMD_STATUS_OK;
+}
+
+#ifdef __CONFIG_LIBC_STDIO_DEFERRED
+/* console binary <0|1>: raw log records for tools/stdio_decode.py */
+static enum cmd_status cmd_console_binary_exec(char *cmd)
+{
+	if (cmd_strcmp(cmd, "0") && cmd_strcmp(cmd, "1")) {
+		CMD_ERR("invalid cmd %s\n", cmd);
+		return CMD_STATUS_FAIL;
+	}
+	stdio_deferred_set_binary(cmd_atoi(cmd));
+
+	return CMD_STATUS_OK;
+}
+#endif
+
 static const struct cmd_data g_console_cmds[] = {
 	{ "enable",			cmd_console_enable_exec },
 	{ "disable",		cmd_console_disable_exec },
 	{ "get",			cmd_console_get_exec },
 	{ "write",			cmd_console_write_exec },
+	{ "bench",			cmd_console_bench_exec },
+#ifdef __CONFIG_LIBC_STDIO_DEFERRED
+	{ "binary",			cmd_console_binary_exec },
+#endif
 };
 
 enum cmd_status cmd_console_exec(char *cmd)
@@ -488,6 +488,140 @@ static enum cmd_status cmd_fs_close_exec(char *cmd)
 	return CMD_STATUS_OK;
 }
 
+#define FS_BATCH_LINE_MAX_LEN	256
+#define FS_BATCH_READ_BUF_SIZE	512
+
+static uint8_t g_fs_batch_running;
+
+/* run one script line, return 0 to go on */
+static int fs_batch_line(char *line, uint32_t line_num, int truncated, int keep_going,
+                         uint32_t *cmd_cnt, uint32_t *fail_cnt)
+{
+	enum cmd_status status;
+	uint32_t start_tm, cost_tm;
+	char *end;
+
+	while (*line == ' ' || *line == '\t')
+		line++;
+	end = line + cmd_strlen(line);
+	while (end > line && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r'))
+		*--end = '\0';
+	if (*line == '\0' || *line == '#') /* empty line or comment */
+		return 0;
+
+	if (truncated) { /* never run a cut off command, e.g. "fs rm" of another path */
+		(*cmd_cnt)++;
+		(*fail_cnt)++;
+		CMD_ERR("[batch] line %u: longer than %d bytes, skipped\n", line_num,
+		        FS_BATCH_LINE_MAX_LEN - 1);
+		return keep_going ? 0 : -1;
+	}
+
+	CMD_LOG(1, "$ %s\n", line);
+	start_tm = OS_GetTicks();
+	status = cmd_main_line_exec(line);
+	cost_tm = OS_TicksToMSecs(OS_GetTicks() - start_tm);
+	(*cmd_cnt)++;
+
+	if (status >= CMD_STATUS_ERROR_MIN) {
+		(*fail_cnt)++;
+		CMD_LOG(1, "[batch] line %u: %s, cost %u ms\n", line_num,
+		        cmd_get_status_desc(status), cost_tm);
+		return keep_going ? 0 : -1;
+	}
+	CMD_LOG(1, "[batch] line %u: OK, cost %u ms\n", line_num, cost_tm);
+	return 0;
+}
+
+/*
+ * command: fs batch <file-path> [k]
+ *   Execute the script <file-path> line by line, as typed at the console.
+ *   Empty lines and lines starting with '#' are skipped. Stop at the first
+ *   failed command, unless 'k' (keep going) is given. A line too long for
+ *   the line buffer counts as a failed command and is not executed.
+ * example: fs batch test/factory.txt k
+ */
+static enum cmd_status cmd_fs_batch_exec(char *cmd)
+{
+	int argc, keep_going, truncated = 0, stop = 0;
+	char *argv[2];
+	FIL *fp;
+	FRESULT res;
+	char *line;
+	uint8_t *buf;
+	UINT i, rd;
+	uint32_t len = 0, line_num = 0, cmd_cnt = 0, fail_cnt = 0;
+	uint32_t start_tm;
+
+	argc = cmd_parse_argv(cmd, argv, cmd_nitems(argv));
+	if (argc < 1) {
+		CMD_ERR("invalid argument %s\n", cmd);
+		return CMD_STATUS_INVALID_ARG;
+	}
+	keep_going = (argc > 1 && cmd_strcmp(argv[1], "k") == 0);
+
+	if (g_fs_batch_running) {
+		CMD_ERR("batch is running\n");
+		return CMD_STATUS_FAIL;
+	}
+
+	fp = cmd_malloc(sizeof(FIL) + FS_BATCH_LINE_MAX_LEN + FS_BATCH_READ_BUF_SIZE);
+	if (fp == NULL) {
+		CMD_ERR("no memory\n");
+		return CMD_STATUS_FAIL;
+	}
+	cmd_memset(fp, 0, sizeof(FIL));
+	line = (char *)(fp + 1);
+	buf = (uint8_t *)line + FS_BATCH_LINE_MAX_LEN;
+
+	res = f_open(fp, argv[0], FA_READ | FA_OPEN_EXISTING);
+	if (res != FR_OK) {
+		CMD_ERR("open %s failed, return %d\n", argv[0], res);
+		cmd_free(fp);
+		return CMD_STATUS_FAIL;
+	}
+
+	g_fs_batch_running = 1;
+	start_tm = OS_GetTicks();
+	while (!stop) {
+		res = f_read(fp, buf, FS_BATCH_READ_BUF_SIZE, &rd);
+		if (res != FR_OK) {
+			CMD_ERR("read failed, return %d\n", res);
+			fail_cnt++;
+			break;
+		}
+		for (i = 0; i < rd && !stop; ++i) {
+			if (buf[i] != '\n') {
+				if (len < FS_BATCH_LINE_MAX_LEN - 1)
+					line[len++] = buf[i];
+				else if (buf[i] != '\r') /* CR of CRLF is trimmed anyway */
+					truncated = 1;
+				continue;
+			}
+			line[len] = '\0';
+			len = 0;
+			stop = fs_batch_line(line, ++line_num, truncated, keep_going, &cmd_cnt, &fail_cnt);
+			truncated = 0;
+		}
+		if (rd < FS_BATCH_READ_BUF_SIZE) { /* end of file */
+			if (!stop && len > 0) { /* last line without new line */
+				line[len] = '\0';
+				fs_batch_line(line, ++line_num, truncated, keep_going, &cmd_cnt, &fail_cnt);
+			}
+			break;
+		}
+	}
+	g_fs_batch_running = 0;
+
+	CMD_LOG(1, "[batch] %s: %u commands, %u failed, cost %u ms\n", argv[0],
+	        cmd_cnt, fail_cnt, (uint32_t)OS_TicksToMSecs(OS_GetTicks() - start_tm));
+
+	f_close(fp);
+	cmd_free(fp);
+
+	return fail_cnt ? CMD_STATUS_FAIL : CMD_STATUS_OK;
+}
+
 static enum cmd_status cmd_fs_help_exec(char *cmd);
 
 static const struct cmd_data g_fs_cmds[] = {
@@ -497,6 +631,7 @@ static const struct cmd_data g_fs_cmds[] = {
 	{ "rmdir",		cmd_fs_emptydir_exec, CMD_DESC("remove directory") },
 	{ "open",		cmd_fs_open_exec, CMD_DESC("open file, fs open <file-path>, eg. fs open fs_test/test.txt") },
 	{ "close",		cmd_fs_close_exec, CMD_DESC("close file") },
+	{ "batch",		cmd_fs_batch_exec, CMD_DESC("run a command script, fs batch <file-path> [k], eg. fs batch test/factory.txt k") },
 	{ "help",		cmd_fs_help_exec, CMD_DESC(CMD_HELP_DESC) },
 };
 
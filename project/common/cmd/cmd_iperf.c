@@ -51,6 +51,12 @@ static const char *iperf_help_info =
 #if IPERF_OPT_NUM
 "[*] -n : The number of bytes to transmit.\n"
 #endif
+#if IPERF_OPT_STREAMS
+"[*] -P : The number of simultaneous client streams (TCP is sent zero-copy).\n"
+#endif
+#if IPERF_OPT_JSON
+"[*] -J : Print the test result as JSON, with UDP jitter and loss histograms.\n"
+#endif
 "[*] -Q : Quit the iperf thread according to the iperf handle. Quit handl 1: -Q 1, quit all threads: -Q a\n"
 "[*] -L : Show the iperf thread list.";
 #endif /* CMD_DESCRIBE */
@@ -83,7 +89,8 @@ enum cmd_status cmd_iperf_exec(char *cmd)
 	}
 
 	struct netif *nif = g_wlan_netif;
-	if (nif == NULL || !NET_IS_IP4_VALID(nif)) {
+	if ((nif == NULL || !NET_IS_IP4_VALID(nif)) &&
+	    !iperf_handle_is_loopback(handle)) {
 		CMD_ERR("net is down, iperf start failed\n");
 		iperf_handle_free(handle);
 		return CMD_STATUS_FAIL;
@@ -29,23 +29,144 @@
 
 #include "cmd_util.h"
 #include <stdarg.h>
+#include "sys/interrupt.h"
 
+/*
+ * Command name index. The first lookup in a command table of at least
+ * CMD_INDEX_MIN_CNT entries sorts the entry numbers by name, later lookups
+ * binary search them. Command tables are const, so an index never goes stale
+ * and is kept for good. Tables beyond CMD_INDEX_TABLE_NUM are searched linearly.
+ */
+#define CMD_INDEX_MIN_CNT	8
+#define CMD_INDEX_MAX_CNT	255
+#define CMD_INDEX_TABLE_NUM	64	/* power of 2 */
+
+struct cmd_index {
+	const struct cmd_data *cdata;
+	uint8_t *order;
+};
+
+static struct cmd_index g_cmd_index[CMD_INDEX_TABLE_NUM];
+
+static uint32_t cmd_index_slot(const struct cmd_data *cdata)
+{
+	return ((uint32_t)cdata >> 2) & (CMD_INDEX_TABLE_NUM - 1);
+}
+
+/* stable sort by name, so the first of equal names wins as in a linear search */
+static uint8_t *cmd_index_build(const struct cmd_data *cdata, int count)
+{
+	int i, j;
+	uint8_t idx;
+	uint8_t *order;
+
+	order = cmd_malloc(count);
+	if (order == NULL) {
+		return NULL;
+	}
+	for (i = 0; i < count; ++i) {
+		idx = i;
+		for (j = i; j > 0 && cmd_strcmp(cdata[order[j - 1]].name, cdata[idx].name) > 0; --j) {
+			order[j] = order[j - 1];
+		}
+		order[j] = idx;
+	}
+	return order;
+}
+
+static const uint8_t *cmd_index_get(const struct cmd_data *cdata, int count)
+{
+	uint32_t i, slot;
+	unsigned long flags;
+	uint8_t *order;
+
+	slot = cmd_index_slot(cdata);
+	for (i = 0; i < CMD_INDEX_TABLE_NUM; ++i) {
+		struct cmd_index *index = &g_cmd_index[(slot + i) & (CMD_INDEX_TABLE_NUM - 1)];
+		if (index->cdata == cdata) {
+			return index->order;
+		}
+		if (index->cdata == NULL) {
+			break;
+		}
+	}
+	if (i == CMD_INDEX_TABLE_NUM) {
+		return NULL; /* registry full */
+	}
+
+	order = cmd_index_build(cdata, count);
+	if (order == NULL) {
+		return NULL;
+	}
+
+	/* publish, another task may have indexed the same table meanwhile */
+	flags = arch_irq_save();
+	for (i = 0; i < CMD_INDEX_TABLE_NUM; ++i) {
+		struct cmd_index *index = &g_cmd_index[(slot + i) & (CMD_INDEX_TABLE_NUM - 1)];
+		if (index->cdata == cdata) {
+			arch_irq_restore(flags);
+			cmd_free(order);
+			return index->order;
+		}
+		if (index->cdata == NULL) {
+			index->order = order;
+			index->cdata = cdata;
+			arch_irq_restore(flags);
+			return order;
+		}
+	}
+	arch_irq_restore(flags);
+	cmd_free(order);
+	return NULL;
+}
+
+static const struct cmd_data *cmd_find(const char *cmd, const struct cmd_data *cdata, int count)
+{
+	int i, lo, hi, mid;
+	const uint8_t *order = NULL;
+
+	if (count >= CMD_INDEX_MIN_CNT && count <= CMD_INDEX_MAX_CNT) {
+		order = cmd_index_get(cdata, count);
+	}
+
+	if (order) {
+		lo = 0;
+		hi = count;
+		while (lo < hi) {
+			mid = (lo + hi) / 2;
+			if (cmd_strcmp(cdata[order[mid]].name, cmd) < 0)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		if (lo < count && cmd_strcmp(cdata[order[lo]].name, cmd) == 0) {
+			return &cdata[order[lo]];
+		}
+		return NULL;
+	}
+
+	for (i = 0; i < count; ++i, ++cdata) {
+		if (cmd_strcmp(cmd, cdata->name) == 0) {
+			return cdata;
+		}
+	}
+	return NULL;
+}
 
 /* cmd format: <command-name> <arg>... */
 enum cmd_status cmd_exec(char *cmd, const struct cmd_data *cdata, int count)
 {
-	int i;
 	char *args;
+	const struct cmd_data *found;
 
 	args = cmd_strchr(cmd, ' ');
 	if (args) {
 		*args++ = '\0'; /* has arguments */
 	}
 
-	for (i = 0; i < count; ++i, ++cdata) {
-		if (cmd_strcmp(cmd, cdata->name) == 0) {
-			return cdata->exec(args ? args : "");
-		}
+	found = cmd_find(cmd, cdata, count);
+	if (found) {
+		return found->exec(args ? args : "");
 	}
 
 	CMD_ERR("unknown cmd '%s'\n", cmd);
@@ -97,10 +218,17 @@ enum cmd_status cmd2_help_exec(const struct cmd2_data *cdata, int count, int ali
 	return CMD_STATUS_ACKED;
 }
 
+/* the top level command table, as last used by cmd_main_exec() */
+static const struct cmd_data *g_cmd_main_data;
+static int g_cmd_main_cnt;
+
 enum cmd_status cmd_main_exec(char *cmd, const struct cmd_data *cdata, int count)
 {
 	enum cmd_status status = CMD_STATUS_OK;
 
+	g_cmd_main_data = cdata;
+	g_cmd_main_cnt = count;
+
 	if (cmd[0] != '\0') {
 #if (!CONSOLE_ECHO_EN)
 		if (cmd_strcmp(cmd, "efpg"))
@@ -127,6 +255,19 @@ enum cmd_status cmd_main_exec(char *cmd, const struct cmd_data *cdata, int count
 	return status;
 }
 
+/*
+ * Execute a command line with the top level command table, as if it was typed
+ * at the console but without the prompt and respond output, e.g. from a script.
+ */
+enum cmd_status cmd_main_line_exec(char *cmd)
+{
+	if (g_cmd_main_data == NULL) {
+		CMD_ERR("no main command table\n");
+		return CMD_STATUS_FAIL;
+	}
+	return cmd_exec(cmd, g_cmd_main_data, g_cmd_main_cnt);
+}
+
 /* parse all argument vectors from a command string, return argument count */
 int cmd_parse_argv(char *cmd, char *argv[], int size)
 {
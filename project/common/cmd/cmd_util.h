@@ -74,6 +74,7 @@ struct cmd2_data {
 enum cmd_status cmd_exec(char *cmd, const struct cmd_data *cdata, int count);
 enum cmd_status cmd_help_exec(const struct cmd_data *cdata, int count, int align);
 enum cmd_status cmd_main_exec(char *cmd, const struct cmd_data *cdata, int count);
+enum cmd_status cmd_main_line_exec(char *cmd);
 enum cmd_status cmd2_exec(char *cmd, const struct cmd2_data *cdata, int count);
 enum cmd_status cmd2_help_exec(const struct cmd2_data *cdata, int count, int align);
 
@@ -28,8 +28,11 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
+#include "audio/dsp/rfft.h"
 #include "fft.h"
 
 
@@ -37,96 +40,61 @@
 #define FFT_Points	(1<<N)
 //#define Fs			16000		// sample freqency = 16kHz
 #define Fin			1000		// input signal frequency = 1kHz
-#define WN_Coffe	31			//
+#define WIN_SHIFT	24			// windowed data scaled up by 2^7, still below 2^31
 
-extern const COMPLEX WN[];
 extern const __u32 Bh[];
 
-COMPLEX dbuf[FFT_Points];
-
-COMPLEX complex_add( COMPLEX x1, COMPLEX x2)
-{
-	COMPLEX x;
-	x.Re = x1.Re + x2.Re;
-	x.Im = x1.Im + x2.Im;
-
-	return x;
-}
-COMPLEX complex_sub( COMPLEX x1, COMPLEX x2)
-{
-	COMPLEX x;
-	x.Re = x1.Re - x2.Re;
-	x.Im = x1.Im - x2.Im;
-
-	return x;
-}
-COMPLEX complex_mul( COMPLEX x1, COMPLEX x2)
+/* magnitude of bin i of the packed spectrum from rfft_q31() */
+static double fft_mag(const __s32 *spec, __u32 i)
 {
-	COMPLEX x;
-	x.Re = (__s32)(((__s64)x1.Re * (__s64)x2.Re)>>WN_Coffe) - (__s32)(((__s64)x1.Im * (__s64)x2.Im)>>WN_Coffe);
-	x.Im = (__s32)(((__s64)x1.Re * (__s64)x2.Im)>>WN_Coffe) + (__s32)(((__s64)x1.Im * (__s64)x2.Re)>>WN_Coffe);
-
-	return x;
+	if(i > FFT_Points/2)
+		i = FFT_Points - i;		// mirror image, the input is real
+	if(i == 0)
+		return fabs((double)spec[0]);
+	if(i == FFT_Points/2)
+		return fabs((double)spec[1]);
+	return sqrt((double)spec[2*i] * spec[2*i] + (double)spec[2*i+1] * spec[2*i+1]);
 }
 
 FFT_RESULT Cooley_Tukey_FFT(__s32 *data, __u32 fs)
 {
-	__u32 i, j, k, index=0;
-	COMPLEX temp1, temp2, temp3;
+	__u32 i;
+	rfft_t fft;
+	__s32 *dbuf;
 	FFT_RESULT ret;
 	__u32 sig_index, sig_ibw_half, max_index = 0;
 	double sig_power = 0, noise_power = 0, temp_power, max_power = 0;
 
-
-	for(i = 0; i < FFT_Points; i++)
+	memset(&ret, 0, sizeof(ret));
+	dbuf = (__s32 *)malloc(FFT_Points * sizeof(__s32));
+	if(dbuf == NULL)
 	{
-		index = 0;
-		for(j = 0; j < N; j++)
-		{
-			index += ((i>>j)&0x1)<<(N-j-1);
-		}
-		dbuf[i].Re = (__s32)(((__s64)(data[index]<<16) * (__s64)Bh[index]) >> 31);
-		dbuf[i].Im = 0;
+		printf("fft buffer malloc fail\n");
+		return ret;
 	}
+	rfft_init(&fft, FFT_Points);
 
-	if(debug_print_en)
+	for(i = 0; i < FFT_Points; i++)
 	{
-		for(i = 0; i < FFT_Points; i++)
-		{
-			printf("dbuf[%d].Re = %d, dbuf[%d].Im = %d.\n", i, dbuf[i].Re, i, dbuf[i].Im);
-		}
+		dbuf[i] = (__s32)(((__s64)(data[i]<<16) * (__s64)Bh[i]) >> WIN_SHIFT);
 	}
 
-	for(i = 0; i < N; i++)
-	{
-		for(j = 0; j < (1<<(N-i-1)); j++)
-		{
-			for(k = 0; k < (1<<i); k++)
-			{
-				temp1 = complex_mul(dbuf[(1<<i) + j*(1<<(i+1)) + k], WN[k*(1<<(N-1-i))]);
-				temp2 = complex_add(dbuf[j*(1<<(i+1)) + k], temp1);		//Butterfly group index interval = 2^i
-				temp3 = complex_sub(dbuf[j*(1<<(i+1)) + k], temp1);
-
-				dbuf[j*(1<<(i+1)) + k] = temp2;
-				dbuf[(1<<i) + j*(1<<(i+1)) + k] = temp3;
-			}
-		}
-	}
+	rfft_q31(&fft, dbuf);
 
 	if(debug_print_en)
 	{
 		printf("Data after FFT:\n");
-		for(i = 0; i < FFT_Points; i++)
+		for(i = 1; i < FFT_Points/2; i++)
 		{
-			printf("dbuf_z[%d].Re = %d, FFT_Data[%d].Im = %d.\n", i, dbuf[i].Re, i, dbuf[i].Im);
+			printf("dbuf_z[%d].Re = %d, FFT_Data[%d].Im = %d.\n", i, dbuf[2*i], i, dbuf[2*i+1]);
 		}
-		for(i = 0; i < FFT_Points; i++)
+		for(i = 1; i < FFT_Points/2; i++)
 		{
-			printf("dbuf_z_magnitude[%d] = %f\n", i, sqrt(((__s64)dbuf[i].Re * (__s64)dbuf[i].Re) + ((__s64)dbuf[i].Im * (__s64)dbuf[i].Im)));
+			printf("dbuf_z_magnitude[%d] = %f\n", i, fft_mag(dbuf, i));
 		}
-		for(i = 0; i < FFT_Points; i++)
+		for(i = 1; i < FFT_Points/2; i++)
 		{
-			printf("dbuf_z_dB[%d] = %f\n", i, 20*log10(sqrt(((__s64)dbuf[i].Re * (__s64)dbuf[i].Re) + ((__s64)dbuf[i].Im * (__s64)dbuf[i].Im))));
+			printf("dbuf_z_dB[%d] = %f\n", i, 20*log10(fft_mag(dbuf, i)));
 		}
 	}
 
@@ -136,7 +104,7 @@ FFT_RESULT Cooley_Tukey_FFT(__s32 *data, __u32 fs)
 	sig_power = 0; max_power = 0;
 	for(i = sig_index - sig_ibw_half; i < sig_index + sig_ibw_half; i++)
 	{
-		temp_power = sqrt((__s64)(dbuf[i].Re * (__s64)dbuf[i].Re) + (__s64)(dbuf[i].Im * (__s64)dbuf[i].Im));
+		temp_power = fft_mag(dbuf, i);
 		sig_power += temp_power;
 
 		if(temp_power > max_power)
@@ -153,12 +121,12 @@ FFT_RESULT Cooley_Tukey_FFT(__s32 *data, __u32 fs)
 	noise_power = 0;
 	for(i = 0; i < sig_index - sig_ibw_half; i++)
 	{
-		temp_power = sqrt((__s64)(dbuf[i].Re * (__s64)dbuf[i].Re) + (__s64)(dbuf[i].Im * (__s64)dbuf[i].Im));
+		temp_power = fft_mag(dbuf, i);
 		noise_power += temp_power;
 	}
 	for(i = sig_index + sig_ibw_half; i < FFT_Points/2; i++)
 	{
-		temp_power = sqrt((__s64)(dbuf[i].Re * (__s64)dbuf[i].Re) + (__s64)(dbuf[i].Im * (__s64)dbuf[i].Im));
+		temp_power = fft_mag(dbuf, i);
 		noise_power += temp_power;
 	}
 	ret.noise_power = 20*log10(noise_power);
@@ -166,7 +134,7 @@ FFT_RESULT Cooley_Tukey_FFT(__s32 *data, __u32 fs)
 	sig_power = 0; max_power = 0;
 	for(i = sig_index*2 - sig_ibw_half; i < sig_index*2 + sig_ibw_half; i++)
 	{
-		temp_power = sqrt((__s64)(dbuf[i].Re * (__s64)dbuf[i].Re) + (__s64)(dbuf[i].Im * (__s64)dbuf[i].Im));
+		temp_power = fft_mag(dbuf, i);
 		sig_power += temp_power;
 
 		if(temp_power > max_power)
@@ -181,7 +149,7 @@ FFT_RESULT Cooley_Tukey_FFT(__s32 *data, __u32 fs)
 	sig_power = 0; max_power = 0;
 	for(i = sig_index*3 - sig_ibw_half; i < sig_index*3 + sig_ibw_half; i++)
 	{
-		temp_power = sqrt((__s64)(dbuf[i].Re * (__s64)dbuf[i].Re) + (__s64)(dbuf[i].Im * (__s64)dbuf[i].Im));
+		temp_power = fft_mag(dbuf, i);
 		sig_power += temp_power;
 
 		if(temp_power > max_power)
@@ -193,6 +161,7 @@ FFT_RESULT Cooley_Tukey_FFT(__s32 *data, __u32 fs)
 	ret.Harm3th_power = 20*log10(sig_power);
 	printf("Harm3th index = %d, F_Harm3th = %f kHz\n",max_index, (double)(max_index+1)*fs/FFT_Points/1000);
 
+	free(dbuf);
 	return ret;
 }
 
@@ -29,525 +29,6 @@
 
 #include "fft.h"
 
-// 1024 points FFT Twiddle factor Wn, HEX format;
-// Re=int32(cos(2*pi*(0:511)/1024) * (2^31-1))';	//Coefficient expansion
-// Im=int32(sin(2*pi*(0:511)/1024) * (2^31-1))';		//Coefficient expansion
-const COMPLEX WN[512] =
-{
-{0x7FFFFFFF,0x00000000},
-{0x7FFF6215,0xFF36F078},
-{0x7FFD8859,0xFE6DE2E0},
-{0x7FFA72D0,0xFDA4D929},
-{0x7FF62181,0xFCDBD541},
-{0x7FF09477,0xFC12D91A},
-{0x7FE9CBBF,0xFB49E6A3},
-{0x7FE1C76A,0xFA80FFCB},
-{0x7FD8878D,0xF9B82684},
-{0x7FCE0C3D,0xF8EF5CBB},
-{0x7FC25595,0xF826A462},
-{0x7FB563B2,0xF75DFF66},
-{0x7FA736B3,0xF6956FB7},
-{0x7F97CEBC,0xF5CCF744},
-{0x7F872BF2,0xF50497FB},
-{0x7F754E7F,0xF43C53CB},
-{0x7F62368E,0xF3742CA2},
-{0x7F4DE450,0xF2AC246E},
-{0x7F3857F5,0xF1E43D1C},
-{0x7F2191B3,0xF11C789A},
-{0x7F0991C3,0xF054D8D5},
-{0x7EF0585F,0xEF8D5FB8},
-{0x7ED5E5C5,0xEEC60F31},
-{0x7EBA3A38,0xEDFEE92B},
-{0x7E9D55FB,0xED37EF92},
-{0x7E7F3956,0xEC71244F},
-{0x7E5FE492,0xEBAA894F},
-{0x7E3F57FE,0xEAE4207B},
-{0x7E1D93E9,0xEA1DEBBC},
-{0x7DFA98A7,0xE957ECFB},
-{0x7DD6668E,0xE8922622},
-{0x7DB0FDF7,0xE7CC9918},
-{0x7D8A5F3F,0xE70747C4},
-{0x7D628AC5,0xE642340D},
-{0x7D3980EB,0xE57D5FDB},
-{0x7D0F4217,0xE4B8CD11},
-{0x7CE3CEB1,0xE3F47D96},
-{0x7CB72723,0xE330734D},
-{0x7C894BDD,0xE26CB01B},
-{0x7C5A3D4F,0xE1A935E2},
-{0x7C29FBED,0xE0E60685},
-{0x7BF8882F,0xE02323E5},
-{0x7BC5E28F,0xDF608FE4},
-{0x7B920B88,0xDE9E4C61},
-{0x7B5D039D,0xDDDC5B3B},
-{0x7B26CB4E,0xDD1ABE51},
-{0x7AEF6323,0xDC597782},
-{0x7AB6CBA3,0xDB9888A9},
-{0x7A7D055A,0xDAD7F3A3},
-{0x7A4210D8,0xDA17BA4A},
-{0x7A05EEAC,0xD957DE7B},
-{0x79C89F6D,0xD898620C},
-{0x798A23B0,0xD7D946D8},
-{0x794A7C11,0xD71A8EB6},
-{0x7909A92C,0xD65C3B7B},
-{0x78C7ABA1,0xD59E4EFF},
-{0x78848413,0xD4E0CB15},
-{0x78403328,0xD423B191},
-{0x77FAB988,0xD3670446},
-{0x77B417DF,0xD2AAC505},
-{0x776C4EDA,0xD1EEF59E},
-{0x77235F2C,0xD13397E2},
-{0x76D94988,0xD078AD9E},
-{0x768E0EA5,0xCFBE38A0},
-{0x7641AF3C,0xCF043AB3},
-{0x75F42C0A,0xCE4AB5A3},
-{0x75A585CE,0xCD91AB39},
-{0x7555BD4B,0xCCD91D3E},
-{0x7504D344,0xCC210D79},
-{0x74B2C883,0xCB697DB1},
-{0x745F9DD0,0xCAB26FAA},
-{0x740B53FA,0xC9FBE527},
-{0x73B5EBD0,0xC945DFED},
-{0x735F6625,0xC89061BA},
-{0x7307C3CF,0xC7DB6C50},
-{0x72AF05A6,0xC727016D},
-{0x72552C84,0xC67322CE},
-{0x71FA3948,0xC5BFD22F},
-{0x719E2CD1,0xC50D1149},
-{0x71410804,0xC45AE1D7},
-{0x70E2CBC5,0xC3A94590},
-{0x708378FE,0xC2F83E2B},
-{0x70231099,0xC247CD5B},
-{0x6FC19384,0xC197F4D4},
-{0x6F5F02B1,0xC0E8B649},
-{0x6EFB5F11,0xC03A1369},
-{0x6E96A99C,0xBF8C0DE3},
-{0x6E30E349,0xBEDEA766},
-{0x6DCA0D14,0xBE31E19C},
-{0x6D6227F9,0xBD85BE30},
-{0x6CF934FB,0xBCDA3ECB},
-{0x6C8F351B,0xBC2F6514},
-{0x6C24295F,0xBB8532B0},
-{0x6BB812D0,0xBADBA944},
-{0x6B4AF278,0xBA32CA71},
-{0x6ADCC964,0xB98A97D9},
-{0x6A6D98A3,0xB8E3131A},
-{0x69FD614A,0xB83C3DD2},
-{0x698C246B,0xB796199C},
-{0x6919E31F,0xB6F0A812},
-{0x68A69E80,0xB64BEACD},
-{0x683257AA,0xB5A7E363},
-{0x67BD0FBC,0xB5049369},
-{0x6746C7D7,0xB461FC71},
-{0x66CF811F,0xB3C0200D},
-{0x66573CBB,0xB31EFFCC},
-{0x65DDFBD2,0xB27E9D3D},
-{0x6563BF91,0xB1DEF9E9},
-{0x64E88925,0xB140175C},
-{0x646C59BF,0xB0A1F71E},
-{0x63EF328F,0xB0049AB4},
-{0x637114CC,0xAF6803A2},
-{0x62F201AC,0xAECC336C},
-{0x6271FA68,0xAE312B92},
-{0x61F1003E,0xAD96ED92},
-{0x616F146B,0xACFD7AE9},
-{0x60EC382F,0xAC64D511},
-{0x60686CCE,0xABCCFD83},
-{0x5FE3B38D,0xAB35F5B6},
-{0x5F5E0DB2,0xAA9FBF1E},
-{0x5ED77C89,0xAA0A5B2E},
-{0x5E50015D,0xA975CB57},
-{0x5DC79D7B,0xA8E21107},
-{0x5D3E5236,0xA84F2DAB},
-{0x5CB420DF,0xA7BD22AC},
-{0x5C290ACC,0xA72BF174},
-{0x5B9D1153,0xA69B9B69},
-{0x5B1035CE,0xA60C21EE},
-{0x5A827999,0xA57D8667},
-{0x59F3DE12,0xA4EFCA32},
-{0x59646497,0xA462EEAD},
-{0x58D40E8C,0xA3D6F534},
-{0x5842DD54,0xA34BDF21},
-{0x57B0D255,0xA2C1ADCA},
-{0x571DEEF9,0xA2386285},
-{0x568A34A9,0xA1AFFEA3},
-{0x55F5A4D2,0xA1288377},
-{0x556040E2,0xA0A1F24E},
-{0x54CA0A4A,0xA01C4C73},
-{0x5433027D,0x9F979332},
-{0x539B2AEF,0x9F13C7D1},
-{0x53028517,0x9E90EB95},
-{0x5269126E,0x9E0EFFC2},
-{0x51CED46E,0x9D8E0598},
-{0x5133CC94,0x9D0DFE54},
-{0x5097FC5E,0x9C8EEB34},
-{0x4FFB654C,0x9C10CD71},
-{0x4F5E08E2,0x9B93A641},
-{0x4EBFE8A4,0x9B1776DB},
-{0x4E210617,0x9A9C406F},
-{0x4D8162C3,0x9A22042E},
-{0x4CE10034,0x99A8C345},
-{0x4C3FDFF3,0x99307EE1},
-{0x4B9E038F,0x98B93829},
-{0x4AFB6C97,0x9842F044},
-{0x4A581C9D,0x97CDA856},
-{0x49B41533,0x97596180},
-{0x490F57EE,0x96E61CE1},
-{0x4869E664,0x9673DB95},
-{0x47C3C22E,0x96029EB6},
-{0x471CECE6,0x9592675D},
-{0x46756827,0x9523369C},
-{0x45CD358F,0x94B50D88},
-{0x452456BC,0x9447ED30},
-{0x447ACD50,0x93DBD6A1},
-{0x43D09AEC,0x9370CAE5},
-{0x4325C135,0x9306CB05},
-{0x427A41D0,0x929DD807},
-{0x41CE1E64,0x9235F2EC},
-{0x4121589A,0x91CF1CB7},
-{0x4073F21D,0x91695664},
-{0x3FC5EC97,0x9104A0EF},
-{0x3F1749B7,0x90A0FD4F},
-{0x3E680B2C,0x903E6C7C},
-{0x3DB832A5,0x8FDCEF67},
-{0x3D07C1D5,0x8F7C8702},
-{0x3C56BA70,0x8F1D343B},
-{0x3BA51E29,0x8EBEF7FC},
-{0x3AF2EEB7,0x8E61D32F},
-{0x3A402DD1,0x8E05C6B8},
-{0x398CDD32,0x8DAAD37C},
-{0x38D8FE93,0x8D50FA5A},
-{0x382493B0,0x8CF83C31},
-{0x376F9E46,0x8CA099DB},
-{0x36BA2013,0x8C4A1430},
-{0x36041AD9,0x8BF4AC06},
-{0x354D9056,0x8BA06230},
-{0x3496824F,0x8B4D377D},
-{0x33DEF287,0x8AFB2CBC},
-{0x3326E2C2,0x8AAA42B5},
-{0x326E54C7,0x8A5A7A32},
-{0x31B54A5D,0x8A0BD3F6},
-{0x30FBC54D,0x89BE50C4},
-{0x3041C760,0x8971F15B},
-{0x2F875262,0x8926B678},
-{0x2ECC681E,0x88DCA0D4},
-{0x2E110A62,0x8893B126},
-{0x2D553AFB,0x884BE821},
-{0x2C98FBBA,0x88054678},
-{0x2BDC4E6F,0x87BFCCD8},
-{0x2B1F34EB,0x877B7BED},
-{0x2A61B101,0x8738545F},
-{0x29A3C485,0x86F656D4},
-{0x28E5714A,0x86B583EF},
-{0x2826B928,0x8675DC50},
-{0x27679DF4,0x86376093},
-{0x26A82185,0x85FA1154},
-{0x25E845B6,0x85BDEF28},
-{0x25280C5D,0x8582FAA6},
-{0x24677757,0x8549345D},
-{0x23A6887E,0x85109CDD},
-{0x22E541AF,0x84D934B2},
-{0x2223A4C5,0x84A2FC63},
-{0x2161B39F,0x846DF478},
-{0x209F701C,0x843A1D71},
-{0x1FDCDC1B,0x840777D1},
-{0x1F19F97B,0x83D60413},
-{0x1E56CA1E,0x83A5C2B1},
-{0x1D934FE5,0x8376B423},
-{0x1CCF8CB3,0x8348D8DD},
-{0x1C0B826A,0x831C314F},
-{0x1B4732EF,0x82F0BDE9},
-{0x1A82A025,0x82C67F15},
-{0x19BDCBF3,0x829D753B},
-{0x18F8B83C,0x8275A0C1},
-{0x183366E8,0x824F0209},
-{0x176DD9DE,0x82299972},
-{0x16A81305,0x82056759},
-{0x15E21444,0x81E26C17},
-{0x151BDF85,0x81C0A802},
-{0x145576B1,0x81A01B6E},
-{0x138EDBB1,0x8180C6AA},
-{0x12C8106E,0x8162AA05},
-{0x120116D5,0x8145C5C8},
-{0x1139F0CF,0x812A1A3B},
-{0x1072A048,0x810FA7A1},
-{0x0FAB272B,0x80F66E3D},
-{0x0EE38766,0x80DE6E4D},
-{0x0E1BC2E4,0x80C7A80B},
-{0x0D53DB92,0x80B21BB0},
-{0x0C8BD35E,0x809DC972},
-{0x0BC3AC35,0x808AB181},
-{0x0AFB6805,0x8078D40E},
-{0x0A3308BC,0x80683144},
-{0x096A9049,0x8058C94D},
-{0x08A2009A,0x804A9C4E},
-{0x07D95B9E,0x803DAA6B},
-{0x0710A345,0x8031F3C3},
-{0x0647D97C,0x80277873},
-{0x057F0035,0x801E3896},
-{0x04B6195D,0x80163441},
-{0x03ED26E6,0x800F6B89},
-{0x03242ABF,0x8009DE7F},
-{0x025B26D7,0x80058D30},
-{0x01921D20,0x800277A7},
-{0x00C90F88,0x80009DEB},
-{0x00000000,0x80000001},
-{0xFF36F078,0x80009DEB},
-{0xFE6DE2E0,0x800277A7},
-{0xFDA4D929,0x80058D30},
-{0xFCDBD541,0x8009DE7F},
-{0xFC12D91A,0x800F6B89},
-{0xFB49E6A3,0x80163441},
-{0xFA80FFCB,0x801E3896},
-{0xF9B82684,0x80277873},
-{0xF8EF5CBB,0x8031F3C3},
-{0xF826A462,0x803DAA6B},
-{0xF75DFF66,0x804A9C4E},
-{0xF6956FB7,0x8058C94D},
-{0xF5CCF744,0x80683144},
-{0xF50497FB,0x8078D40E},
-{0xF43C53CB,0x808AB181},
-{0xF3742CA2,0x809DC972},
-{0xF2AC246E,0x80B21BB0},
-{0xF1E43D1C,0x80C7A80B},
-{0xF11C789A,0x80DE6E4D},
-{0xF054D8D5,0x80F66E3D},
-{0xEF8D5FB8,0x810FA7A1},
-{0xEEC60F31,0x812A1A3B},
-{0xEDFEE92B,0x8145C5C8},
-{0xED37EF92,0x8162AA05},
-{0xEC71244F,0x8180C6AA},
-{0xEBAA894F,0x81A01B6E},
-{0xEAE4207B,0x81C0A802},
-{0xEA1DEBBC,0x81E26C17},
-{0xE957ECFB,0x82056759},
-{0xE8922622,0x82299972},
-{0xE7CC9918,0x824F0209},
-{0xE70747C4,0x8275A0C1},
-{0xE642340D,0x829D753B},
-{0xE57D5FDB,0x82C67F15},
-{0xE4B8CD11,0x82F0BDE9},
-{0xE3F47D96,0x831C314F},
-{0xE330734D,0x8348D8DD},
-{0xE26CB01B,0x8376B423},
-{0xE1A935E2,0x83A5C2B1},
-{0xE0E60685,0x83D60413},
-{0xE02323E5,0x840777D1},
-{0xDF608FE4,0x843A1D71},
-{0xDE9E4C61,0x846DF478},
-{0xDDDC5B3B,0x84A2FC63},
-{0xDD1ABE51,0x84D934B2},
-{0xDC597782,0x85109CDD},
-{0xDB9888A9,0x8549345D},
-{0xDAD7F3A3,0x8582FAA6},
-{0xDA17BA4A,0x85BDEF28},
-{0xD957DE7B,0x85FA1154},
-{0xD898620C,0x86376093},
-{0xD7D946D8,0x8675DC50},
-{0xD71A8EB6,0x86B583EF},
-{0xD65C3B7B,0x86F656D4},
-{0xD59E4EFF,0x8738545F},
-{0xD4E0CB15,0x877B7BED},
-{0xD423B191,0x87BFCCD8},
-{0xD3670446,0x88054678},
-{0xD2AAC505,0x884BE821},
-{0xD1EEF59E,0x8893B126},
-{0xD13397E2,0x88DCA0D4},
-{0xD078AD9E,0x8926B678},
-{0xCFBE38A0,0x8971F15B},
-{0xCF043AB3,0x89BE50C4},
-{0xCE4AB5A3,0x8A0BD3F6},
-{0xCD91AB39,0x8A5A7A32},
-{0xCCD91D3E,0x8AAA42B5},
-{0xCC210D79,0x8AFB2CBC},
-{0xCB697DB1,0x8B4D377D},
-{0xCAB26FAA,0x8BA06230},
-{0xC9FBE527,0x8BF4AC06},
-{0xC945DFED,0x8C4A1430},
-{0xC89061BA,0x8CA099DB},
-{0xC7DB6C50,0x8CF83C31},
-{0xC727016D,0x8D50FA5A},
-{0xC67322CE,0x8DAAD37C},
-{0xC5BFD22F,0x8E05C6B8},
-{0xC50D1149,0x8E61D32F},
-{0xC45AE1D7,0x8EBEF7FC},
-{0xC3A94590,0x8F1D343B},
-{0xC2F83E2B,0x8F7C8702},
-{0xC247CD5B,0x8FDCEF67},
-{0xC197F4D4,0x903E6C7C},
-{0xC0E8B649,0x90A0FD4F},
-{0xC03A1369,0x9104A0EF},
-{0xBF8C0DE3,0x91695664},
-{0xBEDEA766,0x91CF1CB7},
-{0xBE31E19C,0x9235F2EC},
-{0xBD85BE30,0x929DD807},
-{0xBCDA3ECB,0x9306CB05},
-{0xBC2F6514,0x9370CAE5},
-{0xBB8532B0,0x93DBD6A1},
-{0xBADBA944,0x9447ED30},
-{0xBA32CA71,0x94B50D88},
-{0xB98A97D9,0x9523369C},
-{0xB8E3131A,0x9592675D},
-{0xB83C3DD2,0x96029EB6},
-{0xB796199C,0x9673DB95},
-{0xB6F0A812,0x96E61CE1},
-{0xB64BEACD,0x97596180},
-{0xB5A7E363,0x97CDA856},
-{0xB5049369,0x9842F044},
-{0xB461FC71,0x98B93829},
-{0xB3C0200D,0x99307EE1},
-{0xB31EFFCC,0x99A8C345},
-{0xB27E9D3D,0x9A22042E},
-{0xB1DEF9E9,0x9A9C406F},
-{0xB140175C,0x9B1776DB},
-{0xB0A1F71E,0x9B93A641},
-{0xB0049AB4,0x9C10CD71},
-{0xAF6803A2,0x9C8EEB34},
-{0xAECC336C,0x9D0DFE54},
-{0xAE312B92,0x9D8E0598},
-{0xAD96ED92,0x9E0EFFC2},
-{0xACFD7AE9,0x9E90EB95},
-{0xAC64D511,0x9F13C7D1},
-{0xABCCFD83,0x9F979332},
-{0xAB35F5B6,0xA01C4C73},
-{0xAA9FBF1E,0xA0A1F24E},
-{0xAA0A5B2E,0xA1288377},
-{0xA975CB57,0xA1AFFEA3},
-{0xA8E21107,0xA2386285},
-{0xA84F2DAB,0xA2C1ADCA},
-{0xA7BD22AC,0xA34BDF21},
-{0xA72BF174,0xA3D6F534},
-{0xA69B9B69,0xA462EEAD},
-{0xA60C21EE,0xA4EFCA32},
-{0xA57D8667,0xA57D8667},
-{0xA4EFCA32,0xA60C21EE},
-{0xA462EEAD,0xA69B9B69},
-{0xA3D6F534,0xA72BF174},
-{0xA34BDF21,0xA7BD22AC},
-{0xA2C1ADCA,0xA84F2DAB},
-{0xA2386285,0xA8E21107},
-{0xA1AFFEA3,0xA975CB57},
-{0xA1288377,0xAA0A5B2E},
-{0xA0A1F24E,0xAA9FBF1E},
-{0xA01C4C73,0xAB35F5B6},
-{0x9F979332,0xABCCFD83},
-{0x9F13C7D1,0xAC64D511},
-{0x9E90EB95,0xACFD7AE9},
-{0x9E0EFFC2,0xAD96ED92},
-{0x9D8E0598,0xAE312B92},
-{0x9D0DFE54,0xAECC336C},
-{0x9C8EEB34,0xAF6803A2},
-{0x9C10CD71,0xB0049AB4},
-{0x9B93A641,0xB0A1F71E},
-{0x9B1776DB,0xB140175C},
-{0x9A9C406F,0xB1DEF9E9},
-{0x9A22042E,0xB27E9D3D},
-{0x99A8C345,0xB31EFFCC},
-{0x99307EE1,0xB3C0200D},
-{0x98B93829,0xB461FC71},
-{0x9842F044,0xB5049369},
-{0x97CDA856,0xB5A7E363},
-{0x97596180,0xB64BEACD},
-{0x96E61CE1,0xB6F0A812},
-{0x9673DB95,0xB796199C},
-{0x96029EB6,0xB83C3DD2},
-{0x9592675D,0xB8E3131A},
-{0x9523369C,0xB98A97D9},
-{0x94B50D88,0xBA32CA71},
-{0x9447ED30,0xBADBA944},
-{0x93DBD6A1,0xBB8532B0},
-{0x9370CAE5,0xBC2F6514},
-{0x9306CB05,0xBCDA3ECB},
-{0x929DD807,0xBD85BE30},
-{0x9235F2EC,0xBE31E19C},
-{0x91CF1CB7,0xBEDEA766},
-{0x91695664,0xBF8C0DE3},
-{0x9104A0EF,0xC03A1369},
-{0x90A0FD4F,0xC0E8B649},
-{0x903E6C7C,0xC197F4D4},
-{0x8FDCEF67,0xC247CD5B},
-{0x8F7C8702,0xC2F83E2B},
-{0x8F1D343B,0xC3A94590},
-{0x8EBEF7FC,0xC45AE1D7},
-{0x8E61D32F,0xC50D1149},
-{0x8E05C6B8,0xC5BFD22F},
-{0x8DAAD37C,0xC67322CE},
-{0x8D50FA5A,0xC727016D},
-{0x8CF83C31,0xC7DB6C50},
-{0x8CA099DB,0xC89061BA},
-{0x8C4A1430,0xC945DFED},
-{0x8BF4AC06,0xC9FBE527},
-{0x8BA06230,0xCAB26FAA},
-{0x8B4D377D,0xCB697DB1},
-{0x8AFB2CBC,0xCC210D79},
-{0x8AAA42B5,0xCCD91D3E},
-{0x8A5A7A32,0xCD91AB39},
-{0x8A0BD3F6,0xCE4AB5A3},
-{0x89BE50C4,0xCF043AB3},
-{0x8971F15B,0xCFBE38A0},
-{0x8926B678,0xD078AD9E},
-{0x88DCA0D4,0xD13397E2},
-{0x8893B126,0xD1EEF59E},
-{0x884BE821,0xD2AAC505},
-{0x88054678,0xD3670446},
-{0x87BFCCD8,0xD423B191},
-{0x877B7BED,0xD4E0CB15},
-{0x8738545F,0xD59E4EFF},
-{0x86F656D4,0xD65C3B7B},
-{0x86B583EF,0xD71A8EB6},
-{0x8675DC50,0xD7D946D8},
-{0x86376093,0xD898620C},
-{0x85FA1154,0xD957DE7B},
-{0x85BDEF28,0xDA17BA4A},
-{0x8582FAA6,0xDAD7F3A3},
-{0x8549345D,0xDB9888A9},
-{0x85109CDD,0xDC597782},
-{0x84D934B2,0xDD1ABE51},
-{0x84A2FC63,0xDDDC5B3B},
-{0x846DF478,0xDE9E4C61},
-{0x843A1D71,0xDF608FE4},
-{0x840777D1,0xE02323E5},
-{0x83D60413,0xE0E60685},
-{0x83A5C2B1,0xE1A935E2},
-{0x8376B423,0xE26CB01B},
-{0x8348D8DD,0xE330734D},
-{0x831C314F,0xE3F47D96},
-{0x82F0BDE9,0xE4B8CD11},
-{0x82C67F15,0xE57D5FDB},
-{0x829D753B,0xE642340D},
-{0x8275A0C1,0xE70747C4},
-{0x824F0209,0xE7CC9918},
-{0x82299972,0xE8922622},
-{0x82056759,0xE957ECFB},
-{0x81E26C17,0xEA1DEBBC},
-{0x81C0A802,0xEAE4207B},
-{0x81A01B6E,0xEBAA894F},
-{0x8180C6AA,0xEC71244F},
-{0x8162AA05,0xED37EF92},
-{0x8145C5C8,0xEDFEE92B},
-{0x812A1A3B,0xEEC60F31},
-{0x810FA7A1,0xEF8D5FB8},
-{0x80F66E3D,0xF054D8D5},
-{0x80DE6E4D,0xF11C789A},
-{0x80C7A80B,0xF1E43D1C},
-{0x80B21BB0,0xF2AC246E},
-{0x809DC972,0xF3742CA2},
-{0x808AB181,0xF43C53CB},
-{0x8078D40E,0xF50497FB},
-{0x80683144,0xF5CCF744},
-{0x8058C94D,0xF6956FB7},
-{0x804A9C4E,0xF75DFF66},
-{0x803DAA6B,0xF826A462},
-{0x8031F3C3,0xF8EF5CBB},
-{0x80277873,0xF9B82684},
-{0x801E3896,0xFA80FFCB},
-{0x80163441,0xFB49E6A3},
-{0x800F6B89,0xFC12D91A},
-{0x8009DE7F,0xFCDBD541},
-{0x80058D30,0xFDA4D929},
-{0x800277A7,0xFE6DE2E0},
-{0x80009DEB,0xFF36F078}
-};
-
 //BhW  = blackmanharris(1024);			//1024 points Blackman-Harrris Window
 //Bh = (2*BhW/sum(BhW)) * 2^31;		//Coefficient expansion
 const __u32 Bh[1024] =
@@ -63,12 +63,6 @@ typedef s16 __s16;
 typedef s32 __s32;
 typedef s64 __s64;
 
-typedef struct _COMPLEX
-{
-	__s32 Re;
-	__s32 Im;
-} COMPLEX;
-
 typedef struct _FFT_RESULT
 {
 	double sig_power;
@@ -78,8 +72,4 @@ typedef struct _FFT_RESULT
 	float sig_freq;
 } FFT_RESULT;
 
-COMPLEX complex_add( COMPLEX x1, COMPLEX x2);
-COMPLEX complex_sub( COMPLEX x1, COMPLEX x2);
-COMPLEX complex_mul( COMPLEX x1, COMPLEX x2);
-
 #endif
@@ -55,6 +55,9 @@ void mbedtls_client( void *arg)
 #include "mbedtls/ctr_drbg.h"
 #include "mbedtls/error.h"
 #include "mbedtls/certs.h"
+#if (__CONFIG_MBEDTLS_VER == 0x02100000)
+#include "mbedtls/trust_store.h"
+#endif
 
 extern volatile int mbedtls_string_mismatch;
 
@@ -79,7 +82,12 @@ void mbedtls_client(void *arg)
 	mbedtls_ctr_drbg_context ctr_drbg;
 	mbedtls_ssl_context ssl;
 	mbedtls_ssl_config conf;
+#if defined(MBEDTLS_TRUST_STORE)
+	mbedtls_trust_param trust_param;
+	mbedtls_trust_store *trust = NULL;
+#else
 	mbedtls_x509_crt cacert;
+#endif
 	unsigned char *buf = mbedtls_calloc(1,TLS_TEST_BUF_SIZE);
 	if (!buf) {
 		mbedtls_printf( "\n[TLS CLI]Malloc failed.\n" );
@@ -93,7 +101,9 @@ void mbedtls_client(void *arg)
 	mbedtls_net_init(&server_fd);
 	mbedtls_ssl_init(&ssl);
 	mbedtls_ssl_config_init(&conf);
+#if !defined(MBEDTLS_TRUST_STORE)
 	mbedtls_x509_crt_init(&cacert);
+#endif
 	mbedtls_ctr_drbg_init(&ctr_drbg);
 
 	mbedtls_printf("Seeding the random number generator.\n");
@@ -107,6 +117,23 @@ void mbedtls_client(void *arg)
 	mbedtls_printf("ok\n");
 	/* Initialize certificates */
 	mbedtls_printf("Loading the CA root certificate .\n");
+#if defined(MBEDTLS_TRUST_STORE)
+	/* parsed once, shared by the following connections */
+	memset(&trust_param, 0, sizeof(trust_param));
+#if defined(MBEDTLS_CUSTOM_CA)
+	trust_param.ca[0].buf = (const unsigned char *) mbedtls_custom_cas_pem;
+	trust_param.ca[0].len = mbedtls_custom_cas_pem_len;
+#else
+	trust_param.ca[0].buf = (const unsigned char *) mbedtls_test_cas_pem;
+	trust_param.ca[0].len = mbedtls_test_cas_pem_len;
+#endif
+	if ((trust = mbedtls_trust_store_get(&trust_param)) == NULL) {
+		mbedtls_printf(" failed\n ! mbedtls_trust_store_get\n\n");
+		ret = -1;
+		goto exit;
+	}
+	mbedtls_printf(" ok\n");
+#else
 #if defined(MBEDTLS_CUSTOM_CA)
 	ret = mbedtls_x509_crt_parse(&cacert, (const unsigned char *) mbedtls_custom_cas_pem,
 	                               mbedtls_custom_cas_pem_len);
@@ -119,6 +146,7 @@ void mbedtls_client(void *arg)
 		goto exit;
 	}
 	mbedtls_printf(" ok (%d skipped)\n", ret);
+#endif /* MBEDTLS_TRUST_STORE */
 	/* Start the connection */
 	char *port = NULL;
 	if (flags & MBEDTLS_SSL_FLAG_SERVER_PORT)
@@ -157,7 +185,11 @@ void mbedtls_client(void *arg)
 #else
 	mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_OPTIONAL);
 #endif
+#if defined(MBEDTLS_TRUST_STORE)
+	mbedtls_trust_store_attach(trust, &conf);
+#else
 	mbedtls_ssl_conf_ca_chain(&conf, &cacert, NULL);
+#endif
 	mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &ctr_drbg);
 	mbedtls_ssl_conf_dbg(&conf, cli_debug, stdout);
 	if ((ret = mbedtls_ssl_setup(&ssl, &conf)) != 0) {
@@ -272,7 +304,11 @@ exit:
 	if (ret != 0)
 		mbedtls_printf("Last error was: %d\n\n", ret);
 	mbedtls_net_free(&server_fd);
+#if defined(MBEDTLS_TRUST_STORE)
+	mbedtls_trust_store_put(trust);
+#else
 	mbedtls_x509_crt_free(&cacert);
+#endif
 	mbedtls_ssl_free(&ssl);
 	mbedtls_ssl_config_free(&conf);
 	mbedtls_ctr_drbg_free(&ctr_drbg);
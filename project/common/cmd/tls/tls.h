@@ -37,8 +37,12 @@
 #include "mbedtls/configs/config-xr-mini-cli.h"
 #endif
 #if defined (MBEDTLS_CLIENT_SERVER)
+#if (__CONFIG_MBEDTLS_PROFILE == 1)
+#include "mbedtls/configs/config-xr-ecdhe.h"
+#else
 #include "mbedtls/configs/config-xr-mini-cliserv.h"
 #endif
+#endif
 #if defined (MBEDTLS_SERVER)
 #include "mbedtls/configs/config-xr-mini-serv.h"
 #endif
@@ -32,6 +32,8 @@
 #include "driver/chip/sdmmc/hal_sdhost.h"
 #include "common/framework/sys_ctrl/sys_ctrl.h"
 #include "fs/fatfs/ff.h"
+#include "fs/norfs/norfs.h"
+#include "image/image.h"
 #include "driver/chip/sdmmc/sdmmc.h"
 
 #define FS_DBG_ON	0
@@ -58,6 +60,9 @@ typedef struct
 {
 	OS_Mutex_t mutex;
 	FATFS *fs;
+#if PRJCONF_NORFS_EN
+	norfs_t *norfs;
+#endif
 } fs_ctrl_private;
 
 static fs_ctrl_private fs_ctrl;
@@ -65,6 +70,114 @@ static fs_ctrl_private fs_ctrl;
 #define FS_CTRL_LOCK()   OS_RecursiveMutexLock(&fs_ctrl.mutex, OS_WAIT_FOREVER)
 #define FS_CTRL_UNLOCK() OS_RecursiveMutexUnlock(&fs_ctrl.mutex)
 
+#if PRJCONF_NORFS_EN
+static int fs_ctrl_norfs_overlap(void)
+{
+	image_ota_param_t *iop;
+	uint32_t start, end;
+	int i;
+
+	iop = (image_ota_param_t *)image_get_ota_param();
+	for (i = 0; i < IMAGE_SEQ_NUM; ++i) {
+		start = iop->addr[i];
+		if (i == 0)
+			end = iop->addr[i] + IMAGE_AREA_SIZE(iop->img_max_size);
+		else
+#if (__CONFIG_OTA_POLICY == 0x00)
+			end = iop->addr[i] + IMAGE_AREA_SIZE(iop->img_max_size);
+#else
+			end = iop->addr[i] + IMAGE_AREA_SIZE(iop->img_xz_max_size);
+#endif
+		if (PRJCONF_NORFS_ADDR < end && PRJCONF_NORFS_ADDR + PRJCONF_NORFS_SIZE > start) {
+			FS_ERR("norfs: %#x - %#x has overlay image%d: %#x - %#x\n",
+			       PRJCONF_NORFS_ADDR, PRJCONF_NORFS_ADDR + PRJCONF_NORFS_SIZE,
+			       i, start, end);
+			return 1;
+		}
+	}
+
+	if (PRJCONF_NORFS_ADDR < iop->ota_addr + iop->ota_size &&
+	    PRJCONF_NORFS_ADDR + PRJCONF_NORFS_SIZE > iop->ota_addr) {
+		FS_ERR("norfs: %#x - %#x has overlay ota area: %#x - %#x\n",
+		       PRJCONF_NORFS_ADDR, PRJCONF_NORFS_ADDR + PRJCONF_NORFS_SIZE,
+		       iop->ota_addr, iop->ota_addr + iop->ota_size);
+		return 1;
+	}
+
+#if PRJCONF_SYSINFO_SAVE_TO_FLASH
+	if (PRJCONF_SYSINFO_FLASH == PRJCONF_NORFS_FLASH &&
+	    PRJCONF_NORFS_ADDR < PRJCONF_SYSINFO_ADDR + PRJCONF_SYSINFO_SIZE &&
+	    PRJCONF_NORFS_ADDR + PRJCONF_NORFS_SIZE > PRJCONF_SYSINFO_ADDR) {
+		FS_ERR("norfs: %#x - %#x has overlay sysinfo: %#x - %#x\n",
+		       PRJCONF_NORFS_ADDR, PRJCONF_NORFS_ADDR + PRJCONF_NORFS_SIZE,
+		       PRJCONF_SYSINFO_ADDR, PRJCONF_SYSINFO_ADDR + PRJCONF_SYSINFO_SIZE);
+		return 1;
+	}
+#endif
+	return 0;
+}
+
+static int fs_ctrl_mount_norfs(enum fs_mnt_dev_type dev_type, uint32_t dev_id)
+{
+	enum fs_mnt_status status = FS_MNT_STATUS_MOUNT_FAIL;
+
+	FS_CTRL_LOCK();
+
+	if (fs_ctrl.norfs != NULL) {
+		FS_CTRL_UNLOCK();
+		return 0; /* already mounted, nothing to do */
+	}
+
+	if (!fs_ctrl_norfs_overlap()) {
+		fs_ctrl.norfs = norfs_mount(PRJCONF_NORFS_FLASH, PRJCONF_NORFS_ADDR,
+		                            PRJCONF_NORFS_SIZE);
+		if (fs_ctrl.norfs == NULL) {
+			FS_ERR("norfs mount fail\n");
+		} else {
+			FS_INF("norfs mount success\n");
+			status = FS_MNT_STATUS_MOUNT_OK;
+		}
+	}
+
+	if (sys_event_send(CTRL_MSG_TYPE_FS,
+	                   FS_CTRL_MSG_FS_MNT,
+	                   FS_MNT_MSG_PARAM(dev_type, dev_id, status),
+	                   0) != 0) {
+		FS_ERR("send event fail\n");
+	}
+
+	FS_CTRL_UNLOCK();
+	return (status == FS_MNT_STATUS_MOUNT_OK ? 0 : -1);
+}
+
+static int fs_ctrl_unmount_norfs(enum fs_mnt_dev_type dev_type, uint32_t dev_id)
+{
+	int ret = 0;
+
+	FS_CTRL_LOCK();
+
+	if (fs_ctrl.norfs != NULL) {
+		ret = norfs_unmount(fs_ctrl.norfs);
+		if (ret != 0) {
+			FS_ERR("norfs unmount fail, err %d\n", ret);
+			ret = -1;
+		} else {
+			fs_ctrl.norfs = NULL;
+			if (sys_event_send(CTRL_MSG_TYPE_FS,
+			                   FS_CTRL_MSG_FS_MNT,
+			                   FS_MNT_MSG_PARAM(dev_type, dev_id,
+			                                    FS_MNT_STATUS_UNMOUNT),
+			                   0) != 0) {
+				FS_ERR("send event fail\n");
+			}
+		}
+	}
+
+	FS_CTRL_UNLOCK();
+	return ret;
+}
+#endif /* PRJCONF_NORFS_EN */
+
 /*
  * @brief Init the device and mount the file system
  * @param[in] dev_type Device type
@@ -76,6 +189,11 @@ int fs_ctrl_mount(enum fs_mnt_dev_type dev_type, uint32_t dev_id)
 	enum fs_mnt_status status = FS_MNT_STATUS_MOUNT_FAIL;
 	SDCard_InitTypeDef card_param = { 0 };
 
+#if PRJCONF_NORFS_EN
+	if (dev_type == FS_MNT_DEV_TYPE_FLASH)
+		return fs_ctrl_mount_norfs(dev_type, dev_id);
+#endif
+
 	FS_CTRL_LOCK();
 
 	if (fs_ctrl.fs != NULL) {
@@ -153,6 +271,11 @@ int fs_ctrl_unmount(enum fs_mnt_dev_type dev_type, uint32_t dev_id)
 {
 	int ret = 0;
 
+#if PRJCONF_NORFS_EN
+	if (dev_type == FS_MNT_DEV_TYPE_FLASH)
+		return fs_ctrl_unmount_norfs(dev_type, dev_id);
+#endif
+
 	FS_CTRL_LOCK();
 
 	if (fs_ctrl.fs == NULL) {
@@ -236,6 +359,19 @@ int fs_ctrl_init(void)
 	return 0;
 }
 
+/*
+ * @brief Get the flash file system mounted as FS_MNT_DEV_TYPE_FLASH
+ * @return norfs handle, NULL if not mounted
+ */
+norfs_t *fs_ctrl_get_norfs(void)
+{
+#if PRJCONF_NORFS_EN
+	return fs_ctrl.norfs;
+#else
+	return NULL;
+#endif
+}
+
 /*
  * @brief SD card detect callback fucntion
  * @param[in] present 1 for card inserted, 0 for card removed
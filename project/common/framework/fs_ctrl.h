@@ -31,6 +31,7 @@
 #define _FS_CTRL_H_
 
 #include "common/framework/sys_ctrl/sys_ctrl.h"
+#include "fs/norfs/norfs.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -53,6 +54,7 @@ enum fs_ctrl_msg_type {
 
 enum fs_mnt_dev_type {
 	FS_MNT_DEV_TYPE_SDCARD,
+	FS_MNT_DEV_TYPE_FLASH,	/* norfs on the area of PRJCONF_NORFS_xxx */
 };
 
 enum fs_mnt_status {
@@ -74,6 +76,7 @@ int fs_ctrl_mount(enum fs_mnt_dev_type dev_type, uint32_t dev_id);
 int fs_ctrl_unmount(enum fs_mnt_dev_type dev_type, uint32_t dev_id);
 
 void sdcard_detect_callback(uint32_t present);
+norfs_t *fs_ctrl_get_norfs(void);
 
 #if 1 /* Obsoleted, for compatibility only  */
 enum fs_mnt_mode {
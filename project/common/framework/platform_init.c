@@ -353,6 +353,51 @@ static void platform_wdg_start(void)
 }
 #endif /* PRJCONF_WDG_EN */
 
+#if PRJCONF_IMG_BOOT_CHECK
+#if PRJCONF_IMG_SCRUB_INTERVAL
+static OS_Thread_t g_img_scrub_thread;
+
+static void platform_image_scrub_task(void *arg)
+{
+	image_seq_t seq = image_get_running_seq();
+
+	while (1) {
+		OS_Sleep(PRJCONF_IMG_SCRUB_INTERVAL);
+		/* full check, the record is dropped if it fails */
+		if (image_check_sections(seq) == IMAGE_INVALID) {
+			FWK_ERR("image seq %u corrupted\n", seq);
+		}
+	}
+}
+#endif /* PRJCONF_IMG_SCRUB_INTERVAL */
+
+static void platform_image_check(void)
+{
+	image_seq_t seq = image_get_running_seq();
+
+	if (image_check_cache_init(PRJCONF_IMG_CHECK_CACHE_FLASH,
+	                           PRJCONF_IMG_CHECK_CACHE_ADDR,
+	                           PRJCONF_IMG_CHECK_CACHE_SIZE) != 0) {
+		FWK_WRN("image check cache init failed\n");
+	}
+
+	if (image_check_sections_cached(seq) == IMAGE_INVALID) {
+		FWK_ERR("image seq %u check failed\n", seq);
+	}
+
+#if PRJCONF_IMG_SCRUB_INTERVAL
+	if (OS_ThreadCreate(&g_img_scrub_thread,
+	                    "img_scrub",
+	                    platform_image_scrub_task,
+	                    NULL,
+	                    OS_PRIORITY_LOW,
+	                    (1 * 1024)) != OS_OK) {
+		FWK_WRN("image scrub thread create failed\n");
+	}
+#endif
+}
+#endif /* PRJCONF_IMG_BOOT_CHECK */
+
 #if (PRJCONF_CE_EN && PRJCONF_PRNG_INIT_SEED)
 #define RAND_SYS_TICK() ((SysTick->VAL & 0xffffff) | (OS_GetTicks() << 24))
 
@@ -476,6 +521,7 @@ __weak void platform_cedarx_init(void)
 	SoundStreamListInit();
 	SoundStreamRegisterCard();
 	SoundStreamRegisterReverb();
+	SoundStreamRegisterTone();
 
 	/* for media recorder */
 	CedarxWriterListInit();
@@ -625,6 +671,10 @@ __weak void platform_init_level1(void)
 
 	sysinfo_init();
 
+#if PRJCONF_IMG_BOOT_CHECK
+	platform_image_check();
+#endif
+
 #if PRJCONF_CONSOLE_EN
 	console_param_t cparam;
 	cparam.uart_id = BOARD_MAIN_UART_ID;
@@ -678,10 +728,15 @@ __weak void platform_init_level2(void)
 	board_spi_init(BOARD_SPI_PORT);
 #endif
 
-#if PRJCONF_MMC_EN
+#if (PRJCONF_MMC_EN || PRJCONF_NORFS_EN)
 	fs_ctrl_init();
+#endif
+#if PRJCONF_MMC_EN
  	board_sdcard_init(sdcard_detect_callback);
 #endif
+#if PRJCONF_NORFS_EN
+	fs_ctrl_mount(FS_MNT_DEV_TYPE_FLASH, 0);
+#endif
 
 #if PRJCONF_AUDIO_SNDCARD_EN
 	board_soundcard_init();
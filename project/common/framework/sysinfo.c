@@ -27,10 +27,12 @@
  *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <stddef.h>
 #include <string.h>
 #include <stdlib.h>
 
 #include "image/fdcm.h"
+#include "image/kvs.h"
 #include "image/image.h"
 #if PRJCONF_NET_EN
 #include "lwip/inet.h"
@@ -43,9 +45,137 @@
 
 static struct sysinfo g_sysinfo;
 #if PRJCONF_SYSINFO_SAVE_TO_FLASH
+#if PRJCONF_SYSINFO_USE_KVS
+static kvs_handle_t *g_kvs_hdl;
+#define SYSINFO_FLASH_HDL	g_kvs_hdl
+#else
 static fdcm_handle_t *g_fdcm_hdl;
+#define SYSINFO_FLASH_HDL	g_fdcm_hdl
+#endif
+#endif
+
+#if (PRJCONF_SYSINFO_SAVE_TO_FLASH && PRJCONF_SYSINFO_USE_KVS)
+#define SYSINFO_KVS_KEY_MAX	(16)
+
+struct sysinfo_kvs_item {
+	const char *key;
+	uint16_t offset;
+	uint16_t size;
+};
+
+#define SYSINFO_KVS_ITEM(key, member) \
+	{ key, offsetof(struct sysinfo, member), sizeof(((struct sysinfo *)0)->member) }
+
+/* one key per independent field, "version" is saved last and marks a complete sysinfo */
+static const struct sysinfo_kvs_item g_sysinfo_kvs_item[] = {
+#if PRJCONF_NET_EN
+	SYSINFO_KVS_ITEM("mac_addr",  mac_addr),
+	SYSINFO_KVS_ITEM("wlan_mode", wlan_mode),
+#endif
+	SYSINFO_KVS_ITEM("version",   version),
+};
+
+#define SYSINFO_KVS_ITEM_NUM	(sizeof(g_sysinfo_kvs_item) / sizeof(g_sysinfo_kvs_item[0]))
+
+#if PRJCONF_NET_EN
+/*
+ * The fields of an interface only make sense together (the static address
+ * belongs to the network), so they share a record: kvs writes a record
+ * atomically, a power cut while saving leaves the old or the new one.
+ */
+struct sysinfo_kvs_sta {
+	uint8_t use_dhcp;
+	struct sysinfo_wlan_sta_param wlan;
+	struct sysinfo_netif_param netif;
+};
+
+struct sysinfo_kvs_ap {
+	struct sysinfo_wlan_ap_param wlan;
+	struct sysinfo_netif_param netif;
+};
 #endif
 
+static int sysinfo_kvs_set(const char *key, const void *data, uint16_t size)
+{
+	if (kvs_set(g_kvs_hdl, key, data, size) != 0) {
+		SYSINFO_ERR("kvs write %s failed\n", key);
+		return -1;
+	}
+	return 0;
+}
+
+static int sysinfo_kvs_get(const char *key, void *data, uint16_t size)
+{
+	if (kvs_get(g_kvs_hdl, key, data, size) != size) {
+		SYSINFO_WRN("kvs read %s failed\n", key);
+		return -1;
+	}
+	return 0;
+}
+
+/* kvs skips the records whose value is unchanged, so only those are written */
+static int sysinfo_kvs_save(const struct sysinfo *info)
+{
+	int i;
+	const struct sysinfo_kvs_item *item;
+#if PRJCONF_NET_EN
+	struct sysinfo_kvs_sta sta;
+	struct sysinfo_kvs_ap ap;
+
+	memset(&sta, 0, sizeof(sta));	/* the padding is compared too */
+	sta.use_dhcp = info->sta_use_dhcp;
+	sta.wlan = info->wlan_sta_param;
+	sta.netif = info->netif_sta_param;
+	memset(&ap, 0, sizeof(ap));
+	ap.wlan = info->wlan_ap_param;
+	ap.netif = info->netif_ap_param;
+	if (sysinfo_kvs_set("sta", &sta, sizeof(sta)) != 0 ||
+	    sysinfo_kvs_set("ap", &ap, sizeof(ap)) != 0) {
+		return -1;
+	}
+#endif
+	for (i = 0; i < SYSINFO_KVS_ITEM_NUM; ++i) {
+		item = &g_sysinfo_kvs_item[i];
+		if (sysinfo_kvs_set(item->key, (const uint8_t *)info + item->offset,
+		                    item->size) != 0) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static int sysinfo_kvs_load(struct sysinfo *info)
+{
+	int i;
+	const struct sysinfo_kvs_item *item;
+#if PRJCONF_NET_EN
+	struct sysinfo_kvs_sta sta;
+	struct sysinfo_kvs_ap ap;
+#endif
+
+	memset(info, 0, SYSINFO_SIZE);
+	for (i = 0; i < SYSINFO_KVS_ITEM_NUM; ++i) {
+		item = &g_sysinfo_kvs_item[i];
+		if (sysinfo_kvs_get(item->key, (uint8_t *)info + item->offset,
+		                    item->size) != 0) {
+			return -1;
+		}
+	}
+#if PRJCONF_NET_EN
+	if (sysinfo_kvs_get("sta", &sta, sizeof(sta)) != 0 ||
+	    sysinfo_kvs_get("ap", &ap, sizeof(ap)) != 0) {
+		return -1;
+	}
+	info->sta_use_dhcp = sta.use_dhcp;
+	info->wlan_sta_param = sta.wlan;
+	info->netif_sta_param = sta.netif;
+	info->wlan_ap_param = ap.wlan;
+	info->netif_ap_param = ap.netif;
+#endif
+	return 0;
+}
+#endif /* (PRJCONF_SYSINFO_SAVE_TO_FLASH && PRJCONF_SYSINFO_USE_KVS) */
+
 #if PRJCONF_NET_EN
 
 static uint8_t m_sysinfo_mac_addr[] = { 0x00, 0x80, 0xE1, 0x29, 0xE8, 0xD1 };
@@ -102,7 +232,15 @@ static void sysinfo_init_mac_addr(void)
 				return;
 		}
 		goto random_mac_addr;
-#if PRJCONF_SYSINFO_SAVE_TO_FLASH
+#if (PRJCONF_SYSINFO_SAVE_TO_FLASH && PRJCONF_SYSINFO_USE_KVS)
+	case SYSINFO_MAC_ADDR_FLASH:
+		if (kvs_get(g_kvs_hdl, "mac_addr", g_sysinfo.mac_addr,
+		            SYSINFO_MAC_ADDR_LEN) != SYSINFO_MAC_ADDR_LEN) {
+			SYSINFO_WRN("read mac addr from flash fail\n");
+			goto random_mac_addr;
+		}
+		return;
+#elif PRJCONF_SYSINFO_SAVE_TO_FLASH
 	case SYSINFO_MAC_ADDR_FLASH: {
 		struct sysinfo *info = malloc(SYSINFO_SIZE);
 		if (info == NULL) {
@@ -185,11 +323,20 @@ int sysinfo_init(void)
 	}
 
 #endif
+#if PRJCONF_SYSINFO_USE_KVS
+	g_kvs_hdl = kvs_open(PRJCONF_SYSINFO_FLASH, PRJCONF_SYSINFO_ADDR,
+	                     PRJCONF_SYSINFO_SIZE, SYSINFO_KVS_KEY_MAX);
+	if (g_kvs_hdl == NULL) {
+		SYSINFO_ERR("kvs open failed, hdl %p\n", g_kvs_hdl);
+		return -1;
+	}
+#else
 	g_fdcm_hdl = fdcm_open(PRJCONF_SYSINFO_FLASH, PRJCONF_SYSINFO_ADDR, PRJCONF_SYSINFO_SIZE);
 	if (g_fdcm_hdl == NULL) {
 		SYSINFO_ERR("fdcm open failed, hdl %p\n", g_fdcm_hdl);
 		return -1;
 	}
+#endif
 #endif /* PRJCONF_SYSINFO_SAVE_TO_FLASH */
 	sysinfo_init_value();
 	return 0;
@@ -202,8 +349,12 @@ int sysinfo_init(void)
 void sysinfo_deinit(void)
 {
 #if PRJCONF_SYSINFO_SAVE_TO_FLASH
+#if PRJCONF_SYSINFO_USE_KVS
+	kvs_close(g_kvs_hdl);
+#else
 	fdcm_close(g_fdcm_hdl);
 #endif
+#endif
 }
 
 /**
@@ -213,8 +364,8 @@ void sysinfo_deinit(void)
 int sysinfo_default(void)
 {
 #if PRJCONF_SYSINFO_SAVE_TO_FLASH
-	if (g_fdcm_hdl == NULL) {
-		SYSINFO_ERR("uninitialized, hdl %p\n", g_fdcm_hdl);
+	if (SYSINFO_FLASH_HDL == NULL) {
+		SYSINFO_ERR("uninitialized, hdl %p\n", SYSINFO_FLASH_HDL);
 		return -1;
 	}
 #endif
@@ -259,15 +410,21 @@ int sysinfo_default(void)
  */
 int sysinfo_save(void)
 {
-	if (g_fdcm_hdl == NULL) {
-		SYSINFO_ERR("uninitialized, hdl %p\n", g_fdcm_hdl);
+	if (SYSINFO_FLASH_HDL == NULL) {
+		SYSINFO_ERR("uninitialized, hdl %p\n", SYSINFO_FLASH_HDL);
 		return -1;
 	}
 
+#if PRJCONF_SYSINFO_USE_KVS
+	if (sysinfo_kvs_save(&g_sysinfo) != 0) {
+		return -1;
+	}
+#else
 	if (fdcm_write(g_fdcm_hdl, &g_sysinfo, SYSINFO_SIZE) != SYSINFO_SIZE) {
 		SYSINFO_ERR("fdcm write failed\n");
 		return -1;
 	}
+#endif
 
 	SYSINFO_DBG("save sysinfo to flash\n");
 
@@ -280,15 +437,29 @@ int sysinfo_save(void)
  */
 int sysinfo_load(void)
 {
-	if (g_fdcm_hdl == NULL) {
-		SYSINFO_ERR("uninitialized, hdl %p\n", g_fdcm_hdl);
+	if (SYSINFO_FLASH_HDL == NULL) {
+		SYSINFO_ERR("uninitialized, hdl %p\n", SYSINFO_FLASH_HDL);
 		return -1;
 	}
 
+#if PRJCONF_SYSINFO_USE_KVS
+	struct sysinfo *info = malloc(SYSINFO_SIZE);
+	if (info == NULL) {
+		SYSINFO_ERR("malloc fail\n");
+		return -1;
+	}
+	if (sysinfo_kvs_load(info) != 0) {
+		free(info);
+		return -1;
+	}
+	memcpy(&g_sysinfo, info, SYSINFO_SIZE);
+	free(info);
+#else
 	if (fdcm_read(g_fdcm_hdl, &g_sysinfo, SYSINFO_SIZE) != SYSINFO_SIZE) {
 		SYSINFO_WRN("fdcm read failed\n");
 		return -1;
 	}
+#endif
 
 	SYSINFO_DBG("load sysinfo from flash\n");
 
@@ -303,8 +474,8 @@ int sysinfo_load(void)
 struct sysinfo *sysinfo_get(void)
 {
 #if PRJCONF_SYSINFO_SAVE_TO_FLASH
-	if (g_fdcm_hdl == NULL) {
-		SYSINFO_ERR("uninitialized, hdl %p\n", g_fdcm_hdl);
+	if (SYSINFO_FLASH_HDL == NULL) {
+		SYSINFO_ERR("uninitialized, hdl %p\n", SYSINFO_FLASH_HDL);
 		return NULL;
 	}
 #endif
@@ -35,8 +35,11 @@
 
 #include "kernel/os/os_thread.h"
 #include "kernel/os/os_errno.h"
+#include "kernel/os/os_semaphore.h"
 #include "lwip/sockets.h"
 #include "lwip/netif.h"
+#include "lwip/api.h"
+#include "lwip/tcp.h"
 
 #include "iperf.h"
 #include "iperf_debug.h"
@@ -50,6 +53,7 @@
 #define IPERF_BUF_SIZE 				(1500)
 #define IPERF_UDP_SEND_DATA_LEN		(1470)	// UDP: 1470 + 8  + 20 = 1498
 #define IPERF_TCP_SEND_DATA_LEN		(1460)	// TCP: 1460 + 20 + 20 = 1500
+#define IPERF_TCP_ZC_BUF_SIZE		(4 * IPERF_TCP_SEND_DATA_LEN) // zero-copy payload
 
 #define IPERF_THREAD_STACK_SIZE		(2 * 1024)
 
@@ -62,13 +66,86 @@ iperf_arg *g_iperf_arg_handle[IPERF_ARG_HANDLE_MAX] = {NULL};
 
 #define IPERF_SELECT_TIMEOUT		100
 
-static void iperf_speed_log(iperf_arg *arg, uint64_t bytes, uint32_t time,
-                            int8_t is_end)
+struct iperf_stream {
+	int		sock;
+	struct netconn	*conn;			/* zero-copy TCP send */
+	struct sockaddr_in peer;		/* UDP receive: sender of the stream */
+	uint64_t	total;			/* bytes since the test started */
+	uint32_t	bytes;			/* bytes in the current interval */
+	uint8_t		done;
+	int32_t		next_id;		/* UDP: next datagram id to send/expect */
+	uint32_t	packets;		/* UDP receive statistics */
+	uint32_t	lost;
+	uint32_t	out_of_order;
+	uint32_t	interval_packets;
+	uint32_t	interval_lost;
+	int32_t		transit;		/* last transit time in us */
+	int32_t		jitter;			/* RFC 1889 jitter in us, scaled by 16 */
+	uint32_t	jitter_hist[IPERF_JITTER_HIST_NUM];
+	uint32_t	loss_hist[IPERF_LOSS_HIST_NUM];
+};
+
+struct iperf_ctx {
+	iperf_arg	*arg;
+	uint8_t		*buf;
+	int		num;			/* streams in use */
+	uint8_t		started;
+	uint64_t	total;			/* sum of all streams */
+	uint32_t	run_beg_tm;
+	uint32_t	run_end_tm;
+	uint32_t	beg_tm;
+	uint32_t	end_tm;
+	struct iperf_stream stream[IPERF_STREAM_MAX];
+};
+
+/* upper bounds of the histogram bins, the last bin is open */
+static const uint16_t iperf_jitter_hist_bound[IPERF_JITTER_HIST_NUM - 1] = {
+	1, 2, 5, 10, 20	/* ms */
+};
+static const uint16_t iperf_loss_hist_bound[IPERF_LOSS_HIST_NUM - 1] = {
+	2, 4, 8, 16	/* datagrams lost in a row */
+};
+
+static const char *iperf_mode_str[IPERF_MODE_NUM] = {
+	"udp-send",
+	"udp-recv",
+	"tcp-send",
+	"tcp-recv",
+};
+
+static int iperf_hist_bin(const uint16_t *bound, int num, uint32_t val)
+{
+	int i;
+
+	for (i = 0; i < num - 1 && val >= bound[i]; ++i)
+		;
+	return i;
+}
+
+static void iperf_u64_str(char *str, uint32_t size, uint64_t val)
+{
+	char tmp[21];
+	int i = sizeof(tmp) - 1;
+
+	tmp[i] = '\0';
+	do {
+		tmp[--i] = '0' + val % 10;
+		val /= 10;
+	} while (val && i > 0);
+	snprintf(str, size, "%s", &tmp[i]);
+}
+
+/* stream < 0 logs the sum of all streams */
+static void iperf_speed_log(iperf_arg *arg, int stream, uint64_t bytes,
+                            uint32_t time, int8_t is_end)
 {
 	uint64_t speed;
 	uint32_t integer_part, decimal_part;
 	char str[16];
 
+	if (time == 0)
+		time = 1;
+
 	if (arg->flags & IPERF_FLAG_FORMAT) {
 		/* KBytes/sec */
 		speed = bytes * IPERF_TIME_PER_SEC * 100 / 1024 / time;
@@ -88,10 +165,305 @@ static void iperf_speed_log(iperf_arg *arg, uint64_t bytes, uint32_t time,
 		snprintf(str, sizeof(str), "%u.%02u", integer_part, decimal_part);
 	}
 
-	IPERF_LOG(1, "[%d] %s%s %s\n", arg->handle, is_end ?  "TEST END: " : "",
-	          str, (arg->flags & IPERF_FLAG_FORMAT) ? "KB/s" : "Mb/s");
+	if (stream < 0)
+		IPERF_LOG(1, "[%d] %s%s %s\n", arg->handle, is_end ?  "TEST END: " : "",
+		          str, (arg->flags & IPERF_FLAG_FORMAT) ? "KB/s" : "Mb/s");
+	else
+		IPERF_LOG(1, "[%d.%d] %s%s %s\n", arg->handle, stream,
+		          is_end ?  "TEST END: " : "",
+		          str, (arg->flags & IPERF_FLAG_FORMAT) ? "KB/s" : "Mb/s");
+}
+
+static void iperf_udp_log(iperf_arg *arg, int stream, struct iperf_stream *st,
+                          int8_t is_end)
+{
+	uint32_t jitter = st->jitter >> 4;
+	uint32_t lost = is_end ? st->lost : st->interval_lost;
+	uint32_t total = lost + (is_end ? st->packets : st->interval_packets);
+
+	IPERF_LOG(1, "[%d.%d] jitter %u.%03u ms, lost %u/%u, out-of-order %u\n",
+	          arg->handle, stream, jitter / 1000, jitter % 1000, lost, total,
+	          st->out_of_order);
+	if (!is_end)
+		return;
+	IPERF_LOG(1, "[%d.%d] jitter hist <1:%u <2:%u <5:%u <10:%u <20:%u >=20ms:%u\n",
+	          arg->handle, stream, st->jitter_hist[0], st->jitter_hist[1],
+	          st->jitter_hist[2], st->jitter_hist[3], st->jitter_hist[4],
+	          st->jitter_hist[5]);
+	IPERF_LOG(1, "[%d.%d] loss bursts 1:%u 2-3:%u 4-7:%u 8-15:%u >=16:%u\n",
+	          arg->handle, stream, st->loss_hist[0], st->loss_hist[1],
+	          st->loss_hist[2], st->loss_hist[3], st->loss_hist[4]);
+}
+
+#if IPERF_OPT_JSON
+static void iperf_json_log(struct iperf_ctx *ctx, uint32_t time)
+{
+	iperf_arg *idata = ctx->arg;
+	struct iperf_stream *st;
+	char bytes[24], bps[24];
+	int i, j;
+
+	if (time == 0)
+		time = 1;
+
+	IPERF_LOG(1, "{\"handle\":%d,\"mode\":\"%s\",\"time_ms\":%u,\"streams\":[",
+	          idata->handle, iperf_mode_str[idata->mode], time);
+	for (i = 0; i < ctx->num; ++i) {
+		st = &ctx->stream[i];
+		iperf_u64_str(bytes, sizeof(bytes), st->total);
+		iperf_u64_str(bps, sizeof(bps), st->total * 8 * IPERF_TIME_PER_SEC / time);
+		IPERF_LOG(1, "%s{\"id\":%d,\"bytes\":%s,\"bits_per_second\":%s",
+		          i ? "," : "", i, bytes, bps);
+		if (idata->mode == IPERF_MODE_UDP_RECV) {
+			IPERF_LOG(1, ",\"packets\":%u,\"lost\":%u,\"out_of_order\":%u,"
+			          "\"jitter_us\":%u,\"jitter_hist\":[",
+			          st->packets, st->lost, st->out_of_order,
+			          (uint32_t)(st->jitter >> 4));
+			for (j = 0; j < IPERF_JITTER_HIST_NUM; ++j)
+				IPERF_LOG(1, "%s%u", j ? "," : "", st->jitter_hist[j]);
+			IPERF_LOG(1, "],\"loss_hist\":[");
+			for (j = 0; j < IPERF_LOSS_HIST_NUM; ++j)
+				IPERF_LOG(1, "%s%u", j ? "," : "", st->loss_hist[j]);
+			IPERF_LOG(1, "]");
+		}
+		IPERF_LOG(1, "}");
+	}
+	iperf_u64_str(bytes, sizeof(bytes), ctx->total);
+	iperf_u64_str(bps, sizeof(bps), ctx->total * 8 * IPERF_TIME_PER_SEC / time);
+	IPERF_LOG(1, "],\"sum\":{\"bytes\":%s,\"bits_per_second\":%s}}\n", bytes, bps);
+}
+#endif
+
+static struct iperf_ctx *iperf_ctx_new(iperf_arg *idata)
+{
+	struct iperf_ctx *ctx;
+	int i;
+
+	ctx = malloc(sizeof(struct iperf_ctx));
+	if (ctx == NULL) {
+		IPERF_ERR("malloc() failed!\n");
+		return NULL;
+	}
+	memset(ctx, 0, sizeof(struct iperf_ctx));
+	ctx->arg = idata;
+	for (i = 0; i < IPERF_STREAM_MAX; ++i)
+		ctx->stream[i].sock = -1;
+	return ctx;
+}
+
+static void iperf_ctx_free(struct iperf_ctx *ctx)
+{
+	struct iperf_stream *st;
+	int i;
+
+	if (ctx == NULL)
+		return;
+	for (i = 0; i < IPERF_STREAM_MAX; ++i) {
+		st = &ctx->stream[i];
+		if (st->sock >= 0)
+			closesocket(st->sock);
+		if (st->conn) {
+			netconn_set_nonblocking(st->conn, 0);
+			netconn_delete(st->conn);
+		}
+	}
+	if (ctx->buf)
+		free(ctx->buf);
+	free(ctx);
+}
+
+static int iperf_ctx_streams(struct iperf_ctx *ctx)
+{
+	return ctx->arg->streams ? ctx->arg->streams : 1;
+}
+
+static int iperf_ctx_done(struct iperf_ctx *ctx)
+{
+	int i;
+
+	if (ctx->num == 0)
+		return 0;
+	for (i = 0; i < ctx->num; ++i) {
+		if (!ctx->stream[i].done)
+			return 0;
+	}
+	return 1;
+}
+
+static void iperf_clock_start(struct iperf_ctx *ctx)
+{
+	ctx->started = 1;
+	ctx->run_beg_tm = IPERF_TIME();
+	ctx->run_end_tm = ctx->run_beg_tm + IPERF_SEC_2_INTERVAL(ctx->arg->run_time);
+	ctx->beg_tm = ctx->run_beg_tm;
+	ctx->end_tm = ctx->beg_tm + IPERF_SEC_2_INTERVAL(ctx->arg->interval);
+}
+
+static void iperf_account(struct iperf_ctx *ctx, struct iperf_stream *st,
+                          uint32_t data_len)
+{
+	iperf_arg *idata = ctx->arg;
+
+	st->bytes += data_len;
+	st->total += data_len;
+	ctx->total += data_len;
+#if IPERF_OPT_NUM
+	if (!idata->mode_time) {
+		if (idata->amount > data_len) {
+			idata->amount -= data_len;
+		} else {
+			idata->amount = 0;
+			idata->flags |= IPERF_FLAG_STOP;
+		}
+	}
+#endif
+}
+
+static void iperf_interval_log(struct iperf_ctx *ctx, uint32_t time)
+{
+	struct iperf_stream *st;
+	uint64_t bytes = 0;
+	int i;
+
+	for (i = 0; i < ctx->num; ++i) {
+		st = &ctx->stream[i];
+		bytes += st->bytes;
+		if (ctx->num > 1)
+			iperf_speed_log(ctx->arg, i, st->bytes, time, 0);
+		if (ctx->arg->mode == IPERF_MODE_UDP_RECV)
+			iperf_udp_log(ctx->arg, i, st, 0);
+		st->bytes = 0;
+		st->interval_packets = 0;
+		st->interval_lost = 0;
+	}
+	iperf_speed_log(ctx->arg, -1, bytes, time, 0);
+}
+
+/* interval reports and the run time limit, call after every I/O step */
+static void iperf_tick(struct iperf_ctx *ctx)
+{
+	iperf_arg *idata = ctx->arg;
+	uint32_t cur_tm;
+
+	if (!ctx->started)
+		return;
+
+	cur_tm = IPERF_TIME();
+	if (cur_tm > ctx->end_tm) {
+		iperf_interval_log(ctx, cur_tm - ctx->beg_tm);
+		ctx->beg_tm = cur_tm;
+		ctx->end_tm = ctx->beg_tm + IPERF_SEC_2_INTERVAL(idata->interval);
+	}
+#if IPERF_OPT_NUM
+	if (!idata->mode_time)
+		return;
+#endif
+	if (idata->run_time && cur_tm > ctx->run_end_tm)
+		idata->flags |= IPERF_FLAG_STOP;
 }
 
+static void iperf_end_log(struct iperf_ctx *ctx)
+{
+	uint32_t time;
+	int i;
+
+	if (!ctx->started)
+		return;
+
+	time = IPERF_TIME() - ctx->run_beg_tm;
+	for (i = 0; i < ctx->num; ++i) {
+		if (ctx->num > 1)
+			iperf_speed_log(ctx->arg, i, ctx->stream[i].total, time, 1);
+		if (ctx->arg->mode == IPERF_MODE_UDP_RECV)
+			iperf_udp_log(ctx->arg, i, &ctx->stream[i], 1);
+	}
+	iperf_speed_log(ctx->arg, -1, ctx->total, time, 1);
+#if IPERF_OPT_JSON
+	if (ctx->arg->flags & IPERF_FLAG_JSON)
+		iperf_json_log(ctx, time);
+#endif
+}
+
+static void iperf_udp_hdr_set(struct UDP_datagram *dg, int32_t id)
+{
+	uint32_t cur_tm = IPERF_TIME();
+
+	dg->id = htonl(id);
+	dg->tv_sec = htonl(cur_tm / IPERF_TIME_PER_SEC);
+	dg->tv_usec = htonl(cur_tm % IPERF_TIME_PER_SEC * 1000);
+}
+
+/* datagram sequence and RFC 1889 jitter bookkeeping of one UDP stream */
+static void iperf_udp_account(struct iperf_stream *st, struct UDP_datagram *dg)
+{
+	int32_t id = ntohl(dg->id);
+	int32_t transit, delta;
+	uint32_t gap;
+
+	st->packets++;
+	st->interval_packets++;
+	if (id >= st->next_id) {
+		gap = id - st->next_id;
+		if (gap) {
+			st->lost += gap;
+			st->interval_lost += gap;
+			st->loss_hist[iperf_hist_bin(iperf_loss_hist_bound,
+			                             IPERF_LOSS_HIST_NUM, gap)]++;
+		}
+		st->next_id = id + 1;
+	} else {
+		/* counted as lost when the gap was seen */
+		st->out_of_order++;
+		if (st->lost)
+			st->lost--;
+		if (st->interval_lost)
+			st->interval_lost--;
+	}
+
+	transit = (int32_t)(IPERF_TIME() * 1000 -
+	                    (ntohl(dg->tv_sec) * 1000000 + ntohl(dg->tv_usec)));
+	if (st->packets > 1) {
+		delta = transit - st->transit;
+		if (delta < 0)
+			delta = -delta;
+		st->jitter += delta - ((st->jitter + 8) >> 4);
+		st->jitter_hist[iperf_hist_bin(iperf_jitter_hist_bound,
+		                               IPERF_JITTER_HIST_NUM, delta / 1000)]++;
+	}
+	st->transit = transit;
+}
+
+static struct iperf_stream *iperf_udp_stream(struct iperf_ctx *ctx,
+                                             struct sockaddr_in *from)
+{
+	struct iperf_stream *st;
+	int i;
+
+	for (i = 0; i < ctx->num; ++i) {
+		st = &ctx->stream[i];
+		if (st->peer.sin_addr.s_addr == from->sin_addr.s_addr &&
+		    st->peer.sin_port == from->sin_port)
+			return st;
+	}
+	if (ctx->num >= IPERF_STREAM_MAX)
+		return NULL;
+
+	st = &ctx->stream[ctx->num++];
+	memcpy(&st->peer, from, sizeof(struct sockaddr_in));
+	IPERF_DBG("iperf: client from %s:%d\n", inet_ntoa(from->sin_addr),
+	          ntohs(from->sin_port));
+	return st;
+}
+
+static void iperf_task_exit(iperf_arg *idata, const char *func)
+{
+	OS_Thread_t thread = idata->iperf_thread;
+	int handle = idata->handle;
+
+	iperf_handle_free(handle);
+	IPERF_DBG("%s() [%d] exit!\n", func, handle);
+	iperf_thread_exit(&thread);
+}
 
 static __inline void iperf_udp_seq_set(uint32_t *p, uint32_t seq)
 {
@@ -177,45 +549,6 @@ static uint8_t *iperf_buf_new(uint32_t size)
 	return data_buf;
 }
 
-#define iperf_loop_init() 													\
-	data_total_cnt = 0;														\
-	data_cnt = 0;															\
-	beg_tm = IPERF_TIME();													\
-	end_tm = beg_tm + IPERF_SEC_2_INTERVAL(((iperf_arg *)arg)->interval);	\
-	run_beg_tm = beg_tm;													\
-	run_end_tm = run_beg_tm + run_time;
-
-#define iperf_calc_speed()													\
-	data_total_cnt += data_len; 											\
-	cur_tm = IPERF_TIME();													\
-	if (cur_tm > end_tm) {													\
-        iperf_speed_log(arg, data_cnt, cur_tm - beg_tm, 0);                 \
-		data_cnt = 0;														\
-		beg_tm = IPERF_TIME();												\
-		end_tm = beg_tm + IPERF_SEC_2_INTERVAL(((iperf_arg *)arg)->interval);\
-	}																		\
-	if (idata->mode_time) {													\
-		if (run_time && cur_tm > run_end_tm) {								\
-			idata->flags |= IPERF_FLAG_STOP;								\
-		}																	\
-	} else {																\
-		if (idata->amount > data_len) {										\
-			idata->amount -= data_len;										\
-		} else {															\
-			idata->amount = 0;												\
-			idata->flags |= IPERF_FLAG_STOP;								\
-		}																	\
-	}																		\
-	if (idata->flags & IPERF_FLAG_STOP) {									\
-        iperf_speed_log(arg, data_total_cnt, cur_tm - run_beg_tm, 1);       \
-		break;																\
-	}
-
-#define iperf_calc_speed_fin()                                              \
-    cur_tm = IPERF_TIME();                                                  \
-    data_total_cnt += data_len;                                             \
-    iperf_speed_log(arg, data_total_cnt, cur_tm - run_beg_tm, 1);           \
-
 /* -------------------------------------------------------------------
  * Send a datagram on the socket. The datagram's contents should signify
  * a FIN to the application. Keep re-transmitting until an
@@ -312,27 +645,38 @@ void write_UDP_AckFIN(int local_sock,
 	IPERF_WARN("ack of last datagram failed after %d tries.\n", count);
 }
 
+
 void iperf_udp_send_task(void *arg)
 {
-	int local_sock = -1;
 	struct sockaddr_in remote_addr;
 	iperf_arg *idata = (iperf_arg *)arg;
-	uint32_t run_time = IPERF_SEC_2_INTERVAL(idata->run_time);
 	uint32_t port = idata->port;
-	uint8_t *data_buf = NULL;
+	struct iperf_ctx *ctx;
+	struct iperf_stream *st;
+	struct UDP_datagram *mBuf_UDP;
 	int32_t data_len;
-	int packetID = 0;
-	struct UDP_datagram* mBuf_UDP;
+	int i;
+#if IPERF_OPT_BANDWIDTH
+	uint32_t send_tm, run_tm; /* relative to run_beg_tm */
+#endif
 
-	local_sock = iperf_sock_create(SOCK_DGRAM, 0, 1);
-	if (local_sock < 0) {
-		IPERF_ERR("socket() return %d\n", local_sock);
+	ctx = iperf_ctx_new(idata);
+	if (ctx == NULL)
 		goto socket_error;
+
+	for (i = 0; i < iperf_ctx_streams(ctx); ++i) {
+		st = &ctx->stream[i];
+		st->sock = iperf_sock_create(SOCK_DGRAM, 0, 1);
+		if (st->sock < 0) {
+			IPERF_ERR("socket() return %d\n", st->sock);
+			goto socket_error;
+		}
+		iperf_set_sock_opt(st->sock, idata);
+		ctx->num++;
 	}
-	iperf_set_sock_opt(local_sock, idata);
 
-	data_buf = iperf_buf_new(IPERF_BUF_SIZE);
-	if (data_buf == NULL) {
+	ctx->buf = iperf_buf_new(IPERF_BUF_SIZE);
+	if (ctx->buf == NULL) {
 		IPERF_ERR("malloc() failed!\n");
 		goto socket_error;
 	}
@@ -342,70 +686,65 @@ void iperf_udp_send_task(void *arg)
 	remote_addr.sin_port = htons(port);
 	remote_addr.sin_family = AF_INET;
 
-	IPERF_DBG("iperf: UDP send to %s:%d\n", idata->remote_ip, port);
-
-	uint32_t run_end_tm = 0, run_beg_tm = 0, beg_tm = 0, end_tm = 0, cur_tm = 0;
-	uint64_t data_total_cnt = 0;
-	uint32_t data_cnt = 0;
-#if IPERF_OPT_BANDWIDTH
-	uint32_t send_tm, run_tm; /* relative to run_beg_tm */
-#endif
+	IPERF_DBG("iperf: UDP send to %s:%d, %d stream(s)\n", idata->remote_ip,
+	          port, ctx->num);
 
-	mBuf_UDP = (struct UDP_datagram*) data_buf;
-	mBuf_UDP->id = htonl(packetID);
-	iperf_loop_init();
+	mBuf_UDP = (struct UDP_datagram *)ctx->buf;
+	iperf_clock_start(ctx);
 
 	while (!(idata->flags & IPERF_FLAG_STOP)) {
+		for (i = 0; i < ctx->num && !(idata->flags & IPERF_FLAG_STOP); ++i) {
+			st = &ctx->stream[i];
 #if IPERF_OPT_BANDWIDTH
-		if (idata->bandwidth != 0) {
-			run_tm = IPERF_TIME() - run_beg_tm;
-			send_tm = data_total_cnt * 8 * 1000 / idata->bandwidth;
-			if (send_tm > run_tm) {
-				iperf_msleep(send_tm - run_tm);
+			/* -b is per stream, as with iperf2 */
+			if (idata->bandwidth != 0) {
+				run_tm = IPERF_TIME() - ctx->run_beg_tm;
+				send_tm = ctx->total * 8 * 1000 /
+				          ((uint64_t)idata->bandwidth * ctx->num);
+				if (send_tm > run_tm) {
+					iperf_msleep(send_tm - run_tm);
+				}
 			}
-		}
 #endif
-		data_len = sendto(local_sock, data_buf, IPERF_UDP_SEND_DATA_LEN, 0,
-		                  (struct sockaddr *)&remote_addr, sizeof(remote_addr));
-		if (data_len > 0) {
-			data_cnt += data_len;
-			packetID++;
-			mBuf_UDP->id = htonl(packetID);
-		} else {
-			data_len = 0;
+			iperf_udp_hdr_set(mBuf_UDP, st->next_id);
+			data_len = sendto(st->sock, ctx->buf, IPERF_UDP_SEND_DATA_LEN, 0,
+			                  (struct sockaddr *)&remote_addr, sizeof(remote_addr));
+			if (data_len > 0) {
+				st->next_id++;
+				iperf_account(ctx, st, data_len);
+			}
+			iperf_tick(ctx);
 		}
-		iperf_calc_speed();
 	}
+	iperf_end_log(ctx);
 
-	mBuf_UDP->id = htonl(-packetID);
-	write_UDP_FIN(local_sock, (struct sockaddr *)&remote_addr, data_buf);
+	for (i = 0; i < ctx->num; ++i) {
+		st = &ctx->stream[i];
+		iperf_udp_hdr_set(mBuf_UDP, -st->next_id);
+		write_UDP_FIN(st->sock, (struct sockaddr *)&remote_addr, ctx->buf);
+	}
 
 socket_error:
-	if (data_buf)
-		free(data_buf);
-	if (local_sock >= 0)
-		closesocket(local_sock);
-
-	OS_Thread_t thread = idata->iperf_thread;
-	iperf_handle_free(idata->handle);
-	IPERF_DBG("%s() [%d] exit!\n", __func__, idata->handle);
-	iperf_thread_exit(&thread);
+	iperf_ctx_free(ctx);
+	iperf_task_exit(idata, __func__);
 }
 
 void iperf_udp_recv_task(void *arg)
 {
 	int local_sock = -1;
 	struct sockaddr_in remote_addr;
-	socklen_t addr_len = sizeof(remote_addr);
+	socklen_t addr_len;
 	iperf_arg *idata = (iperf_arg *)arg;
-	uint32_t run_time = IPERF_SEC_2_INTERVAL(idata->run_time);
 	uint32_t port = idata->port;
-	uint8_t *data_buf = NULL;
+	struct iperf_ctx *ctx;
+	struct iperf_stream *st;
+	struct UDP_datagram *mBuf_UDP;
 	int32_t data_len;
 	int timeout = IPERF_SELECT_TIMEOUT; //ms
-	int packetID = 0;
-	struct UDP_datagram* mBuf_UDP;
-	uint8_t wait = 1;
+
+	ctx = iperf_ctx_new(idata);
+	if (ctx == NULL)
+		goto socket_error;
 
 	if (port == 0) {
 		port = IPERF_PORT;
@@ -417,17 +756,14 @@ void iperf_udp_recv_task(void *arg)
 	}
 	iperf_set_sock_opt(local_sock, idata);
 
-	data_buf = iperf_buf_new(IPERF_BUF_SIZE);
-	if (data_buf == NULL) {
+	ctx->buf = iperf_buf_new(IPERF_BUF_SIZE);
+	if (ctx->buf == NULL) {
 		IPERF_ERR("malloc() failed!\n");
 		goto socket_error;
 	}
 
 	IPERF_DBG("iperf: UDP recv at port %d\n", port);
 
-	uint32_t run_end_tm = 0, run_beg_tm = 0, beg_tm = 0, end_tm = 0, cur_tm = 0;
-	uint64_t data_total_cnt = 0;
-	uint32_t data_cnt = 0;
 #if IPERF_OPT_NUM
 	idata->mode_time = 1;
 #endif
@@ -437,174 +773,231 @@ void iperf_udp_recv_task(void *arg)
 		IPERF_ERR("set socket option err %d\n", iperf_errno);
 		goto socket_error;
 	}
-	mBuf_UDP = (struct UDP_datagram*)data_buf;
-	iperf_loop_init();
+	mBuf_UDP = (struct UDP_datagram *)ctx->buf;
 
 	while (!(idata->flags & IPERF_FLAG_STOP)) {
-		data_len = recvfrom(local_sock, data_buf, IPERF_BUF_SIZE, 0,
+		addr_len = sizeof(remote_addr);
+		data_len = recvfrom(local_sock, ctx->buf, IPERF_BUF_SIZE, 0,
 							(struct sockaddr *)&remote_addr, &addr_len);
-		if (data_len > 0) {
-			if (wait) {
-				wait = 0;
-				iperf_loop_init(); // reinitialization time
+		if (data_len >= (int32_t)sizeof(struct UDP_datagram) &&
+		    (st = iperf_udp_stream(ctx, &remote_addr)) != NULL) {
+			if ((int32_t)ntohl(mBuf_UDP->id) < 0) {
+				if (!st->done) {
+					st->done = 1;
+					IPERF_DBG("iperf udp_recv_task receive a FIN datagram\n");
+				}
+				if (iperf_ctx_done(ctx)) {
+					write_UDP_AckFIN(local_sock, (struct sockaddr *)&remote_addr,
+					                 ctx->buf);
+					break;
+				}
+				/* other streams are still running, just ack this one */
+				sendto(local_sock, ctx->buf, IPERF_UDP_SEND_DATA_LEN, 0,
+				       (struct sockaddr *)&remote_addr, sizeof(remote_addr));
+				continue;
+			}
+			if (!ctx->started) {
+				iperf_clock_start(ctx); // reinitialization time
 				IPERF_DBG("iperf udp_recv_task reinit time and reclocking\n");
 			}
-			data_cnt += data_len;
-		} else {
-			data_len = 0;
-		}
-
-		packetID = ntohl(mBuf_UDP->id);
-		if (packetID < 0) {
-			iperf_calc_speed_fin();
-			IPERF_DBG("iperf udp_recv_task receive a FIN datagram\n");
-			write_UDP_AckFIN(local_sock, (struct sockaddr *)&remote_addr,
-								data_buf);
-			break;
+			if (!st->done) {
+				iperf_udp_account(st, mBuf_UDP);
+				iperf_account(ctx, st, data_len);
+			}
 		}
-		iperf_calc_speed();
+		iperf_tick(ctx);
 	}
+	iperf_end_log(ctx);
 
 socket_error:
-	if (data_buf)
-		free(data_buf);
 	if (local_sock >= 0)
 		closesocket(local_sock);
+	iperf_ctx_free(ctx);
+	iperf_task_exit(idata, __func__);
+}
 
-	OS_Thread_t thread = idata->iperf_thread;
-	iperf_handle_free(idata->handle);
-	IPERF_DBG("%s() [%d] exit!\n", __func__, idata->handle);
-	iperf_thread_exit(&thread);
+/* lwIP keeps pointing at zero-copy payload until it is acked, possibly after
+ * the netconn is gone, so the buffer is allocated once and kept. */
+static uint8_t *g_iperf_zc_buf;
+
+/* The send task to wake for each zero-copy netconn. The event callback runs
+ * in the tcpip thread, so the table is only used with the scheduler
+ * suspended: once a task has removed its entries, no callback still holds
+ * its semaphore. */
+struct iperf_zc_slot {
+	struct netconn	*conn;
+	OS_Semaphore_t	*sem;
+};
+
+static struct iperf_zc_slot g_iperf_zc_slot[IPERF_ARG_HANDLE_MAX * IPERF_STREAM_MAX];
+
+static void iperf_zc_event(struct netconn *conn, enum netconn_evt evt, u16_t len)
+{
+	int i;
+
+	if (evt == NETCONN_EVT_SENDMINUS || evt == NETCONN_EVT_RCVMINUS)
+		return;
+	OS_ThreadSuspendScheduler();
+	for (i = 0; i < IPERF_ARG_HANDLE_MAX * IPERF_STREAM_MAX; ++i) {
+		if (g_iperf_zc_slot[i].conn == conn) {
+			OS_SemaphoreRelease(g_iperf_zc_slot[i].sem);
+			break;
+		}
+	}
+	OS_ThreadResumeScheduler();
+}
+
+static int iperf_zc_slot_add(struct netconn *conn, OS_Semaphore_t *sem)
+{
+	int i, ret = -1;
+
+	OS_ThreadSuspendScheduler();
+	for (i = 0; i < IPERF_ARG_HANDLE_MAX * IPERF_STREAM_MAX; ++i) {
+		if (g_iperf_zc_slot[i].conn == NULL) {
+			g_iperf_zc_slot[i].sem = sem;
+			g_iperf_zc_slot[i].conn = conn;
+			ret = 0;
+			break;
+		}
+	}
+	OS_ThreadResumeScheduler();
+	return ret;
+}
+
+static void iperf_zc_slot_remove(OS_Semaphore_t *sem)
+{
+	int i;
+
+	OS_ThreadSuspendScheduler();
+	for (i = 0; i < IPERF_ARG_HANDLE_MAX * IPERF_STREAM_MAX; ++i) {
+		if (g_iperf_zc_slot[i].sem == sem) {
+			g_iperf_zc_slot[i].conn = NULL;
+			g_iperf_zc_slot[i].sem = NULL;
+		}
+	}
+	OS_ThreadResumeScheduler();
 }
 
 void iperf_tcp_send_task(void *arg)
 {
-	int local_sock = -1;
-	struct sockaddr_in remote_addr;
 	iperf_arg *idata = (iperf_arg *)arg;
-	uint32_t run_time = IPERF_SEC_2_INTERVAL(idata->run_time);
 	uint32_t port = idata->port;
-	uint8_t *data_buf = NULL;
-	int32_t data_len;
-	int ret;
-
-	fd_set fdw;
-	struct timeval tv;
-
-//	OS_MSleep(1); // enable task create function return
-	local_sock = iperf_sock_create(SOCK_STREAM, 0, 0);
-	if (local_sock < 0) {
-		IPERF_ERR("socket() return %d\n", local_sock);
+	struct iperf_ctx *ctx;
+	struct iperf_stream *st;
+	ip_addr_t remote_ip;
+	OS_Semaphore_t sem;
+	size_t written;
+	err_t err;
+	int i, active, progress;
+
+	OS_SemaphoreSetInvalid(&sem);
+	ctx = iperf_ctx_new(idata);
+	if (ctx == NULL)
 		goto socket_error;
+
+	if (g_iperf_zc_buf == NULL) {
+		g_iperf_zc_buf = iperf_buf_new(IPERF_TCP_ZC_BUF_SIZE);
+		if (g_iperf_zc_buf == NULL)
+			goto socket_error;
 	}
-	iperf_set_sock_opt(local_sock, idata);
 
-	data_buf = iperf_buf_new(IPERF_BUF_SIZE);
-	if (data_buf == NULL) {
-		IPERF_ERR("malloc() failed!\n");
+	if (!ipaddr_aton(idata->remote_ip, &remote_ip)) {
+		IPERF_ERR("invalid ip %s\n", idata->remote_ip);
 		goto socket_error;
 	}
 
-	uint32_t i = 1;
-	ret = ioctlsocket(local_sock, FIONBIO, &i);
-	if (ret < 0) {
-		IPERF_ERR("ioctlsocket() return %d\n", ret);
+	if (OS_SemaphoreCreateBinary(&sem) != OS_OK) {
+		IPERF_ERR("sem create failed\n");
 		goto socket_error;
 	}
 
-	memset(&remote_addr, 0, sizeof(struct sockaddr_in));
-	inet_aton(idata->remote_ip, &remote_addr.sin_addr);
-	remote_addr.sin_port = htons(port);
-	remote_addr.sin_family = AF_INET;
-
-	ret = connect(local_sock, (struct sockaddr *)&remote_addr, sizeof(remote_addr));
-	if (ret != 0) {
-		if (errno != EINPROGRESS) {
-			IPERF_ERR("connect() return %d\n", ret);
+	for (i = 0; i < iperf_ctx_streams(ctx); ++i) {
+		st = &ctx->stream[i];
+		st->conn = netconn_new_with_callback(NETCONN_TCP, iperf_zc_event);
+		if (st->conn == NULL) {
+			IPERF_ERR("netconn_new() failed\n");
+			goto socket_error;
+		}
+		ctx->num++;
+		if (iperf_zc_slot_add(st->conn, &sem) != 0) {
+			IPERF_ERR("no zero-copy slot\n");
+			goto socket_error;
+		}
+#if IPERF_OPT_TOS
+		if (idata->tos > 0)
+			st->conn->pcb.tcp->tos = idata->tos;
+#endif
+		/* non-blocking so that one stream never stalls the others */
+		netconn_set_nonblocking(st->conn, 1);
+		err = netconn_connect(st->conn, &remote_ip, port);
+		if (err != ERR_OK && err != ERR_INPROGRESS) {
+			IPERF_ERR("connect() return %d\n", err);
 			goto socket_error;
-		} else {
-			while (!(idata->flags & IPERF_FLAG_STOP)) {
-
-				FD_ZERO(&fdw);
-				FD_SET(local_sock, &fdw);
-				tv.tv_sec = 0;
-				tv.tv_usec = 100000; //100ms
-
-				ret = select(local_sock + 1, NULL, &fdw, NULL, &tv);
-				if (ret > 0) {
-					if (FD_ISSET(local_sock, &fdw)) {
-						break;
-					}
-				} else if (ret < 0) {
-					IPERF_ERR("socket select err! errno:%d\n", errno);
-					goto socket_error;
-				} else if (ret == 0) {
-					continue;
-				}
-			}
-			if (idata->flags & IPERF_FLAG_STOP)
-				goto socket_error;
 		}
 	}
 
-	IPERF_DBG("iperf: TCP send to %s:%d\n", idata->remote_ip, port);
-
-	uint32_t run_end_tm = 0, run_beg_tm = 0, beg_tm = 0, end_tm = 0, cur_tm = 0;
-	uint64_t data_total_cnt = 0;
-	uint32_t data_cnt = 0;
-
-	iperf_loop_init();
+	IPERF_DBG("iperf: TCP send to %s:%d, %d stream(s)\n", idata->remote_ip,
+	          port, ctx->num);
 
 	while (!(idata->flags & IPERF_FLAG_STOP)) {
-		FD_ZERO(&fdw);
-		FD_SET(local_sock, &fdw);
-		tv.tv_sec = 0;
-		tv.tv_usec = 100000; //100ms
-
-		ret = select(local_sock + 1, NULL, &fdw, NULL, &tv);
-		if (ret > 0) {
-			if (FD_ISSET(local_sock, &fdw)) {
-				data_len = send(local_sock, data_buf, IPERF_TCP_SEND_DATA_LEN, 0);
-				if (data_len > 0) {
-					data_cnt += data_len;
-				} else {
-					IPERF_WARN("send return %d, err %d\n", data_len, iperf_errno);
-					break;
-				}
-				iperf_calc_speed();
+		active = 0;
+		progress = 0;
+		for (i = 0; i < ctx->num && !(idata->flags & IPERF_FLAG_STOP); ++i) {
+			st = &ctx->stream[i];
+			if (st->done)
+				continue;
+			active++;
+			written = 0;
+			err = netconn_write_partly(st->conn, g_iperf_zc_buf,
+			                           IPERF_TCP_ZC_BUF_SIZE, NETCONN_NOCOPY,
+			                           &written);
+			if (err == ERR_OK && written > 0) {
+				if (!ctx->started)
+					iperf_clock_start(ctx);
+				iperf_account(ctx, st, written);
+				progress = 1;
+			} else if (err != ERR_OK && err != ERR_WOULDBLOCK &&
+			           err != ERR_INPROGRESS && err != ERR_MEM) {
+				IPERF_WARN("[%d.%d] send return %d\n", idata->handle, i, err);
+				st->done = 1;
 			}
-		} else if (ret < 0) {
-			IPERF_ERR("socket select err! errno:%d\n", errno);
-			goto socket_error;
-		} else if (ret == 0) {
-			continue;
 		}
+		if (!active)
+			break;
+		iperf_tick(ctx);
+		if (!progress)
+			OS_SemaphoreWait(&sem, IPERF_SELECT_TIMEOUT);
 	}
+	iperf_end_log(ctx);
 
 socket_error:
-	if (data_buf)
-		free(data_buf);
-	if (local_sock >= 0)
-		closesocket(local_sock);
-
-	OS_Thread_t thread = idata->iperf_thread;
-	iperf_handle_free(idata->handle);
-	IPERF_DBG("%s() [%d] exit!\n", __func__, idata->handle);
-	iperf_thread_exit(&thread);
+	/* before the netconns go, so that a new netconn at the same address
+	 * can't be taken for one of ours */
+	iperf_zc_slot_remove(&sem);
+	iperf_ctx_free(ctx);
+	if (OS_SemaphoreIsValid(&sem))
+		OS_SemaphoreDelete(&sem);
+	iperf_task_exit(idata, __func__);
 }
 
 void iperf_tcp_recv_task(void *arg)
 {
 	int local_sock = -1;
-	int remote_sock = -1;
+	int remote_sock;
+	int maxfd, ret, i;
 	struct sockaddr_in remote_addr;
+	socklen_t addr_len;
 	iperf_arg *idata = (iperf_arg *)arg;
 	uint32_t port = idata->port;
-	uint32_t run_time = IPERF_SEC_2_INTERVAL(idata->run_time);
-	uint8_t *data_buf = NULL;
+	struct iperf_ctx *ctx;
+	struct iperf_stream *st;
 	int32_t data_len;
-	int ret;
-	int timeout = IPERF_SELECT_TIMEOUT; //ms
+	fd_set fdr;
+	struct timeval tv;
+
+	ctx = iperf_ctx_new(idata);
+	if (ctx == NULL)
+		goto socket_error;
 
 	local_sock = iperf_sock_create(SOCK_STREAM, port, 1);
 	if (local_sock < 0) {
@@ -613,76 +1006,92 @@ void iperf_tcp_recv_task(void *arg)
 	}
 	iperf_set_sock_opt(local_sock, idata);
 
-	data_buf = iperf_buf_new(IPERF_BUF_SIZE);
-	if (data_buf == NULL) {
+	ctx->buf = iperf_buf_new(IPERF_BUF_SIZE);
+	if (ctx->buf == NULL) {
 		IPERF_ERR("malloc() failed!\n");
 		goto socket_error;
 	}
 
 	IPERF_DBG("iperf: TCP listen at port %d\n", port);
 
-	ret = listen(local_sock, 5);
+	ret = listen(local_sock, IPERF_STREAM_MAX);
 	if (ret < 0) {
 		IPERF_ERR("Failed to listen socket %d, err %d\n", local_sock, iperf_errno);
 		goto socket_error;
 	}
 
-	ret = sizeof(struct sockaddr_in);
-
-	/* Set the recv timeout to set the accept timeout */
-	if (setsockopt(local_sock, SOL_SOCKET, SO_RCVTIMEO,
-					(char *)&timeout, sizeof(timeout)) < 0) {
-		IPERF_ERR("set socket option err %d\n", iperf_errno);
-		goto socket_error;
-	}
+#if IPERF_OPT_NUM
+	idata->mode_time = 1;
+#endif
 
+	/* every connection of a -P client is one stream, the test ends when
+	 * all of them are closed */
 	while (!(idata->flags & IPERF_FLAG_STOP)) {
-		remote_sock = accept(local_sock, (struct sockaddr *)&remote_addr,
-							(socklen_t *)&ret);
-		if (remote_sock >= 0) {
-			iperf_set_sock_opt(remote_sock, idata);
-			break;
+		FD_ZERO(&fdr);
+		FD_SET(local_sock, &fdr);
+		maxfd = local_sock;
+		for (i = 0; i < ctx->num; ++i) {
+			st = &ctx->stream[i];
+			if (!st->done) {
+				FD_SET(st->sock, &fdr);
+				if (st->sock > maxfd)
+					maxfd = st->sock;
+			}
 		}
-	}
+		tv.tv_sec = 0;
+		tv.tv_usec = IPERF_SELECT_TIMEOUT * 1000;
 
-	if (!(idata->flags & IPERF_FLAG_STOP)) {
-		IPERF_DBG("iperf: client from %s:%d\n", inet_ntoa(remote_addr.sin_addr),
-					ntohs(remote_addr.sin_port));
-	}
+		ret = select(maxfd + 1, &fdr, NULL, NULL, &tv);
+		if (ret < 0) {
+			IPERF_ERR("socket select err! errno:%d\n", errno);
+			break;
+		}
 
-	uint32_t run_end_tm = 0, run_beg_tm = 0, beg_tm = 0, end_tm = 0, cur_tm = 0;
-	uint64_t data_total_cnt = 0;
-	uint32_t data_cnt = 0;
-#if IPERF_OPT_NUM
-	idata->mode_time = 1;
-#endif
+		for (i = 0; ret > 0 && i < ctx->num; ++i) {
+			st = &ctx->stream[i];
+			if (st->done || !FD_ISSET(st->sock, &fdr))
+				continue;
+			data_len = recv(st->sock, ctx->buf, IPERF_BUF_SIZE, 0);
+			if (data_len > 0) {
+				iperf_account(ctx, st, data_len);
+			} else {
+				if (data_len < 0)
+					IPERF_WARN("recv return %d, err %d\n", data_len, iperf_errno);
+				st->done = 1;
+				closesocket(st->sock);
+				st->sock = -1;
+			}
+		}
 
-	iperf_loop_init();
+		if (ret > 0 && FD_ISSET(local_sock, &fdr)) {
+			addr_len = sizeof(remote_addr);
+			remote_sock = accept(local_sock, (struct sockaddr *)&remote_addr,
+			                     &addr_len);
+			if (remote_sock >= 0 && ctx->num >= IPERF_STREAM_MAX) {
+				IPERF_WARN("too many streams, drop client\n");
+				closesocket(remote_sock);
+			} else if (remote_sock >= 0) {
+				iperf_set_sock_opt(remote_sock, idata);
+				IPERF_DBG("iperf: client from %s:%d\n",
+				          inet_ntoa(remote_addr.sin_addr),
+				          ntohs(remote_addr.sin_port));
+				ctx->stream[ctx->num++].sock = remote_sock;
+				if (!ctx->started)
+					iperf_clock_start(ctx);
+			}
+		}
 
-	while (!(idata->flags & IPERF_FLAG_STOP)) {
-		data_len = recv(remote_sock, data_buf, IPERF_BUF_SIZE, 0);
-		if (data_len > 0) {
-			data_cnt += data_len;
-		} else {
-			iperf_calc_speed_fin();
-			IPERF_WARN("recv return %d, err %d\n", data_len, iperf_errno);
+		iperf_tick(ctx);
+		if (iperf_ctx_done(ctx))
 			break;
-		}
-		iperf_calc_speed();
 	}
+	iperf_end_log(ctx);
 
 socket_error:
-	if (remote_sock)
-		closesocket(remote_sock);
-	if (data_buf)
-		free(data_buf);
 	if (local_sock >= 0)
 		closesocket(local_sock);
-
-	OS_Thread_t thread = idata->iperf_thread;
-	iperf_handle_free(idata->handle);
-	IPERF_DBG("%s() [%d] exit!\n", __func__, idata->handle);
-	iperf_thread_exit(&thread);
+	iperf_ctx_free(ctx);
+	iperf_task_exit(idata, __func__);
 }
 
 static const OS_ThreadEntry_t iperf_thread_entry[IPERF_MODE_NUM] = {
@@ -692,9 +1101,24 @@ static const OS_ThreadEntry_t iperf_thread_entry[IPERF_MODE_NUM] = {
 	iperf_tcp_recv_task,
 }; /* index by enum IPERF_MODE */
 
+/* client of a local iperf server, runs without the WLAN being up */
+int iperf_handle_is_loopback(int handle)
+{
+	iperf_arg *idata;
+
+	if (handle < 0 || handle >= IPERF_ARG_HANDLE_MAX)
+		return 0;
+	idata = g_iperf_arg_handle[handle];
+	if (idata == NULL || (idata->flags & IPERF_FLAG_SERVER))
+		return 0;
+	return (ntohl(inet_addr(idata->remote_ip)) >> 24) == 127;
+}
+
 int iperf_handle_start(struct netif *nif, int handle)
 {
-	if (nif == NULL || handle < 0 || handle >= IPERF_ARG_HANDLE_MAX)
+	if (handle < 0 || handle >= IPERF_ARG_HANDLE_MAX)
+		return -1;
+	if (nif == NULL && !iperf_handle_is_loopback(handle))
 		return -1;
 
 	if (OS_ThreadIsValid(&(g_iperf_arg_handle[handle]->iperf_thread))) {
@@ -811,13 +1235,6 @@ int iperf_handle_free(int handle)
 	return 0;
 }
 
-static const char *iperf_mode_str[IPERF_MODE_NUM] = {
-	"udp-send",
-	"udp-recv",
-	"tcp-send",
-	"tcp-recv",
-};
-
 int iperf_show_list(void) {
 	int i = 0;
 	int run_num = 0;
@@ -832,7 +1249,9 @@ int iperf_show_list(void) {
 			IPERF_LOG(1, "remote ip = %s\n", g_iperf_arg_handle[i]->remote_ip);
 			IPERF_LOG(1, "port      = %u\n", g_iperf_arg_handle[i]->port);
 			IPERF_LOG(1, "run time  = %u\n", g_iperf_arg_handle[i]->run_time);
-			IPERF_LOG(1, "interval  = %u\n\n", g_iperf_arg_handle[i]->interval);
+			IPERF_LOG(1, "interval  = %u\n", g_iperf_arg_handle[i]->interval);
+			IPERF_LOG(1, "streams   = %u\n\n",
+			          g_iperf_arg_handle[i]->streams ? g_iperf_arg_handle[i]->streams : 1);
 		}
 	}
 	if (!run_num)
@@ -845,7 +1264,7 @@ int iperf_parse_argv(int argc, char *argv[])
 	iperf_arg iperf_arg_t;
 	uint32_t port;
 	int opt = 0;
-	char *short_opts = "LusQ:c:f:p:t:i:b:n:S:";
+	char *short_opts = "LusJQ:c:f:p:t:i:b:n:S:P:";
 	memset(&iperf_arg_t, 0, sizeof(iperf_arg_t));
 #if IPERF_OPT_BANDWIDTH
 	iperf_arg_t.bandwidth = 1000 * 1000; /* default to 1Mbits/sec */
@@ -942,6 +1361,23 @@ int iperf_parse_argv(int argc, char *argv[])
 			case 'S':
 				iperf_arg_t.tos = (uint16_t)strtol(optarg, NULL, 0);
 				break;
+#endif
+#if IPERF_OPT_STREAMS
+			case 'P': {
+				int streams = atoi(optarg);
+				if (streams < 1 || streams > IPERF_STREAM_MAX) {
+					IPERF_ERR("invalid streams arg '%s', 1~%d\n", optarg,
+					          IPERF_STREAM_MAX);
+					return -1;
+				}
+				iperf_arg_t.streams = streams;
+				break;
+			}
+#endif
+#if IPERF_OPT_JSON
+			case 'J':
+				iperf_arg_t.flags |= IPERF_FLAG_JSON;
+				break;
 #endif
 			default :
 				return -1;
@@ -43,9 +43,15 @@ extern "C" {
 #define IPERF_OPT_BANDWIDTH		1	/* -b, bandwidth to send at in bits/sec */
 #define IPERF_OPT_NUM			1	/* -n, number of bytes to transmit (instead of -t) */
 #define IPERF_OPT_TOS			1	/* -S, the type-of-service for outgoing packets */
+#define IPERF_OPT_STREAMS		1	/* -P, number of parallel client streams */
+#define IPERF_OPT_JSON			1	/* -J, print the results as JSON */
 
 #define MAX_INTERVAL 60
 #define IPERF_ARG_HANDLE_MAX    4
+#define IPERF_STREAM_MAX        4
+
+#define IPERF_JITTER_HIST_NUM   6	/* <1, <2, <5, <10, <20, >=20 ms */
+#define IPERF_LOSS_HIST_NUM     5	/* bursts of 1, 2-3, 4-7, 8-15, >=16 */
 
 #ifndef INET_ADDRSTRLEN
 #define INET_ADDRSTRLEN         16
@@ -73,6 +79,7 @@ enum IPERF_FLAGS {
 	IPERF_FLAG_UDP     = 0x00000010,
 	IPERF_FLAG_FORMAT  = 0x00000020,
 	IPERF_FLAG_STOP    = 0x00000040,
+	IPERF_FLAG_JSON    = 0x00000080,
 };
 
 typedef struct {
@@ -91,13 +98,17 @@ typedef struct {
 #if IPERF_OPT_BANDWIDTH
 	uint32_t	bandwidth; // in bits/sec (k == 1000, m == 1000 * 1000)
 #endif
+	uint8_t		streams; // parallel streams, 0 means 1
 	uint32_t	flags;
 	OS_Thread_t iperf_thread;
 	int 		handle;
 }iperf_arg;
 
+/* iperf2 UDP payload header, in network order */
 typedef struct UDP_datagram {
     signed int id ;
+    unsigned int tv_sec ;
+    unsigned int tv_usec ;
 } UDP_datagram;
 
 
@@ -106,6 +117,7 @@ int iperf_stop(char* arg);
 int iperf_parse_argv(int argc, char *argv[]);
 int iperf_handle_free(int handle);
 int iperf_handle_start(struct netif * nif, int handle);
+int iperf_handle_is_loopback(int handle);
 
 #ifdef __cplusplus
 }
@@ -94,6 +94,37 @@ extern "C" {
 #error "image max size MUST be defined in image.cfg file and set PRJCONF_IMG_MAX_SIZE to 0!"
 #endif
 
+/* check the running image at boot, and remember a passed check in flash so
+ * that the next boots of the same image only read the section headers.
+ */
+#ifndef PRJCONF_IMG_BOOT_CHECK
+#define PRJCONF_IMG_BOOT_CHECK          0
+#endif
+
+#if PRJCONF_IMG_BOOT_CHECK
+
+/* flash area keeping the record of checked images (by fdcm) */
+#ifndef PRJCONF_IMG_CHECK_CACHE_FLASH
+#define PRJCONF_IMG_CHECK_CACHE_FLASH   0
+#endif
+
+#ifndef PRJCONF_IMG_CHECK_CACHE_ADDR
+#define PRJCONF_IMG_CHECK_CACHE_ADDR    ((1024 - 8) * 1024)
+#endif
+
+#ifndef PRJCONF_IMG_CHECK_CACHE_SIZE
+#define PRJCONF_IMG_CHECK_CACHE_SIZE    (4 * 1024)
+#endif
+
+/* interval (in seconds) of reading the whole running image again in the
+ * background to catch flash corruption, 0 to disable
+ */
+#ifndef PRJCONF_IMG_SCRUB_INTERVAL
+#define PRJCONF_IMG_SCRUB_INTERVAL      (24 * 60 * 60)
+#endif
+
+#endif /* PRJCONF_IMG_BOOT_CHECK */
+
 /* save sysinfo to flash or not */
 #ifndef PRJCONF_SYSINFO_SAVE_TO_FLASH
 #define PRJCONF_SYSINFO_SAVE_TO_FLASH	1
@@ -121,8 +152,50 @@ extern "C" {
 #define PRJCONF_SYSINFO_CHECK_OVERLAP	1
 #endif
 
+/* save sysinfo in a key-value store (image/kvs.h), one record per field or per
+ * group of fields that go together (the settings of an interface), so that a
+ * save only writes the records changed and a power cut leaves each record
+ * either old or new. Needs 2 sectors (8K) at least.
+ * The sysinfo area is not migrated: on a device that saved sysinfo without it,
+ * the first mount formats the area and the saved sysinfo is lost (defaults
+ * are used).
+ */
+#ifndef PRJCONF_SYSINFO_USE_KVS
+#define PRJCONF_SYSINFO_USE_KVS			0
+#endif
+
+#if (PRJCONF_SYSINFO_USE_KVS && (PRJCONF_SYSINFO_SIZE < 8 * 1024))
+#error "PRJCONF_SYSINFO_SIZE MUST be 8K at least for PRJCONF_SYSINFO_USE_KVS!"
+#endif
+
 #endif /* PRJCONF_SYSINFO_SAVE_TO_FLASH */
 
+/* flash file system (fs/norfs) on a data area of the flash, mounted at boot
+ * by fs_ctrl as FS_MNT_DEV_TYPE_FLASH. The area MUST be clear of the images,
+ * the OTA area and sysinfo; an area never used before mounts as empty.
+ */
+#ifndef PRJCONF_NORFS_EN
+#define PRJCONF_NORFS_EN                0
+#endif
+
+#if PRJCONF_NORFS_EN
+
+#ifndef PRJCONF_NORFS_FLASH
+#define PRJCONF_NORFS_FLASH             0
+#endif
+
+/* start address, 4K aligned */
+#ifndef PRJCONF_NORFS_ADDR
+#define PRJCONF_NORFS_ADDR              (1024 * 1024)
+#endif
+
+/* size, multiple of 4K, 16K at least */
+#ifndef PRJCONF_NORFS_SIZE
+#define PRJCONF_NORFS_SIZE              (256 * 1024)
+#endif
+
+#endif /* PRJCONF_NORFS_EN */
+
 /* MAC address source */
 #ifndef PRJCONF_MAC_ADDR_SOURCE
 #define PRJCONF_MAC_ADDR_SOURCE         SYSINFO_MAC_ADDR_CHIPID
@@ -220,6 +293,11 @@ extern "C" {
 #define PRJCONF_AUDIO_CTRL_EN           0
 #endif
 
+/* cedarx sound mixer enable/disable, tones play over the music */
+#ifndef PRJCONF_SOUND_MIXER_EN
+#define PRJCONF_SOUND_MIXER_EN          1
+#endif
+
 /* swd enable/disable */
 #ifndef PRJCONF_SWD_EN
 #define PRJCONF_SWD_EN                  0
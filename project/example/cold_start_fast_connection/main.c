@@ -27,6 +27,7 @@
  *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 #include "net/wlan/wlan.h"
@@ -36,7 +37,7 @@
 #include "common/framework/sysinfo.h"
 #include "common/cmd/cmd.h"
 #include "lwip/inet.h"
-#include "sys/fdcm.h"
+#include "image/kvs.h"
 #include "sys/xr_debug.h"
 #include "util/time_logger.h"
 
@@ -100,6 +101,7 @@ int net_msg_rcv_init(void)
 #define BSS_FLASH_NUM		(0)
 #define BSS_FLASH_ADDR		((1024 + 128) * 1024)
 #define BSS_FLASH_SIZE		(8*1024)
+#define BSS_KVS_KEY_MAX		(4)
 typedef struct bss_info {
 	uint8_t		ssid[32];
 	uint8_t		psk[32];
@@ -139,7 +141,7 @@ int save_bss_to_flash(bss_info_t * pbss_info)
 	int ret = 0;
 	uint32_t size;
 	wlan_sta_bss_info_t bss_get;
-	fdcm_handle_t * bss_fdcm_hdl;
+	kvs_handle_t * bss_kvs_hdl;
 
 	if (!g_ap_connected) {
 		printf("Please connect AP first!\n");
@@ -184,15 +186,23 @@ int save_bss_to_flash(bss_info_t * pbss_info)
 	memcpy(pbss_info->psk, param.psk, 32);
 	pbss_info->bss_size = size;
 	memcpy(pbss_info->bss, bss_get.bss, size);
-	bss_fdcm_hdl = fdcm_open(BSS_FLASH_NUM, BSS_FLASH_ADDR, BSS_FLASH_SIZE);
-	if (bss_fdcm_hdl == NULL) {
-		printf("fdcm open failed, hdl %p\n", bss_fdcm_hdl);
+	free(bss_get.bss);
+	bss_kvs_hdl = kvs_open(BSS_FLASH_NUM, BSS_FLASH_ADDR, BSS_FLASH_SIZE, BSS_KVS_KEY_MAX);
+	if (bss_kvs_hdl == NULL) {
+		printf("kvs open failed, hdl %p\n", bss_kvs_hdl);
 		ret = -1;
 		return ret;
 	}
-	fdcm_write(bss_fdcm_hdl, pbss_info, sizeof(bss_info_t));
-	fdcm_close(bss_fdcm_hdl);
-	free(bss_get.bss);
+	//SSID, PSK and bss go together in one record, written whole or not at all.
+	//It is only rewritten if it changed, reconnecting to the same AP writes nothing
+	if (kvs_set(bss_kvs_hdl, "fc_info", pbss_info,
+	            offsetof(bss_info_t, bss) + pbss_info->bss_size)) {
+		printf("kvs write failed\n");
+		ret = -1;
+	}
+	kvs_close(bss_kvs_hdl);
+	if (ret != 0)
+		return ret;
     printf("Save bss info done!\n");
 	return ret;
 }
@@ -200,18 +210,18 @@ int save_bss_to_flash(bss_info_t * pbss_info)
 int clear_bss_in_flash(void)
 {
 	int ret = 0;
-	fdcm_handle_t * bss_fdcm_hdl;
+	kvs_handle_t * bss_kvs_hdl;
 
     printf("Clear bss info in flash!\n");
 	memset(&g_bss_info, 0, sizeof(bss_info_t));
-	bss_fdcm_hdl = fdcm_open(BSS_FLASH_NUM, BSS_FLASH_ADDR, BSS_FLASH_SIZE);
-	if (bss_fdcm_hdl == NULL) {
-		printf("fdcm open failed, hdl %p\n", bss_fdcm_hdl);
+	bss_kvs_hdl = kvs_open(BSS_FLASH_NUM, BSS_FLASH_ADDR, BSS_FLASH_SIZE, BSS_KVS_KEY_MAX);
+	if (bss_kvs_hdl == NULL) {
+		printf("kvs open failed, hdl %p\n", bss_kvs_hdl);
 		ret = -1;
 		return ret;
 	}
-	fdcm_write(bss_fdcm_hdl, &g_bss_info, sizeof(bss_info_t));
-	fdcm_close(bss_fdcm_hdl);
+	kvs_delete(bss_kvs_hdl, "fc_info");
+	kvs_close(bss_kvs_hdl);
 
 	struct sysinfo *sysinfo = sysinfo_get();
 	if (sysinfo == NULL) {
@@ -263,23 +273,28 @@ void connect_ap_fast(bss_info_t * pbss_info)
 int get_bss_from_flash(bss_info_t * pbss_info)
 {
 	int ret;
-	uint32_t size;
+	int size;
 	wlan_sta_bss_info_t bss_set;
-	fdcm_handle_t * bss_fdcm_hdl;
+	kvs_handle_t * bss_kvs_hdl;
 
-	bss_fdcm_hdl = fdcm_open(BSS_FLASH_NUM, BSS_FLASH_ADDR, BSS_FLASH_SIZE);
-	if (bss_fdcm_hdl == NULL) {
-		printf("fdcm open failed, hdl %p\n", bss_fdcm_hdl);
+	memset(pbss_info, 0, sizeof(bss_info_t));
+	bss_kvs_hdl = kvs_open(BSS_FLASH_NUM, BSS_FLASH_ADDR, BSS_FLASH_SIZE, BSS_KVS_KEY_MAX);
+	if (bss_kvs_hdl == NULL) {
+		printf("kvs open failed, hdl %p\n", bss_kvs_hdl);
 		ret = -1;
 		return ret;
 	}
-	size = fdcm_read(bss_fdcm_hdl, pbss_info, sizeof(bss_info_t));
-	fdcm_close(bss_fdcm_hdl);
-	if (size != sizeof(bss_info_t)) {
-		printf("fdcm read failed, size %d\n", size);
+	size = kvs_get(bss_kvs_hdl, "fc_info", pbss_info, sizeof(bss_info_t));
+	kvs_close(bss_kvs_hdl);
+	if (size < 0) {
+		printf("kvs read failed, size %d\n", size);
 		ret = -1;
 		return ret;
 	}
+	if (size < (int)offsetof(bss_info_t, bss) ||
+	    pbss_info->bss_size != size - offsetof(bss_info_t, bss)) {
+		memset(pbss_info, 0, sizeof(bss_info_t));
+	}
 	if (pbss_info->bss_size == 0) {
 		printf("empty bss info\n");
 		ret = -1;
@@ -33,6 +33,7 @@
 #include <stdint.h>
 #include "kernel/os/os_time.h"
 #include "kernel/os/os_thread.h"
+#include "kernel/os/os_semaphore.h"
 #include "audio/pcm/audio_pcm.h"
 #include "audio/manager/audio_manager.h"
 #include "debug.h"
@@ -64,6 +65,8 @@
 
 #define AEC_THREAD_STACK_SIZE    (1024 * 4)
 
+#define RECORD_FIFO_PERIODS      6    /* 60 ms of capture between the record and aec tasks */
+
 #ifdef ASR_SUPPORT
 struct AsrContext {
 	//TODO:add value of asr algorithm
@@ -92,6 +95,7 @@ struct recordContext {
 	int record_run;
 	OS_Thread_t record_thread;
 	struct PcmFifoS *recordFifo;
+	OS_Semaphore_t recordSem;    /* released for every period put in the fifo */
 	void *recordData;
 	unsigned int recordLen;
 };
@@ -150,13 +154,26 @@ static void Aec_Deinit(struct AecContext *pAec)
 
 #ifdef USE_TASK_TO_RECORD
 
+/*
+ * The record task is the only producer of recordFifo and the aec task the
+ * only consumer, so the fifo needs no lock. A period is read straight into
+ * the fifo; recordData is only used when the fifo is full, and that period
+ * is dropped.
+ */
 static void record_task(void *arg)
 {
+	void *buf;
+
 	while (rdContext.record_run) {
-		snd_pcm_read(AUDIO_CARD_ID, rdContext.recordData, rdContext.recordLen);
-		PcmFifoLock(rdContext.recordFifo);
-		PcmFifoIn(rdContext.recordFifo, rdContext.recordData, rdContext.recordLen, 1);
-		PcmFifoUnlock(rdContext.recordFifo);
+		buf = PcmFifoReserve(rdContext.recordFifo, rdContext.recordLen);
+		if (buf != NULL) {
+			snd_pcm_read(AUDIO_CARD_ID, buf, rdContext.recordLen);
+			PcmFifoCommit(rdContext.recordFifo, rdContext.recordLen);
+		} else {
+			snd_pcm_read(AUDIO_CARD_ID, rdContext.recordData, rdContext.recordLen);
+			PcmFifoIn(rdContext.recordFifo, rdContext.recordData, rdContext.recordLen, 1);
+		}
+		OS_SemaphoreRelease(&rdContext.recordSem);
 	}
 
 	OS_ThreadDelete(&rdContext.record_thread);
@@ -173,13 +190,18 @@ static int record_task_start()
 		return -1;
 	}
 
-	rdContext.recordFifo = pcm_fifo_create(8 * 1024);
+	rdContext.recordFifo = pcm_fifo_create(RECORD_FIFO_PERIODS * rdContext.recordLen, 0);
 	if (rdContext.recordFifo == NULL) {
 		printf("pcm fifo for record task create fail.\n");
 		goto err0;
 	}
 	PcmFifoControl(rdContext.recordFifo, SAVE_PCM_DATA, NULL);
 
+	if (OS_SemaphoreCreateBinary(&rdContext.recordSem) != OS_OK) {
+		printf("semaphore create fail.\n");
+		goto err1;
+	}
+
 	rdContext.record_run = 1;
 	if (OS_ThreadCreate(&rdContext.record_thread,
                         "record_task",
@@ -188,11 +210,13 @@ static int record_task_start()
                         OS_PRIORITY_ABOVE_NORMAL,
                         1 * 1024) != OS_OK) {
 		printf("thread create error\n");
-		goto err1;
+		goto err2;
 	}
 
 	return 0;
 
+err2:
+	OS_SemaphoreDelete(&rdContext.recordSem);
 err1:
 	pcm_fifo_destroy(rdContext.recordFifo);
 	rdContext.recordFifo = NULL;
@@ -203,26 +227,25 @@ err0:
 	return -1;
 }
 
-static int record_task_get_data(void *buffer, unsigned int len)
+/* the next len bytes in place in the fifo, hand them back with record_task_put_data() */
+static const void *record_task_get_data(unsigned int len)
 {
-	int readLen = 0;
-	int validLen;
+	const void *data;
 
 	while (rdContext.record_run) {
-		PcmFifoLock(rdContext.recordFifo);
-		validLen = PcmFifoValid(rdContext.recordFifo);
-		if (validLen >= len) {
-			PcmFifoOut(rdContext.recordFifo, buffer, len);
-			PcmFifoUnlock(rdContext.recordFifo);
-			readLen = len;
-			break;
-		} else {
-			PcmFifoUnlock(rdContext.recordFifo);
-			OS_MSleep(2);  /* for 16000hz, 1 channel, 1s will produce 32k data */
-			continue;
+		data = PcmFifoPeek(rdContext.recordFifo, len);
+		if (data != NULL) {
+			return data;
 		}
+		/* a period takes 10 ms, the timeout only guards against a stalled card */
+		OS_SemaphoreWait(&rdContext.recordSem, 100);
 	}
-	return readLen;
+	return NULL;
+}
+
+static void record_task_put_data(unsigned int len)
+{
+	PcmFifoRelease(rdContext.recordFifo, len);
 }
 
 static int record_task_stop()
@@ -232,6 +255,7 @@ static int record_task_stop()
 		OS_MSleep(10);
 	}
 
+	OS_SemaphoreDelete(&rdContext.recordSem);
 	pcm_fifo_destroy(rdContext.recordFifo);
 	rdContext.recordFifo = NULL;
 
@@ -326,25 +350,32 @@ err1:
 static int audio_get_micsig_aecref(struct audioContext *pAudio)
 {
 	int i;
-	int ret;
+	const short *data;
 
 #ifdef USE_TASK_TO_RECORD
-	ret = record_task_get_data(pAudio->ReadData, pAudio->ReadLen);
+	data = record_task_get_data(pAudio->ReadLen);
+	if (data == NULL) {
+		printf("get record data fail.\n");
+		return -1;
+	}
 #else
-	ret = snd_pcm_read(AUDIO_CARD_ID, pAudio->ReadData, pAudio->ReadLen);
-#endif
-
-	if (ret != pAudio->ReadLen) {
+	if (snd_pcm_read(AUDIO_CARD_ID, pAudio->ReadData, pAudio->ReadLen) != pAudio->ReadLen) {
 		printf("get record data fail.\n");
 		return -1;
 	}
+	data = pAudio->ReadData;
+#endif
 
 	for (i = 0; i < SAMPLE_10MS; i++) {
-		pAudio->AecRef[i] = ((short *)pAudio->ReadData)[4 * i + 1];
-		pAudio->MicSig[i] = ((short *)pAudio->ReadData)[4 * i + 2];
-		pAudio->MicSig[i + SAMPLE_10MS] = ((short *)pAudio->ReadData)[4 * i + 3];
+		pAudio->AecRef[i] = data[4 * i + 1];
+		pAudio->MicSig[i] = data[4 * i + 2];
+		pAudio->MicSig[i + SAMPLE_10MS] = data[4 * i + 3];
 	}
 
+#ifdef USE_TASK_TO_RECORD
+	record_task_put_data(pAudio->ReadLen);
+#endif
+
 	return 0;
 }
 
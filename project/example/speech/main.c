@@ -42,7 +42,7 @@ int main(void)
 
 	HAL_PsramCtrl_Set_RD_BuffSize(PSRAMC_CACHE_LL_256BIT);
 
-	pcmFifo = pcm_fifo_create(4 * 1024);
+	pcmFifo = pcm_fifo_create(4 * 1024, 0);
 
 	aec_asr_start();
 	return 0;
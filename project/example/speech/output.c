@@ -120,9 +120,7 @@ static int result_param_solve(struct resultParam *param)
 
 static int media_data_solve(struct mediaData *mData)
 {
-	PcmFifoLock(pcmFifo);
 	PcmFifoIn(pcmFifo, mData->LOut, mData->loutLen, 1);
-	PcmFifoUnlock(pcmFifo);
 
 	return 0;
 }
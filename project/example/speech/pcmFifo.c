@@ -27,81 +27,100 @@
  *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include "kernel/os/os_mutex.h"
-#include "kfifo.h"
+#include "util/spsc_ring.h"
 #include "pcmFifo.h"
 
 struct PcmFifoImpl {
     struct PcmFifoS base; /* must put it first */
-    struct kfifo fifo;
-    OS_Mutex_t mutex;
+    spsc_ring_t ring;
 	int save; /* default not save */
 };
 
-static void PcmKfifoLock(struct PcmFifoS *fifo)
+static void PcmRingLock(struct PcmFifoS *fifo)
 {
+}
+
+static void PcmRingUnlock(struct PcmFifoS *fifo)
+{
+}
+
+/*
+ * The producer can't take data back from the consumer without a lock, so
+ * when the fifo is full the new data is dropped (and counted) whether or not
+ * cover_write is set.
+ */
+static int PcmRingIn(struct PcmFifoS *fifo, void *buf, unsigned int len, int cover_write)
+{
+	int putLen = len;
     struct PcmFifoImpl *impl;
 	impl = (struct PcmFifoImpl *)fifo;
-    OS_MutexLock(&impl->mutex, OS_WAIT_FOREVER);
+
+	if (impl->save) {
+		putLen = spsc_ring_write(&impl->ring, buf, len);
+	}
+    return putLen;
 }
 
-static void PcmKfifoUnlock(struct PcmFifoS *fifo)
+static int PcmRingOut(struct PcmFifoS *fifo, void *buf, unsigned int len)
 {
     struct PcmFifoImpl *impl;
 	impl = (struct PcmFifoImpl *)fifo;
-    OS_MutexUnlock(&impl->mutex);
+    return spsc_ring_read(&impl->ring, buf, len);
 }
 
-static int PcmKfifoIn(struct PcmFifoS *fifo, void *buf, unsigned int len, int cover_write)
+static void *PcmRingReserve(struct PcmFifoS *fifo, unsigned int len)
 {
-	int putLen = len;
-	char buffer[256];
+    uint32_t spanLen = len;
+    void *span;
     struct PcmFifoImpl *impl;
 	impl = (struct PcmFifoImpl *)fifo;
 
-	if (impl->save) {
-		if (cover_write) {
-			int avail;
-			avail = kfifo_avail(&impl->fifo);
-			if (avail < len) {
-				int outLen = len - avail;
-				int tmpLen;
-				while (outLen > 0) {
-					tmpLen = (outLen > 256) ? 256 : outLen;
-					kfifo_out(&impl->fifo, buffer, tmpLen);
-					outLen -= tmpLen;
-				}
-			}
-		}
-		putLen = kfifo_in(&impl->fifo, (char *)buf, len);
+	if (!impl->save) {
+		return NULL;
 	}
-    return putLen;
+	span = spsc_ring_write_span(&impl->ring, &spanLen);
+	return (spanLen >= len) ? span : NULL;
+}
+
+static void PcmRingCommit(struct PcmFifoS *fifo, unsigned int len)
+{
+    struct PcmFifoImpl *impl;
+	impl = (struct PcmFifoImpl *)fifo;
+    spsc_ring_write_commit(&impl->ring, len);
 }
 
-static int PcmKfifoOut(struct PcmFifoS *fifo, void *buf, unsigned int len)
+static const void *PcmRingPeek(struct PcmFifoS *fifo, unsigned int len)
 {
     struct PcmFifoImpl *impl;
 	impl = (struct PcmFifoImpl *)fifo;
-    return kfifo_out(&impl->fifo, (char *)buf, len);
+    return spsc_ring_read_span(&impl->ring, len);
 }
 
-static int PcmKfifoValid(struct PcmFifoS *fifo)
+static void PcmRingRelease(struct PcmFifoS *fifo, unsigned int len)
 {
     struct PcmFifoImpl *impl;
 	impl = (struct PcmFifoImpl *)fifo;
-    return kfifo_len(&impl->fifo);
+    spsc_ring_read_release(&impl->ring, len);
 }
 
-static int PcmKfifoAvail(struct PcmFifoS *fifo)
+static int PcmRingValid(struct PcmFifoS *fifo)
+{
+    struct PcmFifoImpl *impl;
+	impl = (struct PcmFifoImpl *)fifo;
+    return spsc_ring_count(&impl->ring);
+}
+
+static int PcmRingAvail(struct PcmFifoS *fifo)
 {
     struct PcmFifoImpl *impl;
     impl = (struct PcmFifoImpl *)fifo;
-    return kfifo_avail(&impl->fifo);
+    return spsc_ring_space(&impl->ring);
 }
 
-static int PcmKfifoControl(struct PcmFifoS *fifo, PcmFifoCmd cmd, void *param)
+static int PcmRingControl(struct PcmFifoS *fifo, PcmFifoCmd cmd, void *param)
 {
     struct PcmFifoImpl *impl;
     impl = (struct PcmFifoImpl *)fifo;
@@ -119,19 +138,23 @@ static int PcmKfifoControl(struct PcmFifoS *fifo, PcmFifoCmd cmd, void *param)
     return 0;
 }
 
-static const struct PcmFifoOpsS KfifoOps = {
-    .lock = PcmKfifoLock,
-    .unlock = PcmKfifoUnlock,
-    .in = PcmKfifoIn,
-    .out = PcmKfifoOut,
-    .valid = PcmKfifoValid,
-    .avail = PcmKfifoAvail,
-    .control = PcmKfifoControl,
+static const struct PcmFifoOpsS RingOps = {
+    .lock = PcmRingLock,
+    .unlock = PcmRingUnlock,
+    .in = PcmRingIn,
+    .out = PcmRingOut,
+    .reserve = PcmRingReserve,
+    .commit = PcmRingCommit,
+    .peek = PcmRingPeek,
+    .release = PcmRingRelease,
+    .valid = PcmRingValid,
+    .avail = PcmRingAvail,
+    .control = PcmRingControl,
 };
 
-struct PcmFifoS *pcm_fifo_create(int fifo_size)
+struct PcmFifoS *pcm_fifo_create(int fifo_size, int span_max)
 {
-    int ret;
+    void *buf;
     struct PcmFifoImpl *impl;
 
     impl = malloc(sizeof(*impl));
@@ -141,22 +164,16 @@ struct PcmFifoS *pcm_fifo_create(int fifo_size)
     }
     memset(impl, 0, sizeof(*impl));
 
-    ret = kfifo_alloc(&impl->fifo, fifo_size);
-    if (ret) {
-        printf("kfifo alloc fail\n");
+    buf = malloc(fifo_size + span_max);
+    if (buf == NULL) {
+        printf("pcm ring malloc fail\n");
         goto err2;
     }
+    spsc_ring_init(&impl->ring, buf, fifo_size, span_max);
 
-    if (OS_MutexCreate(&impl->mutex) != OS_OK) {
-        printf("mutex create fail\n");
-        goto err3;
-    }
-
-    impl->base.ops = &KfifoOps;
+    impl->base.ops = &RingOps;
     return &impl->base;
 
-err3:
-    kfifo_free(&impl->fifo);
 err2:
     free(impl);
 err1:
@@ -169,10 +186,11 @@ int pcm_fifo_destroy(struct PcmFifoS *fifo)
 
     impl = (struct PcmFifoImpl *)fifo;
 
-    OS_MutexDelete(&impl->mutex);
-    kfifo_free(&impl->fifo);
+    if (impl->ring.overrun) {
+        printf("pcm fifo dropped %u bytes\n", (unsigned int)impl->ring.overrun);
+    }
+    free(impl->ring.buf);
     free(impl);
 
     return 0;
 }
-
@@ -41,11 +41,20 @@ typedef enum PcmFifoCmd {
 
 typedef struct PcmFifoS PcmFifoT;
 
+/*
+ * One producer and one consumer thread may use the fifo at the same time
+ * without locking: in/reserve/commit belong to the producer, out/peek/release
+ * to the consumer. lock/unlock are kept for old callers and do nothing.
+ */
 struct PcmFifoOpsS {
     void (*lock)(PcmFifoT *);
     void (*unlock)(PcmFifoT *);
     int (*in)(PcmFifoT *, void *buf, unsigned int len, int cover_write);
     int (*out)(PcmFifoT *, void *buf, unsigned int len);
+    void *(*reserve)(PcmFifoT *, unsigned int len);  /* room for len bytes to fill in place, NULL if none */
+    void (*commit)(PcmFifoT *, unsigned int len);    /* publish the bytes filled after reserve */
+    const void *(*peek)(PcmFifoT *, unsigned int len); /* next len bytes in place, NULL if not ready */
+    void (*release)(PcmFifoT *, unsigned int len);   /* drop the bytes looked at with peek */
     int (*valid)(PcmFifoT *);    /* get the size of valid data in the fifo */
     int (*avail)(PcmFifoT *);    /* get the remain room of the fifo */
 	int (*control)(PcmFifoT *, PcmFifoCmd cmd, void *param);
@@ -75,6 +84,26 @@ static inline int PcmFifoOut(struct PcmFifoS *fifo, void *buf, unsigned int len)
     return fifo->ops->out(fifo, buf, len);
 }
 
+static inline void *PcmFifoReserve(struct PcmFifoS *fifo, unsigned int len)
+{
+    return fifo->ops->reserve(fifo, len);
+}
+
+static inline void PcmFifoCommit(struct PcmFifoS *fifo, unsigned int len)
+{
+    fifo->ops->commit(fifo, len);
+}
+
+static inline const void *PcmFifoPeek(struct PcmFifoS *fifo, unsigned int len)
+{
+    return fifo->ops->peek(fifo, len);
+}
+
+static inline void PcmFifoRelease(struct PcmFifoS *fifo, unsigned int len)
+{
+    fifo->ops->release(fifo, len);
+}
+
 static inline int PcmFifoValid(struct PcmFifoS *fifo)
 {
     return fifo->ops->valid(fifo);
@@ -90,8 +119,13 @@ static inline int PcmFifoControl(struct PcmFifoS *fifo, PcmFifoCmd cmd, void *pa
     return fifo->ops->control(fifo, cmd, param);
 }
 
-/* return: NON-NULL for success, NULL for error. */
-extern struct PcmFifoS *pcm_fifo_create(int fifo_size);
+/*
+ * A peek across the end of the fifo is copied to span_max spare bytes. When
+ * fifo_size is a multiple of the frame size, frames never cross the end and
+ * span_max can be 0.
+ * return: NON-NULL for success, NULL for error.
+ */
+extern struct PcmFifoS *pcm_fifo_create(int fifo_size, int span_max);
 
 /* return: 0 for success, other for error. */
 extern int pcm_fifo_destroy(struct PcmFifoS *fifo);
@@ -75,11 +75,13 @@ LIBRARIES += -lxrsys
 # other libs
 LIBRARIES += -lcjson
 LIBRARIES += -lfs
+LIBRARIES += -lnorfs
 LIBRARIES += -lconsole
 LIBRARIES += -lcomponent
 LIBRARIES += -lreverb
 LIBRARIES += -laudmgr
 LIBRARIES += -lpcm
+LIBRARIES += -ldsp
 LIBRARIES += -ladt
 LIBRARIES += -lutil
 LIBRARIES += -ljpeg
@@ -0,0 +1,456 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <math.h>
+
+#include "audio/dsp/biquad_eq.h"
+#include "dsp_simd.h"
+
+#define BIQUAD_EQ_ONE			INT32_MAX	/* unity preamp, Q31 */
+#define BIQUAD_EQ_IN_SHIFT		(16 - BIQUAD_EQ_HEADROOM)	/* pcm to the cascade */
+#define BIQUAD_EQ_STEPS			(BIQUAD_EQ_RAMP / BIQUAD_EQ_RAMP_STEP)
+#define BIQUAD_EQ_GAIN_MAX		24.0f	/* dB of a band */
+#define BIQUAD_EQ_GRID			64		/* frequencies the peak gain is looked for at */
+
+static __inline int32_t biquad_sat32(int64_t x)
+{
+	return (int32_t)(x > INT32_MAX ? INT32_MAX : (x < INT32_MIN ? INT32_MIN : x));
+}
+
+/* b0 b1 b2 a1 a2 normalized to a0, from the audio EQ cookbook */
+static int biquad_design(const eq_core_prms_t *prms, uint32_t rate, float *c)
+{
+	float A, w0, cs, sn, alpha, sq, g, a0;
+
+	if (prms->fc <= 0 || (uint32_t)prms->fc * 2 >= rate || prms->Q <= 0.0f ||
+	    prms->G > BIQUAD_EQ_GAIN_MAX || prms->G < -BIQUAD_EQ_GAIN_MAX)
+		return -1;
+
+	A = powf(10.0f, prms->G / 40.0f);
+	w0 = 2.0f * (float)M_PI * prms->fc / rate;
+	cs = cosf(w0);
+	sn = sinf(w0);
+	alpha = sn / (2.0f * prms->Q);
+	sq = 2.0f * sqrtf(A) * alpha;
+
+	switch (prms->type) {
+	case BANDPASS_PEAK:
+		c[0] = 1.0f + alpha * A;
+		c[1] = -2.0f * cs;
+		c[2] = 1.0f - alpha * A;
+		a0 = 1.0f + alpha / A;
+		c[3] = -2.0f * cs;
+		c[4] = 1.0f - alpha / A;
+		break;
+	case LOWPASS_SHELVING:
+		c[0] = A * ((A + 1.0f) - (A - 1.0f) * cs + sq);
+		c[1] = 2.0f * A * ((A - 1.0f) - (A + 1.0f) * cs);
+		c[2] = A * ((A + 1.0f) - (A - 1.0f) * cs - sq);
+		a0 = (A + 1.0f) + (A - 1.0f) * cs + sq;
+		c[3] = -2.0f * ((A - 1.0f) + (A + 1.0f) * cs);
+		c[4] = (A + 1.0f) + (A - 1.0f) * cs - sq;
+		break;
+	case HIHPASS_SHELVING:
+		c[0] = A * ((A + 1.0f) + (A - 1.0f) * cs + sq);
+		c[1] = -2.0f * A * ((A - 1.0f) + (A + 1.0f) * cs);
+		c[2] = A * ((A + 1.0f) + (A - 1.0f) * cs - sq);
+		a0 = (A + 1.0f) - (A - 1.0f) * cs + sq;
+		c[3] = 2.0f * ((A - 1.0f) - (A + 1.0f) * cs);
+		c[4] = (A + 1.0f) - (A - 1.0f) * cs - sq;
+		break;
+	case LOWPASS:
+	case HIGHPASS:
+		/* G is the pass band gain */
+		g = A * A;
+		if (prms->type == LOWPASS) {
+			c[0] = g * (1.0f - cs) / 2.0f;
+			c[1] = g * (1.0f - cs);
+		} else {
+			c[0] = g * (1.0f + cs) / 2.0f;
+			c[1] = -g * (1.0f + cs);
+		}
+		c[2] = c[0];
+		a0 = 1.0f + alpha;
+		c[3] = -2.0f * cs;
+		c[4] = 1.0f - alpha;
+		break;
+	default:
+		return -1;
+	}
+
+	c[0] /= a0;
+	c[1] /= a0;
+	c[2] /= a0;
+	c[3] /= a0;
+	c[4] /= a0;
+	return 0;
+}
+
+/* to Q(31 - shift), shift the least for the largest coefficient */
+static void biquad_quantize(const float *c, int32_t *q, int32_t *shift)
+{
+	float max = 0.0f, v;
+	int32_t s = 1, i;
+
+	for (i = 0; i < 5; ++i) {
+		v = fabsf(c[i]);
+		if (v > max)
+			max = v;
+	}
+	while (max >= (float)(1 << s))
+		s++;
+
+	for (i = 0; i < 5; ++i) {
+		v = ldexpf(i < 3 ? c[i] : -c[i], 31 - s);
+		q[i] = biquad_sat32((int64_t)llrintf(v));
+	}
+	*shift = s;
+}
+
+static int biquad_is_flat(const int32_t *q, int32_t shift)
+{
+	return q[0] == (1 << (31 - shift)) && !q[1] && !q[2] && !q[3] && !q[4];
+}
+
+static void biquad_band_flat(struct biquad_band *band)
+{
+	band->coef[0] = 1 << 30;
+	band->coef[1] = band->coef[2] = band->coef[3] = band->coef[4] = 0;
+	band->shift = 1;
+	memcpy(band->target, band->coef, sizeof(band->target));
+	band->target_shift = 1;
+	band->steps = 0;
+	band->flat = 1;
+	band->prms.G = 0.0f;
+	band->prms.fc = 1000;
+	band->prms.Q = 1.0f;
+	band->prms.type = BANDPASS_PEAK;
+}
+
+/* |H| of the cascade at f Hz */
+static float biquad_eq_gain_at(const biquad_eq_t *eq, float f)
+{
+	float c[5], w = 2.0f * (float)M_PI * f / eq->rate;
+	float c1 = cosf(w), s1 = sinf(w), c2 = cosf(2.0f * w), s2 = sinf(2.0f * w);
+	float nr, ni, dr, di, g = 1.0f;
+	uint32_t i;
+
+	for (i = 0; i < eq->bands; ++i) {
+		if (biquad_design(&eq->band[i].prms, eq->rate, c) != 0)
+			continue;
+		nr = c[0] + c[1] * c1 + c[2] * c2;
+		ni = -c[1] * s1 - c[2] * s2;
+		dr = 1.0f + c[3] * c1 + c[4] * c2;
+		di = -c[3] * s1 - c[4] * s2;
+		g *= sqrtf((nr * nr + ni * ni) / (dr * dr + di * di));
+	}
+	return g;
+}
+
+/**
+ * @brief Highest gain of the cascade as set (its targets while ramping)
+ * @return Linear gain, from a grid of frequencies and the band centers
+ */
+float biquad_eq_peak_gain(const biquad_eq_t *eq)
+{
+	float f, g, peak = 0.0f, ratio;
+	uint32_t i;
+
+	ratio = powf(eq->rate / 2.0f / 20.0f, 1.0f / (BIQUAD_EQ_GRID - 1));
+	for (i = 0, f = 20.0f; i < BIQUAD_EQ_GRID; ++i, f *= ratio) {
+		g = biquad_eq_gain_at(eq, f);
+		if (g > peak)
+			peak = g;
+	}
+	for (i = 0; i < eq->bands; ++i) {
+		g = biquad_eq_gain_at(eq, (float)eq->band[i].prms.fc);
+		if (g > peak)
+			peak = g;
+	}
+	return peak;
+}
+
+static void biquad_eq_start_ramp(biquad_eq_t *eq)
+{
+	if (!eq->ramping) {
+		eq->ramping = 1;
+		eq->ramp_left = BIQUAD_EQ_RAMP_STEP;
+	}
+}
+
+static void biquad_eq_update_preamp(biquad_eq_t *eq)
+{
+	float g = powf(10.0f, eq->preamp_db / 20.0f), peak;
+	int32_t target;
+
+	if (eq->auto_headroom) {
+		peak = biquad_eq_peak_gain(eq);
+		if (peak * g > 1.0f)
+			g = 1.0f / peak;
+	}
+	target = g >= 1.0f ? BIQUAD_EQ_ONE : (int32_t)ldexpf(g, 31);
+	if (target == eq->preamp_target)
+		return;
+
+	eq->preamp_target = target;
+	if (!eq->running) {
+		eq->preamp = target;
+		eq->preamp_steps = 0;
+		return;
+	}
+	eq->preamp_delta = (target - eq->preamp) / BIQUAD_EQ_STEPS;
+	eq->preamp_steps = BIQUAD_EQ_STEPS;
+	biquad_eq_start_ramp(eq);
+}
+
+/**
+ * @brief Set up an equalizer with every band flat
+ * @param[in] eq Equalizer state
+ * @param[in] rate Sample rate
+ * @param[in] channels 1 or 2, interleaved
+ * @param[in] bands Bands in use, up to BIQUAD_EQ_BANDS_MAX
+ * @return 0 on success, -1 on invalid parameters
+ */
+int biquad_eq_init(biquad_eq_t *eq, uint32_t rate, uint32_t channels, uint32_t bands)
+{
+	uint32_t i;
+
+	if (rate == 0 || channels == 0 || channels > BIQUAD_EQ_CHANNELS_MAX ||
+	    bands > BIQUAD_EQ_BANDS_MAX)
+		return -1;
+
+	memset(eq, 0, sizeof(*eq));
+	eq->rate = rate;
+	eq->channels = channels;
+	eq->bands = bands;
+	eq->preamp = BIQUAD_EQ_ONE;
+	eq->preamp_target = BIQUAD_EQ_ONE;
+	for (i = 0; i < BIQUAD_EQ_BANDS_MAX; ++i)
+		biquad_band_flat(&eq->band[i]);
+	return 0;
+}
+
+/**
+ * @brief Change a band
+ * @param[in] eq Equalizer state
+ * @param[in] band Band index
+ * @param[in] prms Filter of the band, as for libeq
+ * @return 0 on success, -1 on invalid parameters (the band is left as it is)
+ *
+ * Takes effect at once before the first biquad_eq_process() after init or
+ * reset, else ramps over BIQUAD_EQ_RAMP frames.
+ */
+int biquad_eq_set_band(biquad_eq_t *eq, uint32_t band, const eq_core_prms_t *prms)
+{
+	struct biquad_band *b;
+	float c[5];
+	int32_t s, i;
+
+	if (band >= eq->bands || biquad_design(prms, eq->rate, c) != 0)
+		return -1;
+
+	b = &eq->band[band];
+	b->prms = *prms;
+	biquad_quantize(c, b->target, &b->target_shift);
+
+	if (!eq->running) {
+		memcpy(b->coef, b->target, sizeof(b->coef));
+		b->shift = b->target_shift;
+		b->steps = 0;
+		b->flat = biquad_is_flat(b->coef, b->shift);
+	} else {
+		/* ramp in the wider format of the two, back to the target's at the end */
+		s = b->target_shift > b->shift ? b->target_shift : b->shift;
+		for (i = 0; i < 5; ++i) {
+			b->coef[i] >>= s - b->shift;
+			b->delta[i] = ((b->target[i] >> (s - b->target_shift)) - b->coef[i]) /
+			              BIQUAD_EQ_STEPS;
+		}
+		b->shift = s;
+		b->steps = BIQUAD_EQ_STEPS;
+		b->flat = 0;
+		biquad_eq_start_ramp(eq);
+	}
+
+	biquad_eq_update_preamp(eq);
+	return 0;
+}
+
+/**
+ * @brief Set the gain ahead of the bands
+ * @param[in] eq Equalizer state
+ * @param[in] db Gain in dB, 0 or less
+ * @param[in] auto_headroom Lower it further so the peak gain of the bands
+ *            makes no more than full scale; kept up to date by
+ *            biquad_eq_set_band()
+ */
+void biquad_eq_set_preamp(biquad_eq_t *eq, float db, int auto_headroom)
+{
+	eq->preamp_db = db > 0.0f ? 0.0f : db;
+	eq->auto_headroom = auto_headroom;
+	biquad_eq_update_preamp(eq);
+}
+
+/**
+ * @brief Forget the history, e.g. on a seek or a new stream; ramps end
+ */
+void biquad_eq_reset(biquad_eq_t *eq)
+{
+	struct biquad_band *b;
+	uint32_t i;
+
+	for (i = 0; i < eq->bands; ++i) {
+		b = &eq->band[i];
+		memcpy(b->coef, b->target, sizeof(b->coef));
+		b->shift = b->target_shift;
+		b->steps = 0;
+		b->flat = biquad_is_flat(b->coef, b->shift);
+	}
+	eq->preamp = eq->preamp_target;
+	eq->preamp_steps = 0;
+	eq->ramping = 0;
+	eq->running = 0;
+	memset(eq->state, 0, sizeof(eq->state));
+}
+
+static void biquad_eq_step(biquad_eq_t *eq)
+{
+	struct biquad_band *b;
+	uint32_t i, j;
+	int ramping = 0;
+
+	for (i = 0; i < eq->bands; ++i) {
+		b = &eq->band[i];
+		if (!b->steps)
+			continue;
+		if (--b->steps == 0) {
+			memcpy(b->coef, b->target, sizeof(b->coef));
+			b->shift = b->target_shift;
+			b->flat = biquad_is_flat(b->coef, b->shift);
+		} else {
+			for (j = 0; j < 5; ++j)
+				b->coef[j] += b->delta[j];
+			ramping = 1;
+		}
+	}
+	if (eq->preamp_steps) {
+		if (--eq->preamp_steps == 0) {
+			eq->preamp = eq->preamp_target;
+		} else {
+			eq->preamp += eq->preamp_delta;
+			ramping = 1;
+		}
+	}
+	eq->ramping = ramping;
+	eq->ramp_left = BIQUAD_EQ_RAMP_STEP;
+}
+
+/*
+ * One band over one channel of the block. Five 32x32 multiply-accumulates
+ * into 64 bits per sample, single cycle each (SMLAL) on cortex-m4.
+ */
+static void biquad_band_run(const struct biquad_band *b, int32_t *st,
+                            int32_t *p, uint32_t n, uint32_t stride)
+{
+	const int32_t b0 = b->coef[0], b1 = b->coef[1], b2 = b->coef[2];
+	const int32_t a1 = b->coef[3], a2 = b->coef[4];
+	const int32_t rsh = 31 - b->shift;
+	const int64_t round = (int64_t)1 << (rsh - 1);
+	int32_t x1 = st[0], x2 = st[1], y1 = st[2], y2 = st[3], x0;
+	int64_t acc;
+
+	for (; n; --n, p += stride) {
+		x0 = *p;
+		acc = round + (int64_t)b0 * x0 + (int64_t)b1 * x1 + (int64_t)b2 * x2 +
+		      (int64_t)a1 * y1 + (int64_t)a2 * y2;
+		x2 = x1;
+		x1 = x0;
+		y2 = y1;
+		y1 = biquad_sat32(acc >> rsh);
+		*p = y1;
+	}
+	st[0] = x1;
+	st[1] = x2;
+	st[2] = y1;
+	st[3] = y2;
+}
+
+/**
+ * @brief Equalize a buffer in place
+ * @param[in] eq Equalizer state
+ * @param[in,out] pcm Interleaved frames
+ * @param[in] frames Frames in pcm
+ */
+void biquad_eq_process(biquad_eq_t *eq, int16_t *pcm, uint32_t frames)
+{
+	uint32_t ch = eq->channels, n, i, c, k;
+	int32_t *buf = eq->buf, *st;
+
+	eq->running = 1;
+	while (frames) {
+		n = frames < BIQUAD_EQ_BLOCK ? frames : BIQUAD_EQ_BLOCK;
+		if (eq->ramping && n > eq->ramp_left)
+			n = eq->ramp_left;
+
+		if (eq->preamp == BIQUAD_EQ_ONE) {
+			for (i = 0; i < n * ch; ++i)
+				buf[i] = (int32_t)pcm[i] << BIQUAD_EQ_IN_SHIFT;
+		} else {
+			for (i = 0; i < n * ch; ++i)
+				buf[i] = (int32_t)(((int64_t)pcm[i] * eq->preamp) >> (31 - BIQUAD_EQ_IN_SHIFT));
+		}
+
+		for (k = 0; k < eq->bands; ++k) {
+			for (c = 0; c < ch; ++c) {
+				st = eq->state[k][c];
+				if (!eq->band[k].flat) {
+					biquad_band_run(&eq->band[k], st, buf + c, n, ch);
+				} else {
+					/* pass-through, keep the history for when it is not */
+					st[1] = n > 1 ? buf[(n - 2) * ch + c] : st[0];
+					st[0] = buf[(n - 1) * ch + c];
+					st[2] = st[0];
+					st[3] = st[1];
+				}
+			}
+		}
+
+		for (i = 0; i < n * ch; ++i)
+			pcm[i] = dsp_sat16((buf[i] + (1 << (BIQUAD_EQ_IN_SHIFT - 1))) >> BIQUAD_EQ_IN_SHIFT);
+
+		pcm += n * ch;
+		frames -= n;
+		if (eq->ramping) {
+			eq->ramp_left -= n;
+			if (eq->ramp_left == 0)
+				biquad_eq_step(eq);
+		}
+	}
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _DSP_SIMD_H_
+#define _DSP_SIMD_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__CONFIG_CPU_CM4F)
+#include "driver/chip/chip.h"	/* cmsis __SMLAD, __SSAT */
+#define DSP_SIMD	1
+#else
+#define DSP_SIMD	0
+#endif
+
+/* two int16 from any 2-byte aligned address, cortex-m4 loads it unaligned */
+static __inline uint32_t dsp_rd32(const int16_t *p)
+{
+	uint32_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static __inline int16_t dsp_sat16(int32_t x)
+{
+#if DSP_SIMD
+	return (int16_t)__SSAT(x, 16);
+#else
+	return (int16_t)(x > 32767 ? 32767 : (x < -32768 ? -32768 : x));
+#endif
+}
+
+/* sum of x[i] * h[i], n a multiple of 4: one SMLAD per two products */
+static __inline int32_t dsp_dot16(const int16_t *x, const int16_t *h, uint32_t n)
+{
+	int32_t acc = 0;
+
+	for (; n; n -= 4, x += 4, h += 4) {
+#if DSP_SIMD
+		acc = (int32_t)__SMLAD(dsp_rd32(x), dsp_rd32(h), (uint32_t)acc);
+		acc = (int32_t)__SMLAD(dsp_rd32(x + 2), dsp_rd32(h + 2), (uint32_t)acc);
+#else
+		acc += x[0] * h[0] + x[1] * h[1] + x[2] * h[2] + x[3] * h[3];
+#endif
+	}
+	return acc;
+}
+
+#endif /* _DSP_SIMD_H_ */
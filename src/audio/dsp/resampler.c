@@ -0,0 +1,260 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <math.h>
+
+#include "audio/dsp/resampler.h"
+#include "dsp_simd.h"
+
+#define RESAMPLER_COEF_ONE		(1 << 14)
+#define RESAMPLER_CUTOFF		0.86f	/* of the lower Nyquist frequency */
+#define RESAMPLER_KAISER_BETA	7.0f	/* ~70 dB stop band from the Nyquist frequency */
+#define RESAMPLER_BUF_FRAMES	(RESAMPLER_TAPS_MAX + RESAMPLER_BLOCK)
+
+static uint32_t resampler_gcd(uint32_t a, uint32_t b)
+{
+	uint32_t t;
+
+	while (b) {
+		t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+/* zeroth order modified Bessel function of the first kind */
+static float resampler_bessel_i0(float x)
+{
+	float sum = 1.0f, term = 1.0f, q = x * x / 4.0f;
+	int k;
+
+	for (k = 1; k < 32 && term > sum * 1e-8f; ++k) {
+		term *= q / (float)(k * k);
+		sum += term;
+	}
+	return sum;
+}
+
+/* fill a row of the table: the filter taken at phase between input frames */
+static void resampler_design_row(int16_t *row, uint32_t taps, float phase, float fc)
+{
+	float h[RESAMPLER_TAPS_MAX];
+	float half = (float)(taps / 2);
+	float i0_beta = resampler_bessel_i0(RESAMPLER_KAISER_BETA);
+	float t, x, w, sum = 0.0f;
+	int32_t q, qsum = 0, center = taps / 2 - 1;
+	uint32_t j;
+
+	for (j = 0; j < taps; ++j) {
+		t = (float)j - (half - 1.0f) - phase;
+		x = t / half;
+		if (x <= -1.0f || x >= 1.0f) {
+			h[j] = 0.0f;
+			continue;
+		}
+		w = resampler_bessel_i0(RESAMPLER_KAISER_BETA * sqrtf(1.0f - x * x)) / i0_beta;
+		x = 2.0f * (float)M_PI * fc * t;
+		h[j] = w * (t == 0.0f ? 1.0f : sinf(x) / x);
+		sum += h[j];
+	}
+
+	/* unity gain at every phase, so no ripple at the phase rate */
+	for (j = 0; j < taps; ++j) {
+		q = (int32_t)lrintf(h[j] * RESAMPLER_COEF_ONE / sum);
+		row[j] = (int16_t)q;
+		qsum += q;
+	}
+	if (phase >= 0.5f)
+		center++;
+	row[center] += RESAMPLER_COEF_ONE - qsum;
+}
+
+/**
+ * @brief Set up a converter, clearing its history
+ * @param[in] rs Converter state
+ * @param[in] in_rate Input sample rate
+ * @param[in] out_rate Output sample rate
+ * @param[in] channels 1 or 2, interleaved
+ * @return 0 on success, -1 on invalid parameters
+ *
+ * May be called again on the same state to change the rates; it does not
+ * allocate anything.
+ */
+int resampler_init(resampler_t *rs, uint32_t in_rate, uint32_t out_rate, uint32_t channels)
+{
+	uint32_t g, taps, phases, i;
+	float fc;
+
+	if (in_rate < RESAMPLER_RATE_MIN || in_rate > RESAMPLER_RATE_MAX ||
+	    out_rate < RESAMPLER_RATE_MIN || out_rate > RESAMPLER_RATE_MAX ||
+	    channels == 0 || channels > RESAMPLER_CHANNELS_MAX)
+		return -1;
+
+	g = resampler_gcd(in_rate, out_rate);
+	rs->in_rate = in_rate;
+	rs->out_rate = out_rate;
+	rs->channels = channels;
+	rs->l = out_rate / g;
+	rs->m = in_rate / g;
+	rs->step = rs->m / rs->l;
+	rs->frac_step = rs->m % rs->l;
+
+	/* the filter spans the same time at the output rate whichever the ratio */
+	taps = RESAMPLER_TAPS;
+	fc = 0.5f * RESAMPLER_CUTOFF;
+	if (in_rate > out_rate) {
+		taps = (RESAMPLER_TAPS * in_rate / out_rate + 3) & ~3U;
+		if (taps > RESAMPLER_TAPS_MAX)
+			taps = RESAMPLER_TAPS_MAX;
+		fc = fc * out_rate / in_rate;
+	}
+	if (taps * 2 > RESAMPLER_COEF_MAX)
+		taps = (RESAMPLER_COEF_MAX / 2) & ~3U;
+	rs->taps = taps;
+
+	if (rs->l * taps <= RESAMPLER_COEF_MAX) {
+		/* every phase of the ratio */
+		phases = rs->l;
+		rs->interp = 0;
+		for (i = 0; i < phases; ++i)
+			resampler_design_row(rs->coef + i * taps, taps, (float)i / phases, fc);
+	} else {
+		phases = 1;
+		while ((phases * 2 + 1) * taps <= RESAMPLER_COEF_MAX)
+			phases *= 2;
+		rs->interp = 1;
+		rs->scale = (uint32_t)(((uint64_t)phases << 32) / rs->l);
+		for (i = 0; i <= phases; ++i)
+			resampler_design_row(rs->coef + i * taps, taps, (float)i / phases, fc);
+	}
+	rs->phases = phases;
+
+	resampler_reset(rs);
+	return 0;
+}
+
+/**
+ * @brief Forget the history, e.g. on a seek or after a flush
+ */
+void resampler_reset(resampler_t *rs)
+{
+	memset(rs->buf, 0, sizeof(rs->buf));
+	rs->fill = rs->taps / 2 - 1;	/* the first output is on the first input */
+	rs->pos = 0;
+	rs->frac = 0;
+}
+
+/**
+ * @brief Most frames resampler_process() can give for in_frames of input
+ */
+uint32_t resampler_out_frames(const resampler_t *rs, uint32_t in_frames)
+{
+	return (uint32_t)(((uint64_t)(in_frames + rs->fill) * rs->l) / rs->m) + 1;
+}
+
+static __inline int16_t resampler_filter(const resampler_t *rs, const int16_t *x)
+{
+	const int16_t *h;
+	uint32_t p;
+	int32_t a, b;
+
+	if (!rs->interp)
+		return dsp_sat16((dsp_dot16(x, rs->coef + rs->frac * rs->taps, rs->taps) +
+		                  (RESAMPLER_COEF_ONE >> 1)) >> 14);
+
+	p = (uint32_t)(((uint64_t)rs->frac * rs->scale) >> 17);	/* Q15 */
+	h = rs->coef + (p >> 15) * rs->taps;
+	a = dsp_dot16(x, h, rs->taps);
+	b = dsp_dot16(x, h + rs->taps, rs->taps);
+	a += (int32_t)(((int64_t)(b - a) * (p & 0x7FFF)) >> 15);
+	return dsp_sat16((a + (RESAMPLER_COEF_ONE >> 1)) >> 14);
+}
+
+/**
+ * @brief Convert a buffer
+ * @param[in] rs Converter state
+ * @param[in] in Input frames
+ * @param[in,out] in_frames Input frames given, on return frames taken
+ * @param[out] out Output frames
+ * @param[in,out] out_frames Room for output frames, on return frames given
+ *
+ * All the input is taken unless the output fills up first, see
+ * resampler_out_frames(). Input is taken ahead by half the filter, so the
+ * output follows it by that much.
+ */
+void resampler_process(resampler_t *rs, const int16_t *in, uint32_t *in_frames,
+                       int16_t *out, uint32_t *out_frames)
+{
+	uint32_t in_left = *in_frames, out_left = *out_frames;
+	uint32_t n, i, ch = rs->channels, taps = rs->taps;
+
+	for (;;) {
+		while (out_left && rs->pos + taps <= rs->fill) {
+			for (i = 0; i < ch; ++i)
+				*out++ = resampler_filter(rs, rs->buf[i] + rs->pos);
+			out_left--;
+			rs->pos += rs->step;
+			rs->frac += rs->frac_step;
+			if (rs->frac >= rs->l) {
+				rs->frac -= rs->l;
+				rs->pos++;
+			}
+		}
+		if (out_left == 0 || in_left == 0)
+			break;
+
+		/* drop the frames behind the filter, then take more input */
+		n = rs->pos < rs->fill ? rs->pos : rs->fill;
+		if (n) {
+			for (i = 0; i < ch; ++i)
+				memmove(rs->buf[i], rs->buf[i] + n, (rs->fill - n) * sizeof(int16_t));
+			rs->fill -= n;
+			rs->pos -= n;
+		}
+		n = RESAMPLER_BUF_FRAMES - rs->fill;
+		if (n > in_left)
+			n = in_left;
+		if (ch == 1) {
+			memcpy(rs->buf[0] + rs->fill, in, n * sizeof(int16_t));
+			in += n;
+		} else {
+			for (i = 0; i < n; ++i, in += 2) {
+				rs->buf[0][rs->fill + i] = in[0];
+				rs->buf[1][rs->fill + i] = in[1];
+			}
+		}
+		rs->fill += n;
+		in_left -= n;
+	}
+
+	*in_frames -= in_left;
+	*out_frames -= out_left;
+}
@@ -0,0 +1,460 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "audio/dsp/rfft.h"
+#include "rfft_tab.h"
+
+/*
+ * Stages of the complex FFT. A radix-4 butterfly writes its outputs in the
+ * order 0, 2, 1, 3, so the result comes out in plain bit-reversed order
+ * whatever the mix of radix-4 and radix-2 stages.
+ *
+ * Forward, each stage scales its result by 1/2 per bit of radix, the first
+ * one by a further 1/2 so no rotated value can pass full scale; the split
+ * pass takes that back. The inverse runs the same stages on the conjugate,
+ * unscaled but for 1/2 in the first stage, doubled again at the end.
+ */
+
+#define RFFT_TAB_BITS	10	/* log2(RFFT_TAB_SIZE) */
+
+/* x / 2^sh rounded, without overflowing on full scale */
+#define RFFT_RSH(x, sh)	((sh) ? ((x) >> (sh)) + (((x) >> ((sh) - 1)) & 1) : (x))
+
+static __inline uint32_t rfft_bitrev(uint32_t i, uint32_t bits)
+{
+#if RFFT_RBIT
+	return __RBIT(i) >> (32 - bits);
+#else
+	return ((uint32_t)rfft_rev8[i & 0xFF] << 8 | rfft_rev8[i >> 8]) >> (16 - bits);
+#endif
+}
+
+/* cos and sin of 2 * pi * t / RFFT_SIZE_MAX */
+static __inline void rfft_tw_q31(uint32_t t, int32_t *c, int32_t *s)
+{
+	const int32_t *tab = rfft_sin_q31;
+	uint32_t r = t & (RFFT_TAB_SIZE - 1);
+
+	switch (t >> RFFT_TAB_BITS) {
+	case 0:
+		*c = tab[RFFT_TAB_SIZE - r];
+		*s = tab[r];
+		break;
+	case 1:
+		*c = -tab[r];
+		*s = tab[RFFT_TAB_SIZE - r];
+		break;
+	case 2:
+		*c = -tab[RFFT_TAB_SIZE - r];
+		*s = -tab[r];
+		break;
+	default:
+		*c = tab[r];
+		*s = -tab[RFFT_TAB_SIZE - r];
+		break;
+	}
+}
+
+static __inline void rfft_tw_q15(uint32_t t, int32_t *c, int32_t *s)
+{
+	const int16_t *tab = rfft_sin_q15;
+	uint32_t r = t & (RFFT_TAB_SIZE - 1);
+
+	switch (t >> RFFT_TAB_BITS) {
+	case 0:
+		*c = tab[RFFT_TAB_SIZE - r];
+		*s = tab[r];
+		break;
+	case 1:
+		*c = -tab[r];
+		*s = tab[RFFT_TAB_SIZE - r];
+		break;
+	case 2:
+		*c = -tab[RFFT_TAB_SIZE - r];
+		*s = -tab[r];
+		break;
+	default:
+		*c = tab[r];
+		*s = -tab[RFFT_TAB_SIZE - r];
+		break;
+	}
+}
+
+/* a * b + c * d, Q31 */
+static __inline int32_t rfft_mac_q31(int32_t a, int32_t b, int32_t c, int32_t d)
+{
+	return (int32_t)(((int64_t)a * b + (int64_t)c * d + (1 << 30)) >> 31);
+}
+
+static __inline int32_t rfft_sat32(int64_t x)
+{
+	return (int32_t)(x > INT32_MAX ? INT32_MAX : (x < INT32_MIN ? INT32_MIN : x));
+}
+
+/**
+ * @brief Check the size and set up a transform
+ * @param[in] fft Transform to set up
+ * @param[in] n Real points, a power of 2 from RFFT_SIZE_MIN to RFFT_SIZE_MAX
+ * @return 0 on success, -1 on an invalid size
+ */
+int rfft_init(rfft_t *fft, uint32_t n)
+{
+	uint32_t bits = 0;
+
+	if (n < RFFT_SIZE_MIN || n > RFFT_SIZE_MAX || (n & (n - 1)))
+		return -1;
+	while ((2U << bits) < n)
+		bits++;
+	fft->n = n;
+	fft->bits = bits;
+	fft->stride = RFFT_SIZE_MAX / n;
+	return 0;
+}
+
+static void rfft_cfft_q31(int32_t *x, uint32_t bits, uint32_t sh, uint32_t sh4)
+{
+	uint32_t m = 1 << bits, l, q, k, g, i, j, step;
+	int32_t c1, s1, c2, s2, c3, s3, t;
+	int32_t ar, ai, br, bi, cr, ci, dr, di;
+	int32_t t0r, t0i, t1r, t1i, t2r, t2i, t3r, t3i, yr, yi;
+	int32_t *p0, *p1, *p2, *p3;
+
+	for (l = m; l >= 4; l >>= 2) {
+		q = l >> 2;
+		step = RFFT_SIZE_MAX / l;
+		for (k = 0; k < q; k++) {
+			rfft_tw_q31(k * step, &c1, &s1);
+			rfft_tw_q31(2 * k * step, &c2, &s2);
+			rfft_tw_q31(3 * k * step, &c3, &s3);
+			for (g = k; g < m; g += l) {
+				p0 = x + 2 * g;
+				p1 = p0 + 2 * q;
+				p2 = p1 + 2 * q;
+				p3 = p2 + 2 * q;
+				ar = RFFT_RSH(p0[0], sh);
+				ai = RFFT_RSH(p0[1], sh);
+				br = RFFT_RSH(p1[0], sh);
+				bi = RFFT_RSH(p1[1], sh);
+				cr = RFFT_RSH(p2[0], sh);
+				ci = RFFT_RSH(p2[1], sh);
+				dr = RFFT_RSH(p3[0], sh);
+				di = RFFT_RSH(p3[1], sh);
+				t0r = ar + cr;
+				t0i = ai + ci;
+				t1r = ar - cr;
+				t1i = ai - ci;
+				t2r = br + dr;
+				t2i = bi + di;
+				t3r = br - dr;
+				t3i = bi - di;
+
+				p0[0] = t0r + t2r;
+				p0[1] = t0i + t2i;
+				/* x * (c - js) */
+				yr = t0r - t2r;
+				yi = t0i - t2i;
+				p1[0] = rfft_mac_q31(yr, c2, yi, s2);
+				p1[1] = rfft_mac_q31(yi, c2, -yr, s2);
+				yr = t1r + t3i;
+				yi = t1i - t3r;
+				p2[0] = rfft_mac_q31(yr, c1, yi, s1);
+				p2[1] = rfft_mac_q31(yi, c1, -yr, s1);
+				yr = t1r - t3i;
+				yi = t1i + t3r;
+				p3[0] = rfft_mac_q31(yr, c3, yi, s3);
+				p3[1] = rfft_mac_q31(yi, c3, -yr, s3);
+			}
+		}
+		sh = sh4;
+	}
+
+	if (bits & 1) {
+		sh = sh4 >> 1;
+		for (p0 = x; p0 < x + 2 * m; p0 += 4) {
+			ar = RFFT_RSH(p0[0], sh);
+			ai = RFFT_RSH(p0[1], sh);
+			br = RFFT_RSH(p0[2], sh);
+			bi = RFFT_RSH(p0[3], sh);
+			p0[0] = ar + br;
+			p0[1] = ai + bi;
+			p0[2] = ar - br;
+			p0[3] = ai - bi;
+		}
+	}
+
+	for (i = 1; i < m - 1; i++) {
+		j = rfft_bitrev(i, bits);
+		if (i < j) {
+			t = x[2 * i];
+			x[2 * i] = x[2 * j];
+			x[2 * j] = t;
+			t = x[2 * i + 1];
+			x[2 * i + 1] = x[2 * j + 1];
+			x[2 * j + 1] = t;
+		}
+	}
+}
+
+/**
+ * @brief Forward transform, Q31
+ * @param[in] fft Transform
+ * @param[in,out] buf n real samples in, the packed spectrum / n out
+ */
+void rfft_q31(const rfft_t *fft, int32_t *buf)
+{
+	uint32_t m = fft->n >> 1, k;
+	int32_t *a, *b, c, s, evr, evi, odr, odi;
+	int64_t p, q;
+
+	rfft_cfft_q31(buf, fft->bits, 3, 2);
+
+	/* Z is the spectrum of the even samples + j odd ones, / n */
+	evr = buf[0];
+	evi = buf[1];
+	buf[0] = rfft_sat32((int64_t)evr + evi);
+	buf[1] = rfft_sat32((int64_t)evr - evi);
+
+	for (k = 1; k <= m / 2; k++) {
+		a = buf + 2 * k;
+		b = buf + 2 * (m - k);
+		evr = (int32_t)(((int64_t)a[0] + b[0]) >> 1);
+		evi = (int32_t)(((int64_t)a[1] - b[1]) >> 1);
+		odr = (int32_t)(((int64_t)a[0] - b[0]) >> 1);
+		odi = (int32_t)(((int64_t)a[1] + b[1]) >> 1);
+		rfft_tw_q31(k * fft->stride, &c, &s);
+		/* X[k] = e - j W o, X[m - k] = conj(e) - j conj(W o) */
+		p = (int64_t)c * odi - (int64_t)s * odr + (1 << 30);
+		q = (int64_t)c * odr + (int64_t)s * odi + (1 << 30);
+		a[0] = rfft_sat32((((int64_t)evr << 31) + p) >> 31);
+		a[1] = rfft_sat32((((int64_t)evi << 31) - q) >> 31);
+		b[0] = rfft_sat32((((int64_t)evr << 31) - p) >> 31);
+		b[1] = rfft_sat32((-((int64_t)evi << 31) - q) >> 31);
+	}
+}
+
+/**
+ * @brief Inverse transform, Q31
+ * @param[in] fft Transform
+ * @param[in,out] buf Packed spectrum in, n real samples out
+ */
+void rifft_q31(const rfft_t *fft, int32_t *buf)
+{
+	uint32_t m = fft->n >> 1, k;
+	int32_t *a, *b, c, s, evr, evi, odr, odi;
+	int64_t p, q;
+
+	/* back to Z, conjugated for the forward stages */
+	evr = buf[0];
+	evi = buf[1];
+	buf[0] = rfft_sat32((int64_t)evr + evi);
+	buf[1] = -rfft_sat32((int64_t)evr - evi);
+
+	for (k = 1; k <= m / 2; k++) {
+		a = buf + 2 * k;
+		b = buf + 2 * (m - k);
+		evr = a[0] + b[0];
+		evi = a[1] - b[1];
+		odr = a[0] - b[0];
+		odi = a[1] + b[1];
+		rfft_tw_q31(k * fft->stride, &c, &s);
+		/* Z[k] = e + j conj(W) o, Z[m - k] = conj(e) + j W conj(o) */
+		p = (int64_t)c * odi + (int64_t)s * odr;
+		q = (int64_t)c * odr - (int64_t)s * odi;
+		a[0] = rfft_sat32((((int64_t)evr << 31) - p + (1 << 30)) >> 31);
+		a[1] = -rfft_sat32((((int64_t)evi << 31) + q + (1 << 30)) >> 31);
+		b[0] = rfft_sat32((((int64_t)evr << 31) + p + (1 << 30)) >> 31);
+		b[1] = -rfft_sat32((q - ((int64_t)evi << 31) + (1 << 30)) >> 31);
+	}
+
+	rfft_cfft_q31(buf, fft->bits, 1, 0);
+
+	for (k = 0; k < 2 * m; k += 2) {
+		buf[k] = rfft_sat32((int64_t)buf[k] * 2);
+		buf[k + 1] = rfft_sat32((int64_t)buf[k + 1] * -2);
+	}
+}
+
+static void rfft_cfft_q15(int16_t *x, uint32_t bits, uint32_t sh, uint32_t sh4)
+{
+	uint32_t m = 1 << bits, l, q, k, g, i, j, step;
+	int32_t c1, s1, c2, s2, c3, s3;
+	int32_t ar, ai, br, bi, cr, ci, dr, di;
+	int32_t t0r, t0i, t1r, t1i, t2r, t2i, t3r, t3i, yr, yi;
+	int16_t *p0, *p1, *p2, *p3, t;
+
+	for (l = m; l >= 4; l >>= 2) {
+		q = l >> 2;
+		step = RFFT_SIZE_MAX / l;
+		for (k = 0; k < q; k++) {
+			rfft_tw_q15(k * step, &c1, &s1);
+			rfft_tw_q15(2 * k * step, &c2, &s2);
+			rfft_tw_q15(3 * k * step, &c3, &s3);
+			for (g = k; g < m; g += l) {
+				p0 = x + 2 * g;
+				p1 = p0 + 2 * q;
+				p2 = p1 + 2 * q;
+				p3 = p2 + 2 * q;
+				ar = RFFT_RSH(p0[0], sh);
+				ai = RFFT_RSH(p0[1], sh);
+				br = RFFT_RSH(p1[0], sh);
+				bi = RFFT_RSH(p1[1], sh);
+				cr = RFFT_RSH(p2[0], sh);
+				ci = RFFT_RSH(p2[1], sh);
+				dr = RFFT_RSH(p3[0], sh);
+				di = RFFT_RSH(p3[1], sh);
+				t0r = ar + cr;
+				t0i = ai + ci;
+				t1r = ar - cr;
+				t1i = ai - ci;
+				t2r = br + dr;
+				t2i = bi + di;
+				t3r = br - dr;
+				t3i = bi - di;
+
+				p0[0] = dsp_sat16(t0r + t2r);
+				p0[1] = dsp_sat16(t0i + t2i);
+				/* x * (c - js), x held to 16 bits so the products fit */
+				yr = dsp_sat16(t0r - t2r);
+				yi = dsp_sat16(t0i - t2i);
+				p1[0] = dsp_sat16((yr * c2 + yi * s2 + (1 << 14)) >> 15);
+				p1[1] = dsp_sat16((yi * c2 - yr * s2 + (1 << 14)) >> 15);
+				yr = dsp_sat16(t1r + t3i);
+				yi = dsp_sat16(t1i - t3r);
+				p2[0] = dsp_sat16((yr * c1 + yi * s1 + (1 << 14)) >> 15);
+				p2[1] = dsp_sat16((yi * c1 - yr * s1 + (1 << 14)) >> 15);
+				yr = dsp_sat16(t1r - t3i);
+				yi = dsp_sat16(t1i + t3r);
+				p3[0] = dsp_sat16((yr * c3 + yi * s3 + (1 << 14)) >> 15);
+				p3[1] = dsp_sat16((yi * c3 - yr * s3 + (1 << 14)) >> 15);
+			}
+		}
+		sh = sh4;
+	}
+
+	if (bits & 1) {
+		sh = sh4 >> 1;
+		for (p0 = x; p0 < x + 2 * m; p0 += 4) {
+			ar = RFFT_RSH(p0[0], sh);
+			ai = RFFT_RSH(p0[1], sh);
+			br = RFFT_RSH(p0[2], sh);
+			bi = RFFT_RSH(p0[3], sh);
+			p0[0] = dsp_sat16(ar + br);
+			p0[1] = dsp_sat16(ai + bi);
+			p0[2] = dsp_sat16(ar - br);
+			p0[3] = dsp_sat16(ai - bi);
+		}
+	}
+
+	for (i = 1; i < m - 1; i++) {
+		j = rfft_bitrev(i, bits);
+		if (i < j) {
+			t = x[2 * i];
+			x[2 * i] = x[2 * j];
+			x[2 * j] = t;
+			t = x[2 * i + 1];
+			x[2 * i + 1] = x[2 * j + 1];
+			x[2 * j + 1] = t;
+		}
+	}
+}
+
+/**
+ * @brief Forward transform, Q15
+ * @param[in] fft Transform
+ * @param[in,out] buf n real samples in, the packed spectrum / n out
+ */
+void rfft_q15(const rfft_t *fft, int16_t *buf)
+{
+	uint32_t m = fft->n >> 1, k;
+	int16_t *a, *b;
+	int32_t c, s, evr, evi, odr, odi, p, q;
+
+	rfft_cfft_q15(buf, fft->bits, 3, 2);
+
+	evr = buf[0];
+	evi = buf[1];
+	buf[0] = dsp_sat16(evr + evi);
+	buf[1] = dsp_sat16(evr - evi);
+
+	for (k = 1; k <= m / 2; k++) {
+		a = buf + 2 * k;
+		b = buf + 2 * (m - k);
+		evr = (a[0] + b[0]) >> 1;
+		evi = (a[1] - b[1]) >> 1;
+		odr = (a[0] - b[0]) >> 1;
+		odi = (a[1] + b[1]) >> 1;
+		rfft_tw_q15(k * fft->stride, &c, &s);
+		p = c * odi - s * odr;
+		q = c * odr + s * odi;
+		a[0] = dsp_sat16(((evr << 15) + p + (1 << 14)) >> 15);
+		a[1] = dsp_sat16(((evi << 15) - q + (1 << 14)) >> 15);
+		b[0] = dsp_sat16(((evr << 15) - p + (1 << 14)) >> 15);
+		b[1] = dsp_sat16((-(evi << 15) - q + (1 << 14)) >> 15);
+	}
+}
+
+/**
+ * @brief Inverse transform, Q15
+ * @param[in] fft Transform
+ * @param[in,out] buf Packed spectrum in, n real samples out
+ */
+void rifft_q15(const rfft_t *fft, int16_t *buf)
+{
+	uint32_t m = fft->n >> 1, k;
+	int16_t *a, *b;
+	int32_t c, s, evr, evi, odr, odi, p, q;
+
+	evr = buf[0];
+	evi = buf[1];
+	buf[0] = dsp_sat16(evr + evi);
+	buf[1] = dsp_sat16(evi - evr);
+
+	for (k = 1; k <= m / 2; k++) {
+		a = buf + 2 * k;
+		b = buf + 2 * (m - k);
+		evr = a[0] + b[0];
+		evi = a[1] - b[1];
+		odr = dsp_sat16(a[0] - b[0]);
+		odi = dsp_sat16(a[1] + b[1]);
+		rfft_tw_q15(k * fft->stride, &c, &s);
+		p = c * odi + s * odr;
+		q = c * odr - s * odi;
+		a[0] = dsp_sat16(((evr << 15) - p + (1 << 14)) >> 15);
+		a[1] = dsp_sat16((-(evi << 15) - q + (1 << 14)) >> 15);
+		b[0] = dsp_sat16(((evr << 15) + p + (1 << 14)) >> 15);
+		b[1] = dsp_sat16(((evi << 15) - q + (1 << 14)) >> 15);
+	}
+
+	rfft_cfft_q15(buf, fft->bits, 1, 0);
+
+	for (k = 0; k < 2 * m; k += 2) {
+		buf[k] = dsp_sat16(buf[k] * 2);
+		buf[k + 1] = dsp_sat16(buf[k + 1] * -2);
+	}
+}
@@ -0,0 +1,336 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "rfft_tab.h"
+
+/*
+ * sin(2 * pi * i / 4096), i = 0..1024, a quarter period of all the twiddle
+ * factors up to RFFT_SIZE_MAX points, rounded and clipped to 0x7FFFFFFF / 0x7FFF
+ */
+const int32_t rfft_sin_q31[RFFT_TAB_SIZE + 1] = {
+	0x00000000, 0x003243F5, 0x006487E3, 0x0096CBC1, 0x00C90F88, 0x00FB5330,
+	0x012D96B1, 0x015FDA03, 0x01921D20, 0x01C45FFE, 0x01F6A297, 0x0228E4E2,
+	0x025B26D7, 0x028D6870, 0x02BFA9A4, 0x02F1EA6C, 0x03242ABF, 0x03566A96,
+	0x0388A9EA, 0x03BAE8B2, 0x03ED26E6, 0x041F6480, 0x0451A177, 0x0483DDC3,
+	0x04B6195D, 0x04E8543E, 0x051A8E5C, 0x054CC7B1, 0x057F0035, 0x05B137DF,
+	0x05E36EA9, 0x0615A48B, 0x0647D97C, 0x067A0D76, 0x06AC406F, 0x06DE7262,
+	0x0710A345, 0x0742D311, 0x077501BE, 0x07A72F45, 0x07D95B9E, 0x080B86C2,
+	0x083DB0A7, 0x086FD947, 0x08A2009A, 0x08D42699, 0x09064B3A, 0x09386E78,
+	0x096A9049, 0x099CB0A7, 0x09CECF89, 0x0A00ECE8, 0x0A3308BD, 0x0A6522FE,
+	0x0A973BA5, 0x0AC952AA, 0x0AFB6805, 0x0B2D7BAF, 0x0B5F8D9F, 0x0B919DCF,
+	0x0BC3AC35, 0x0BF5B8CB, 0x0C27C389, 0x0C59CC68, 0x0C8BD35E, 0x0CBDD865,
+	0x0CEFDB76, 0x0D21DC87, 0x0D53DB92, 0x0D85D88F, 0x0DB7D376, 0x0DE9CC40,
+	0x0E1BC2E4, 0x0E4DB75B, 0x0E7FA99E, 0x0EB199A4, 0x0EE38766, 0x0F1572DC,
+	0x0F475BFF, 0x0F7942C7, 0x0FAB272B, 0x0FDD0926, 0x100EE8AD, 0x1040C5BB,
+	0x1072A048, 0x10A4784B, 0x10D64DBD, 0x11082096, 0x1139F0CF, 0x116BBE60,
+	0x119D8941, 0x11CF516A, 0x120116D5, 0x1232D979, 0x1264994E, 0x1296564D,
+	0x12C8106F, 0x12F9C7AA, 0x132B7BF9, 0x135D2D53, 0x138EDBB1, 0x13C0870A,
+	0x13F22F58, 0x1423D492, 0x145576B1, 0x148715AE, 0x14B8B17F, 0x14EA4A1F,
+	0x151BDF86, 0x154D71AA, 0x157F0086, 0x15B08C12, 0x15E21445, 0x16139918,
+	0x16451A83, 0x1676987F, 0x16A81305, 0x16D98A0C, 0x170AFD8D, 0x173C6D80,
+	0x176DD9DE, 0x179F429F, 0x17D0A7BC, 0x1802092C, 0x183366E9, 0x1864C0EA,
+	0x18961728, 0x18C7699B, 0x18F8B83C, 0x192A0304, 0x195B49EA, 0x198C8CE7,
+	0x19BDCBF3, 0x19EF0707, 0x1A203E1B, 0x1A517128, 0x1A82A026, 0x1AB3CB0D,
+	0x1AE4F1D6, 0x1B161479, 0x1B4732EF, 0x1B784D30, 0x1BA96335, 0x1BDA74F6,
+	0x1C0B826A, 0x1C3C8B8C, 0x1C6D9053, 0x1C9E90B8, 0x1CCF8CB3, 0x1D00843D,
+	0x1D31774D, 0x1D6265DD, 0x1D934FE5, 0x1DC4355E, 0x1DF5163F, 0x1E25F282,
+	0x1E56CA1E, 0x1E879D0D, 0x1EB86B46, 0x1EE934C3, 0x1F19F97B, 0x1F4AB968,
+	0x1F7B7481, 0x1FAC2ABF, 0x1FDCDC1B, 0x200D888D, 0x203E300D, 0x206ED295,
+	0x209F701C, 0x20D0089C, 0x21009C0C, 0x21312A65, 0x2161B3A0, 0x219237B5,
+	0x21C2B69C, 0x21F3304F, 0x2223A4C5, 0x225413F8, 0x22847DE0, 0x22B4E274,
+	0x22E541AF, 0x23159B88, 0x2345EFF8, 0x23763EF7, 0x23A6887F, 0x23D6CC87,
+	0x24070B08, 0x243743FA, 0x24677758, 0x2497A517, 0x24C7CD33, 0x24F7EFA2,
+	0x25280C5E, 0x2558235F, 0x2588349D, 0x25B84012, 0x25E845B6, 0x26184581,
+	0x26483F6C, 0x26783370, 0x26A82186, 0x26D809A5, 0x2707EBC7, 0x2737C7E3,
+	0x27679DF4, 0x27976DF1, 0x27C737D3, 0x27F6FB92, 0x2826B928, 0x2856708D,
+	0x288621B9, 0x28B5CCA5, 0x28E5714B, 0x29150FA1, 0x2944A7A2, 0x29743946,
+	0x29A3C485, 0x29D34958, 0x2A02C7B8, 0x2A323F9E, 0x2A61B101, 0x2A911BDC,
+	0x2AC08026, 0x2AEFDDD8, 0x2B1F34EB, 0x2B4E8558, 0x2B7DCF17, 0x2BAD1221,
+	0x2BDC4E6F, 0x2C0B83FA, 0x2C3AB2B9, 0x2C69DAA6, 0x2C98FBBA, 0x2CC815EE,
+	0x2CF72939, 0x2D263596, 0x2D553AFC, 0x2D843964, 0x2DB330C7, 0x2DE2211E,
+	0x2E110A62, 0x2E3FEC8B, 0x2E6EC792, 0x2E9D9B70, 0x2ECC681E, 0x2EFB2D95,
+	0x2F29EBCC, 0x2F58A2BE, 0x2F875262, 0x2FB5FAB2, 0x2FE49BA7, 0x30133539,
+	0x3041C761, 0x30705217, 0x309ED556, 0x30CD5115, 0x30FBC54D, 0x312A31F8,
+	0x3158970E, 0x3186F487, 0x31B54A5E, 0x31E39889, 0x3211DF04, 0x32401DC6,
+	0x326E54C7, 0x329C8402, 0x32CAAB6F, 0x32F8CB07, 0x3326E2C3, 0x3354F29B,
+	0x3382FA88, 0x33B0FA84, 0x33DEF287, 0x340CE28B, 0x343ACA87, 0x3468AA76,
+	0x34968250, 0x34C4520D, 0x34F219A8, 0x351FD918, 0x354D9057, 0x357B3F5D,
+	0x35A8E625, 0x35D684A6, 0x36041AD9, 0x3631A8B8, 0x365F2E3B, 0x368CAB5C,
+	0x36BA2014, 0x36E78C5B, 0x3714F02A, 0x37424B7B, 0x376F9E46, 0x379CE885,
+	0x37CA2A30, 0x37F76341, 0x382493B0, 0x3851BB77, 0x387EDA8E, 0x38ABF0EF,
+	0x38D8FE93, 0x39060373, 0x3932FF87, 0x395FF2C9, 0x398CDD32, 0x39B9BEBC,
+	0x39E6975E, 0x3A136712, 0x3A402DD2, 0x3A6CEB96, 0x3A99A057, 0x3AC64C0F,
+	0x3AF2EEB7, 0x3B1F8848, 0x3B4C18BA, 0x3B78A007, 0x3BA51E29, 0x3BD19318,
+	0x3BFDFECD, 0x3C2A6142, 0x3C56BA70, 0x3C830A50, 0x3CAF50DA, 0x3CDB8E09,
+	0x3D07C1D6, 0x3D33EC39, 0x3D600D2C, 0x3D8C24A8, 0x3DB832A6, 0x3DE4371F,
+	0x3E10320D, 0x3E3C2369, 0x3E680B2C, 0x3E93E950, 0x3EBFBDCD, 0x3EEB889C,
+	0x3F1749B8, 0x3F430119, 0x3F6EAEB8, 0x3F9A5290, 0x3FC5EC98, 0x3FF17CCA,
+	0x401D0321, 0x40487F94, 0x4073F21D, 0x409F5AB6, 0x40CAB958, 0x40F60DFB,
+	0x4121589B, 0x414C992F, 0x4177CFB1, 0x41A2FC1A, 0x41CE1E65, 0x41F93689,
+	0x42244481, 0x424F4845, 0x427A41D0, 0x42A5311B, 0x42D0161E, 0x42FAF0D4,
+	0x4325C135, 0x4350873C, 0x437B42E1, 0x43A5F41E, 0x43D09AED, 0x43FB3746,
+	0x4425C923, 0x4450507E, 0x447ACD50, 0x44A53F93, 0x44CFA740, 0x44FA0450,
+	0x452456BD, 0x454E9E80, 0x4578DB93, 0x45A30DF0, 0x45CD358F, 0x45F7526B,
+	0x4621647D, 0x464B6BBE, 0x46756828, 0x469F59B4, 0x46C9405C, 0x46F31C1A,
+	0x471CECE7, 0x4746B2BC, 0x47706D93, 0x479A1D67, 0x47C3C22F, 0x47ED5BE6,
+	0x4816EA86, 0x48406E08, 0x4869E665, 0x48935397, 0x48BCB599, 0x48E60C62,
+	0x490F57EE, 0x49389836, 0x4961CD33, 0x498AF6DF, 0x49B41533, 0x49DD282A,
+	0x4A062FBD, 0x4A2F2BE6, 0x4A581C9E, 0x4A8101DE, 0x4AA9DBA2, 0x4AD2A9E2,
+	0x4AFB6C98, 0x4B2423BE, 0x4B4CCF4D, 0x4B756F40, 0x4B9E0390, 0x4BC68C36,
+	0x4BEF092D, 0x4C177A6E, 0x4C3FDFF4, 0x4C6839B7, 0x4C9087B1, 0x4CB8C9DD,
+	0x4CE10034, 0x4D092AB0, 0x4D31494B, 0x4D595BFE, 0x4D8162C4, 0x4DA95D96,
+	0x4DD14C6E, 0x4DF92F46, 0x4E210617, 0x4E48D0DD, 0x4E708F8F, 0x4E984229,
+	0x4EBFE8A5, 0x4EE782FB, 0x4F0F1126, 0x4F369320, 0x4F5E08E3, 0x4F857269,
+	0x4FACCFAB, 0x4FD420A4, 0x4FFB654D, 0x50229DA1, 0x5049C999, 0x5070E92F,
+	0x5097FC5E, 0x50BF031F, 0x50E5FD6D, 0x510CEB40, 0x5133CC94, 0x515AA162,
+	0x518169A5, 0x51A82555, 0x51CED46E, 0x51F576EA, 0x521C0CC2, 0x524295F0,
+	0x5269126E, 0x528F8238, 0x52B5E546, 0x52DC3B92, 0x53028518, 0x5328C1D0,
+	0x534EF1B5, 0x537514C2, 0x539B2AF0, 0x53C13439, 0x53E73097, 0x540D2005,
+	0x5433027D, 0x5458D7F9, 0x547EA073, 0x54A45BE6, 0x54CA0A4B, 0x54EFAB9C,
+	0x55153FD4, 0x553AC6EE, 0x556040E2, 0x5585ADAD, 0x55AB0D46, 0x55D05FAA,
+	0x55F5A4D2, 0x561ADCB9, 0x56400758, 0x566524AA, 0x568A34A9, 0x56AF3750,
+	0x56D42C99, 0x56F9147E, 0x571DEEFA, 0x5742BC06, 0x57677B9D, 0x578C2DBA,
+	0x57B0D256, 0x57D5696D, 0x57F9F2F8, 0x581E6EF1, 0x5842DD54, 0x58673E1B,
+	0x588B9140, 0x58AFD6BD, 0x58D40E8C, 0x58F838A9, 0x591C550E, 0x594063B5,
+	0x59646498, 0x598857B2, 0x59AC3CFD, 0x59D01475, 0x59F3DE12, 0x5A1799D1,
+	0x5A3B47AB, 0x5A5EE79A, 0x5A82799A, 0x5AA5FDA5, 0x5AC973B5, 0x5AECDBC5,
+	0x5B1035CF, 0x5B3381CE, 0x5B56BFBD, 0x5B79EF96, 0x5B9D1154, 0x5BC024F0,
+	0x5BE32A67, 0x5C0621B2, 0x5C290ACC, 0x5C4BE5B0, 0x5C6EB258, 0x5C9170BF,
+	0x5CB420E0, 0x5CD6C2B5, 0x5CF95638, 0x5D1BDB65, 0x5D3E5237, 0x5D60BAA7,
+	0x5D8314B1, 0x5DA5604F, 0x5DC79D7C, 0x5DE9CC33, 0x5E0BEC6E, 0x5E2DFE29,
+	0x5E50015D, 0x5E71F606, 0x5E93DC1F, 0x5EB5B3A2, 0x5ED77C8A, 0x5EF936D1,
+	0x5F1AE274, 0x5F3C7F6B, 0x5F5E0DB3, 0x5F7F8D46, 0x5FA0FE1F, 0x5FC26038,
+	0x5FE3B38D, 0x6004F819, 0x60262DD6, 0x604754BF, 0x60686CCF, 0x60897601,
+	0x60AA7050, 0x60CB5BB7, 0x60EC3830, 0x610D05B7, 0x612DC447, 0x614E73DA,
+	0x616F146C, 0x618FA5F7, 0x61B02876, 0x61D09BE5, 0x61F1003F, 0x6211557E,
+	0x62319B9D, 0x6251D298, 0x6271FA69, 0x6292130C, 0x62B21C7B, 0x62D216B3,
+	0x62F201AC, 0x6311DD64, 0x6331A9D4, 0x635166F9, 0x637114CC, 0x6390B34A,
+	0x63B0426D, 0x63CFC231, 0x63EF3290, 0x640E9386, 0x642DE50D, 0x644D2722,
+	0x646C59BF, 0x648B7CE0, 0x64AA907F, 0x64C99498, 0x64E88926, 0x65076E25,
+	0x6526438F, 0x6545095F, 0x6563BF92, 0x65826622, 0x65A0FD0B, 0x65BF8447,
+	0x65DDFBD3, 0x65FC63A9, 0x661ABBC5, 0x66390422, 0x66573CBB, 0x6675658C,
+	0x66937E91, 0x66B187C3, 0x66CF8120, 0x66ED6AA1, 0x670B4444, 0x67290E02,
+	0x6746C7D8, 0x676471C0, 0x67820BB7, 0x679F95B7, 0x67BD0FBD, 0x67DA79C3,
+	0x67F7D3C5, 0x68151DBE, 0x683257AB, 0x684F8186, 0x686C9B4B, 0x6889A4F6,
+	0x68A69E81, 0x68C387E9, 0x68E06129, 0x68FD2A3D, 0x6919E320, 0x69368BCE,
+	0x69532442, 0x696FAC78, 0x698C246C, 0x69A88C19, 0x69C4E37A, 0x69E12A8C,
+	0x69FD614A, 0x6A1987B0, 0x6A359DB9, 0x6A51A361, 0x6A6D98A4, 0x6A897D7D,
+	0x6AA551E9, 0x6AC115E2, 0x6ADCC964, 0x6AF86C6C, 0x6B13FEF5, 0x6B2F80FB,
+	0x6B4AF279, 0x6B66536B, 0x6B81A3CD, 0x6B9CE39B, 0x6BB812D1, 0x6BD3316A,
+	0x6BEE3F62, 0x6C093CB6, 0x6C242960, 0x6C3F055D, 0x6C59D0A9, 0x6C748B3F,
+	0x6C8F351C, 0x6CA9CE3B, 0x6CC45698, 0x6CDECE2F, 0x6CF934FC, 0x6D138AFB,
+	0x6D2DD027, 0x6D48047E, 0x6D6227FA, 0x6D7C3A98, 0x6D963C54, 0x6DB02D29,
+	0x6DCA0D14, 0x6DE3DC11, 0x6DFD9A1C, 0x6E174730, 0x6E30E34A, 0x6E4A6E66,
+	0x6E63E87F, 0x6E7D5193, 0x6E96A99D, 0x6EAFF099, 0x6EC92683, 0x6EE24B57,
+	0x6EFB5F12, 0x6F1461B0, 0x6F2D532C, 0x6F463383, 0x6F5F02B2, 0x6F77C0B3,
+	0x6F906D84, 0x6FA90921, 0x6FC19385, 0x6FDA0CAE, 0x6FF27497, 0x700ACB3C,
+	0x7023109A, 0x703B44AD, 0x70536771, 0x706B78E3, 0x708378FF, 0x709B67C0,
+	0x70B34525, 0x70CB1128, 0x70E2CBC6, 0x70FA74FC, 0x71120CC5, 0x7129931F,
+	0x71410805, 0x71586B74, 0x716FBD68, 0x7186FDDE, 0x719E2CD2, 0x71B54A41,
+	0x71CC5626, 0x71E35080, 0x71FA3949, 0x7211107E, 0x7227D61C, 0x723E8A20,
+	0x72552C85, 0x726BBD48, 0x72823C67, 0x7298A9DD, 0x72AF05A7, 0x72C54FC1,
+	0x72DB8828, 0x72F1AED9, 0x7307C3D0, 0x731DC70A, 0x7333B883, 0x73499838,
+	0x735F6626, 0x73752249, 0x738ACC9E, 0x73A06522, 0x73B5EBD1, 0x73CB60A8,
+	0x73E0C3A3, 0x73F614C0, 0x740B53FB, 0x74208150, 0x74359CBD, 0x744AA63F,
+	0x745F9DD1, 0x74748371, 0x7489571C, 0x749E18CD, 0x74B2C884, 0x74C7663A,
+	0x74DBF1EF, 0x74F06B9E, 0x7504D345, 0x751928E0, 0x752D6C6C, 0x75419DE7,
+	0x7555BD4C, 0x7569CA99, 0x757DC5CA, 0x7591AEDD, 0x75A585CF, 0x75B94A9C,
+	0x75CCFD42, 0x75E09DBD, 0x75F42C0B, 0x7607A828, 0x761B1211, 0x762E69C4,
+	0x7641AF3D, 0x7654E279, 0x76680376, 0x767B1231, 0x768E0EA6, 0x76A0F8D2,
+	0x76B3D0B4, 0x76C69647, 0x76D94989, 0x76EBEA77, 0x76FE790E, 0x7710F54C,
+	0x77235F2D, 0x7735B6AF, 0x7747FBCE, 0x775A2E89, 0x776C4EDB, 0x777E5CC3,
+	0x7790583E, 0x77A24148, 0x77B417DF, 0x77C5DC01, 0x77D78DAA, 0x77E92CD9,
+	0x77FAB989, 0x780C33B8, 0x781D9B65, 0x782EF08B, 0x78403329, 0x7851633B,
+	0x786280BF, 0x78738BB3, 0x78848414, 0x789569DF, 0x78A63D11, 0x78B6FDA8,
+	0x78C7ABA2, 0x78D846FB, 0x78E8CFB2, 0x78F945C3, 0x7909A92D, 0x7919F9EC,
+	0x792A37FE, 0x793A6361, 0x794A7C12, 0x795A820E, 0x796A7554, 0x797A55E0,
+	0x798A23B1, 0x7999DEC4, 0x79A98715, 0x79B91CA4, 0x79C89F6E, 0x79D80F6F,
+	0x79E76CA7, 0x79F6B711, 0x7A05EEAD, 0x7A151378, 0x7A24256F, 0x7A332490,
+	0x7A4210D8, 0x7A50EA47, 0x7A5FB0D8, 0x7A6E648A, 0x7A7D055B, 0x7A8B9348,
+	0x7A9A0E50, 0x7AA8766F, 0x7AB6CBA4, 0x7AC50DEC, 0x7AD33D45, 0x7AE159AE,
+	0x7AEF6323, 0x7AFD59A4, 0x7B0B3D2C, 0x7B190DBC, 0x7B26CB4F, 0x7B3475E5,
+	0x7B420D7A, 0x7B4F920E, 0x7B5D039E, 0x7B6A6227, 0x7B77ADA8, 0x7B84E61F,
+	0x7B920B89, 0x7B9F1DE6, 0x7BAC1D31, 0x7BB9096B, 0x7BC5E290, 0x7BD2A89E,
+	0x7BDF5B94, 0x7BEBFB70, 0x7BF88830, 0x7C0501D2, 0x7C116853, 0x7C1DBBB3,
+	0x7C29FBEE, 0x7C362904, 0x7C4242F2, 0x7C4E49B7, 0x7C5A3D50, 0x7C661DBC,
+	0x7C71EAF9, 0x7C7DA505, 0x7C894BDE, 0x7C94DF83, 0x7CA05FF1, 0x7CABCD28,
+	0x7CB72724, 0x7CC26DE5, 0x7CCDA169, 0x7CD8C1AE, 0x7CE3CEB2, 0x7CEEC873,
+	0x7CF9AEF0, 0x7D048228, 0x7D0F4218, 0x7D19EEBF, 0x7D24881B, 0x7D2F0E2B,
+	0x7D3980EC, 0x7D43E05E, 0x7D4E2C7F, 0x7D58654D, 0x7D628AC6, 0x7D6C9CE9,
+	0x7D769BB5, 0x7D808728, 0x7D8A5F40, 0x7D9423FC, 0x7D9DD55A, 0x7DA77359,
+	0x7DB0FDF8, 0x7DBA7534, 0x7DC3D90D, 0x7DCD2981, 0x7DD6668F, 0x7DDF9034,
+	0x7DE8A670, 0x7DF1A942, 0x7DFA98A8, 0x7E0374A0, 0x7E0C3D29, 0x7E14F242,
+	0x7E1D93EA, 0x7E26221F, 0x7E2E9CDF, 0x7E37042A, 0x7E3F57FF, 0x7E47985B,
+	0x7E4FC53E, 0x7E57DEA7, 0x7E5FE493, 0x7E67D703, 0x7E6FB5F4, 0x7E778166,
+	0x7E7F3957, 0x7E86DDC6, 0x7E8E6EB2, 0x7E95EC1A, 0x7E9D55FC, 0x7EA4AC58,
+	0x7EABEF2C, 0x7EB31E78, 0x7EBA3A39, 0x7EC14270, 0x7EC8371A, 0x7ECF1837,
+	0x7ED5E5C6, 0x7EDC9FC6, 0x7EE34636, 0x7EE9D914, 0x7EF05860, 0x7EF6C418,
+	0x7EFD1C3C, 0x7F0360CB, 0x7F0991C4, 0x7F0FAF25, 0x7F15B8EE, 0x7F1BAF1E,
+	0x7F2191B4, 0x7F2760AF, 0x7F2D1C0E, 0x7F32C3D1, 0x7F3857F6, 0x7F3DD87C,
+	0x7F434563, 0x7F489EAA, 0x7F4DE451, 0x7F531655, 0x7F5834B7, 0x7F5D3F75,
+	0x7F62368F, 0x7F671A05, 0x7F6BE9D4, 0x7F70A5FE, 0x7F754E80, 0x7F79E35A,
+	0x7F7E648C, 0x7F82D214, 0x7F872BF3, 0x7F8B7227, 0x7F8FA4B0, 0x7F93C38C,
+	0x7F97CEBD, 0x7F9BC640, 0x7F9FAA15, 0x7FA37A3C, 0x7FA736B4, 0x7FAADF7C,
+	0x7FAE7495, 0x7FB1F5FC, 0x7FB563B3, 0x7FB8BDB8, 0x7FBC040A, 0x7FBF36AA,
+	0x7FC25596, 0x7FC560CF, 0x7FC85854, 0x7FCB3C23, 0x7FCE0C3E, 0x7FD0C8A3,
+	0x7FD37153, 0x7FD6064C, 0x7FD8878E, 0x7FDAF519, 0x7FDD4EEC, 0x7FDF9508,
+	0x7FE1C76B, 0x7FE3E616, 0x7FE5F108, 0x7FE7E841, 0x7FE9CBC0, 0x7FEB9B85,
+	0x7FED5791, 0x7FEEFFE1, 0x7FF09478, 0x7FF21553, 0x7FF38274, 0x7FF4DBD9,
+	0x7FF62182, 0x7FF75370, 0x7FF871A2, 0x7FF97C18, 0x7FFA72D1, 0x7FFB55CE,
+	0x7FFC250F, 0x7FFCE093, 0x7FFD885A, 0x7FFE1C65, 0x7FFE9CB2, 0x7FFF0943,
+	0x7FFF6216, 0x7FFFA72C, 0x7FFFD886, 0x7FFFF621, 0x7FFFFFFF
+};
+
+const int16_t rfft_sin_q15[RFFT_TAB_SIZE + 1] = {
+	0x0000, 0x0032, 0x0065, 0x0097, 0x00C9, 0x00FB, 0x012E, 0x0160, 0x0192, 0x01C4,
+	0x01F7, 0x0229, 0x025B, 0x028D, 0x02C0, 0x02F2, 0x0324, 0x0356, 0x0389, 0x03BB,
+	0x03ED, 0x041F, 0x0452, 0x0484, 0x04B6, 0x04E8, 0x051B, 0x054D, 0x057F, 0x05B1,
+	0x05E3, 0x0616, 0x0648, 0x067A, 0x06AC, 0x06DE, 0x0711, 0x0743, 0x0775, 0x07A7,
+	0x07D9, 0x080C, 0x083E, 0x0870, 0x08A2, 0x08D4, 0x0906, 0x0938, 0x096B, 0x099D,
+	0x09CF, 0x0A01, 0x0A33, 0x0A65, 0x0A97, 0x0AC9, 0x0AFB, 0x0B2D, 0x0B60, 0x0B92,
+	0x0BC4, 0x0BF6, 0x0C28, 0x0C5A, 0x0C8C, 0x0CBE, 0x0CF0, 0x0D22, 0x0D54, 0x0D86,
+	0x0DB8, 0x0DEA, 0x0E1C, 0x0E4E, 0x0E80, 0x0EB2, 0x0EE4, 0x0F15, 0x0F47, 0x0F79,
+	0x0FAB, 0x0FDD, 0x100F, 0x1041, 0x1073, 0x10A4, 0x10D6, 0x1108, 0x113A, 0x116C,
+	0x119E, 0x11CF, 0x1201, 0x1233, 0x1265, 0x1296, 0x12C8, 0x12FA, 0x132B, 0x135D,
+	0x138F, 0x13C1, 0x13F2, 0x1424, 0x1455, 0x1487, 0x14B9, 0x14EA, 0x151C, 0x154D,
+	0x157F, 0x15B1, 0x15E2, 0x1614, 0x1645, 0x1677, 0x16A8, 0x16DA, 0x170B, 0x173C,
+	0x176E, 0x179F, 0x17D1, 0x1802, 0x1833, 0x1865, 0x1896, 0x18C7, 0x18F9, 0x192A,
+	0x195B, 0x198D, 0x19BE, 0x19EF, 0x1A20, 0x1A51, 0x1A83, 0x1AB4, 0x1AE5, 0x1B16,
+	0x1B47, 0x1B78, 0x1BA9, 0x1BDA, 0x1C0C, 0x1C3D, 0x1C6E, 0x1C9F, 0x1CD0, 0x1D01,
+	0x1D31, 0x1D62, 0x1D93, 0x1DC4, 0x1DF5, 0x1E26, 0x1E57, 0x1E88, 0x1EB8, 0x1EE9,
+	0x1F1A, 0x1F4B, 0x1F7B, 0x1FAC, 0x1FDD, 0x200E, 0x203E, 0x206F, 0x209F, 0x20D0,
+	0x2101, 0x2131, 0x2162, 0x2192, 0x21C3, 0x21F3, 0x2224, 0x2254, 0x2284, 0x22B5,
+	0x22E5, 0x2316, 0x2346, 0x2376, 0x23A7, 0x23D7, 0x2407, 0x2437, 0x2467, 0x2498,
+	0x24C8, 0x24F8, 0x2528, 0x2558, 0x2588, 0x25B8, 0x25E8, 0x2618, 0x2648, 0x2678,
+	0x26A8, 0x26D8, 0x2708, 0x2738, 0x2768, 0x2797, 0x27C7, 0x27F7, 0x2827, 0x2856,
+	0x2886, 0x28B6, 0x28E5, 0x2915, 0x2945, 0x2974, 0x29A4, 0x29D3, 0x2A03, 0x2A32,
+	0x2A62, 0x2A91, 0x2AC1, 0x2AF0, 0x2B1F, 0x2B4F, 0x2B7E, 0x2BAD, 0x2BDC, 0x2C0C,
+	0x2C3B, 0x2C6A, 0x2C99, 0x2CC8, 0x2CF7, 0x2D26, 0x2D55, 0x2D84, 0x2DB3, 0x2DE2,
+	0x2E11, 0x2E40, 0x2E6F, 0x2E9E, 0x2ECC, 0x2EFB, 0x2F2A, 0x2F59, 0x2F87, 0x2FB6,
+	0x2FE5, 0x3013, 0x3042, 0x3070, 0x309F, 0x30CD, 0x30FC, 0x312A, 0x3159, 0x3187,
+	0x31B5, 0x31E4, 0x3212, 0x3240, 0x326E, 0x329D, 0x32CB, 0x32F9, 0x3327, 0x3355,
+	0x3383, 0x33B1, 0x33DF, 0x340D, 0x343B, 0x3469, 0x3497, 0x34C4, 0x34F2, 0x3520,
+	0x354E, 0x357B, 0x35A9, 0x35D7, 0x3604, 0x3632, 0x365F, 0x368D, 0x36BA, 0x36E8,
+	0x3715, 0x3742, 0x3770, 0x379D, 0x37CA, 0x37F7, 0x3825, 0x3852, 0x387F, 0x38AC,
+	0x38D9, 0x3906, 0x3933, 0x3960, 0x398D, 0x39BA, 0x39E7, 0x3A13, 0x3A40, 0x3A6D,
+	0x3A9A, 0x3AC6, 0x3AF3, 0x3B20, 0x3B4C, 0x3B79, 0x3BA5, 0x3BD2, 0x3BFE, 0x3C2A,
+	0x3C57, 0x3C83, 0x3CAF, 0x3CDC, 0x3D08, 0x3D34, 0x3D60, 0x3D8C, 0x3DB8, 0x3DE4,
+	0x3E10, 0x3E3C, 0x3E68, 0x3E94, 0x3EC0, 0x3EEC, 0x3F17, 0x3F43, 0x3F6F, 0x3F9A,
+	0x3FC6, 0x3FF1, 0x401D, 0x4048, 0x4074, 0x409F, 0x40CB, 0x40F6, 0x4121, 0x414D,
+	0x4178, 0x41A3, 0x41CE, 0x41F9, 0x4224, 0x424F, 0x427A, 0x42A5, 0x42D0, 0x42FB,
+	0x4326, 0x4351, 0x437B, 0x43A6, 0x43D1, 0x43FB, 0x4426, 0x4450, 0x447B, 0x44A5,
+	0x44D0, 0x44FA, 0x4524, 0x454F, 0x4579, 0x45A3, 0x45CD, 0x45F7, 0x4621, 0x464B,
+	0x4675, 0x469F, 0x46C9, 0x46F3, 0x471D, 0x4747, 0x4770, 0x479A, 0x47C4, 0x47ED,
+	0x4817, 0x4840, 0x486A, 0x4893, 0x48BD, 0x48E6, 0x490F, 0x4939, 0x4962, 0x498B,
+	0x49B4, 0x49DD, 0x4A06, 0x4A2F, 0x4A58, 0x4A81, 0x4AAA, 0x4AD3, 0x4AFB, 0x4B24,
+	0x4B4D, 0x4B75, 0x4B9E, 0x4BC7, 0x4BEF, 0x4C17, 0x4C40, 0x4C68, 0x4C91, 0x4CB9,
+	0x4CE1, 0x4D09, 0x4D31, 0x4D59, 0x4D81, 0x4DA9, 0x4DD1, 0x4DF9, 0x4E21, 0x4E49,
+	0x4E71, 0x4E98, 0x4EC0, 0x4EE8, 0x4F0F, 0x4F37, 0x4F5E, 0x4F85, 0x4FAD, 0x4FD4,
+	0x4FFB, 0x5023, 0x504A, 0x5071, 0x5098, 0x50BF, 0x50E6, 0x510D, 0x5134, 0x515B,
+	0x5181, 0x51A8, 0x51CF, 0x51F5, 0x521C, 0x5243, 0x5269, 0x5290, 0x52B6, 0x52DC,
+	0x5303, 0x5329, 0x534F, 0x5375, 0x539B, 0x53C1, 0x53E7, 0x540D, 0x5433, 0x5459,
+	0x547F, 0x54A4, 0x54CA, 0x54F0, 0x5515, 0x553B, 0x5560, 0x5586, 0x55AB, 0x55D0,
+	0x55F6, 0x561B, 0x5640, 0x5665, 0x568A, 0x56AF, 0x56D4, 0x56F9, 0x571E, 0x5743,
+	0x5767, 0x578C, 0x57B1, 0x57D5, 0x57FA, 0x581E, 0x5843, 0x5867, 0x588C, 0x58B0,
+	0x58D4, 0x58F8, 0x591C, 0x5940, 0x5964, 0x5988, 0x59AC, 0x59D0, 0x59F4, 0x5A18,
+	0x5A3B, 0x5A5F, 0x5A82, 0x5AA6, 0x5AC9, 0x5AED, 0x5B10, 0x5B34, 0x5B57, 0x5B7A,
+	0x5B9D, 0x5BC0, 0x5BE3, 0x5C06, 0x5C29, 0x5C4C, 0x5C6F, 0x5C91, 0x5CB4, 0x5CD7,
+	0x5CF9, 0x5D1C, 0x5D3E, 0x5D61, 0x5D83, 0x5DA5, 0x5DC8, 0x5DEA, 0x5E0C, 0x5E2E,
+	0x5E50, 0x5E72, 0x5E94, 0x5EB6, 0x5ED7, 0x5EF9, 0x5F1B, 0x5F3C, 0x5F5E, 0x5F80,
+	0x5FA1, 0x5FC2, 0x5FE4, 0x6005, 0x6026, 0x6047, 0x6068, 0x6089, 0x60AA, 0x60CB,
+	0x60EC, 0x610D, 0x612E, 0x614E, 0x616F, 0x6190, 0x61B0, 0x61D1, 0x61F1, 0x6211,
+	0x6232, 0x6252, 0x6272, 0x6292, 0x62B2, 0x62D2, 0x62F2, 0x6312, 0x6332, 0x6351,
+	0x6371, 0x6391, 0x63B0, 0x63D0, 0x63EF, 0x640F, 0x642E, 0x644D, 0x646C, 0x648B,
+	0x64AB, 0x64CA, 0x64E9, 0x6507, 0x6526, 0x6545, 0x6564, 0x6582, 0x65A1, 0x65C0,
+	0x65DE, 0x65FC, 0x661B, 0x6639, 0x6657, 0x6675, 0x6693, 0x66B2, 0x66D0, 0x66ED,
+	0x670B, 0x6729, 0x6747, 0x6764, 0x6782, 0x67A0, 0x67BD, 0x67DA, 0x67F8, 0x6815,
+	0x6832, 0x6850, 0x686D, 0x688A, 0x68A7, 0x68C4, 0x68E0, 0x68FD, 0x691A, 0x6937,
+	0x6953, 0x6970, 0x698C, 0x69A9, 0x69C5, 0x69E1, 0x69FD, 0x6A1A, 0x6A36, 0x6A52,
+	0x6A6E, 0x6A89, 0x6AA5, 0x6AC1, 0x6ADD, 0x6AF8, 0x6B14, 0x6B30, 0x6B4B, 0x6B66,
+	0x6B82, 0x6B9D, 0x6BB8, 0x6BD3, 0x6BEE, 0x6C09, 0x6C24, 0x6C3F, 0x6C5A, 0x6C75,
+	0x6C8F, 0x6CAA, 0x6CC4, 0x6CDF, 0x6CF9, 0x6D14, 0x6D2E, 0x6D48, 0x6D62, 0x6D7C,
+	0x6D96, 0x6DB0, 0x6DCA, 0x6DE4, 0x6DFE, 0x6E17, 0x6E31, 0x6E4A, 0x6E64, 0x6E7D,
+	0x6E97, 0x6EB0, 0x6EC9, 0x6EE2, 0x6EFB, 0x6F14, 0x6F2D, 0x6F46, 0x6F5F, 0x6F78,
+	0x6F90, 0x6FA9, 0x6FC2, 0x6FDA, 0x6FF2, 0x700B, 0x7023, 0x703B, 0x7053, 0x706B,
+	0x7083, 0x709B, 0x70B3, 0x70CB, 0x70E3, 0x70FA, 0x7112, 0x712A, 0x7141, 0x7158,
+	0x7170, 0x7187, 0x719E, 0x71B5, 0x71CC, 0x71E3, 0x71FA, 0x7211, 0x7228, 0x723F,
+	0x7255, 0x726C, 0x7282, 0x7299, 0x72AF, 0x72C5, 0x72DC, 0x72F2, 0x7308, 0x731E,
+	0x7334, 0x734A, 0x735F, 0x7375, 0x738B, 0x73A0, 0x73B6, 0x73CB, 0x73E1, 0x73F6,
+	0x740B, 0x7421, 0x7436, 0x744B, 0x7460, 0x7475, 0x7489, 0x749E, 0x74B3, 0x74C7,
+	0x74DC, 0x74F0, 0x7505, 0x7519, 0x752D, 0x7542, 0x7556, 0x756A, 0x757E, 0x7592,
+	0x75A6, 0x75B9, 0x75CD, 0x75E1, 0x75F4, 0x7608, 0x761B, 0x762E, 0x7642, 0x7655,
+	0x7668, 0x767B, 0x768E, 0x76A1, 0x76B4, 0x76C7, 0x76D9, 0x76EC, 0x76FE, 0x7711,
+	0x7723, 0x7736, 0x7748, 0x775A, 0x776C, 0x777E, 0x7790, 0x77A2, 0x77B4, 0x77C6,
+	0x77D8, 0x77E9, 0x77FB, 0x780C, 0x781E, 0x782F, 0x7840, 0x7851, 0x7863, 0x7874,
+	0x7885, 0x7895, 0x78A6, 0x78B7, 0x78C8, 0x78D8, 0x78E9, 0x78F9, 0x790A, 0x791A,
+	0x792A, 0x793A, 0x794A, 0x795B, 0x796A, 0x797A, 0x798A, 0x799A, 0x79AA, 0x79B9,
+	0x79C9, 0x79D8, 0x79E7, 0x79F7, 0x7A06, 0x7A15, 0x7A24, 0x7A33, 0x7A42, 0x7A51,
+	0x7A60, 0x7A6E, 0x7A7D, 0x7A8C, 0x7A9A, 0x7AA8, 0x7AB7, 0x7AC5, 0x7AD3, 0x7AE1,
+	0x7AEF, 0x7AFD, 0x7B0B, 0x7B19, 0x7B27, 0x7B34, 0x7B42, 0x7B50, 0x7B5D, 0x7B6A,
+	0x7B78, 0x7B85, 0x7B92, 0x7B9F, 0x7BAC, 0x7BB9, 0x7BC6, 0x7BD3, 0x7BDF, 0x7BEC,
+	0x7BF9, 0x7C05, 0x7C11, 0x7C1E, 0x7C2A, 0x7C36, 0x7C42, 0x7C4E, 0x7C5A, 0x7C66,
+	0x7C72, 0x7C7E, 0x7C89, 0x7C95, 0x7CA0, 0x7CAC, 0x7CB7, 0x7CC2, 0x7CCE, 0x7CD9,
+	0x7CE4, 0x7CEF, 0x7CFA, 0x7D05, 0x7D0F, 0x7D1A, 0x7D25, 0x7D2F, 0x7D3A, 0x7D44,
+	0x7D4E, 0x7D58, 0x7D63, 0x7D6D, 0x7D77, 0x7D81, 0x7D8A, 0x7D94, 0x7D9E, 0x7DA7,
+	0x7DB1, 0x7DBA, 0x7DC4, 0x7DCD, 0x7DD6, 0x7DE0, 0x7DE9, 0x7DF2, 0x7DFB, 0x7E03,
+	0x7E0C, 0x7E15, 0x7E1E, 0x7E26, 0x7E2F, 0x7E37, 0x7E3F, 0x7E48, 0x7E50, 0x7E58,
+	0x7E60, 0x7E68, 0x7E70, 0x7E78, 0x7E7F, 0x7E87, 0x7E8E, 0x7E96, 0x7E9D, 0x7EA5,
+	0x7EAC, 0x7EB3, 0x7EBA, 0x7EC1, 0x7EC8, 0x7ECF, 0x7ED6, 0x7EDD, 0x7EE3, 0x7EEA,
+	0x7EF0, 0x7EF7, 0x7EFD, 0x7F03, 0x7F0A, 0x7F10, 0x7F16, 0x7F1C, 0x7F22, 0x7F27,
+	0x7F2D, 0x7F33, 0x7F38, 0x7F3E, 0x7F43, 0x7F49, 0x7F4E, 0x7F53, 0x7F58, 0x7F5D,
+	0x7F62, 0x7F67, 0x7F6C, 0x7F71, 0x7F75, 0x7F7A, 0x7F7E, 0x7F83, 0x7F87, 0x7F8B,
+	0x7F90, 0x7F94, 0x7F98, 0x7F9C, 0x7FA0, 0x7FA3, 0x7FA7, 0x7FAB, 0x7FAE, 0x7FB2,
+	0x7FB5, 0x7FB9, 0x7FBC, 0x7FBF, 0x7FC2, 0x7FC5, 0x7FC8, 0x7FCB, 0x7FCE, 0x7FD1,
+	0x7FD3, 0x7FD6, 0x7FD9, 0x7FDB, 0x7FDD, 0x7FE0, 0x7FE2, 0x7FE4, 0x7FE6, 0x7FE8,
+	0x7FEA, 0x7FEC, 0x7FED, 0x7FEF, 0x7FF1, 0x7FF2, 0x7FF4, 0x7FF5, 0x7FF6, 0x7FF7,
+	0x7FF8, 0x7FF9, 0x7FFA, 0x7FFB, 0x7FFC, 0x7FFD, 0x7FFE, 0x7FFE, 0x7FFF, 0x7FFF,
+	0x7FFF, 0x7FFF, 0x7FFF, 0x7FFF, 0x7FFF
+};
+
+#if !RFFT_RBIT
+/* i with the order of its 8 bits reversed */
+const uint8_t rfft_rev8[256] = {
+	0x00, 0x80, 0x40, 0xC0, 0x20, 0xA0, 0x60, 0xE0, 0x10, 0x90, 0x50, 0xD0, 0x30, 0xB0, 0x70, 0xF0,
+	0x08, 0x88, 0x48, 0xC8, 0x28, 0xA8, 0x68, 0xE8, 0x18, 0x98, 0x58, 0xD8, 0x38, 0xB8, 0x78, 0xF8,
+	0x04, 0x84, 0x44, 0xC4, 0x24, 0xA4, 0x64, 0xE4, 0x14, 0x94, 0x54, 0xD4, 0x34, 0xB4, 0x74, 0xF4,
+	0x0C, 0x8C, 0x4C, 0xCC, 0x2C, 0xAC, 0x6C, 0xEC, 0x1C, 0x9C, 0x5C, 0xDC, 0x3C, 0xBC, 0x7C, 0xFC,
+	0x02, 0x82, 0x42, 0xC2, 0x22, 0xA2, 0x62, 0xE2, 0x12, 0x92, 0x52, 0xD2, 0x32, 0xB2, 0x72, 0xF2,
+	0x0A, 0x8A, 0x4A, 0xCA, 0x2A, 0xAA, 0x6A, 0xEA, 0x1A, 0x9A, 0x5A, 0xDA, 0x3A, 0xBA, 0x7A, 0xFA,
+	0x06, 0x86, 0x46, 0xC6, 0x26, 0xA6, 0x66, 0xE6, 0x16, 0x96, 0x56, 0xD6, 0x36, 0xB6, 0x76, 0xF6,
+	0x0E, 0x8E, 0x4E, 0xCE, 0x2E, 0xAE, 0x6E, 0xEE, 0x1E, 0x9E, 0x5E, 0xDE, 0x3E, 0xBE, 0x7E, 0xFE,
+	0x01, 0x81, 0x41, 0xC1, 0x21, 0xA1, 0x61, 0xE1, 0x11, 0x91, 0x51, 0xD1, 0x31, 0xB1, 0x71, 0xF1,
+	0x09, 0x89, 0x49, 0xC9, 0x29, 0xA9, 0x69, 0xE9, 0x19, 0x99, 0x59, 0xD9, 0x39, 0xB9, 0x79, 0xF9,
+	0x05, 0x85, 0x45, 0xC5, 0x25, 0xA5, 0x65, 0xE5, 0x15, 0x95, 0x55, 0xD5, 0x35, 0xB5, 0x75, 0xF5,
+	0x0D, 0x8D, 0x4D, 0xCD, 0x2D, 0xAD, 0x6D, 0xED, 0x1D, 0x9D, 0x5D, 0xDD, 0x3D, 0xBD, 0x7D, 0xFD,
+	0x03, 0x83, 0x43, 0xC3, 0x23, 0xA3, 0x63, 0xE3, 0x13, 0x93, 0x53, 0xD3, 0x33, 0xB3, 0x73, 0xF3,
+	0x0B, 0x8B, 0x4B, 0xCB, 0x2B, 0xAB, 0x6B, 0xEB, 0x1B, 0x9B, 0x5B, 0xDB, 0x3B, 0xBB, 0x7B, 0xFB,
+	0x07, 0x87, 0x47, 0xC7, 0x27, 0xA7, 0x67, 0xE7, 0x17, 0x97, 0x57, 0xD7, 0x37, 0xB7, 0x77, 0xF7,
+	0x0F, 0x8F, 0x4F, 0xCF, 0x2F, 0xAF, 0x6F, 0xEF, 0x1F, 0x9F, 0x5F, 0xDF, 0x3F, 0xBF, 0x7F, 0xFF
+};
+#endif
@@ -91,6 +91,28 @@ static int cJSON_strcasecmp(const char *s1, const char *s2)
 static void *(*cJSON_malloc)(size_t sz) = malloc;
 static void (*cJSON_free)(void *ptr) = free;
 
+/* Objects with fewer keys are searched linearly. */
+#ifndef CJSON_INDEX_MIN_ITEMS
+#define CJSON_INDEX_MIN_ITEMS 16
+#endif
+
+/* Key index of an object: open addressing with linear probing. Keys are hashed
+ * case insensitively, so one table serves both lookups, and children are inserted
+ * in list order, so the first of several equal keys is found first. */
+typedef struct cJSON_Index
+{
+    unsigned int mask;
+    unsigned int count;
+    struct
+    {
+        unsigned int hash;
+        cJSON *item;
+    } slot[1];
+} cJSON_Index;
+
+/* marks nodes that must never own an index (arena nodes are not freed) */
+static cJSON_Index no_index;
+
 static char* cJSON_strdup(const char* str)
 {
     size_t len = 0;
@@ -137,6 +159,74 @@ static cJSON *cJSON_New_Item(void)
     return node;
 }
 
+/* State of one parse: input bounds, node storage and error reporting. */
+typedef struct
+{
+    const char *end;        /* one past the last input byte, NULL if NUL terminated */
+    cJSON_Arena *arena;     /* node and string storage, NULL to use cJSON_malloc */
+    cjbool insitu;          /* strings may be unescaped into the (writable) input */
+    const char **ep;
+} parse_context;
+
+/* Read one input byte, the end of a length bounded input reads as NUL. */
+static char peek(const parse_context *ctx, const char *p)
+{
+    if (ctx->end && (p >= ctx->end))
+    {
+        return '\0';
+    }
+
+    return *p;
+}
+
+/* Carve size bytes from the arena, aligned for a cJSON node if requested. */
+static void *arena_alloc(cJSON_Arena *arena, size_t size, cjbool align)
+{
+    size_t pad = 0;
+    void *p = NULL;
+
+    if (align)
+    {
+        pad = (sizeof(double) - ((size_t)(arena->block + arena->used) & (sizeof(double) - 1))) & (sizeof(double) - 1);
+    }
+    if ((arena->size - arena->used) < (pad + size))
+    {
+        return NULL;
+    }
+    p = arena->block + arena->used + pad;
+    arena->used += pad + size;
+
+    return p;
+}
+
+static cJSON *parse_new_item(parse_context *ctx)
+{
+    cJSON *node = NULL;
+
+    if (!ctx->arena)
+    {
+        return cJSON_New_Item();
+    }
+    node = (cJSON*)arena_alloc(ctx->arena, sizeof(cJSON), true);
+    if (node)
+    {
+        memset(node, '\0', sizeof(cJSON));
+        node->index = &no_index;
+    }
+
+    return node;
+}
+
+/* Drop the key index of an object whose children changed. */
+static void index_drop(cJSON *object)
+{
+    if (object->index && (object->index != &no_index))
+    {
+        cJSON_free(object->index);
+        object->index = NULL;
+    }
+}
+
 /* Delete a cJSON structure. */
 void cJSON_Delete(cJSON *c)
 {
@@ -144,6 +234,7 @@ void cJSON_Delete(cJSON *c)
     while (c)
     {
         next = c->next;
+        index_drop(c);
         if (!(c->type & cJSON_IsReference) && c->child)
         {
             cJSON_Delete(c->child);
@@ -162,7 +253,7 @@ void cJSON_Delete(cJSON *c)
 }
 
 /* Parse the input text to generate a number, and populate the result into item. */
-static const char *parse_number(cJSON *item, const char *num)
+static const char *parse_number(parse_context *ctx, cJSON *item, const char *num)
 {
     double n = 0;
     double sign = 1;
@@ -171,51 +262,51 @@ static const char *parse_number(cJSON *item, const char *num)
     int signsubscale = 1;
 
     /* Has sign? */
-    if (*num == '-')
+    if (peek(ctx, num) == '-')
     {
         sign = -1;
         num++;
     }
     /* is zero */
-    if (*num == '0')
+    if (peek(ctx, num) == '0')
     {
         num++;
     }
     /* Number? */
-    if ((*num >= '1') && (*num <= '9'))
+    if ((peek(ctx, num) >= '1') && (peek(ctx, num) <= '9'))
     {
         do
         {
             n = (n * 10.0) + (*num++ - '0');
         }
-        while ((*num >= '0') && (*num<='9'));
+        while ((peek(ctx, num) >= '0') && (peek(ctx, num) <='9'));
     }
     /* Fractional part? */
-    if ((*num == '.') && (num[1] >= '0') && (num[1] <= '9'))
+    if ((peek(ctx, num) == '.') && (peek(ctx, num + 1) >= '0') && (peek(ctx, num + 1) <= '9'))
     {
         num++;
         do
         {
             n = (n  *10.0) + (*num++ - '0');
             scale--;
-        } while ((*num >= '0') && (*num <= '9'));
+        } while ((peek(ctx, num) >= '0') && (peek(ctx, num) <= '9'));
     }
     /* Exponent? */
-    if ((*num == 'e') || (*num == 'E'))
+    if ((peek(ctx, num) == 'e') || (peek(ctx, num) == 'E'))
     {
         num++;
         /* With sign? */
-        if (*num == '+')
+        if (peek(ctx, num) == '+')
         {
             num++;
         }
-        else if (*num == '-')
+        else if (peek(ctx, num) == '-')
         {
             signsubscale = -1;
             num++;
         }
         /* Number? */
-        while ((*num>='0') && (*num<='9'))
+        while ((peek(ctx, num) >='0') && (peek(ctx, num) <='9'))
         {
             subscale = (subscale * 10) + (*num++ - '0');
         }
@@ -487,7 +578,7 @@ static const unsigned char firstByteMark[7] =
 };
 
 /* Parse the input text into an unescaped cstring, and populate item. */
-static const char *parse_string(cJSON *item, const char *str, const char **ep)
+static const char *parse_string(parse_context *ctx, cJSON *item, const char *str)
 {
     const char *ptr = str + 1;
     const char *end_ptr =str + 1;
@@ -496,19 +587,21 @@ static const char *parse_string(cJSON *item, const char *str, const char **ep)
     int len = 0;
     unsigned uc = 0;
     unsigned uc2 = 0;
+    cjbool terminated = false;
+    const char **ep = ctx->ep;
 
     /* not a string! */
-    if (*str != '\"')
+    if (peek(ctx, str) != '\"')
     {
         *ep = str;
         return NULL;
     }
 
-    while ((*end_ptr != '\"') && *end_ptr)
+    while ((peek(ctx, end_ptr) != '\"') && peek(ctx, end_ptr))
     {
         if (*end_ptr++ == '\\')
         {
-            if (*end_ptr == '\0')
+            if (peek(ctx, end_ptr) == '\0')
             {
                 /* prevent buffer overflow when last input character is a backslash */
                 return NULL;
@@ -519,8 +612,27 @@ static const char *parse_string(cJSON *item, const char *str, const char **ep)
         len++;
     }
 
-    /* This is at most how long we need for the string, roughly. */
-    out = (char*)cJSON_malloc(len + 1);
+    terminated = (peek(ctx, end_ptr) == '\"');
+
+    if (ctx->insitu)
+    {
+        /* unescape in place, the closing quote makes room for the NUL */
+        if (!terminated)
+        {
+            *ep = str;
+            return NULL;
+        }
+        out = (char*)str + 1;
+    }
+    else if (ctx->arena)
+    {
+        out = (char*)arena_alloc(ctx->arena, len + 1, false);
+    }
+    else
+    {
+        /* This is at most how long we need for the string, roughly. */
+        out = (char*)cJSON_malloc(len + 1);
+    }
     if (!out)
     {
         return NULL;
@@ -565,14 +677,14 @@ static const char *parse_string(cJSON *item, const char *str, const char **ep)
                     break;
                 case 'u':
                     /* transcode utf16 to utf8. See RFC2781 and RFC3629. */
-                    uc = parse_hex4(ptr + 1); /* get the unicode char. */
-                    ptr += 4;
-                    if (ptr >= end_ptr)
+                    if ((ptr + 4) >= end_ptr)
                     {
-                        /* invalid */
+                        /* invalid, don't read the hex digits past the string */
                         *ep = str;
                         return NULL;
                     }
+                    uc = parse_hex4(ptr + 1); /* get the unicode char. */
+                    ptr += 4;
                     /* check for invalid. */
                     if (((uc >= 0xDC00) && (uc <= 0xDFFF)) || (uc == 0))
                     {
@@ -656,7 +768,7 @@ static const char *parse_string(cJSON *item, const char *str, const char **ep)
         }
     }
     *ptr2 = '\0';
-    if (*ptr == '\"')
+    if (terminated)
     {
         ptr++;
     }
@@ -817,17 +929,17 @@ static char *print_string(const cJSON *item, printbuffer *p)
 }
 
 /* Predeclare these prototypes. */
-static const char *parse_value(cJSON *item, const char *value, const char **ep);
+static const char *parse_value(parse_context *ctx, cJSON *item, const char *value);
 static char *print_value(const cJSON *item, int depth, cjbool fmt, printbuffer *p);
-static const char *parse_array(cJSON *item, const char *value, const char **ep);
+static const char *parse_array(parse_context *ctx, cJSON *item, const char *value);
 static char *print_array(const cJSON *item, int depth, cjbool fmt, printbuffer *p);
-static const char *parse_object(cJSON *item, const char *value, const char **ep);
+static const char *parse_object(parse_context *ctx, cJSON *item, const char *value);
 static char *print_object(const cJSON *item, int depth, cjbool fmt, printbuffer *p);
 
 /* Utility to jump whitespace and cr/lf */
-static const char *skip(const char *in)
+static const char *skip(const parse_context *ctx, const char *in)
 {
-    while (in && *in && ((unsigned char)*in<=32))
+    while (in && peek(ctx, in) && ((unsigned char)*in<=32))
     {
         in++;
     }
@@ -836,37 +948,51 @@ static const char *skip(const char *in)
 }
 
 /* Parse an object - create a new root, and populate. */
-cJSON *cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cjbool require_null_terminated)
+static cJSON *parse_root(parse_context *ctx, const char *value, const char **return_parse_end, cjbool require_null_terminated)
 {
     const char *end = NULL;
+    size_t arena_mark = ctx->arena ? ctx->arena->used : 0;
     /* use global error pointer if no specific one was given */
     const char **ep = return_parse_end ? return_parse_end : &global_ep;
-    cJSON *c = cJSON_New_Item();
+    cJSON *c = NULL;
+
+    ctx->ep = ep;
     *ep = NULL;
-    if (!c) /* memory fail */
+    if (!value)
     {
         return NULL;
     }
-
-    end = parse_value(c, skip(value), ep);
-    if (!end)
+    c = parse_new_item(ctx);
+    if (!c) /* memory fail */
     {
-        /* parse failure. ep is set. */
-        cJSON_Delete(c);
         return NULL;
     }
 
-    /* if we require null-terminated JSON without appended garbage, skip and then check for a null terminator */
-    if (require_null_terminated)
+    end = parse_value(ctx, c, skip(ctx, value));
+    if (end && require_null_terminated)
     {
-        end = skip(end);
-        if (*end)
+        /* if we require null-terminated JSON without appended garbage, skip and then check for a null terminator */
+        end = skip(ctx, end);
+        if (peek(ctx, end))
         {
-            cJSON_Delete(c);
             *ep = end;
-            return NULL;
+            end = NULL;
         }
     }
+    if (!end)
+    {
+        /* parse failure. ep is set. */
+        if (ctx->arena)
+        {
+            ctx->arena->used = arena_mark;
+        }
+        else
+        {
+            cJSON_Delete(c);
+        }
+        return NULL;
+    }
+
     if (return_parse_end)
     {
         *return_parse_end = end;
@@ -875,6 +1001,56 @@ cJSON *cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cjb
     return c;
 }
 
+cJSON *cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cjbool require_null_terminated)
+{
+    parse_context ctx = { NULL, NULL, false, NULL };
+
+    return parse_root(&ctx, value, return_parse_end, require_null_terminated);
+}
+
+cJSON *cJSON_ParseWithLengthOpts(const char *value, size_t length, const char **return_parse_end, cjbool require_null_terminated)
+{
+    parse_context ctx = { NULL, NULL, false, NULL };
+
+    ctx.end = value + length;
+    return parse_root(&ctx, value, return_parse_end, require_null_terminated);
+}
+
+cJSON *cJSON_ParseWithLength(const char *value, size_t length)
+{
+    return cJSON_ParseWithLengthOpts(value, length, 0, 0);
+}
+
+void cJSON_InitArena(cJSON_Arena *arena, void *block, size_t size)
+{
+    arena->block = (char*)block;
+    arena->size = block ? size : 0;
+    arena->used = 0;
+}
+
+void cJSON_ResetArena(cJSON_Arena *arena)
+{
+    arena->used = 0;
+}
+
+cJSON *cJSON_ParseArena(cJSON_Arena *arena, const char *value, size_t length, const char **return_parse_end)
+{
+    parse_context ctx = { NULL, NULL, false, NULL };
+
+    ctx.end = value + length;
+    ctx.arena = arena;
+    return parse_root(&ctx, value, return_parse_end, false);
+}
+
+cJSON *cJSON_ParseArenaInSitu(cJSON_Arena *arena, char *value, size_t length, const char **return_parse_end)
+{
+    parse_context ctx = { NULL, NULL, true, NULL };
+
+    ctx.end = value + length;
+    ctx.arena = arena;
+    return parse_root(&ctx, value, return_parse_end, false);
+}
+
 /* Default options for cJSON_Parse */
 cJSON *cJSON_Parse(const char *value)
 {
@@ -917,9 +1093,22 @@ int cJSON_PrintPreallocated(cJSON *item,char *buf, const int len, const cjbool f
     return print_value(item,0,fmt,&p) != NULL;
 }
 
+/* Compare a literal, not reading past the end of the input. */
+static cjbool parse_literal(const parse_context *ctx, const char *value, const char *literal, size_t len)
+{
+    if (ctx->end && ((size_t)(ctx->end - value) < len))
+    {
+        return false;
+    }
+
+    return !strncmp(value, literal, len);
+}
+
 /* Parser core - when encountering text, process appropriately. */
-static const char *parse_value(cJSON *item, const char *value, const char **ep)
+static const char *parse_value(parse_context *ctx, cJSON *item, const char *value)
 {
+    char c;
+
     if (!value)
     {
         /* Fail on null. */
@@ -927,41 +1116,42 @@ static const char *parse_value(cJSON *item, const char *value, const char **ep)
     }
 
     /* parse the different types of values */
-    if (!strncmp(value, "null", 4))
+    if (parse_literal(ctx, value, "null", 4))
     {
         item->type = cJSON_NULL;
         return value + 4;
     }
-    if (!strncmp(value, "false", 5))
+    if (parse_literal(ctx, value, "false", 5))
     {
         item->type = cJSON_False;
         return value + 5;
     }
-    if (!strncmp(value, "true", 4))
+    if (parse_literal(ctx, value, "true", 4))
     {
         item->type = cJSON_True;
         item->valueint = 1;
         return value + 4;
     }
-    if (*value == '\"')
+    c = peek(ctx, value);
+    if (c == '\"')
     {
-        return parse_string(item, value, ep);
+        return parse_string(ctx, item, value);
     }
-    if ((*value == '-') || ((*value >= '0') && (*value <= '9')))
+    if ((c == '-') || ((c >= '0') && (c <= '9')))
     {
-        return parse_number(item, value);
+        return parse_number(ctx, item, value);
     }
-    if (*value == '[')
+    if (c == '[')
     {
-        return parse_array(item, value, ep);
+        return parse_array(ctx, item, value);
     }
-    if (*value == '{')
+    if (c == '{')
     {
-        return parse_object(item, value, ep);
+        return parse_object(ctx, item, value);
     }
 
     /* failure. */
-    *ep = value;
+    *ctx->ep = value;
     return NULL;
 }
 
@@ -1069,42 +1259,42 @@ static char *print_value(const cJSON *item, int depth, cjbool fmt, printbuffer *
 }
 
 /* Build an array from input text. */
-static const char *parse_array(cJSON *item,const char *value,const char **ep)
+static const char *parse_array(parse_context *ctx, cJSON *item, const char *value)
 {
     cJSON *child = NULL;
-    if (*value != '[')
+    if (peek(ctx, value) != '[')
     {
         /* not an array! */
-        *ep = value;
+        *ctx->ep = value;
         return NULL;
     }
 
     item->type = cJSON_Array;
-    value = skip(value + 1);
-    if (*value == ']')
+    value = skip(ctx, value + 1);
+    if (peek(ctx, value) == ']')
     {
         /* empty array. */
         return value + 1;
     }
 
-    item->child = child = cJSON_New_Item();
+    item->child = child = parse_new_item(ctx);
     if (!item->child)
     {
         /* memory fail */
         return NULL;
     }
     /* skip any spacing, get the value. */
-    value = skip(parse_value(child, skip(value), ep));
+    value = skip(ctx, parse_value(ctx, child, skip(ctx, value)));
     if (!value)
     {
         return NULL;
     }
 
     /* loop through the comma separated array elements */
-    while (*value == ',')
+    while (peek(ctx, value) == ',')
     {
         cJSON *new_item = NULL;
-        if (!(new_item = cJSON_New_Item()))
+        if (!(new_item = parse_new_item(ctx)))
         {
             /* memory fail */
             return NULL;
@@ -1115,7 +1305,7 @@ static const char *parse_array(cJSON *item,const char *value,const char **ep)
         child = new_item;
 
         /* go to the next comma */
-        value = skip(parse_value(child, skip(value + 1), ep));
+        value = skip(ctx, parse_value(ctx, child, skip(ctx, value + 1)));
         if (!value)
         {
             /* memory fail */
@@ -1123,14 +1313,14 @@ static const char *parse_array(cJSON *item,const char *value,const char **ep)
         }
     }
 
-    if (*value == ']')
+    if (peek(ctx, value) == ']')
     {
         /* end of array */
         return value + 1;
     }
 
     /* malformed. */
-    *ep = value;
+    *ctx->ep = value;
 
     return NULL;
 }
@@ -1305,32 +1495,32 @@ static char *print_array(const cJSON *item, int depth, cjbool fmt, printbuffer *
 }
 
 /* Build an object from the text. */
-static const char *parse_object(cJSON *item, const char *value, const char **ep)
+static const char *parse_object(parse_context *ctx, cJSON *item, const char *value)
 {
     cJSON *child = NULL;
-    if (*value != '{')
+    if (peek(ctx, value) != '{')
     {
         /* not an object! */
-        *ep = value;
+        *ctx->ep = value;
         return NULL;
     }
 
     item->type = cJSON_Object;
-    value = skip(value + 1);
-    if (*value == '}')
+    value = skip(ctx, value + 1);
+    if (peek(ctx, value) == '}')
     {
         /* empty object. */
         return value + 1;
     }
 
-    child = cJSON_New_Item();
+    child = parse_new_item(ctx);
     item->child = child;
     if (!item->child)
     {
         return NULL;
     }
     /* parse first key */
-    value = skip(parse_string(child, skip(value), ep));
+    value = skip(ctx, parse_string(ctx, child, skip(ctx, value)));
     if (!value)
     {
         return NULL;
@@ -1339,23 +1529,23 @@ static const char *parse_object(cJSON *item, const char *value, const char **ep)
     child->string = child->valuestring;
     child->valuestring = NULL;
 
-    if (*value != ':')
+    if (peek(ctx, value) != ':')
     {
         /* invalid object. */
-        *ep = value;
+        *ctx->ep = value;
         return NULL;
     }
     /* skip any spacing, get the value. */
-    value = skip(parse_value(child, skip(value + 1), ep));
+    value = skip(ctx, parse_value(ctx, child, skip(ctx, value + 1)));
     if (!value)
     {
         return NULL;
     }
 
-    while (*value == ',')
+    while (peek(ctx, value) == ',')
     {
         cJSON *new_item = NULL;
-        if (!(new_item = cJSON_New_Item()))
+        if (!(new_item = parse_new_item(ctx)))
         {
             /* memory fail */
             return NULL;
@@ -1365,7 +1555,7 @@ static const char *parse_object(cJSON *item, const char *value, const char **ep)
         new_item->prev = child;
 
         child = new_item;
-        value = skip(parse_string(child, skip(value + 1), ep));
+        value = skip(ctx, parse_string(ctx, child, skip(ctx, value + 1)));
         if (!value)
         {
             return NULL;
@@ -1375,27 +1565,27 @@ static const char *parse_object(cJSON *item, const char *value, const char **ep)
         child->string = child->valuestring;
         child->valuestring = NULL;
 
-        if (*value != ':')
+        if (peek(ctx, value) != ':')
         {
             /* invalid object. */
-            *ep = value;
+            *ctx->ep = value;
             return NULL;
         }
         /* skip any spacing, get the value. */
-        value = skip(parse_value(child, skip(value + 1), ep));
+        value = skip(ctx, parse_value(ctx, child, skip(ctx, value + 1)));
         if (!value)
         {
             return NULL;
         }
     }
     /* end of object */
-    if (*value == '}')
+    if (peek(ctx, value) == '}')
     {
         return value + 1;
     }
 
     /* malformed */
-    *ep = value;
+    *ctx->ep = value;
     return NULL;
 }
 
@@ -1705,14 +1895,139 @@ cJSON *cJSON_GetArrayItem(const cJSON *array, int item)
     return c;
 }
 
-cJSON *cJSON_GetObjectItem(const cJSON *object, const char *string)
+static unsigned int index_hash(const char *string)
 {
-    cJSON *c = object ? object->child : NULL;
-    while (c && cJSON_strcasecmp(c->string, string))
+    /* FNV-1a of the lower case key */
+    unsigned int hash = 2166136261u;
+    while (*string)
     {
-        c = c->next;
+        hash ^= (unsigned int)tolower(*(const unsigned char *)string++);
+        hash *= 16777619u;
     }
-    return c;
+
+    return hash;
+}
+
+/* Add a child, fails if the table is getting too full */
+static cjbool index_insert(cJSON_Index *index, cJSON *item)
+{
+    unsigned int hash = 0;
+    unsigned int i = 0;
+
+    if (!item->string || ((index->count + 1) * 2 > index->mask + 1))
+    {
+        return false;
+    }
+    hash = index_hash(item->string);
+    i = hash & index->mask;
+    while (index->slot[i].item)
+    {
+        i = (i + 1) & index->mask;
+    }
+    index->slot[i].hash = hash;
+    index->slot[i].item = item;
+    index->count++;
+
+    return true;
+}
+
+static cJSON_Index *index_build(const cJSON *object, unsigned int count)
+{
+    cJSON_Index *index = NULL;
+    cJSON *c = NULL;
+    unsigned int size = 4;
+
+    /* at most half full, with room to append */
+    while (size < (count * 2 + CJSON_INDEX_MIN_ITEMS))
+    {
+        size <<= 1;
+    }
+    index = (cJSON_Index*)cJSON_malloc(sizeof(cJSON_Index) + (size - 1) * sizeof(index->slot[0]));
+    if (!index)
+    {
+        return NULL;
+    }
+    memset(index, '\0', sizeof(cJSON_Index) + (size - 1) * sizeof(index->slot[0]));
+    index->mask = size - 1;
+    for (c = object->child; c; c = c->next)
+    {
+        if (c->string && !index_insert(index, c))
+        {
+            cJSON_free(index);
+            return NULL;
+        }
+    }
+
+    return index;
+}
+
+static cJSON *index_find(const cJSON_Index *index, const char *string, cjbool case_sensitive)
+{
+    unsigned int hash = index_hash(string);
+    unsigned int i = 0;
+    cJSON *c = NULL;
+
+    for (i = hash & index->mask; (c = index->slot[i].item) != NULL; i = (i + 1) & index->mask)
+    {
+        if ((index->slot[i].hash == hash)
+            && !(case_sensitive ? strcmp(c->string, string) : cJSON_strcasecmp(c->string, string)))
+        {
+            return c;
+        }
+    }
+
+    return NULL;
+}
+
+static cJSON *get_object_item(const cJSON *object, const char *string, cjbool case_sensitive)
+{
+    cJSON *c = NULL;
+    cJSON *rest = NULL;
+    unsigned int n = 0;
+
+    if (!object)
+    {
+        return NULL;
+    }
+    if (string && object->index && (object->index != &no_index))
+    {
+        return index_find(object->index, string, case_sensitive);
+    }
+
+    for (c = object->child; c; c = c->next, n++)
+    {
+        if ((n == CJSON_INDEX_MIN_ITEMS) && string && !object->index
+            && ((object->type & 0xFF) == cJSON_Object) && !(object->type & cJSON_IsReference))
+        {
+            /* a large object: index it once, so later lookups don't walk the list either */
+            for (rest = c; rest; rest = rest->next)
+            {
+                n++;
+            }
+            /* the index is a cache, building it doesn't change the object */
+            ((cJSON*)object)->index = index_build(object, n);
+            if (object->index)
+            {
+                return index_find(object->index, string, case_sensitive);
+            }
+        }
+        if (case_sensitive ? (c->string && string && !strcmp(c->string, string)) : !cJSON_strcasecmp(c->string, string))
+        {
+            return c;
+        }
+    }
+
+    return NULL;
+}
+
+cJSON *cJSON_GetObjectItem(const cJSON *object, const char *string)
+{
+    return get_object_item(object, string, false);
+}
+
+cJSON *cJSON_GetObjectItemCaseSensitive(const cJSON *object, const char *string)
+{
+    return get_object_item(object, string, true);
 }
 
 cjbool cJSON_HasObjectItem(const cJSON *object,const char *string)
@@ -1737,6 +2052,8 @@ static cJSON *create_reference(const cJSON *item)
     }
     memcpy(ref, item, sizeof(cJSON));
     ref->string = NULL;
+    /* the original owns its index, a reference is searched linearly */
+    ref->index = NULL;
     ref->type |= cJSON_IsReference;
     ref->next = ref->prev = NULL;
     return ref;
@@ -1764,6 +2081,11 @@ void   cJSON_AddItemToArray(cJSON *array, cJSON *item)
         }
         suffix_object(c, item);
     }
+    /* keep an existing index as long as it has room */
+    if (array->index && (array->index != &no_index) && !index_insert(array->index, item))
+    {
+        index_drop(array);
+    }
 }
 
 void   cJSON_AddItemToObject(cJSON *object, const char *string, cJSON *item)
@@ -1840,6 +2162,7 @@ cJSON *cJSON_DetachItemFromArray(cJSON *array, int which)
     }
     /* make sure the detached item doesn't point anywhere anymore */
     c->prev = c->next = NULL;
+    index_drop(array);
 
     return c;
 }
@@ -1885,6 +2208,7 @@ void cJSON_InsertItemInArray(cJSON *array, int which, cJSON *newitem)
         cJSON_AddItemToArray(array, newitem);
         return;
     }
+    index_drop(array);
     newitem->next = c;
     newitem->prev = c->prev;
     c->prev = newitem;
@@ -1910,6 +2234,7 @@ void cJSON_ReplaceItemInArray(cJSON *array, int which, cJSON *newitem)
     {
         return;
     }
+    index_drop(array);
     newitem->next = c->next;
     newitem->prev = c->prev;
     if (newitem->next)
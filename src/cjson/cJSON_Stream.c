@@ -0,0 +1,1033 @@
+/*
+  Copyright (c) 2009 Dave Gamble
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+/* Streaming JSON reader and writer */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+#include <limits.h>
+#include "cjson/cJSON_Stream.h"
+
+/* what the reader accepts next, outside of a token */
+enum
+{
+    EXPECT_VALUE,
+    EXPECT_VALUE_OR_END,    /* after '[' */
+    EXPECT_KEY,             /* after ',' in an object */
+    EXPECT_KEY_OR_END,      /* after '{' */
+    EXPECT_COLON,
+    EXPECT_COMMA_OR_END,
+    EXPECT_DONE,
+    EXPECT_ERROR
+};
+
+/* token being lexed, it may span any number of chunks */
+enum
+{
+    LEX_NONE,
+    LEX_STRING,
+    LEX_ESCAPE,
+    LEX_UNICODE,            /* lex_count hex digits read, 4 once uc is waiting for room */
+    LEX_NUMBER,
+    LEX_LITERAL             /* uc is the literal, lex_count the characters matched */
+};
+
+/* room for any number cJSON prints ("%1.17g", e.g. -1.2345678901234567e+300) */
+#define READER_TOKEN_MIN 32
+
+static const char *const literals[3] = { "true", "false", "null" };
+static const cJSON_StreamEvent literal_events[3] = { cJSON_StreamTrue, cJSON_StreamFalse, cJSON_StreamNull };
+
+void cJSON_ReaderInit(cJSON_Reader *reader, char *buffer, size_t size)
+{
+    memset(reader, 0, sizeof(cJSON_Reader));
+    reader->token = buffer;
+    reader->token_size = size;
+    reader->expect = EXPECT_VALUE;
+    if (!buffer || (size < READER_TOKEN_MIN))
+    {
+        reader->expect = EXPECT_ERROR;
+        return;
+    }
+    buffer[0] = '\0';
+}
+
+void cJSON_ReaderFeed(cJSON_Reader *reader, const char *data, size_t length)
+{
+    reader->in = data;
+    reader->in_length = data ? length : 0;
+    reader->in_pos = 0;
+}
+
+void cJSON_ReaderFinish(cJSON_Reader *reader)
+{
+    reader->finished = 1;
+}
+
+static cJSON_StreamEvent reader_error(cJSON_Reader *reader)
+{
+    reader->expect = EXPECT_ERROR;
+    reader->lex = LEX_NONE;
+    return cJSON_StreamError;
+}
+
+static void reader_consume(cJSON_Reader *reader)
+{
+    reader->in_pos++;
+    reader->offset++;
+}
+
+/* a value is complete: what may follow depends on the enclosing container */
+static void reader_value_done(cJSON_Reader *reader)
+{
+    reader->lex = LEX_NONE;
+    reader->expect = (reader->depth == 0) ? EXPECT_DONE : EXPECT_COMMA_OR_END;
+}
+
+static int reader_in_object(const cJSON_Reader *reader)
+{
+    return (reader->containers >> (reader->depth - 1)) & 1;
+}
+
+static cJSON_StreamEvent reader_push(cJSON_Reader *reader, int object)
+{
+    if (reader->depth >= CJSON_STREAM_NESTING_LIMIT)
+    {
+        return reader_error(reader);
+    }
+    if (object)
+    {
+        reader->containers |= (1UL << reader->depth);
+    }
+    else
+    {
+        reader->containers &= ~(1UL << reader->depth);
+    }
+    reader->depth++;
+    reader->expect = object ? EXPECT_KEY_OR_END : EXPECT_VALUE_OR_END;
+
+    return object ? cJSON_StreamObjectStart : cJSON_StreamArrayStart;
+}
+
+static cJSON_StreamEvent reader_pop(cJSON_Reader *reader, char c)
+{
+    cJSON_StreamEvent event = cJSON_StreamArrayEnd;
+
+    if (reader_in_object(reader))
+    {
+        event = cJSON_StreamObjectEnd;
+    }
+    if (c != ((event == cJSON_StreamObjectEnd) ? '}' : ']'))
+    {
+        return reader_error(reader);
+    }
+    reader_consume(reader);
+    reader->depth--;
+    reader_value_done(reader);
+
+    return event;
+}
+
+/* Append to the token, always leaving room for the terminator. 0 if it doesn't fit. */
+static int reader_put(cJSON_Reader *reader, const char *data, size_t length)
+{
+    if ((reader->token_length + length) >= reader->token_size)
+    {
+        return 0;
+    }
+    memcpy(reader->token + reader->token_length, data, length);
+    reader->token_length += length;
+    reader->token[reader->token_length] = '\0';
+
+    return 1;
+}
+
+/* The token buffer is full: hand out what there is of a string value, a key has to fit. */
+static cJSON_StreamEvent reader_string_full(cJSON_Reader *reader)
+{
+    if (reader->is_key)
+    {
+        return reader_error(reader);
+    }
+    reader->token_taken = 1;
+
+    return cJSON_StreamStringPart;
+}
+
+static void reader_start_token(cJSON_Reader *reader, unsigned char lex)
+{
+    reader->lex = lex;
+    reader->token_length = 0;
+    reader->token[0] = '\0';
+}
+
+/* Strict JSON number grammar, the reader collects the characters first */
+static int number_valid(const char *s)
+{
+    if (*s == '-')
+    {
+        s++;
+    }
+    if (*s == '0')
+    {
+        s++;
+    }
+    else if ((*s >= '1') && (*s <= '9'))
+    {
+        while ((*s >= '0') && (*s <= '9'))
+        {
+            s++;
+        }
+    }
+    else
+    {
+        return 0;
+    }
+    if (*s == '.')
+    {
+        s++;
+        if ((*s < '0') || (*s > '9'))
+        {
+            return 0;
+        }
+        while ((*s >= '0') && (*s <= '9'))
+        {
+            s++;
+        }
+    }
+    if ((*s == 'e') || (*s == 'E'))
+    {
+        s++;
+        if ((*s == '+') || (*s == '-'))
+        {
+            s++;
+        }
+        if ((*s < '0') || (*s > '9'))
+        {
+            return 0;
+        }
+        while ((*s >= '0') && (*s <= '9'))
+        {
+            s++;
+        }
+    }
+
+    return *s == '\0';
+}
+
+static cJSON_StreamEvent reader_number_done(cJSON_Reader *reader)
+{
+    if (!number_valid(reader->token))
+    {
+        return reader_error(reader);
+    }
+    reader->number = strtod(reader->token, NULL);
+    reader_value_done(reader);
+
+    return cJSON_StreamNumber;
+}
+
+/* Store the code point of a complete \u escape as UTF-8. See RFC2781 and RFC3629. */
+static int reader_put_unicode(cJSON_Reader *reader)
+{
+    unsigned int uc = reader->uc;
+    char utf8[4];
+    size_t len = 0;
+
+    if (uc < 0x80)
+    {
+        utf8[len++] = (char)uc;
+    }
+    else if (uc < 0x800)
+    {
+        utf8[len++] = (char)(0xC0 | (uc >> 6));
+        utf8[len++] = (char)(0x80 | (uc & 0x3F));
+    }
+    else if (uc < 0x10000)
+    {
+        utf8[len++] = (char)(0xE0 | (uc >> 12));
+        utf8[len++] = (char)(0x80 | ((uc >> 6) & 0x3F));
+        utf8[len++] = (char)(0x80 | (uc & 0x3F));
+    }
+    else
+    {
+        utf8[len++] = (char)(0xF0 | (uc >> 18));
+        utf8[len++] = (char)(0x80 | ((uc >> 12) & 0x3F));
+        utf8[len++] = (char)(0x80 | ((uc >> 6) & 0x3F));
+        utf8[len++] = (char)(0x80 | (uc & 0x3F));
+    }
+    if (!reader_put(reader, utf8, len))
+    {
+        return 0;
+    }
+    reader->lex = LEX_STRING;
+
+    return 1;
+}
+
+static int hex_value(char c)
+{
+    if ((c >= '0') && (c <= '9'))
+    {
+        return c - '0';
+    }
+    if ((c >= 'A') && (c <= 'F'))
+    {
+        return 10 + c - 'A';
+    }
+    if ((c >= 'a') && (c <= 'f'))
+    {
+        return 10 + c - 'a';
+    }
+
+    return -1;
+}
+
+cJSON_StreamEvent cJSON_ReaderNext(cJSON_Reader *reader)
+{
+    char c = 0;
+    char out = 0;
+    int v = 0;
+
+    if (reader->expect == EXPECT_ERROR)
+    {
+        return cJSON_StreamError;
+    }
+    if (reader->token_taken)
+    {
+        /* the previous StringPart has been read, carry on with an empty buffer */
+        reader->token_taken = 0;
+        reader->token_length = 0;
+        reader->token[0] = '\0';
+    }
+
+    for (;;)
+    {
+        if ((reader->lex == LEX_UNICODE) && (reader->lex_count == 4))
+        {
+            if (!reader_put_unicode(reader))
+            {
+                return reader_string_full(reader);
+            }
+        }
+
+        if (reader->in_pos >= reader->in_length)
+        {
+            if (reader->lex == LEX_NONE)
+            {
+                if (reader->expect == EXPECT_DONE)
+                {
+                    return cJSON_StreamEnd;
+                }
+                if (!reader->finished)
+                {
+                    return cJSON_StreamNeedMore;
+                }
+                /* truncated document */
+                return reader_error(reader);
+            }
+            if (!reader->finished)
+            {
+                return cJSON_StreamNeedMore;
+            }
+            if (reader->lex == LEX_NUMBER)
+            {
+                return reader_number_done(reader);
+            }
+            return reader_error(reader);
+        }
+        c = reader->in[reader->in_pos];
+
+        switch (reader->lex)
+        {
+            case LEX_NONE:
+                if ((c == ' ') || (c == '\t') || (c == '\n') || (c == '\r'))
+                {
+                    reader_consume(reader);
+                    continue;
+                }
+                switch (reader->expect)
+                {
+                    case EXPECT_COLON:
+                        if (c != ':')
+                        {
+                            return reader_error(reader);
+                        }
+                        reader_consume(reader);
+                        reader->expect = EXPECT_VALUE;
+                        continue;
+
+                    case EXPECT_COMMA_OR_END:
+                        if (c == ',')
+                        {
+                            reader_consume(reader);
+                            reader->expect = reader_in_object(reader) ? EXPECT_KEY : EXPECT_VALUE;
+                            continue;
+                        }
+                        return reader_pop(reader, c);
+
+                    case EXPECT_KEY_OR_END:
+                        if (c == '}')
+                        {
+                            return reader_pop(reader, c);
+                        }
+                        /* fall through */
+                    case EXPECT_KEY:
+                        if (c != '\"')
+                        {
+                            return reader_error(reader);
+                        }
+                        reader_consume(reader);
+                        reader->is_key = 1;
+                        reader_start_token(reader, LEX_STRING);
+                        continue;
+
+                    case EXPECT_VALUE_OR_END:
+                        if (c == ']')
+                        {
+                            return reader_pop(reader, c);
+                        }
+                        /* fall through */
+                    case EXPECT_VALUE:
+                        if (c == '{')
+                        {
+                            reader_consume(reader);
+                            return reader_push(reader, 1);
+                        }
+                        if (c == '[')
+                        {
+                            reader_consume(reader);
+                            return reader_push(reader, 0);
+                        }
+                        if (c == '\"')
+                        {
+                            reader_consume(reader);
+                            reader->is_key = 0;
+                            reader_start_token(reader, LEX_STRING);
+                            continue;
+                        }
+                        if ((c == '-') || ((c >= '0') && (c <= '9')))
+                        {
+                            reader_start_token(reader, LEX_NUMBER);
+                            continue;
+                        }
+                        for (v = 0; v < 3; v++)
+                        {
+                            if (c == literals[v][0])
+                            {
+                                reader->lex = LEX_LITERAL;
+                                reader->uc = v;
+                                reader->lex_count = 0;
+                                break;
+                            }
+                        }
+                        if (v < 3)
+                        {
+                            continue;
+                        }
+                        return reader_error(reader);
+
+                    default:
+                        /* garbage after the document */
+                        return reader_error(reader);
+                }
+
+            case LEX_STRING:
+                if (reader->uc_high && (c != '\\'))
+                {
+                    /* missing second half of a surrogate pair */
+                    return reader_error(reader);
+                }
+                if (c == '\"')
+                {
+                    reader_consume(reader);
+                    if (reader->is_key)
+                    {
+                        reader->lex = LEX_NONE;
+                        reader->expect = EXPECT_COLON;
+                        return cJSON_StreamKey;
+                    }
+                    reader_value_done(reader);
+                    return cJSON_StreamString;
+                }
+                if (c == '\\')
+                {
+                    reader_consume(reader);
+                    reader->lex = LEX_ESCAPE;
+                    continue;
+                }
+                if ((unsigned char)c < 32)
+                {
+                    return reader_error(reader);
+                }
+                if (!reader_put(reader, &c, 1))
+                {
+                    return reader_string_full(reader);
+                }
+                reader_consume(reader);
+                continue;
+
+            case LEX_ESCAPE:
+                if (reader->uc_high && (c != 'u'))
+                {
+                    return reader_error(reader);
+                }
+                switch (c)
+                {
+                    case 'b':
+                        out = '\b';
+                        break;
+                    case 'f':
+                        out = '\f';
+                        break;
+                    case 'n':
+                        out = '\n';
+                        break;
+                    case 'r':
+                        out = '\r';
+                        break;
+                    case 't':
+                        out = '\t';
+                        break;
+                    case '\"':
+                    case '\\':
+                    case '/':
+                        out = c;
+                        break;
+                    case 'u':
+                        reader_consume(reader);
+                        reader->lex = LEX_UNICODE;
+                        reader->lex_count = 0;
+                        reader->uc = 0;
+                        continue;
+                    default:
+                        return reader_error(reader);
+                }
+                if (!reader_put(reader, &out, 1))
+                {
+                    return reader_string_full(reader);
+                }
+                reader_consume(reader);
+                reader->lex = LEX_STRING;
+                continue;
+
+            case LEX_UNICODE:
+                v = hex_value(c);
+                if (v < 0)
+                {
+                    return reader_error(reader);
+                }
+                reader_consume(reader);
+                reader->uc = (reader->uc << 4) | v;
+                if (++reader->lex_count < 4)
+                {
+                    continue;
+                }
+                if (reader->uc_high)
+                {
+                    if ((reader->uc < 0xDC00) || (reader->uc > 0xDFFF))
+                    {
+                        /* invalid second half of surrogate */
+                        return reader_error(reader);
+                    }
+                    reader->uc = 0x10000 + (((reader->uc_high & 0x3FF) << 10) | (reader->uc & 0x3FF));
+                    reader->uc_high = 0;
+                }
+                else if ((reader->uc >= 0xD800) && (reader->uc <= 0xDBFF))
+                {
+                    reader->uc_high = reader->uc;
+                    reader->lex = LEX_STRING;
+                    continue;
+                }
+                else if (((reader->uc >= 0xDC00) && (reader->uc <= 0xDFFF)) || (reader->uc == 0))
+                {
+                    return reader_error(reader);
+                }
+                /* lex_count is 4: the code point is stored at the top of the loop */
+                continue;
+
+            case LEX_NUMBER:
+                if (((c >= '0') && (c <= '9')) || (c == '-') || (c == '+') || (c == '.') || (c == 'e') || (c == 'E'))
+                {
+                    if (!reader_put(reader, &c, 1))
+                    {
+                        /* longer than any number worth parsing */
+                        return reader_error(reader);
+                    }
+                    reader_consume(reader);
+                    continue;
+                }
+                return reader_number_done(reader);
+
+            case LEX_LITERAL:
+                if (c != literals[reader->uc][reader->lex_count])
+                {
+                    return reader_error(reader);
+                }
+                reader_consume(reader);
+                if (literals[reader->uc][++reader->lex_count] == '\0')
+                {
+                    v = reader->uc;
+                    reader_value_done(reader);
+                    return literal_events[v];
+                }
+                continue;
+
+            default:
+                return reader_error(reader);
+        }
+    }
+}
+
+void cJSON_WriterInit(cJSON_Writer *writer, char *buffer, size_t size, cJSON_WriterFlush flush, void *arg)
+{
+    memset(writer, 0, sizeof(cJSON_Writer));
+    writer->buffer = buffer;
+    writer->size = size;
+    writer->flush = flush;
+    writer->arg = arg;
+    if (!buffer || !size || !flush)
+    {
+        writer->error = 1;
+    }
+}
+
+static int writer_fail(cJSON_Writer *writer)
+{
+    writer->error = 1;
+    return 0;
+}
+
+static int writer_flush(cJSON_Writer *writer)
+{
+    if (writer->length && (writer->flush(writer->arg, writer->buffer, writer->length) != 0))
+    {
+        return writer_fail(writer);
+    }
+    writer->length = 0;
+
+    return 1;
+}
+
+static int writer_put(cJSON_Writer *writer, const char *data, size_t length)
+{
+    size_t chunk = 0;
+
+    while (length)
+    {
+        if (writer->length == writer->size)
+        {
+            if (!writer_flush(writer))
+            {
+                return 0;
+            }
+        }
+        chunk = writer->size - writer->length;
+        if (chunk > length)
+        {
+            chunk = length;
+        }
+        memcpy(writer->buffer + writer->length, data, chunk);
+        writer->length += chunk;
+        writer->total += chunk;
+        data += chunk;
+        length -= chunk;
+    }
+
+    return 1;
+}
+
+/* Same escaping as cJSON_Print, runs of plain characters are copied at once */
+static int writer_put_escaped(cJSON_Writer *writer, const char *data, size_t length)
+{
+    size_t run = 0;
+    unsigned char c = 0;
+    char esc[7];
+
+    while (length)
+    {
+        for (run = 0; run < length; run++)
+        {
+            c = (unsigned char)data[run];
+            if ((c < 32) || (c == '\"') || (c == '\\'))
+            {
+                break;
+            }
+        }
+        if (run && !writer_put(writer, data, run))
+        {
+            return 0;
+        }
+        data += run;
+        length -= run;
+        if (!length)
+        {
+            break;
+        }
+
+        c = (unsigned char)*data++;
+        length--;
+        esc[0] = '\\';
+        esc[2] = '\0';
+        switch (c)
+        {
+            case '\\':
+            case '\"':
+                esc[1] = c;
+                break;
+            case '\b':
+                esc[1] = 'b';
+                break;
+            case '\f':
+                esc[1] = 'f';
+                break;
+            case '\n':
+                esc[1] = 'n';
+                break;
+            case '\r':
+                esc[1] = 'r';
+                break;
+            case '\t':
+                esc[1] = 't';
+                break;
+            default:
+                /* escape and print as unicode codepoint */
+                sprintf(esc, "\\u%04x", c);
+                break;
+        }
+        if (!writer_put(writer, esc, strlen(esc)))
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* Separator and key in front of a value, after checking the value may go here */
+static int writer_begin_value(cJSON_Writer *writer, const char *key)
+{
+    if (writer->error)
+    {
+        return 0;
+    }
+    if (writer->in_string || writer->done)
+    {
+        return writer_fail(writer);
+    }
+    if ((writer->depth == 0) || !((writer->containers >> (writer->depth - 1)) & 1))
+    {
+        if (key)
+        {
+            return writer_fail(writer);
+        }
+    }
+    else if (!key)
+    {
+        return writer_fail(writer);
+    }
+
+    if (writer->need_comma && !writer_put(writer, ",", 1))
+    {
+        return 0;
+    }
+    if (key)
+    {
+        if (!writer_put(writer, "\"", 1)
+            || !writer_put_escaped(writer, key, strlen(key))
+            || !writer_put(writer, "\":", 2))
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static int writer_end_value(cJSON_Writer *writer)
+{
+    writer->need_comma = 1;
+    if (writer->depth == 0)
+    {
+        writer->done = 1;
+    }
+
+    return !writer->error;
+}
+
+static int writer_start(cJSON_Writer *writer, const char *key, int object)
+{
+    if (!writer_begin_value(writer, key))
+    {
+        return 0;
+    }
+    if (writer->depth >= CJSON_STREAM_NESTING_LIMIT)
+    {
+        return writer_fail(writer);
+    }
+    if (object)
+    {
+        writer->containers |= (1UL << writer->depth);
+    }
+    else
+    {
+        writer->containers &= ~(1UL << writer->depth);
+    }
+    writer->depth++;
+    writer->need_comma = 0;
+
+    return writer_put(writer, object ? "{" : "[", 1);
+}
+
+static int writer_end(cJSON_Writer *writer, int object)
+{
+    if (writer->error)
+    {
+        return 0;
+    }
+    if (writer->in_string || (writer->depth == 0)
+        || ((int)((writer->containers >> (writer->depth - 1)) & 1) != object))
+    {
+        return writer_fail(writer);
+    }
+    writer->depth--;
+    if (!writer_put(writer, object ? "}" : "]", 1))
+    {
+        return 0;
+    }
+
+    return writer_end_value(writer);
+}
+
+int cJSON_WriteObjectStart(cJSON_Writer *writer, const char *key)
+{
+    return writer_start(writer, key, 1);
+}
+
+int cJSON_WriteObjectEnd(cJSON_Writer *writer)
+{
+    return writer_end(writer, 1);
+}
+
+int cJSON_WriteArrayStart(cJSON_Writer *writer, const char *key)
+{
+    return writer_start(writer, key, 0);
+}
+
+int cJSON_WriteArrayEnd(cJSON_Writer *writer)
+{
+    return writer_end(writer, 0);
+}
+
+/* Literal value: true, false, null, a number or raw json */
+static int writer_literal(cJSON_Writer *writer, const char *key, const char *text)
+{
+    if (!text)
+    {
+        return writer_fail(writer);
+    }
+    if (!writer_begin_value(writer, key) || !writer_put(writer, text, strlen(text)))
+    {
+        return 0;
+    }
+
+    return writer_end_value(writer);
+}
+
+int cJSON_WriteString(cJSON_Writer *writer, const char *key, const char *string)
+{
+    if (!cJSON_WriteStringBegin(writer, key))
+    {
+        return 0;
+    }
+    if (string && !cJSON_WriteStringData(writer, string, strlen(string)))
+    {
+        return 0;
+    }
+
+    return cJSON_WriteStringEnd(writer);
+}
+
+int cJSON_WriteStringBegin(cJSON_Writer *writer, const char *key)
+{
+    if (!writer_begin_value(writer, key) || !writer_put(writer, "\"", 1))
+    {
+        return 0;
+    }
+    writer->in_string = 1;
+
+    return 1;
+}
+
+int cJSON_WriteStringData(cJSON_Writer *writer, const char *data, size_t length)
+{
+    if (writer->error)
+    {
+        return 0;
+    }
+    if (!writer->in_string)
+    {
+        return writer_fail(writer);
+    }
+
+    return writer_put_escaped(writer, data, length);
+}
+
+int cJSON_WriteStringEnd(cJSON_Writer *writer)
+{
+    if (writer->error)
+    {
+        return 0;
+    }
+    if (!writer->in_string)
+    {
+        return writer_fail(writer);
+    }
+    writer->in_string = 0;
+    if (!writer_put(writer, "\"", 1))
+    {
+        return 0;
+    }
+
+    return writer_end_value(writer);
+}
+
+/* Same format as cJSON_Print */
+int cJSON_WriteNumber(cJSON_Writer *writer, const char *key, double number)
+{
+    char str[64];
+    double d = number;
+
+    if (d == 0)
+    {
+        strcpy(str, "0");
+    }
+    else if ((fabs(floor(d) - d) <= DBL_EPSILON) && (d <= INT_MAX) && (d >= INT_MIN))
+    {
+        sprintf(str, "%d", (int)d);
+    }
+    /* This checks for NaN and Infinity */
+    else if ((d * 0) != 0)
+    {
+        strcpy(str, "null");
+    }
+    else if ((fabs(floor(d) - d) <= DBL_EPSILON) && (fabs(d) < 1.0e60))
+    {
+        sprintf(str, "%.0f", d);
+    }
+    else if ((fabs(d) < 1.0e-6) || (fabs(d) > 1.0e9))
+    {
+        sprintf(str, "%e", d);
+    }
+    else
+    {
+        sprintf(str, "%f", d);
+    }
+
+    return writer_literal(writer, key, str);
+}
+
+int cJSON_WriteBool(cJSON_Writer *writer, const char *key, int boolean)
+{
+    return writer_literal(writer, key, boolean ? "true" : "false");
+}
+
+int cJSON_WriteNull(cJSON_Writer *writer, const char *key)
+{
+    return writer_literal(writer, key, "null");
+}
+
+int cJSON_WriteRaw(cJSON_Writer *writer, const char *key, const char *json)
+{
+    return writer_literal(writer, key, json);
+}
+
+int cJSON_WriteItem(cJSON_Writer *writer, const char *key, const cJSON *item)
+{
+    const cJSON *child = NULL;
+
+    if (!item)
+    {
+        return writer_fail(writer);
+    }
+
+    switch ((item->type) & 0xFF)
+    {
+        case cJSON_NULL:
+            return cJSON_WriteNull(writer, key);
+        case cJSON_False:
+            return cJSON_WriteBool(writer, key, 0);
+        case cJSON_True:
+            return cJSON_WriteBool(writer, key, 1);
+        case cJSON_Number:
+            return cJSON_WriteNumber(writer, key, item->valuedouble);
+        case cJSON_String:
+            return cJSON_WriteString(writer, key, item->valuestring);
+        case cJSON_Raw:
+            return cJSON_WriteRaw(writer, key, item->valuestring);
+        case cJSON_Array:
+            if (!cJSON_WriteArrayStart(writer, key))
+            {
+                return 0;
+            }
+            for (child = item->child; child; child = child->next)
+            {
+                if (!cJSON_WriteItem(writer, NULL, child))
+                {
+                    return 0;
+                }
+            }
+            return cJSON_WriteArrayEnd(writer);
+        case cJSON_Object:
+            if (!cJSON_WriteObjectStart(writer, key))
+            {
+                return 0;
+            }
+            for (child = item->child; child; child = child->next)
+            {
+                if (!cJSON_WriteItem(writer, child->string ? child->string : "", child))
+                {
+                    return 0;
+                }
+            }
+            return cJSON_WriteObjectEnd(writer);
+        default:
+            return writer_fail(writer);
+    }
+}
+
+int cJSON_WriterFinish(cJSON_Writer *writer)
+{
+    if (writer->error)
+    {
+        return 0;
+    }
+    if (!writer->done || writer->depth || writer->in_string)
+    {
+        return writer_fail(writer);
+    }
+
+    return writer_flush(writer);
+}
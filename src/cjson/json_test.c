@@ -24,6 +24,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include "cjson/cJSON.h"
+#include "cjson/cJSON_Stream.h"
+#include "kernel/os/os_time.h"
 
 
 void JsonRecursiveReadExample(cJSON *json){
@@ -449,6 +451,232 @@ char text4[] =
         "</body>\n"
         "</html>\n";
 
+static int count_malloc_calls;
+static size_t count_malloc_bytes;
+
+static void *count_malloc(size_t sz)
+{
+    count_malloc_calls++;
+    count_malloc_bytes += sz;
+    return malloc(sz);
+}
+
+/* Parse text on the heap and in an arena, and compare what each costs. */
+static void arena_compare(const char *name, const char *text)
+{
+    static double block[256]; /* 2 KB, aligned for cJSON nodes */
+    cJSON_Hooks hooks = { count_malloc, free };
+    cJSON_Arena arena;
+    cJSON *json = NULL;
+    char *copy = NULL;
+    size_t len = strlen(text);
+
+    count_malloc_calls = 0;
+    count_malloc_bytes = 0;
+    cJSON_InitHooks(&hooks);
+    json = cJSON_Parse(text);
+    cJSON_Delete(json);
+    cJSON_InitHooks(NULL);
+
+    cJSON_InitArena(&arena, block, sizeof(block));
+    json = cJSON_ParseArena(&arena, text, len, NULL);
+    printf("%s: heap %d mallocs %u bytes, arena %u bytes%s",
+           name, count_malloc_calls, (unsigned)count_malloc_bytes,
+           (unsigned)arena.used, json ? "" : " (failed)");
+
+    /* in situ: only the nodes are taken from the arena, the strings stay in the copy */
+    cJSON_ResetArena(&arena);
+    copy = (char*)malloc(len);
+    if (copy == NULL)
+    {
+        printf("\n");
+        return;
+    }
+    memcpy(copy, text, len);
+    json = cJSON_ParseArenaInSitu(&arena, copy, len, NULL);
+    printf(", in situ %u bytes%s\n", (unsigned)arena.used, json ? "" : " (failed)");
+    cJSON_ResetArena(&arena);
+    free(copy);
+}
+
+static char stream_out[1024];
+static size_t stream_out_len;
+
+static int stream_flush(void *arg, const char *data, size_t length)
+{
+    if (stream_out_len + length >= sizeof(stream_out))
+    {
+        return -1;
+    }
+    memcpy(stream_out + stream_out_len, data, length);
+    stream_out_len += length;
+    return 0;
+}
+
+/* Pull text through the reader in small chunks, push the events into the writer, */
+/* and check the result against cJSON_PrintUnformatted. */
+static void stream_compare(const char *name, const char *text, size_t chunk)
+{
+    char token[32];
+    char wbuf[32];
+    char key[32];
+    cJSON_Reader reader;
+    cJSON_Writer writer;
+    cJSON_StreamEvent event;
+    cJSON *json = NULL;
+    char *out = NULL;
+    const char *k = NULL;
+    size_t len = strlen(text);
+    size_t pos = 0;
+    int ok = 1;
+    int in_string = 0;
+
+    stream_out_len = 0;
+    cJSON_ReaderInit(&reader, token, sizeof(token));
+    cJSON_WriterInit(&writer, wbuf, sizeof(wbuf), stream_flush, NULL);
+    do
+    {
+        event = cJSON_ReaderNext(&reader);
+        switch (event)
+        {
+            case cJSON_StreamNeedMore:
+                if (pos < len)
+                {
+                    cJSON_ReaderFeed(&reader, text + pos, (len - pos) < chunk ? (len - pos) : chunk);
+                    pos += (len - pos) < chunk ? (len - pos) : chunk;
+                }
+                else
+                {
+                    cJSON_ReaderFinish(&reader);
+                }
+                continue;
+            case cJSON_StreamKey:
+                strncpy(key, reader.token, sizeof(key) - 1);
+                key[sizeof(key) - 1] = '\0';
+                k = key;
+                continue;
+            case cJSON_StreamObjectStart:
+                ok = cJSON_WriteObjectStart(&writer, k);
+                break;
+            case cJSON_StreamObjectEnd:
+                ok = cJSON_WriteObjectEnd(&writer);
+                break;
+            case cJSON_StreamArrayStart:
+                ok = cJSON_WriteArrayStart(&writer, k);
+                break;
+            case cJSON_StreamArrayEnd:
+                ok = cJSON_WriteArrayEnd(&writer);
+                break;
+            case cJSON_StreamStringPart:
+                if (!in_string)
+                {
+                    ok = cJSON_WriteStringBegin(&writer, k);
+                    in_string = 1;
+                }
+                ok = ok && cJSON_WriteStringData(&writer, reader.token, reader.token_length);
+                break;
+            case cJSON_StreamString:
+                if (in_string)
+                {
+                    ok = cJSON_WriteStringData(&writer, reader.token, reader.token_length)
+                         && cJSON_WriteStringEnd(&writer);
+                    in_string = 0;
+                }
+                else
+                {
+                    ok = cJSON_WriteString(&writer, k, reader.token);
+                }
+                break;
+            case cJSON_StreamNumber:
+                ok = cJSON_WriteNumber(&writer, k, reader.number);
+                break;
+            case cJSON_StreamTrue:
+            case cJSON_StreamFalse:
+                ok = cJSON_WriteBool(&writer, k, event == cJSON_StreamTrue);
+                break;
+            case cJSON_StreamNull:
+                ok = cJSON_WriteNull(&writer, k);
+                break;
+            default:
+                break;
+        }
+        k = NULL;
+    } while (ok && (event != cJSON_StreamEnd) && (event != cJSON_StreamError));
+
+    ok = ok && (event == cJSON_StreamEnd) && cJSON_WriterFinish(&writer);
+    stream_out[stream_out_len] = '\0';
+
+    json = cJSON_Parse(text);
+    out = json ? cJSON_PrintUnformatted(json) : NULL;
+    cJSON_Delete(json);
+    printf("%s: stream %s at %lu, %lu bytes out, %s\n", name, ok ? "ok" : "failed",
+           reader.offset, writer.total, (out && ok && !strcmp(out, stream_out)) ? "same" : "different");
+    free(out);
+}
+
+/* The list walk cJSON_GetObjectItem used before objects were indexed */
+static cJSON *lookup_linear(const cJSON *object, const char *string)
+{
+    cJSON *c = object->child;
+    while (c && strcasecmp(c->string, string))
+    {
+        c = c->next;
+    }
+    return c;
+}
+
+/* Time every key of an object of the given size looked up a few times, linearly and indexed. */
+static void lookup_compare(int keys)
+{
+    cJSON *root = cJSON_CreateObject();
+    char name[16];
+    OS_Time_t t;
+    int linear_ms = 0;
+    int indexed_ms = 0;
+    int rounds = 10000 / keys + 1;
+    int found = 0;
+    int i = 0;
+    int r = 0;
+
+    for (i = 0; root && (i < keys); i++)
+    {
+        sprintf(name, "key_%d", i);
+        cJSON_AddNumberToObject(root, name, i);
+    }
+    if (!root || (cJSON_GetArraySize(root) != keys))
+    {
+        printf("%d keys: no memory\n", keys);
+        cJSON_Delete(root);
+        return;
+    }
+
+    t = OS_GetTicks();
+    for (r = 0; r < rounds; r++)
+    {
+        for (i = 0; i < keys; i++)
+        {
+            sprintf(name, "KEY_%d", i);
+            found += (lookup_linear(root, name) != NULL);
+        }
+    }
+    linear_ms = OS_TicksToMSecs(OS_GetTicks() - t);
+
+    t = OS_GetTicks();
+    for (r = 0; r < rounds; r++)
+    {
+        for (i = 0; i < keys; i++)
+        {
+            sprintf(name, "KEY_%d", i);
+            found += (cJSON_GetObjectItem(root, name) != NULL);
+        }
+    }
+    indexed_ms = OS_TicksToMSecs(OS_GetTicks() - t);
+
+    printf("%d keys x %d: linear %d ms, indexed %d ms%s\n", keys, rounds, linear_ms, indexed_ms,
+           (found == 2 * rounds * keys) ? "" : " (lookup failed)");
+    cJSON_Delete(root);
+}
+
 int cjson_test(void)
 {
      /* a bunch of json: */
@@ -461,5 +689,25 @@ int cjson_test(void)
     /* Now some samplecode for building objects concisely: */
      create_objects();
 
+    /* Allocation cost of the heap and arena parsers */
+    arena_compare("text1", text1);
+    arena_compare("text2", text2);
+    arena_compare("text3", text3);
+    arena_compare("text4", text4);
+    arena_compare("text5", text5);
+
+    /* Streaming reader and writer, fed a few bytes at a time */
+    stream_compare("text1", text1, 7);
+    stream_compare("text2", text2, 5);
+    stream_compare("text3", text3, 3);
+    stream_compare("text4", text4, 11);
+    stream_compare("text5", text5, 1);
+    stream_compare("numbers", "[-1.2345678901234567e+300,2.2250738585072014e-308,-0]", 4);
+
+    /* Key lookup in large objects */
+    lookup_compare(10);
+    lookup_compare(100);
+    lookup_compare(1000);
+
     return 0;
 }
@@ -48,7 +48,13 @@
 #define CONSOLE_NEW_LINE_MODE       1
 
 #define CONSOLE_CMD_LINE_MAX_LEN    256
-#define CONSOLE_CMD_LINE_BUF_NUM    2
+
+/* Number of command line buffers, i.e. how many received command lines can
+ * wait for execution. When all are in use, rx is stalled until one is free.
+ */
+#ifndef CONSOLE_CMD_LINE_BUF_NUM
+#define CONSOLE_CMD_LINE_BUF_NUM    8
+#endif
 
 typedef enum {
 	CONSOLE_STATE_STOP = 0,
@@ -66,6 +72,8 @@ typedef struct console_priv {
     uint8_t         ready_buf_bitmap[CONSOLE_CMD_LINE_BUF_NUM];
     uint8_t         last_cmd_buf_idx;
     uint8_t         rx_buf_idx;
+    uint8_t         rx_stalled;     /* rx callback disabled for lack of buffers */
+    uint8_t         rx_disabled;    /* rx disabled by console_disable() */
     uint32_t        rx_data_cnt;
 
     uint8_t         *buf[CONSOLE_CMD_LINE_BUF_NUM];
@@ -276,10 +284,12 @@ retry:
 		}
 		console->rx_data_cnt = cnt;
 	} else {
-		CONS_IT_WRN("no buf for rx, discard received data\n");
-		while (console_is_rx_ready(uart)) {
-			console_get_rx_data(uart);
-		}
+		/* No buf for rx. Leave the data in the UART, where flow control (if
+		 * any) holds off the sender, until the console task frees a buffer.
+		 */
+		CONS_IT_DBG("no buf for rx, stall rx\n");
+		HAL_UART_DisableRxCallback(console->uart_id);
+		console->rx_stalled = 1;
 	}
 }
 
@@ -325,6 +335,15 @@ static void console_task(void *arg)
 				/* buf state change: ready --> free */
 				CONSOLE_SET_BUF_BITMAP_VALID(console->free_buf_bitmap, cmd_buf_idx);
 			}
+			if (console->rx_stalled && !console->rx_disabled) {
+				/* resume rx, the data held in the UART is read now. Checked
+				 * and done with irq disabled, so that console_disable() can
+				 * not come in between.
+				 */
+				HAL_UART_EnableRxCallback(console->uart_id, console_rx_callback,
+				                          HAL_UART_GetInstance(console->uart_id));
+			}
+			console->rx_stalled = 0;
 			arch_irq_enable();
 		} else {
 			CONS_WRN("no valid command\n");
@@ -446,7 +465,10 @@ void console_disable(void)
 
 	console = &g_console;
 	if (console->state == CONSOLE_STATE_START) {
+		arch_irq_disable();
+		console->rx_disabled = 1;
 		HAL_UART_DisableRxCallback(console->uart_id);
+		arch_irq_enable();
 	}
 }
 
@@ -465,7 +487,10 @@ void console_enable(void)
 	console = &g_console;
 	if (console->state == CONSOLE_STATE_START) {
 		uart = HAL_UART_GetInstance(console->uart_id);
+		arch_irq_disable();
+		console->rx_disabled = 0;
 		HAL_UART_EnableRxCallback(console->uart_id, console_rx_callback, uart);
+		arch_irq_enable();
 	}
 }
 
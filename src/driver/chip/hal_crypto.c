@@ -38,6 +38,12 @@
 #include "hal_base.h"
 #include "sys/endian.h"
 #include "pm/pm.h"
+#ifdef __CONFIG_XIP
+#include "driver/chip/hal_xip.h"
+#endif
+#ifdef __CONFIG_PSRAM
+#include "driver/chip/psram/psram.h"
+#endif
 #include "sys/xr_debug.h"
 
 
@@ -53,7 +59,9 @@
             printf("[Crypto] "fmt, ##arg);		\
     } while (0);
 
-#define CE_CRC_HASH_DMA_ENA	0	/* use dma to do crc/hash */
+#ifndef CE_CRC_HASH_DMA_MIN
+#define CE_CRC_HASH_DMA_MIN	1024	/* use dma to do crc/hash from this size */
+#endif
 #define HAL_PRNG_RAND_NUM	5	/* number of random value for one generation */
 #define HAL_PRNG_SEED_NUM	6
 
@@ -1297,8 +1305,6 @@ static const CE_CRC_Config crc_cfg[] = {
 	{CE_CTL_CRC_WIDTH_32BITS, 0x04c11db7, 	1, 0, 0, 0},		/* CE_CRC32_MPEG2,  */
 };
 
-#if CE_CRC_HASH_DMA_ENA
-
 static HAL_Status HAL_CRC_Hash_InitDMA(DMA_Channel *input)
 {
 	HAL_Status ret = HAL_OK;
@@ -1340,7 +1346,21 @@ static void HAL_CRC_Hash_DenitDMA(DMA_Channel input)
 	HAL_DMA_Release(input);
 }
 
-#endif /* CE_CRC_HASH_DMA_ENA */
+/* dma reads the data from sram only, flash and psram go through the cache */
+static int HAL_CRC_Hash_DMAble(const uint8_t *data, uint32_t size)
+{
+	if (size < CE_CRC_HASH_DMA_MIN)
+		return 0;
+#ifdef __CONFIG_XIP
+	if (((uint32_t)data <= XIP_END_ADDR) && ((uint32_t)data + size > XIP_START_ADDR))
+		return 0;
+#endif
+#ifdef __CONFIG_PSRAM
+	if (((uint32_t)data <= PSRAM_END_ADDR) && ((uint32_t)data + size > PSRAM_START_ADDR))
+		return 0;
+#endif
+	return 1;
+}
 
 static HAL_Status HAL_CRC_Hash_Convey(CE_Fifo_Align *align, uint8_t *data, uint32_t size)
 {
@@ -1352,60 +1372,46 @@ static HAL_Status HAL_CRC_Hash_Convey(CE_Fifo_Align *align, uint8_t *data, uint3
 	CRYPTO_PRINT(CRYPTO_DBG, "input size = %u, buf_left = %u\n", size, buf_left);
 
 	if (size < buf_left) {
-		HAL_Memcpy(align->word, data, size);
+		HAL_Memcpy(&align->word[align->word_size], data, size);
 		align->word_size += size;
 		goto out;
 	}
 	HAL_Memcpy(&align->word[align->word_size], data, buf_left);
-#if CE_CRC_HASH_DMA_ENA
-	/* use DMA mode */
-	DMA_Channel input = DMA_CHANNEL_INVALID;
-	if ((ret = HAL_CRC_Hash_InitDMA(&input)) != HAL_OK) {
-		CRYPTO_PRINT(CRYPTO_ERR, "DMA Request failed\n");
-		goto out;
-	}
 
-	CE_SetInputThreshold(CE, 0);
-
-	HAL_DMA_Start(input, (uint32_t)align->word, (uint32_t)CE_Crypto_GetInputAddr(CE), 4);
-	if ((ret = HAL_SemaphoreWait(&ce_block, CE_WAIT_TIME)) != HAL_OK) {
-		CRYPTO_PRINT(CRYPTO_ERR, "DMA transfer 1st block failed\n");
-		HAL_CRC_Hash_DenitDMA(input);
-		goto out;
-	}
-	HAL_DMA_Stop(input);
+	while(!HAL_GET_BIT(CE->FCSR, CE_FCSR_RXFIFO_STATUS_MASK));
+	uint32_t *p = (uint32_t*)align->word;
+	*CE_Crypto_GetInputAddr(CE) = *p;
 
 	align->word_size = (size - buf_left) & 0x3; // len % 4
 	align_len = size - buf_left - align->word_size;
-//	CE_DEBUG("align_len = %d, new buf_left should be = %d\n", align_len, align->word_size);
 
-	if (align_len != 0) {
+	if (HAL_CRC_Hash_DMAble(data + buf_left, align_len)) {
+		/* use DMA mode */
+		DMA_Channel input = DMA_CHANNEL_INVALID;
+		if ((ret = HAL_CRC_Hash_InitDMA(&input)) != HAL_OK) {
+			CRYPTO_PRINT(CRYPTO_ERR, "DMA Request failed\n");
+			goto out;
+		}
+
+		CE_SetInputThreshold(CE, 0);
+
 		HAL_DMA_Start(input, (uint32_t)(data + buf_left), (uint32_t)CE_Crypto_GetInputAddr(CE), align_len);
 		if ((ret = HAL_SemaphoreWait(&ce_block, CE_WAIT_TIME)) != HAL_OK) {
-			CRYPTO_PRINT(CRYPTO_ERR, "DMA transfer 2rd block failed\n");
+			CRYPTO_PRINT(CRYPTO_ERR, "DMA transfer failed\n");
+			HAL_DMA_Stop(input);
 			HAL_CRC_Hash_DenitDMA(input);
 			goto out;
 		}
 		HAL_DMA_Stop(input);
-	}
-	HAL_CRC_Hash_DenitDMA(input);
-#else /* CE_CRC_HASH_DMA_ENA */
-	/* use CPU mode */
-	while(!HAL_GET_BIT(CE->FCSR, CE_FCSR_RXFIFO_STATUS_MASK));
-	uint32_t *p = (uint32_t*)align->word;
-	*CE_Crypto_GetInputAddr(CE) = *p;
-
-	align->word_size = (size - buf_left) & 0x3; // len % 4
-	align_len = size - buf_left - align->word_size;
-
-	uint32_t i;
-	if (align_len != 0) {
+		HAL_CRC_Hash_DenitDMA(input);
+	} else {
+		/* use CPU mode */
+		uint32_t i;
 		for(i = 0; i < align_len; i += 4) {
 			while(!HAL_GET_BIT(CE->FCSR, CE_FCSR_RXFIFO_STATUS_MASK));
 			*CE_Crypto_GetInputAddr(CE) = *((uint32_t*)&data[buf_left + i]);
 		}
 	}
-#endif /* CE_CRC_HASH_DMA_ENA */
 	HAL_Memset(align->word, 0, sizeof(align->word));
 	HAL_Memcpy(align->word, data + size - align->word_size, align->word_size);
 
@@ -1440,6 +1446,51 @@ static void HAL_Hash_Finish(CE_MD5_Handler *hdl, uint64_t bit_size)
 
 	CE_Hash_Finish(CE);
 }
+
+/*
+ * Run whole 64-byte blocks through the hash engine, chaining from state[]
+ * and writing the new chaining value back. No padding is appended, the
+ * engine is only held for the duration of the call.
+ */
+static HAL_Status HAL_Hash_Compress(CE_CTL_Method algo, uint32_t *state, uint32_t state_size,
+                                    const uint8_t *data, uint32_t size)
+{
+	HAL_Status ret = HAL_OK;
+	CE_Fifo_Align align;
+	uint32_t i;
+
+	if ((size == 0) || (size & 0x3f)) {
+		ret = HAL_INVALID;
+		goto out;
+	}
+
+	ce_running = 1;
+	if ((ret = HAL_MutexLock(&ce_lock, CE_WAIT_TIME)) != HAL_OK)
+		goto out;
+
+	HAL_CE_EnableCCMU();
+	CE_Hash_Init(CE, algo);
+	CE_Hash_SetIV(CE, CE_CTL_IVMODE_SHA_MD5_INPUT, state, state_size);
+	CE_Reg_All(__LINE__);
+
+	HAL_Memset(&align, 0, sizeof(align));
+	ret = HAL_CRC_Hash_Convey(&align, (uint8_t *)data, size);
+	if (ret == HAL_OK) {
+		CE_Hash_Finish(CE);
+		while (CE_Status(CE, CE_INT_TPYE_HASH_CRC_END) == 0);
+		CE_Hash_Calc(CE, algo, state);
+		for (i = 0; i < state_size; i++)
+			state[i] = SWAP32(state[i]);	/* digest byte order to iv word order */
+	}
+
+	CE_Hash_Deinit(CE);
+	HAL_CE_DisableCCMU();
+	HAL_MutexUnlock(&ce_lock);
+
+out:
+	ce_running = 0;
+	return ret;
+}
 /************************ public **************************************/
 
 /**
@@ -1700,6 +1751,22 @@ HAL_Status HAL_SHA1_Finish(CE_SHA1_Handler *hdl, uint32_t digest[5])
 	return ret;
 }
 
+/**
+  * @brief Process whole SHA1 blocks without taking the engine between calls.
+  * @note Unlike HAL_SHA1_Init/Append/Finish, the intermediate state is kept
+  *       by the caller, so several SHA1 calculations can be interleaved and
+  *       cloned. Padding is left to the caller.
+  * @param state: SHA1 chaining value in the same word order as the iv of
+  *               HAL_SHA1_Init, updated after processing.
+  * @param data: the data needed to calculate sha1.
+  * @param size: size of data, must be multiple of 64 bytes.
+  * @retval HAL_Status:  The status of driver
+  */
+HAL_Status HAL_SHA1_Compress(uint32_t state[5], const uint8_t *data, uint32_t size)
+{
+	return HAL_Hash_Compress(CE_CTL_METHOD_SHA1, state, CE_SHA1_IV_SIZE, data, size);
+}
+
 /**
   * @brief Initialize SHA256 module.
   * @param hdl: It's a handler stored private info. created by user.
@@ -1770,6 +1837,22 @@ HAL_Status HAL_SHA256_Finish(CE_SHA256_Handler *hdl, uint32_t digest[8])
 	return ret;
 }
 
+/**
+  * @brief Process whole SHA256 blocks without taking the engine between calls.
+  * @note Unlike HAL_SHA256_Init/Append/Finish, the intermediate state is kept
+  *       by the caller, so several SHA256 calculations can be interleaved and
+  *       cloned. Padding is left to the caller.
+  * @param state: SHA256 chaining value in the same word order as the iv of
+  *               HAL_SHA256_Init, updated after processing.
+  * @param data: the data needed to calculate sha256.
+  * @param size: size of data, must be multiple of 64 bytes.
+  * @retval HAL_Status:  The status of driver
+  */
+HAL_Status HAL_SHA256_Compress(uint32_t state[8], const uint8_t *data, uint32_t size)
+{
+	return HAL_Hash_Compress(CE_CTL_METHOD_SHA256, state, CE_SHA256_IV_SIZE, data, size);
+}
+
 static uint32_t prng_seed[HAL_PRNG_SEED_NUM];
 
 /**
@@ -10,6 +10,12 @@
 #include "fs/fatfs/diskio.h"		/* FatFs lower layer API */
 
 #include "driver/sdmmc_diskio.h"
+#ifdef __CONFIG_FATFS_RAM_DISK
+#include "driver/ram_diskio.h"
+#endif
+#ifdef __CONFIG_FATFS_BLK_CACHE
+#include "driver/blk_cache.h"
+#endif
 #include <stdio.h>	//for debug
 
 /* Definitions of physical drive number for each drive */
@@ -17,9 +23,18 @@
 #define DEV_MMC		0	/* Example: Map MMC/SD card to physical drive 1 */
 #define DEV_USB		2	/* Example: Map USB MSD to physical drive 2 */
 
+#ifdef __CONFIG_FATFS_RAM_DISK
+#define SUPPORT_DEV_RAM 1
+#else
 #define SUPPORT_DEV_RAM 0
+#endif
 #define SUPPORT_DEV_USB 0
 
+#ifdef __CONFIG_FATFS_BLK_CACHE
+static blk_cache_t mmc_cache;
+static uint8_t mmc_cache_ready;
+#endif
+
 /*-----------------------------------------------------------------------*/
 /* Get Drive Status                                                      */
 /*-----------------------------------------------------------------------*/
@@ -36,7 +51,7 @@ DSTATUS disk_status (
 	case DEV_RAM :
 		result = RAM_disk_status();
 
-		// translate the reslut code here
+		stat = result;
 
 		return stat;
 #endif
@@ -78,7 +93,7 @@ DSTATUS disk_initialize (
 	case DEV_RAM :
 		result = RAM_disk_initialize();
 
-		// translate the reslut code here
+		stat = result;
 
 		return stat;
 #endif
@@ -87,6 +102,13 @@ DSTATUS disk_initialize (
 		result = SDMMC_initialize();
 
 		stat = result;// translate the reslut code here
+#ifdef __CONFIG_FATFS_BLK_CACHE
+		/* (re)mount, the medium may have been changed */
+		if (!mmc_cache_ready)
+			mmc_cache_ready = (blk_cache_init(&mmc_cache, SDMMC_read, SDMMC_write) == 0);
+		else
+			blk_cache_invalidate(&mmc_cache);
+#endif
 
 		return stat;
 
@@ -125,7 +147,7 @@ DRESULT disk_read (
 
 		result = RAM_disk_read(buff, sector, count);
 
-		// translate the reslut code here
+		res = result;
 
 		return res;
 #endif
@@ -133,6 +155,11 @@ DRESULT disk_read (
 	case DEV_MMC :
 		// translate the arguments here
 
+#ifdef __CONFIG_FATFS_BLK_CACHE
+		if (mmc_cache_ready)
+			result = blk_cache_read(&mmc_cache, buff, sector, count);
+		else
+#endif
 		result = SDMMC_read(buff, sector, count);
 
 		res = result;// translate the reslut code here
@@ -177,7 +204,7 @@ DRESULT disk_write (
 
 		result = RAM_disk_write(buff, sector, count);
 
-		// translate the reslut code here
+		res = result;
 
 		return res;
 #endif
@@ -185,6 +212,11 @@ DRESULT disk_write (
 	case DEV_MMC :
 		// translate the arguments here
 
+#ifdef __CONFIG_FATFS_BLK_CACHE
+		if (mmc_cache_ready)
+			result = blk_cache_write(&mmc_cache, buff, sector, count);
+		else
+#endif
 		result = SDMMC_write(buff, sector, count);
 
 		res = result;// translate the reslut code here
@@ -225,13 +257,28 @@ DRESULT disk_ioctl (
 #if (SUPPORT_DEV_RAM)
 	case DEV_RAM :
 
-		// Process of the command for the RAM drive
+		result = RAM_disk_ioctl(cmd, buff);
+
+		res = result;
 
 		return res;
 #endif
 
 	case DEV_MMC :
 
+#ifdef __CONFIG_FATFS_BLK_CACHE
+		if (mmc_cache_ready) {
+			if (cmd == CTRL_VOLUME_AREA) {
+				blk_cache_set_area(&mmc_cache, buff);
+				return RES_OK;
+			}
+			if (cmd == CTRL_SYNC) {
+				res = blk_cache_sync(&mmc_cache);
+				if (res != RES_OK)
+					return res;
+			}
+		}
+#endif
 		result = SDMMC_ioctl(cmd, buff);// Process of the command for the MMC/SD card
 
 		res = result;
@@ -0,0 +1,409 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "blk_cache.h"
+
+#define BLK_F_VALID		(1 << 0)
+#define BLK_F_DIRTY		(1 << 1)
+#define BLK_F_FAT		(1 << 2)
+
+#define BLK_DATA(c, i)	((c)->data + (i) * BLK_CACHE_SECTOR_SIZE)
+
+static int blk_find(blk_cache_t *c, DWORD sector)
+{
+	int i;
+
+	for (i = 0; i < BLK_CACHE_SECTORS; ++i) {
+		if ((c->entry[i].flags & BLK_F_VALID) && c->entry[i].sector == sector)
+			return i;
+	}
+	return -1;
+}
+
+static int blk_is_fat(blk_cache_t *c, DWORD sector)
+{
+	return (sector >= c->fat_start && sector < c->fat_end);
+}
+
+static void blk_touch(blk_cache_t *c, int i)
+{
+	c->entry[i].stamp = ++c->clock;
+}
+
+static void blk_drop(blk_cache_t *c, int i)
+{
+	struct blk_cache_entry *e = &c->entry[i];
+
+	if (e->flags & BLK_F_FAT)
+		c->fat_cnt--;
+	if (e->flags & BLK_F_DIRTY)
+		c->dirty_cnt--;
+	e->flags = 0;
+	e->stamp = 0;
+}
+
+static DRESULT blk_dev_read(blk_cache_t *c, BYTE *buff, DWORD sector, UINT count)
+{
+	c->stats.dev_read++;
+	c->stats.dev_read_sectors += count;
+	return c->read(buff, sector, count);
+}
+
+static DRESULT blk_dev_write(blk_cache_t *c, const BYTE *buff, DWORD sector, UINT count)
+{
+	c->stats.dev_write++;
+	c->stats.dev_write_sectors += count;
+	return c->write(buff, sector, count);
+}
+
+static int blk_find_dirty(blk_cache_t *c, DWORD sector)
+{
+	int i = blk_find(c, sector);
+
+	if (i >= 0 && (c->entry[i].flags & BLK_F_DIRTY))
+		return i;
+	return -1;
+}
+
+/* write the dirty sectors from sector on, up to BLK_CACHE_RUN_MAX, at once */
+static DRESULT blk_write_run(blk_cache_t *c, DWORD sector)
+{
+	int idx[BLK_CACHE_RUN_MAX];
+	UINT n = 0;
+	UINT k;
+	DRESULT res;
+
+	while (n < BLK_CACHE_RUN_MAX && (idx[n] = blk_find_dirty(c, sector + n)) >= 0) {
+		memcpy(c->run + n * BLK_CACHE_SECTOR_SIZE, BLK_DATA(c, idx[n]),
+		       BLK_CACHE_SECTOR_SIZE);
+		n++;
+	}
+	if (n == 0)
+		return RES_OK;
+
+	res = blk_dev_write(c, c->run, sector, n);
+	if (res == RES_OK) {
+		for (k = 0; k < n; ++k) {
+			c->entry[idx[k]].flags &= ~BLK_F_DIRTY;
+			c->dirty_cnt--;
+		}
+	}
+	return res;
+}
+
+/* write back entry i, together with the dirty sectors around it */
+static DRESULT blk_write_back(blk_cache_t *c, int i)
+{
+	DWORD start = c->entry[i].sector;
+	UINT n = 1;
+
+	while (n < BLK_CACHE_RUN_MAX && start > 0 && blk_find_dirty(c, start - 1) >= 0) {
+		start--;
+		n++;
+	}
+	return blk_write_run(c, start);
+}
+
+/* least recently used entry, FAT sectors only if there are too many of them */
+static int blk_victim(blk_cache_t *c)
+{
+	int i;
+	int lru = -1;
+	int lru_data = -1;
+
+	for (i = 0; i < BLK_CACHE_SECTORS; ++i) {
+		if (!(c->entry[i].flags & BLK_F_VALID))
+			return i;
+		if (lru < 0 || c->entry[i].stamp < c->entry[lru].stamp)
+			lru = i;
+		if (!(c->entry[i].flags & BLK_F_FAT) &&
+		    (lru_data < 0 || c->entry[i].stamp < c->entry[lru_data].stamp))
+			lru_data = i;
+	}
+	if (lru_data >= 0 && c->fat_cnt <= BLK_CACHE_FAT_MAX)
+		return lru_data;
+	return lru;
+}
+
+static int blk_alloc(blk_cache_t *c, DWORD sector)
+{
+	int i = blk_victim(c);
+	struct blk_cache_entry *e = &c->entry[i];
+
+	if ((e->flags & BLK_F_DIRTY) && blk_write_back(c, i) != RES_OK)
+		return -1;
+	if (e->flags & BLK_F_VALID)
+		blk_drop(c, i);
+
+	e->sector = sector;
+	e->flags = BLK_F_VALID;
+	if (blk_is_fat(c, sector)) {
+		e->flags |= BLK_F_FAT;
+		c->fat_cnt++;
+	}
+	blk_touch(c, i);
+	return i;
+}
+
+/**
+ * @brief Set up the cache in front of a block device
+ * @param[in] cache Pointer to the cache
+ * @param[in] read Read sectors from the device
+ * @param[in] write Write sectors to the device
+ * @retval 0 on success, -1 if out of memory (the device is accessed directly)
+ */
+int blk_cache_init(blk_cache_t *cache, blk_dev_read_t read, blk_dev_write_t write)
+{
+	memset(cache, 0, sizeof(*cache));
+	cache->read = read;
+	cache->write = write;
+	cache->data = malloc((BLK_CACHE_SECTORS + BLK_CACHE_RUN_MAX) * BLK_CACHE_SECTOR_SIZE);
+	if (cache->data == NULL)
+		return -1;
+	cache->run = BLK_DATA(cache, BLK_CACHE_SECTORS);
+	return 0;
+}
+
+void blk_cache_deinit(blk_cache_t *cache)
+{
+	if (cache->data) {
+		free(cache->data);
+		cache->data = NULL;
+	}
+}
+
+/**
+ * @brief Forget all the cached sectors, dirty ones included (e.g. the medium
+ *        was changed)
+ */
+void blk_cache_invalidate(blk_cache_t *cache)
+{
+	int i;
+
+	for (i = 0; i < BLK_CACHE_SECTORS; ++i)
+		blk_drop(cache, i);
+	cache->next = 0;
+}
+
+/**
+ * @brief Tell the layout of the volume
+ * @param[in] area {FAT start sector, number of FAT sectors, end sector of
+ *                 the volume}
+ */
+void blk_cache_set_area(blk_cache_t *cache, const DWORD *area)
+{
+	int i;
+	struct blk_cache_entry *e;
+
+	cache->fat_start = area[0];
+	cache->fat_end = area[0] + area[1];
+	cache->vol_end = area[2];
+	cache->fat_cnt = 0;
+	for (i = 0; i < BLK_CACHE_SECTORS; ++i) {
+		e = &cache->entry[i];
+		e->flags &= ~BLK_F_FAT;
+		if ((e->flags & BLK_F_VALID) && blk_is_fat(cache, e->sector)) {
+			e->flags |= BLK_F_FAT;
+			cache->fat_cnt++;
+		}
+	}
+}
+
+/* read the missing sectors from sector on, n of them requested */
+static DRESULT blk_fill(blk_cache_t *c, DWORD sector, UINT n, UINT ahead)
+{
+	int idx[BLK_CACHE_RUN_MAX];
+	UINT k;
+	DRESULT res;
+
+	/* entries first, evicting may need the run buffer */
+	for (k = 0; k < n + ahead; ++k) {
+		idx[k] = blk_alloc(c, sector + k);
+		if (idx[k] < 0) {
+			while (k-- > 0)
+				blk_drop(c, idx[k]);
+			return RES_ERROR;
+		}
+	}
+
+	res = blk_dev_read(c, c->run, sector, n + ahead);
+	if (res != RES_OK && ahead > 0) {
+		/* may be past the end of the medium */
+		for (k = n; k < n + ahead; ++k)
+			blk_drop(c, idx[k]);
+		ahead = 0;
+		res = blk_dev_read(c, c->run, sector, n);
+	}
+	if (res != RES_OK) {
+		for (k = 0; k < n; ++k)
+			blk_drop(c, idx[k]);
+		return res;
+	}
+
+	for (k = 0; k < n + ahead; ++k) {
+		memcpy(BLK_DATA(c, idx[k]), c->run + k * BLK_CACHE_SECTOR_SIZE,
+		       BLK_CACHE_SECTOR_SIZE);
+	}
+	return RES_OK;
+}
+
+DRESULT blk_cache_read(blk_cache_t *cache, BYTE *buff, DWORD sector, UINT count)
+{
+	int i;
+	UINT n;
+	UINT ahead;
+	DRESULT res;
+	int sequential = (sector == cache->next);
+
+	if (cache->data == NULL)
+		return cache->read(buff, sector, count);
+
+	cache->next = sector + count;
+
+	if (count >= BLK_CACHE_BYPASS) {
+		res = blk_dev_read(cache, buff, sector, count);
+		if (res != RES_OK || cache->dirty_cnt == 0)
+			return res;
+		/* newer data not written yet */
+		for (i = 0; i < BLK_CACHE_SECTORS; ++i) {
+			if ((cache->entry[i].flags & BLK_F_DIRTY) &&
+			    cache->entry[i].sector - sector < count) {
+				memcpy(buff + (cache->entry[i].sector - sector) * BLK_CACHE_SECTOR_SIZE,
+				       BLK_DATA(cache, i), BLK_CACHE_SECTOR_SIZE);
+			}
+		}
+		return RES_OK;
+	}
+
+	while (count > 0) {
+		i = blk_find(cache, sector);
+		if (i >= 0) {
+			cache->stats.hit++;
+			blk_touch(cache, i);
+			memcpy(buff, BLK_DATA(cache, i), BLK_CACHE_SECTOR_SIZE);
+			buff += BLK_CACHE_SECTOR_SIZE;
+			sector++;
+			count--;
+			continue;
+		}
+
+		/* the missing sectors requested, and following ones if sequential */
+		n = 1;
+		while (n < count && blk_find(cache, sector + n) < 0)
+			n++;
+		ahead = 0;
+		while (sequential && n + ahead < BLK_CACHE_RUN_MAX &&
+		       (cache->vol_end == 0 || sector + n + ahead < cache->vol_end) &&
+		       blk_find(cache, sector + n + ahead) < 0)
+			ahead++;
+
+		res = blk_fill(cache, sector, n, ahead);
+		if (res != RES_OK)
+			return res;
+		cache->stats.miss += n;
+		memcpy(buff, cache->run, n * BLK_CACHE_SECTOR_SIZE);
+		buff += n * BLK_CACHE_SECTOR_SIZE;
+		sector += n;
+		count -= n;
+	}
+	return RES_OK;
+}
+
+DRESULT blk_cache_write(blk_cache_t *cache, const BYTE *buff, DWORD sector, UINT count)
+{
+	int i;
+	DRESULT res;
+
+	if (cache->data == NULL)
+		return cache->write(buff, sector, count);
+
+	if (count >= BLK_CACHE_BYPASS) {
+		res = blk_dev_write(cache, buff, sector, count);
+		if (res != RES_OK)
+			return res;
+		/* keep the cached copies up to date, and clean */
+		for (i = 0; i < BLK_CACHE_SECTORS; ++i) {
+			if ((cache->entry[i].flags & BLK_F_VALID) &&
+			    cache->entry[i].sector - sector < count) {
+				memcpy(BLK_DATA(cache, i),
+				       buff + (cache->entry[i].sector - sector) * BLK_CACHE_SECTOR_SIZE,
+				       BLK_CACHE_SECTOR_SIZE);
+				if (cache->entry[i].flags & BLK_F_DIRTY) {
+					cache->entry[i].flags &= ~BLK_F_DIRTY;
+					cache->dirty_cnt--;
+				}
+			}
+		}
+		return RES_OK;
+	}
+
+	while (count > 0) {
+		i = blk_find(cache, sector);
+		if (i < 0) {
+			i = blk_alloc(cache, sector);
+			if (i < 0)
+				return RES_ERROR;
+		}
+		blk_touch(cache, i);
+		memcpy(BLK_DATA(cache, i), buff, BLK_CACHE_SECTOR_SIZE);
+		if (!(cache->entry[i].flags & BLK_F_DIRTY)) {
+			cache->entry[i].flags |= BLK_F_DIRTY;
+			cache->dirty_cnt++;
+		}
+		buff += BLK_CACHE_SECTOR_SIZE;
+		sector++;
+		count--;
+	}
+	return RES_OK;
+}
+
+/**
+ * @brief Write all the dirty sectors to the device, in ascending order
+ */
+DRESULT blk_cache_sync(blk_cache_t *cache)
+{
+	int i;
+	int first;
+	DRESULT res;
+
+	while (cache->dirty_cnt > 0) {
+		first = -1;
+		for (i = 0; i < BLK_CACHE_SECTORS; ++i) {
+			if ((cache->entry[i].flags & BLK_F_DIRTY) &&
+			    (first < 0 || cache->entry[i].sector < cache->entry[first].sector))
+				first = i;
+		}
+		res = blk_write_run(cache, cache->entry[first].sector);
+		if (res != RES_OK)
+			return res;
+	}
+	return RES_OK;
+}
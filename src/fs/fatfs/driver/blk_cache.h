@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _BLK_CACHE_H_
+#define _BLK_CACHE_H_
+
+#include <stdint.h>
+#include "fs/fatfs/integer.h"
+#include "fs/fatfs/diskio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Write-back sector cache between FatFs and a block device.
+ *  - LRU replacement, sectors of the FAT are kept in preference to data
+ *  - a read miss following the previous read is extended by read ahead
+ *  - dirty sectors are written back in runs of consecutive sectors, each run
+ *    in one multi-block write, on eviction and on CTRL_SYNC
+ *  - requests of BLK_CACHE_BYPASS sectors or more go to the device directly
+ * The caller serializes the access (FatFs locks the volume).
+ */
+
+#define BLK_CACHE_SECTOR_SIZE	512
+
+#ifndef BLK_CACHE_SECTORS
+#define BLK_CACHE_SECTORS		32	/* cached sectors */
+#endif
+
+#ifndef BLK_CACHE_RUN_MAX
+#define BLK_CACHE_RUN_MAX		8	/* max sectors of a read ahead or write back */
+#endif
+
+#ifndef BLK_CACHE_BYPASS
+#define BLK_CACHE_BYPASS		BLK_CACHE_RUN_MAX
+#endif
+
+#ifndef BLK_CACHE_FAT_MAX
+#define BLK_CACHE_FAT_MAX		(BLK_CACHE_SECTORS / 2)	/* max FAT sectors preferred */
+#endif
+
+typedef DRESULT (*blk_dev_read_t)(BYTE *buff, DWORD sector, UINT count);
+typedef DRESULT (*blk_dev_write_t)(const BYTE *buff, DWORD sector, UINT count);
+
+struct blk_cache_stats {
+	uint32_t	hit;
+	uint32_t	miss;
+	uint32_t	dev_read;		/* device read commands */
+	uint32_t	dev_read_sectors;
+	uint32_t	dev_write;		/* device write commands */
+	uint32_t	dev_write_sectors;
+};
+
+struct blk_cache_entry {
+	DWORD		sector;
+	uint32_t	stamp;			/* last access, 0 if unused */
+	uint8_t		flags;
+};
+
+typedef struct blk_cache {
+	blk_dev_read_t	read;
+	blk_dev_write_t	write;
+	uint8_t		   *data;		/* BLK_CACHE_SECTORS sectors */
+	uint8_t		   *run;		/* BLK_CACHE_RUN_MAX sectors */
+	struct blk_cache_entry entry[BLK_CACHE_SECTORS];
+	uint32_t		clock;
+	DWORD			next;		/* sector following the last read */
+	DWORD			fat_start;
+	DWORD			fat_end;
+	DWORD			vol_end;	/* read ahead stops here, 0 if unknown */
+	uint16_t		fat_cnt;
+	uint16_t		dirty_cnt;
+	struct blk_cache_stats stats;
+} blk_cache_t;
+
+int blk_cache_init(blk_cache_t *cache, blk_dev_read_t read, blk_dev_write_t write);
+void blk_cache_deinit(blk_cache_t *cache);
+void blk_cache_invalidate(blk_cache_t *cache);
+void blk_cache_set_area(blk_cache_t *cache, const DWORD *area);
+DRESULT blk_cache_read(blk_cache_t *cache, BYTE *buff, DWORD sector, UINT count);
+DRESULT blk_cache_write(blk_cache_t *cache, const BYTE *buff, DWORD sector, UINT count);
+DRESULT blk_cache_sync(blk_cache_t *cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BLK_CACHE_H_ */
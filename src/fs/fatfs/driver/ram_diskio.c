@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include "ram_diskio.h"
+
+static BYTE *ram_disk_mem;
+static DWORD ram_disk_sectors;
+static DSTATUS ram_disk_stat = STA_NOINIT;
+
+int RAM_disk_setup(void *mem, DWORD size)
+{
+	if (mem == NULL && size != 0)
+		return -1;
+
+	ram_disk_mem = mem;
+	ram_disk_sectors = size / RAM_DISK_SECTOR_SIZE;
+	ram_disk_stat = STA_NOINIT;
+	return 0;
+}
+
+DSTATUS RAM_disk_initialize(void)
+{
+	if (ram_disk_sectors == 0)
+		ram_disk_stat = STA_NOINIT | STA_NODISK;
+	else
+		ram_disk_stat = 0;
+	return ram_disk_stat;
+}
+
+DSTATUS RAM_disk_status(void)
+{
+	return ram_disk_stat;
+}
+
+static int RAM_disk_check(DWORD sector, UINT count)
+{
+	return !(ram_disk_stat & STA_NOINIT) &&
+	       sector < ram_disk_sectors && count <= ram_disk_sectors - sector;
+}
+
+DRESULT RAM_disk_read(BYTE *buff, DWORD sector, UINT count)
+{
+	if (ram_disk_stat & STA_NOINIT)
+		return RES_NOTRDY;
+	if (!RAM_disk_check(sector, count))
+		return RES_PARERR;
+
+	memcpy(buff, ram_disk_mem + sector * RAM_DISK_SECTOR_SIZE,
+	       count * RAM_DISK_SECTOR_SIZE);
+	return RES_OK;
+}
+
+DRESULT RAM_disk_write(const BYTE *buff, DWORD sector, UINT count)
+{
+	if (ram_disk_stat & STA_NOINIT)
+		return RES_NOTRDY;
+	if (!RAM_disk_check(sector, count))
+		return RES_PARERR;
+
+	memcpy(ram_disk_mem + sector * RAM_DISK_SECTOR_SIZE, buff,
+	       count * RAM_DISK_SECTOR_SIZE);
+	return RES_OK;
+}
+
+DRESULT RAM_disk_ioctl(BYTE cmd, void *buff)
+{
+	if (ram_disk_stat & STA_NOINIT)
+		return RES_NOTRDY;
+
+	switch (cmd) {
+	case CTRL_SYNC:
+		return RES_OK;
+	case GET_SECTOR_COUNT:
+		*(DWORD *)buff = ram_disk_sectors;
+		return RES_OK;
+	case GET_SECTOR_SIZE:
+		*(WORD *)buff = RAM_DISK_SECTOR_SIZE;
+		return RES_OK;
+	case GET_BLOCK_SIZE:
+		*(DWORD *)buff = 1;
+		return RES_OK;
+	default:
+		return RES_PARERR;
+	}
+}
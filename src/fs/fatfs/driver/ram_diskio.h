@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _RAM_DISKIO_H_
+#define _RAM_DISKIO_H_
+
+#include "fs/fatfs/integer.h"
+#include "fs/fatfs/ffconf.h"
+#include "fs/fatfs/ff.h"
+#include "fs/fatfs/diskio.h"
+
+#define RAM_DISK_SECTOR_SIZE	512
+
+/*
+ * RAM disk on a caller supplied buffer, physical drive 1 (volume "1:").
+ * The buffer must stay valid while the volume is mounted, a fresh buffer
+ * has to be formatted by f_mkfs (_USE_MKFS) or filled with an image first.
+ */
+int RAM_disk_setup(void *mem, DWORD size);
+
+DSTATUS RAM_disk_initialize(void);
+DSTATUS RAM_disk_status(void);
+DRESULT RAM_disk_read(BYTE *buff, DWORD sector, UINT count);
+DRESULT RAM_disk_write(const BYTE *buff, DWORD sector, UINT count);
+DRESULT RAM_disk_ioctl(BYTE cmd, void *buff);
+
+#endif /* _RAM_DISKIO_H_ */
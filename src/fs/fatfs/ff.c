@@ -516,6 +516,27 @@ typedef struct {
 #endif
 
 
+/* Extent map */
+#if _USE_EXTMAP < 0 || _USE_EXTMAP > 255
+#error Wrong _USE_EXTMAP setting
+#endif
+#if _USE_EXTMAP
+#if _EXTMAP_FILES < 1
+#error Wrong _EXTMAP_FILES setting
+#endif
+typedef struct {
+	FIL* fp;		/* File object owning the map (NULL:blank entry) */
+	BYTE cnt;		/* Number of extents in ext[] */
+	BYTE last;		/* Extent used last, the chain is usually followed from it */
+	struct {
+		DWORD ofs;	/* Cluster order of the extent from the top of the file */
+		DWORD clst;	/* First cluster# of the extent */
+		DWORD len;	/* Number of contiguous clusters */
+	} ext[_USE_EXTMAP];	/* Extents sorted by ofs, built as the chain is followed (emptied on open) */
+} XMAP;
+#endif
+
+
 
 
 
@@ -543,6 +564,10 @@ static BYTE CurrVol;			/* Current drive */
 static FILESEM Files[_FS_LOCK];	/* Open object lock semaphores */
 #endif
 
+#if _USE_EXTMAP
+static XMAP XMaps[_VOLUMES][_EXTMAP_FILES];	/* Extent maps of the open files, per volume (guarded by its lock) */
+#endif
+
 #if _USE_LFN == 0		/* Non-LFN configuration */
 #define	DEF_NAMBUF
 #define INIT_NAMBUF(fs)
@@ -1464,6 +1489,242 @@ DWORD clmt_clust (	/* <2:Error, >=2:Cluster number */
 
 
 
+#if _USE_EXTMAP
+/*-----------------------------------------------------------------------*/
+/* FAT handling - Get the extent map of the file                         */
+/*-----------------------------------------------------------------------*/
+
+static
+XMAP* xmap_get (	/* NULL:The file has no map, !NULL:Extent map of the file */
+	FIL* fp			/* Pointer to the file object */
+)
+{
+	UINT vol, i;
+
+
+	for (vol = 0; vol < _VOLUMES && FatFs[vol] != fp->obj.fs; vol++) ;
+	if (vol == _VOLUMES) return 0;
+	for (i = 0; i < _EXTMAP_FILES; i++) {
+		if (XMaps[vol][i].fp == fp) return &XMaps[vol][i];
+	}
+	return 0;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* FAT handling - Give an empty extent map to the file being opened      */
+/*-----------------------------------------------------------------------*/
+
+static
+void xmap_open (
+	FIL* fp			/* Pointer to the file object, obj.fs is valid */
+)
+{
+	UINT vol, i, be;
+
+
+	for (vol = 0; vol < _VOLUMES && FatFs[vol] != fp->obj.fs; vol++) ;
+	if (vol == _VOLUMES) return;
+	for (i = 0, be = _EXTMAP_FILES; i < _EXTMAP_FILES; i++) {
+		if (XMaps[vol][i].fp == fp) break;		/* Reopened without closing */
+		if (!XMaps[vol][i].fp && be == _EXTMAP_FILES) be = i;
+	}
+	if (i == _EXTMAP_FILES) i = be;
+	if (i == _EXTMAP_FILES) return;		/* No free entry, the file goes without a map */
+	XMaps[vol][i].fp = fp;
+	XMaps[vol][i].cnt = 0;
+	XMaps[vol][i].last = 0;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* FAT handling - Release the extent map of the file                     */
+/*-----------------------------------------------------------------------*/
+
+static
+void xmap_close (
+	FIL* fp			/* Pointer to the file object */
+)
+{
+	UINT vol, i;
+
+
+	for (vol = 0; vol < _VOLUMES; vol++) {
+		for (i = 0; i < _EXTMAP_FILES; i++) {
+			if (XMaps[vol][i].fp == fp) XMaps[vol][i].fp = 0;
+		}
+	}
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* FAT handling - Release the extent maps of the volume                  */
+/*-----------------------------------------------------------------------*/
+
+static
+void xmap_clear (
+	UINT vol		/* Logical drive number */
+)
+{
+	UINT i;
+
+
+	for (i = 0; i < _EXTMAP_FILES; i++) XMaps[vol][i].fp = 0;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* FAT handling - Look up the extent map                                 */
+/*-----------------------------------------------------------------------*/
+
+static
+DWORD xmap_find (	/* 0:Nothing mapped at or below *ci, >=2:Cluster number at *ci */
+	FIL* fp,		/* Pointer to the file object */
+	DWORD* ci		/* Cluster order to find, lowered to the nearest mapped one if not mapped */
+)
+{
+	XMAP *xm = xmap_get(fp);
+	UINT lo, hi, i;
+
+
+	if (!xm || xm->cnt == 0 || xm->ext[0].ofs > *ci) return 0;
+	lo = 0; hi = xm->cnt - 1;
+	while (lo < hi) {				/* Find the last extent starting at or below *ci */
+		i = (lo + hi + 1) / 2;
+		if (xm->ext[i].ofs <= *ci) lo = i; else hi = i - 1;
+	}
+	xm->last = (BYTE)lo;
+	if (*ci - xm->ext[lo].ofs >= xm->ext[lo].len) {	/* Beyond the extent, continue from its last cluster */
+		*ci = xm->ext[lo].ofs + xm->ext[lo].len - 1;
+	}
+	return xm->ext[lo].clst + (*ci - xm->ext[lo].ofs);
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* FAT handling - Get a cluster from the extent map if mapped            */
+/*-----------------------------------------------------------------------*/
+
+static
+DWORD xmap_clust (	/* 0:Not mapped, >=2:Cluster number */
+	FIL* fp,		/* Pointer to the file object */
+	DWORD ci		/* Cluster order from top of the file */
+)
+{
+	DWORD mci = ci, clst;
+
+
+	clst = xmap_find(fp, &mci);
+	return (mci == ci) ? clst : 0;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* FAT handling - Record a cluster of the file in the extent map         */
+/*-----------------------------------------------------------------------*/
+
+static
+void xmap_put (
+	FIL* fp,		/* Pointer to the file object */
+	DWORD ci,		/* Cluster order from top of the file */
+	DWORD clst		/* Cluster number at ci */
+)
+{
+	XMAP *xm = xmap_get(fp);
+	UINT n, i, k, v;
+	DWORD gap, vgap, prev, next;
+
+
+	if (!xm) return;
+	n = xm->cnt;
+
+	/* Find the extent ending at or covering ci, the last used one first */
+	i = xm->last;
+	if (i >= n || ci < xm->ext[i].ofs || ci > xm->ext[i].ofs + xm->ext[i].len) {
+		for (k = 0; k < n && xm->ext[k].ofs <= ci; k++) ;
+		i = k - 1;					/* (n or k == 0 makes it invalid) */
+	}
+	if (i < n && ci - xm->ext[i].ofs <= xm->ext[i].len) {
+		xm->last = (BYTE)i;
+		if (ci - xm->ext[i].ofs < xm->ext[i].len) return;		/* Already mapped */
+		if (i + 1 < n && xm->ext[i + 1].ofs == ci) {			/* Mapped by the following extent */
+			xm->last = (BYTE)(i + 1);
+			return;
+		}
+		if (clst == xm->ext[i].clst + xm->ext[i].len) {		/* Contiguous, stretch the extent */
+			xm->ext[i].len++;
+			if (i + 1 < n && xm->ext[i + 1].ofs == ci + 1 && xm->ext[i + 1].clst == clst + 1) {
+				xm->ext[i].len += xm->ext[i + 1].len;		/* Merge with the following extent */
+				for (k = i + 1; k + 1 < n; k++) xm->ext[k] = xm->ext[k + 1];
+				xm->cnt--;
+			}
+			return;
+		}
+	}
+	for (k = 0; k < n && xm->ext[k].ofs <= ci; k++) ;	/* Insert position */
+
+	if (n == _USE_EXTMAP) {			/* Map is full, drop the extent leaving the smallest unmapped gap */
+		v = 0; vgap = 0xFFFFFFFF;
+		for (i = 0; i < n; i++) {
+			if (i == k) prev = ci + 1;
+			else prev = i ? xm->ext[i - 1].ofs + xm->ext[i - 1].len : 0;
+			if (i + 1 == k) next = ci;
+			else next = (i + 1 < n) ? xm->ext[i + 1].ofs : xm->ext[i].ofs + xm->ext[i].len;
+			gap = next - prev;
+			if (gap < vgap) { v = i; vgap = gap; }
+		}
+		for (i = v; i + 1 < n; i++) xm->ext[i] = xm->ext[i + 1];
+		if (v < k) k--;
+		n--;
+	}
+	for (i = n; i > k; i--) xm->ext[i] = xm->ext[i - 1];
+	xm->ext[k].ofs = ci;
+	xm->ext[k].clst = clst;
+	xm->ext[k].len = 1;
+	xm->cnt = (BYTE)(n + 1);
+	xm->last = (BYTE)k;
+}
+
+
+
+#if !_FS_READONLY && _FS_MINIMIZE == 0
+/*-----------------------------------------------------------------------*/
+/* FAT handling - Forget the clusters removed from the file              */
+/*-----------------------------------------------------------------------*/
+
+static
+void xmap_cut (
+	FIL* fp,		/* Pointer to the file object */
+	DWORD ncl		/* Number of clusters left in the file */
+)
+{
+	XMAP *xm = xmap_get(fp);
+	UINT n;
+
+
+	if (!xm) return;
+	n = xm->cnt;
+
+	while (n && xm->ext[n - 1].ofs >= ncl) n--;
+	if (n && xm->ext[n - 1].ofs + xm->ext[n - 1].len > ncl) {
+		xm->ext[n - 1].len = ncl - xm->ext[n - 1].ofs;
+	}
+	xm->cnt = (BYTE)n;
+	xm->last = 0;
+}
+#endif
+
+#endif	/* _USE_EXTMAP */
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Directory handling - Set directory index                              */
 /*-----------------------------------------------------------------------*/
@@ -3164,6 +3425,11 @@ FRESULT find_volume (	/* FR_OK(0): successful, !=0: any error occurred */
 		}
 		if (fs->fsize < (szbfat + (SS(fs) - 1)) / SS(fs)) return FR_NO_FILESYSTEM;	/* (BPB_FATSz must not be less than the size needed) */
 
+		br[0] = fs->fatbase;							/* Let the driver know the FAT area (e.g. to keep it cached) */
+		br[1] = fasize;
+		br[2] = fs->database + nclst * fs->csize;
+		disk_ioctl(fs->drv, CTRL_VOLUME_AREA, br);		/* (Optional, drivers may not support it) */
+
 #if !_FS_READONLY
 		/* Get FSINFO if available */
 		fs->last_clst = fs->free_clst = 0xFFFFFFFF;		/* Initialize cluster allocation information */
@@ -3203,6 +3469,9 @@ FRESULT find_volume (	/* FR_OK(0): successful, !=0: any error occurred */
 #endif
 #if _FS_LOCK != 0			/* Clear file lock semaphores */
 	clear_lock(fs);
+#endif
+#if _USE_EXTMAP				/* Release extent maps of the files opened before */
+	xmap_clear((UINT)vol);
 #endif
 	return FR_OK;
 }
@@ -3269,6 +3538,9 @@ FRESULT f_mount (
 #if _FS_LOCK != 0
 		clear_lock(cfs);
 #endif
+#if _USE_EXTMAP
+		xmap_clear((UINT)vol);
+#endif
 #if _FS_REENTRANT						/* Discard sync object of the current volume */
 		if (!ff_del_syncobj(cfs->sobj)) return FR_INT_ERR;
 #endif
@@ -3452,6 +3724,9 @@ FRESULT f_open (
 #endif
 			fp->obj.fs = fs;	 	/* Validate the file object */
 			fp->obj.id = fs->id;
+#if _USE_EXTMAP
+			xmap_open(fp);			/* Get an empty extent map */
+#endif
 			fp->flag = mode;		/* Set file access mode */
 			fp->err = 0;			/* Clear error flag */
 			fp->sect = 0;			/* Invalidate current data sector */
@@ -3464,10 +3739,16 @@ FRESULT f_open (
 				fp->fptr = fp->obj.objsize;			/* Offset to seek */
 				bcs = (DWORD)fs->csize * SS(fs);	/* Cluster size in byte */
 				clst = fp->obj.sclust;				/* Follow the cluster chain */
+#if _USE_EXTMAP
+				xmap_put(fp, 0, clst);
+#endif
 				for (ofs = fp->obj.objsize; res == FR_OK && ofs > bcs; ofs -= bcs) {
 					clst = get_fat(&fp->obj, clst);
 					if (clst <= 1) res = FR_INT_ERR;
 					if (clst == 0xFFFFFFFF) res = FR_DISK_ERR;
+#if _USE_EXTMAP
+					if (res == FR_OK) xmap_put(fp, (DWORD)((fp->obj.objsize - ofs) / bcs) + 1, clst);
+#endif
 				}
 				fp->clust = clst;
 				if (res == FR_OK && ofs % SS(fs)) {	/* Fill sector buffer if not on the sector boundary */
@@ -3487,6 +3768,9 @@ FRESULT f_open (
 		FREE_NAMBUF();
 	}
 
+#if _USE_EXTMAP
+	if (res != FR_OK) xmap_close(fp);
+#endif
 	if (res != FR_OK) fp->obj.fs = 0;	/* Invalidate file object on error */
 
 	LEAVE_FF(fs, res);
@@ -3535,12 +3819,19 @@ FRESULT f_read (
 					} else
 #endif
 					{
+#if _USE_EXTMAP
+						clst = xmap_clust(fp, (DWORD)(fp->fptr / SS(fs) / fs->csize));	/* Get cluster# from the extent map */
+						if (!clst)
+#endif
 						clst = get_fat(&fp->obj, fp->clust);	/* Follow cluster chain on the FAT */
 					}
 				}
 				if (clst < 2) ABORT(fs, FR_INT_ERR);
 				if (clst == 0xFFFFFFFF) ABORT(fs, FR_DISK_ERR);
 				fp->clust = clst;				/* Update current cluster */
+#if _USE_EXTMAP
+				xmap_put(fp, (DWORD)(fp->fptr / SS(fs) / fs->csize), clst);
+#endif
 			}
 			sect = clust2sect(fs, fp->clust);	/* Get current sector */
 			if (!sect) ABORT(fs, FR_INT_ERR);
@@ -3640,6 +3931,10 @@ FRESULT f_write (
 					} else
 #endif
 					{
+#if _USE_EXTMAP
+						clst = xmap_clust(fp, (DWORD)(fp->fptr / SS(fs) / fs->csize));	/* Get cluster# from the extent map */
+						if (!clst)
+#endif
 						clst = create_chain(&fp->obj, fp->clust);	/* Follow or stretch cluster chain on the FAT */
 					}
 				}
@@ -3648,6 +3943,9 @@ FRESULT f_write (
 				if (clst == 0xFFFFFFFF) ABORT(fs, FR_DISK_ERR);
 				fp->clust = clst;			/* Update current cluster */
 				if (fp->obj.sclust == 0) fp->obj.sclust = clst;	/* Set start cluster if the first write */
+#if _USE_EXTMAP
+				xmap_put(fp, (DWORD)(fp->fptr / SS(fs) / fs->csize), clst);
+#endif
 			}
 #if _FS_TINY
 			if (fs->winsect == fp->sect && sync_window(fs) != FR_OK) ABORT(fs, FR_DISK_ERR);	/* Write-back sector cache */
@@ -3820,6 +4118,9 @@ FRESULT f_close (
 			if (res == FR_OK)
 #endif
 			{
+#if _USE_EXTMAP
+				xmap_close(fp);			/* Release the extent map */
+#endif
 				fp->obj.fs = 0;			/* Invalidate file object */
 			}
 #if _FS_REENTRANT
@@ -3998,6 +4299,9 @@ FRESULT f_lseek (
 	FATFS *fs;
 	DWORD clst, bcs, nsect;
 	FSIZE_t ifptr;
+#if _USE_EXTMAP
+	DWORD ci, xcl;
+#endif
 #if _USE_FASTSEEK
 	DWORD cl, pcl, ncl, tcl, dsc, tlen, ulen, *tbl;
 #endif
@@ -4092,6 +4396,18 @@ FRESULT f_lseek (
 #endif
 				fp->clust = clst;
 			}
+#if _USE_EXTMAP
+			if (clst != 0) {
+				if (fp->fptr == 0) xmap_put(fp, 0, clst);
+				ci = (DWORD)((fp->fptr + ofs - 1) / bcs);	/* Cluster order of the destination */
+				xcl = xmap_find(fp, &ci);				/* Nearest mapped cluster at or below it */
+				if (xcl && (FSIZE_t)ci * bcs > fp->fptr) {	/* Skip the mapped part of the chain */
+					ofs -= (FSIZE_t)ci * bcs - fp->fptr;
+					fp->fptr = (FSIZE_t)ci * bcs;
+					fp->clust = clst = xcl;
+				}
+			}
+#endif
 			if (clst != 0) {
 				while (ofs > bcs) {						/* Cluster following loop */
 					ofs -= bcs; fp->fptr += bcs;
@@ -4113,6 +4429,9 @@ FRESULT f_lseek (
 					if (clst == 0xFFFFFFFF) ABORT(fs, FR_DISK_ERR);
 					if (clst <= 1 || clst >= fs->n_fatent) ABORT(fs, FR_INT_ERR);
 					fp->clust = clst;
+#if _USE_EXTMAP
+					xmap_put(fp, (DWORD)(fp->fptr / bcs), clst);
+#endif
 				}
 				fp->fptr += ofs;
 				if (ofs % SS(fs)) {
@@ -4489,6 +4808,9 @@ FRESULT f_truncate (
 				res = remove_chain(&fp->obj, ncl, fp->clust);
 			}
 		}
+#if _USE_EXTMAP
+		xmap_cut(fp, (DWORD)((fp->fptr + (DWORD)fs->csize * SS(fs) - 1) / ((DWORD)fs->csize * SS(fs))));
+#endif
 		fp->obj.objsize = fp->fptr;	/* Set file size to current R/W point */
 		fp->flag |= FA_MODIFIED;
 #if !_FS_TINY
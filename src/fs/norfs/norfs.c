@@ -0,0 +1,1711 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "kernel/os/os_mutex.h"
+#include "image/flash.h"
+#include "fs/norfs/norfs.h"
+
+#define NORFS_DBG_ON	0
+#define NORFS_WRN_ON	1
+#define NORFS_ERR_ON	1
+
+#define NORFS_LOG(flags, fmt, arg...)	\
+	do {								\
+		if (flags)						\
+			printf(fmt, ##arg);			\
+	} while (0)
+
+#define NORFS_DBG(fmt, arg...)	NORFS_LOG(NORFS_DBG_ON, "[norfs D] "fmt, ##arg)
+#define NORFS_WRN(fmt, arg...)	NORFS_LOG(NORFS_WRN_ON, "[norfs W] "fmt, ##arg)
+#define NORFS_ERR(fmt, arg...)							\
+	do {												\
+		NORFS_LOG(NORFS_ERR_ON, "[norfs E] %s():%d, "fmt,	\
+		          __func__, __LINE__, ##arg);			\
+	} while (0)
+
+#if (NORFS_CHUNK_SIZE > 1020) || (NORFS_CHUNK_SIZE & 3)
+#error "NORFS_CHUNK_SIZE must be a multiple of 4, 1020 at most"
+#endif
+
+#define NORFS_MAGIC			(0x5346524E)	/* "NRFS" */
+#define NORFS_BLK_HDR_SIZE	(20)
+#define NORFS_REC_HDR_SIZE	(16)
+#define NORFS_BLK_CAP		(NORFS_BLOCK_SIZE - NORFS_BLK_HDR_SIZE)
+#define NORFS_BLK_MAX		(4096)
+#define NORFS_REC_ALIGN(n)	(((n) + 3) & ~3U)
+#define NORFS_REC_SIZE(len)	(NORFS_REC_HDR_SIZE + NORFS_REC_ALIGN(len))
+
+/* record state, written after the rest of the record */
+#define NORFS_REC_EMPTY		(0xFF)
+#define NORFS_REC_VALID		(0xA5)
+
+/* record types */
+#define NORFS_REC_INODE		(1)		/* payload: name, arg: id of the file replaced */
+#define NORFS_REC_DATA		(2)		/* payload: data, arg: chunk index */
+#define NORFS_REC_DELETE	(3)		/* size: seq of the first block newer than the file */
+
+#define NORFS_ID_NONE		(0xFFFF)
+#define NORFS_BLK_NONE		(0xFFFF)	/* tombstone not on flash */
+#define NORFS_CHUNK_NONE	(0xFFFFFFFF)
+
+#define NORFS_GC_RESERVE	(1)		/* free blocks kept for reclaiming */
+#define NORFS_WEAR_INTERVAL	(16)	/* reclaims between wear checks */
+#define NORFS_WEAR_DELTA	(64)	/* erase count spread to move a cold block */
+#define NORFS_TOMB_MAX		(32)	/* tombstones to start reclaiming the oldest block */
+
+/* reclaim modes */
+#define NORFS_GC_DEAD		(0)		/* the block with the most outdated data */
+#define NORFS_GC_WEAR		(1)		/* the least worn block */
+#define NORFS_GC_OLDEST		(2)		/* the oldest block, to drop tombstones */
+
+/*
+ * A record is found by a location: offset in the block / 4 (bits 0-9),
+ * block (bits 10-21) and payload length (bits 22-31). 0 is no record, offset
+ * 0 holds the block header.
+ */
+#define NORFS_LOC(blk, off, len)	\
+	(((uint32_t)(off) >> 2) | ((uint32_t)(blk) << 10) | ((uint32_t)(len) << 22))
+#define NORFS_LOC_OFF(loc)		(((loc) & 0x3FF) << 2)
+#define NORFS_LOC_BLK(loc)		(((loc) >> 10) & 0xFFF)
+#define NORFS_LOC_LEN(loc)		((loc) >> 22)
+
+typedef struct norfs_blk_hdr {
+	uint32_t	magic;
+	uint32_t	seq;		/* order of the blocks in the log */
+	uint32_t	erase;		/* erase count */
+	uint32_t	crc;		/* magic, seq and erase */
+	uint32_t	src;		/* seq of the block being reclaimed to this one,
+							 * cleared to 0 once its records are all copied,
+							 * not in crc */
+} norfs_blk_hdr_t;
+
+typedef struct norfs_rec_hdr {
+	uint8_t		state;
+	uint8_t		type;
+	uint16_t	id;			/* file */
+	uint16_t	len;		/* payload */
+	uint16_t	arg;
+	uint32_t	size;		/* file size */
+	uint32_t	crc;		/* type to size and the payload */
+} norfs_rec_hdr_t;
+
+#define NORFS_REC_CRC_START	(1)
+#define NORFS_REC_CRC_LEN	(11)
+
+/* block states */
+#define NORFS_BLK_FREE		(0)		/* erased */
+#define NORFS_BLK_DIRTY		(1)		/* to be checked or erased before use */
+#define NORFS_BLK_USED		(2)
+
+struct norfs_block {
+	uint32_t	seq;
+	uint32_t	erase;
+	uint16_t	used;		/* bytes written or unusable after the header */
+	uint16_t	live;		/* bytes of the records in use */
+	uint8_t		state;
+};
+
+struct norfs_node {
+	uint16_t	id;
+	uint16_t	hash;		/* of the name */
+	uint8_t		open;		/* open handles */
+	uint8_t		writer;		/* open for writing */
+	uint16_t	gen;		/* changes when data is committed */
+	uint32_t	size;		/* committed size */
+	uint32_t	inode;		/* location of the newest inode record */
+	uint32_t   *chunk;		/* chunk index -> location of its record, 0 if a hole */
+	uint32_t	chunk_max;
+	char		name[NORFS_NAME_MAX + 1];
+};
+
+struct norfs_tomb {
+	uint16_t	id;			/* deleted file */
+	uint16_t	blk;		/* block holding the record that deleted it, or
+							 * NORFS_BLK_NONE if it is to be written again */
+	uint32_t	seq;		/* blocks before this seq may hold records of the file */
+};
+
+struct norfs {
+	uint32_t	flash;
+	uint32_t	addr;
+	uint32_t	size;
+	OS_Mutex_t	mutex;
+
+	struct norfs_block *blk;
+	uint16_t	blk_cnt;
+	uint16_t	free_cnt;	/* free and dirty blocks */
+	uint16_t	active;		/* block appended to, blk_cnt if none */
+	uint16_t	next_id;
+	uint32_t	seq;		/* of the next block taken */
+	uint32_t	gc_cnt;
+	uint32_t	gc_src;		/* seq of the block being reclaimed, 0 if none */
+	uint8_t		active_src;	/* src of the active block not cleared yet */
+
+	struct norfs_node **node;
+	uint16_t	node_cnt;
+	uint16_t	node_max;
+	struct norfs_tomb *tomb;
+	uint16_t	tomb_cnt;
+	uint16_t	tomb_max;
+	uint16_t	open_cnt;
+
+	uint8_t	   *wbuf;		/* record header and payload */
+	uint8_t	   *cache;		/* NORFS_CACHE_LINES chunks */
+	uint32_t	cache_loc[NORFS_CACHE_LINES];
+	uint32_t	cache_stamp[NORFS_CACHE_LINES];
+	uint32_t	clock;
+};
+
+struct norfs_file {
+	norfs_t	   *fs;
+	struct norfs_node *node;
+	uint32_t	pos;
+	uint32_t	size;		/* including the chunk in buf */
+	uint32_t	buf_idx;	/* chunk in buf */
+	uint16_t	buf_len;	/* valid bytes in buf */
+	uint16_t	buf_gen;	/* node gen when buf was loaded */
+	uint8_t		flags;
+	uint8_t		dirty;		/* buf has data not written yet */
+	uint8_t		buf[NORFS_CHUNK_SIZE];
+};
+
+#define NORFS_LOCK(fs)		OS_MutexLock(&(fs)->mutex, OS_WAIT_FOREVER)
+#define NORFS_UNLOCK(fs)	OS_MutexUnlock(&(fs)->mutex)
+
+static uint32_t norfs_crc32(uint32_t crc, const void *buf, uint32_t len)
+{
+	static const uint32_t tbl[16] = {
+		0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+		0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+		0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+		0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+	};
+	const uint8_t *p = buf;
+
+	crc = ~crc;
+	while (len--) {
+		crc ^= *p++;
+		crc = (crc >> 4) ^ tbl[crc & 0xF];
+		crc = (crc >> 4) ^ tbl[crc & 0xF];
+	}
+	return ~crc;
+}
+
+static uint16_t norfs_hash(const char *name)
+{
+	uint32_t h = 2166136261U;
+
+	while (*name) {
+		h ^= (uint8_t)*name++;
+		h *= 16777619U;
+	}
+	return (uint16_t)(h ^ (h >> 16));
+}
+
+static int norfs_read_flash(norfs_t *fs, uint32_t blk, uint32_t off, void *buf, uint32_t len)
+{
+	uint32_t addr = fs->addr + blk * NORFS_BLOCK_SIZE + off;
+
+	return (flash_read(fs->flash, addr, buf, len) == len) ? 0 : NORFS_ERR_IO;
+}
+
+static int norfs_write_flash(norfs_t *fs, uint32_t blk, uint32_t off, const void *buf, uint32_t len)
+{
+	uint32_t addr = fs->addr + blk * NORFS_BLOCK_SIZE + off;
+
+	return (flash_write(fs->flash, addr, buf, len) == len) ? 0 : NORFS_ERR_IO;
+}
+
+/* forget the cached chunks of a block about to be erased */
+static void norfs_cache_drop(norfs_t *fs, uint32_t blk)
+{
+	int i;
+
+	for (i = 0; i < NORFS_CACHE_LINES; ++i) {
+		if (fs->cache_loc[i] && NORFS_LOC_BLK(fs->cache_loc[i]) == blk)
+			fs->cache_loc[i] = 0;
+	}
+}
+
+/* copy the payload of the record at loc to buf, through the read cache */
+static int norfs_load(norfs_t *fs, uint32_t loc, uint8_t *buf)
+{
+	uint32_t len = NORFS_LOC_LEN(loc);
+	uint8_t *line;
+	int i, victim = 0;
+
+	for (i = 0; i < NORFS_CACHE_LINES; ++i) {
+		if (fs->cache_loc[i] == loc) {
+			fs->cache_stamp[i] = ++fs->clock;
+			memcpy(buf, fs->cache + i * NORFS_CHUNK_SIZE, len);
+			return 0;
+		}
+		if (fs->cache_stamp[i] < fs->cache_stamp[victim])
+			victim = i;
+	}
+
+	line = fs->cache + victim * NORFS_CHUNK_SIZE;
+	fs->cache_loc[victim] = 0;
+	if (norfs_read_flash(fs, NORFS_LOC_BLK(loc),
+	                     NORFS_LOC_OFF(loc) + NORFS_REC_HDR_SIZE, line, len) != 0)
+		return NORFS_ERR_IO;
+	fs->cache_loc[victim] = loc;
+	fs->cache_stamp[victim] = ++fs->clock;
+	memcpy(buf, line, len);
+	return 0;
+}
+
+/* return 1 if the block reads as erased from off on */
+static int norfs_is_erased(norfs_t *fs, uint32_t blk, uint32_t off)
+{
+	uint32_t buf[32];	/* not wbuf, it may hold a record being moved */
+	uint32_t n, i;
+
+	while (off < NORFS_BLOCK_SIZE) {
+		n = NORFS_BLOCK_SIZE - off;
+		if (n > sizeof(buf))
+			n = sizeof(buf);
+		if (norfs_read_flash(fs, blk, off, buf, n) != 0)
+			return 0;
+		for (i = 0; i < n / 4; ++i) {
+			if (buf[i] != 0xFFFFFFFF)
+				return 0;
+		}
+		off += n;
+	}
+	return 1;
+}
+
+static int norfs_erase(norfs_t *fs, uint32_t blk)
+{
+	struct norfs_block *b = &fs->blk[blk];
+
+	NORFS_DBG("erase block %u (%u)\n", blk, b->erase);
+	norfs_cache_drop(fs, blk);
+	b->erase++;
+	if (flash_erase(fs->flash, fs->addr + blk * NORFS_BLOCK_SIZE, NORFS_BLOCK_SIZE) != 0) {
+		NORFS_ERR("erase %u failed\n", blk);
+		b->state = NORFS_BLK_DIRTY;
+		return NORFS_ERR_IO;
+	}
+	b->state = NORFS_BLK_FREE;
+	return 0;
+}
+
+/*
+ * Node index
+ */
+
+static struct norfs_node *norfs_find_id(norfs_t *fs, uint16_t id)
+{
+	int i;
+
+	for (i = 0; i < fs->node_cnt; ++i) {
+		if (fs->node[i]->id == id)
+			return fs->node[i];
+	}
+	return NULL;
+}
+
+static struct norfs_node *norfs_find_name(norfs_t *fs, const char *name)
+{
+	uint16_t hash = norfs_hash(name);
+	struct norfs_node *node;
+	int i;
+
+	for (i = 0; i < fs->node_cnt; ++i) {
+		node = fs->node[i];
+		if (node->hash == hash && node->inode && strcmp(node->name, name) == 0)
+			return node;
+	}
+	return NULL;
+}
+
+static struct norfs_node *norfs_node_new(norfs_t *fs, uint16_t id)
+{
+	struct norfs_node *node, **tbl;
+
+	if (fs->node_cnt == fs->node_max) {
+		tbl = realloc(fs->node, (fs->node_max + 16) * sizeof(*tbl));
+		if (tbl == NULL)
+			return NULL;
+		fs->node = tbl;
+		fs->node_max += 16;
+	}
+	node = calloc(1, sizeof(*node));
+	if (node == NULL)
+		return NULL;
+	node->id = id;
+	fs->node[fs->node_cnt++] = node;
+	return node;
+}
+
+/* make room for chunk index idx */
+static int norfs_node_grow(struct norfs_node *node, uint32_t idx)
+{
+	uint32_t max;
+	uint32_t *tbl;
+
+	if (idx < node->chunk_max)
+		return 0;
+	if (idx >= 0xFFFF)
+		return NORFS_ERR_NOSPC;
+	max = node->chunk_max ? node->chunk_max * 2 : 4;
+	while (max <= idx)
+		max *= 2;
+	tbl = realloc(node->chunk, max * sizeof(*tbl));
+	if (tbl == NULL)
+		return NORFS_ERR_NOMEM;
+	memset(tbl + node->chunk_max, 0, (max - node->chunk_max) * sizeof(*tbl));
+	node->chunk = tbl;
+	node->chunk_max = max;
+	return 0;
+}
+
+/* the record at loc is no longer in use */
+static void norfs_unref(norfs_t *fs, uint32_t loc)
+{
+	if (loc)
+		fs->blk[NORFS_LOC_BLK(loc)].live -= NORFS_REC_SIZE(NORFS_LOC_LEN(loc));
+}
+
+static void norfs_ref(norfs_t *fs, uint32_t loc)
+{
+	fs->blk[NORFS_LOC_BLK(loc)].live += NORFS_REC_SIZE(NORFS_LOC_LEN(loc));
+}
+
+/* drop the chunks past size */
+static void norfs_node_cut(norfs_t *fs, struct norfs_node *node, uint32_t size)
+{
+	uint32_t i = (size + NORFS_CHUNK_SIZE - 1) / NORFS_CHUNK_SIZE;
+
+	for (; i < node->chunk_max; ++i) {
+		norfs_unref(fs, node->chunk[i]);
+		node->chunk[i] = 0;
+	}
+	node->size = size;
+}
+
+static void norfs_node_free(norfs_t *fs, struct norfs_node *node)
+{
+	int i;
+
+	norfs_node_cut(fs, node, 0);
+	norfs_unref(fs, node->inode);
+	for (i = 0; i < fs->node_cnt; ++i) {
+		if (fs->node[i] == node) {
+			fs->node[i] = fs->node[--fs->node_cnt];
+			break;
+		}
+	}
+	free(node->chunk);
+	free(node);
+}
+
+static int norfs_tomb_add(norfs_t *fs, uint16_t id, uint16_t blk, uint32_t seq)
+{
+	struct norfs_tomb *tbl;
+	int i;
+
+	for (i = 0; i < fs->tomb_cnt; ++i) {
+		if (fs->tomb[i].id == id)
+			break;
+	}
+	if (i == fs->tomb_cnt) {
+		if (fs->tomb_cnt == fs->tomb_max) {
+			tbl = realloc(fs->tomb, (fs->tomb_max + 8) * sizeof(*tbl));
+			if (tbl == NULL)
+				return NORFS_ERR_NOMEM;
+			fs->tomb = tbl;
+			fs->tomb_max += 8;
+		}
+		fs->tomb_cnt++;
+		fs->tomb[i].seq = seq;
+	} else if (seq > fs->tomb[i].seq) {
+		fs->tomb[i].seq = seq;
+	}
+	fs->tomb[i].id = id;
+	fs->tomb[i].blk = blk;
+	return 0;
+}
+
+/*
+ * Drop the tombstones no longer needed: a file is gone for good once no
+ * block older than its deletion is left, skip is the block being reclaimed.
+ */
+static void norfs_tomb_prune(norfs_t *fs, uint32_t skip)
+{
+	uint32_t i, oldest = 0xFFFFFFFF;
+
+	for (i = 0; i < fs->blk_cnt; ++i) {
+		if (i != skip && fs->blk[i].state == NORFS_BLK_USED && fs->blk[i].seq < oldest)
+			oldest = fs->blk[i].seq;
+	}
+	for (i = 0; i < fs->tomb_cnt; ) {
+		if (fs->tomb[i].seq <= oldest)
+			fs->tomb[i] = fs->tomb[--fs->tomb_cnt];
+		else
+			++i;
+	}
+}
+
+static int norfs_id_used(norfs_t *fs, uint16_t id)
+{
+	int i;
+
+	if (norfs_find_id(fs, id))
+		return 1;
+	for (i = 0; i < fs->tomb_cnt; ++i) {
+		if (fs->tomb[i].id == id)
+			return 1;
+	}
+	return 0;
+}
+
+static int norfs_new_id(norfs_t *fs)
+{
+	uint32_t tries = NORFS_ID_NONE;
+
+	while (fs->next_id == NORFS_ID_NONE || norfs_id_used(fs, fs->next_id)) {
+		if (tries-- == 0)
+			return NORFS_ERR_NFILE;
+		fs->next_id++;
+	}
+	return fs->next_id++;
+}
+
+/*
+ * Log
+ */
+
+/* take the least worn free block as the block to append to */
+static int norfs_activate(norfs_t *fs)
+{
+	norfs_blk_hdr_t hdr;
+	struct norfs_block *b;
+	uint32_t i, best = fs->blk_cnt;
+	int ret;
+
+	for (i = 0; i < fs->blk_cnt; ++i) {
+		if (fs->blk[i].state != NORFS_BLK_USED &&
+		    (best == fs->blk_cnt || fs->blk[i].erase < fs->blk[best].erase))
+			best = i;
+	}
+	if (best == fs->blk_cnt)
+		return NORFS_ERR_NOSPC;
+
+	b = &fs->blk[best];
+	if (b->state == NORFS_BLK_DIRTY && !norfs_is_erased(fs, best, 0)) {
+		ret = norfs_erase(fs, best);
+		if (ret != 0)
+			return ret;
+	}
+
+	hdr.magic = NORFS_MAGIC;
+	hdr.seq = fs->seq;
+	hdr.erase = b->erase;
+	hdr.crc = norfs_crc32(0, &hdr, offsetof(norfs_blk_hdr_t, crc));
+	hdr.src = fs->gc_src;
+	if (norfs_write_flash(fs, best, 0, &hdr, sizeof(hdr)) != 0) {
+		b->state = NORFS_BLK_DIRTY;
+		return NORFS_ERR_IO;
+	}
+
+	if (fs->active < fs->blk_cnt)
+		fs->blk[fs->active].used = NORFS_BLK_CAP;	/* closed */
+	b->state = NORFS_BLK_USED;
+	b->seq = fs->seq++;
+	b->used = 0;
+	b->live = 0;
+	fs->free_cnt--;
+	fs->active = best;
+	fs->active_src = (fs->gc_src != 0);
+	NORFS_DBG("block %u active, seq %u\n", best, b->seq);
+	return 0;
+}
+
+static int norfs_gc(norfs_t *fs, int mode);
+
+/* make sure the active block has room for need bytes */
+static int norfs_reserve(norfs_t *fs, uint32_t need, int gc)
+{
+	uint32_t tries = fs->blk_cnt;
+	int ret;
+
+	while (fs->active >= fs->blk_cnt ||
+	       (uint32_t)(NORFS_BLK_CAP - fs->blk[fs->active].used) < need) {
+		if (gc || fs->free_cnt > NORFS_GC_RESERVE)
+			return norfs_activate(fs);
+		/* keep the reserve for reclaiming, which may also leave room in the
+		 * active block */
+		if (tries-- == 0)
+			return NORFS_ERR_NOSPC;
+		ret = norfs_gc(fs, NORFS_GC_DEAD);
+		if (ret != 0)
+			return ret;
+	}
+	return 0;
+}
+
+/*
+ * Append a record, data is the payload of hdr->len bytes. gc is set when
+ * reclaiming, which may use the reserved blocks.
+ */
+static int norfs_append(norfs_t *fs, norfs_rec_hdr_t *hdr, const void *data,
+                        uint32_t *loc, int gc)
+{
+	uint32_t size = NORFS_REC_SIZE(hdr->len);
+	struct norfs_block *b;
+	uint32_t off;
+	uint8_t state = NORFS_REC_VALID;
+	int ret;
+
+	ret = norfs_reserve(fs, size, gc);
+	if (ret != 0)
+		return ret;
+	b = &fs->blk[fs->active];
+	off = NORFS_BLK_HDR_SIZE + b->used;
+
+	if (hdr->len && data != fs->wbuf + NORFS_REC_HDR_SIZE)
+		memcpy(fs->wbuf + NORFS_REC_HDR_SIZE, data, hdr->len);
+	memset(fs->wbuf + NORFS_REC_HDR_SIZE + hdr->len, 0xFF,
+	       NORFS_REC_ALIGN(hdr->len) - hdr->len);
+	hdr->state = NORFS_REC_EMPTY;
+	hdr->crc = norfs_crc32(0, (uint8_t *)hdr + NORFS_REC_CRC_START, NORFS_REC_CRC_LEN);
+	hdr->crc = norfs_crc32(hdr->crc, fs->wbuf + NORFS_REC_HDR_SIZE, hdr->len);
+	memcpy(fs->wbuf, hdr, NORFS_REC_HDR_SIZE);
+
+	/* everything but the state, then the state */
+	b->used += size;
+	if (norfs_write_flash(fs, fs->active, off + 1, fs->wbuf + 1, size - 1) != 0 ||
+	    norfs_write_flash(fs, fs->active, off, &state, 1) != 0) {
+		NORFS_ERR("write block %u @ %u failed\n", fs->active, off);
+		b->used = NORFS_BLK_CAP;	/* do not append after it */
+		return NORFS_ERR_IO;
+	}
+	*loc = NORFS_LOC(fs->active, off, hdr->len);
+	norfs_ref(fs, *loc);
+	return 0;
+}
+
+static int norfs_put_inode(norfs_t *fs, struct norfs_node *node, const char *name,
+                           uint32_t size, uint16_t replace, int gc)
+{
+	norfs_rec_hdr_t hdr;
+	uint32_t loc;
+	int ret;
+
+	hdr.type = NORFS_REC_INODE;
+	hdr.id = node->id;
+	hdr.len = strlen(name);
+	hdr.arg = replace;
+	hdr.size = size;
+	ret = norfs_append(fs, &hdr, name, &loc, gc);
+	if (ret != 0)
+		return ret;
+	norfs_unref(fs, node->inode);
+	node->inode = loc;
+	return 0;
+}
+
+static int norfs_put_delete(norfs_t *fs, uint16_t id, uint32_t seq, uint32_t *blk)
+{
+	norfs_rec_hdr_t hdr;
+	uint32_t loc;
+	int ret;
+
+	hdr.type = NORFS_REC_DELETE;
+	hdr.id = id;
+	hdr.len = 0;
+	hdr.arg = 0;
+	hdr.size = seq;
+	ret = norfs_append(fs, &hdr, NULL, &loc, 1);
+	if (ret != 0)
+		return ret;
+	norfs_unref(fs, loc);	/* tombstones are not counted as live */
+	*blk = NORFS_LOC_BLK(loc);
+	return 0;
+}
+
+/* write the tombstones kept only in RAM */
+static int norfs_tomb_flush(norfs_t *fs)
+{
+	uint32_t i, blk;
+	int ret;
+
+	for (i = 0; i < fs->tomb_cnt; ++i) {
+		if (fs->tomb[i].blk != NORFS_BLK_NONE)
+			continue;
+		ret = norfs_put_delete(fs, fs->tomb[i].id, fs->tomb[i].seq, &blk);
+		if (ret != 0)
+			return ret;
+		fs->tomb[i].blk = blk;
+	}
+	return 0;
+}
+
+/* return 1 if n tombstones can be appended */
+static int norfs_tomb_fit(norfs_t *fs, uint32_t n)
+{
+	uint32_t room = (uint32_t)fs->free_cnt * (NORFS_BLK_CAP / NORFS_REC_HDR_SIZE);
+
+	if (fs->active < fs->blk_cnt)
+		room += (NORFS_BLK_CAP - fs->blk[fs->active].used) / NORFS_REC_HDR_SIZE;
+	return n <= room;
+}
+
+/*
+ * The records of the block reclaimed are all copied, clear src of the active
+ * block. On failure the block reclaimed must be kept, the active block would
+ * be dropped at mount.
+ */
+static int norfs_gc_src_done(norfs_t *fs)
+{
+	uint32_t zero = 0;
+
+	fs->gc_src = 0;
+	if (!fs->active_src)
+		return 0;
+	fs->active_src = 0;
+	if (norfs_write_flash(fs, fs->active, offsetof(norfs_blk_hdr_t, src),
+	                      &zero, sizeof(zero)) != 0) {
+		NORFS_ERR("write block %u failed\n", fs->active);
+		fs->blk[fs->active].used = NORFS_BLK_CAP;	/* do not append after it */
+		return NORFS_ERR_IO;
+	}
+	return 0;
+}
+
+/*
+ * Reclaim a block: copy its live records and the tombstones still needed to
+ * the active block and erase it. When nothing live is left but there is no
+ * room for the tombstones, the block is erased first and the tombstones are
+ * written to it afterwards, they are only kept in RAM until then.
+ * del is a file deleted first, as part of the reclaim, or NULL.
+ */
+static int norfs_gc_block(norfs_t *fs, uint32_t victim, struct norfs_node *del)
+{
+	struct norfs_block *v = &fs->blk[victim];
+	norfs_rec_hdr_t hdr;
+	struct norfs_node *node;
+	uint32_t off, end, loc, blk, i, n, seq;
+	int ret = 0;
+
+	NORFS_DBG("reclaim block %u, used %u live %u\n", victim, v->used, v->live);
+
+	/*
+	 * Blocks taken until the records are all copied hold nothing else, so a
+	 * reclaim cut by a power loss is undone at mount (see norfs_scan()). Not
+	 * if tombstones of erased blocks are to be written, they are no copies.
+	 */
+	fs->gc_src = v->seq;
+	for (i = 0; i < fs->tomb_cnt; ++i) {
+		if (fs->tomb[i].blk == NORFS_BLK_NONE)
+			fs->gc_src = 0;
+	}
+
+	if (del) {
+		seq = fs->seq;
+		ret = norfs_put_delete(fs, del->id, seq, &blk);
+		if (ret == 0)
+			ret = norfs_tomb_add(fs, del->id, blk, seq);
+		if (ret != 0)
+			goto out;
+		norfs_node_free(fs, del);
+	}
+
+	end = NORFS_BLK_HDR_SIZE + v->used;
+	for (off = NORFS_BLK_HDR_SIZE; off + NORFS_REC_HDR_SIZE <= end;
+	     off += NORFS_REC_SIZE(hdr.len)) {
+		if (v->live == 0)
+			break;
+		if (norfs_read_flash(fs, victim, off, &hdr, sizeof(hdr)) != 0) {
+			ret = NORFS_ERR_IO;
+			goto out;
+		}
+		if (hdr.state != NORFS_REC_VALID || hdr.len > NORFS_CHUNK_SIZE)
+			break;
+		loc = NORFS_LOC(victim, off, hdr.len);
+		node = norfs_find_id(fs, hdr.id);
+		if (node == NULL)
+			continue;
+
+		if (hdr.type == NORFS_REC_DATA) {
+			if (hdr.arg >= node->chunk_max || node->chunk[hdr.arg] != loc)
+				continue;
+			if (norfs_read_flash(fs, victim, off + NORFS_REC_HDR_SIZE,
+			                     fs->wbuf + NORFS_REC_HDR_SIZE, hdr.len) != 0) {
+				ret = NORFS_ERR_IO;
+				goto out;
+			}
+			hdr.size = node->size;
+			ret = norfs_append(fs, &hdr, fs->wbuf + NORFS_REC_HDR_SIZE, &loc, 1);
+			if (ret != 0)
+				goto out;
+			norfs_unref(fs, node->chunk[hdr.arg]);
+			node->chunk[hdr.arg] = loc;
+		} else if (hdr.type == NORFS_REC_INODE) {
+			if (node->inode != loc)
+				continue;
+			/* the file it replaced stays deleted by a tombstone, see below */
+			ret = norfs_put_inode(fs, node, node->name, node->size, NORFS_ID_NONE, 1);
+			if (ret != 0)
+				goto out;
+		}
+	}
+
+	/* tombstones are needed while blocks older than the deletion exist */
+	norfs_tomb_prune(fs, victim);
+	for (i = 0, n = 0; i < fs->tomb_cnt; ++i) {
+		if (fs->tomb[i].blk == victim)
+			fs->tomb[i].blk = NORFS_BLK_NONE;
+		if (fs->tomb[i].blk == NORFS_BLK_NONE)
+			n++;
+	}
+	if (norfs_tomb_fit(fs, n)) {
+		ret = norfs_tomb_flush(fs);
+		n = 0;
+	}
+
+out:
+	if (norfs_gc_src_done(fs) != 0)
+		ret = NORFS_ERR_IO;
+	if (ret != 0)
+		return ret;
+
+	ret = norfs_erase(fs, victim);
+	fs->free_cnt++;
+	fs->gc_cnt++;
+	if (ret == 0 && n)
+		ret = norfs_tomb_flush(fs);
+	return ret;
+}
+
+static int norfs_gc(norfs_t *fs, int mode)
+{
+	struct norfs_block *b;
+	uint32_t i, dead, victim = fs->blk_cnt, best = 0, erase_max = 0;
+	int ret;
+
+	for (i = 0; i < fs->blk_cnt; ++i) {
+		b = &fs->blk[i];
+		if (b->erase > erase_max)
+			erase_max = b->erase;
+		if (b->state != NORFS_BLK_USED || i == fs->active)
+			continue;
+		dead = b->used - b->live;
+		if (mode == NORFS_GC_WEAR) {
+			if (victim == fs->blk_cnt || b->erase < fs->blk[victim].erase)
+				victim = i;
+		} else if (mode == NORFS_GC_OLDEST) {
+			if (victim == fs->blk_cnt || b->seq < fs->blk[victim].seq)
+				victim = i;
+		} else if (dead > best || (dead == best && dead && b->seq < fs->blk[victim].seq)) {
+			best = dead;
+			victim = i;
+		}
+	}
+	if (victim == fs->blk_cnt)
+		return mode ? 0 : NORFS_ERR_NOSPC;
+	if (mode == NORFS_GC_WEAR && erase_max - fs->blk[victim].erase <= NORFS_WEAR_DELTA)
+		return 0;
+
+	ret = norfs_gc_block(fs, victim, NULL);
+	if (ret != 0 || mode != NORFS_GC_DEAD)
+		return ret;
+	/* tombstones go once the blocks older than the deletion are reclaimed */
+	if (fs->tomb_cnt > NORFS_TOMB_MAX)
+		ret = norfs_gc(fs, NORFS_GC_OLDEST);
+	if (ret == 0 && (fs->gc_cnt % NORFS_WEAR_INTERVAL) == 0)
+		ret = norfs_gc(fs, NORFS_GC_WEAR);
+	return ret;
+}
+
+/* bytes of the records of a file in a block */
+static uint32_t norfs_node_bytes(struct norfs_node *node, uint32_t blk)
+{
+	uint32_t i, n = 0;
+
+	if (NORFS_LOC_BLK(node->inode) == blk)
+		n += NORFS_REC_SIZE(NORFS_LOC_LEN(node->inode));
+	for (i = 0; i < node->chunk_max; ++i) {
+		if (node->chunk[i] && NORFS_LOC_BLK(node->chunk[i]) == blk)
+			n += NORFS_REC_SIZE(NORFS_LOC_LEN(node->chunk[i]));
+	}
+	return n;
+}
+
+/*
+ * Delete a file when full: the tombstone is written to the reserve with the
+ * reclaim of the block the file frees the most in, so a power cut undoes both.
+ */
+static int norfs_gc_delete(norfs_t *fs, struct norfs_node *node)
+{
+	struct norfs_block *b;
+	uint32_t i, dead, victim = fs->blk_cnt, best = 0;
+
+	for (i = 0; i < fs->blk_cnt; ++i) {
+		b = &fs->blk[i];
+		if (b->state != NORFS_BLK_USED)
+			continue;
+		dead = b->used - b->live + norfs_node_bytes(node, i);
+		if (dead > best) {
+			best = dead;
+			victim = i;
+		}
+	}
+	/* room for the tombstone, the active block is closed by it */
+	if (victim == fs->blk_cnt || best < NORFS_REC_HDR_SIZE)
+		return NORFS_ERR_NOSPC;
+	return norfs_gc_block(fs, victim, node);
+}
+
+/*
+ * Mount
+ */
+
+/* apply the records of a block to the index, in the order of the log */
+static int norfs_scan_block(norfs_t *fs, uint32_t blk)
+{
+	struct norfs_block *b = &fs->blk[blk];
+	norfs_rec_hdr_t *hdr = (norfs_rec_hdr_t *)fs->wbuf;
+	struct norfs_node *node;
+	uint32_t off, loc, crc;
+	char *name;
+	int ret;
+
+	for (off = NORFS_BLK_HDR_SIZE; off + NORFS_REC_HDR_SIZE <= NORFS_BLOCK_SIZE;
+	     off += NORFS_REC_SIZE(hdr->len)) {
+		if (norfs_read_flash(fs, blk, off, hdr, NORFS_REC_HDR_SIZE) != 0)
+			return NORFS_ERR_IO;
+		if (hdr->state == NORFS_REC_EMPTY && hdr->type == 0xFF && hdr->id == 0xFFFF &&
+		    hdr->len == 0xFFFF && hdr->arg == 0xFFFF && hdr->size == 0xFFFFFFFF &&
+		    hdr->crc == 0xFFFFFFFF) {
+			b->used = off - NORFS_BLK_HDR_SIZE;	/* end of the log in this block */
+			return 0;
+		}
+		if (hdr->state != NORFS_REC_VALID || hdr->len > NORFS_CHUNK_SIZE ||
+		    off + NORFS_REC_SIZE(hdr->len) > NORFS_BLOCK_SIZE)
+			break;
+		if (norfs_read_flash(fs, blk, off + NORFS_REC_HDR_SIZE,
+		                     fs->wbuf + NORFS_REC_HDR_SIZE, hdr->len) != 0)
+			return NORFS_ERR_IO;
+		crc = norfs_crc32(0, (uint8_t *)hdr + NORFS_REC_CRC_START, NORFS_REC_CRC_LEN);
+		crc = norfs_crc32(crc, fs->wbuf + NORFS_REC_HDR_SIZE, hdr->len);
+		if (crc != hdr->crc) {
+			NORFS_WRN("bad record, block %u @ %u\n", blk, off);
+			break;
+		}
+
+		loc = NORFS_LOC(blk, off, hdr->len);
+		switch (hdr->type) {
+		case NORFS_REC_INODE:
+			if (hdr->len == 0 || hdr->len > NORFS_NAME_MAX)
+				break;
+			if (hdr->arg != NORFS_ID_NONE) {
+				node = norfs_find_id(fs, hdr->arg);
+				if (node)
+					norfs_node_free(fs, node);
+				if (norfs_tomb_add(fs, hdr->arg, blk, b->seq + 1) != 0)
+					return NORFS_ERR_NOMEM;
+			}
+			node = norfs_find_id(fs, hdr->id);
+			if (node == NULL && (node = norfs_node_new(fs, hdr->id)) == NULL)
+				return NORFS_ERR_NOMEM;
+			name = (char *)fs->wbuf + NORFS_REC_HDR_SIZE;
+			memcpy(node->name, name, hdr->len);
+			node->name[hdr->len] = '\0';
+			node->hash = norfs_hash(node->name);
+			node->inode = loc;
+			norfs_node_cut(fs, node, hdr->size);
+			break;
+		case NORFS_REC_DATA:
+			node = norfs_find_id(fs, hdr->id);
+			if (node == NULL && (node = norfs_node_new(fs, hdr->id)) == NULL)
+				return NORFS_ERR_NOMEM;
+			ret = norfs_node_grow(node, hdr->arg);
+			if (ret != 0)
+				return ret;
+			node->chunk[hdr->arg] = loc;
+			norfs_node_cut(fs, node, hdr->size);
+			break;
+		case NORFS_REC_DELETE:
+			node = norfs_find_id(fs, hdr->id);
+			if (node)
+				norfs_node_free(fs, node);
+			if (norfs_tomb_add(fs, hdr->id, blk, hdr->size) != 0)
+				return NORFS_ERR_NOMEM;
+			break;
+		default:
+			break;
+		}
+	}
+	b->used = NORFS_BLK_CAP;	/* torn or damaged, nothing is appended here */
+	return 0;
+}
+
+static int norfs_scan(norfs_t *fs)
+{
+	norfs_blk_hdr_t hdr;
+	struct norfs_block *b;
+	struct norfs_node *node;
+	uint16_t *order;
+	uint32_t i, j, n = 0, erase_sum = 0, id_max = 0, seq = 0;
+	int ret = 0;
+
+	order = malloc(fs->blk_cnt * sizeof(*order));
+	if (order == NULL)
+		return NORFS_ERR_NOMEM;
+
+	for (i = 0; i < fs->blk_cnt; ++i) {
+		b = &fs->blk[i];
+		if (norfs_read_flash(fs, i, 0, &hdr, sizeof(hdr)) != 0) {
+			ret = NORFS_ERR_IO;
+			goto out;
+		}
+		if (hdr.magic == NORFS_MAGIC &&
+		    hdr.crc == norfs_crc32(0, &hdr, offsetof(norfs_blk_hdr_t, crc))) {
+			b->state = NORFS_BLK_USED;
+			b->seq = hdr.seq;
+			b->erase = hdr.erase;
+			erase_sum += hdr.erase;
+			/* sorted by seq */
+			for (j = n; j > 0 && fs->blk[order[j - 1]].seq > hdr.seq; --j)
+				order[j] = order[j - 1];
+			order[j] = i;
+			n++;
+		} else {
+			b->state = NORFS_BLK_DIRTY;	/* erased, or an erase was cut */
+			fs->free_cnt++;
+		}
+	}
+
+	/*
+	 * The newest block with src set was taken by a reclaim cut by a power
+	 * loss (or its header was cut), the block reclaimed is still there.
+	 * It only holds copies and is dropped, so is the one before if taken by
+	 * the same reclaim.
+	 */
+	if (n)
+		seq = fs->blk[order[n - 1]].seq;
+	while (n) {
+		i = order[n - 1];
+		if (norfs_read_flash(fs, i, 0, &hdr, sizeof(hdr)) != 0) {
+			ret = NORFS_ERR_IO;
+			goto out;
+		}
+		if (hdr.src == 0)
+			break;
+		NORFS_WRN("drop block %u of a reclaim cut\n", i);
+		erase_sum -= fs->blk[i].erase;
+		ret = norfs_erase(fs, i);
+		if (ret != 0)
+			goto out;
+		fs->free_cnt++;
+		n--;
+	}
+
+	for (i = 0; i < n; ++i) {
+		ret = norfs_scan_block(fs, order[i]);
+		if (ret != 0)
+			goto out;
+	}
+
+	/* data without a name is left over of an interrupted creation */
+	for (i = 0; i < fs->node_cnt; ) {
+		node = fs->node[i];
+		if (node->inode == 0) {
+			NORFS_WRN("drop nameless file %u\n", node->id);
+			norfs_node_free(fs, node);
+			continue;
+		}
+		if (node->id > id_max)
+			id_max = node->id;
+		++i;
+	}
+
+	/* live bytes of every block */
+	for (i = 0; i < fs->blk_cnt; ++i)
+		fs->blk[i].live = 0;
+	for (i = 0; i < fs->node_cnt; ++i) {
+		node = fs->node[i];
+		norfs_ref(fs, node->inode);
+		for (j = 0; j < node->chunk_max; ++j) {
+			if (node->chunk[j])
+				norfs_ref(fs, node->chunk[j]);
+		}
+	}
+
+	/* blocks never written get the average wear */
+	for (i = 0; i < fs->blk_cnt; ++i) {
+		if (fs->blk[i].state != NORFS_BLK_USED)
+			fs->blk[i].erase = n ? erase_sum / n : 0;
+	}
+
+	fs->active = fs->blk_cnt;
+	fs->seq = seq + 1;
+	if (n) {
+		i = order[n - 1];
+		/* go on appending to the last block if its end was not cut */
+		if (fs->blk[i].used < NORFS_BLK_CAP &&
+		    norfs_is_erased(fs, i, NORFS_BLK_HDR_SIZE + fs->blk[i].used))
+			fs->active = i;
+		else
+			fs->blk[i].used = NORFS_BLK_CAP;
+	}
+	for (i = 0; i < n - (fs->active < fs->blk_cnt); ++i)
+		fs->blk[order[i]].used = NORFS_BLK_CAP;	/* closed */
+	fs->next_id = (uint16_t)(id_max + 1);
+	norfs_tomb_prune(fs, fs->blk_cnt);
+
+out:
+	free(order);
+	return ret;
+}
+
+/**
+ * @brief Erase the area, leaving an empty file system
+ * @param[in] flash Flash number
+ * @param[in] addr Start address of the area, 4K aligned
+ * @param[in] size Size of the area, multiple of 4K
+ * @return 0 on success, negative NORFS_ERR_* on failure
+ */
+int norfs_format(uint32_t flash, uint32_t addr, uint32_t size)
+{
+	if ((addr | size) & (NORFS_BLOCK_SIZE - 1))
+		return NORFS_ERR_INVAL;
+	return flash_erase(flash, addr, size) == 0 ? 0 : NORFS_ERR_IO;
+}
+
+/**
+ * @brief Mount the file system of a flash area
+ * @param[in] flash Flash number
+ * @param[in] addr Start address of the area, 4K aligned
+ * @param[in] size Size of the area, multiple of 4K, 16K at least
+ * @return handle of the file system, NULL on failure
+ *
+ * An erased area (see norfs_format()) mounts as an empty file system.
+ */
+norfs_t *norfs_mount(uint32_t flash, uint32_t addr, uint32_t size)
+{
+	norfs_t *fs;
+	uint32_t cnt = size / NORFS_BLOCK_SIZE;
+
+	if (((addr | size) & (NORFS_BLOCK_SIZE - 1)) || cnt < 4 || cnt > NORFS_BLK_MAX) {
+		NORFS_ERR("invalid area %#x, size %#x\n", addr, size);
+		return NULL;
+	}
+
+	fs = calloc(1, sizeof(*fs));
+	if (fs == NULL)
+		return NULL;
+	fs->flash = flash;
+	fs->addr = addr;
+	fs->size = size;
+	fs->blk_cnt = cnt;
+	fs->blk = calloc(cnt, sizeof(*fs->blk));
+	fs->wbuf = malloc(NORFS_REC_HDR_SIZE + NORFS_CHUNK_SIZE);
+	fs->cache = malloc(NORFS_CACHE_LINES * NORFS_CHUNK_SIZE);
+	if (fs->blk == NULL || fs->wbuf == NULL || fs->cache == NULL)
+		goto err;
+
+	if (norfs_scan(fs) != 0) {
+		NORFS_ERR("scan failed\n");
+		goto err;
+	}
+	/* a power cut while reclaiming may have taken the reserve */
+	for (cnt = fs->blk_cnt; fs->free_cnt < NORFS_GC_RESERVE && cnt > 0; --cnt) {
+		if (norfs_gc(fs, NORFS_GC_DEAD) != 0) {
+			NORFS_WRN("no reserve, %u free blocks\n", fs->free_cnt);
+			break;
+		}
+	}
+	if (OS_MutexCreate(&fs->mutex) != OS_OK)
+		goto err;
+
+	NORFS_DBG("mounted %u files, %u free blocks, seq %u\n",
+	          fs->node_cnt, fs->free_cnt, fs->seq);
+	return fs;
+
+err:
+	fs->open_cnt = 0;
+	norfs_unmount(fs);
+	return NULL;
+}
+
+/**
+ * @brief Unmount the file system, all files must be closed
+ * @return 0 on success, negative NORFS_ERR_* on failure
+ */
+int norfs_unmount(norfs_t *fs)
+{
+	int i;
+
+	if (fs->open_cnt)
+		return NORFS_ERR_BUSY;
+
+	for (i = 0; i < fs->node_cnt; ++i) {
+		free(fs->node[i]->chunk);
+		free(fs->node[i]);
+	}
+	if (OS_MutexIsValid(&fs->mutex))
+		OS_MutexDelete(&fs->mutex);
+	free(fs->node);
+	free(fs->tomb);
+	free(fs->cache);
+	free(fs->wbuf);
+	free(fs->blk);
+	free(fs);
+	return 0;
+}
+
+int norfs_info(norfs_t *fs, struct norfs_info *info)
+{
+	struct norfs_block *b;
+	uint32_t i, free_size = 0;
+
+	NORFS_LOCK(fs);
+	memset(info, 0, sizeof(*info));
+	info->block_cnt = fs->blk_cnt;
+	info->erase_min = 0xFFFFFFFF;
+	for (i = 0; i < fs->blk_cnt; ++i) {
+		b = &fs->blk[i];
+		if (b->state != NORFS_BLK_USED)
+			free_size += NORFS_BLK_CAP;
+		else
+			free_size += (i == fs->active ? NORFS_BLK_CAP : b->used) - b->live;
+		if (b->erase < info->erase_min)
+			info->erase_min = b->erase;
+		if (b->erase > info->erase_max)
+			info->erase_max = b->erase;
+	}
+	/* less the reserve and the record headers */
+	i = NORFS_GC_RESERVE * NORFS_BLK_CAP;
+	free_size = free_size > i ? free_size - i : 0;
+	info->free_size = free_size / NORFS_REC_SIZE(NORFS_CHUNK_SIZE) * NORFS_CHUNK_SIZE;
+	info->file_cnt = fs->node_cnt;
+	info->gc_cnt = fs->gc_cnt;
+	NORFS_UNLOCK(fs);
+	return 0;
+}
+
+/*
+ * Files
+ */
+
+/* write the chunk in buf */
+static int norfs_flush(norfs_file_t *file)
+{
+	norfs_t *fs = file->fs;
+	struct norfs_node *node = file->node;
+	norfs_rec_hdr_t hdr;
+	uint32_t loc, end;
+	int ret;
+
+	if (!file->dirty)
+		return 0;
+
+	ret = norfs_node_grow(node, file->buf_idx);
+	if (ret != 0)
+		return ret;
+	end = file->buf_idx * NORFS_CHUNK_SIZE + file->buf_len;
+	hdr.type = NORFS_REC_DATA;
+	hdr.id = node->id;
+	hdr.len = file->buf_len;
+	hdr.arg = file->buf_idx;
+	hdr.size = node->size > end ? node->size : end;
+	ret = norfs_append(fs, &hdr, file->buf, &loc, 0);
+	if (ret != 0)
+		return ret;
+	norfs_unref(fs, node->chunk[file->buf_idx]);
+	node->chunk[file->buf_idx] = loc;
+	node->size = hdr.size;
+	node->gen++;
+	file->buf_gen = node->gen;
+	file->dirty = 0;
+	return 0;
+}
+
+/* get chunk idx into buf */
+static int norfs_fill(norfs_file_t *file, uint32_t idx, int whole)
+{
+	struct norfs_node *node = file->node;
+	uint32_t loc, len;
+	int ret;
+
+	if (file->buf_idx == idx && (file->dirty || file->buf_gen == node->gen))
+		return 0;
+	ret = norfs_flush(file);
+	if (ret != 0)
+		return ret;
+
+	loc = idx < node->chunk_max ? node->chunk[idx] : 0;
+	len = 0;
+	if (loc && !whole) {
+		ret = norfs_load(file->fs, loc, file->buf);
+		if (ret != 0)
+			return ret;
+		/* bytes past a truncation are stale */
+		len = NORFS_LOC_LEN(loc);
+		if (node->size < idx * NORFS_CHUNK_SIZE + len)
+			len = node->size > idx * NORFS_CHUNK_SIZE ? node->size - idx * NORFS_CHUNK_SIZE : 0;
+	}
+	memset(file->buf + len, 0, NORFS_CHUNK_SIZE - len);
+	file->buf_idx = idx;
+	file->buf_len = len;
+	file->buf_gen = node->gen;
+	return 0;
+}
+
+/*
+ * Shrink a file to size. A chunk cut in the middle is written again with
+ * size in its record, which truncates the file as well, so no stale bytes
+ * come back when the file grows again.
+ */
+static int norfs_cut(norfs_t *fs, struct norfs_node *node, uint32_t size, uint8_t *buf)
+{
+	norfs_rec_hdr_t hdr;
+	uint32_t idx = size / NORFS_CHUNK_SIZE;
+	uint32_t off = size % NORFS_CHUNK_SIZE;
+	uint32_t loc = idx < node->chunk_max ? node->chunk[idx] : 0;
+	int ret;
+
+	if (off == 0 || loc == 0)
+		return norfs_put_inode(fs, node, node->name, size, NORFS_ID_NONE, 0);
+
+	ret = norfs_load(fs, loc, buf);
+	if (ret != 0)
+		return ret;
+	hdr.type = NORFS_REC_DATA;
+	hdr.id = node->id;
+	hdr.len = off < NORFS_LOC_LEN(loc) ? off : NORFS_LOC_LEN(loc);
+	hdr.arg = idx;
+	hdr.size = size;
+	ret = norfs_append(fs, &hdr, buf, &loc, 0);
+	if (ret != 0)
+		return ret;
+	norfs_unref(fs, node->chunk[idx]);
+	node->chunk[idx] = loc;
+	return 0;
+}
+
+/**
+ * @brief Open a file
+ * @param[in] fs File system handle
+ * @param[out] file Handle of the opened file
+ * @param[in] name File name
+ * @param[in] flags NORFS_O_*
+ * @return 0 on success, negative NORFS_ERR_* on failure
+ *
+ * A file may be open for writing once, and for reading any number of times.
+ */
+int norfs_open(norfs_t *fs, norfs_file_t **file, const char *name, int flags)
+{
+	struct norfs_node *node;
+	norfs_file_t *f;
+	uint32_t len = strlen(name);
+	int ret = 0;
+
+	if (len == 0 || len > NORFS_NAME_MAX || !(flags & NORFS_O_RDWR))
+		return NORFS_ERR_INVAL;
+
+	NORFS_LOCK(fs);
+	node = norfs_find_name(fs, name);
+	if (node == NULL) {
+		if (!(flags & NORFS_O_CREAT)) {
+			ret = NORFS_ERR_NOENT;
+			goto out;
+		}
+	} else if ((flags & NORFS_O_CREAT) && (flags & NORFS_O_EXCL)) {
+		ret = NORFS_ERR_EXIST;
+		goto out;
+	} else if ((flags & NORFS_O_WRITE) && node->writer) {
+		ret = NORFS_ERR_BUSY;
+		goto out;
+	}
+
+	f = calloc(1, sizeof(*f));
+	if (f == NULL) {
+		ret = NORFS_ERR_NOMEM;
+		goto out;
+	}
+
+	if (node == NULL) {
+		ret = norfs_new_id(fs);
+		if (ret >= 0 && (node = norfs_node_new(fs, ret)) == NULL)
+			ret = NORFS_ERR_NOMEM;
+		if (node) {
+			strcpy(node->name, name);
+			node->hash = norfs_hash(name);
+			ret = norfs_put_inode(fs, node, name, 0, NORFS_ID_NONE, 0);
+			if (ret != 0)
+				norfs_node_free(fs, node);
+		}
+	} else if ((flags & NORFS_O_TRUNC) && (flags & NORFS_O_WRITE) && node->size) {
+		ret = norfs_put_inode(fs, node, node->name, 0, NORFS_ID_NONE, 0);
+		if (ret == 0) {
+			norfs_node_cut(fs, node, 0);
+			node->gen++;
+		}
+	}
+	if (ret < 0) {
+		free(f);
+		goto out;
+	}
+	ret = 0;
+
+	f->fs = fs;
+	f->node = node;
+	f->flags = flags;
+	f->size = node->size;
+	f->buf_idx = NORFS_CHUNK_NONE;
+	node->open++;
+	if (flags & NORFS_O_WRITE)
+		node->writer = 1;
+	fs->open_cnt++;
+	*file = f;
+
+out:
+	NORFS_UNLOCK(fs);
+	return ret;
+}
+
+/**
+ * @brief Read from the current position
+ * @return bytes read, 0 at the end of the file, negative NORFS_ERR_* on failure
+ */
+int norfs_read(norfs_file_t *file, void *buf, uint32_t len)
+{
+	norfs_t *fs = file->fs;
+	struct norfs_node *node = file->node;
+	uint8_t *p = buf;
+	uint32_t size, idx, off, n, loc, done = 0;
+	int ret = 0;
+
+	if (!(file->flags & NORFS_O_READ))
+		return NORFS_ERR_INVAL;
+
+	NORFS_LOCK(fs);
+	size = (file->flags & NORFS_O_WRITE) ? file->size : node->size;
+	if (file->pos >= size)
+		len = 0;
+	else if (len > size - file->pos)
+		len = size - file->pos;
+
+	while (done < len) {
+		idx = file->pos / NORFS_CHUNK_SIZE;
+		off = file->pos % NORFS_CHUNK_SIZE;
+		n = NORFS_CHUNK_SIZE - off;
+		if (n > len - done)
+			n = len - done;
+
+		loc = idx < node->chunk_max ? node->chunk[idx] : 0;
+		if (n == NORFS_CHUNK_SIZE && file->buf_idx != idx && loc &&
+		    NORFS_LOC_LEN(loc) == NORFS_CHUNK_SIZE) {
+			/* whole chunk, straight to the caller */
+			ret = norfs_read_flash(fs, NORFS_LOC_BLK(loc),
+			                       NORFS_LOC_OFF(loc) + NORFS_REC_HDR_SIZE, p, n);
+		} else {
+			ret = norfs_fill(file, idx, 0);
+			if (ret == 0)
+				memcpy(p, file->buf + off, n);
+		}
+		if (ret != 0)
+			break;
+		p += n;
+		done += n;
+		file->pos += n;
+	}
+	NORFS_UNLOCK(fs);
+	return done ? (int)done : ret;
+}
+
+/**
+ * @brief Write at the current position (the end with NORFS_O_APPEND)
+ * @return bytes written, negative NORFS_ERR_* on failure
+ *
+ * Data is written by chunks, a partial chunk is kept until the next chunk
+ * is touched or norfs_sync()/norfs_close().
+ */
+int norfs_write(norfs_file_t *file, const void *buf, uint32_t len)
+{
+	norfs_t *fs = file->fs;
+	const uint8_t *p = buf;
+	uint32_t idx, off, n, done = 0;
+	int ret = 0;
+
+	if (!(file->flags & NORFS_O_WRITE))
+		return NORFS_ERR_INVAL;
+
+	NORFS_LOCK(fs);
+	if (file->flags & NORFS_O_APPEND)
+		file->pos = file->size;
+	if (file->pos + len < file->pos ||
+	    (file->pos + len + NORFS_CHUNK_SIZE - 1) / NORFS_CHUNK_SIZE > 0xFFFF) {
+		ret = NORFS_ERR_NOSPC;
+		goto out;
+	}
+
+	while (done < len) {
+		idx = file->pos / NORFS_CHUNK_SIZE;
+		off = file->pos % NORFS_CHUNK_SIZE;
+		n = NORFS_CHUNK_SIZE - off;
+		if (n > len - done)
+			n = len - done;
+
+		ret = norfs_fill(file, idx, n == NORFS_CHUNK_SIZE);
+		if (ret != 0)
+			break;
+		memcpy(file->buf + off, p, n);
+		if (off + n > file->buf_len)
+			file->buf_len = off + n;
+		file->dirty = 1;
+		p += n;
+		done += n;
+		file->pos += n;
+		if (file->pos > file->size)
+			file->size = file->pos;
+		if (off + n == NORFS_CHUNK_SIZE) {
+			ret = norfs_flush(file);	/* chunk complete */
+			if (ret != 0) {
+				done -= n;		/* not written */
+				file->pos -= n;
+				break;
+			}
+		}
+	}
+
+out:
+	NORFS_UNLOCK(fs);
+	return done ? (int)done : ret;
+}
+
+/**
+ * @brief Set the position, which may be past the end of the file
+ */
+int norfs_seek(norfs_file_t *file, uint32_t offset)
+{
+	NORFS_LOCK(file->fs);
+	file->pos = offset;
+	NORFS_UNLOCK(file->fs);
+	return 0;
+}
+
+uint32_t norfs_tell(norfs_file_t *file)
+{
+	return file->pos;
+}
+
+uint32_t norfs_size(norfs_file_t *file)
+{
+	return (file->flags & NORFS_O_WRITE) ? file->size : file->node->size;
+}
+
+/**
+ * @brief Cut the file at the current position
+ * @return 0 on success, negative NORFS_ERR_* on failure
+ */
+int norfs_truncate(norfs_file_t *file)
+{
+	norfs_t *fs = file->fs;
+	struct norfs_node *node = file->node;
+	int ret = 0;
+
+	if (!(file->flags & NORFS_O_WRITE))
+		return NORFS_ERR_INVAL;
+
+	NORFS_LOCK(fs);
+	if (file->pos < file->size) {
+		ret = norfs_flush(file);
+		if (ret == 0)
+			ret = norfs_cut(fs, node, file->pos, file->buf);
+		if (ret == 0) {
+			norfs_node_cut(fs, node, file->pos);
+			node->gen++;
+			file->size = file->pos;
+			file->buf_idx = NORFS_CHUNK_NONE;
+		}
+	}
+	NORFS_UNLOCK(fs);
+	return ret;
+}
+
+/**
+ * @brief Write the data kept of the file
+ * @return 0 on success, negative NORFS_ERR_* on failure
+ */
+int norfs_sync(norfs_file_t *file)
+{
+	int ret;
+
+	NORFS_LOCK(file->fs);
+	ret = norfs_flush(file);
+	NORFS_UNLOCK(file->fs);
+	return ret;
+}
+
+/**
+ * @brief Write the data kept of the file and close it
+ * @return 0 on success, negative NORFS_ERR_* on failure (the file is closed
+ *         anyway)
+ */
+int norfs_close(norfs_file_t *file)
+{
+	norfs_t *fs = file->fs;
+	int ret;
+
+	NORFS_LOCK(fs);
+	ret = norfs_flush(file);
+	file->node->open--;
+	if (file->flags & NORFS_O_WRITE)
+		file->node->writer = 0;
+	fs->open_cnt--;
+	NORFS_UNLOCK(fs);
+	free(file);
+	return ret;
+}
+
+/**
+ * @brief Delete a file
+ * @return 0 on success, negative NORFS_ERR_* on failure
+ */
+int norfs_remove(norfs_t *fs, const char *name)
+{
+	struct norfs_node *node;
+	uint32_t blk;
+	int ret;
+
+	NORFS_LOCK(fs);
+	node = norfs_find_name(fs, name);
+	if (node == NULL) {
+		ret = NORFS_ERR_NOENT;
+	} else if (node->open) {
+		ret = NORFS_ERR_BUSY;
+	} else {
+		ret = norfs_reserve(fs, NORFS_REC_HDR_SIZE, 0);
+		if (ret == NORFS_ERR_NOSPC) {
+			ret = norfs_gc_delete(fs, node);
+		} else if (ret == 0) {
+			ret = norfs_put_delete(fs, node->id, fs->seq, &blk);
+			if (ret == 0)
+				ret = norfs_tomb_add(fs, node->id, blk, fs->seq);
+			if (ret == 0)
+				norfs_node_free(fs, node);
+		}
+	}
+	NORFS_UNLOCK(fs);
+	return ret;
+}
+
+/**
+ * @brief Rename a file, replacing new_name if it exists
+ * @return 0 on success, negative NORFS_ERR_* on failure
+ *
+ * The replacement is atomic: after a power cut new_name is either the old
+ * file or the renamed one, so writing a new version under a temporary name
+ * and renaming it updates a file safely.
+ */
+int norfs_rename(norfs_t *fs, const char *old_name, const char *new_name)
+{
+	struct norfs_node *node, *target;
+	uint32_t len = strlen(new_name);
+	int ret;
+
+	if (len == 0 || len > NORFS_NAME_MAX)
+		return NORFS_ERR_INVAL;
+
+	NORFS_LOCK(fs);
+	node = norfs_find_name(fs, old_name);
+	target = norfs_find_name(fs, new_name);
+	if (node == NULL) {
+		ret = NORFS_ERR_NOENT;
+	} else if (target == node) {
+		ret = 0;
+	} else if (target && target->open) {
+		ret = NORFS_ERR_BUSY;
+	} else {
+		ret = norfs_put_inode(fs, node, new_name, node->size,
+		                      target ? target->id : NORFS_ID_NONE, 0);
+		if (ret == 0) {
+			if (target) {
+				ret = norfs_tomb_add(fs, target->id, NORFS_LOC_BLK(node->inode), fs->seq);
+				norfs_node_free(fs, target);
+			}
+			strcpy(node->name, new_name);
+			node->hash = norfs_hash(new_name);
+		}
+	}
+	NORFS_UNLOCK(fs);
+	return ret;
+}
+
+/**
+ * @brief Get the size of a file
+ * @return 0 on success, NORFS_ERR_NOENT if it does not exist
+ */
+int norfs_stat(norfs_t *fs, const char *name, uint32_t *size)
+{
+	struct norfs_node *node;
+
+	NORFS_LOCK(fs);
+	node = norfs_find_name(fs, name);
+	if (node && size)
+		*size = node->size;
+	NORFS_UNLOCK(fs);
+	return node ? 0 : NORFS_ERR_NOENT;
+}
+
+/**
+ * @brief List the files
+ * @param[in,out] index 0 for the first file, advanced on return
+ * @param[out] name NORFS_NAME_MAX + 1 bytes
+ * @param[out] size Size of the file, may be NULL
+ * @return 0 on success, NORFS_ERR_NOENT after the last file
+ */
+int norfs_readdir(norfs_t *fs, uint32_t *index, char *name, uint32_t *size)
+{
+	struct norfs_node *node;
+	int ret = NORFS_ERR_NOENT;
+
+	NORFS_LOCK(fs);
+	if (*index < fs->node_cnt) {
+		node = fs->node[(*index)++];
+		strcpy(name, node->name);
+		if (size)
+			*size = node->size;
+		ret = 0;
+	}
+	NORFS_UNLOCK(fs);
+	return ret;
+}
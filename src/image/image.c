@@ -28,9 +28,13 @@
  */
 
 #include "stdlib.h"
+#include "string.h"
 
+#include "driver/chip/chip.h"
 #include "image/image.h"
 #include "image/flash.h"
+#include "image/fdcm.h"
+#include "kernel/os/os_mutex.h"
 #include "image_debug.h"
 
 #define IMAGE_INVALID_FLASH 	(0xFF)
@@ -220,3 +224,318 @@ int image_init(uint32_t flash, uint32_t addr, uint32_t max_size)
 
 }
 
+
+#define IMAGE_CHECK_SIZE	(4 * 1024)
+#define IMG_SEC_ADDR(iop, seq, off)	((iop)->addr[(seq)] + (off) - (iop)->bl_size)
+
+/**
+ * @brief Calculate 16-bit checksum of the data buffer
+ * @param[in] data Pointer to the data buffer
+ * @param[in] len length of the data buffer
+ * @return 16-bit checksum
+ *
+ * The sum of the 16-bit little endian words, plus the last byte if len is odd,
+ * the same as the one in ROM (which calls back to here through the RAM table).
+ * The aligned part is summed four words per loop, with both halfwords of a
+ * word added at once by UADD16 on CM4F, so that it keeps up with flash reads.
+ */
+uint16_t image_checksum16(uint8_t *data, uint32_t len)
+{
+	uint32_t sum = 0;
+	uint32_t w0, w1, w2, w3;
+	uint32_t *p32;
+	uint16_t *p16;
+
+	p16 = (uint16_t *)data;
+	if (((uint32_t)p16 & 0x3) == 0x2 && len >= 2) {
+		sum += *p16++;
+		len -= 2;
+	}
+
+	p32 = (uint32_t *)p16;
+	if (((uint32_t)p32 & 0x3) == 0) {
+#ifdef __CONFIG_CPU_CM4F
+		uint32_t acc0 = 0, acc1 = 0;
+
+		while (len >= 16) {
+			w0 = p32[0];
+			w1 = p32[1];
+			w2 = p32[2];
+			w3 = p32[3];
+			p32 += 4;
+			len -= 16;
+			acc0 = __UADD16(acc0, w0);
+			acc1 = __UADD16(acc1, w1);
+			acc0 = __UADD16(acc0, w2);
+			acc1 = __UADD16(acc1, w3);
+		}
+		acc0 = __UADD16(acc0, acc1);
+		sum += (acc0 & 0xFFFF) + (acc0 >> 16);
+#else
+		while (len >= 16) {
+			w0 = p32[0];
+			w1 = p32[1];
+			w2 = p32[2];
+			w3 = p32[3];
+			p32 += 4;
+			len -= 16;
+			sum += (w0 & 0xFFFF) + (w0 >> 16) + (w1 & 0xFFFF) + (w1 >> 16)
+			     + (w2 & 0xFFFF) + (w2 >> 16) + (w3 & 0xFFFF) + (w3 >> 16);
+		}
+#endif
+	}
+
+	/* odd address or the tail, one word per load as ROM does */
+	while (len >= 4) {
+		w0 = *p32++;
+		len -= 4;
+		sum += (w0 & 0xFFFF) + (w0 >> 16);
+	}
+
+	p16 = (uint16_t *)p32;
+	if (len >= 2) {
+		sum += *p16++;
+		len -= 2;
+	}
+
+	if (len > 0) {
+		sum += *(uint8_t *)p16;
+	}
+
+	return (uint16_t)sum;
+}
+
+/*
+ * Read the whole section (header, body and tailer) and check its checksums.
+ * If gen is not NULL, the header is folded into it and the body is only read
+ * when check_data is set.
+ */
+static image_val_t _image_check_section(uint32_t flash, uint32_t addr,
+                                        uint8_t *buf, uint32_t buf_len,
+                                        uint32_t *next_addr, uint32_t *gen,
+                                        int check_data)
+{
+	uint32_t			offset;
+	uint16_t			data_chksum;
+	uint32_t			data_size;
+	uint32_t			size;
+	uint32_t			i;
+	section_header_t   *sh;
+
+	if (flash_read(flash, addr, buf, IMAGE_HEADER_SIZE) != IMAGE_HEADER_SIZE) {
+		return IMAGE_INVALID;
+	}
+
+	sh = (section_header_t *)buf;
+	if (image_check_header(sh) == IMAGE_INVALID) {
+		return IMAGE_INVALID;
+	}
+	data_chksum = sh->data_chksum;
+	data_size = sh->data_size;
+	offset = sh->next_addr;
+
+	if (gen) {
+		/* FNV-1a over the address and the header (which covers data_chksum) */
+		*gen = (*gen ^ addr) * 16777619;
+		for (i = 0; i < IMAGE_HEADER_SIZE; ++i) {
+			*gen = (*gen ^ buf[i]) * 16777619;
+		}
+	}
+
+	addr += IMAGE_HEADER_SIZE;
+	while (check_data && data_size > 0) {
+		size = data_size > buf_len ? buf_len : data_size;
+		if (flash_read(flash, addr, buf, size) != size) {
+			return IMAGE_INVALID;
+		}
+		data_chksum += image_checksum16(buf, size);
+		addr += size;
+		data_size -= size;
+	}
+
+	if (check_data && data_chksum != 0xFFFF) {
+		IMAGE_WRN("%s() fail, data checksum %#x\n", __func__, data_chksum);
+		return IMAGE_INVALID;
+	}
+
+	if (next_addr) {
+		*next_addr = offset;
+	}
+	return IMAGE_VALID;
+}
+
+/*
+ * Walk the sections of the image, from the bootloader on. gen gets the
+ * generation of the image, a hash of all the section headers.
+ */
+static image_val_t image_walk_sections(image_seq_t seq, uint32_t *gen,
+                                       int check_data)
+{
+	uint32_t flash;
+	uint32_t addr;
+	uint32_t next_addr;
+	uint8_t *buf;
+	uint32_t buf_len;
+	const image_ota_param_t *iop = image_get_ota_param();
+
+	if (seq >= IMAGE_SEQ_NUM) {
+		IMAGE_ERR("invalid seq %d\n", seq);
+		return IMAGE_INVALID;
+	}
+
+	buf_len = check_data ? IMAGE_CHECK_SIZE : IMAGE_HEADER_SIZE;
+	buf = malloc(buf_len);
+	if (buf == NULL) {
+		IMAGE_ERR("no mem\n");
+		return IMAGE_INVALID;
+	}
+
+	*gen = 2166136261U;
+	flash = IMG_BL_FLASH(iop);
+	addr = IMG_BL_ADDR(iop);
+
+	while (1) {
+		if (_image_check_section(flash, addr, buf, buf_len, &next_addr,
+		                         gen, check_data) == IMAGE_INVALID) {
+			IMAGE_WRN("%s(), invalid section, seq %d, flash %u, addr %#x\n",
+					  __func__, seq, flash, addr);
+			free(buf);
+			return IMAGE_INVALID;
+		}
+		if (next_addr == IMAGE_INVALID_ADDR)
+			break;
+
+		flash = iop->flash[seq];
+		addr = IMG_SEC_ADDR(iop, seq, next_addr);
+	}
+
+	if (*gen == IMAGE_CHECK_GEN_NONE)
+		*gen = 1;
+
+	free(buf);
+	return IMAGE_VALID;
+}
+
+/*
+ * Validated generation of each image sequence, kept by fdcm in the area set
+ * by image_check_cache_init(). Written only when a full check passes on an
+ * image not recorded yet, or fails on one recorded. Updated by both the scrub
+ * thread and OTA, so updates are serialized by image_check_cache_mutex.
+ */
+static fdcm_handle_t *image_check_cache_hdl;
+static image_check_cache_t image_check_cache;
+static OS_Mutex_t image_check_cache_mutex;
+
+static void image_check_cache_update(image_seq_t seq, uint32_t gen)
+{
+	if (image_check_cache_hdl == NULL)
+		return;
+
+	OS_MutexLock(&image_check_cache_mutex, OS_WAIT_FOREVER);
+	if (image_check_cache_hdl != NULL && image_check_cache.gen[seq] != gen) {
+		image_check_cache.gen[seq] = gen;
+		if (fdcm_write(image_check_cache_hdl, &image_check_cache,
+		               sizeof(image_check_cache)) != sizeof(image_check_cache)) {
+			IMAGE_ERR("write check cache failed\n");
+		}
+	}
+	OS_MutexUnlock(&image_check_cache_mutex);
+}
+
+/**
+ * @brief Open the record of validated images
+ * @param[in] flash Flash device number of the record area
+ * @param[in] addr Start address of the record area
+ * @param[in] size Size of the record area (4K at least)
+ * @retval 0 on success, -1 on failure
+ */
+int image_check_cache_init(uint32_t flash, uint32_t addr, uint32_t size)
+{
+	fdcm_handle_t *hdl;
+
+	if (!OS_MutexIsValid(&image_check_cache_mutex) &&
+	    OS_MutexCreate(&image_check_cache_mutex) != OS_OK) {
+		IMAGE_ERR("mutex create failed\n");
+		return -1;
+	}
+
+	hdl = fdcm_open(flash, addr, size);
+	if (hdl == NULL) {
+		IMAGE_ERR("fdcm open failed\n");
+		return -1;
+	}
+
+	if (fdcm_read(hdl, &image_check_cache,
+	              sizeof(image_check_cache)) != sizeof(image_check_cache)) {
+		memset(&image_check_cache, 0, sizeof(image_check_cache));
+	}
+	image_check_cache_hdl = hdl;
+	return 0;
+}
+
+/**
+ * @brief Close the record of validated images
+ * @return None
+ */
+void image_check_cache_deinit(void)
+{
+	if (image_check_cache_hdl) {
+		OS_MutexLock(&image_check_cache_mutex, OS_WAIT_FOREVER);
+		fdcm_close(image_check_cache_hdl);
+		image_check_cache_hdl = NULL;
+		OS_MutexUnlock(&image_check_cache_mutex);
+	}
+}
+
+/**
+ * @brief Forget the validation of the specified image, MUST be called before
+ *        the image is written (e.g. by OTA)
+ * @param[in] seq Sequence of the specified image
+ * @return None
+ */
+void image_check_cache_clear(image_seq_t seq)
+{
+	if (seq < IMAGE_SEQ_NUM)
+		image_check_cache_update(seq, IMAGE_CHECK_GEN_NONE);
+}
+
+/**
+ * @brief Check vadility of all sections in the specified image
+ * @param[in] seq Sequence of the specified image
+ * @retval image_val_t, IMAGE_VALID on valid, IMAGE_INVALID on invalid
+ *
+ * All the data is read and checked, the result is recorded if
+ * image_check_cache_init() is done.
+ */
+image_val_t image_check_sections(image_seq_t seq)
+{
+	uint32_t gen;
+	image_val_t ret;
+
+	IMAGE_DBG("%s(), seq %d\n", __func__, seq);
+
+	ret = image_walk_sections(seq, &gen, 1);
+	if (seq < IMAGE_SEQ_NUM)
+		image_check_cache_update(seq, ret == IMAGE_VALID ? gen : IMAGE_CHECK_GEN_NONE);
+	return ret;
+}
+
+/**
+ * @brief Check vadility of all sections in the specified image, only reading
+ *        the section headers if the same image passed image_check_sections()
+ * @param[in] seq Sequence of the specified image
+ * @retval image_val_t, IMAGE_VALID on valid, IMAGE_INVALID on invalid
+ */
+image_val_t image_check_sections_cached(image_seq_t seq)
+{
+	uint32_t gen;
+
+	if (image_check_cache_hdl != NULL &&
+	    image_walk_sections(seq, &gen, 0) == IMAGE_VALID &&
+	    gen == image_check_cache.gen[seq]) {
+		IMAGE_DBG("%s(), seq %d, gen %#x validated\n", __func__, seq, gen);
+		return IMAGE_VALID;
+	}
+
+	return image_check_sections(seq);
+}
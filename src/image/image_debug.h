@@ -52,6 +52,11 @@ extern "C" {
 #define FLASH_ERR_ON    1
 #define FLASH_ABORT_ON  0
 
+#define KVS_DBG_ON      0
+#define KVS_WRN_ON      0
+#define KVS_ERR_ON      1
+#define KVS_ABORT_ON    0
+
 #define IMAGE_SYSLOG    printf
 #define IMAGE_ABORT()   sys_abort()
 
@@ -109,6 +114,25 @@ extern "C" {
             FLASH_ABORT();                                  \
     } while (0)
 
+#define KVS_SYSLOG      printf
+#define KVS_ABORT()     sys_abort()
+
+#define KVS_LOG(flags, fmt, arg...)     \
+    do {                                \
+        if (flags)                      \
+            KVS_SYSLOG(fmt, ##arg);     \
+    } while (0)
+
+#define KVS_DBG(fmt, arg...)    KVS_LOG(KVS_DBG_ON, "[kvs] "fmt, ##arg)
+#define KVS_WRN(fmt, arg...)    KVS_LOG(KVS_WRN_ON, "[kvs W] "fmt, ##arg)
+#define KVS_ERR(fmt, arg...)                            \
+    do {                                                \
+        KVS_LOG(KVS_ERR_ON, "[kvs E] %s():%d, "fmt,     \
+                __func__, __LINE__, ##arg);             \
+        if (KVS_ABORT_ON)                               \
+            KVS_ABORT();                                \
+    } while (0)
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,821 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "image/flash.h"
+#include "image/kvs.h"
+
+#include "image_debug.h"
+
+#define KVS_SECTOR_MAGIC	(0x3153564B)	/* "KVS1" */
+#define KVS_SECTOR_HDR_SIZE	(8)
+#define KVS_REC_HDR_SIZE	(8)
+#define KVS_REC_ALIGN(n)	(((n) + 3) & ~3U)
+#define KVS_COPY_BUF_SIZE	(64)
+
+/* record state, written after the rest of the record */
+#define KVS_REC_EMPTY		(0xFF)
+#define KVS_REC_VALUE		(0xA5)
+#define KVS_REC_DELETED		(0x5A)
+
+typedef struct kvs_sector_hdr {
+	uint32_t	magic;
+	uint32_t	seq;
+} kvs_sector_hdr_t;
+
+typedef struct kvs_rec_hdr {
+	uint8_t		state;
+	uint8_t		key_len;
+	uint16_t	data_len;
+	uint32_t	crc;		/* key_len, data_len, key and data */
+} kvs_rec_hdr_t;
+
+struct kvs_slot {
+	uint32_t	offset;		/* of the record in the area, 0 if unused */
+	uint16_t	hash;
+	uint16_t	size;		/* of the record */
+};
+
+#define KVS_SLOT_NEXT(hdl, i)	(((i) + 1) & ((hdl)->index_size - 1))
+
+static uint32_t kvs_crc32(uint32_t crc, const void *buf, uint32_t len)
+{
+	static const uint32_t tbl[16] = {
+		0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+		0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+		0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+		0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+	};
+	const uint8_t *p = buf;
+
+	crc = ~crc;
+	while (len--) {
+		crc ^= *p++;
+		crc = (crc >> 4) ^ tbl[crc & 0xF];
+		crc = (crc >> 4) ^ tbl[crc & 0xF];
+	}
+	return ~crc;
+}
+
+static uint16_t kvs_hash(const char *key, uint8_t key_len)
+{
+	uint32_t h = 2166136261U;
+
+	while (key_len--) {
+		h ^= (uint8_t)*key++;
+		h *= 16777619U;
+	}
+	return (uint16_t)(h ^ (h >> 16));
+}
+
+static __inline uint32_t kvs_sector_addr(kvs_handle_t *hdl, uint32_t sector)
+{
+	return hdl->addr + sector * KVS_SECTOR_SIZE;
+}
+
+static int kvs_read(kvs_handle_t *hdl, uint32_t offset, void *buf, uint32_t len)
+{
+	return (flash_read(hdl->flash, hdl->addr + offset, buf, len) == len) ? 0 : -1;
+}
+
+static int kvs_write(kvs_handle_t *hdl, uint32_t offset, const void *buf, uint32_t len)
+{
+	return (flash_write(hdl->flash, hdl->addr + offset, buf, len) == len) ? 0 : -1;
+}
+
+static int kvs_erase_sector(kvs_handle_t *hdl, uint32_t sector)
+{
+	KVS_DBG("%s(), sector %u\n", __func__, sector);
+	return flash_erase(hdl->flash, kvs_sector_addr(hdl, sector), KVS_SECTOR_SIZE);
+}
+
+/* return 1 if [offset, offset + len) reads as erased */
+static int kvs_is_erased(kvs_handle_t *hdl, uint32_t offset, uint32_t len)
+{
+	uint32_t buf[KVS_COPY_BUF_SIZE / 4];
+	uint32_t n, i;
+
+	while (len) {
+		n = (len > sizeof(buf)) ? sizeof(buf) : len;
+		if (kvs_read(hdl, offset, buf, n) != 0)
+			return 0;
+		for (i = 0; i < n / 4; i++) {
+			if (buf[i] != 0xFFFFFFFF)
+				return 0;
+		}
+		offset += n;
+		len -= n;
+	}
+	return 1;
+}
+
+/* return 0 if the record at offset holds key */
+static int kvs_key_cmp(kvs_handle_t *hdl, uint32_t offset, const char *key,
+                       uint8_t key_len)
+{
+	kvs_rec_hdr_t rh;
+	char buf[KVS_KEY_LEN_MAX];
+
+	if (kvs_read(hdl, offset, &rh, KVS_REC_HDR_SIZE) != 0 ||
+	    rh.key_len != key_len ||
+	    kvs_read(hdl, offset + KVS_REC_HDR_SIZE, buf, key_len) != 0) {
+		return -1;
+	}
+	return memcmp(buf, key, key_len);
+}
+
+static struct kvs_slot *kvs_index_find(kvs_handle_t *hdl, const char *key,
+                                       uint8_t key_len)
+{
+	uint16_t hash = kvs_hash(key, key_len);
+	uint32_t i = hash & (hdl->index_size - 1);
+	struct kvs_slot *slot;
+
+	while ((slot = &hdl->index[i])->offset != 0) {
+		if (slot->hash == hash &&
+		    kvs_key_cmp(hdl, slot->offset, key, key_len) == 0) {
+			return slot;
+		}
+		i = KVS_SLOT_NEXT(hdl, i);
+	}
+	return NULL;
+}
+
+static int kvs_index_add(kvs_handle_t *hdl, const char *key, uint8_t key_len,
+                         uint32_t offset, uint16_t size)
+{
+	uint16_t hash = kvs_hash(key, key_len);
+	uint32_t i = hash & (hdl->index_size - 1);
+
+	if (hdl->key_cnt >= hdl->key_max) {
+		KVS_ERR("too many keys, max %u\n", hdl->key_max);
+		return -1;
+	}
+	while (hdl->index[i].offset != 0)
+		i = KVS_SLOT_NEXT(hdl, i);
+	hdl->index[i].offset = offset;
+	hdl->index[i].hash = hash;
+	hdl->index[i].size = size;
+	hdl->key_cnt++;
+	hdl->live += size;
+	return 0;
+}
+
+/* linear probing removal, shifting back the entries of the same run */
+static void kvs_index_remove(kvs_handle_t *hdl, struct kvs_slot *slot)
+{
+	uint32_t mask = hdl->index_size - 1;
+	uint32_t hole = slot - hdl->index;
+	uint32_t i = hole, home;
+
+	hdl->live -= slot->size;
+	hdl->key_cnt--;
+	while (1) {
+		hdl->index[hole].offset = 0;
+		do {
+			i = (i + 1) & mask;
+			if (hdl->index[i].offset == 0)
+				return;
+			home = hdl->index[i].hash & mask;
+		} while (((i - home) & mask) < ((i - hole) & mask));
+		hdl->index[hole] = hdl->index[i];
+		hole = i;
+	}
+}
+
+/* make the latest record of a key found at mount or written */
+static int kvs_index_update(kvs_handle_t *hdl, const char *key, uint8_t key_len,
+                            uint8_t state, uint32_t offset, uint16_t size)
+{
+	struct kvs_slot *slot = kvs_index_find(hdl, key, key_len);
+
+	if (state == KVS_REC_DELETED) {
+		if (slot)
+			kvs_index_remove(hdl, slot);
+		return 0;
+	}
+	if (slot) {
+		hdl->live += size - slot->size;
+		slot->offset = offset;
+		slot->size = size;
+		return 0;
+	}
+	return kvs_index_add(hdl, key, key_len, offset, size);
+}
+
+static int kvs_rec_check(kvs_handle_t *hdl, uint32_t offset, kvs_rec_hdr_t *rh,
+                         char *key)
+{
+	uint8_t buf[KVS_COPY_BUF_SIZE];
+	uint32_t crc, pos, n, end;
+
+	crc = kvs_crc32(0, &rh->key_len, 3);
+	if (kvs_read(hdl, offset + KVS_REC_HDR_SIZE, key, rh->key_len) != 0)
+		return -1;
+	crc = kvs_crc32(crc, key, rh->key_len);
+	pos = offset + KVS_REC_HDR_SIZE + rh->key_len;
+	end = pos + rh->data_len;
+	for (; pos < end; pos += n) {
+		n = (end - pos > sizeof(buf)) ? sizeof(buf) : end - pos;
+		if (kvs_read(hdl, pos, buf, n) != 0)
+			return -1;
+		crc = kvs_crc32(crc, buf, n);
+	}
+	return (crc == rh->crc) ? 0 : -1;
+}
+
+/*
+ * Index the records of a sector. Returns the offset in the sector where the
+ * records end, anything after it is erased or left by a cut write.
+ */
+static uint32_t kvs_scan_sector(kvs_handle_t *hdl, uint32_t sector)
+{
+	uint32_t base = sector * KVS_SECTOR_SIZE;
+	uint32_t off = KVS_SECTOR_HDR_SIZE, size;
+	kvs_rec_hdr_t rh;
+	char key[KVS_KEY_LEN_MAX];
+
+	while (off + KVS_REC_HDR_SIZE <= KVS_SECTOR_SIZE) {
+		if (kvs_read(hdl, base + off, &rh, KVS_REC_HDR_SIZE) != 0)
+			return KVS_SECTOR_SIZE;
+		if (rh.state == KVS_REC_EMPTY && rh.key_len == 0xFF &&
+		    rh.data_len == 0xFFFF && rh.crc == 0xFFFFFFFF) {
+			break;
+		}
+		if (rh.state == 0 && rh.key_len == 0 && rh.data_len == 0) {
+			off += 4;	/* cleared by kvs_fix_tail() */
+			continue;
+		}
+		size = KVS_REC_ALIGN(KVS_REC_HDR_SIZE + rh.key_len + rh.data_len);
+		if (rh.key_len == 0 || rh.key_len > KVS_KEY_LEN_MAX ||
+		    off + size > KVS_SECTOR_SIZE) {
+			KVS_WRN("sector %u: bad record at %u\n", sector, off);
+			break;
+		}
+		if ((rh.state == KVS_REC_VALUE || rh.state == KVS_REC_DELETED) &&
+		    kvs_rec_check(hdl, base + off, &rh, key) == 0) {
+			if (kvs_index_update(hdl, key, rh.key_len, rh.state, base + off,
+			                     rh.state == KVS_REC_VALUE ? size : 0) != 0) {
+				KVS_ERR("drop key %.*s\n", rh.key_len, key);
+			}
+		}
+		off += size;
+	}
+	return off;
+}
+
+/*
+ * Clear what a cut write left behind the records of the active sector, so
+ * that appending can go on after it and later scans step over it. Returns
+ * the new write offset.
+ */
+static uint32_t kvs_fix_tail(kvs_handle_t *hdl, uint32_t sector, uint32_t off)
+{
+	uint32_t buf[KVS_COPY_BUF_SIZE / 4];
+	uint32_t base = sector * KVS_SECTOR_SIZE;
+	uint32_t end = KVS_SECTOR_SIZE, n, i;
+
+	/* the last programmed word */
+	while (end > off) {
+		n = (end - off > sizeof(buf)) ? sizeof(buf) : end - off;
+		if (kvs_read(hdl, base + end - n, buf, n) != 0)
+			return KVS_SECTOR_SIZE;
+		for (i = n / 4; i > 0 && buf[i - 1] == 0xFFFFFFFF; i--)
+			;
+		if (i > 0) {
+			end -= n - i * 4;
+			break;
+		}
+		end -= n;
+	}
+	if (end == off)
+		return off;
+
+	KVS_WRN("sector %u: clear %u to %u\n", sector, off, end);
+	memset(buf, 0, sizeof(buf));
+	for (i = off; i < end; i += n) {
+		n = (end - i > sizeof(buf)) ? sizeof(buf) : end - i;
+		if (kvs_write(hdl, base + i, buf, n) != 0)
+			return KVS_SECTOR_SIZE;
+	}
+	return end;
+}
+
+static int kvs_sector_seq(kvs_handle_t *hdl, uint32_t sector, uint32_t *seq)
+{
+	kvs_sector_hdr_t sh;
+
+	if (kvs_read(hdl, sector * KVS_SECTOR_SIZE, &sh, sizeof(sh)) != 0 ||
+	    sh.magic != KVS_SECTOR_MAGIC) {
+		return -1;
+	}
+	*seq = sh.seq;
+	return 0;
+}
+
+/* start appending to an erased sector */
+static int kvs_open_sector(kvs_handle_t *hdl)
+{
+	kvs_sector_hdr_t sh;
+	uint32_t i, n, seq;
+
+	/* the one after the active sector, to spread the erases */
+	for (n = 1; n <= hdl->sector_cnt; n++) {
+		i = (hdl->active + n) % hdl->sector_cnt;
+		if (i != hdl->active && kvs_sector_seq(hdl, i, &seq) != 0)
+			break;
+	}
+	if (n > hdl->sector_cnt || hdl->free_cnt == 0) {
+		KVS_ERR("no free sector\n");
+		return -1;
+	}
+
+	/* the magic last, so that a valid sector has a complete seq */
+	sh.magic = KVS_SECTOR_MAGIC;
+	sh.seq = hdl->seq + 1;
+	if (kvs_write(hdl, i * KVS_SECTOR_SIZE + 4, &sh.seq, 4) != 0 ||
+	    kvs_write(hdl, i * KVS_SECTOR_SIZE, &sh.magic, 4) != 0) {
+		return -1;
+	}
+	hdl->free_cnt--;
+	hdl->active = i;
+	hdl->seq = sh.seq;
+	hdl->wp = KVS_SECTOR_HDR_SIZE;
+	KVS_DBG("%s(), sector %u, seq %u\n", __func__, i, sh.seq);
+	return 0;
+}
+
+/* copy a record to the active sector, returns its new offset or 0 */
+static uint32_t kvs_copy_rec(kvs_handle_t *hdl, uint32_t offset, uint32_t size)
+{
+	uint8_t buf[KVS_COPY_BUF_SIZE];
+	uint32_t dst, pos, n;
+	uint8_t state = KVS_REC_EMPTY;
+
+	if (hdl->wp + size > KVS_SECTOR_SIZE && kvs_open_sector(hdl) != 0)
+		return 0;
+	dst = hdl->active * KVS_SECTOR_SIZE + hdl->wp;
+
+	for (pos = 0; pos < size; pos += n) {
+		n = (size - pos > sizeof(buf)) ? sizeof(buf) : size - pos;
+		if (kvs_read(hdl, offset + pos, buf, n) != 0)
+			return 0;
+		if (pos == 0) {
+			state = buf[0];
+			buf[0] = KVS_REC_EMPTY;
+		}
+		if (kvs_write(hdl, dst + pos, buf, n) != 0)
+			return 0;
+	}
+	hdl->wp += size;
+	if (kvs_write(hdl, dst, &state, 1) != 0)
+		return 0;
+	return dst;
+}
+
+/*
+ * Move the latest records out of the oldest sector and erase it. Tombstones
+ * are dropped, there is nothing older left for them to hide. If the active
+ * sector is the only one in use, it is compacted into an erased one.
+ */
+static int kvs_gc(kvs_handle_t *hdl)
+{
+	uint32_t i, seq, oldest = 0, oldest_seq = 0xFFFFFFFF;
+	uint32_t base, dst;
+	struct kvs_slot *slot;
+	static const uint32_t zero = 0;
+
+	for (i = 0; i < hdl->sector_cnt; i++) {
+		if (kvs_sector_seq(hdl, i, &seq) == 0 && seq < oldest_seq) {
+			oldest = i;
+			oldest_seq = seq;
+		}
+	}
+	if (oldest_seq == 0xFFFFFFFF)
+		return -1;
+	KVS_DBG("%s(), sector %u, seq %u\n", __func__, oldest, oldest_seq);
+
+	if (oldest == hdl->active && kvs_open_sector(hdl) != 0)
+		return -1;
+
+	base = oldest * KVS_SECTOR_SIZE;
+	for (i = 0; i < hdl->index_size; i++) {
+		slot = &hdl->index[i];
+		if (slot->offset == 0 || slot->offset < base ||
+		    slot->offset >= base + KVS_SECTOR_SIZE) {
+			continue;
+		}
+		dst = kvs_copy_rec(hdl, slot->offset, slot->size);
+		if (dst == 0)
+			return -1;
+		slot->offset = dst;
+	}
+
+	/* the copies are the latest now, never mount a half erased sector again */
+	if (kvs_write(hdl, base, &zero, sizeof(zero)) != 0 ||
+	    kvs_erase_sector(hdl, oldest) != 0) {
+		return -1;
+	}
+	hdl->free_cnt++;
+	return 0;
+}
+
+/* make room for size bytes in the active sector, keeping one erased sector for gc */
+static int kvs_reserve(kvs_handle_t *hdl, uint32_t size)
+{
+	uint32_t budget = hdl->sector_cnt;
+
+	while (hdl->wp + size > KVS_SECTOR_SIZE) {
+		if (hdl->free_cnt > 1) {
+			if (kvs_open_sector(hdl) != 0)
+				return -1;
+		} else if (budget-- == 0 || kvs_gc(hdl) != 0) {
+			KVS_ERR("no space for %u bytes\n", size);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static int kvs_append(kvs_handle_t *hdl, const char *key, uint8_t key_len,
+                      uint8_t state, const void *data, uint16_t data_len,
+                      uint32_t *offset)
+{
+	kvs_rec_hdr_t rh;
+	uint32_t size, dst;
+
+	size = KVS_REC_ALIGN(KVS_REC_HDR_SIZE + key_len + data_len);
+	if (kvs_reserve(hdl, size) != 0)
+		return -1;
+
+	rh.state = KVS_REC_EMPTY;
+	rh.key_len = key_len;
+	rh.data_len = data_len;
+	rh.crc = kvs_crc32(0, &rh.key_len, 3);
+	rh.crc = kvs_crc32(rh.crc, key, key_len);
+	rh.crc = kvs_crc32(rh.crc, data, data_len);
+
+	dst = hdl->active * KVS_SECTOR_SIZE + hdl->wp;
+	hdl->wp += size;	/* taken even if the write fails half way */
+	if (kvs_write(hdl, dst, &rh, KVS_REC_HDR_SIZE) != 0 ||
+	    kvs_write(hdl, dst + KVS_REC_HDR_SIZE, key, key_len) != 0 ||
+	    (data_len && kvs_write(hdl, dst + KVS_REC_HDR_SIZE + key_len,
+	                           data, data_len) != 0) ||
+	    kvs_write(hdl, dst, &state, 1) != 0) {
+		return -1;
+	}
+	*offset = dst;
+	return size;
+}
+
+static int kvs_mount(kvs_handle_t *hdl)
+{
+	uint32_t i, j, seq, min, prev = 0, sel = 0, cnt = 0, end;
+
+	hdl->free_cnt = 0;
+	hdl->seq = 0;
+	for (i = 0; i < hdl->sector_cnt; i++) {
+		if (kvs_sector_seq(hdl, i, &seq) == 0) {
+			if (cnt++ == 0 || seq > hdl->seq) {
+				hdl->seq = seq;
+				hdl->active = i;
+			}
+			continue;
+		}
+		/* erased, or an erase or sector start was cut short */
+		if (!kvs_is_erased(hdl, i * KVS_SECTOR_SIZE, KVS_SECTOR_SIZE) &&
+		    kvs_erase_sector(hdl, i) != 0) {
+			return -1;
+		}
+		hdl->free_cnt++;
+	}
+
+	if (cnt == 0) {
+		hdl->active = hdl->sector_cnt;
+		return kvs_open_sector(hdl);
+	}
+
+	/* replay the sectors from the oldest, later records win */
+	for (j = 0; j < cnt; j++) {
+		min = 0xFFFFFFFF;
+		for (i = 0; i < hdl->sector_cnt; i++) {
+			if (kvs_sector_seq(hdl, i, &seq) == 0 &&
+			    (j == 0 || seq > prev) && seq <= min) {
+				min = seq;
+				sel = i;
+			}
+		}
+		prev = min;
+		end = kvs_scan_sector(hdl, sel);
+		if (sel == hdl->active)
+			hdl->wp = end;
+	}
+
+	/*
+	 * A gc was cut short after taking the last erased sector. That sector
+	 * holds copies of records still in the one being emptied, and maybe what
+	 * the cut left, so that the gc may not fit in it any more. Drop it and
+	 * mount again, the next update does the gc from the start.
+	 */
+	if (hdl->free_cnt == 0) {
+		KVS_WRN("sector %u: gc cut short, erase\n", hdl->active);
+		if (kvs_erase_sector(hdl, hdl->active) != 0)
+			return -1;
+		memset(hdl->index, 0, hdl->index_size * sizeof(struct kvs_slot));
+		hdl->key_cnt = 0;
+		hdl->live = 0;
+		return kvs_mount(hdl);
+	}
+
+	hdl->wp = kvs_fix_tail(hdl, hdl->active, hdl->wp);
+
+	KVS_DBG("%s(), %u keys, %u bytes, active sector %u at %u, %u free\n",
+	        __func__, hdl->key_cnt, hdl->live, hdl->active, hdl->wp,
+	        hdl->free_cnt);
+	return 0;
+}
+
+/**
+ * @brief Open a flash area as key-value store, formatting it if needed
+ * @param[in] flash Flash device number
+ * @param[in] addr Start address of the area
+ * @param[in] size Size of the area, at least 2 sectors of KVS_SECTOR_SIZE
+ * @param[in] key_max Maximum number of keys, sizes the RAM index
+ * @retval Pointer to the KVS handle, NULL on failure
+ *
+ * @note The area must be aligned to KVS_SECTOR_SIZE. Keys found beyond
+ *       key_max are lost on the next garbage collection.
+ */
+kvs_handle_t *kvs_open(uint32_t flash, uint32_t addr, uint32_t size,
+                       uint16_t key_max)
+{
+	kvs_handle_t *hdl;
+	uint32_t index_size = 4;
+
+	if ((addr % KVS_SECTOR_SIZE) || (size % KVS_SECTOR_SIZE) ||
+	    size < 2 * KVS_SECTOR_SIZE || key_max == 0 ||
+	    flash_get_erase_block(flash, addr, size) < 0) {
+		KVS_ERR("invalid area (%u, %#x, %u)\n", flash, addr, size);
+		return NULL;
+	}
+
+	while (index_size < 2 * (uint32_t)key_max)
+		index_size <<= 1;
+
+	hdl = malloc(sizeof(kvs_handle_t));
+	if (hdl == NULL) {
+		KVS_ERR("no mem\n");
+		return NULL;
+	}
+	memset(hdl, 0, sizeof(kvs_handle_t));
+	hdl->index = malloc(index_size * sizeof(struct kvs_slot));
+	if (hdl->index == NULL) {
+		KVS_ERR("no mem\n");
+		free(hdl);
+		return NULL;
+	}
+	memset(hdl->index, 0, index_size * sizeof(struct kvs_slot));
+	hdl->flash = flash;
+	hdl->addr = addr;
+	hdl->size = size;
+	hdl->index_size = index_size;
+	hdl->key_max = key_max;
+	hdl->sector_cnt = size / KVS_SECTOR_SIZE;
+
+	if (kvs_mount(hdl) != 0 || OS_MutexCreate(&hdl->mutex) != OS_OK) {
+		KVS_ERR("mount (%u, %#x, %u) fail\n", flash, addr, size);
+		free(hdl->index);
+		free(hdl);
+		return NULL;
+	}
+	return hdl;
+}
+
+static int kvs_key_len(const char *key)
+{
+	size_t len;
+
+	if (key == NULL)
+		return -1;
+	len = strlen(key);
+	if (len == 0 || len > KVS_KEY_LEN_MAX) {
+		KVS_ERR("invalid key %s\n", key);
+		return -1;
+	}
+	return len;
+}
+
+/**
+ * @brief Read the value of a key
+ * @param[in] hdl Pointer to the KVS handle
+ * @param[in] key Null terminated key, up to KVS_KEY_LEN_MAX characters
+ * @param[out] data Buffer for the value, may be NULL to query the size
+ * @param[in] data_size Size of the buffer, a longer value is truncated
+ * @return Size of the stored value, -1 if the key is not found
+ */
+int kvs_get(kvs_handle_t *hdl, const char *key, void *data, uint16_t data_size)
+{
+	struct kvs_slot *slot;
+	kvs_rec_hdr_t rh;
+	int key_len, ret = -1;
+
+	key_len = kvs_key_len(key);
+	if (hdl == NULL || key_len < 0)
+		return -1;
+
+	OS_MutexLock(&hdl->mutex, OS_WAIT_FOREVER);
+	slot = kvs_index_find(hdl, key, key_len);
+	if (slot && kvs_read(hdl, slot->offset, &rh, KVS_REC_HDR_SIZE) == 0) {
+		if (data_size > rh.data_len)
+			data_size = rh.data_len;
+		if (data == NULL || data_size == 0 ||
+		    kvs_read(hdl, slot->offset + KVS_REC_HDR_SIZE + key_len,
+		             data, data_size) == 0) {
+			ret = rh.data_len;
+		}
+	}
+	OS_MutexUnlock(&hdl->mutex);
+	return ret;
+}
+
+/* return 1 if the record at slot already holds data */
+static int kvs_data_equal(kvs_handle_t *hdl, struct kvs_slot *slot,
+                          uint8_t key_len, const void *data, uint16_t data_size)
+{
+	uint8_t buf[KVS_COPY_BUF_SIZE];
+	uint32_t pos, n, offset;
+	kvs_rec_hdr_t rh;
+
+	if (kvs_read(hdl, slot->offset, &rh, KVS_REC_HDR_SIZE) != 0 ||
+	    rh.data_len != data_size) {
+		return 0;
+	}
+	offset = slot->offset + KVS_REC_HDR_SIZE + key_len;
+	for (pos = 0; pos < data_size; pos += n) {
+		n = (data_size - pos > sizeof(buf)) ? sizeof(buf) : data_size - pos;
+		if (kvs_read(hdl, offset + pos, buf, n) != 0 ||
+		    memcmp(buf, (const uint8_t *)data + pos, n) != 0) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/**
+ * @brief Store the value of a key, replacing the previous one
+ * @param[in] hdl Pointer to the KVS handle
+ * @param[in] key Null terminated key, up to KVS_KEY_LEN_MAX characters
+ * @param[in] data Pointer to the value
+ * @param[in] data_size Size of the value, up to KVS_VALUE_LEN_MAX
+ * @return 0 on success, -1 on failure (the previous value is kept)
+ *
+ * @note Writing the value already stored does not touch the flash.
+ */
+int kvs_set(kvs_handle_t *hdl, const char *key, const void *data,
+            uint16_t data_size)
+{
+	struct kvs_slot *slot;
+	uint32_t size, offset;
+	int key_len, ret = -1;
+
+	key_len = kvs_key_len(key);
+	if (hdl == NULL || key_len < 0 || (data == NULL && data_size) ||
+	    data_size > KVS_VALUE_LEN_MAX) {
+		KVS_ERR("hdl %p, data (%p, %u)\n", hdl, data, data_size);
+		return -1;
+	}
+	size = KVS_REC_ALIGN(KVS_REC_HDR_SIZE + key_len + data_size);
+
+	OS_MutexLock(&hdl->mutex, OS_WAIT_FOREVER);
+	slot = kvs_index_find(hdl, key, key_len);
+	if (slot && kvs_data_equal(hdl, slot, key_len, data, data_size)) {
+		ret = 0;
+		goto out;
+	}
+	if (slot == NULL && hdl->key_cnt >= hdl->key_max) {
+		KVS_ERR("too many keys, max %u\n", hdl->key_max);
+		goto out;
+	}
+	/* the old record stays live until the new one is written */
+	if (hdl->live + size >
+	    (uint32_t)(hdl->sector_cnt - 1) * (KVS_SECTOR_SIZE - KVS_SECTOR_HDR_SIZE)) {
+		KVS_ERR("no space, %u bytes used\n", hdl->live);
+		goto out;
+	}
+	if (kvs_append(hdl, key, key_len, KVS_REC_VALUE, data, data_size,
+	               &offset) < 0) {
+		goto out;
+	}
+	ret = kvs_index_update(hdl, key, key_len, KVS_REC_VALUE, offset, size);
+out:
+	OS_MutexUnlock(&hdl->mutex);
+	return ret;
+}
+
+/**
+ * @brief Remove a key
+ * @param[in] hdl Pointer to the KVS handle
+ * @param[in] key Null terminated key
+ * @return 0 on success or if the key is not found, -1 on failure
+ */
+int kvs_delete(kvs_handle_t *hdl, const char *key)
+{
+	struct kvs_slot *slot;
+	uint32_t offset;
+	int key_len, ret = 0;
+
+	key_len = kvs_key_len(key);
+	if (hdl == NULL || key_len < 0)
+		return -1;
+
+	OS_MutexLock(&hdl->mutex, OS_WAIT_FOREVER);
+	slot = kvs_index_find(hdl, key, key_len);
+	if (slot) {
+		if (kvs_append(hdl, key, key_len, KVS_REC_DELETED, NULL, 0,
+		               &offset) < 0) {
+			ret = -1;
+		} else {
+			/* gc may have moved it */
+			slot = kvs_index_find(hdl, key, key_len);
+			if (slot)
+				kvs_index_remove(hdl, slot);
+		}
+	}
+	OS_MutexUnlock(&hdl->mutex);
+	return ret;
+}
+
+/**
+ * @brief Remove all keys, erasing the whole area
+ * @param[in] hdl Pointer to the KVS handle
+ * @return 0 on success, -1 on failure
+ */
+int kvs_erase(kvs_handle_t *hdl)
+{
+	int ret = -1;
+
+	if (hdl == NULL) {
+		KVS_ERR("hdl %p\n", hdl);
+		return -1;
+	}
+
+	OS_MutexLock(&hdl->mutex, OS_WAIT_FOREVER);
+	memset(hdl->index, 0, hdl->index_size * sizeof(struct kvs_slot));
+	hdl->key_cnt = 0;
+	hdl->live = 0;
+	hdl->seq = 0;
+	if (flash_erase(hdl->flash, hdl->addr, hdl->size) == 0) {
+		hdl->free_cnt = hdl->sector_cnt;
+		hdl->active = hdl->sector_cnt;
+		ret = kvs_open_sector(hdl);
+	} else {
+		KVS_ERR("erase fail, (%u, %#x, %u)\n",
+		        hdl->flash, hdl->addr, hdl->size);
+	}
+	OS_MutexUnlock(&hdl->mutex);
+	return ret;
+}
+
+/**
+ * @brief Close the key-value store
+ * @param[in] hdl Pointer to the KVS handle
+ * @return None
+ */
+void kvs_close(kvs_handle_t *hdl)
+{
+	KVS_DBG("%s(), hdl %p\n", __func__, hdl);
+
+	if (hdl != NULL) {
+		OS_MutexDelete(&hdl->mutex);
+		free(hdl->index);
+		free(hdl);
+	}
+}
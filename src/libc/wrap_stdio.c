@@ -83,6 +83,9 @@ void stdout_mutex_unlock(void)
 void stdio_set_write(stdio_write_fn fn)
 {
 	stdout_mutex_lock();
+#ifdef __CONFIG_LIBC_STDIO_DEFERRED
+	stdio_deferred_flush();
+#endif
 	s_stdio_write = fn;
 	stdout_mutex_unlock();
 }
@@ -105,11 +108,581 @@ static __inline int stdio_wrap_write(char *buf, int len, int max)
 	return s_stdio_write(buf, len);
 }
 
+#ifdef __CONFIG_LIBC_STDIO_DEFERRED
+/*
+ * Deferred stdout: instead of formatting in the caller, printf stores the
+ * format pointer and its arguments as a record in a lock-free ring and a
+ * low priority task formats and writes the records later. Strings ("%s")
+ * are copied, since they rarely outlive the call, and so are formats which
+ * are not in the image (text/rodata in XIP or RAM). Records are reserved
+ * with LDREX/STREX, so any context can log without a lock, including ISRs
+ * and code running with IRQ disabled. When the ring is full the record is
+ * dropped and counted.
+ *
+ * Before the scheduler runs and in NMI or fault handlers, the pending
+ * records and the message are written synchronously as without deferring.
+ *
+ * In binary mode the records are written raw, framed by STDIO_FRAME_SYNC,
+ * and tools/stdio_decode.py formats them on the host using the image elf.
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include "kernel/os/os_thread.h"
+#include "kernel/os/os_semaphore.h"
+
+#ifndef STDIO_DEFERRED_RING_SIZE
+#define STDIO_DEFERRED_RING_SIZE	4096	/* power of 2 */
+#endif
+#define STDIO_DEFERRED_REC_MAX		256	/* record size limit, on the caller stack */
+#define STDIO_DEFERRED_STACK_SIZE	(2 * 1024)
+#define STDIO_DEFERRED_POLL_MS		1000	/* picks up records of IRQ disabled context */
+
+#define STDIO_RING_MASK			(STDIO_DEFERRED_RING_SIZE - 1)
+
+/* record header: size in bytes (multiple of 4) << 16 | flags << 8 | type,
+ * written last, a zero type marks a record still being written. */
+#define STDIO_REC_LOG			0xA5
+#define STDIO_REC_PAD			0x5A	/* fills the ring end up to the wrap */
+#define STDIO_REC_FMT_INLINE		0x01	/* format text follows the header */
+#define STDIO_REC_TRUNCATED		0x02	/* arguments did not fit */
+
+#define STDIO_FRAME_SYNC0		0xFE
+#define STDIO_FRAME_SYNC1		'L'
+
+/* argument classes, stored little endian in their own size */
+enum {
+	STDIO_ARG_NONE = 0,	/* "%%" or unknown conversion */
+	STDIO_ARG_INT,
+	STDIO_ARG_LONG,
+	STDIO_ARG_LLONG,
+	STDIO_ARG_SIZE,
+	STDIO_ARG_PTRDIFF,
+	STDIO_ARG_INTMAX,
+	STDIO_ARG_DOUBLE,
+	STDIO_ARG_LDOUBLE,
+	STDIO_ARG_PTR,
+	STDIO_ARG_STR,		/* copied, null terminated */
+	STDIO_ARG_COUNT,	/* "%n", the pointer is discarded */
+};
+
+struct stdio_spec {
+	uint8_t arg;
+	uint8_t stars;		/* int arguments for '*' width and precision */
+	int precision;		/* -1 if none, -2 if '*' */
+};
+
+static uint32_t s_log_ring[STDIO_DEFERRED_RING_SIZE / 4];
+static volatile uint32_t s_log_head;	/* reserved up to, free running */
+static volatile uint32_t s_log_tail;	/* consumed up to, free running */
+static volatile uint32_t s_log_draining;
+static volatile uint32_t s_log_dropped;
+static volatile uint8_t s_log_signalled;
+static volatile uint8_t s_log_binary;
+static volatile uint32_t s_log_state;	/* 0: not started, 1: starting, 2: running, 3: failed */
+static uint32_t s_log_dropped_shown;
+static OS_Semaphore_t s_log_sem;
+static OS_Thread_t s_log_thread;
+
+extern uint8_t __xip_start__[] __attribute__((weak));
+extern uint8_t __xip_end__[] __attribute__((weak));
+extern uint8_t __text_start__[] __attribute__((weak));
+extern uint8_t __text_end__[] __attribute__((weak));
+
+static int stdio_atomic_cas(volatile uint32_t *p, uint32_t old, uint32_t val)
+{
+	do {
+		if (__LDREXW(p) != old) {
+			__CLREX();
+			return 0;
+		}
+	} while (__STREXW(val, p));
+	return 1;
+}
+
+/* parse the conversion after '%', return the position behind it */
+static const char *stdio_parse_spec(const char *p, struct stdio_spec *spec)
+{
+	char mod = 0;
+
+	spec->arg = STDIO_ARG_NONE;
+	spec->stars = 0;
+	spec->precision = -1;
+
+	while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0')
+		p++;
+	if (*p == '*') {
+		spec->stars++;
+		p++;
+	} else {
+		while (*p >= '0' && *p <= '9')
+			p++;
+	}
+	if (*p == '.') {
+		p++;
+		if (*p == '*') {
+			spec->stars++;
+			spec->precision = -2;
+			p++;
+		} else {
+			spec->precision = 0;
+			while (*p >= '0' && *p <= '9')
+				spec->precision = spec->precision * 10 + (*p++ - '0');
+		}
+	}
+	switch (*p) {
+	case 'h':
+		p += (p[1] == 'h') ? 2 : 1;	/* promoted to int */
+		break;
+	case 'l':
+		if (p[1] == 'l') {
+			mod = 'q';
+			p++;
+		} else {
+			mod = 'l';
+		}
+		p++;
+		break;
+	case 'q':
+	case 'j':
+	case 'z':
+	case 't':
+	case 'L':
+		mod = *p++;
+		break;
+	}
+
+	switch (*p) {
+	case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+		switch (mod) {
+		case 'l': spec->arg = STDIO_ARG_LONG; break;
+		case 'q': spec->arg = STDIO_ARG_LLONG; break;
+		case 'j': spec->arg = STDIO_ARG_INTMAX; break;
+		case 'z': spec->arg = STDIO_ARG_SIZE; break;
+		case 't': spec->arg = STDIO_ARG_PTRDIFF; break;
+		default:  spec->arg = STDIO_ARG_INT; break;
+		}
+		break;
+	case 'c':
+		spec->arg = STDIO_ARG_INT;
+		break;
+	case 'e': case 'E': case 'f': case 'F':
+	case 'g': case 'G': case 'a': case 'A':
+		spec->arg = (mod == 'L') ? STDIO_ARG_LDOUBLE : STDIO_ARG_DOUBLE;
+		break;
+	case 's':
+		/* wide strings are passed on as pointers */
+		spec->arg = (mod == 'l') ? STDIO_ARG_PTR : STDIO_ARG_STR;
+		break;
+	case 'p':
+		spec->arg = STDIO_ARG_PTR;
+		break;
+	case 'n':
+		spec->arg = STDIO_ARG_COUNT;
+		break;
+	case '\0':
+		return p;
+	}
+	return p + 1;
+}
+
+static uint32_t stdio_strnlen(const char *s, uint32_t max)
+{
+	uint32_t len = 0;
+
+	while (len < max && s[len] != '\0')
+		len++;
+	return len;
+}
+
+static int stdio_fmt_in_image(const char *fmt)
+{
+	const uint8_t *p = (const uint8_t *)fmt;
+
+	return ((p >= __xip_start__ && p < __xip_end__) ||
+	        (p >= __text_start__ && p < __text_end__));
+}
+
+#define STDIO_ENCODE_ARG(type)					\
+	do {							\
+		type v_ = va_arg(ap, type);			\
+		if (pos + sizeof(type) > STDIO_DEFERRED_REC_MAX) \
+			goto truncated;				\
+		memcpy(rec + pos, &v_, sizeof(type));		\
+		pos += sizeof(type);				\
+	} while (0)
+
+/* build a record in rec (STDIO_DEFERRED_REC_MAX bytes), return its size */
+static uint32_t stdio_encode(uint8_t *rec, const char *format, va_list ap)
+{
+	uint32_t pos, len, room, flags = 0;
+	int star = -1;
+	const char *p, *s;
+	struct stdio_spec spec;
+
+	if (stdio_fmt_in_image(format)) {
+		memcpy(rec + 4, &format, sizeof(format));
+		pos = 4 + sizeof(format);
+	} else {
+		len = strlen(format);
+		if (len > STDIO_DEFERRED_REC_MAX - 4 - 1) {
+			len = STDIO_DEFERRED_REC_MAX - 4 - 1;
+			flags |= STDIO_REC_TRUNCATED;
+		}
+		memcpy(rec + 4, format, len);
+		rec[4 + len] = '\0';
+		pos = 4 + len + 1;
+		flags |= STDIO_REC_FMT_INLINE;
+		if (flags & STDIO_REC_TRUNCATED)
+			goto out;
+	}
+
+	for (p = format; *p; ) {
+		if (*p++ != '%')
+			continue;
+		p = stdio_parse_spec(p, &spec);
+		if (spec.stars) {
+			STDIO_ENCODE_ARG(int);
+			if (spec.stars > 1)
+				STDIO_ENCODE_ARG(int);
+			memcpy(&star, rec + pos - 4, 4);	/* precision if any */
+		}
+		switch (spec.arg) {
+		case STDIO_ARG_INT:	STDIO_ENCODE_ARG(int); break;
+		case STDIO_ARG_LONG:	STDIO_ENCODE_ARG(long); break;
+		case STDIO_ARG_LLONG:	STDIO_ENCODE_ARG(long long); break;
+		case STDIO_ARG_SIZE:	STDIO_ENCODE_ARG(size_t); break;
+		case STDIO_ARG_PTRDIFF:	STDIO_ENCODE_ARG(ptrdiff_t); break;
+		case STDIO_ARG_INTMAX:	STDIO_ENCODE_ARG(intmax_t); break;
+		case STDIO_ARG_DOUBLE:	STDIO_ENCODE_ARG(double); break;
+		case STDIO_ARG_LDOUBLE:	STDIO_ENCODE_ARG(long double); break;
+		case STDIO_ARG_PTR:	STDIO_ENCODE_ARG(void *); break;
+		case STDIO_ARG_COUNT:	(void)va_arg(ap, void *); break;
+		case STDIO_ARG_STR:
+			s = va_arg(ap, const char *);
+			if (s == NULL)
+				s = "(null)";
+			if (pos >= STDIO_DEFERRED_REC_MAX)
+				goto truncated;
+			room = STDIO_DEFERRED_REC_MAX - 1 - pos;
+			len = room;
+			if (spec.precision == -2 && star >= 0 && (uint32_t)star < len)
+				len = star;
+			else if (spec.precision >= 0 && (uint32_t)spec.precision < len)
+				len = spec.precision;
+			len = stdio_strnlen(s, len);
+			memcpy(rec + pos, s, len);
+			rec[pos + len] = '\0';
+			pos += len + 1;
+			if (len == room && s[len] != '\0')
+				flags |= STDIO_REC_TRUNCATED;
+			break;
+		default:
+			break;
+		}
+	}
+	goto out;
+
+truncated:
+	flags |= STDIO_REC_TRUNCATED;
+out:
+	pos = (pos + 3) & ~3U;
+	*(uint32_t *)rec = (pos << 16) | (flags << 8);	/* type set on commit */
+	return pos;
+}
+
+#undef STDIO_ENCODE_ARG
+
+/* reserve size bytes of contiguous ring space, NULL if full */
+static uint32_t *stdio_ring_reserve(uint32_t size)
+{
+	uint32_t head, off, pad;
+
+	do {
+		head = __LDREXW(&s_log_head);
+		off = head & STDIO_RING_MASK;
+		pad = (off + size > STDIO_DEFERRED_RING_SIZE) ?
+		      STDIO_DEFERRED_RING_SIZE - off : 0;
+		if (head + pad + size - s_log_tail > STDIO_DEFERRED_RING_SIZE) {
+			__CLREX();
+			return NULL;
+		}
+	} while (__STREXW(head + pad + size, &s_log_head));
+
+	if (pad) {
+		s_log_ring[off / 4] = (pad << 16) | STDIO_REC_PAD;
+		off = 0;
+	}
+	return &s_log_ring[off / 4];
+}
+
+#define STDIO_REPLAY_ARG(type)						\
+	do {								\
+		type v_;						\
+		if (arg + sizeof(type) > end)				\
+			goto truncated;					\
+		memcpy(&v_, arg, sizeof(type));				\
+		arg += sizeof(type);					\
+		if (spec.stars == 0)					\
+			snprintf(out + len, size - len, conv, v_);	\
+		else if (spec.stars == 1)				\
+			snprintf(out + len, size - len, conv, star[0], v_); \
+		else							\
+			snprintf(out + len, size - len, conv, star[0], star[1], v_); \
+	} while (0)
+
+/* format a record into out, return the length */
+static int stdio_replay(char *out, int size, const uint8_t *rec, uint32_t rec_size)
+{
+	const uint8_t *end = rec + rec_size;
+	const uint8_t *arg;
+	const char *fmt, *p, *q;
+	char conv[32];
+	int star[2] = { 0, 0 };
+	int len = 0, i;
+	struct stdio_spec spec;
+
+	if (rec[1] & STDIO_REC_FMT_INLINE) {
+		fmt = (const char *)rec + 4;
+		arg = (const uint8_t *)fmt + strlen(fmt) + 1;
+	} else {
+		memcpy(&fmt, rec + 4, sizeof(fmt));
+		arg = rec + 4 + sizeof(fmt);
+	}
+
+	for (p = fmt; *p && len < size - 1; ) {
+		if (*p != '%') {
+			out[len++] = *p++;
+			continue;
+		}
+		q = p;
+		p = stdio_parse_spec(p + 1, &spec);
+		if (spec.arg == STDIO_ARG_NONE || p - q >= (int)sizeof(conv)) {
+			if (p - q == 2 && q[1] == '%') {
+				out[len++] = '%';
+			} else {
+				while (q < p && len < size - 1)
+					out[len++] = *q++;
+			}
+			continue;
+		}
+		memcpy(conv, q, p - q);
+		conv[p - q] = '\0';
+		for (i = 0; i < spec.stars; i++) {
+			if (arg + sizeof(int) > end)
+				goto truncated;
+			memcpy(&star[i], arg, sizeof(int));
+			arg += sizeof(int);
+		}
+		switch (spec.arg) {
+		case STDIO_ARG_INT:	STDIO_REPLAY_ARG(int); break;
+		case STDIO_ARG_LONG:	STDIO_REPLAY_ARG(long); break;
+		case STDIO_ARG_LLONG:	STDIO_REPLAY_ARG(long long); break;
+		case STDIO_ARG_SIZE:	STDIO_REPLAY_ARG(size_t); break;
+		case STDIO_ARG_PTRDIFF:	STDIO_REPLAY_ARG(ptrdiff_t); break;
+		case STDIO_ARG_INTMAX:	STDIO_REPLAY_ARG(intmax_t); break;
+		case STDIO_ARG_DOUBLE:	STDIO_REPLAY_ARG(double); break;
+		case STDIO_ARG_LDOUBLE:	STDIO_REPLAY_ARG(long double); break;
+		case STDIO_ARG_PTR:	STDIO_REPLAY_ARG(void *); break;
+		case STDIO_ARG_COUNT:	continue;
+		case STDIO_ARG_STR:
+			if (arg >= end)
+				goto truncated;
+			if (spec.stars == 0)
+				snprintf(out + len, size - len, conv, (const char *)arg);
+			else if (spec.stars == 1)
+				snprintf(out + len, size - len, conv, star[0], (const char *)arg);
+			else
+				snprintf(out + len, size - len, conv, star[0], star[1], (const char *)arg);
+			arg += stdio_strnlen((const char *)arg, end - arg) + 1;
+			break;
+		}
+		/* the return value is unreliable without __CONFIG_LIBC_PRINTF_FLOAT */
+		len += strlen(out + len);
+	}
+	out[len] = '\0';
+	return len;
+
+truncated:
+	out[len] = '\0';
+	return len;
+}
+
+#undef STDIO_REPLAY_ARG
+
+/*
+ * Write out the committed records, up to the first one still being written.
+ * Only one drain runs at a time: a fault that interrupts a drain leaves the
+ * records to it rather than sharing the ring tail. s_stdout_buf is used under
+ * the stdout mutex like any other printf.
+ */
+static void stdio_deferred_drain(void)
+{
+	uint32_t tail, hdr, rec_size, dropped;
+	uint32_t *rec;
+	int len;
+
+	if (!stdio_atomic_cas(&s_log_draining, 0, 1))
+		return;
+	stdout_mutex_lock();
+
+	for (tail = s_log_tail; tail != s_log_head; tail += rec_size) {
+		rec = &s_log_ring[(tail & STDIO_RING_MASK) / 4];
+		hdr = rec[0];
+		if ((hdr & 0xFF) == 0)
+			break;
+		__DMB();
+		rec_size = hdr >> 16;
+		if ((hdr & 0xFF) == STDIO_REC_LOG && s_stdio_write != NULL) {
+			if (s_log_binary) {
+				s_stdout_buf[0] = STDIO_FRAME_SYNC0;
+				s_stdout_buf[1] = STDIO_FRAME_SYNC1;
+				memcpy(s_stdout_buf + 2, rec, rec_size);
+				s_stdio_write(s_stdout_buf, rec_size + 2);
+			} else {
+				len = stdio_replay(s_stdout_buf, WRAP_STDOUT_BUF_SIZE,
+				                   (const uint8_t *)rec, rec_size);
+				s_stdio_write(s_stdout_buf, len);
+			}
+		}
+		memset(rec, 0, rec_size);	/* no stale headers when reused */
+		__DMB();
+		s_log_tail = tail + rec_size;
+	}
+
+	dropped = s_log_dropped;
+	if (dropped != s_log_dropped_shown && s_stdio_write != NULL) {
+		len = snprintf(s_stdout_buf, WRAP_STDOUT_BUF_SIZE,
+		               "\n[stdio] %u messages dropped\n",
+		               (unsigned int)(dropped - s_log_dropped_shown));
+		s_stdio_write(s_stdout_buf, len);
+		s_log_dropped_shown = dropped;
+	}
+
+	stdout_mutex_unlock();
+	s_log_draining = 0;
+}
+
+static void stdio_deferred_task(void *arg)
+{
+	while (1) {
+		OS_SemaphoreWait(&s_log_sem, STDIO_DEFERRED_POLL_MS);
+		s_log_signalled = 0;
+		stdio_deferred_drain();
+	}
+}
+
+static void stdio_deferred_start(void)
+{
+	if (!stdio_atomic_cas(&s_log_state, 0, 1))
+		return;
+
+	if (OS_SemaphoreCreateBinary(&s_log_sem) != OS_OK) {
+		s_log_state = 3;
+		return;
+	}
+	s_log_state = 2;	/* before the task exists, so its messages are kept */
+	if (OS_ThreadCreate(&s_log_thread, "stdio", stdio_deferred_task, NULL,
+	                    OS_THREAD_PRIO_STDIO,
+	                    STDIO_DEFERRED_STACK_SIZE) != OS_OK) {
+		s_log_state = 3;
+		OS_SemaphoreDelete(&s_log_sem);
+	}
+}
+
+/*
+ * Nothing is formatted here, so the length printf would return is not known:
+ * return the size of the stored record instead, or 0 if it was dropped.
+ */
+static int stdio_deferred_vlog(const char *format, va_list ap)
+{
+	uint32_t rec[STDIO_DEFERRED_REC_MAX / 4];
+	uint32_t size;
+	uint32_t *dst;
+
+	size = stdio_encode((uint8_t *)rec, format, ap);
+	dst = stdio_ring_reserve(size);
+	if (dst == NULL) {
+		s_log_dropped++;
+		return 0;
+	}
+	memcpy(dst + 1, rec + 1, size - 4);
+	__DMB();
+	dst[0] = rec[0] | STDIO_REC_LOG;
+
+	if (__get_PRIMASK() || __get_FAULTMASK()) {
+		return size;	/* no kernel calls, left to the poll */
+	}
+	if (s_log_state != 2) {
+		if (__get_IPSR())
+			return size;
+		stdio_deferred_start();
+		if (s_log_state != 2)
+			return size;
+	}
+	if (!s_log_signalled) {
+		s_log_signalled = 1;
+		OS_SemaphoreRelease(&s_log_sem);
+	}
+	return size;
+}
+
+static int stdio_deferred_log(const char *format, ...)
+{
+	va_list ap;
+	int len;
+
+	va_start(ap, format);
+	len = stdio_deferred_vlog(format, ap);
+	va_end(ap);
+	return len;
+}
+
+/* return 1 if the caller may defer, otherwise write out what is pending */
+static int stdio_deferred_enter(void)
+{
+	uint32_t ipsr = __get_IPSR();
+
+	/* exceptions 2 to 6: NMI, HardFault, MemManage, BusFault, UsageFault */
+	if (OS_ThreadIsSchedulerRunning() && (ipsr < 2 || ipsr > 6) &&
+	    s_log_state != 3) {
+		return 1;
+	}
+	stdio_deferred_drain();
+	return 0;
+}
+
+void stdio_deferred_flush(void)
+{
+	stdio_deferred_drain();
+}
+
+void stdio_deferred_set_binary(int enable)
+{
+	stdio_deferred_flush();
+	s_log_binary = !!enable;
+}
+
+unsigned int stdio_deferred_dropped(void)
+{
+	return s_log_dropped;
+}
+
+#endif /* __CONFIG_LIBC_STDIO_DEFERRED */
+
 int __wrap_printf(const char *format, ...)
 {
 	int len;
 	va_list ap;
 
+#ifdef __CONFIG_LIBC_STDIO_DEFERRED
+	if (stdio_deferred_enter()) {
+		va_start(ap, format);
+		len = stdio_deferred_vlog(format, ap);
+		va_end(ap);
+		return len;
+	}
+#endif
+
 	stdout_mutex_lock();
 
 	if (s_stdio_write == NULL) {
@@ -130,6 +703,11 @@ int __wrap_vprintf(const char *format, va_list ap)
 {
 	int len;
 
+#ifdef __CONFIG_LIBC_STDIO_DEFERRED
+	if (stdio_deferred_enter())
+		return stdio_deferred_vlog(format, ap);
+#endif
+
 	stdout_mutex_lock();
 
 	if (s_stdio_write == NULL) {
@@ -148,6 +726,11 @@ int __wrap_puts(const char *s)
 {
 	int len;
 
+#ifdef __CONFIG_LIBC_STDIO_DEFERRED
+	if (stdio_deferred_enter())
+		return stdio_deferred_log("%s\n", s);
+#endif
+
 	stdout_mutex_lock();
 
 	if (s_stdio_write == NULL) {
@@ -170,6 +753,15 @@ int __wrap_fprintf(FILE *stream, const char *format, ...)
 	if (stream != stdout && stream != stderr)
 		return 0;
 
+#ifdef __CONFIG_LIBC_STDIO_DEFERRED
+	if (stdio_deferred_enter()) {
+		va_start(ap, format);
+		len = stdio_deferred_vlog(format, ap);
+		va_end(ap);
+		return len;
+	}
+#endif
+
 	stdout_mutex_lock();
 
 	if (s_stdio_write == NULL) {
@@ -208,6 +800,11 @@ int __wrap_putchar(int c)
 	int len;
 	char cc;
 
+#ifdef __CONFIG_LIBC_STDIO_DEFERRED
+	if (stdio_deferred_enter())
+		return stdio_deferred_log("%c", c);
+#endif
+
 	stdout_mutex_lock();
 
 	if (s_stdio_write == NULL) {
@@ -237,6 +834,10 @@ int __wrap_fputc(int c, FILE *stream)
 
 int __wrap_fflush(FILE *stream)
 {
+#ifdef __CONFIG_LIBC_STDIO_DEFERRED
+	if (stream == stdout || stream == stderr)
+		stdio_deferred_flush();
+#endif
 	return 0;
 }
 
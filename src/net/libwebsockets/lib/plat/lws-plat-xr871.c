@@ -66,31 +66,25 @@ lws_get_random(struct lws_context *context, void *buf, int len)
 }
 
 /*
- *check the socket choked or not
+ * check the socket choked or not
+ *
+ * Writability is tracked from the service loop instead of probing the socket
+ * with select() before every write: sock_send_blocking is set when a send
+ * returns EWOULDBLOCK and cleared again when the socket is reported writable.
  */
 LWS_VISIBLE int
 lws_send_pipe_choked(struct lws *wsi)
 {
 	struct lws *wsi_eff = wsi;
-	fd_set writefds;
-	struct timeval tv = { 0, 0 };
 #if defined(LWS_WITH_HTTP2)
 	wsi_eff = lws_get_network_wsi(wsi);
 #endif
-	int n;
 
 	/* treat the fact we got a truncated send pending as if we're choked */
 	if (wsi_eff->trunc_len)
 		return 1;
 
-	FD_ZERO(&writefds);
-	FD_SET(wsi_eff->desc.sockfd, &writefds);
-
-	n = select(wsi_eff->desc.sockfd + 1, NULL, &writefds, NULL, &tv);
-	if (n < 0)
-		return 1; /* choked */
-
-	return !n; /* n = 0 = not writable = choked */
+	return (int)wsi_eff->sock_send_blocking;
 }
 
 LWS_VISIBLE int
@@ -212,6 +206,11 @@ _lws_plat_service_tsi(struct lws_context *context, int timeout_ms, int tsi)
 		}
 
 		n = select(max_fd + 1, &readfds, &writefds, &errfds, ptv);
+		if (n < 0) {
+			FD_ZERO(&readfds);
+			FD_ZERO(&writefds);
+			FD_ZERO(&errfds);
+		}
 		n = 0;
 		for (m = 0; m < pt->fds_count; m++) {
 			c = 0;
@@ -220,6 +219,11 @@ _lws_plat_service_tsi(struct lws_context *context, int timeout_ms, int tsi)
 				c = 1;
 			}
 			if (FD_ISSET(pt->fds[m].fd, &writefds)) {
+				struct lws *wsi = wsi_from_fd(context,
+							      pt->fds[m].fd);
+
+				if (wsi)
+					wsi->sock_send_blocking = 0;
 				pt->fds[m].revents |= LWS_POLLOUT;
 				c = 1;
 			}
@@ -359,21 +363,89 @@ lws_plat_drop_app_privileges(struct lws_context_creation_info *info)
 }
 
 
+/*
+ * lwIP has no pipe(), so the event pipe is a nonblocking UDP socket bound to
+ * the loopback interface and connected to itself. lws_cancel_service() sends
+ * one byte to it, which makes the select() in the service loop return at once
+ * instead of waiting for the poll timeout.
+ */
+#define LWS_XR_EVENT_PIPE_RCVBUF	1	/* coalesce pending wakeups */
+
 int
 lws_plat_pipe_create(struct lws *wsi)
 {
-	return 1;
+	struct lws_context_per_thread *pt = &wsi->context->pt[(int)wsi->tsi];
+	struct sockaddr_in sin;
+	socklen_t len = sizeof(sin);
+	int fd, val;
+
+	pt->dummy_pipe_fds[0] = pt->dummy_pipe_fds[1] = -1;
+
+	fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (fd < 0) {
+		lwsl_err("%s: socket failed\n", __func__);
+		return 1;
+	}
+
+	memset(&sin, 0, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	sin.sin_port = 0;
+
+	if (bind(fd, (struct sockaddr *)&sin, sizeof(sin)) < 0 ||
+	    getsockname(fd, (struct sockaddr *)&sin, &len) < 0 ||
+	    connect(fd, (struct sockaddr *)&sin, sizeof(sin)) < 0) {
+		lwsl_err("%s: loopback setup failed\n", __func__);
+		closesocket(fd);
+		return 1;
+	}
+
+	/*
+	 * a single queued datagram is enough to wake the loop, further
+	 * signals before it is drained are dropped by lwIP
+	 */
+	val = LWS_XR_EVENT_PIPE_RCVBUF;
+	setsockopt(fd, SOL_SOCKET, SO_RCVBUF, (const void *)&val, sizeof(val));
+
+	val = 1;
+	if (ioctlsocket(fd, FIONBIO, (void *)&val) != 0) {
+		lwsl_err("%s: O_NONBLOCK set failed\n", __func__);
+		closesocket(fd);
+		return 1;
+	}
+
+	pt->dummy_pipe_fds[0] = pt->dummy_pipe_fds[1] = fd;
+
+	return 0;
 }
 
 int
 lws_plat_pipe_signal(struct lws *wsi)
 {
-	return 1;
+	struct lws_context_per_thread *pt = &wsi->context->pt[(int)wsi->tsi];
+	char buf = 0;
+	int n;
+
+	if (pt->dummy_pipe_fds[1] < 0)
+		return 1;
+
+	n = send(pt->dummy_pipe_fds[1], &buf, 1, 0);
+
+	lwsl_debug("%s: fd %d %d\n", __func__, pt->dummy_pipe_fds[1], n);
+
+	return n != 1;
 }
 
 void
 lws_plat_pipe_close(struct lws *wsi)
 {
+	struct lws_context_per_thread *pt = &wsi->context->pt[(int)wsi->tsi];
+
+	/* both ends share the same socket */
+	if (pt->dummy_pipe_fds[0] >= 0)
+		closesocket(pt->dummy_pipe_fds[0]);
+
+	pt->dummy_pipe_fds[0] = pt->dummy_pipe_fds[1] = -1;
 }
 
 LWS_VISIBLE int
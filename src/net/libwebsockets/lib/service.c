@@ -1236,9 +1236,9 @@ lws_service_fd_tsi(struct lws_context *context, struct lws_pollfd *pollfd,
 		goto close_and_handled;
 	}
 
-#ifdef _WIN32
+#if defined(_WIN32) || defined(LWS_WITH_XRADIO)
 	if (pollfd->revents & LWS_POLLOUT)
-		wsi->sock_send_blocking = FALSE;
+		wsi->sock_send_blocking = 0;
 #endif
 
 #endif
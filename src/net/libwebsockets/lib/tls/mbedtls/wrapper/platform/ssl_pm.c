@@ -25,6 +25,11 @@
 #include "mbedtls/ctr_drbg.h"
 #include "mbedtls/error.h"
 #include "mbedtls/certs.h"
+#if (__CONFIG_MBEDTLS_VER == 0x02100000)
+#include "mbedtls/session_store.h"
+#include "mbedtls/trust_store.h"
+#include "lwip/sockets.h"
+#endif
 #else
 #include "mbedtls/platform.h"
 #include "mbedtls/net_sockets.h"
@@ -60,6 +65,10 @@ struct x509_pm
     mbedtls_x509_crt *x509_crt;
 
     mbedtls_x509_crt *ex_crt;
+
+#if defined(MBEDTLS_TRUST_STORE)
+    mbedtls_trust_store *trust; /* x509_crt is its chain, shared */
+#endif
 };
 
 struct pkey_pm
@@ -67,6 +76,10 @@ struct pkey_pm
     mbedtls_pk_context *pkey;
 
     mbedtls_pk_context *ex_pkey;
+
+#if defined(MBEDTLS_TRUST_STORE)
+    mbedtls_trust_store *trust; /* pkey is its key, shared */
+#endif
 };
 
 unsigned int max_content_len;
@@ -261,6 +274,11 @@ static int ssl_pm_reload_crt(SSL *ssl)
         ret = -1;
     }
 
+#if defined(MBEDTLS_TRUST_STORE)
+    /* the certificates and key may be shared with other connections */
+    mbedtls_ssl_conf_cert_lock(&ssl_pm->conf, mbedtls_trust_store_use, NULL);
+#endif
+
     return ret;
 }
 
@@ -284,6 +302,24 @@ static int mbedtls_handshake( mbedtls_ssl_context *ssl )
     return ret;
 }
 
+#ifdef MBEDTLS_SESSION_STORE
+/*
+ * Server port of a client connection, used with the host name as the key of
+ * the shared session store.
+ */
+static int ssl_pm_peer_port(struct ssl_pm *ssl_pm)
+{
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+
+    if (getpeername(ssl_pm->fd.fd, (struct sockaddr *)&addr, &len) != 0 ||
+        addr.sin_family != AF_INET)
+        return 0;
+
+    return ntohs(addr.sin_port);
+}
+#endif
+
 int ssl_pm_handshake(SSL *ssl)
 {
     int ret;
@@ -294,6 +330,9 @@ int ssl_pm_handshake(SSL *ssl)
         return 0;
 
     if (ssl_pm->ssl.state != MBEDTLS_SSL_HANDSHAKE_OVER) {
+#ifdef MBEDTLS_SESSION_STORE
+	    mbedtls_session_store_resume_ssl(&ssl_pm->ssl, ssl_pm_peer_port(ssl_pm));
+#endif
 	    ssl_speed_up_enter();
 
 	   /* mbedtls return codes
@@ -302,6 +341,10 @@ int ssl_pm_handshake(SSL *ssl)
 	    */
 	    ret = mbedtls_handshake(&ssl_pm->ssl);
 	    ssl_speed_up_exit();
+#ifdef MBEDTLS_SESSION_STORE
+	    if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE)
+		    mbedtls_session_store_update_ssl(&ssl_pm->ssl, ssl_pm_peer_port(ssl_pm), ret);
+#endif
     } else
 	    ret = 0;
 
@@ -600,6 +643,14 @@ void x509_pm_free(X509 *x)
 {
     struct x509_pm *x509_pm = (struct x509_pm *)x->x509_pm;
 
+#if defined(MBEDTLS_TRUST_STORE)
+    if (x509_pm->trust) {
+        mbedtls_trust_store_put(x509_pm->trust);
+        x509_pm->trust = NULL;
+        x509_pm->x509_crt = NULL;
+    }
+#endif
+
     if (x509_pm->x509_crt) {
         mbedtls_x509_crt_free(x509_pm->x509_crt);
 
@@ -611,11 +662,67 @@ void x509_pm_free(X509 *x)
     x->x509_pm = NULL;
 }
 
+#if defined(MBEDTLS_TRUST_STORE)
+/*
+ * Get the store of a certificate (x509) or key buffer. PEM is copied to be
+ * null terminated, the store keeps a parsed copy.
+ */
+static mbedtls_trust_store *ssl_pm_trust_get(const unsigned char *buffer, int len, int x509)
+{
+    mbedtls_trust_store *trust;
+    mbedtls_trust_param param;
+    unsigned char *load_buf = NULL;
+
+    if (!x509 || buffer[0] != 0x30) {
+        load_buf = ssl_mem_malloc(len + 1);
+        if (!load_buf) {
+            SSL_DEBUG(SSL_PLATFORM_ERROR_LEVEL, "no enough memory > (load_buf)");
+            return NULL;
+        }
+        ssl_memcpy(load_buf, buffer, len);
+        load_buf[len] = '\0';
+        buffer = load_buf;
+        len++;
+    }
+
+    memset(&param, 0, sizeof(param));
+    if (x509) {
+        param.ca[0].buf = buffer;
+        param.ca[0].len = len;
+    } else {
+        param.key = buffer;
+        param.key_len = len;
+    }
+    trust = mbedtls_trust_store_get(&param);
+    if (load_buf)
+        ssl_mem_free(load_buf);
+    return trust;
+}
+#endif
+
 int x509_pm_load(X509 *x, const unsigned char *buffer, int len)
 {
+    struct x509_pm *x509_pm = (struct x509_pm *)x->x509_pm;
+
+#if defined(MBEDTLS_TRUST_STORE)
+    mbedtls_trust_store *trust = ssl_pm_trust_get(buffer, len, 1);
+
+    if (!trust) {
+        printf("mbedtls_trust_store_get failed\n");
+        return -1;
+    }
+    if (x509_pm->trust)
+        mbedtls_trust_store_put(x509_pm->trust);
+    else if (x509_pm->x509_crt) {
+        mbedtls_x509_crt_free(x509_pm->x509_crt);
+        ssl_mem_free(x509_pm->x509_crt);
+    }
+    x509_pm->trust = trust;
+    x509_pm->x509_crt = &trust->ca;
+    return 0;
+#else
     int ret;
     unsigned char *load_buf;
-    struct x509_pm *x509_pm = (struct x509_pm *)x->x509_pm;
 
 	if (x509_pm->x509_crt)
         mbedtls_x509_crt_free(x509_pm->x509_crt);
@@ -660,6 +767,7 @@ failed:
     x509_pm->x509_crt = NULL;
 no_mem:
     return -1;
+#endif
 }
 
 int pkey_pm_new(EVP_PKEY *pk, EVP_PKEY *m_pkey)
@@ -685,6 +793,14 @@ void pkey_pm_free(EVP_PKEY *pk)
 {
     struct pkey_pm *pkey_pm = (struct pkey_pm *)pk->pkey_pm;
 
+#if defined(MBEDTLS_TRUST_STORE)
+    if (pkey_pm->trust) {
+        mbedtls_trust_store_put(pkey_pm->trust);
+        pkey_pm->trust = NULL;
+        pkey_pm->pkey = NULL;
+    }
+#endif
+
     if (pkey_pm->pkey) {
         mbedtls_pk_free(pkey_pm->pkey);
 
@@ -698,9 +814,27 @@ void pkey_pm_free(EVP_PKEY *pk)
 
 int pkey_pm_load(EVP_PKEY *pk, const unsigned char *buffer, int len)
 {
+    struct pkey_pm *pkey_pm = (struct pkey_pm *)pk->pkey_pm;
+
+#if defined(MBEDTLS_TRUST_STORE)
+    mbedtls_trust_store *trust = ssl_pm_trust_get(buffer, len, 0);
+
+    if (!trust) {
+        SSL_DEBUG(SSL_PLATFORM_ERROR_LEVEL, "mbedtls_trust_store_get failed");
+        return -1;
+    }
+    if (pkey_pm->trust)
+        mbedtls_trust_store_put(pkey_pm->trust);
+    else if (pkey_pm->pkey) {
+        mbedtls_pk_free(pkey_pm->pkey);
+        ssl_mem_free(pkey_pm->pkey);
+    }
+    pkey_pm->trust = trust;
+    pkey_pm->pkey = &trust->key;
+    return 0;
+#else
     int ret;
     unsigned char *load_buf;
-    struct pkey_pm *pkey_pm = (struct pkey_pm *)pk->pkey_pm;
 
     if (pkey_pm->pkey)
         mbedtls_pk_free(pkey_pm->pkey);
@@ -740,6 +874,7 @@ failed:
     pkey_pm->pkey = NULL;
 no_mem:
     return -1;
+#endif
 }
 
 
@@ -144,14 +144,31 @@ int mbedtls_aes_crypt_ecb( mbedtls_aes_context *ctx,
                     const unsigned char input[16],
                     unsigned char output[16] )
 {
+    return( mbedtls_aes_crypt_ecb_blocks( ctx, mode, 16, input, output ) );
+}
+
+/*
+ * AES-ECB encryption/decryption of several blocks in one CE request
+ */
+int mbedtls_aes_crypt_ecb_blocks( mbedtls_aes_context *ctx,
+                    int mode,
+                    size_t length,
+                    const unsigned char *input,
+                    unsigned char *output )
+{
+	HAL_Status status;
+
+	if( length == 0 || ( length % 16 ) )
+		return( MBEDTLS_ERR_AES_INVALID_INPUT_LENGTH );
+
 	ctx->aes.mode = CE_CTL_CRYPT_MODE_ECB;
 
 	if (mode == MBEDTLS_AES_ENCRYPT)
-		HAL_AES_Encrypt(&ctx->aes, (uint8_t*)input, (uint8_t*)output, 16);
+		status = HAL_AES_Encrypt(&ctx->aes, (uint8_t*)input, output, length);
 	else
-		HAL_AES_Decrypt(&ctx->aes, (uint8_t*)input, (uint8_t*)output, 16);
+		status = HAL_AES_Decrypt(&ctx->aes, (uint8_t*)input, output, length);
 
-	return( 0 );
+	return( status == HAL_OK ? 0 : MBEDTLS_ERR_AES_HW_ACCEL_FAILED );
 }
 
 #if defined(MBEDTLS_CIPHER_MODE_CBC)
@@ -165,17 +182,23 @@ int mbedtls_aes_crypt_cbc( mbedtls_aes_context *ctx,
                     const unsigned char *input,
                     unsigned char *output )
 {
-    if( length % 16 )
-        return( MBEDTLS_ERR_AES_INVALID_INPUT_LENGTH );
+	HAL_Status status;
+
+	if( length % 16 )
+		return( MBEDTLS_ERR_AES_INVALID_INPUT_LENGTH );
+	if( length == 0 )
+		return( 0 );
 
 	ctx->aes.mode = CE_CTL_CRYPT_MODE_CBC;
 	ctx->aes.src = CE_CTL_KEYSOURCE_INPUT;
 	memcpy(ctx->aes.iv, iv, 16);
 
 	if (mode == MBEDTLS_AES_ENCRYPT)
-		HAL_AES_Encrypt(&ctx->aes, (uint8_t*)input, (uint8_t*)output, length);
+		status = HAL_AES_Encrypt(&ctx->aes, (uint8_t*)input, (uint8_t*)output, length);
 	else
-		HAL_AES_Decrypt(&ctx->aes, (uint8_t*)input, (uint8_t*)output, length);
+		status = HAL_AES_Decrypt(&ctx->aes, (uint8_t*)input, (uint8_t*)output, length);
+	if (status != HAL_OK)
+		return( MBEDTLS_ERR_AES_HW_ACCEL_FAILED );
 	memcpy(iv, ctx->aes.iv, 16);
 
 	return( 0 );
@@ -265,6 +288,9 @@ int mbedtls_aes_crypt_cfb8( mbedtls_aes_context *ctx,
 #if defined(MBEDTLS_CIPHER_MODE_CTR)
 /*
  * AES-CTR buffer encryption/decryption
+ *
+ * The CE counter mode is unusable (see hal_crypto.h), so whole blocks are
+ * handled by encrypting a run of counter blocks in one ECB request.
  */
 int mbedtls_aes_crypt_ctr( mbedtls_aes_context *ctx,
                        size_t length,
@@ -274,13 +300,57 @@ int mbedtls_aes_crypt_ctr( mbedtls_aes_context *ctx,
                        const unsigned char *input,
                        unsigned char *output )
 {
-    int c, i;
+    int c, i, ret;
     size_t n = *nc_off;
+    size_t j, blocks;
+    unsigned char ks[MBEDTLS_AES_ALT_CTR_BLOCKS * 16];
+
+    if( n > 0x0F )
+        return( MBEDTLS_ERR_AES_BAD_INPUT_DATA );
+
+    /* use up the current stream block first */
+    while( n != 0 && length > 0 )
+    {
+        *output++ = (unsigned char)( *input++ ^ stream_block[n] );
+        n = ( n + 1 ) & 0x0F;
+        length--;
+    }
+
+    while( length >= 16 )
+    {
+        blocks = length / 16;
+        if( blocks > MBEDTLS_AES_ALT_CTR_BLOCKS )
+            blocks = MBEDTLS_AES_ALT_CTR_BLOCKS;
+
+        for( j = 0; j < blocks; j++ )
+        {
+            memcpy( ks + j * 16, nonce_counter, 16 );
+            for( i = 16; i > 0; i-- )
+                if( ++nonce_counter[i - 1] != 0 )
+                    break;
+        }
+
+        if( ( ret = mbedtls_aes_crypt_ecb_blocks( ctx, MBEDTLS_AES_ENCRYPT,
+                                                  blocks * 16, ks, ks ) ) != 0 )
+        {
+            mbedtls_zeroize( ks, sizeof( ks ) );
+            return( ret );
+        }
+
+        for( j = 0; j < blocks * 16; j++ )
+            output[j] = (unsigned char)( input[j] ^ ks[j] );
+
+        input  += blocks * 16;
+        output += blocks * 16;
+        length -= blocks * 16;
+    }
+    mbedtls_zeroize( ks, sizeof( ks ) );
 
     while( length-- )
     {
         if( n == 0 ) {
-            mbedtls_aes_crypt_ecb( ctx, MBEDTLS_AES_ENCRYPT, nonce_counter, stream_block );
+            if( ( ret = mbedtls_aes_crypt_ecb( ctx, MBEDTLS_AES_ENCRYPT, nonce_counter, stream_block ) ) != 0 )
+                return( ret );
 
             for( i = 16; i > 0; i-- )
                 if( ++nonce_counter[i - 1] != 0 )
@@ -3239,12 +3239,15 @@ curve_matching_done:
          * after the call to ssl_prepare_server_key_exchange.
          * ssl_write_server_key_exchange also takes care of incrementing
          * ssl->out_msglen. */
-        if( ( ret = mbedtls_pk_sign( mbedtls_ssl_own_key( ssl ),
-                                     md_alg, hash, hashlen,
-                                     ssl->out_msg + ssl->out_msglen + 2,
-                                     signature_len,
-                                     ssl->conf->f_rng,
-                                     ssl->conf->p_rng ) ) != 0 )
+        mbedtls_ssl_cert_lock( ssl, 1 );
+        ret = mbedtls_pk_sign( mbedtls_ssl_own_key( ssl ),
+                               md_alg, hash, hashlen,
+                               ssl->out_msg + ssl->out_msglen + 2,
+                               signature_len,
+                               ssl->conf->f_rng,
+                               ssl->conf->p_rng );
+        mbedtls_ssl_cert_lock( ssl, 0 );
+        if( ret != 0 )
         {
             MBEDTLS_SSL_DEBUG_RET( 1, "mbedtls_pk_sign", ret );
             return( ret );
@@ -3540,9 +3543,11 @@ static int ssl_decrypt_encrypted_pms( mbedtls_ssl_context *ssl,
         return( MBEDTLS_ERR_SSL_PRIVATE_KEY_REQUIRED );
     }
 
+    mbedtls_ssl_cert_lock( ssl, 1 );
     ret = mbedtls_pk_decrypt( private_key, p, len,
                               peer_pms, peer_pmslen, peer_pmssize,
                               ssl->conf->f_rng, ssl->conf->p_rng );
+    mbedtls_ssl_cert_lock( ssl, 0 );
     return( ret );
 }
 
@@ -2513,6 +2513,270 @@ static int ssl_resend_hello_request( mbedtls_ssl_context *ssl )
 #endif
 #endif /* MBEDTLS_SSL_SRV_C && MBEDTLS_SSL_RENEGOTIATION */
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+/*
+ * Variable length I/O buffers: MBEDTLS_SSL_VARIABLE_BUFFER_MIN_LEN bytes of
+ * content between records, the full size during handshakes, and the size of
+ * the largest recent application record otherwise.
+ */
+#define SSL_IN_BUFFER_LEN_FOR( content )                                \
+    ( MBEDTLS_SSL_IN_BUFFER_LEN - MBEDTLS_SSL_IN_CONTENT_LEN + ( content ) )
+#define SSL_OUT_BUFFER_LEN_FOR( content )                               \
+    ( MBEDTLS_SSL_OUT_BUFFER_LEN - MBEDTLS_SSL_OUT_CONTENT_LEN + ( content ) )
+
+#define SSL_IN_BUFFER_MIN_LEN                                           \
+    SSL_IN_BUFFER_LEN_FOR( MBEDTLS_SSL_VARIABLE_BUFFER_MIN_LEN )
+#define SSL_OUT_BUFFER_MIN_LEN                                          \
+    SSL_OUT_BUFFER_LEN_FOR( MBEDTLS_SSL_VARIABLE_BUFFER_MIN_LEN )
+
+/* Datagrams are read whole, DTLS keeps full size buffers */
+static int ssl_buffers_variable( const mbedtls_ssl_context *ssl )
+{
+#if defined(MBEDTLS_SSL_PROTO_DTLS)
+    if( ssl->conf->transport == MBEDTLS_SSL_TRANSPORT_DATAGRAM )
+        return( 0 );
+#else
+    ((void) ssl);
+#endif
+    return( 1 );
+}
+
+/* Grow in steps, so that slightly varying record sizes share a buffer */
+#define SSL_BUFFER_GROW_STEP    1024
+
+static size_t ssl_buffer_grow_len( size_t needed, size_t max_len )
+{
+    size_t len = ( needed + SSL_BUFFER_GROW_STEP - 1 ) &
+                 ~( (size_t) SSL_BUFFER_GROW_STEP - 1 );
+
+    return( len < max_len ? len : max_len );
+}
+
+/*
+ * Largest input buffer: the peer must not exceed a negotiated
+ * max_fragment_length once the handshake is over.
+ */
+static size_t ssl_in_buf_max_len( const mbedtls_ssl_context *ssl )
+{
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+    if( ssl_buffers_variable( ssl ) &&
+        ssl->state == MBEDTLS_SSL_HANDSHAKE_OVER && ssl->session != NULL &&
+        ssl->session->mfl_code != MBEDTLS_SSL_MAX_FRAG_LEN_NONE )
+    {
+        return( SSL_IN_BUFFER_LEN_FOR(
+                    ssl_mfl_code_to_length( ssl->session->mfl_code ) ) );
+    }
+#endif
+    return( MBEDTLS_SSL_IN_BUFFER_LEN );
+}
+
+/*
+ * Move the input buffer to one of len bytes, keeping the record being read
+ * and the current message. Fails if they do not fit.
+ */
+static int ssl_resize_in_buf( mbedtls_ssl_context *ssl, size_t len )
+{
+    unsigned char *buf;
+    size_t used;
+
+    used = (size_t)( ssl->in_hdr - ssl->in_buf ) + ssl->in_left;
+    if( (size_t)( ssl->in_msg - ssl->in_buf ) + ssl->in_msglen > used )
+        used = (size_t)( ssl->in_msg - ssl->in_buf ) + ssl->in_msglen;
+    /* in_msglen may announce a record still to be fetched */
+    if( used > ssl->in_buf_len )
+        used = ssl->in_buf_len;
+    if( used > len )
+        return( MBEDTLS_ERR_SSL_BAD_INPUT_DATA );
+
+    if( ( buf = mbedtls_calloc( 1, len ) ) == NULL )
+    {
+        MBEDTLS_SSL_DEBUG_MSG( 1, ( "alloc(%d bytes) failed", (int) len ) );
+        return( MBEDTLS_ERR_SSL_ALLOC_FAILED );
+    }
+    memcpy( buf, ssl->in_buf, used );
+
+    ssl->in_ctr = buf + ( ssl->in_ctr - ssl->in_buf );
+    ssl->in_hdr = buf + ( ssl->in_hdr - ssl->in_buf );
+    ssl->in_len = buf + ( ssl->in_len - ssl->in_buf );
+    ssl->in_iv  = buf + ( ssl->in_iv  - ssl->in_buf );
+    ssl->in_msg = buf + ( ssl->in_msg - ssl->in_buf );
+    if( ssl->in_offt != NULL )
+        ssl->in_offt = buf + ( ssl->in_offt - ssl->in_buf );
+
+    mbedtls_platform_zeroize( ssl->in_buf, ssl->in_buf_len );
+    mbedtls_free( ssl->in_buf );
+    ssl->in_buf = buf;
+    ssl->in_buf_len = len;
+
+    MBEDTLS_SSL_DEBUG_MSG( 3, ( "input buffer resized to %d bytes", (int) len ) );
+
+    return( 0 );
+}
+
+/*
+ * Move the output buffer to one of len bytes. Only done between records,
+ * when no data is pending.
+ */
+static int ssl_resize_out_buf( mbedtls_ssl_context *ssl, size_t len )
+{
+    unsigned char *buf;
+    size_t used = (size_t)( ssl->out_msg - ssl->out_buf );
+
+    if( ssl->out_left != 0 || used > len )
+        return( MBEDTLS_ERR_SSL_BAD_INPUT_DATA );
+
+    if( ( buf = mbedtls_calloc( 1, len ) ) == NULL )
+    {
+        MBEDTLS_SSL_DEBUG_MSG( 1, ( "alloc(%d bytes) failed", (int) len ) );
+        return( MBEDTLS_ERR_SSL_ALLOC_FAILED );
+    }
+    memcpy( buf, ssl->out_buf, used );
+
+    ssl->out_ctr = buf + ( ssl->out_ctr - ssl->out_buf );
+    ssl->out_hdr = buf + ( ssl->out_hdr - ssl->out_buf );
+    ssl->out_len = buf + ( ssl->out_len - ssl->out_buf );
+    ssl->out_iv  = buf + ( ssl->out_iv  - ssl->out_buf );
+    ssl->out_msg = buf + ( ssl->out_msg - ssl->out_buf );
+
+    mbedtls_platform_zeroize( ssl->out_buf, ssl->out_buf_len );
+    mbedtls_free( ssl->out_buf );
+    ssl->out_buf = buf;
+    ssl->out_buf_len = len;
+
+    MBEDTLS_SSL_DEBUG_MSG( 3, ( "output buffer resized to %d bytes", (int) len ) );
+
+    return( 0 );
+}
+
+static void ssl_buffers_touch( mbedtls_ssl_context *ssl )
+{
+#if defined(MBEDTLS_HAVE_TIME)
+    ssl->buf_stamp = mbedtls_time( NULL );
+#else
+    ((void) ssl);
+#endif
+}
+
+/*
+ * Make room for nb_want bytes from the record header on
+ */
+static int ssl_in_buf_reserve( mbedtls_ssl_context *ssl, size_t nb_want )
+{
+    size_t needed = (size_t)( ssl->in_hdr - ssl->in_buf ) + nb_want;
+    size_t max_len = ssl_in_buf_max_len( ssl );
+
+    if( needed > max_len )
+    {
+        MBEDTLS_SSL_DEBUG_MSG( 1, ( "requesting more data than fits" ) );
+        return( MBEDTLS_ERR_SSL_BAD_INPUT_DATA );
+    }
+
+    if( needed > SSL_IN_BUFFER_MIN_LEN )
+        ssl_buffers_touch( ssl );
+
+#if defined(MBEDTLS_CIPHER_MODE_CBC) &&                                  \
+    ( defined(MBEDTLS_AES_C) || defined(MBEDTLS_CAMELLIA_C) || defined(MBEDTLS_ARIA_C) )
+    /*
+     * The constant-time padding check of CBC records reads up to 256 bytes
+     * past the record. The full buffer has room for it, see
+     * MBEDTLS_SSL_PADDING_ADD, a shrunk one must keep it too.
+     */
+    if( ssl->transform_in != NULL &&
+        mbedtls_cipher_get_cipher_mode( &ssl->transform_in->cipher_ctx_dec ) ==
+            MBEDTLS_MODE_CBC )
+    {
+        needed += 256;
+        if( needed > MBEDTLS_SSL_IN_BUFFER_LEN )
+            needed = MBEDTLS_SSL_IN_BUFFER_LEN;
+        max_len = MBEDTLS_SSL_IN_BUFFER_LEN;
+    }
+#endif
+
+    if( needed <= ssl->in_buf_len )
+        return( 0 );
+
+    return( ssl_resize_in_buf( ssl, ssl_buffer_grow_len( needed, max_len ) ) );
+}
+
+/*
+ * Make room for an outgoing record of len bytes of content
+ */
+static int ssl_out_buf_reserve( mbedtls_ssl_context *ssl, size_t len )
+{
+    size_t needed = SSL_OUT_BUFFER_LEN_FOR( len );
+
+    if( needed > SSL_OUT_BUFFER_MIN_LEN )
+        ssl_buffers_touch( ssl );
+
+    if( needed <= ssl->out_buf_len )
+        return( 0 );
+
+    return( ssl_resize_out_buf( ssl,
+                ssl_buffer_grow_len( needed, MBEDTLS_SSL_OUT_BUFFER_LEN ) ) );
+}
+
+/*
+ * Handshake messages are written and parsed in place, with the full
+ * buffer sizes as bounds.
+ */
+static int ssl_buffers_grow_handshake( mbedtls_ssl_context *ssl )
+{
+    int ret;
+
+    if( ssl->in_buf_len < MBEDTLS_SSL_IN_BUFFER_LEN &&
+        ( ret = ssl_resize_in_buf( ssl, MBEDTLS_SSL_IN_BUFFER_LEN ) ) != 0 )
+    {
+        return( ret );
+    }
+
+    if( ssl->out_buf_len < MBEDTLS_SSL_OUT_BUFFER_LEN &&
+        ( ret = ssl_resize_out_buf( ssl, MBEDTLS_SSL_OUT_BUFFER_LEN ) ) != 0 )
+    {
+        return( ret );
+    }
+
+    return( 0 );
+}
+
+void mbedtls_ssl_shrink_buffers( mbedtls_ssl_context *ssl )
+{
+    if( ssl == NULL || ssl->conf == NULL ||
+        ssl->in_buf == NULL || ssl->out_buf == NULL ||
+        !ssl_buffers_variable( ssl ) )
+    {
+        return;
+    }
+
+    /* Keep the larger buffers if data is pending or on allocation failure */
+    if( ssl->in_buf_len > SSL_IN_BUFFER_MIN_LEN && ssl->in_offt == NULL )
+        (void) ssl_resize_in_buf( ssl, SSL_IN_BUFFER_MIN_LEN );
+
+    if( ssl->out_buf_len > SSL_OUT_BUFFER_MIN_LEN )
+        (void) ssl_resize_out_buf( ssl, SSL_OUT_BUFFER_MIN_LEN );
+}
+
+/*
+ * Shrink buffers that have not been needed for a while
+ */
+static void ssl_buffers_check_idle( mbedtls_ssl_context *ssl )
+{
+    if( ssl->state != MBEDTLS_SSL_HANDSHAKE_OVER ||
+        ( ssl->in_buf_len <= SSL_IN_BUFFER_MIN_LEN &&
+          ssl->out_buf_len <= SSL_OUT_BUFFER_MIN_LEN ) )
+    {
+        return;
+    }
+
+#if defined(MBEDTLS_HAVE_TIME)
+    if( mbedtls_time( NULL ) - ssl->buf_stamp >=
+        (mbedtls_time_t) MBEDTLS_SSL_VARIABLE_BUFFER_IDLE )
+    {
+        mbedtls_ssl_shrink_buffers( ssl );
+    }
+#endif
+}
+#endif /* MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH */
+
 /*
  * Fill the input message buffer by appending data to it.
  * The amount of data already fetched is in ssl->in_left.
@@ -2542,11 +2806,16 @@ int mbedtls_ssl_fetch_input( mbedtls_ssl_context *ssl, size_t nb_want )
         return( MBEDTLS_ERR_SSL_BAD_INPUT_DATA );
     }
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    if( ( ret = ssl_in_buf_reserve( ssl, nb_want ) ) != 0 )
+        return( ret );
+#else
     if( nb_want > MBEDTLS_SSL_IN_BUFFER_LEN - (size_t)( ssl->in_hdr - ssl->in_buf ) )
     {
         MBEDTLS_SSL_DEBUG_MSG( 1, ( "requesting more data than fits" ) );
         return( MBEDTLS_ERR_SSL_BAD_INPUT_DATA );
     }
+#endif
 
 #if defined(MBEDTLS_SSL_PROTO_DTLS)
     if( ssl->conf->transport == MBEDTLS_SSL_TRANSPORT_DATAGRAM )
@@ -5744,6 +6013,7 @@ crt_verify:
         /*
          * Main check: verify certificate
          */
+        mbedtls_ssl_cert_lock( ssl, 1 );
         ret = mbedtls_x509_crt_verify_restartable(
                                 ssl->session_negotiate->peer_cert,
                                 ca_chain, ca_crl,
@@ -5751,6 +6021,7 @@ crt_verify:
                                 ssl->hostname,
                                &ssl->session_negotiate->verify_result,
                                 ssl->conf->f_vrfy, ssl->conf->p_vrfy, rs_ctx );
+        mbedtls_ssl_cert_lock( ssl, 0 );
 
         if( ret != 0 )
         {
@@ -6388,6 +6659,10 @@ void mbedtls_ssl_handshake_wrapup( mbedtls_ssl_context *ssl )
 
     ssl->state++;
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    mbedtls_ssl_shrink_buffers( ssl );
+#endif
+
     MBEDTLS_SSL_DEBUG_MSG( 3, ( "<= handshake wrapup" ) );
 }
 
@@ -6869,9 +7144,20 @@ int mbedtls_ssl_setup( mbedtls_ssl_context *ssl,
                        const mbedtls_ssl_config *conf )
 {
     int ret;
+    size_t in_buf_len = MBEDTLS_SSL_IN_BUFFER_LEN;
+    size_t out_buf_len = MBEDTLS_SSL_OUT_BUFFER_LEN;
 
     ssl->conf = conf;
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    /* Grown for the handshake */
+    if( ssl_buffers_variable( ssl ) )
+    {
+        in_buf_len = SSL_IN_BUFFER_MIN_LEN;
+        out_buf_len = SSL_OUT_BUFFER_MIN_LEN;
+    }
+#endif
+
     /*
      * Prepare base structures
      */
@@ -6879,22 +7165,27 @@ int mbedtls_ssl_setup( mbedtls_ssl_context *ssl,
     /* Set to NULL in case of an error condition */
     ssl->out_buf = NULL;
 
-    ssl->in_buf = mbedtls_calloc( 1, MBEDTLS_SSL_IN_BUFFER_LEN );
+    ssl->in_buf = mbedtls_calloc( 1, in_buf_len );
     if( ssl->in_buf == NULL )
     {
-        MBEDTLS_SSL_DEBUG_MSG( 1, ( "alloc(%d bytes) failed", MBEDTLS_SSL_IN_BUFFER_LEN) );
+        MBEDTLS_SSL_DEBUG_MSG( 1, ( "alloc(%d bytes) failed", (int) in_buf_len) );
         ret = MBEDTLS_ERR_SSL_ALLOC_FAILED;
         goto error;
     }
 
-    ssl->out_buf = mbedtls_calloc( 1, MBEDTLS_SSL_OUT_BUFFER_LEN );
+    ssl->out_buf = mbedtls_calloc( 1, out_buf_len );
     if( ssl->out_buf == NULL )
     {
-        MBEDTLS_SSL_DEBUG_MSG( 1, ( "alloc(%d bytes) failed", MBEDTLS_SSL_OUT_BUFFER_LEN) );
+        MBEDTLS_SSL_DEBUG_MSG( 1, ( "alloc(%d bytes) failed", (int) out_buf_len) );
         ret = MBEDTLS_ERR_SSL_ALLOC_FAILED;
         goto error;
     }
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    ssl->in_buf_len = in_buf_len;
+    ssl->out_buf_len = out_buf_len;
+#endif
+
     ssl_reset_in_out_pointers( ssl );
 
     if( ( ret = ssl_handshake_init( ssl ) ) != 0 )
@@ -6991,14 +7282,22 @@ static int ssl_session_reset_int( mbedtls_ssl_context *ssl, int partial )
     ssl->session_in = NULL;
     ssl->session_out = NULL;
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    memset( ssl->out_buf, 0, ssl->out_buf_len );
+#else
     memset( ssl->out_buf, 0, MBEDTLS_SSL_OUT_BUFFER_LEN );
+#endif
 
 #if defined(MBEDTLS_SSL_DTLS_CLIENT_PORT_REUSE) && defined(MBEDTLS_SSL_SRV_C)
     if( partial == 0 )
 #endif /* MBEDTLS_SSL_DTLS_CLIENT_PORT_REUSE && MBEDTLS_SSL_SRV_C */
     {
         ssl->in_left = 0;
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+        memset( ssl->in_buf, 0, ssl->in_buf_len );
+#else
         memset( ssl->in_buf, 0, MBEDTLS_SSL_IN_BUFFER_LEN );
+#endif
     }
 
 #if defined(MBEDTLS_SSL_HW_RECORD_ACCEL)
@@ -7113,6 +7412,14 @@ void mbedtls_ssl_conf_verify( mbedtls_ssl_config *conf,
     conf->f_vrfy      = f_vrfy;
     conf->p_vrfy      = p_vrfy;
 }
+
+void mbedtls_ssl_conf_cert_lock( mbedtls_ssl_config *conf,
+                                 void (*f_lock)(void *, int),
+                                 void *p_lock )
+{
+    conf->f_cert_lock = f_lock;
+    conf->p_cert_lock = p_lock;
+}
 #endif /* MBEDTLS_X509_CRT_PARSE_C */
 
 void mbedtls_ssl_conf_rng( mbedtls_ssl_config *conf,
@@ -8059,6 +8366,11 @@ int mbedtls_ssl_handshake_step( mbedtls_ssl_context *ssl )
     if( ssl == NULL || ssl->conf == NULL )
         return( MBEDTLS_ERR_SSL_BAD_INPUT_DATA );
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    if( ( ret = ssl_buffers_grow_handshake( ssl ) ) != 0 )
+        return( ret );
+#endif
+
 #if defined(MBEDTLS_SSL_CLI_C)
     if( ssl->conf->endpoint == MBEDTLS_SSL_IS_CLIENT )
         ret = mbedtls_ssl_handshake_client_step( ssl );
@@ -8317,6 +8629,10 @@ int mbedtls_ssl_read( mbedtls_ssl_context *ssl, unsigned char *buf, size_t len )
         }
     }
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    ssl_buffers_check_idle( ssl );
+#endif
+
     /* Loop as long as no application data record is available */
     while( ssl->in_offt == NULL )
     {
@@ -8620,6 +8936,10 @@ static int ssl_write_real( mbedtls_ssl_context *ssl,
          * copy the data into the internal buffers and setup the data structure
          * to keep track of partial writes
          */
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+        if( ( ret = ssl_out_buf_reserve( ssl, len ) ) != 0 )
+            return( ret );
+#endif
         ssl->out_msglen  = len;
         ssl->out_msgtype = MBEDTLS_SSL_MSG_APPLICATION_DATA;
         memcpy( ssl->out_msg, buf, len );
@@ -8701,6 +9021,10 @@ int mbedtls_ssl_write( mbedtls_ssl_context *ssl, const unsigned char *buf, size_
         }
     }
 
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    ssl_buffers_check_idle( ssl );
+#endif
+
 #if defined(MBEDTLS_SSL_CBC_RECORD_SPLITTING)
     ret = ssl_write_split( ssl, buf, len );
 #else
@@ -8935,13 +9259,21 @@ void mbedtls_ssl_free( mbedtls_ssl_context *ssl )
 
     if( ssl->out_buf != NULL )
     {
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+        mbedtls_platform_zeroize( ssl->out_buf, ssl->out_buf_len );
+#else
         mbedtls_platform_zeroize( ssl->out_buf, MBEDTLS_SSL_OUT_BUFFER_LEN );
+#endif
         mbedtls_free( ssl->out_buf );
     }
 
     if( ssl->in_buf != NULL )
     {
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+        mbedtls_platform_zeroize( ssl->in_buf, ssl->in_buf_len );
+#else
         mbedtls_platform_zeroize( ssl->in_buf, MBEDTLS_SSL_IN_BUFFER_LEN );
+#endif
         mbedtls_free( ssl->in_buf );
     }
 
@@ -29,6 +29,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include "mbedtls/mbedtls.h"
+#include "kernel/os/os.h"
+#if defined(MBEDTLS_TRUST_STORE) || defined(MBEDTLS_SESSION_STORE)
+#include "mbedtls/sha256.h"
+#endif
+#if defined(MBEDTLS_TRUST_STORE)
+#include "mbedtls/platform.h"
+#endif
 
 #define MBEDTLS_API_DEBUG
 
@@ -155,6 +162,23 @@ int mbedtls_config_context(mbedtls_context *context, void *param, int verify)
 #if defined(MBEDTLS_SSL_CLI_C)
 	/* Load the certificates and private RSA key */
 	if (pContext->is_client == MBEDTLS_SSL_IS_CLIENT) {
+#if defined(MBEDTLS_TRUST_STORE)
+		mbedtls_trust_param trust;
+
+		memset(&trust, 0, sizeof(trust));
+		trust.ca[0].buf = (const unsigned char *)(client->pCa);
+		trust.ca[0].len = client->nCa;
+		if (client->certs.pCert != NULL && client->certs.pCa != NULL && client->certs.pKey != NULL) {
+			trust.ca[1].buf = (const unsigned char *)(client->certs.pCa);
+			trust.ca[1].len = client->certs.nCa;
+			trust.cert = (const unsigned char *)(client->certs.pCert);
+			trust.cert_len = client->certs.nCert;
+			trust.key = (const unsigned char *)(client->certs.pKey);
+			trust.key_len = client->certs.nKey;
+		}
+		if ((pContext->trust = mbedtls_trust_store_get(&trust)) == NULL)
+			return -1;
+#else
 		if ((ret = mbedtls_x509_crt_parse(&(pContext->cert.cli_cert.ca),
 		                                    (const unsigned char *)(client->pCa),
 		                                    client->nCa)) != 0) {
@@ -183,7 +207,7 @@ int mbedtls_config_context(mbedtls_context *context, void *param, int verify)
 				return -1;
 			}
 		}
-
+#endif /* MBEDTLS_TRUST_STORE */
 	}
 #endif
 
@@ -241,6 +265,12 @@ int mbedtls_config_context(mbedtls_context *context, void *param, int verify)
 
 #if defined(MBEDTLS_SSL_CLI_C)
 	if (pContext->is_client == MBEDTLS_SSL_IS_CLIENT) {
+#if defined(MBEDTLS_TRUST_STORE)
+		if ((ret = mbedtls_trust_store_attach(pContext->trust, &(pContext->conf))) != 0) {
+			mbedtls_dbg(err, "mbedtls_ssl_conf_own_cert failed (%s0x%04x)\n", ret > 0 ? "":"-", ret > 0 ? ret:-ret);
+			return -1;
+		}
+#else
 		mbedtls_ssl_conf_ca_chain(&(pContext->conf), &(pContext->cert.cli_cert.ca), NULL);
 		if (client->certs.pCert != NULL && client->certs.pKey != NULL) {
 			if ((ret = mbedtls_ssl_conf_own_cert(&(pContext->conf), &(pContext->cert.cli_cert.cert),
@@ -249,6 +279,7 @@ int mbedtls_config_context(mbedtls_context *context, void *param, int verify)
 				return -1;
 			}
 		}
+#endif /* MBEDTLS_TRUST_STORE */
 	}
 #endif
 
@@ -281,6 +312,601 @@ int mbedtls_config_context(mbedtls_context *context, void *param, int verify)
 
 #if defined(MBEDTLS_SSL_CLI_C)
 
+/*
+ * A resumed session keeps the verify result of the handshake that created it,
+ * so a session is only offered to a connection that would have verified the
+ * server the same way: same server, auth mode and CA chain.
+ */
+typedef struct {
+	char                host[MBEDTLS_SESSION_STORE_HOST_LEN];
+	int                 port;
+	int                 authmode;
+	unsigned char       ca_id[32];    /* see mbedtls_session_ca_id() */
+	OS_Time_t           stamp;        /* ticks of the last save */
+	mbedtls_ssl_session session;
+} mbedtls_session_entry;
+
+typedef struct {
+	const char          *host;
+	int                 port;
+	int                 authmode;
+	unsigned char       ca_id[32];
+} mbedtls_session_key;
+
+static mbedtls_session_entry g_session_store[MBEDTLS_SESSION_STORE_NUM];
+static mbedtls_session_stats g_session_stats;
+static OS_Mutex_t g_session_mutex;
+
+static void mbedtls_session_lock(void)
+{
+	if (!OS_MutexIsValid(&g_session_mutex)) {
+		OS_ThreadSuspendScheduler();
+		if (!OS_MutexIsValid(&g_session_mutex))
+			OS_MutexCreate(&g_session_mutex);
+		OS_ThreadResumeScheduler();
+	}
+	OS_MutexLock(&g_session_mutex, OS_WAIT_FOREVER);
+}
+
+static void mbedtls_session_unlock(void)
+{
+	OS_MutexUnlock(&g_session_mutex);
+}
+
+static void mbedtls_session_entry_free(mbedtls_session_entry *entry)
+{
+	mbedtls_ssl_session_free(&entry->session);
+	memset(entry, 0, sizeof(*entry));
+}
+
+/* The CA chain, identified by the digest of its signatures (one per certificate). */
+static void mbedtls_session_ca_id(const mbedtls_ssl_context *ssl, unsigned char id[32])
+{
+	mbedtls_sha256_context sha;
+	const mbedtls_x509_crt *crt;
+
+	mbedtls_sha256_init(&sha);
+	mbedtls_sha256_starts_ret(&sha, 0);
+	for (crt = ssl->conf->ca_chain; crt != NULL && crt->raw.len != 0; crt = crt->next)
+		mbedtls_sha256_update_ret(&sha, crt->sig.p, crt->sig.len);
+	mbedtls_sha256_finish_ret(&sha, id);
+	mbedtls_sha256_free(&sha);
+}
+
+static void mbedtls_session_key_init(mbedtls_session_key *key, const mbedtls_ssl_context *ssl,
+                                     const char *host, int port)
+{
+	key->host = host;
+	key->port = port;
+	key->authmode = ssl->conf->authmode;
+	mbedtls_session_ca_id(ssl, key->ca_id);
+}
+
+/* Find the entry of a key, dropping it if it has expired. */
+static mbedtls_session_entry *mbedtls_session_find(const mbedtls_session_key *key)
+{
+	int i;
+	mbedtls_session_entry *entry;
+
+	for (i = 0; i < MBEDTLS_SESSION_STORE_NUM; i++) {
+		entry = &g_session_store[i];
+		if (entry->host[0] == '\0' || entry->port != key->port ||
+		    entry->authmode != key->authmode ||
+		    memcmp(entry->ca_id, key->ca_id, sizeof(entry->ca_id)) != 0 ||
+		    strncmp(entry->host, key->host, sizeof(entry->host)) != 0)
+			continue;
+		if (OS_GetTicks() - entry->stamp > OS_MSecsToTicks(MBEDTLS_SESSION_STORE_TIMEOUT)) {
+			mbedtls_session_entry_free(entry);
+			return NULL;
+		}
+		return entry;
+	}
+	return NULL;
+}
+
+/* Get a free entry, or the least recently saved one. */
+static mbedtls_session_entry *mbedtls_session_alloc(void)
+{
+	int i;
+	mbedtls_session_entry *entry, *oldest = &g_session_store[0];
+
+	for (i = 0; i < MBEDTLS_SESSION_STORE_NUM; i++) {
+		entry = &g_session_store[i];
+		if (entry->host[0] == '\0')
+			return entry;
+		if (OS_GetTicks() - entry->stamp > OS_GetTicks() - oldest->stamp)
+			oldest = entry;
+	}
+	mbedtls_session_entry_free(oldest);
+	return oldest;
+}
+
+/**
+  * @brief Offer the stored session of a server for resumption
+  *
+  * @note  Call it after mbedtls_ssl_setup() and before the handshake.
+  * @param ssl: client SSL context
+  * @param host: server's name
+  * @param port: server's port
+  * @retval 0 if a session was set or -1 otherwise.
+  */
+int mbedtls_session_store_resume(mbedtls_ssl_context *ssl, const char *host, int port)
+{
+	int ret = -1;
+	mbedtls_session_entry *entry;
+	mbedtls_session_key key;
+
+	if (ssl == NULL || host == NULL || strlen(host) >= MBEDTLS_SESSION_STORE_HOST_LEN)
+		return -1;
+
+	mbedtls_session_key_init(&key, ssl, host, port);
+	mbedtls_session_lock();
+	entry = mbedtls_session_find(&key);
+	if (entry != NULL && mbedtls_ssl_set_session(ssl, &entry->session) == 0)
+		ret = 0;
+	mbedtls_session_unlock();
+
+	mbedtls_dbg(inf, "%s:%d session %s.\n", host, port, ret == 0 ? "offered" : "not stored");
+	return ret;
+}
+
+/**
+  * @brief Record the result of a client handshake
+  *
+  * A successful handshake is counted as resumed or full and its session is
+  * stored for the next connection. A failed handshake drops the stored
+  * session, so that the next attempt is a full handshake. A session whose
+  * server certificate did not verify is not stored either, unless the
+  * connection does not verify at all (MBEDTLS_SSL_VERIFY_NONE).
+  *
+  * @note  Call it after the caller has checked the verify result.
+  * @param ssl: client SSL context
+  * @param host: server's name
+  * @param port: server's port
+  * @param result: return value of the handshake
+  * @retval
+  */
+void mbedtls_session_store_update(mbedtls_ssl_context *ssl, const char *host, int port, int result)
+{
+	mbedtls_session_entry *entry;
+	mbedtls_session_key key;
+	int resumed;
+
+	if (ssl == NULL || host == NULL || strlen(host) >= MBEDTLS_SESSION_STORE_HOST_LEN)
+		return;
+
+	mbedtls_session_key_init(&key, ssl, host, port);
+	mbedtls_session_lock();
+	entry = mbedtls_session_find(&key);
+	if (result != 0 || ssl->session == NULL) {
+		if (entry != NULL)
+			mbedtls_session_entry_free(entry);
+		mbedtls_session_unlock();
+		return;
+	}
+
+	/* a resumed session keeps the master secret of the stored one */
+	resumed = (entry != NULL &&
+	           memcmp(entry->session.master, ssl->session->master,
+	                  sizeof(ssl->session->master)) == 0);
+	if (resumed)
+		g_session_stats.resumed++;
+	else
+		g_session_stats.full++;
+
+	if ((ssl->session->verify_result != 0 && key.authmode != MBEDTLS_SSL_VERIFY_NONE) ||
+	    (ssl->session->id_len == 0
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+	     && ssl->session->ticket_len == 0
+#endif
+	    )) {
+		/* not verified, or the server does not support resumption */
+		if (entry != NULL)
+			mbedtls_session_entry_free(entry);
+	} else {
+		if (entry == NULL)
+			entry = mbedtls_session_alloc();
+		if (mbedtls_ssl_get_session(ssl, &entry->session) == 0) {
+			strcpy(entry->host, host);
+			entry->port = port;
+			entry->authmode = key.authmode;
+			memcpy(entry->ca_id, key.ca_id, sizeof(entry->ca_id));
+			entry->stamp = OS_GetTicks();
+		} else {
+			mbedtls_session_entry_free(entry);
+		}
+	}
+	mbedtls_session_unlock();
+
+	mbedtls_dbg(inf, "%s:%d %s handshake.\n", host, port, resumed ? "resumed" : "full");
+}
+
+/**
+  * @brief Offer the stored session of the server the SSL context is set up for
+  *
+  * The same as mbedtls_session_store_resume() with the host name set by
+  * mbedtls_ssl_set_hostname(), for callers that must not look into the
+  * context. Nothing is offered to a server context, a client without a host
+  * name or one whose handshake has already started.
+  *
+  * @param ssl: SSL context
+  * @param port: server's port
+  * @retval 0 if a session was set or -1 otherwise.
+  */
+int mbedtls_session_store_resume_ssl(mbedtls_ssl_context *ssl, int port)
+{
+	if (ssl == NULL || ssl->conf == NULL ||
+	    ssl->conf->endpoint != MBEDTLS_SSL_IS_CLIENT ||
+	    ssl->state != MBEDTLS_SSL_HELLO_REQUEST)
+		return -1;
+
+	return mbedtls_session_store_resume(ssl, ssl->hostname, port);
+}
+
+/**
+  * @brief Record the result of a handshake on the SSL context
+  *
+  * The same as mbedtls_session_store_update() with the host name set by
+  * mbedtls_ssl_set_hostname(). Server contexts and clients without a host
+  * name are ignored.
+  *
+  * @param ssl: SSL context
+  * @param port: server's port
+  * @param result: return value of the handshake
+  * @retval
+  */
+void mbedtls_session_store_update_ssl(mbedtls_ssl_context *ssl, int port, int result)
+{
+	if (ssl == NULL || ssl->conf == NULL ||
+	    ssl->conf->endpoint != MBEDTLS_SSL_IS_CLIENT)
+		return;
+
+	mbedtls_session_store_update(ssl, ssl->hostname, port, result);
+}
+
+/**
+  * @brief Drop the stored sessions of a server
+  *
+  * @param host: server's name
+  * @param port: server's port
+  * @retval
+  */
+void mbedtls_session_store_remove(const char *host, int port)
+{
+	int i;
+	mbedtls_session_entry *entry;
+
+	if (host == NULL)
+		return;
+
+	mbedtls_session_lock();
+	for (i = 0; i < MBEDTLS_SESSION_STORE_NUM; i++) {
+		entry = &g_session_store[i];
+		if (entry->host[0] != '\0' && entry->port == port &&
+		    strncmp(entry->host, host, sizeof(entry->host)) == 0)
+			mbedtls_session_entry_free(entry);
+	}
+	mbedtls_session_unlock();
+}
+
+/**
+  * @brief Drop all stored sessions
+  *
+  * @retval
+  */
+void mbedtls_session_store_flush(void)
+{
+	int i;
+
+	mbedtls_session_lock();
+	for (i = 0; i < MBEDTLS_SESSION_STORE_NUM; i++) {
+		if (g_session_store[i].host[0] != '\0')
+			mbedtls_session_entry_free(&g_session_store[i]);
+	}
+	mbedtls_session_unlock();
+}
+
+/**
+  * @brief Get the number of full and resumed client handshakes
+  *
+  * @param stats: (output) handshake counters
+  * @retval
+  */
+void mbedtls_session_store_stats(mbedtls_session_stats *stats)
+{
+	if (stats == NULL)
+		return;
+
+	mbedtls_session_lock();
+	*stats = g_session_stats;
+	mbedtls_session_unlock();
+}
+
+#if defined(MBEDTLS_TRUST_STORE)
+
+static mbedtls_trust_store *g_trust_list;
+static OS_Mutex_t g_trust_mutex;
+static OS_Mutex_t g_trust_use_mutex;	/* held while store contexts are used */
+
+static void mbedtls_trust_lock(void)
+{
+	if (!OS_MutexIsValid(&g_trust_mutex)) {
+		OS_ThreadSuspendScheduler();
+		if (!OS_MutexIsValid(&g_trust_mutex))
+			OS_MutexCreate(&g_trust_mutex);
+		OS_ThreadResumeScheduler();
+	}
+	OS_MutexLock(&g_trust_mutex, OS_WAIT_FOREVER);
+}
+
+static void mbedtls_trust_unlock(void)
+{
+	OS_MutexUnlock(&g_trust_mutex);
+}
+
+static void mbedtls_trust_digest_buf(mbedtls_sha256_context *sha,
+                                     const unsigned char *buf, size_t len)
+{
+	unsigned char n[4];
+
+	if (buf == NULL)
+		len = 0;
+	n[0] = (unsigned char)(len >> 24);
+	n[1] = (unsigned char)(len >> 16);
+	n[2] = (unsigned char)(len >> 8);
+	n[3] = (unsigned char)(len);
+	mbedtls_sha256_update_ret(sha, n, sizeof(n));
+	if (len > 0)
+		mbedtls_sha256_update_ret(sha, buf, len);
+}
+
+/* each buffer is prefixed by its length, so that concatenations differ */
+static void mbedtls_trust_digest(const mbedtls_trust_param *param, unsigned char digest[32])
+{
+	mbedtls_sha256_context sha;
+	unsigned char in_place = param->ca_in_place ? 1 : 0;
+	int i;
+
+	mbedtls_sha256_init(&sha);
+	mbedtls_sha256_starts_ret(&sha, 0);
+	mbedtls_sha256_update_ret(&sha, &in_place, 1);
+	for (i = 0; i < MBEDTLS_TRUST_STORE_CA_NUM; i++)
+		mbedtls_trust_digest_buf(&sha, param->ca[i].buf, param->ca[i].len);
+	mbedtls_trust_digest_buf(&sha, param->cert, param->cert_len);
+	mbedtls_trust_digest_buf(&sha, param->chain, param->chain_len);
+	mbedtls_trust_digest_buf(&sha, param->key, param->key_len);
+	mbedtls_trust_digest_buf(&sha, param->pwd, param->pwd_len);
+	mbedtls_sha256_finish_ret(&sha, digest);
+	mbedtls_sha256_free(&sha);
+}
+
+/* concatenated DER certificates, referenced in place */
+static int mbedtls_trust_parse_in_place(mbedtls_x509_crt *chain,
+                                        const unsigned char *buf, size_t len)
+{
+	const unsigned char *end = buf + len;
+	mbedtls_x509_crt *last;
+	int ret;
+
+	while (buf < end) {
+		if ((ret = mbedtls_x509_crt_parse_der_nocopy(chain, buf, end - buf)) != 0)
+			return ret;
+		for (last = chain; last->next != NULL; last = last->next)
+			;
+		buf += last->raw.len;
+	}
+	return 0;
+}
+
+static void mbedtls_trust_store_free(mbedtls_trust_store *store)
+{
+	mbedtls_x509_crt_free(&store->ca);
+	mbedtls_x509_crt_free(&store->cert);
+	mbedtls_pk_free(&store->key);
+	mbedtls_free(store);
+}
+
+static mbedtls_trust_store *mbedtls_trust_store_parse(const mbedtls_trust_param *param)
+{
+	mbedtls_trust_store *store;
+	OS_Time_t start = OS_GetTicks();
+	int i, ret = 0;
+
+	if ((store = mbedtls_calloc(1, sizeof(*store))) == NULL) {
+		mbedtls_dbg(err, "Malloc mem failed.\n");
+		return NULL;
+	}
+	mbedtls_x509_crt_init(&store->ca);
+	mbedtls_x509_crt_init(&store->cert);
+	mbedtls_pk_init(&store->key);
+
+	for (i = 0; i < MBEDTLS_TRUST_STORE_CA_NUM && ret == 0; i++) {
+		if (param->ca[i].buf == NULL || param->ca[i].len == 0)
+			continue;
+		if (param->ca_in_place)
+			ret = mbedtls_trust_parse_in_place(&store->ca, param->ca[i].buf, param->ca[i].len);
+		else
+			ret = mbedtls_x509_crt_parse(&store->ca, param->ca[i].buf, param->ca[i].len);
+		/* a bundle may hold certificates of unsupported algorithms */
+		if (ret > 0) {
+			mbedtls_dbg(inf, "%d CA certificates skipped.\n", ret);
+			ret = 0;
+		}
+	}
+	if (ret != 0) {
+		mbedtls_dbg(err, "mbedtls_x509_crt_parse failed..(%s0x%04x)\n", ret > 0 ? "":"-", ret > 0 ? ret:-ret);
+		goto err;
+	}
+
+	if (param->cert != NULL) {
+		if ((ret = mbedtls_x509_crt_parse(&store->cert, param->cert, param->cert_len)) != 0 ||
+		    (param->chain != NULL &&
+		     (ret = mbedtls_x509_crt_parse(&store->cert, param->chain, param->chain_len)) != 0)) {
+			mbedtls_dbg(err, "mbedtls_x509_crt_parse failed.. (%s0x%04x)\n", ret > 0 ? "":"-", ret > 0 ? ret:-ret);
+			goto err;
+		}
+	}
+	if (param->key != NULL) {
+		if ((ret = mbedtls_pk_parse_key(&store->key, param->key, param->key_len,
+		                                param->pwd, param->pwd_len)) != 0) {
+			mbedtls_dbg(err, "mbedtls_pk_parse_key failed.. (%s0x%04x)\n", ret > 0 ? "":"-", ret > 0 ? ret:-ret);
+			goto err;
+		}
+	}
+	store->has_own = (param->cert != NULL && param->key != NULL);
+
+	mbedtls_dbg(inf, "Trust store parsed in %u ms.\n",
+	            (unsigned int)OS_TicksToMSecs(OS_GetTicks() - start));
+	return store;
+
+err:
+	mbedtls_trust_store_free(store);
+	return NULL;
+}
+
+/* free the least recently released stores beyond the cache size */
+static void mbedtls_trust_store_trim(int keep)
+{
+	mbedtls_trust_store *store, **pp, **oldest;
+	int idle;
+
+	while (1) {
+		idle = 0;
+		oldest = NULL;
+		for (pp = &g_trust_list; (store = *pp) != NULL; pp = &store->next) {
+			if (store->ref > 0)
+				continue;
+			idle++;
+			if (oldest == NULL || OS_TimeBefore(store->stamp, (*oldest)->stamp))
+				oldest = pp;
+		}
+		if (idle <= keep)
+			break;
+		store = *oldest;
+		*oldest = store->next;
+		mbedtls_trust_store_free(store);
+	}
+}
+
+/**
+  * @brief Get the trust store of a set of certificates
+  *
+  * @param param: certificates and key, which must stay valid while the
+  *        store is referenced if ca_in_place is set
+  * @note  A store with the same input is shared, otherwise the input is
+  *        parsed into a new store.
+  * @retval The store, to be released by mbedtls_trust_store_put(), or NULL
+  *         if the input can not be parsed.
+  */
+mbedtls_trust_store *mbedtls_trust_store_get(const mbedtls_trust_param *param)
+{
+	mbedtls_trust_store *store;
+	unsigned char digest[32];
+
+	if (param == NULL)
+		return NULL;
+
+	mbedtls_trust_digest(param, digest);
+
+	/* parse under the lock, concurrent connections then share one store */
+	mbedtls_trust_lock();
+	if (!OS_MutexIsValid(&g_trust_use_mutex) &&
+	    OS_MutexCreate(&g_trust_use_mutex) != OS_OK) {
+		mbedtls_trust_unlock();
+		mbedtls_dbg(err, "Mutex create failed.\n");
+		return NULL;
+	}
+	for (store = g_trust_list; store != NULL; store = store->next) {
+		if (memcmp(store->digest, digest, sizeof(digest)) == 0)
+			break;
+	}
+	if (store == NULL) {
+		store = mbedtls_trust_store_parse(param);
+		if (store != NULL) {
+			memcpy(store->digest, digest, sizeof(digest));
+			store->next = g_trust_list;
+			g_trust_list = store;
+		}
+	}
+	if (store != NULL)
+		store->ref++;
+	mbedtls_trust_unlock();
+
+	return store;
+}
+
+/**
+  * @brief Release a trust store got by mbedtls_trust_store_get()
+  *
+  * @param store: the store, may be NULL
+  * @retval
+  */
+void mbedtls_trust_store_put(mbedtls_trust_store *store)
+{
+	if (store == NULL)
+		return;
+
+	mbedtls_trust_lock();
+	if (--store->ref == 0) {
+		store->stamp = OS_GetTicks();
+		mbedtls_trust_store_trim(MBEDTLS_TRUST_STORE_CACHE_NUM);
+	}
+	mbedtls_trust_unlock();
+}
+
+/**
+  * @brief Lock callback of the certificates and keys of all stores
+  *
+  * @param p: unused
+  * @param lock: 1 to lock, 0 to unlock
+  * @note  For mbedtls_ssl_conf_cert_lock() of configurations using store
+  *        contexts without mbedtls_trust_store_attach(). One lock serves all
+  *        stores, a connection may take certificates and key from several.
+  * @retval
+  */
+void mbedtls_trust_store_use(void *p, int lock)
+{
+	(void)p;
+	if (lock)
+		OS_MutexLock(&g_trust_use_mutex, OS_WAIT_FOREVER);
+	else
+		OS_MutexUnlock(&g_trust_use_mutex);
+}
+
+/**
+  * @brief Configure the certificates and key of a store for a connection
+  *
+  * @param store: the store
+  * @param conf: the SSL configuration, keeping a pointer to the store
+  * @note  Connections of one store share its contexts. mbedtls changes them
+  *        while verifying a chain or using the key, so these operations are
+  *        locked one by one through mbedtls_ssl_conf_cert_lock().
+  * @retval 0 on success, or the error of mbedtls_ssl_conf_own_cert()
+  */
+int mbedtls_trust_store_attach(mbedtls_trust_store *store, mbedtls_ssl_config *conf)
+{
+	mbedtls_ssl_conf_ca_chain(conf, &store->ca, NULL);
+	mbedtls_ssl_conf_cert_lock(conf, mbedtls_trust_store_use, NULL);
+	if (store->has_own)
+		return mbedtls_ssl_conf_own_cert(conf, &store->cert, &store->key);
+	return 0;
+}
+
+/**
+  * @brief Free all trust stores that are not referenced
+  *
+  * @retval
+  */
+void mbedtls_trust_store_flush(void)
+{
+	mbedtls_trust_lock();
+	mbedtls_trust_store_trim(0);
+	mbedtls_trust_unlock();
+	/* sessions were verified against the old certificates */
+	mbedtls_session_store_flush();
+}
+#endif /* MBEDTLS_TRUST_STORE */
+
 static int mbedtls_get_noblock(mbedtls_net_context *ctx)
 {
 	if (ctx == NULL) {
@@ -333,6 +959,10 @@ int mbedtls_connect(mbedtls_context *context, mbedtls_sock *fd, struct sockaddr
 	}
 	if (is_noblock == 1)
 		mbedtls_net_set_nonblock(net_fd);
+	if (ServerAddress->sa_family == AF_INET)
+		pContext->port = ntohs(((struct sockaddr_in *)ServerAddress)->sin_port);
+	if (hostname != NULL)
+		mbedtls_session_store_resume(&(pContext->ssl), hostname, pContext->port);
 	mbedtls_dbg(inf, "Connect ok..\n");
 	return ret;
 }
@@ -393,6 +1023,9 @@ void mbedtls_deinit_context(mbedtls_context *context)
 
 #if defined(MBEDTLS_SSL_CLI_C)
 	if (pContext->is_client == MBEDTLS_SSL_IS_CLIENT) {
+#if defined(MBEDTLS_TRUST_STORE)
+		mbedtls_trust_store_put(pContext->trust);
+#endif
 		mbedtls_x509_crt_free(&(pContext->cert.cli_cert.ca));
 		mbedtls_x509_crt_free(&(pContext->cert.cli_cert.cert));
 		mbedtls_pk_free(&(pContext->cert.cli_cert.key));
@@ -467,11 +1100,15 @@ int mbedtls_handshake(mbedtls_context *context, mbedtls_sock* fd)
 			ret = -1;
 		}
 	}
-	if (ret == 0) {
+	if (ret == 0)
 		mbedtls_dbg(inf, "Handshake ok(%s).\n", mbedtls_ssl_get_ciphersuite(&(pContext->ssl)));
-		return 0;
-	}
 exit:
+#if defined(MBEDTLS_SSL_CLI_C)
+	/* a session is only kept for resumption if it was accepted here */
+	if (pContext->is_client == MBEDTLS_SSL_IS_CLIENT)
+		mbedtls_session_store_update(&(pContext->ssl), pContext->ssl.hostname,
+		                             pContext->port, ret);
+#endif
 	return ret;
 }
 
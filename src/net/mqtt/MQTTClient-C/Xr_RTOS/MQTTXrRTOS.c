@@ -21,6 +21,10 @@
 #include "MQTTDebug.h"
 #include "lwip/sockets.h"
 #include "lwip/netdb.h"
+#if (__CONFIG_MBEDTLS_VER == 0x02100000)
+#include "mbedtls/session_store.h"
+#include "mbedtls/trust_store.h"
+#endif
 #include "errno.h"
 
 #if (__CONFIG_MQTT_HEAP_MODE == 1)
@@ -460,12 +464,14 @@ static void mqtt_ssl_network_deinit(Network *n)
 		psram_free(n->entropy);
 	if (n->ctr_drbg)
 		psram_free(n->ctr_drbg);
+#ifndef MBEDTLS_TRUST_STORE
 	if (n->cacertl)
 		psram_free(n->cacertl);
 	if (n->clicert)
 		psram_free(n->clicert);
 	if (n->pkey)
 		psram_free(n->pkey);
+#endif
 #else
 	if (n->fd)
 		free(n->fd);
@@ -477,12 +483,14 @@ static void mqtt_ssl_network_deinit(Network *n)
 		free(n->entropy);
 	if (n->ctr_drbg)
 		free(n->ctr_drbg);
+#ifndef MBEDTLS_TRUST_STORE
 	if (n->cacertl)
 		free(n->cacertl);
 	if (n->clicert)
 		free(n->clicert);
 	if (n->pkey)
 		free(n->pkey);
+#endif
 #endif
 
 	n->fd = NULL;
@@ -493,6 +501,10 @@ static void mqtt_ssl_network_deinit(Network *n)
 	n->cacertl = NULL;
 	n->clicert = NULL;
 	n->pkey = NULL;
+#ifdef MBEDTLS_TRUST_STORE
+	mbedtls_trust_store_put(n->trust);
+	n->trust = NULL;
+#endif
 }
 
 static int mqtt_ssl_network_init(Network *n)
@@ -503,22 +515,35 @@ static int mqtt_ssl_network_init(Network *n)
 	n->conf = psram_malloc(sizeof(mbedtls_ssl_config));
 	n->entropy = psram_malloc(sizeof(mbedtls_entropy_context));
 	n->ctr_drbg = psram_malloc(sizeof(mbedtls_ctr_drbg_context));
+#ifndef MBEDTLS_TRUST_STORE
 	n->cacertl = psram_malloc(sizeof(mbedtls_x509_crt));
 	n->clicert = psram_malloc(sizeof(mbedtls_x509_crt));
 	n->pkey = psram_malloc(sizeof(mbedtls_pk_context));
+#endif
 #else
 	n->fd = malloc(sizeof(mbedtls_net_context));
 	n->ssl = malloc(sizeof(mbedtls_ssl_context));
 	n->conf = malloc(sizeof(mbedtls_ssl_config));
 	n->entropy = malloc(sizeof(mbedtls_entropy_context));
 	n->ctr_drbg = malloc(sizeof(mbedtls_ctr_drbg_context));
+#ifndef MBEDTLS_TRUST_STORE
 	n->cacertl = malloc(sizeof(mbedtls_x509_crt));
 	n->clicert = malloc(sizeof(mbedtls_x509_crt));
 	n->pkey = malloc(sizeof(mbedtls_pk_context));
 #endif
+#endif
 
+#ifdef MBEDTLS_TRUST_STORE
+	/* certificates are referenced from the shared trust store */
+	n->cacertl = NULL;
+	n->clicert = NULL;
+	n->pkey = NULL;
+	n->trust = NULL;
+	if (!n->fd || !n->ssl || !n->conf || !n->entropy || !n->ctr_drbg) {
+#else
 	if (!n->fd || !n->ssl || !n->conf || !n->entropy ||
 		!n->ctr_drbg || !n->cacertl || !n->clicert || !n->pkey) {
+#endif
 		mqtt_ssl_network_deinit(n);
 		return -1;
 	}
@@ -587,9 +612,11 @@ void mqtt_ssl_disconnect(Network *n)
 		mbedtls_ssl_config_free(n->conf);
 		mbedtls_entropy_free(n->entropy);
 		mbedtls_ctr_drbg_free(n->ctr_drbg);
+#ifndef MBEDTLS_TRUST_STORE
 		mbedtls_x509_crt_free(n->cacertl);
 		mbedtls_x509_crt_free(n->clicert);
 		mbedtls_pk_free(n->pkey);
+#endif
 
 		mqtt_ssl_network_deinit(n);
 	}
@@ -618,9 +645,11 @@ int TLSConnectNetwork(Network *n, const char *addr, const char *port,
     mbedtls_ssl_config_init(n->conf);
 	mbedtls_entropy_init(n->entropy);
 	mbedtls_ctr_drbg_init(n->ctr_drbg);
+#ifndef MBEDTLS_TRUST_STORE
     mbedtls_x509_crt_init(n->cacertl);
 	mbedtls_x509_crt_init(n->clicert);
 	mbedtls_pk_init(n->pkey);
+#endif
 /*
 	if ((ret = mbedtls_ctr_drbg_seed(n->ctr_drbg, mbedtls_entropy_func, n->entropy,
 	                                    (const unsigned char *) pers,
@@ -629,6 +658,29 @@ int TLSConnectNetwork(Network *n, const char *addr, const char *port,
 		goto exit;
 	}
 */
+#ifdef MBEDTLS_TRUST_STORE
+	mbedtls_trust_param trust;
+
+	memset(&trust, 0, sizeof(trust));
+	trust.ca[0].buf = (const unsigned char *)ca_crt;
+	trust.ca[0].len = ca_crt_len;
+	if (client_crt != NULL && client_key != NULL) {
+		trust.cert = (const unsigned char *)client_crt;
+		trust.cert_len = client_crt_len;
+		trust.key = (const unsigned char *)client_key;
+		trust.key_len = client_key_len;
+		trust.pwd = (const unsigned char *)client_pwd;
+		trust.pwd_len = client_pwd_len;
+	}
+	if ((n->trust = mbedtls_trust_store_get(&trust)) == NULL) {
+		MQTT_PLATFORM_WARN("failed ! mbedtls_trust_store_get\n");
+		ret = -1;
+		goto exit;
+	}
+	n->cacertl = &n->trust->ca;
+	n->clicert = &n->trust->cert;
+	n->pkey = &n->trust->key;
+#else
     if (ca_crt != NULL) {
         if ((ret = mbedtls_x509_crt_parse(n->cacertl, (const unsigned char *)ca_crt, ca_crt_len)) != 0) {
             MQTT_PLATFORM_WARN("failed ! x509parse_crt returned -0x%04x\n", -ret);
@@ -648,6 +700,7 @@ int TLSConnectNetwork(Network *n, const char *addr, const char *port,
 			goto exit;
 		}
 	}
+#endif /* MBEDTLS_TRUST_STORE */
 
     /*
      * 1. Start the connection
@@ -680,12 +733,19 @@ int TLSConnectNetwork(Network *n, const char *addr, const char *port,
         mbedtls_ssl_conf_authmode(n->conf, MBEDTLS_SSL_VERIFY_NONE);
 	mbedtls_ssl_conf_read_timeout(n->conf, TLS_RECV_TIMOUT_DEFAULT); /* recv timeout 9 min */
 
+#ifdef MBEDTLS_TRUST_STORE
+    if ((ret = mbedtls_trust_store_attach(n->trust, n->conf)) != 0 ) {
+        MQTT_PLATFORM_WARN( "failed ! mbedtls_ssl_conf_own_cert returned -0x%04x\n", -ret);
+        goto exit;
+    }
+#else
     mbedtls_ssl_conf_ca_chain(n->conf, n->cacertl, NULL);
 
     if ((ret = mbedtls_ssl_conf_own_cert(n->conf, n->clicert, n->pkey)) != 0 ) {
         MQTT_PLATFORM_WARN( "failed ! mbedtls_ssl_conf_own_cert returned -0x%04x\n", -ret);
         goto exit;
     }
+#endif
 
 //    mbedtls_ssl_conf_rng(n->conf, mqtt_ssl_random, n->ctr_drbg);
 	mbedtls_ssl_conf_rng(n->conf, mqtt_ssl_random, NULL);
@@ -701,6 +761,9 @@ int TLSConnectNetwork(Network *n, const char *addr, const char *port,
 		MQTT_PLATFORM_WARN( "failed ! mbedtls_ssl_set_hostname returned -0x%04x\n", -ret);
 		goto exit;
 	}
+#ifdef MBEDTLS_SESSION_STORE
+	mbedtls_session_store_resume(n->ssl, addr, atoi(port));
+#endif
 
     mbedtls_ssl_set_bio(n->ssl, n->fd, mbedtls_net_send, mbedtls_net_recv, mbedtls_net_recv_timeout);
 
@@ -710,6 +773,9 @@ int TLSConnectNetwork(Network *n, const char *addr, const char *port,
     while ((ret = mbedtls_ssl_handshake(n->ssl)) != 0) {
         if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
             MQTT_PLATFORM_WARN( " failed ! mbedtls_ssl_handshake returned -0x%04x\n", -ret);
+#ifdef MBEDTLS_SESSION_STORE
+            mbedtls_session_store_update(n->ssl, addr, atoi(port), ret);
+#endif
             goto exit;
         }
     }
@@ -734,6 +800,10 @@ int TLSConnectNetwork(Network *n, const char *addr, const char *port,
 #endif
 		}
     }
+#ifdef MBEDTLS_SESSION_STORE
+	/* after the verify step, the store keeps only verified sessions */
+    mbedtls_session_store_update(n->ssl, addr, atoi(port), 0);
+#endif
 
     n->my_socket = n->fd->fd;
     n->mqttread = mqtt_ssl_read;
@@ -748,9 +818,11 @@ exit:
 	mbedtls_ssl_config_free(n->conf);
 	mbedtls_entropy_free(n->entropy);
 	mbedtls_ctr_drbg_free(n->ctr_drbg);
+#ifndef MBEDTLS_TRUST_STORE
 	mbedtls_x509_crt_free(n->cacertl);
 	mbedtls_x509_crt_free(n->clicert);
 	mbedtls_pk_free(n->pkey);
+#endif
 
 	mqtt_ssl_network_deinit(n);
 
@@ -774,6 +774,45 @@ static void mbedtls_debug(void *ctx, int level,const char *file,
 	printf("%s:%04d: %s", file, line, str);
 }
 
+#if defined(NOPOLL_MBEDTLS) && defined(MBEDTLS_TRUST_STORE)
+/**
+ * @internal Configures the certificates and key of a TLS connection
+ * from the shared trust store, parsing them only if no other connection
+ * uses the same ones. The CA certificate is taken from options, if any.
+ */
+static nopoll_bool __nopoll_conn_ssl_trust (noPollCtx * ctx, noPollConn * conn,
+					    noPollConnOpts * options,
+					    const char * cert, int cert_size,
+					    const char * chain, int chain_size,
+					    const char * key, int key_size)
+{
+	mbedtls_trust_param param;
+
+	memset (&param, 0, sizeof (param));
+	if (options && options->ca_certificate) {
+		param.ca[0].buf = (const unsigned char *) options->ca_certificate;
+		param.ca[0].len = options->ca_certificate_size;
+	}
+	param.cert        = (const unsigned char *) cert;
+	param.cert_len    = cert ? cert_size : 0;
+	param.chain       = (const unsigned char *) chain;
+	param.chain_len   = chain ? chain_size : 0;
+	param.key         = (const unsigned char *) key;
+	param.key_len     = key ? key_size : 0;
+
+	conn->ssl_trust = mbedtls_trust_store_get (&param);
+	if (conn->ssl_trust == NULL) {
+		nopoll_log (ctx, NOPOLL_LEVEL_CRITICAL, "failed to parse certificates\n");
+		return nopoll_false;
+	}
+	if (mbedtls_trust_store_attach (conn->ssl_trust, conn->ssl_conf) != 0) {
+		nopoll_log (ctx, NOPOLL_LEVEL_CRITICAL, "mbedtls_ssl_conf_own_cert failed\n");
+		return nopoll_false;
+	}
+	return nopoll_true;
+}
+#endif
+
 /**
  * @internal Internal implementation used to do a connect.
  */
@@ -909,24 +948,32 @@ noPollConn * __nopoll_conn_new_common (noPollCtx       * ctx,
 		conn->fd_ctx		= nopoll_new(mbedtls_net_context, 1);
 		conn->ssl			= nopoll_new(mbedtls_ssl_context, 1);
 		conn->ssl_conf		= nopoll_new(mbedtls_ssl_config, 1);
+#if !defined(MBEDTLS_TRUST_STORE)
 		conn->ssl_cert		= nopoll_new(mbedtls_x509_crt, 1);
 		conn->ssl_ca_cert	= nopoll_new(mbedtls_x509_crt, 1);
 		conn->ssl_pkey		= nopoll_new(mbedtls_pk_context, 1);
+#endif
 		conn->ssl_entropy	= nopoll_new(mbedtls_entropy_context, 1);
 		conn->ssl_ctr_drbg	= nopoll_new(mbedtls_ctr_drbg_context, 1);
-		if (!(conn->ssl && conn->ssl_conf && conn->ssl_cert &&
-		    conn->ssl_pkey && conn->ssl_entropy && conn->ssl_ctr_drbg))
+		if (!(conn->ssl && conn->ssl_conf &&
+#if !defined(MBEDTLS_TRUST_STORE)
+		    conn->ssl_cert && conn->ssl_pkey &&
+#endif
+		    conn->ssl_entropy && conn->ssl_ctr_drbg))
 			goto fail_ssl_connection1;
 
 		mbedtls_ssl_init(conn->ssl);
 		mbedtls_ssl_config_init(conn->ssl_conf);
+#if !defined(MBEDTLS_TRUST_STORE)
 		mbedtls_x509_crt_init(conn->ssl_cert);
 		mbedtls_pk_init(conn->ssl_pkey);
+#endif
 		mbedtls_entropy_init(conn->ssl_entropy);
 		mbedtls_ctr_drbg_init(conn->ssl_ctr_drbg);
 		mbedtls_debug_set_threshold(3);
 		mbedtls_ssl_conf_dbg(conn->ssl_conf, mbedtls_debug, stdout );
 
+#if !defined(MBEDTLS_TRUST_STORE)
 		if (options && options->certificate) {
 			if (mbedtls_x509_crt_parse(conn->ssl_cert, (const unsigned char *)options->certificate, options->certificate_size) != 0) {
 				nopoll_log (ctx, NOPOLL_LEVEL_CRITICAL, "failed to parse certificate\n");
@@ -954,6 +1001,7 @@ noPollConn * __nopoll_conn_new_common (noPollCtx       * ctx,
 				goto fail_ssl_connection2;
 			}
 		}
+#endif
 
 		if (mbedtls_ctr_drbg_seed(conn->ssl_ctr_drbg, mbedtls_entropy_func, conn->ssl_entropy, (const unsigned char *)pers, strlen(pers)) != 0) {
 			nopoll_log (ctx, NOPOLL_LEVEL_CRITICAL, "mbedtls_ctr_drbg_seed failed\n");
@@ -971,12 +1019,23 @@ noPollConn * __nopoll_conn_new_common (noPollCtx       * ctx,
 			mbedtls_ssl_conf_authmode(conn->ssl_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
 
 		mbedtls_ssl_conf_rng(conn->ssl_conf, mbedtls_ctr_drbg_random, conn->ssl_ctr_drbg);
+#if defined(MBEDTLS_TRUST_STORE)
+		if (!__nopoll_conn_ssl_trust (ctx, conn, options,
+					      options ? options->certificate : NULL,
+					      options ? options->certificate_size : 0,
+					      options ? options->chain_certificate : NULL,
+					      options ? options->chain_certificate_size : 0,
+					      options ? options->private_key : NULL,
+					      options ? options->private_key_size : 0))
+			goto fail_ssl_connection2;
+#else
 		mbedtls_ssl_conf_ca_chain(conn->ssl_conf, conn->ssl_ca_cert, NULL);
 
 		if (mbedtls_ssl_conf_own_cert(conn->ssl_conf, conn->ssl_cert, conn->ssl_pkey ) != 0) {
 			nopoll_log (ctx, NOPOLL_LEVEL_CRITICAL, "mbedtls_ssl_conf_own_cert failed\n");
 			goto fail_ssl_connection2;
 		}
+#endif
 
 		if (mbedtls_ssl_setup(conn->ssl, conn->ssl_conf) != 0) {
 			nopoll_log (ctx, NOPOLL_LEVEL_CRITICAL, "mbedtls_ssl_setup failed\n");
@@ -990,6 +1049,9 @@ noPollConn * __nopoll_conn_new_common (noPollCtx       * ctx,
 #endif
 		conn->fd_ctx->fd = session;
 		mbedtls_ssl_set_bio(conn->ssl, conn->fd_ctx, mbedtls_net_send, mbedtls_net_recv, NULL );
+#ifdef MBEDTLS_SESSION_STORE
+		mbedtls_session_store_resume(conn->ssl, conn->host_name, atoi(conn->port));
+#endif
 
 		iterator = 0;
 		while (nopoll_true) {
@@ -1035,6 +1097,9 @@ noPollConn * __nopoll_conn_new_common (noPollCtx       * ctx,
 			}
 			if ((ssl_error != MBEDTLS_ERR_SSL_WANT_READ) && (ssl_error != MBEDTLS_ERR_SSL_WANT_WRITE)) {
 				nopoll_log (ctx, NOPOLL_LEVEL_CRITICAL, "mbedtls_ssl_handshake failed\n");
+#ifdef MBEDTLS_SESSION_STORE
+				mbedtls_session_store_update(conn->ssl, conn->host_name, atoi(conn->port), ssl_error);
+#endif
 				goto fail_ssl_connection2;
 			}
 
@@ -1059,8 +1124,14 @@ noPollConn * __nopoll_conn_new_common (noPollCtx       * ctx,
 
 		if (mbedtls_ssl_get_verify_result(conn->ssl) != 0) {
 			nopoll_log (ctx, NOPOLL_LEVEL_CRITICAL, "mbedtls_ssl_get_verify_result failed\n");
+#ifdef MBEDTLS_SESSION_STORE
+			mbedtls_session_store_update(conn->ssl, conn->host_name, atoi(conn->port), -1);
+#endif
 			goto fail_ssl_connection2;
 		}
+#ifdef MBEDTLS_SESSION_STORE
+		mbedtls_session_store_update(conn->ssl, conn->host_name, atoi(conn->port), 0);
+#endif
 #else
 		/* found TLS connection request, enable it */
 		conn->ssl_ctx  = __nopoll_conn_get_ssl_context (ctx, conn, options, nopoll_true);
@@ -2318,6 +2389,9 @@ void nopoll_conn_unref (noPollConn * conn)
 		mbedtls_pk_free(conn->ssl_pkey);
 		nopoll_free(conn->ssl_pkey);
 	}
+#if defined(MBEDTLS_TRUST_STORE)
+	mbedtls_trust_store_put(conn->ssl_trust);
+#endif
 	if (conn->ssl_entropy) {
 		mbedtls_entropy_free(conn->ssl_entropy);
 		nopoll_free(conn->ssl_entropy);
@@ -2378,8 +2452,10 @@ int nopoll_conn_default_send (noPollConn * conn, char * buffer, int buffer_size)
 #endif
 }
 
+void __nopoll_pack_content (char * buffer, int start, int bytes);
+
 /**
- * @internal Read the next line, byte by byte until it gets a \n or
+ * @internal Read the next line until it gets a \n or
  * maxlen is reached. Some code errors are used to manage exceptions
  * (see return values)
  *
@@ -2398,9 +2474,10 @@ int nopoll_conn_default_send (noPollConn * conn, char * buffer, int buffer_size)
  **/
 int          nopoll_conn_readline (noPollConn * conn, char  * buffer, int  maxlen)
 {
-	int         n, rc;
+	int         n, rc, iter;
 	int         desp;
 	char        c, *ptr;
+	nopoll_bool found;
 #if defined(SHOW_DEBUG_LOG)
 # if !defined(SHOW_FORMAT_BUGS)
 	noPollCtx * ctx = conn->ctx;
@@ -2431,45 +2508,61 @@ int          nopoll_conn_readline (noPollConn * conn, char  * buffer, int  maxle
 		conn->pending_line = NULL;
 	}
 
-	/* read current next line */
-	ptr = (buffer + desp);
-	for (n = 1; n < (maxlen - desp); n++) {
-	nopoll_readline_again:
-		if (( rc = conn->receive (conn, &c, 1)) == 1) {
-			*ptr++ = c;
-			if (c == '\x0A')
-				break;
-		}else if (rc == 0) {
-			if (n == 1)
-				return 0;
-			else
-				break;
-		} else {
-			if (errno == NOPOLL_EINTR)
-				goto nopoll_readline_again;
-			if ((errno == NOPOLL_EWOULDBLOCK) || (errno == NOPOLL_EAGAIN) || (rc == -2)) {
-				if (n > 0) {
+	/* read current next line: bytes are taken from the connection
+	 * read-ahead buffer (pending_buf), which is refilled with as
+	 * much as the transport has ready instead of one byte per
+	 * receive call. Bytes left after the end of the handshake stay
+	 * there and are served first by __nopoll_conn_receive. */
+	ptr   = (buffer + desp);
+	n     = 0;
+	found = nopoll_false;
+	while (! found && n < (maxlen - desp - 1)) {
+		if (conn->pending_buf_bytes == 0) {
+		nopoll_readline_again:
+			rc = conn->receive (conn, conn->pending_buf, sizeof (conn->pending_buf));
+			if (rc == 0) {
+				if (n == 0)
+					return 0;
+				else
+					break;
+			} else if (rc < 0) {
+				if (errno == NOPOLL_EINTR)
+					goto nopoll_readline_again;
+				if ((errno == NOPOLL_EWOULDBLOCK) || (errno == NOPOLL_EAGAIN) || (rc == -2)) {
 					/* store content read until now */
-					if ((n + desp - 1) > 0) {
-						buffer[n+desp - 1] = 0;
+					if ((n + desp) > 0) {
+						buffer[n + desp] = 0;
 						conn->pending_line = nopoll_strdup (buffer);
 					} /* end if */
-				} /* end if */
-				return -2;
-			}
+					return -2;
+				}
 
-			if (nopoll_conn_is_ok (conn) && errno == 0 && rc == 0) {
-				nopoll_log (ctx, NOPOLL_LEVEL_WARNING, "unable to read line, but errno is 0, and connection is ok, return to keep on trying..");
-				return -2;
+				/* if the conn is closed, just return
+				 * without logging a message */
+				nopoll_log (ctx, NOPOLL_LEVEL_CRITICAL, "unable to read line, error code errno: %d, rc: %d (%s)",
+					    errno, rc, strerror (errno));
+				return (-1);
+			} /* end if */
+
+			conn->pending_buf_bytes = rc;
+		} /* end if */
+
+		/* copy up to the end of line or the space available */
+		for (iter = 0; iter < conn->pending_buf_bytes && n < (maxlen - desp - 1); iter++) {
+			c      = conn->pending_buf[iter];
+			*ptr++ = c;
+			n++;
+			if (c == '\x0A') {
+				iter++;
+				found = nopoll_true;
+				break;
 			}
+		} /* end for */
 
-			/* if the conn is closed, just return
-			 * without logging a message */
-			nopoll_log (ctx, NOPOLL_LEVEL_CRITICAL, "unable to read line, error code errno: %d, rc: %d (%s)",
-				    errno, rc, strerror (errno));
-			return (-1);
-		}
-	}
+		/* drop consumed bytes from the read-ahead buffer */
+		__nopoll_pack_content (conn->pending_buf, iter, conn->pending_buf_bytes - iter);
+		conn->pending_buf_bytes -= iter;
+	} /* end while */
 	*ptr = 0;
 	return (n + desp);
 
@@ -3211,11 +3304,56 @@ void nopoll_conn_complete_handshake (noPollConn * conn)
 	return;
 }
 
+/**
+ * @internal Machine word used to apply the websocket mask several
+ * bytes at a time.
+ */
+#if defined(NOPOLL_64BIT_PLATFORM)
+typedef unsigned long long noPollMaskWord;
+#else
+typedef unsigned int       noPollMaskWord;
+#endif
+
 void nopoll_conn_mask_content (noPollCtx * ctx, char * payload, int payload_size, char * mask, int desp)
 {
-	int iter       = 0;
-	int mask_index = 0;
+	int              iter       = 0;
+	int              mask_index = 0;
+	noPollMaskWord   mask_word;
+	noPollMaskWord * word;
+	char             rotated[sizeof (noPollMaskWord)];
+
+	/* apply byte by byte until the payload is word aligned */
+	while (iter < payload_size && (((unsigned long) (payload + iter)) & (sizeof (noPollMaskWord) - 1))) {
+		mask_index = (iter + desp) % 4;
+		payload[iter] ^= mask[mask_index];
+		iter++;
+	} /* end while */
+
+	if ((payload_size - iter) >= (int) sizeof (noPollMaskWord)) {
+		/* build a word holding the mask rotated to the current
+		 * position, laid out in memory order so it works on
+		 * any endianness */
+		for (mask_index = 0; mask_index < (int) sizeof (noPollMaskWord); mask_index++)
+			rotated[mask_index] = mask[(iter + desp + mask_index) % 4];
+		memcpy (&mask_word, rotated, sizeof (noPollMaskWord));
+
+		word = (noPollMaskWord *) (payload + iter);
+		while ((payload_size - iter) >= (int) (4 * sizeof (noPollMaskWord))) {
+			word[0] ^= mask_word;
+			word[1] ^= mask_word;
+			word[2] ^= mask_word;
+			word[3] ^= mask_word;
+			word    += 4;
+			iter    += 4 * sizeof (noPollMaskWord);
+		} /* end while */
+
+		while ((payload_size - iter) >= (int) sizeof (noPollMaskWord)) {
+			*word++ ^= mask_word;
+			iter    += sizeof (noPollMaskWord);
+		} /* end while */
+	} /* end if */
 
+	/* remaining tail bytes */
 	while (iter < payload_size) {
 		/* rotate mask and apply it */
 		mask_index = (iter + desp) % 4;
@@ -4550,6 +4688,150 @@ int nopoll_conn_flush_writes (noPollConn * conn, long timeout, int previous_resu
 }
 
 
+/**
+ * @internal Writes the provided buffer retrying on partial writes the
+ * same way nopoll_conn_send_frame does. Returns the amount of bytes
+ * written, which is lower than buffer_size when the socket stopped
+ * accepting data (errno is set) or the retries were exhausted.
+ */
+int __nopoll_conn_send_chunk (noPollConn * conn, const char * buffer, int buffer_size)
+{
+	int written = 0;
+	int result;
+	int tries   = 0;
+
+	while (written < buffer_size) {
+		result = conn->send (conn, (char *) buffer + written, buffer_size - written);
+		if (result > 0)
+			written += result;
+		if (written == buffer_size)
+			break;
+
+		/* increase tries */
+		tries++;
+
+		if ((errno != 0) || tries > 50) {
+			nopoll_log (conn->ctx, NOPOLL_LEVEL_WARNING, "Found errno=%d (%s) value while trying to bytes to the WebSocket conn-id=%d or max tries reached=%d",
+				    errno, strerror (errno), conn->id, tries);
+			break;
+		} /* end if */
+
+		/* wait a bit */
+		nopoll_sleep (100000);
+	} /* end while */
+
+	return written;
+}
+
+/**
+ * @internal Sends a frame without copying the whole payload into a
+ * new buffer.
+ *
+ * The header and the first payload bytes are placed into a small
+ * staging buffer so short frames still leave in a single send
+ * operation (and a single record under TLS). The rest of an unmasked
+ * payload is written straight from the caller buffer, while a masked
+ * payload is masked chunk by chunk into the staging buffer. Only if
+ * the transport stops accepting data, the unsent tail of the frame is
+ * copied into conn->pending_write to be completed later by \ref
+ * nopoll_conn_complete_pending_write.
+ *
+ * Return values are the same as nopoll_conn_send_frame.
+ */
+int __nopoll_conn_send_frame_gather (noPollConn * conn, const char * header, int header_size,
+				     char * mask, long length, const char * content)
+{
+	char          staging[NOPOLL_SEND_STAGING_SIZE];
+	const char  * chunk;
+	long          chunk_size;
+	long          chunk_payload;
+	long          offset  = 0; /* payload bytes handed to the transport */
+	long          desp    = 0; /* frame bytes written */
+	long          remain;
+	int           written;
+	int           bytes_sent;
+	char        * pending;
+
+	/* first chunk: header plus the payload that fits */
+	chunk_payload = NOPOLL_SEND_STAGING_SIZE - header_size;
+	if (chunk_payload > length)
+		chunk_payload = length;
+	memcpy (staging, header, header_size);
+	if (chunk_payload > 0) {
+		memcpy (staging + header_size, content, chunk_payload);
+		if (mask)
+			nopoll_conn_mask_content (conn->ctx, staging + header_size, chunk_payload, mask, 0);
+	} /* end if */
+	chunk      = staging;
+	chunk_size = header_size + chunk_payload;
+
+	while (nopoll_true) {
+		written = __nopoll_conn_send_chunk (conn, chunk, chunk_size);
+		desp   += written;
+		offset += chunk_payload;
+
+		if (written != chunk_size)
+			break;
+
+		if (offset == length)
+			break;
+
+		/* next chunk */
+		chunk_payload = length - offset;
+		if (mask) {
+			if (chunk_payload > NOPOLL_SEND_STAGING_SIZE)
+				chunk_payload = NOPOLL_SEND_STAGING_SIZE;
+			memcpy (staging, content + offset, chunk_payload);
+			nopoll_conn_mask_content (conn->ctx, staging, chunk_payload, mask, offset);
+			chunk = staging;
+		} else {
+			chunk = content + offset;
+		} /* end if */
+		chunk_size = chunk_payload;
+	} /* end while */
+
+	/* record pending write bytes */
+	conn->pending_write_bytes = length + header_size - desp;
+	conn->pending_write_added_header = header_size;
+
+	/* record and report useful userland payload's bytes sent */
+	bytes_sent = 0;
+	if ((desp - header_size) > 0) {
+		bytes_sent = (desp - header_size);
+		conn->pending_write_added_header = 0;
+	} /* end if */
+
+	nopoll_log (conn->ctx, NOPOLL_LEVEL_DEBUG, "Gathered write finished, bytes-sent=%d, desp=%d, header_size=%d, requested=%d (length), remaining=%d, errno=%d (conn-id=%d)",
+		    bytes_sent, (int) desp, header_size, (int) length, conn->pending_write_bytes, errno, conn->id);
+
+	if (conn->pending_write_bytes > 0) {
+		/* copy the unsent tail: rest of the last chunk plus the
+		 * payload not handed to the transport yet */
+		pending = nopoll_new (char, conn->pending_write_bytes);
+		if (pending == NULL) {
+			nopoll_log (conn->ctx, NOPOLL_LEVEL_CRITICAL, "Unable to allocate memory to store pending write");
+			conn->pending_write_bytes = 0;
+			return -1;
+		} /* end if */
+		remain = chunk_size - written;
+		memcpy (pending, chunk + written, remain);
+		if (offset < length) {
+			memcpy (pending + remain, content + offset, length - offset);
+			if (mask)
+				nopoll_conn_mask_content (conn->ctx, pending + remain, length - offset, mask, offset);
+		} /* end if */
+		conn->pending_write      = pending;
+		conn->pending_write_desp = 0;
+	} /* end if */
+
+	/* if no byte was sent and errno is set to non-blocking error
+	   operation that indicates a retry, report -2 */
+	if (bytes_sent == 0 && errno == NOPOLL_EWOULDBLOCK)
+	        return -2;
+
+	return bytes_sent;
+}
+
 /**
  * @internal Function used to send a frame over the provided
  * connection.
@@ -4665,6 +4947,12 @@ int nopoll_conn_send_frame (noPollConn * conn, nopoll_bool fin, nopoll_bool mask
 		header_size += 4;
 	} /* end if */
 
+	/* regular case: send header and payload without building a
+	 * full copy of the frame (the debug paths below still use the
+	 * copying implementation) */
+	if (sleep_in_header == 0 && conn->__force_stop_after_header <= 0)
+		return __nopoll_conn_send_frame_gather (conn, header, header_size, masked ? mask : NULL, length, (const char *) content);
+
 	/* allocate enough memory to send content */
 	send_buffer = nopoll_new (char, length + header_size + 2);
 	if (send_buffer == NULL) {
@@ -5029,23 +5317,31 @@ nopoll_bool __nopoll_conn_accept_complete_common (noPollCtx * ctx, noPollConnOpt
 		conn->fd_ctx		= nopoll_new(mbedtls_net_context, 1);
 		conn->ssl			= nopoll_new(mbedtls_ssl_context, 1);
 		conn->ssl_conf		= nopoll_new(mbedtls_ssl_config, 1);
+#if !defined(MBEDTLS_TRUST_STORE)
 		conn->ssl_cert		= nopoll_new(mbedtls_x509_crt, 1);
 		conn->ssl_ca_cert	= nopoll_new(mbedtls_x509_crt, 1);
 		conn->ssl_pkey		= nopoll_new(mbedtls_pk_context, 1);
+#endif
 		conn->ssl_entropy	= nopoll_new(mbedtls_entropy_context, 1);
 		conn->ssl_ctr_drbg	= nopoll_new(mbedtls_ctr_drbg_context, 1);
-		if (!(conn->ssl && conn->ssl_conf && conn->ssl_cert &&
-		    conn->ssl_pkey && conn->ssl_entropy && conn->ssl_ctr_drbg))
+		if (!(conn->ssl && conn->ssl_conf &&
+#if !defined(MBEDTLS_TRUST_STORE)
+		    conn->ssl_cert && conn->ssl_pkey &&
+#endif
+		    conn->ssl_entropy && conn->ssl_ctr_drbg))
 			goto exit1;
 
 		mbedtls_ssl_init(conn->ssl);
 		mbedtls_ssl_config_init(conn->ssl_conf);
+#if !defined(MBEDTLS_TRUST_STORE)
 		mbedtls_x509_crt_init(conn->ssl_cert);
 		mbedtls_pk_init(conn->ssl_pkey);
+#endif
 		mbedtls_entropy_init(conn->ssl_entropy);
 		mbedtls_ctr_drbg_init(conn->ssl_ctr_drbg);
 		mbedtls_debug_set_threshold(3);
 		mbedtls_ssl_conf_dbg(conn->ssl_conf, mbedtls_debug, stdout );
+#if !defined(MBEDTLS_TRUST_STORE)
 		if (mbedtls_x509_crt_parse(conn->ssl_cert, (const unsigned char *)certificateFile, certificateFile_size) != 0) {
 			nopoll_log (ctx, NOPOLL_LEVEL_CRITICAL, "failed to parse certificateFile\n");
 			goto exit2;
@@ -5069,6 +5365,7 @@ nopoll_bool __nopoll_conn_accept_complete_common (noPollCtx * ctx, noPollConnOpt
 			nopoll_log (ctx, NOPOLL_LEVEL_CRITICAL, "failed to parse privateKey\n");
 			goto exit2;
 		}
+#endif
 
 		if (mbedtls_ctr_drbg_seed(conn->ssl_ctr_drbg, mbedtls_entropy_func, conn->ssl_entropy, (const unsigned char *)pers, strlen(pers)) != 0) {
 			nopoll_log (ctx, NOPOLL_LEVEL_CRITICAL, "mbedtls_ctr_drbg_seed failed\n");
@@ -5086,12 +5383,20 @@ nopoll_bool __nopoll_conn_accept_complete_common (noPollCtx * ctx, noPollConnOpt
 			mbedtls_ssl_conf_authmode(conn->ssl_conf, MBEDTLS_SSL_VERIFY_NONE);
 
 		mbedtls_ssl_conf_rng(conn->ssl_conf, mbedtls_ctr_drbg_random, conn->ssl_ctr_drbg);
+#if defined(MBEDTLS_TRUST_STORE)
+		if (!__nopoll_conn_ssl_trust (ctx, conn, options,
+					      certificateFile, certificateFile_size,
+					      chainCertificate, chainCertificate_size,
+					      privateKey, privateKey_size))
+			goto exit2;
+#else
 		mbedtls_ssl_conf_ca_chain(conn->ssl_conf, conn->ssl_ca_cert, NULL);
 
 		if (mbedtls_ssl_conf_own_cert(conn->ssl_conf, conn->ssl_cert, conn->ssl_pkey ) != 0) {
 			nopoll_log (ctx, NOPOLL_LEVEL_CRITICAL, "mbedtls_ssl_conf_own_cert failed\n");
 			goto exit2;
 		}
+#endif
 
 		if (mbedtls_ssl_setup(conn->ssl, conn->ssl_conf) != 0) {
 			nopoll_log (ctx, NOPOLL_LEVEL_CRITICAL, "mbedtls_ssl_setup failed\n");
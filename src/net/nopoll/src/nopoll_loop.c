@@ -99,6 +99,20 @@ void nopoll_loop_process_data (noPollCtx * ctx, noPollConn * conn)
 	return;
 }
 
+/**
+ * @internal Function used to serve connections that already hold a
+ * complete frame header in their read-ahead buffer (bytes received
+ * together with the end of the handshake). The io wait mechanism will
+ * not report them because those bytes are no longer in the socket.
+ */
+nopoll_bool nopoll_loop_process_buffered (noPollCtx * ctx, noPollConn * conn, noPollPtr user_data)
+{
+	if (nopoll_conn_is_ok (conn) && conn->handshake_ok && conn->pending_buf_bytes >= 2)
+		nopoll_loop_process_data (ctx, conn);
+
+	return nopoll_false; /* keep foreach, don't stop */
+}
+
 /**
  * @internal Function used to detected which connections has something
  * interesting to be notified.
@@ -217,6 +231,9 @@ int nopoll_loop_wait (noPollCtx * ctx, long timeout)
 	ctx->keep_looping = nopoll_true;
 
 	while (ctx->keep_looping) {
+		/* first serve content already buffered */
+		nopoll_ctx_foreach_conn (ctx, nopoll_loop_process_buffered, NULL);
+
 		/* ok, now implement wait operation */
 		ctx->io_engine->clear (ctx, ctx->io_engine->io_object);
 
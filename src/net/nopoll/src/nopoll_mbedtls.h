@@ -49,6 +49,10 @@
 #include <mbedtls/x509_crt.h>
 #include <mbedtls/entropy.h>
 #include <mbedtls/ctr_drbg.h>
+#if (__CONFIG_MBEDTLS_VER == 0x02100000)
+#include <mbedtls/session_store.h>
+#include <mbedtls/trust_store.h>
+#endif
 
 #ifndef EVP_MAX_MD_SIZE
 #define EVP_MAX_MD_SIZE	20
@@ -292,6 +292,9 @@ struct _noPollConn {
 	mbedtls_x509_crt *ssl_cert; //The own certificate chain
 	mbedtls_x509_crt *ssl_ca_cert; //The ca certificate
 	mbedtls_pk_context *ssl_pkey;
+#if defined(MBEDTLS_TRUST_STORE)
+	mbedtls_trust_store *ssl_trust; //The certificates and key instead of the above, shared
+#endif
 	mbedtls_entropy_context *ssl_entropy;
 	mbedtls_ctr_drbg_context *ssl_ctr_drbg;
 #else
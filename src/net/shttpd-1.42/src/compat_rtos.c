@@ -34,6 +34,10 @@ struct local {
 	const char      *name;
 	char            *body;
 	unsigned long	mode;
+	unsigned long	size;           /* body length, computed once */
+	unsigned long	etag;           /* body hash, computed once */
+	char            *gz_body;
+	unsigned long	gz_size;
 };
 
 struct llhead	registered_file;
@@ -63,6 +67,19 @@ void *_shttpd_zalloc(size_t size)
 	return buf;
 }
 
+/* FNV-1a hash of the file body, stable across reboots for the ETag */
+static unsigned long local_file_hash(const char *body, unsigned long size)
+{
+	unsigned long hash = 2166136261UL;
+	unsigned long i;
+
+	for (i = 0; i < size; i++) {
+		hash ^= (unsigned char)body[i];
+		hash *= 16777619UL;
+	}
+	return hash & 0xffffffffUL;
+}
+
 void _shttpd_init_local_file(const struct usr_file *list, int count)
 {
 	if (list == NULL || count == 0) {
@@ -83,8 +100,15 @@ void _shttpd_init_local_file(const struct usr_file *list, int count)
 			file->name = list[i].name;
 			file->mode = (file->name[strlen(file->name)-1]
 				             == '/')? _S_IFDIR : _S_IFREG;
-			if (file->mode == _S_IFREG)
+			if (file->mode == _S_IFREG) {
 				file->body = list[i].body;
+				file->size = strlen(file->body);
+				file->etag = local_file_hash(file->body, file->size);
+				if (list[i].gz_body != NULL && list[i].gz_size > 0) {
+					file->gz_body = list[i].gz_body;
+					file->gz_size = list[i].gz_size;
+				}
+			}
 		} else
 			break;
 		LL_ADD(&registered_file, &file->link);
@@ -114,6 +138,10 @@ int _shttpd_add_file(struct local *file)
 					 strlen(local_file->name) + 1) == 0)
 			return -1;
 	}
+	if (file->mode == _S_IFREG && file->body != NULL) {
+		file->size = strlen(file->body);
+		file->etag = local_file_hash(file->body, file->size);
+	}
 	LL_ADD(&registered_file, &file->link);
 	return 0;
 }
@@ -143,6 +171,11 @@ int _shttpd_lookup_file(struct local **file, const char *name)
 	LL_FOREACH(&registered_file, lp) {
 		local_file = LL_ENTRY(lp, struct local, link);
 		if (_shttpd_strncasecmp(local_file->name, name, strlen(local_file->name) +1) == 0) {
+			/* keep the list in LRU order so hot assets are found first */
+			if (lp != registered_file.next) {
+				LL_DEL(lp);
+				LL_ADD(&registered_file, lp);
+			}
 			*file = local_file;
 			return 0;
 		}
@@ -162,10 +195,17 @@ int _shttpd_stat(const char *path, struct stat *stp)
 		return -1;
 	 }
 	stp->st_mode = file->mode;
-	if (stp->st_mode == _S_IFREG)
-		stp->st_size = strlen(file->body);
-	else
+	if (stp->st_mode == _S_IFREG) {
+		stp->st_size = file->size;
+		stp->st_etag = file->etag;
+		stp->st_gz_body = file->gz_body;
+		stp->st_gz_size = file->gz_size;
+	} else {
 		stp->st_size = 0;
+		stp->st_etag = 0;
+		stp->st_gz_body = NULL;
+		stp->st_gz_size = 0;
+	}
 	return 0;
 }
 
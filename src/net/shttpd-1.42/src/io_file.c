@@ -113,12 +113,72 @@ close_file(struct stream *stream)
 #endif
 }
 
+#if !defined(SHTTPD_FS)
+/*
+ * Check whether the If-None-Match request header lists our entity tag
+ */
+static int
+etag_matches(const struct conn *c, const char *etag)
+{
+	const struct vec	*inm = &c->ch.inm.v_vec;
+	size_t			len = strlen(etag);
+	int			i;
+
+	for (i = 0; i < inm->len; i++) {
+		if (inm->ptr[i] == '*')
+			return (1);
+		if (inm->ptr[i] == '"' && i + len + 2 <= (size_t) inm->len &&
+		    memcmp(inm->ptr + i + 1, etag, len) == 0 &&
+		    inm->ptr[i + len + 1] == '"')
+			return (1);
+	}
+
+	return (0);
+}
+
+/*
+ * Check whether the client accepts a gzip encoded response
+ */
+static int
+accepts_gzip(const struct conn *c)
+{
+	const struct vec	*ae = &c->ch.ae.v_vec;
+	int			i;
+
+	for (i = 0; i + 4 <= ae->len; i++)
+		if (_shttpd_strncasecmp(ae->ptr + i, "gzip", 4) == 0)
+			return (1);
+
+	return (0);
+}
+
+/*
+ * Reply "304 Not Modified" without a body, the client cache is valid
+ */
+static void
+send_not_modified(struct conn *c, const char *etag)
+{
+	io_clear(&c->loc.io);
+	c->loc.io.head = c->loc.headers_len = _shttpd_snprintf(c->loc.io.buf,
+	    c->loc.io.size,
+	    "HTTP/1.1 304 Not Modified\r\n"
+	    "Etag: \"%s\"\r\n"
+	    "\r\n",
+	    etag);
+	c->loc.content_len = 0;
+	c->status = 304;
+	_shttpd_stop_stream(&c->loc);
+}
+#endif /* !SHTTPD_FS */
+
 void
 _shttpd_get_file(struct conn *c, struct stat *stp)
 {
 	char		date[64], lm[64], etag[64], range[64] = "";
 	size_t	 status = 200;
 	const char	*fmt = "%a, %d %b %Y %H:%M:%S GMT", *msg = "OK";
+	const char	*encoding = "";
+	int		gzipped = 0;
 	big_int_t	cl = 0; /* Content-Length */
 
 	if (c->mime_type.len == 0)
@@ -126,6 +186,34 @@ _shttpd_get_file(struct conn *c, struct stat *stp)
 		    strlen(c->uri), &c->mime_type);
 	cl = (big_int_t) stp->st_size;
 
+#if !defined(SHTTPD_FS)
+	/* Serve the precompressed body to clients that accept it */
+	if (stp->st_gz_body != NULL) {
+		if (accepts_gzip(c)) {
+			c->loc.chan.fh = (unsigned int) stp->st_gz_body;
+			cl = (big_int_t) stp->st_gz_size;
+			gzipped = 1;
+			encoding = "Content-Encoding: gzip\r\n"
+			    "Vary: Accept-Encoding\r\n";
+		} else {
+			encoding = "Vary: Accept-Encoding\r\n";
+		}
+	}
+
+	/*
+	 * The ETag is a hash of the file body computed when the file was
+	 * registered, so it stays valid across requests and reboots.
+	 * Each encoding is a separate representation with its own tag.
+	 */
+	(void) _shttpd_snprintf(etag, sizeof(etag), "%08lx.%lx%s",
+		stp->st_etag, (unsigned long) stp->st_size,
+		gzipped ? "-gz" : "");
+	if (c->ch.inm.v_vec.len > 0 && etag_matches(c, etag)) {
+		send_not_modified(c, etag);
+		return;
+	}
+#endif
+
 #if defined(SHTTPD_RANGE)
 	size_t		n
 	unsigned long	r1, r2;
@@ -156,9 +244,6 @@ _shttpd_get_file(struct conn *c, struct stat *stp)
 #if defined(SHTTPD_FS)
 	(void) _shttpd_snprintf(etag, sizeof(etag), "%lx.%lx",
 	    (unsigned long) stp->st_mtime, (unsigned long) stp->st_size);
-#else
-	(void) _shttpd_snprintf(etag, sizeof(etag), "%lx.%lx",
-		(unsigned long)_shttpd_current_time, (unsigned long) stp->st_size);
 #endif
 
 	/*
@@ -175,9 +260,9 @@ _shttpd_get_file(struct conn *c, struct stat *stp)
 	    "Content-Type: %.*s\r\n"
 	    "Content-Length: %lu\r\n"
 	    "Accept-Ranges: bytes\r\n"
-	    "%s\r\n",
+	    "%s%s\r\n",
 	    status, msg, date, lm, etag,
-	    c->mime_type.len, c->mime_type.ptr, cl, range);
+	    c->mime_type.len, c->mime_type.ptr, cl, encoding, range);
 
 	c->status = status;
 	c->loc.content_len = cl;
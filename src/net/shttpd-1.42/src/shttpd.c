@@ -48,6 +48,8 @@ static const struct http_header http_headers[] = {
 	{7,  HDR_STRING, OFFSET(range),		"Range: "		},
 	{12, HDR_STRING, OFFSET(connection),	"Connection: "		},
 	{19, HDR_STRING, OFFSET(transenc),	"Transfer-Encoding: "	},
+	{15, HDR_STRING, OFFSET(inm),		"If-None-Match: "	},
+	{17, HDR_STRING, OFFSET(ae),		"Accept-Encoding: "	},
 	{0,  HDR_INT,	 0,			NULL			}
 };
 
@@ -1036,6 +1038,44 @@ write_stream(struct stream *from, struct stream *to)
 		_shttpd_stop_stream(to);
 }
 
+#if !defined(SHTTPD_FS)
+/*
+ * Files live in memory, so their body is handed to the socket straight
+ * from where it is stored instead of being copied through the local
+ * stream buffer first. Only the HTTP headers use the stream buffer.
+ */
+static void
+write_file_direct(struct conn *c)
+{
+	struct stream	*loc = &c->loc;
+	const char	*body = (const char *) loc->chan.fh;
+	int		n, len;
+
+	/* Send pending HTTP headers first */
+	if (io_data_len(&loc->io) > 0)
+		write_stream(loc, &c->rem);
+	if (io_data_len(&loc->io) > 0 || !(loc->flags & FLAG_R))
+		return;
+
+	len = loc->content_len - loc->io.total;
+	if (len > 0) {
+		n = c->rem.io_class->io_write(&c->rem, body + loc->io.total, len);
+		c->expire_time = _shttpd_current_time + EXPIRE_TIME;
+		DBG(("write_file_direct (%d): written %d/%d bytes (ERRNO %d)",
+		    c->rem.chan.sock, n, len, ERRNO));
+		if (n > 0)
+			loc->io.total += n;
+		else if (n == -1 && (ERRNO == EINTR || ERRNO == EWOULDBLOCK))
+			n = n;	/* Ignore EINTR and EAGAIN */
+		else if (!(c->rem.flags & FLAG_DONT_CLOSE))
+			_shttpd_stop_stream(&c->rem);
+	}
+
+	if (loc->io.total >= loc->content_len)
+		_shttpd_stop_stream(loc);
+}
+#endif /* !SHTTPD_FS */
+
 static void
 connection_desctructor(struct llhead *lp)
 {
@@ -1161,6 +1201,12 @@ process_connection(struct conn *c, int remote_ready, int local_ready)
 	    (int) io_data_len(&c->rem.io), io_data(&c->rem.io)));
 
 	/* Read from the local end if it is ready */
+#if !defined(SHTTPD_FS)
+	if (local_ready && c->loc.io_class == &_shttpd_io_file &&
+	    (c->loc.flags & FLAG_R) && c->rem.io_class != NULL) {
+		write_file_direct(c);
+	} else
+#endif
 	if (local_ready && io_space_len(&c->loc.io)) {
 		read_stream(&c->loc);
 	}
@@ -1255,6 +1301,19 @@ multiplex_worker_sockets(const struct worker *worker, int *max_fd,
 #endif
 		}
 
+#if !defined(SHTTPD_FS)
+		/*
+		 * In-memory files are written straight to the remote socket
+		 * (see write_file_direct), so wait for it to become writable
+		 * instead of spinning.
+		 */
+		if (c->loc.io_class == &_shttpd_io_file &&
+		    (c->loc.flags & FLAG_R)) {
+			add_to_set(c->rem.chan.sock, write_set, max_fd);
+			continue;
+		}
+#endif
+
 #if defined(SHTTPD_CGI)
 		/*
 		 * If there is a space in local IO, and local endpoint is
@@ -48,28 +48,18 @@
 #define ARPOP_REQUEST		ARP_REQUEST
 #endif
 
-/* FIXME: match response against chaddr */
-int   arpping(u_int32_t yiaddr, u_int32_t ip, unsigned char *mac, char *interface)
-{
-	int	timeout = 2;
-	int 	optval = 1;
-	int	s;			/* socket */
-	int	rv = 1;			/* return value */
-	//struct sockaddr addr;		/* for interface name */
-#ifdef DHCPD_ICMPPING
-	char icmp_buf[50];
-	struct icmp_echo_hdr *icmp_hdr = (struct icmp_echo_hdr *)icmp_buf;
-#else
-	struct arpMsg	arp;
-#endif
-	fd_set		fdset;
-	struct timeval	tm;
-	time_t		prevTime;
-#ifdef DHCPD_ICMPPING
-	struct sockaddr_in sl;
+#ifdef DHCPD_LWIP
+#define arpping_closesocket(s)	closesocket(s)
 #else
-	struct sockaddr_ll sl;
+#define arpping_closesocket(s)	close(s)
 #endif
+
+/* open the raw socket probes are sent and answered on, -1 on error */
+int arpping_open(void)
+{
+	int	optval = 1;
+	int	s;			/* socket */
+
 #ifdef DHCPD_ICMPPING
 	if ((s = socket(AF_INET, SOCK_RAW, IPPROTO_ICMP)) == -1) {
 #else
@@ -81,13 +71,31 @@ int   arpping(u_int32_t yiaddr, u_int32_t ip, unsigned char *mac, char *interfac
 
 	if (setsockopt(s, SOL_SOCKET, SO_BROADCAST, &optval, sizeof(optval)) == -1) {
 		DHCPD_LOG(LOG_ERR, "arp:Could not setsocketopt on raw socket");
-#ifdef DHCPD_LWIP
-		closesocket(s);
-#else
-		close(s);
-#endif
+		arpping_closesocket(s);
 		return -1;
 	}
+	return s;
+}
+
+
+void arpping_close(int s)
+{
+	arpping_closesocket(s);
+}
+
+
+/* send one probe for yiaddr, 0 on success */
+int arpping_send(int s, u_int32_t yiaddr, u_int32_t ip, unsigned char *mac)
+{
+#ifdef DHCPD_ICMPPING
+	char icmp_buf[50];
+	struct icmp_echo_hdr *icmp_hdr = (struct icmp_echo_hdr *)icmp_buf;
+	struct sockaddr_in sl;
+#else
+	struct arpMsg	arp;
+	struct sockaddr_ll sl;
+#endif
+
 	DHCPD_LOG(LOG_INFO, "arp : check ip %s\n", inet_ntoa(yiaddr));
 	/* send arp request */
 #ifdef DHCPD_ICMPPING
@@ -133,25 +141,68 @@ int   arpping(u_int32_t yiaddr, u_int32_t ip, unsigned char *mac, char *interfac
 	memcpy(arp.tInaddr,(char *)&yiaddr, 4);
 #endif
 #endif
-	//memset(&addr, 0, sizeof(addr));
-	//strcpy(addr.sa_data, interface);
-	//if (sendto(s, &arp, sizeof(arp), 0, &addr, sizeof(addr)) < 0)
 	memset(&sl, 0, sizeof(sl));
 #ifdef DHCPD_ICMPPING
 	sl.sin_len = sizeof(sl);
 	sl.sin_family = AF_INET;
-	sl.sin_addr.s_addr = htonl(INADDR_ANY);
+	sl.sin_addr.s_addr = yiaddr;
+	if (sendto(s, icmp_buf, sizeof(icmp_buf), 0, (struct sockaddr*)&sl, sizeof(sl)) < 0)
 #else
 	sl.sll_family = AF_PACKET;
-    	//sl.sll_addr = MAC_SOURCE;
-    	//sl.sll_halen = ETH_ALEN;
 	sl.sll_ifindex = 0x2;
+	if (sendto(s, &arp, sizeof(arp), 0, (struct sockaddr*)&sl, sizeof(sl)) < 0)
 #endif
+		return -1;
+	return 0;
+}
+
+
+/* read one packet off the probe socket.
+ * retn:	1 valid reply, *addr set to the address that answered
+ *		0 packet is not a reply to one of our probes
+ *		-1 error (or nothing queued with MSG_DONTWAIT)
+ */
+int arpping_recv(int s, unsigned char *mac, u_int32_t *addr, int flags)
+{
 #ifdef DHCPD_ICMPPING
-	if (sendto(s, icmp_buf, sizeof(icmp_buf), 0, (struct sockaddr*)&sl, sizeof(sl)) < 0)
+	char icmp_buf[50];
+	struct ip_hdr *iphdr = (struct ip_hdr *)icmp_buf;
+	struct icmp_echo_hdr *icmp_hdr;
+
+	if (recv(s, icmp_buf, sizeof(icmp_buf), flags) < 0)
+		return -1;
+	icmp_hdr = (struct icmp_echo_hdr *)(icmp_buf + IPH_HL(iphdr) * 4);
+	if (icmp_hdr->type != ICMP_ER)
+		return 0;
+	*addr = iphdr->src.addr;
 #else
-	if (sendto(s, &arp, sizeof(arp), 0, (struct sockaddr*)&sl, sizeof(sl)) < 0)
+	struct arpMsg	arp;
+
+	if (recv(s, &arp, sizeof(arp), flags) < 0)
+		return -1;
+	if (arp.operation != htons(ARP_REPLY) || bcmp(arp.tHaddr, mac, 6) != 0)
+		return 0;
+	memcpy(addr, arp.sInaddr, 4);
 #endif
+	return 1;
+}
+
+
+/* FIXME: match response against chaddr */
+int   arpping(u_int32_t yiaddr, u_int32_t ip, unsigned char *mac, char *interface)
+{
+	int	timeout = 2;
+	int	s;			/* socket */
+	int	rv = 1;			/* return value */
+	u_int32_t	from;
+	fd_set		fdset;
+	struct timeval	tm;
+	time_t		prevTime;
+
+	if ((s = arpping_open()) < 0)
+		return -1;
+
+	if (arpping_send(s, yiaddr, ip, mac) < 0)
 		rv = 0;
 
 	/* wait arp reply, and check it */
@@ -166,21 +217,9 @@ int   arpping(u_int32_t yiaddr, u_int32_t ip, unsigned char *mac, char *interfac
 			DEBUG(LOG_ERR, "Error on ARPING request: %s", strerror(errno));
 			if (errno != EINTR) rv = 0;
 		} else if (FD_ISSET(s, &fdset)) {
-#ifdef DHCPD_ICMPPING
-			if (recv(s, icmp_buf, sizeof(icmp_buf), 0) < 0 ) rv = 0;
-			struct ip_hdr *iphdr = (struct ip_hdr *)icmp_buf;
-			icmp_hdr = (struct icmp_echo_hdr *)(icmp_buf + IPH_HL(iphdr) * 4);
-#else
-			if (recv(s, &arp, sizeof(arp), 0) < 0 ) rv = 0;
-			u_int *tsInaddr = (u_int *)arp.sInaddr;
-#endif
-#ifdef DHCPD_ICMPPING
-			if (iphdr->src.addr == yiaddr && icmp_hdr->type == ICMP_ER) {
-#else
-			if (arp.operation == htons(ARP_REPLY) &&
-				bcmp(arp.tHaddr, mac, 6) == 0 &&
-				*(/*(u_int *) arp.sInaddr*/tsInaddr) == yiaddr) {
-#endif
+			int ret = arpping_recv(s, mac, &from, 0);
+			if (ret < 0) rv = 0;
+			if (ret == 1 && from == yiaddr) {
 				DEBUG(LOG_INFO, "Valid arp reply receved for this address");
 				rv = 0;
 				break;
@@ -190,11 +229,7 @@ int   arpping(u_int32_t yiaddr, u_int32_t ip, unsigned char *mac, char *interfac
 		time(&prevTime);
 
 	}
-#ifdef DHCPD_LWIP
-	closesocket(s);
-#else
-	close(s);
-#endif
+	arpping_closesocket(s);
 	DEBUG(LOG_INFO, "%salid arp replies for this address", rv ? "No v" : "V");
 	return rv;
 }
@@ -37,5 +37,9 @@ struct arpMsg {
 
 /* function prototypes */
 int arpping(u_int32_t yiaddr, u_int32_t ip, unsigned char *arp, char *interface);
+int arpping_open(void);
+void arpping_close(int s);
+int arpping_send(int s, u_int32_t yiaddr, u_int32_t ip, unsigned char *mac);
+int arpping_recv(int s, unsigned char *mac, u_int32_t *addr, int flags);
 
 #endif
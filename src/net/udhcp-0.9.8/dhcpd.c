@@ -116,6 +116,7 @@ int main(int argc, char *argv[])
 
 	leases = malloc(sizeof(struct dhcpOfferedAddr) * server_config.max_leases);
 	memset(leases, 0, sizeof(struct dhcpOfferedAddr) * server_config.max_leases);
+	init_leases_index();
 	read_leases(server_config.lease_file);
 
 	if (read_interface(server_config.interface, &server_config.ifindex,
@@ -250,7 +251,7 @@ int main(int argc, char *argv[])
 				if ((lease = find_lease_by_yiaddr(requested_align))) {
 					if (lease_expired(lease)) {
 						/* probably best if we drop this lease */
-						memset(lease->chaddr, 0, 16);
+						unbind_lease(lease);
 					/* make some contention for this address */
 					} else sendNAK(&packet);
 				} else if (requested_align < server_config.start ||
@@ -265,7 +266,7 @@ int main(int argc, char *argv[])
 		case DHCPDECLINE:
 			DEBUG(LOG_INFO,"received DECLINE");
 			if (lease) {
-				memset(lease->chaddr, 0, 16);
+				unbind_lease(lease);
 				lease->expires = time(0) + server_config.decline_time;
 				printf("%s,line:%d,lease->expires:%lu\n",__func__,__LINE__,lease->expires);
 			}
@@ -3,6 +3,7 @@
  * Russ Dill <Russ.Dill@asu.edu> July 2001
  */
 #include <string.h>
+#include <stdlib.h>
 
 #ifdef DHCPD_LWIP
 #include <lwip/sockets.h>
@@ -18,22 +19,211 @@
 #include <time.h>
 #endif
 
+#ifdef DHCPD_FREERTOS
+#include "kernel/os/os_time.h"
+#define probe_now_ms()	((u_int32_t)OS_TicksToMSecs(OS_GetTicks()))
+#else
+#define probe_now_ms()	((u_int32_t)time(0) * 1000)
+#endif
+
 #include "debug.h"
 #include "dhcpd.h"
 #include "files.h"
 #include "options.h"
 #include "leases.h"
 #include "arpping.h"
+#include "packet.h"
+#include "serverpacket.h"
 
 unsigned char blank_chaddr[] = {[0 ... 15] = 0};
 
+/*
+ * Lease index. Both hash tables chain through the lease array by index,
+ * entries are stored as index + 1 so that 0 terminates a chain. The address
+ * map has one bit per address of start..end, set while some lease (expired
+ * or not) holds that address. Without an index every lookup falls back to
+ * scanning the lease table.
+ */
+#define LEASE_NIL		0
+
+struct lease_index {
+	u_int32_t mask;			/* hash buckets - 1 */
+	u_int16_t *chaddr_head;
+	u_int16_t *chaddr_next;
+	u_int16_t *yiaddr_head;
+	u_int16_t *yiaddr_next;
+	u_int32_t map_base;		/* host order */
+	u_int32_t map_size;		/* addresses covered */
+	u_int32_t *map;
+};
+
+static struct lease_index *lindex;
+
+struct lease_probe {
+	u_int32_t addr;			/* network order, 0 if slot unused */
+	u_int32_t deadline;		/* probe_now_ms() */
+	struct dhcpMessage *packet;	/* DISCOVER to answer once settled */
+};
+
+static struct lease_probe probes[DHCPD_PROBE_MAX];
+static int probe_sock = -1;
+
+static int chaddr_blank(u_int8_t *chaddr)
+{
+	return !memcmp(chaddr, blank_chaddr, 16);
+}
+
+static u_int32_t chaddr_hash(u_int8_t *chaddr)
+{
+	u_int32_t h = 2166136261UL;
+	int i;
+
+	for (i = 0; i < 16; i++)
+		h = (h ^ chaddr[i]) * 16777619UL;
+	return h ^ (h >> 16);
+}
+
+static u_int32_t yiaddr_hash(u_int32_t yiaddr)
+{
+	u_int32_t h = ntohl(yiaddr) * 2654435761UL;
+
+	return h ^ (h >> 16);
+}
+
+static u_int16_t *chain_unlink(u_int16_t *pos, u_int16_t *next, u_int16_t id)
+{
+	while (*pos != LEASE_NIL) {
+		if (*pos == id) {
+			*pos = next[id - 1];
+			next[id - 1] = LEASE_NIL;
+			break;
+		}
+		pos = &next[*pos - 1];
+	}
+	return pos;
+}
+
+static int map_bit(u_int32_t yiaddr, u_int32_t *word, u_int32_t *bit)
+{
+	u_int32_t off = ntohl(yiaddr) - lindex->map_base;
+
+	if (off >= lindex->map_size)
+		return 0;
+	*word = off >> 5;
+	*bit = 1UL << (off & 31);
+	return 1;
+}
+
+/* drop a lease from the index, call before its chaddr/yiaddr change */
+static void lease_unlink(struct dhcpOfferedAddr *lease)
+{
+	u_int16_t id = (u_int16_t)(lease - leases) + 1;
+	u_int32_t word, bit;
+
+	if (!lindex)
+		return;
+	if (!chaddr_blank(lease->chaddr))
+		chain_unlink(&lindex->chaddr_head[chaddr_hash(lease->chaddr) & lindex->mask],
+		             lindex->chaddr_next, id);
+	if (lease->yiaddr) {
+		chain_unlink(&lindex->yiaddr_head[yiaddr_hash(lease->yiaddr) & lindex->mask],
+		             lindex->yiaddr_next, id);
+		if (map_bit(lease->yiaddr, &word, &bit) &&
+		    !find_lease_by_yiaddr(lease->yiaddr))
+			lindex->map[word] &= ~bit;
+	}
+}
+
+/* add a lease to the index, call after its chaddr/yiaddr changed */
+static void lease_link(struct dhcpOfferedAddr *lease)
+{
+	u_int16_t id = (u_int16_t)(lease - leases) + 1;
+	u_int16_t *head;
+	u_int32_t word, bit;
+
+	if (!lindex)
+		return;
+	if (!chaddr_blank(lease->chaddr)) {
+		head = &lindex->chaddr_head[chaddr_hash(lease->chaddr) & lindex->mask];
+		lindex->chaddr_next[id - 1] = *head;
+		*head = id;
+	}
+	if (lease->yiaddr) {
+		head = &lindex->yiaddr_head[yiaddr_hash(lease->yiaddr) & lindex->mask];
+		lindex->yiaddr_next[id - 1] = *head;
+		*head = id;
+		if (map_bit(lease->yiaddr, &word, &bit))
+			lindex->map[word] |= bit;
+	}
+}
+
+
+/* build the lookup index over leases[], must be called again whenever the
+ * table is reallocated. Failing to allocate only costs lookup speed. */
+int init_leases_index(void)
+{
+	u_int32_t buckets = 8, words, i;
+	u_int32_t start = ntohl(server_config.start), end = ntohl(server_config.end);
+	size_t size;
+
+	free_leases_index();
+	if (!leases || server_config.max_leases >= 0xffff || end < start)
+		return -1;
+
+	while (buckets < server_config.max_leases)
+		buckets <<= 1;
+	words = ((end - start) >> 5) + 1;
+	size = sizeof(struct lease_index) +
+	       (buckets * 2 + server_config.max_leases * 2) * sizeof(u_int16_t);
+	size = (size + 3) & ~3;
+
+	lindex = calloc(1, size + words * sizeof(u_int32_t));
+	if (!lindex) {
+		DHCPD_LOG(LOG_WARNING, "no mem for lease index");
+		return -1;
+	}
+	lindex->mask = buckets - 1;
+	lindex->chaddr_head = (u_int16_t *)(lindex + 1);
+	lindex->yiaddr_head = lindex->chaddr_head + buckets;
+	lindex->chaddr_next = lindex->yiaddr_head + buckets;
+	lindex->yiaddr_next = lindex->chaddr_next + server_config.max_leases;
+	lindex->map = (u_int32_t *)((char *)lindex + size);
+	lindex->map_base = start;
+	lindex->map_size = end - start + 1;
+
+	for (i = 0; i < server_config.max_leases; i++)
+		lease_link(&leases[i]);
+	return 0;
+}
+
+
+void free_leases_index(void)
+{
+	if (lindex) {
+		free(lindex);
+		lindex = NULL;
+	}
+}
+
+
 /* clear every lease out that chaddr OR yiaddr matches and is nonzero */
 void clear_lease(u_int8_t *chaddr, u_int32_t yiaddr)
 {
 	unsigned int i, j;
+	struct dhcpOfferedAddr *lease;
 
 	for (j = 0; j < 16 && !chaddr[j]; j++);
 
+	if (lindex) {
+		if (j != 16)
+			while ((lease = find_lease_by_chaddr(chaddr)))
+				remove_lease(lease);
+		if (yiaddr)
+			while ((lease = find_lease_by_yiaddr(yiaddr)))
+				remove_lease(lease);
+		return;
+	}
+
 	for (i = 0; i < server_config.max_leases; i++)
 		if ((j != 16 && !memcmp(leases[i].chaddr, chaddr, 16)) ||
 		    (yiaddr && leases[i].yiaddr == yiaddr)) {
@@ -53,15 +243,34 @@ struct dhcpOfferedAddr *add_lease(u_int8_t *chaddr, u_int32_t yiaddr, unsigned l
 	oldest = oldest_expired_lease();
 
 	if (oldest) {
+		lease_unlink(oldest);
 		memcpy(oldest->chaddr, chaddr, 16);
 		oldest->yiaddr = yiaddr;
 		oldest->expires = time(0) + lease;
+		lease_link(oldest);
 	}
 
 	return oldest;
 }
 
 
+/* forget who a lease belongs to, the address stays reserved until it expires */
+void unbind_lease(struct dhcpOfferedAddr *lease)
+{
+	lease_unlink(lease);
+	memset(lease->chaddr, 0, 16);
+	lease_link(lease);
+}
+
+
+/* empty a lease slot */
+void remove_lease(struct dhcpOfferedAddr *lease)
+{
+	lease_unlink(lease);
+	memset(lease, 0, sizeof(struct dhcpOfferedAddr));
+}
+
+
 /* true if a lease has expired */
 int lease_expired(struct dhcpOfferedAddr *lease)
 {
@@ -91,6 +300,16 @@ struct dhcpOfferedAddr *oldest_expired_lease(void)
 struct dhcpOfferedAddr *find_lease_by_chaddr(u_int8_t *chaddr)
 {
 	unsigned int i;
+	u_int16_t id;
+
+	/* blank chaddr also matches unused slots, which are not indexed */
+	if (lindex && !chaddr_blank(chaddr)) {
+		id = lindex->chaddr_head[chaddr_hash(chaddr) & lindex->mask];
+		for (; id != LEASE_NIL; id = lindex->chaddr_next[id - 1])
+			if (!memcmp(leases[id - 1].chaddr, chaddr, 16))
+				return &(leases[id - 1]);
+		return NULL;
+	}
 
 	for (i = 0; i < server_config.max_leases; i++)
 		if (!memcmp(leases[i].chaddr, chaddr, 16)) return &(leases[i]);
@@ -103,6 +322,15 @@ struct dhcpOfferedAddr *find_lease_by_chaddr(u_int8_t *chaddr)
 struct dhcpOfferedAddr *find_lease_by_yiaddr(u_int32_t yiaddr)
 {
 	unsigned int i;
+	u_int16_t id;
+
+	if (lindex && yiaddr) {
+		id = lindex->yiaddr_head[yiaddr_hash(yiaddr) & lindex->mask];
+		for (; id != LEASE_NIL; id = lindex->yiaddr_next[id - 1])
+			if (leases[id - 1].yiaddr == yiaddr)
+				return &(leases[id - 1]);
+		return NULL;
+	}
 
 	for (i = 0; i < server_config.max_leases; i++)
 		if (leases[i].yiaddr == yiaddr) return &(leases[i]);
@@ -111,22 +339,56 @@ struct dhcpOfferedAddr *find_lease_by_yiaddr(u_int32_t yiaddr)
 }
 
 
+/* true if addr may be handed out: not a .0/.255 address, not being probed
+ * and, when probes are asynchronous, nothing answered for it */
+static int address_usable(u_int32_t addr)
+{
+	/* ie, 192.168.55.0 */
+	if (!(addr & 0xFF)) return 0;
+
+	/* ie, 192.168.55.255 */
+	if ((addr & 0xFF) == 0xFF) return 0;
+
+	if (probe_pending(htonl(addr))) return 0;
+
+	/* probe_socket() set means the caller probes after picking the address */
+	return probe_socket() >= 0 || !check_ip(htonl(addr));
+}
+
+
 /* find an assignable address, it check_expired is true, we check all the expired leases as well.
  * Maybe this should try expired leases by age... */
 u_int32_t find_address(int check_expired)
 {
-	u_int32_t addr, ret;
+	u_int32_t addr, ret, off;
 	struct dhcpOfferedAddr *lease = NULL;
 
+	if (lindex) {
+		/* the address map tells which addresses no lease holds */
+		for (off = 0; off < lindex->map_size; off++) {
+			u_int32_t word = lindex->map[off >> 5];
+
+			if (!check_expired && word == 0xffffffff && !(off & 31)) {
+				off += 31;
+				continue;
+			}
+			addr = lindex->map_base + off;
+			ret = htonl(addr);
+			if (word & (1UL << (off & 31))) {
+				if (!check_expired ||
+				    !(lease = find_lease_by_yiaddr(ret)) ||
+				    !lease_expired(lease))
+					continue;
+			}
+			if (address_usable(addr))
+				return ret;
+		}
+		return 0;
+	}
+
 	addr = ntohl(server_config.start); /* addr is in host order here */
 	for (;addr <= ntohl(server_config.end); addr++) {
 
-		/* ie, 192.168.55.0 */
-		if (!(addr & 0xFF)) continue;
-
-		/* ie, 192.168.55.255 */
-		if ((addr & 0xFF) == 0xFF) continue;
-
 		/* lease is not taken */
 		ret = htonl(addr);
 		if ((!(lease = find_lease_by_yiaddr(ret)) ||
@@ -135,7 +397,7 @@ u_int32_t find_address(int check_expired)
 		     (check_expired  && lease_expired(lease))) &&
 
 		     /* and it isn't on the network */
-	    	     !check_ip(ret)) {
+		     address_usable(addr)) {
 			return ret;
 			break;
 		}
@@ -159,3 +421,154 @@ int check_ip(u_int32_t addr)
 	} else return 0;
 }
 
+
+/*
+ * Asynchronous conflict probing. Instead of blocking in check_ip() for every
+ * candidate, the server reserves the address for the client, sends a probe
+ * and keeps serving other requests. The DISCOVER is answered from
+ * probe_poll() once the probe timed out unanswered; if the address answers
+ * it is reserved for conflict_time and the client gets another one.
+ */
+int probe_init(void)
+{
+	probe_deinit();
+	probe_sock = arpping_open();
+	return probe_sock < 0 ? -1 : 0;
+}
+
+
+void probe_deinit(void)
+{
+	int i;
+
+	for (i = 0; i < DHCPD_PROBE_MAX; i++) {
+		if (probes[i].packet)
+			free(probes[i].packet);
+		memset(&probes[i], 0, sizeof(probes[i]));
+	}
+	if (probe_sock >= 0) {
+		arpping_close(probe_sock);
+		probe_sock = -1;
+	}
+}
+
+
+/* probe socket for the server loop to select on, -1 if probing is synchronous */
+int probe_socket(void)
+{
+	return probe_sock;
+}
+
+
+static struct lease_probe *probe_find(u_int32_t addr)
+{
+	int i;
+
+	for (i = 0; i < DHCPD_PROBE_MAX; i++)
+		if (probes[i].addr == addr)
+			return &probes[i];
+	return NULL;
+}
+
+
+int probe_pending(u_int32_t addr)
+{
+	return addr && probe_find(addr) != NULL;
+}
+
+
+/* queue a probe for addr on behalf of packet, 0 when the answer is deferred */
+int probe_address(struct dhcpMessage *packet, u_int32_t addr)
+{
+	struct lease_probe *probe;
+
+	if (probe_sock < 0)
+		return -1;
+
+	/* a retransmitted DISCOVER replaces the one we hold */
+	if ((probe = probe_find(addr))) {
+		memcpy(probe->packet, packet, sizeof(struct dhcpMessage));
+		return 0;
+	}
+	if (!(probe = probe_find(0))) {
+		DHCPD_LOG(LOG_WARNING, "probe queue full");
+		return -1;
+	}
+	probe->packet = malloc(sizeof(struct dhcpMessage));
+	if (!probe->packet)
+		return -1;
+	if (arpping_send(probe_sock, addr, server_config.server, server_config.arp) < 0) {
+		free(probe->packet);
+		probe->packet = NULL;
+		return -1;
+	}
+	memcpy(probe->packet, packet, sizeof(struct dhcpMessage));
+	probe->addr = addr;
+	probe->deadline = probe_now_ms() + DHCPD_PROBE_TIMEOUT_MS;
+	return 0;
+}
+
+
+/* milliseconds until the next probe times out, -1 if none is pending */
+int probe_wait_ms(void)
+{
+	u_int32_t now = probe_now_ms();
+	int i, left, wait = -1;
+
+	for (i = 0; i < DHCPD_PROBE_MAX; i++) {
+		if (!probes[i].addr)
+			continue;
+		left = (int)(probes[i].deadline - now);
+		if (left < 0)
+			left = 0;
+		if (wait < 0 || left < wait)
+			wait = left;
+	}
+	return wait;
+}
+
+
+static void probe_finish(struct lease_probe *probe, int conflict)
+{
+	struct dhcpMessage *packet = probe->packet;
+	struct in_addr temp;
+
+	temp.s_addr = probe->addr;
+	/* free the slot first, answering may queue a new probe */
+	memset(probe, 0, sizeof(*probe));
+
+	if (conflict) {
+		DHCPD_LOG(LOG_INFO, "%s belongs to someone, reserving it for %ld seconds",
+			inet_ntoa(temp), server_config.conflict_time);
+		add_lease(blank_chaddr, temp.s_addr, server_config.conflict_time);
+	}
+	if (sendOffer(packet) < 0)
+		DEBUG(LOG_ERR, "send OFFER failed");
+	free(packet);
+}
+
+
+/* collect probe replies (readable is the select() result for probe_socket())
+ * and answer the clients whose probes have settled */
+void probe_poll(int readable)
+{
+	struct lease_probe *probe;
+	u_int32_t from, now;
+	int i, ret;
+
+	if (probe_sock < 0)
+		return;
+
+	while (readable) {
+		ret = arpping_recv(probe_sock, server_config.arp, &from, MSG_DONTWAIT);
+		if (ret < 0)
+			break;
+		if (ret == 1 && from && (probe = probe_find(from)))
+			probe_finish(probe, 1);
+	}
+
+	now = probe_now_ms();
+	for (i = 0; i < DHCPD_PROBE_MAX; i++)
+		if (probes[i].addr && (int)(probes[i].deadline - now) <= 0)
+			probe_finish(&probes[i], 0);
+}
@@ -12,6 +12,16 @@ struct dhcpOfferedAddr {
 	u_int32_t expires;	/* host order */
 };
 
+/* outstanding conflict probes and how long to wait for an answer */
+#ifndef DHCPD_PROBE_MAX
+#define DHCPD_PROBE_MAX		8
+#endif
+#ifndef DHCPD_PROBE_TIMEOUT_MS
+#define DHCPD_PROBE_TIMEOUT_MS	1000
+#endif
+
+struct dhcpMessage;
+
 extern unsigned char blank_chaddr[];
 
 void clear_lease(u_int8_t *chaddr, u_int32_t yiaddr);
@@ -22,6 +32,18 @@ struct dhcpOfferedAddr *find_lease_by_chaddr(u_int8_t *chaddr);
 struct dhcpOfferedAddr *find_lease_by_yiaddr(u_int32_t yiaddr);
 u_int32_t find_address(int check_expired);
 int check_ip(u_int32_t addr);
+void unbind_lease(struct dhcpOfferedAddr *lease);
+void remove_lease(struct dhcpOfferedAddr *lease);
+int init_leases_index(void);
+void free_leases_index(void);
+
+int probe_init(void);
+void probe_deinit(void);
+int probe_socket(void);
+int probe_pending(u_int32_t addr);
+int probe_address(struct dhcpMessage *packet, u_int32_t addr);
+int probe_wait_ms(void);
+void probe_poll(int readable);
 
 
 #endif
@@ -122,6 +122,7 @@ int sendOffer(struct dhcpMessage *oldpacket)
 	u_int32_t req_align, lease_time_align = server_config.lease;
 	unsigned char *req, *lease_time;
 	struct option_set *curr;
+	int fresh = 0;
 	//struct in_addr addr;
 
 #ifdef DHCPD_HEAP_REPLACE_STACK
@@ -138,6 +139,14 @@ int sendOffer(struct dhcpMessage *oldpacket)
 	/* ADDME: if static, short circuit */
 	/* the client is in our lease/offered table */
 	if ((lease = find_lease_by_chaddr(oldpacket->chaddr))) {
+		/* the address we reserved for it is still being probed */
+		if (probe_pending(lease->yiaddr) &&
+		    probe_address(oldpacket, lease->yiaddr) == 0) {
+#ifdef DHCPD_HEAP_REPLACE_STACK
+			free(packet);
+#endif
+			return 0;
+		}
 		if (!lease_expired(lease))
 			lease_time_align = lease->expires - time(0);
 #ifdef DHCPD_HEAP_REPLACE_STACK
@@ -178,6 +187,7 @@ int sendOffer(struct dhcpMessage *oldpacket)
 		/* try for an expired lease */
 		if (!packet.yiaddr) packet.yiaddr = find_address(1);
 #endif
+		fresh = 1;
 	}
 #ifdef DHCPD_HEAP_REPLACE_STACK
 	if(!(packet->yiaddr)) {
@@ -203,6 +213,29 @@ int sendOffer(struct dhcpMessage *oldpacket)
 		return -1;
 	}
 
+	/* with asynchronous probing a new address is offered once nobody answered */
+	if (fresh && probe_socket() >= 0) {
+#ifdef DHCPD_HEAP_REPLACE_STACK
+		req_align = packet->yiaddr;
+		if (probe_address(oldpacket, req_align) < 0)
+			clear_lease(packet->chaddr, req_align);
+		else
+			req_align = 0;
+		free(packet);
+#else
+		req_align = packet.yiaddr;
+		if (probe_address(oldpacket, req_align) < 0)
+			clear_lease(packet.chaddr, req_align);
+		else
+			req_align = 0;
+#endif
+		if (req_align) {
+			DHCPD_LOG(LOG_WARNING, "can't probe address -- OFFER deferred");
+			return -1;
+		}
+		return 0;
+	}
+
 	if ((lease_time = get_option(oldpacket, DHCP_LEASE_TIME))) {
 		memcpy(&lease_time_align, lease_time, 4);
 		lease_time_align = ntohl(lease_time_align);
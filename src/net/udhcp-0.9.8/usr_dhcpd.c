@@ -118,7 +118,7 @@ static int udhcpd_upgrade_sta_mac(void)
 				DEBUG(LOG_INFO, "Mac: %02x:%02x:%02x:%02x:%02x:%02x has disconnect, will be delete!",
 					leases[i].chaddr[0], leases[i].chaddr[1], leases[i].chaddr[2],
 					leases[i].chaddr[3], leases[i].chaddr[4], leases[i].chaddr[5]);
-				memset(&(leases[i]), 0, sizeof(struct dhcpOfferedAddr));
+				remove_lease(&leases[i]);
 			}
 		}
 	}
@@ -130,11 +130,13 @@ exit:
 
 static void udhcpd_start(void *arg)
 {
-#ifdef DHCPD_DNS
 	fd_set fds;
 	int maxfdp;
 	int ret;
-
+	int probe_fd;
+	int probe_ms;
+	struct timeval tv;
+#ifdef DHCPD_DNS
 	int dns_socket = -1;
 	char *dns_buf = NULL;
 	dns_buf = malloc(DNS_BUF_SIZE);
@@ -199,6 +201,9 @@ static void udhcpd_start(void *arg)
 
 	leases = malloc(sizeof(struct dhcpOfferedAddr) * server_config.max_leases);
 	memset(leases, 0, sizeof(struct dhcpOfferedAddr) * server_config.max_leases);
+	init_leases_index();
+	if (probe_init() < 0)
+		DEBUG(LOG_WARNING, "no probe socket, checking addresses synchronously");
 	DEBUG(LOG_DEBUG, "start ip=%s", inet_ntoa(server_config.start));
 	DEBUG(LOG_DEBUG, "end   ip=%s", inet_ntoa(server_config.end));
 
@@ -215,21 +220,38 @@ static void udhcpd_start(void *arg)
 				DNS_ERR("FATAL: couldn't create dns server socket\n");
 				goto exit_server;
 			}
+#endif
 
 		FD_ZERO(&fds);
 		FD_SET(server_socket, &fds);
+		maxfdp = server_socket + 1;
+#ifdef DHCPD_DNS
 		FD_SET(dns_socket, &fds);
-		maxfdp = server_socket > dns_socket ? server_socket + 1 : dns_socket + 1;
-		ret = select(maxfdp, &fds, NULL, NULL, NULL);
+		if (dns_socket >= maxfdp)
+			maxfdp = dns_socket + 1;
+#endif
+		/* keep serving while conflict probes are outstanding */
+		probe_fd = probe_socket();
+		if (probe_fd >= 0) {
+			FD_SET(probe_fd, &fds);
+			if (probe_fd >= maxfdp)
+				maxfdp = probe_fd + 1;
+		}
+		probe_ms = probe_wait_ms();
+		tv.tv_sec = probe_ms / 1000;
+		tv.tv_usec = (probe_ms % 1000) * 1000;
+		ret = select(maxfdp, &fds, NULL, NULL, probe_ms < 0 ? NULL : &tv);
 		if (ret < 0)
 			goto exit_server;
-		else if (ret == 0)
+		probe_poll(ret > 0 && probe_fd >= 0 && FD_ISSET(probe_fd, &fds));
+		if (ret == 0)
 			continue;
+#ifdef DHCPD_DNS
 		if (FD_ISSET(dns_socket, &fds))
 			dns_server(dns_socket, dns_buf, DNS_BUF_SIZE);
+#endif
 
 		if (FD_ISSET(server_socket, &fds)) {
-#endif
 			if ((bytes = get_packet(packet, server_socket)) < 0) { /* this waits for a packet - idle */
 				if (bytes == -1 && errno != EINTR) {
 					DEBUG(LOG_INFO, "error on read, %s, reopening socket", strerror(errno));
@@ -312,7 +334,7 @@ static void udhcpd_start(void *arg)
 						if ((lease = find_lease_by_yiaddr(requested_align))) {
 							if (lease_expired(lease)) {
 								/* probably best if we drop this lease */
-								memset(lease->chaddr, 0, 16);
+								unbind_lease(lease);
 								/* make some contention for this address */
 							} else sendNAK(packet);
 						} else {
@@ -325,7 +347,7 @@ static void udhcpd_start(void *arg)
 				case DHCPDECLINE:
 					DEBUG(LOG_INFO,"received DECLINE");
 					if (lease) {
-						memset(lease->chaddr, 0, 16);
+						unbind_lease(lease);
 						lease->expires = time(0) + server_config.decline_time;
 					}
 					break;
@@ -340,9 +362,7 @@ static void udhcpd_start(void *arg)
 				default:
 					DEBUG(LOG_WARNING, "unsupported DHCP message (%02x) -- ignoring", state[0]);
 			}
-#ifdef DHCPD_DNS
 		}
-#endif
 	}
 
 exit_server:
@@ -358,6 +378,8 @@ exit_server:
 		free(packet);
 		packet = NULL;
 	}
+	probe_deinit();
+	free_leases_index();
 	if (leases != NULL) {
 		free(leases);
 		leases = NULL;
@@ -116,6 +116,15 @@ void ota_deinit(void)
 	ota_memset(&ota_priv, 0, sizeof(ota_priv));
 }
 
+/* the image is about to be rewritten, drop its record of a passed check */
+static void ota_check_cache_clear(image_seq_t seq)
+{
+	image_check_cache_clear(seq);
+#if (__CONFIG_OTA_POLICY != 0x00)
+	image_check_cache_clear(0); /* bootloader decompresses the image to seq 0 */
+#endif
+}
+
 static ota_status_t ota_update_image_process(image_seq_t seq, void *url,
 											 ota_update_init_t init_cb,
 											 ota_update_get_t get_cb)
@@ -146,6 +155,7 @@ static ota_status_t ota_update_image_process(image_seq_t seq, void *url,
 	if (ota_cb)
 		ota_cb(OTA_UPGRADE_START, 0, OTA_START_PERCENT);
 
+	ota_check_cache_clear(seq);
 	if (flash_erase(flash, addr, img_max_size) != 0) {
 		return ret;
 	}
@@ -399,6 +409,7 @@ ota_status_t ota_push_init(void)
 	OTA_DBG("%s(), seq %d, flash %u, addr %#x\n", __func__, seq, flash, addr);
 	OTA_SYSLOG("OTA: erase flash...\n");
 
+	ota_check_cache_clear(seq);
 	if (flash_erase(flash, addr, img_max_size) != 0) {
 		OTA_ERR("OTA: erase fail\n");
 		return OTA_STATUS_ERROR;
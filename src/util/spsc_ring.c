@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include "util/spsc_ring.h"
+
+/*
+ * head and tail run over [0, 2 * size): equal means empty, size apart means
+ * full. Each side keeps a cached copy of the other side's index and only
+ * loads the shared one when the copy shows too little, so the other side's
+ * cache line is touched once per refill instead of on every call.
+ */
+
+#define RING_LOAD_ACQUIRE(p)		__atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define RING_STORE_RELEASE(p, v)	__atomic_store_n(p, v, __ATOMIC_RELEASE)
+
+static __inline uint32_t ring_used(const spsc_ring_t *ring, uint32_t head, uint32_t tail)
+{
+	return (head >= tail) ? (head - tail) : (head + 2 * ring->size - tail);
+}
+
+static __inline uint32_t ring_advance(const spsc_ring_t *ring, uint32_t idx, uint32_t n)
+{
+	idx += n;
+	if (idx >= 2 * ring->size)
+		idx -= 2 * ring->size;
+	return idx;
+}
+
+static __inline uint32_t ring_offset(const spsc_ring_t *ring, uint32_t idx)
+{
+	return (idx >= ring->size) ? (idx - ring->size) : idx;
+}
+
+void spsc_ring_init(spsc_ring_t *ring, void *buf, uint32_t size, uint32_t span_max)
+{
+	ring->buf = buf;
+	ring->size = size;
+	ring->span_max = span_max;
+	spsc_ring_reset(ring);
+}
+
+void spsc_ring_reset(spsc_ring_t *ring)
+{
+	ring->head = 0;
+	ring->tail_cache = 0;
+	ring->overrun = 0;
+	ring->tail = 0;
+	ring->head_cache = 0;
+}
+
+/* free bytes, at least want of them if the consumer has made the room */
+static uint32_t ring_space(spsc_ring_t *ring, uint32_t want)
+{
+	uint32_t space;
+
+	space = ring->size - ring_used(ring, ring->head, ring->tail_cache);
+	if (space < want) {
+		ring->tail_cache = RING_LOAD_ACQUIRE(&ring->tail);
+		space = ring->size - ring_used(ring, ring->head, ring->tail_cache);
+	}
+	return space;
+}
+
+uint32_t spsc_ring_space(spsc_ring_t *ring)
+{
+	return ring_space(ring, ring->size);
+}
+
+/*
+ * Free room at the head for the producer to fill in place. *len is the number
+ * of bytes wanted on entry and the contiguous bytes at the returned address
+ * on return, which may be fewer. Returns NULL if the ring is full.
+ */
+void *spsc_ring_write_span(spsc_ring_t *ring, uint32_t *len)
+{
+	uint32_t off = ring_offset(ring, ring->head);
+	uint32_t space = ring_space(ring, *len);
+
+	if (space > ring->size - off)
+		space = ring->size - off;
+	*len = space;
+	return space ? (ring->buf + off) : NULL;
+}
+
+/* publish len bytes filled in the last write span */
+void spsc_ring_write_commit(spsc_ring_t *ring, uint32_t len)
+{
+	RING_STORE_RELEASE(&ring->head, ring_advance(ring, ring->head, len));
+}
+
+/*
+ * Copy len bytes in, all or nothing so that frames stay whole. When there is
+ * no room the data is dropped and counted in overrun, returns 0.
+ */
+uint32_t spsc_ring_write(spsc_ring_t *ring, const void *data, uint32_t len)
+{
+	uint32_t off, first;
+
+	if (ring_space(ring, len) < len) {
+		ring->overrun += len;
+		return 0;
+	}
+
+	off = ring_offset(ring, ring->head);
+	first = ring->size - off;
+	if (first > len)
+		first = len;
+	memcpy(ring->buf + off, data, first);
+	memcpy(ring->buf, (const uint8_t *)data + first, len - first);
+	spsc_ring_write_commit(ring, len);
+	return len;
+}
+
+/* bytes ready, at least want of them if the producer has written them */
+static uint32_t ring_count(spsc_ring_t *ring, uint32_t want)
+{
+	uint32_t count;
+
+	count = ring_used(ring, ring->head_cache, ring->tail);
+	if (count < want) {
+		ring->head_cache = RING_LOAD_ACQUIRE(&ring->head);
+		count = ring_used(ring, ring->head_cache, ring->tail);
+	}
+	return count;
+}
+
+uint32_t spsc_ring_count(spsc_ring_t *ring)
+{
+	return ring_count(ring, ring->size);
+}
+
+/*
+ * The next len bytes as one contiguous block, valid until they are released.
+ * Returns NULL if fewer than len bytes are ready, or if the block crosses the
+ * end of the ring by more than span_max bytes.
+ */
+const void *spsc_ring_read_span(spsc_ring_t *ring, uint32_t len)
+{
+	uint32_t off, first;
+
+	if (len == 0 || ring_count(ring, len) < len)
+		return NULL;
+
+	off = ring_offset(ring, ring->tail);
+	first = ring->size - off;
+	if (first < len) {
+		if (len - first > ring->span_max)
+			return NULL;
+		memcpy(ring->buf + ring->size, ring->buf, len - first);
+	}
+	return ring->buf + off;
+}
+
+/* hand len bytes of the last read span back to the producer */
+void spsc_ring_read_release(spsc_ring_t *ring, uint32_t len)
+{
+	RING_STORE_RELEASE(&ring->tail, ring_advance(ring, ring->tail, len));
+}
+
+/* copy out up to len bytes, returns the number copied */
+uint32_t spsc_ring_read(spsc_ring_t *ring, void *data, uint32_t len)
+{
+	uint32_t off, first, count;
+
+	count = ring_count(ring, len);
+	if (len > count)
+		len = count;
+
+	off = ring_offset(ring, ring->tail);
+	first = ring->size - off;
+	if (first > len)
+		first = len;
+	memcpy(data, ring->buf + off, first);
+	memcpy((uint8_t *)data + first, ring->buf, len - first);
+	spsc_ring_read_release(ring, len);
+	return len;
+}
@@ -0,0 +1,365 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host test and benchmark of util/spsc_ring, one producer and one consumer
+ * pthread.
+ *
+ * usage: spsc_ring_sim test [mbytes]
+ *        spsc_ring_sim bench [frames]
+ *
+ * The test streams a byte count through a 1000-byte ring with 300 spare
+ * bytes, both sides picking at random between the in-place calls and the
+ * copying ones and a random length each time, and checks every byte read.
+ * A ring size that is not a multiple of the lengths makes read spans cross
+ * the end, so the spare bytes are used.
+ *
+ * The bench passes 1280-byte capture frames (10 ms of 4 channels at 16 kHz)
+ * through a 6 frame ring, as the speech capture does, flat out and paced at
+ * 1 ms with a semaphore waking the consumer, and prints frames per second and
+ * the producer to consumer latency. The same is done with the ring under a
+ * mutex and a consumer polling every 2 ms, as pcmFifo used to be.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include "util/spsc_ring.h"
+
+#define SIM_FAIL(fmt, arg...)									\
+	do {														\
+		printf("FAIL %s():%d, " fmt "\n", __func__, __LINE__, ##arg);	\
+		exit(1);												\
+	} while (0)
+
+#define FUZZ_SIZE		1000
+#define FUZZ_SPAN_MAX	300
+
+static spsc_ring_t fuzz_ring;
+static uint8_t fuzz_buf[FUZZ_SIZE + FUZZ_SPAN_MAX];
+static uint32_t fuzz_total;
+
+static void *fuzz_producer(void *arg)
+{
+	uint8_t tmp[FUZZ_SPAN_MAX], *p;
+	unsigned int seed = 1;
+	uint32_t n = 0, len, i;
+
+	while (n < fuzz_total) {
+		len = rand_r(&seed) % FUZZ_SPAN_MAX + 1;
+		if (len > fuzz_total - n)
+			len = fuzz_total - n;
+		if (rand_r(&seed) & 1) {
+			p = spsc_ring_write_span(&fuzz_ring, &len);
+			if (p == NULL) {
+				sched_yield();
+				continue;
+			}
+			for (i = 0; i < len; i++)
+				p[i] = (uint8_t)(n + i);
+			spsc_ring_write_commit(&fuzz_ring, len);
+			n += len;
+		} else {
+			for (i = 0; i < len; i++)
+				tmp[i] = (uint8_t)(n + i);
+			if (spsc_ring_write(&fuzz_ring, tmp, len)) {
+				n += len;
+			} else {
+				fuzz_ring.overrun = 0;
+				sched_yield();
+			}
+		}
+	}
+	return NULL;
+}
+
+static int sim_test(uint32_t mbytes)
+{
+	uint8_t tmp[FUZZ_SPAN_MAX];
+	const uint8_t *d;
+	unsigned int seed = 7;
+	uint32_t n = 0, bad = 0, spans = 0, wraps = 0, len, off, got, i;
+	pthread_t producer;
+
+	fuzz_total = mbytes * 1000000;
+	spsc_ring_init(&fuzz_ring, fuzz_buf, FUZZ_SIZE, FUZZ_SPAN_MAX);
+	pthread_create(&producer, NULL, fuzz_producer, NULL);
+
+	while (n < fuzz_total) {
+		len = rand_r(&seed) % FUZZ_SPAN_MAX + 1;
+		if (len > fuzz_total - n)
+			len = fuzz_total - n;
+		if (rand_r(&seed) & 1) {
+			off = fuzz_ring.tail >= FUZZ_SIZE ? fuzz_ring.tail - FUZZ_SIZE : fuzz_ring.tail;
+			d = spsc_ring_read_span(&fuzz_ring, len);
+			if (d == NULL) {
+				sched_yield();
+				continue;
+			}
+			spans++;
+			if (off + len > FUZZ_SIZE)
+				wraps++;
+			for (i = 0; i < len; i++)
+				bad += d[i] != (uint8_t)(n + i);
+			spsc_ring_read_release(&fuzz_ring, len);
+			n += len;
+		} else {
+			got = spsc_ring_read(&fuzz_ring, tmp, len);
+			for (i = 0; i < got; i++)
+				bad += tmp[i] != (uint8_t)(n + i);
+			n += got;
+			if (got == 0)
+				sched_yield();
+		}
+	}
+	pthread_join(producer, NULL);
+
+	printf("%u bytes, %u read spans of which %u wrapped, %u bytes wrong\n",
+	       n, spans, wraps, bad);
+	if (bad)
+		SIM_FAIL("%u bytes wrong", bad);
+	if (wraps == 0)
+		SIM_FAIL("no read span wrapped");
+	if (spsc_ring_count(&fuzz_ring) != 0 || spsc_ring_space(&fuzz_ring) != FUZZ_SIZE)
+		SIM_FAIL("ring not empty at the end");
+	printf("ok\n");
+	return 0;
+}
+
+#define BENCH_FRAME		1280
+#define BENCH_FRAMES	6
+
+static spsc_ring_t bench_ring;
+static uint8_t bench_buf[BENCH_FRAMES * BENCH_FRAME];
+static pthread_mutex_t bench_lock = PTHREAD_MUTEX_INITIALIZER;
+static sem_t bench_sem;
+static int bench_locked;
+static long bench_frames;
+static long bench_period_us;
+static long bench_got;
+static double *bench_lat;
+static uint8_t bench_src[BENCH_FRAME];
+static int16_t bench_ref[BENCH_FRAME / 8];
+static int16_t bench_mic[BENCH_FRAME / 4];
+
+static uint64_t bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void bench_fill(uint8_t *p)
+{
+	uint64_t t;
+
+	memcpy(p, bench_src, BENCH_FRAME);
+	t = bench_now();
+	memcpy(p, &t, sizeof(t));
+}
+
+/* deinterleave as the aec task does, and take the latency */
+static void bench_consume(const uint8_t *p)
+{
+	const int16_t *s = (const int16_t *)p;
+	uint64_t t;
+	int i;
+
+	memcpy(&t, p, sizeof(t));
+	for (i = 0; i < BENCH_FRAME / 8; i++) {
+		bench_ref[i] = s[4 * i + 1];
+		bench_mic[i] = s[4 * i + 2];
+		bench_mic[i + BENCH_FRAME / 8] = s[4 * i + 3];
+	}
+	bench_lat[bench_got++] = (bench_now() - t) / 1000.0;
+}
+
+static void *bench_producer(void *arg)
+{
+	uint8_t frame[BENCH_FRAME];
+	uint64_t next = bench_now();
+	struct timespec ts;
+	uint32_t len;
+	void *span;
+	long i;
+	int ok;
+
+	for (i = 0; i < bench_frames; i++) {
+		if (bench_period_us) {
+			next += bench_period_us * 1000;
+			ts.tv_sec = next / 1000000000;
+			ts.tv_nsec = next % 1000000000;
+			clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+		}
+		if (bench_locked) {
+			for (;;) {
+				bench_fill(frame);
+				pthread_mutex_lock(&bench_lock);
+				ok = spsc_ring_write(&bench_ring, frame, BENCH_FRAME) != 0;
+				pthread_mutex_unlock(&bench_lock);
+				if (ok)
+					break;
+				sched_yield();
+			}
+		} else {
+			for (;;) {
+				len = BENCH_FRAME;
+				span = spsc_ring_write_span(&bench_ring, &len);
+				if (span && len >= BENCH_FRAME)
+					break;
+				sched_yield();
+			}
+			bench_fill(span);
+			spsc_ring_write_commit(&bench_ring, BENCH_FRAME);
+			if (bench_period_us)
+				sem_post(&bench_sem);
+		}
+	}
+	return NULL;
+}
+
+static void *bench_consumer(void *arg)
+{
+	uint8_t frame[BENCH_FRAME];
+	struct timespec ts;
+	const void *span;
+	uint32_t got;
+
+	while (bench_got < bench_frames) {
+		if (bench_locked) {
+			pthread_mutex_lock(&bench_lock);
+			got = 0;
+			if (spsc_ring_count(&bench_ring) >= BENCH_FRAME)
+				got = spsc_ring_read(&bench_ring, frame, BENCH_FRAME);
+			pthread_mutex_unlock(&bench_lock);
+			if (got) {
+				bench_consume(frame);
+			} else if (bench_period_us) {
+				usleep(2000);
+			} else {
+				sched_yield();
+			}
+		} else {
+			span = spsc_ring_read_span(&bench_ring, BENCH_FRAME);
+			if (span) {
+				bench_consume(span);
+				spsc_ring_read_release(&bench_ring, BENCH_FRAME);
+			} else if (bench_period_us) {
+				clock_gettime(CLOCK_REALTIME, &ts);
+				ts.tv_nsec += 100 * 1000000;
+				if (ts.tv_nsec >= 1000000000) {
+					ts.tv_sec++;
+					ts.tv_nsec -= 1000000000;
+				}
+				sem_timedwait(&bench_sem, &ts);
+			} else {
+				sched_yield();
+			}
+		}
+	}
+	return NULL;
+}
+
+static int bench_cmp(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void bench_run(int locked, long frames, long period_us)
+{
+	pthread_t producer, consumer;
+	double sum = 0, sum2 = 0, mean;
+	uint64_t t;
+	long i;
+
+	bench_locked = locked;
+	bench_frames = frames;
+	bench_period_us = period_us;
+	bench_got = 0;
+	spsc_ring_init(&bench_ring, bench_buf, sizeof(bench_buf), 0);
+	sem_init(&bench_sem, 0, 0);
+
+	t = bench_now();
+	pthread_create(&consumer, NULL, bench_consumer, NULL);
+	pthread_create(&producer, NULL, bench_producer, NULL);
+	pthread_join(producer, NULL);
+	pthread_join(consumer, NULL);
+	t = bench_now() - t;
+	sem_destroy(&bench_sem);
+
+	for (i = 0; i < frames; i++) {
+		sum += bench_lat[i];
+		sum2 += bench_lat[i] * bench_lat[i];
+	}
+	mean = sum / frames;
+	qsort(bench_lat, frames, sizeof(double), bench_cmp);
+	printf("%-12s %-5s %8.0f %8.1f %8.1f %8.1f %8.1f %8.1f\n",
+	       locked ? "mutex, poll" : "ring", period_us ? "1 ms" : "flat",
+	       frames * 1e9 / t, mean, bench_lat[frames / 2], bench_lat[frames * 99 / 100],
+	       bench_lat[frames - 1], sqrt(sum2 / frames - mean * mean));
+}
+
+static int sim_bench(long frames)
+{
+	long i, paced = frames / 100;
+
+	if (paced < 1000)
+		paced = 1000;
+	bench_lat = malloc((frames > paced ? frames : paced) * sizeof(double));
+	for (i = 0; i < BENCH_FRAME; i++)
+		bench_src[i] = (uint8_t)(i * 7);
+
+	printf("%ld frames flat out, %ld paced, latency in us\n", frames, paced);
+	printf("                  frames/s     mean      p50      p99      max       sd\n");
+	bench_run(0, frames, 0);
+	bench_run(1, frames, 0);
+	bench_run(0, paced, 1000);
+	bench_run(1, paced, 1000);
+	free(bench_lat);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc >= 2 && !strcmp(argv[1], "test"))
+		return sim_test(argc >= 3 ? atoi(argv[2]) : 20);
+	if (argc >= 2 && !strcmp(argv[1], "bench"))
+		return sim_bench(argc >= 3 ? atol(argv[2]) : 1000000);
+	printf("usage: %s test [mbytes] | bench [frames]\n", argv[0]);
+	return 1;
+}
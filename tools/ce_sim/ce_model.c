@@ -0,0 +1,881 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Crypto engine model, see ce_model.h. Built with the software mbedtls
+ * (ce_sim_sw.h renames it), which does the computing of the engine.
+ */
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+
+#include "driver/chip/hal_crypto.h"
+#include "driver/chip/hal_dma.h"
+#include "driver/chip/hal_ccm.h"
+#include "driver/chip/private/hal_os.h"
+#include "mbedtls/aes.h"
+#include "mbedtls/sha1.h"
+#include "mbedtls/sha256.h"
+#include "ce_model.h"
+
+#define COST_REG			4
+#define COST_DMA_WORD		4
+#define COST_DMA_REQUEST	50
+#define COST_DMA_INIT		100
+#define COST_DMA_START		60
+#define COST_DMA_STOP		30
+#define COST_MUTEX			40
+#define COST_SEM			20
+#define COST_SEM_BLOCK		300
+#define CE_CYCLE			2		/* cpu cycles of a CE cycle */
+
+#define CE_PAGE_SIZE		0x1000
+#define CE_FIFO_WORDS		32
+#define CE_OUT_WORDS		64
+
+#define REG(name)			(offsetof(CE_T, name) / 4)
+#define REG_NUM				(sizeof(CE_T) / 4)
+
+#define CTL_METHOD(ctl)		((ctl) & CE_CTL_METHOD_MASK)
+
+struct ce_model_stat ce_model_stat;
+uint32_t ce_model_hash_dma_min = 1024;	/* as the driver */
+SysTick_Type host_systick;
+
+static volatile uint32_t *s_page;
+static uint32_t s_reg[REG_NUM];
+static uint32_t s_trap_reg;
+static uint32_t s_trap_old;
+static int s_trap_write;
+
+#define s_now	ce_model_stat.cycles
+
+/* engine state of the current session, from enabling the CE to disabling it */
+static struct {
+	int			active;		/* set up on the first word in */
+	uint32_t	method;
+	mbedtls_aes_context aes;
+	uint8_t		iv[16];
+	uint32_t	h[8];
+	uint32_t	crc;
+	uint32_t	crc_len;
+	uint8_t		blk[64];
+	uint32_t	blk_len;
+	uint64_t	busy;		/* busy computing until */
+	uint64_t	pend_start[CE_FIFO_WORDS];	/* blocks queued, words leave the fifo at start */
+	uint32_t	pend_words[CE_FIFO_WORDS];
+	uint32_t	pend_idx;
+	uint32_t	out[CE_OUT_WORDS];
+	uint64_t	out_at[CE_OUT_WORDS];
+	uint32_t	out_head;
+	uint32_t	out_cnt;
+	int			end;		/* hash/crc finished */
+	uint64_t	end_at;
+	uint32_t	prng;
+} s_ce;
+
+/******************************** engine *********************************/
+
+static uint32_t ce_block_words(void)
+{
+	switch (s_ce.method) {
+	case CE_CTL_METHOD_AES:
+		return 4;
+	case CE_CTL_METHOD_SHA1:
+	case CE_CTL_METHOD_SHA256:
+		return 16;
+	default:
+		return 1;
+	}
+}
+
+static uint32_t ce_aes_bits(void)
+{
+	switch (s_reg[REG(CTL)] & CE_CTL_AES_KEY_SIZE_MASK) {
+	case CE_CTL_AES_KEYSIZE_128BITS:
+		return 128;
+	case CE_CTL_AES_KEYSIZE_192BITS:
+		return 192;
+	default:
+		return 256;
+	}
+}
+
+static uint32_t ce_crc_mask(void)
+{
+	return (s_reg[REG(CTL)] & CE_CTL_CRC_WIDTH_MASK) ? 0xFFFFFFFF : 0xFFFF;
+}
+
+static uint32_t ce_reflect(uint32_t v, int bits)
+{
+	uint32_t r = 0;
+	int i;
+
+	for (i = 0; i < bits; i++)
+		r |= ((v >> i) & 1) << (bits - 1 - i);
+	return r;
+}
+
+static void ce_session_reset(void)
+{
+	mbedtls_aes_free(&s_ce.aes);
+	memset(&s_ce, 0, sizeof(s_ce));
+	mbedtls_aes_init(&s_ce.aes);
+}
+
+static void ce_session_start(void)
+{
+	static const uint32_t sha1_iv[5] = {
+		0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0
+	};
+	static const uint32_t sha256_iv[8] = {
+		0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+		0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+	};
+	uint32_t ctl = s_reg[REG(CTL)];
+	int i;
+
+	s_ce.active = 1;
+	s_ce.method = CTL_METHOD(ctl);
+	switch (s_ce.method) {
+	case CE_CTL_METHOD_AES:
+		if (ctl & CE_CTL_OP_DIR_MASK)
+			mbedtls_aes_setkey_dec(&s_ce.aes, (uint8_t *)&s_reg[REG(KEY)], ce_aes_bits());
+		else
+			mbedtls_aes_setkey_enc(&s_ce.aes, (uint8_t *)&s_reg[REG(KEY)], ce_aes_bits());
+		memcpy(s_ce.iv, &s_reg[REG(IV)], 16);
+		break;
+	case CE_CTL_METHOD_SHA1:
+	case CE_CTL_METHOD_SHA256:
+		if (ctl & CE_CTL_IV_MODE_MASK) {
+			/* IV registers hold the chaining words byte swapped */
+			for (i = 0; i < 4; i++)
+				s_ce.h[i] = __builtin_bswap32(s_reg[REG(IV) + i]);
+			for (i = 0; i < 4; i++)
+				s_ce.h[4 + i] = __builtin_bswap32(s_reg[REG(CNT) + i]);
+		} else if (s_ce.method == CE_CTL_METHOD_SHA1) {
+			memcpy(s_ce.h, sha1_iv, sizeof(sha1_iv));
+		} else {
+			memcpy(s_ce.h, sha256_iv, sizeof(sha256_iv));
+		}
+		break;
+	case CE_CTL_METHOD_CRC:
+		s_ce.crc = (ctl & CE_CTL_CRC_INIT_MASK) ? ce_crc_mask() : 0;
+		break;
+	default:
+		break;
+	}
+}
+
+static void ce_out_push(const uint8_t *data, uint32_t words, uint64_t at)
+{
+	uint32_t i, w;
+
+	for (i = 0; i < words; i++) {
+		if (s_ce.out_cnt == CE_OUT_WORDS) {
+			printf("ce_model: tx fifo overflow\n");
+			exit(1);
+		}
+		memcpy(&w, data + 4 * i, 4);
+		s_ce.out[(s_ce.out_head + s_ce.out_cnt) % CE_OUT_WORDS] = w;
+		s_ce.out_at[(s_ce.out_head + s_ce.out_cnt) % CE_OUT_WORDS] = at;
+		s_ce.out_cnt++;
+	}
+}
+
+/* run the block in s_ce.blk, its last word arrived at t */
+static void ce_block(uint64_t t)
+{
+	uint64_t start = (t > s_ce.busy) ? t : s_ce.busy;
+	uint32_t cost;
+	uint8_t out[16];
+	int i;
+
+	switch (s_ce.method) {
+	case CE_CTL_METHOD_AES:
+		cost = ce_aes_bits() / 32 + 6 + 2;		/* rounds + 2 */
+		if ((s_reg[REG(CTL)] & CE_CTL_OP_MODE_MASK) == CE_CTL_CRYPT_MODE_CBC) {
+			if (s_reg[REG(CTL)] & CE_CTL_OP_DIR_MASK) {
+				mbedtls_aes_crypt_ecb(&s_ce.aes, MBEDTLS_AES_DECRYPT, s_ce.blk, out);
+				for (i = 0; i < 16; i++)
+					out[i] ^= s_ce.iv[i];
+				memcpy(s_ce.iv, s_ce.blk, 16);
+			} else {
+				for (i = 0; i < 16; i++)
+					s_ce.blk[i] ^= s_ce.iv[i];
+				mbedtls_aes_crypt_ecb(&s_ce.aes, MBEDTLS_AES_ENCRYPT, s_ce.blk, out);
+				memcpy(s_ce.iv, out, 16);
+			}
+			memcpy(&s_reg[REG(IV)], s_ce.iv, 16);
+		} else {
+			mbedtls_aes_crypt_ecb(&s_ce.aes, (s_reg[REG(CTL)] & CE_CTL_OP_DIR_MASK) ?
+			                      MBEDTLS_AES_DECRYPT : MBEDTLS_AES_ENCRYPT, s_ce.blk, out);
+		}
+		break;
+	case CE_CTL_METHOD_SHA1: {
+		mbedtls_sha1_context sha1;
+		cost = 80 + 4;
+		memcpy(sha1.state, s_ce.h, 20);
+		mbedtls_internal_sha1_process(&sha1, s_ce.blk);
+		memcpy(s_ce.h, sha1.state, 20);
+		break;
+	}
+	case CE_CTL_METHOD_SHA256: {
+		mbedtls_sha256_context sha256;
+		cost = 64 + 4;
+		memcpy(sha256.state, s_ce.h, 32);
+		mbedtls_internal_sha256_process(&sha256, s_ce.blk);
+		memcpy(s_ce.h, sha256.state, 32);
+		break;
+	}
+	case CE_CTL_METHOD_CRC: {
+		uint32_t width = (ce_crc_mask() == 0xFFFF) ? 16 : 32;
+		uint32_t top = 1U << (width - 1);
+		uint8_t b;
+		int bit;
+
+		cost = 1;
+		for (i = 0; i < 4 && s_ce.crc_len < s_reg[REG(CTS_LEN)]; i++, s_ce.crc_len++) {
+			b = s_ce.blk[i];
+			if (s_reg[REG(CTL)] & CE_CTL_CRC_REF_IN_MASK)
+				b = ce_reflect(b, 8);
+			s_ce.crc ^= (uint32_t)b << (width - 8);
+			for (bit = 0; bit < 8; bit++)
+				s_ce.crc = (s_ce.crc & top) ? (s_ce.crc << 1) ^ s_reg[REG(CRC_POLY)] : s_ce.crc << 1;
+			s_ce.crc &= ce_crc_mask();
+		}
+		break;
+	}
+	default:
+		cost = 1;
+		break;
+	}
+
+	s_ce.busy = start + cost * CE_CYCLE;
+	s_ce.pend_start[s_ce.pend_idx] = start;
+	s_ce.pend_words[s_ce.pend_idx] = ce_block_words();
+	s_ce.pend_idx = (s_ce.pend_idx + 1) % CE_FIFO_WORDS;
+	ce_model_stat.blocks++;
+	if (s_ce.method == CE_CTL_METHOD_AES)
+		ce_out_push(out, 4, s_ce.busy);
+}
+
+static uint32_t ce_in_used(uint64_t t)
+{
+	uint32_t used = s_ce.blk_len / 4;
+	int i;
+
+	for (i = 0; i < CE_FIFO_WORDS; i++) {
+		if (s_ce.pend_start[i] > t)
+			used += s_ce.pend_words[i];
+	}
+	return used;
+}
+
+static uint32_t ce_out_ready(uint64_t t)
+{
+	uint32_t i;
+
+	for (i = 0; i < s_ce.out_cnt; i++) {
+		if (s_ce.out_at[(s_ce.out_head + i) % CE_OUT_WORDS] > t)
+			break;
+	}
+	return i;
+}
+
+/* next time after t a queued block starts or an output word is ready */
+static uint64_t ce_next_event(uint64_t t)
+{
+	uint64_t next = UINT64_MAX;
+	uint32_t i;
+
+	for (i = 0; i < CE_FIFO_WORDS; i++) {
+		if (s_ce.pend_start[i] > t && s_ce.pend_start[i] < next)
+			next = s_ce.pend_start[i];
+	}
+	for (i = 0; i < s_ce.out_cnt; i++) {
+		if (s_ce.out_at[(s_ce.out_head + i) % CE_OUT_WORDS] > t &&
+		    s_ce.out_at[(s_ce.out_head + i) % CE_OUT_WORDS] < next)
+			next = s_ce.out_at[(s_ce.out_head + i) % CE_OUT_WORDS];
+	}
+	return next;
+}
+
+static void ce_in_push(uint32_t word, uint64_t t)
+{
+	if (!(s_reg[REG(CTL)] & CE_CTL_ENABLE_MASK))
+		return;
+	if (ce_in_used(t) >= CE_FIFO_WORDS) {
+		printf("ce_model: rx fifo overflow\n");
+		exit(1);
+	}
+	if (!s_ce.active)
+		ce_session_start();
+	memcpy(&s_ce.blk[s_ce.blk_len], &word, 4);
+	s_ce.blk_len += 4;
+	if (s_ce.blk_len == ce_block_words() * 4) {
+		ce_block(t);
+		s_ce.blk_len = 0;
+	}
+}
+
+static uint32_t ce_out_pop(uint64_t t)
+{
+	uint32_t word;
+
+	if (ce_out_ready(t) == 0)
+		return 0;
+	word = s_ce.out[s_ce.out_head];
+	s_ce.out_head = (s_ce.out_head + 1) % CE_OUT_WORDS;
+	s_ce.out_cnt--;
+	return word;
+}
+
+static void ce_finish(void)
+{
+	uint32_t ctl = s_reg[REG(CTL)];
+	uint32_t crc;
+	int i;
+
+	if (!s_ce.active)
+		ce_session_start();
+	s_ce.end = 1;
+	s_ce.end_at = ((s_ce.busy > s_now) ? s_ce.busy : s_now) + 2 * CE_CYCLE;
+	switch (s_ce.method) {
+	case CE_CTL_METHOD_SHA1:
+	case CE_CTL_METHOD_SHA256:
+		for (i = 0; i < 5; i++)
+			s_reg[REG(MD0) + i] = __builtin_bswap32(s_ce.h[i]);
+		for (i = 0; i < 3; i++)
+			s_reg[REG(MD5) + i] = __builtin_bswap32(s_ce.h[5 + i]);
+		break;
+	case CE_CTL_METHOD_CRC:
+		crc = s_ce.crc;
+		if (ctl & CE_CTL_CRC_REF_OUT_MASK)
+			crc = ce_reflect(crc, (ce_crc_mask() == 0xFFFF) ? 16 : 32);
+		if (ctl & CE_CTL_CRC_XOR_OUT_MASK)
+			crc ^= ce_crc_mask();
+		s_reg[REG(CRC_RESULT)] = crc;
+		break;
+	default:
+		break;
+	}
+}
+
+static void ce_prng(void)
+{
+	int i;
+
+	if (s_ce.prng == 0)
+		s_ce.prng = s_reg[REG(KEY)] ^ s_reg[REG(KEY) + 5] ^ 0x9E3779B9;
+	for (i = 0; i < 5; i++) {
+		s_ce.prng ^= s_ce.prng << 13;
+		s_ce.prng ^= s_ce.prng >> 17;
+		s_ce.prng ^= s_ce.prng << 5;
+		s_reg[REG(MD0) + i] = s_ce.prng;
+	}
+}
+
+/******************************** registers *********************************/
+
+static uint32_t ce_reg_read(uint32_t reg)
+{
+	uint32_t v = s_reg[reg];
+	uint32_t n;
+
+	if (reg == REG(FCSR)) {
+		v &= CE_FCSR_RXFIFO_INT_TRIG_LEVEL_MASK | CE_FCSR_TXFIFO_INT_TRIG_LEVEL_MASK;
+		n = CE_FIFO_WORDS - ce_in_used(s_now);
+		if (n)
+			v |= CE_FCSR_RXFIFO_STATUS_MASK;
+		v |= n << CE_FCSR_RXFIFO_EMP_CNT_SHIFT;
+		n = ce_out_ready(s_now);
+		if (n > CE_FCSR_TXFIFO_AVA_CNT_VMASK)
+			n = CE_FCSR_TXFIFO_AVA_CNT_VMASK;
+		if (n)
+			v |= CE_FCSR_TXFIFO_STATUS_MASK;
+		v |= n << CE_FCSR_TXFIFO_AVA_CNT_SHIFT;
+	} else if (reg == REG(ICSR)) {
+		if (s_ce.end && s_now >= s_ce.end_at)
+			v |= CE_ICSR_HASH_CRC_END_MASK;
+	}
+	return v;
+}
+
+static void ce_reg_write(uint32_t reg, uint32_t v)
+{
+	uint32_t old = s_reg[reg];
+
+	if (reg == REG(RXFIFO)) {
+		ce_in_push(v, s_now);
+		return;
+	}
+	if (reg == REG(TXFIFO))
+		return;
+	if (reg == REG(ICSR))
+		v &= ~(CE_ICSR_HASH_CRC_END_MASK | CE_ICSR_RXFIFO_EMP_MASK | CE_ICSR_TXFIFO_AVA_MASK);
+	s_reg[reg] = v;
+	if (reg != REG(CTL))
+		return;
+
+	if ((v & CE_CTL_ENABLE_MASK) && !(old & CE_CTL_ENABLE_MASK))
+		ce_session_reset();
+	if (!(v & CE_CTL_ENABLE_MASK))
+		return;
+	if ((CTL_METHOD(v) == CE_CTL_METHOD_PRNG) && (v & CE_CTL_PRNG_START_MASK)) {
+		ce_prng();
+		s_reg[reg] &= ~CE_CTL_PRNG_START_MASK;
+	}
+	if ((v & CE_CTL_END_BIT_MASK) && !(old & CE_CTL_END_BIT_MASK))
+		ce_finish();
+}
+
+static void ce_page_sync(void)
+{
+	uint32_t i;
+
+	for (i = 0; i < REG_NUM; i++)
+		s_page[i] = ce_reg_read(i);
+}
+
+/*
+ * An access to the page faults: fill it in with the registers, open it and
+ * single step the instruction. The trap after it takes a written value and
+ * closes the page again.
+ */
+static void ce_segv(int sig, siginfo_t *si, void *ctx)
+{
+	ucontext_t *uc = ctx;
+	uintptr_t addr = (uintptr_t)si->si_addr;
+
+	if (addr < CE_BASE || addr >= CE_BASE + CE_PAGE_SIZE) {
+		signal(SIGSEGV, SIG_DFL);
+		return;
+	}
+	s_trap_reg = (addr - CE_BASE) / 4;
+	s_trap_write = (uc->uc_mcontext.gregs[REG_ERR] & 0x2) != 0;
+	s_now += COST_REG;
+	ce_model_stat.reg_access++;
+
+	mprotect((void *)s_page, CE_PAGE_SIZE, PROT_READ | PROT_WRITE);
+	ce_page_sync();
+	if (s_trap_reg == REG(TXFIFO) && !s_trap_write)
+		s_page[s_trap_reg] = ce_out_pop(s_now);
+	s_trap_old = s_page[s_trap_reg];
+	uc->uc_mcontext.gregs[REG_EFL] |= 0x100;	/* TF */
+}
+
+static void ce_trap(int sig, siginfo_t *si, void *ctx)
+{
+	ucontext_t *uc = ctx;
+	uint32_t v;
+
+	uc->uc_mcontext.gregs[REG_EFL] &= ~0x100;
+	if (s_trap_reg < REG_NUM) {
+		v = s_page[s_trap_reg];
+		if (s_trap_write || v != s_trap_old)
+			ce_reg_write(s_trap_reg, v);
+	}
+	mprotect((void *)s_page, CE_PAGE_SIZE, PROT_NONE);
+}
+
+/******************************** dma *********************************/
+
+static struct {
+	int			used;
+	DMA_ChannelInitParam param;
+	uint32_t	src;
+	uint32_t	dst;
+	uint32_t	len;
+} s_dma[DMA_CHANNEL_NUM];
+
+static uint64_t s_dma_end;		/* the last transfer ends */
+
+static void ce_dma_end(DMA_Channel chan)
+{
+	if (s_dma[chan].param.endCallback)
+		s_dma[chan].param.endCallback(s_dma[chan].param.endArg);
+}
+
+/* words into the rx fifo, as fast as the bus and the fifo allow */
+static void ce_dma_in(DMA_Channel chan)
+{
+	const uint8_t *src = (const uint8_t *)(uintptr_t)s_dma[chan].src;
+	uint64_t t = s_now;
+	uint32_t i, w;
+
+	for (i = 0; i < s_dma[chan].len; i += 4) {
+		while (ce_in_used(t) >= CE_FIFO_WORDS)
+			t = ce_next_event(t);
+		t += COST_DMA_WORD;
+		memcpy(&w, src + i, 4);
+		ce_in_push(w, t);
+	}
+	s_dma_end = t;
+	ce_dma_end(chan);
+}
+
+/* both channels of a cipher run, sharing the bus, the tx fifo drained first */
+static void ce_dma_inout(DMA_Channel in, DMA_Channel out)
+{
+	const uint8_t *src = (const uint8_t *)(uintptr_t)s_dma[in].src;
+	uint8_t *dst = (uint8_t *)(uintptr_t)s_dma[out].dst;
+	uint64_t t = s_now;
+	uint32_t i = 0, o = 0, w;
+
+	while (o < s_dma[out].len) {
+		if (ce_out_ready(t)) {
+			w = ce_out_pop(t);
+			memcpy(dst + o, &w, 4);
+			o += 4;
+			t += COST_DMA_WORD;
+		} else if (i < s_dma[in].len && ce_in_used(t) < CE_FIFO_WORDS) {
+			memcpy(&w, src + i, 4);
+			t += COST_DMA_WORD;
+			ce_in_push(w, t);
+			i += 4;
+		} else if ((t = ce_next_event(t)) == UINT64_MAX) {
+			printf("ce_model: dma stalled\n");
+			return;		/* no end irq, the driver times out */
+		}
+	}
+	s_dma_end = t;
+	ce_dma_end(in);
+	ce_dma_end(out);
+}
+
+DMA_Channel HAL_DMA_Request(void)
+{
+	int i;
+
+	s_now += COST_DMA_REQUEST;
+	for (i = 0; i < DMA_CHANNEL_NUM; i++) {
+		if (!s_dma[i].used) {
+			s_dma[i].used = 1;
+			return (DMA_Channel)i;
+		}
+	}
+	return DMA_CHANNEL_INVALID;
+}
+
+void HAL_DMA_Release(DMA_Channel chan)
+{
+	s_now += COST_DMA_REQUEST;
+	s_dma[chan].used = 0;
+}
+
+HAL_Status HAL_DMA_Init(DMA_Channel chan, const DMA_ChannelInitParam *param)
+{
+	s_now += COST_DMA_INIT;
+	s_dma[chan].param = *param;
+	return HAL_OK;
+}
+
+HAL_Status HAL_DMA_DeInit(DMA_Channel chan)
+{
+	s_now += COST_DMA_STOP;
+	return HAL_OK;
+}
+
+HAL_Status HAL_DMA_Start(DMA_Channel chan, uint32_t srcAddr, uint32_t dstAddr, uint32_t datalen)
+{
+	int i;
+
+	s_now += COST_DMA_START;
+	ce_model_stat.dma_start++;
+	s_dma[chan].src = srcAddr;
+	s_dma[chan].dst = dstAddr;
+	s_dma[chan].len = datalen;
+	if (!(s_reg[REG(ICSR)] & CE_ICSR_DRQ_ENABLE_MASK) || (datalen & 3)) {
+		printf("ce_model: dma without drq or of %u bytes\n", datalen);
+		return HAL_OK;		/* never ends */
+	}
+
+	if (dstAddr == CE_BASE + REG(RXFIFO) * 4) {
+		switch (CTL_METHOD(s_reg[REG(CTL)])) {
+		case CE_CTL_METHOD_SHA1:
+		case CE_CTL_METHOD_SHA256:
+		case CE_CTL_METHOD_MD5:
+		case CE_CTL_METHOD_CRC:
+			ce_dma_in(chan);
+			break;
+		default:
+			break;		/* waits for the tx channel */
+		}
+	} else if (srcAddr == CE_BASE + REG(TXFIFO) * 4) {
+		for (i = 0; i < DMA_CHANNEL_NUM; i++) {
+			if (i != chan && s_dma[i].used &&
+			    s_dma[i].dst == CE_BASE + REG(RXFIFO) * 4 && s_dma[i].len == datalen)
+				break;
+		}
+		if (i == DMA_CHANNEL_NUM) {
+			printf("ce_model: tx dma without rx dma\n");
+			return HAL_OK;
+		}
+		ce_dma_inout((DMA_Channel)i, chan);
+	}
+	return HAL_OK;
+}
+
+HAL_Status HAL_DMA_Stop(DMA_Channel chan)
+{
+	s_now += COST_DMA_STOP;
+	s_dma[chan].dst = 0;
+	s_dma[chan].src = 0;
+	return HAL_OK;
+}
+
+/******************************** os, ccm *********************************/
+
+HAL_Status HAL_SemaphoreInit(HAL_Semaphore *sem, uint32_t initCount, uint32_t maxCount)
+{
+	sem->count = initCount;
+	return HAL_OK;
+}
+
+HAL_Status HAL_SemaphoreDeinit(HAL_Semaphore *sem)
+{
+	return HAL_OK;
+}
+
+HAL_Status HAL_SemaphoreWait(HAL_Semaphore *sem, uint32_t msec)
+{
+	uint64_t timeout = (uint64_t)msec * (CE_MODEL_CPU_HZ / 1000);
+
+	if (sem->count == 0) {
+		ce_model_stat.idle += timeout;
+		s_now += timeout;
+		return HAL_TIMEOUT;
+	}
+	sem->count--;
+	if (s_dma_end > s_now) {
+		ce_model_stat.idle += s_dma_end - s_now;
+		s_now = s_dma_end + COST_SEM_BLOCK;
+	} else {
+		s_now += COST_SEM;
+	}
+	return HAL_OK;
+}
+
+HAL_Status HAL_SemaphoreRelease(HAL_Semaphore *sem)
+{
+	sem->count++;
+	return HAL_OK;
+}
+
+HAL_Status HAL_MutexInit(HAL_Mutex *mtx)
+{
+	mtx->locked = 0;
+	return HAL_OK;
+}
+
+HAL_Status HAL_MutexDeinit(HAL_Mutex *mtx)
+{
+	return HAL_OK;
+}
+
+HAL_Status HAL_MutexLock(HAL_Mutex *mtx, uint32_t msec)
+{
+	s_now += COST_MUTEX;
+	if (mtx->locked) {
+		printf("ce_model: CE mutex taken twice\n");
+		return HAL_TIMEOUT;
+	}
+	mtx->locked = 1;
+	return HAL_OK;
+}
+
+HAL_Status HAL_MutexUnlock(HAL_Mutex *mtx)
+{
+	s_now += COST_MUTEX;
+	mtx->locked = 0;
+	return HAL_OK;
+}
+
+/* a read-modify-write of a CCM register each */
+void HAL_CCM_BusEnablePeriphClock(uint32_t periphMask)
+{
+	s_now += 2 * COST_REG;
+}
+
+void HAL_CCM_BusDisablePeriphClock(uint32_t periphMask)
+{
+	s_now += 2 * COST_REG;
+}
+
+void HAL_CCM_BusForcePeriphReset(uint32_t periphMask)
+{
+	s_now += 2 * COST_REG;
+}
+
+void HAL_CCM_BusReleasePeriphReset(uint32_t periphMask)
+{
+	s_now += 2 * COST_REG;
+}
+
+void HAL_CCM_CE_SetMClock(CCM_AHBPeriphClkSrc src, CCM_PeriphClkDivN divN, CCM_PeriphClkDivM divM)
+{
+	s_now += 2 * COST_REG;
+}
+
+void HAL_CCM_CE_EnableMClock(void)
+{
+	s_now += 2 * COST_REG;
+}
+
+void HAL_CCM_CE_DisableMClock(void)
+{
+	s_now += 2 * COST_REG;
+}
+
+/******************************** public *********************************/
+
+void ce_model_init(void)
+{
+	struct sigaction sa;
+
+	s_page = mmap((void *)CE_BASE, CE_PAGE_SIZE, PROT_NONE,
+	              MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+	if (s_page != (volatile uint32_t *)CE_BASE) {
+		printf("ce_model: cannot map the registers at 0x%x\n", CE_BASE);
+		exit(1);
+	}
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_flags = SA_SIGINFO;
+	sa.sa_sigaction = ce_segv;
+	sigaction(SIGSEGV, &sa, NULL);
+	sa.sa_sigaction = ce_trap;
+	sigaction(SIGTRAP, &sa, NULL);
+
+	memset(s_reg, 0, sizeof(s_reg));
+	ce_session_reset();
+	ce_model_reset_stat();
+}
+
+void ce_model_reset_stat(void)
+{
+	memset(&ce_model_stat, 0, sizeof(ce_model_stat));
+	memset(&s_ce.pend_start, 0, sizeof(s_ce.pend_start));
+	s_ce.busy = 0;
+	s_ce.end_at = 0;
+	s_dma_end = 0;
+}
+
+struct ce_model_call {
+	int (*fn)(void *arg);
+	void *arg;
+	int ret;
+};
+
+static void *ce_model_thread(void *arg)
+{
+	struct ce_model_call *call = arg;
+
+	call->ret = call->fn(call->arg);
+	return NULL;
+}
+
+int ce_model_run(int (*fn)(void *arg), void *arg)
+{
+	struct ce_model_call call = { fn, arg, -1 };
+	size_t size = 8 * 1024 * 1024;
+	pthread_attr_t attr;
+	pthread_t thread;
+	void *stack;
+
+	/* heap from brk only, below 4G as well */
+	mallopt(M_ARENA_MAX, 1);
+	mallopt(M_MMAP_MAX, 0);
+	stack = mmap(NULL, size, PROT_READ | PROT_WRITE,
+	             MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT | MAP_STACK, -1, 0);
+	if (stack == MAP_FAILED) {
+		printf("ce_model: no stack below 4G\n");
+		return -1;
+	}
+	pthread_attr_init(&attr);
+	pthread_attr_setstack(&attr, stack, size);
+	pthread_create(&thread, &attr, ce_model_thread, &call);
+	pthread_join(thread, NULL);
+	pthread_attr_destroy(&attr);
+	munmap(stack, size);
+	return call.ret;
+}
+
+void ce_ref_aes(int cbc, int enc, const uint8_t *key, uint32_t bits, uint8_t iv[16],
+                const uint8_t *in, uint8_t *out, uint32_t len)
+{
+	mbedtls_aes_context aes;
+	int mode = enc ? MBEDTLS_AES_ENCRYPT : MBEDTLS_AES_DECRYPT;
+	uint32_t i;
+
+	mbedtls_aes_init(&aes);
+	if (enc)
+		mbedtls_aes_setkey_enc(&aes, key, bits);
+	else
+		mbedtls_aes_setkey_dec(&aes, key, bits);
+	if (cbc) {
+		mbedtls_aes_crypt_cbc(&aes, mode, len, iv, in, out);
+	} else {
+		for (i = 0; i < len; i += 16)
+			mbedtls_aes_crypt_ecb(&aes, mode, in + i, out + i);
+	}
+	mbedtls_aes_free(&aes);
+}
+
+void ce_ref_aes_ctr(const uint8_t *key, uint32_t bits, uint8_t nc[16],
+                    const uint8_t *in, uint8_t *out, uint32_t len)
+{
+	mbedtls_aes_context aes;
+	uint8_t stream[16];
+	size_t off = 0;
+
+	mbedtls_aes_init(&aes);
+	mbedtls_aes_setkey_enc(&aes, key, bits);
+	mbedtls_aes_crypt_ctr(&aes, len, &off, nc, stream, in, out);
+	mbedtls_aes_free(&aes);
+}
+
+void ce_ref_sha1(const uint8_t *in, uint32_t len, uint8_t out[20])
+{
+	mbedtls_sha1_ret(in, len, out);
+}
+
+void ce_ref_sha256(const uint8_t *in, uint32_t len, uint8_t out[32])
+{
+	mbedtls_sha256_ret(in, len, out, 0);
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _CE_SIM_CE_MODEL_H_
+#define _CE_SIM_CE_MODEL_H_
+
+#include <stdint.h>
+
+/*
+ * Crypto engine registers in a page at CE_BASE, under the unmodified
+ * hal_crypto.c. The page is kept inaccessible: every access of the driver
+ * traps, is single stepped and applied to the model, so FIFO writes, reads
+ * and status polls behave as on the chip. AES, SHA-1, SHA-256, CRC and the
+ * PRNG are computed in software, DMA to and from the FIFOs and the OS calls
+ * of the driver are stubbed here as well.
+ *
+ * Time is counted in CPU cycles at 160 MHz with the CE clock at 80 MHz:
+ *   register access      4 (the polling loop around it included)
+ *   AES block            Nr + 2 CE cycles, SHA-1 84, SHA-256 68, CRC 1 per word
+ *   DMA word             4 per channel, the channels share the bus
+ *   DMA request/release  50, init 100, start 60, stop/deinit 30
+ *   mutex lock/unlock    40, blocking on a semaphore 300 (irq and switch back)
+ * The driver's own instructions between the register accesses are not
+ * counted. While the driver blocks on a DMA transfer the CPU is idle, so
+ * cpu = cycles - idle is the time other threads lose.
+ *
+ * Data passed to the driver must have a 32-bit address: the binary is linked
+ * without PIE and ce_model_run() runs the code on a stack below 4G, with
+ * malloc() kept to the heap after the data.
+ */
+
+#define CE_MODEL_CPU_HZ		(160 * 1000 * 1000)
+
+struct ce_model_stat {
+	uint64_t	cycles;		/* wall time */
+	uint64_t	idle;		/* blocked on a DMA transfer */
+	uint32_t	reg_access;
+	uint32_t	dma_start;
+	uint32_t	blocks;		/* AES, SHA and CRC blocks of the engine */
+};
+
+extern struct ce_model_stat ce_model_stat;
+extern uint32_t ce_model_hash_dma_min;	/* CE_CRC_HASH_DMA_MIN of the driver */
+
+void ce_model_init(void);
+void ce_model_reset_stat(void);
+int ce_model_run(int (*fn)(void *arg), void *arg);
+
+/* software reference, the code the engine computes with */
+void ce_ref_aes(int cbc, int enc, const uint8_t *key, uint32_t bits, uint8_t iv[16],
+                const uint8_t *in, uint8_t *out, uint32_t len);
+void ce_ref_aes_ctr(const uint8_t *key, uint32_t bits, uint8_t nc[16],
+                    const uint8_t *in, uint8_t *out, uint32_t len);
+void ce_ref_sha1(const uint8_t *in, uint32_t len, uint8_t out[20]);
+void ce_ref_sha256(const uint8_t *in, uint32_t len, uint8_t out[32]);
+
+#endif /* _CE_SIM_CE_MODEL_H_ */
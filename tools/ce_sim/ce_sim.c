@@ -0,0 +1,492 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Test and benchmark of the crypto engine driver and the mbedtls offload
+ * modules on the CE register model.
+ *
+ * usage: ce_sim test
+ *        ce_sim bench
+ *
+ * The test runs AES ECB/CBC, SHA-1, SHA-256 and CRC through the driver, by
+ * CPU and by DMA, the hash and CRC input split in pieces of every alignment,
+ * and checks them against software. Then the mbedtls calls of the offload
+ * modules: AES, SHA-1 and SHA-256 against software, the GCM self test, CTR
+ * in pieces and a cloned SHA-256 context. (The AES and SHA self tests of
+ * mbedtls pass as well, but take minutes on the model.)
+ *
+ * The bench gives bytes per cycle: software on this host (host cycles), and
+ * the modeled CPU cycles of the offloaded paths, wall time and the part of
+ * it the CPU is busy. Hashing is run by CPU and by DMA at every size.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <x86intrin.h>
+
+#include "driver/chip/hal_crypto.h"
+#include "mbedtls/aes.h"
+#include "mbedtls/gcm.h"
+#include "mbedtls/sha1.h"
+#include "mbedtls/sha256.h"
+#include "ce_model.h"
+
+#define SIM_BUF_SIZE	(16 * 1024 + 64)
+
+static uint8_t sim_in[SIM_BUF_SIZE];
+static uint8_t sim_out[SIM_BUF_SIZE];
+static uint8_t sim_ref[SIM_BUF_SIZE];
+static int sim_fail;
+
+#define SIM_CHECK(cond, fmt, arg...)								\
+	do {															\
+		if (!(cond)) {												\
+			printf("FAIL %s():%d, " fmt "\n", __func__, __LINE__, ##arg);	\
+			sim_fail = 1;											\
+		}															\
+	} while (0)
+
+static uint32_t sim_rand_state = 1;
+
+static uint32_t sim_rand(void)
+{
+	sim_rand_state ^= sim_rand_state << 13;
+	sim_rand_state ^= sim_rand_state >> 17;
+	sim_rand_state ^= sim_rand_state << 5;
+	return sim_rand_state;
+}
+
+static void sim_fill(uint8_t *buf, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = sim_rand();
+}
+
+/******************************** test *********************************/
+
+static const CE_AES_KeySize sim_keysize[] = {
+	CE_CTL_AES_KEYSIZE_128BITS, CE_CTL_AES_KEYSIZE_192BITS, CE_CTL_AES_KEYSIZE_256BITS
+};
+
+static void test_aes(void)
+{
+	static const uint32_t sizes[] = { 16, 32, 100, 288, 304, 320, 1000, 1024, 4096 };
+	CE_AES_Config aes;
+	uint8_t iv[16], iv_ref[16];
+	uint32_t k, m, s, len, bits;
+	int cbc;
+
+	for (k = 0; k < 3; k++) {
+		bits = 128 + 64 * k;
+		for (m = 0; m < 2; m++) {
+			cbc = (m == 1);
+			for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+				len = (sizes[s] + 15) & ~15U;
+				memset(&aes, 0, sizeof(aes));
+				aes.mode = cbc ? CE_CRYPT_MODE_CBC : CE_CRYPT_MODE_ECB;
+				aes.src = CE_CTL_KEYSOURCE_INPUT;
+				aes.keysize = sim_keysize[k];
+				sim_fill(aes.key, 32);
+				sim_fill(iv, 16);
+				memcpy(aes.iv, iv, 16);
+				sim_fill(sim_in, len);
+				memset(sim_in + sizes[s], 0, len - sizes[s]);	/* the driver pads with zeros */
+
+				SIM_CHECK(HAL_AES_Encrypt(&aes, sim_in, sim_out, sizes[s]) == HAL_OK,
+				          "encrypt %u", sizes[s]);
+				memcpy(iv_ref, iv, 16);
+				ce_ref_aes(cbc, 1, aes.key, bits, iv_ref, sim_in, sim_ref, len);
+				SIM_CHECK(memcmp(sim_out, sim_ref, len) == 0,
+				          "AES-%u %s encrypt %u", bits, cbc ? "CBC" : "ECB", sizes[s]);
+				if (cbc)
+					SIM_CHECK(memcmp(aes.iv, iv_ref, 16) == 0, "CBC iv out, %u", sizes[s]);
+
+				memcpy(aes.iv, iv, 16);
+				SIM_CHECK(HAL_AES_Decrypt(&aes, sim_ref, sim_out, len) == HAL_OK,
+				          "decrypt %u", len);
+				SIM_CHECK(memcmp(sim_out, sim_in, len) == 0,
+				          "AES-%u %s decrypt %u", bits, cbc ? "CBC" : "ECB", len);
+				if (cbc)
+					SIM_CHECK(memcmp(aes.iv, iv_ref, 16) == 0, "CBC iv in, %u", len);
+			}
+		}
+	}
+}
+
+/* pieces of 1..max bytes, so every alignment of the data and the word buffer occurs */
+static uint32_t sim_piece(uint32_t left, uint32_t max)
+{
+	uint32_t n = 1 + sim_rand() % max;
+
+	return (n < left) ? n : left;
+}
+
+static void test_hash(uint32_t total, uint32_t max_piece)
+{
+	CE_SHA1_Handler sha1;
+	CE_SHA256_Handler sha256;
+	uint32_t digest[8];
+	uint8_t ref[32];
+	uint32_t off, n;
+
+	sim_fill(sim_in, total);
+
+	SIM_CHECK(HAL_SHA1_Init(&sha1, CE_CTL_IVMODE_SHA_MD5_FIPS180, NULL) == HAL_OK, "sha1 init");
+	for (off = 0; off < total; off += n) {
+		n = sim_piece(total - off, max_piece);
+		SIM_CHECK(HAL_SHA1_Append(&sha1, sim_in + off, n) == HAL_OK, "sha1 append");
+	}
+	SIM_CHECK(HAL_SHA1_Finish(&sha1, digest) == HAL_OK, "sha1 finish");
+	ce_ref_sha1(sim_in, total, ref);
+	SIM_CHECK(memcmp(digest, ref, 20) == 0, "SHA-1 of %u in pieces up to %u", total, max_piece);
+
+	SIM_CHECK(HAL_SHA256_Init(&sha256, CE_CTL_IVMODE_SHA_MD5_FIPS180, NULL) == HAL_OK,
+	          "sha256 init");
+	for (off = 0; off < total; off += n) {
+		n = sim_piece(total - off, max_piece);
+		SIM_CHECK(HAL_SHA256_Append(&sha256, sim_in + off, n) == HAL_OK, "sha256 append");
+	}
+	SIM_CHECK(HAL_SHA256_Finish(&sha256, digest) == HAL_OK, "sha256 finish");
+	ce_ref_sha256(sim_in, total, ref);
+	SIM_CHECK(memcmp(digest, ref, 32) == 0, "SHA-256 of %u in pieces up to %u", total, max_piece);
+}
+
+/* bit by bit, the reflected form */
+static uint32_t sim_crc32(const uint8_t *p, uint32_t len)
+{
+	uint32_t crc = 0xFFFFFFFF;
+	int i;
+
+	while (len--) {
+		crc ^= *p++;
+		for (i = 0; i < 8; i++)
+			crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+	}
+	return ~crc;
+}
+
+static uint32_t test_crc_run(CE_CRC_Types type, uint8_t *data, uint32_t total, uint32_t max_piece)
+{
+	CE_CRC_Handler crc;
+	uint32_t off, n, v = 0;
+
+	SIM_CHECK(HAL_CRC_Init(&crc, type, total) == HAL_OK, "crc init");
+	for (off = 0; off < total; off += n) {
+		n = sim_piece(total - off, max_piece);
+		SIM_CHECK(HAL_CRC_Append(&crc, data + off, n) == HAL_OK, "crc append");
+	}
+	SIM_CHECK(HAL_CRC_Finish(&crc, &v) == HAL_OK, "crc finish");
+	return v;
+}
+
+static void test_crc(void)
+{
+	uint8_t check[] = "123456789";
+	uint32_t v;
+
+	v = test_crc_run(CE_CRC32, check, 9, 9);
+	SIM_CHECK(v == 0xCBF43926, "CRC-32 check 0x%08x", v);
+	v = test_crc_run(CE_CRC16_MODBUS, check, 9, 4);
+	SIM_CHECK(v == 0x4B37, "CRC-16/MODBUS check 0x%04x", v);
+	v = test_crc_run(CE_CRC16_XMODEM, check, 9, 2);
+	SIM_CHECK(v == 0x31C3, "CRC-16/XMODEM check 0x%04x", v);
+
+	sim_fill(sim_in, 9000);
+	v = test_crc_run(CE_CRC32, sim_in, 9000, 3000);
+	SIM_CHECK(v == sim_crc32(sim_in, 9000), "CRC-32 of 9000 0x%08x", v);
+	v = test_crc_run(CE_CRC32, sim_in + 1, 8191, 8191);
+	SIM_CHECK(v == sim_crc32(sim_in + 1, 8191), "CRC-32 of 8191 0x%08x", v);
+}
+
+static void test_prng(void)
+{
+	uint32_t seed[6] = { 1, 2, 3, 4, 5, 6 };
+	uint8_t r1[50], r2[50];
+
+	HAL_PRNG_SetSeed(seed);
+	SIM_CHECK(HAL_PRNG_Generate(r1, sizeof(r1)) == HAL_OK, "prng");
+	SIM_CHECK(HAL_PRNG_Generate(r2, sizeof(r2)) == HAL_OK, "prng");
+	SIM_CHECK(memcmp(r1, r2, sizeof(r1)) != 0, "prng repeats");
+}
+
+/* the mbedtls entry points of the offload modules, one call each */
+static void test_alt(void)
+{
+	static const uint32_t sizes[] = { 0, 1, 55, 56, 63, 64, 65, 1000, 5000 };
+	mbedtls_aes_context aes;
+	uint8_t key[32], iv0[16], iv[16], iv_ref[16], ref[32];
+	uint32_t i, bits;
+
+	for (bits = 128; bits <= 256; bits += 64) {
+		sim_fill(key, 32);
+		sim_fill(iv0, 16);
+		memcpy(iv, iv0, 16);
+		sim_fill(sim_in, 1008);
+		mbedtls_aes_init(&aes);
+		mbedtls_aes_setkey_enc(&aes, key, bits);
+		SIM_CHECK(mbedtls_aes_crypt_ecb(&aes, MBEDTLS_AES_ENCRYPT, sim_in, sim_out) == 0, "ecb");
+		memcpy(iv_ref, iv, 16);
+		SIM_CHECK(mbedtls_aes_crypt_cbc(&aes, MBEDTLS_AES_ENCRYPT, 1008, iv, sim_in,
+		                                sim_out + 16) == 0, "cbc");
+		mbedtls_aes_free(&aes);
+		ce_ref_aes(0, 1, key, bits, NULL, sim_in, sim_ref, 16);
+		ce_ref_aes(1, 1, key, bits, iv_ref, sim_in, sim_ref + 16, 1008);
+		SIM_CHECK(memcmp(sim_out, sim_ref, 16 + 1008) == 0, "AES-%u ECB/CBC encrypt", bits);
+		SIM_CHECK(memcmp(iv, iv_ref, 16) == 0, "AES-%u CBC iv", bits);
+
+		mbedtls_aes_init(&aes);
+		mbedtls_aes_setkey_dec(&aes, key, bits);
+		SIM_CHECK(mbedtls_aes_crypt_ecb(&aes, MBEDTLS_AES_DECRYPT, sim_ref, sim_out) == 0, "ecb");
+		memcpy(iv, iv0, 16);
+		SIM_CHECK(mbedtls_aes_crypt_cbc(&aes, MBEDTLS_AES_DECRYPT, 1008, iv, sim_ref + 16,
+		                                sim_out + 16) == 0, "cbc");
+		mbedtls_aes_free(&aes);
+		SIM_CHECK(memcmp(sim_out, sim_in, 16) == 0, "AES-%u ECB decrypt", bits);
+		SIM_CHECK(memcmp(sim_out + 16, sim_in, 1008) == 0, "AES-%u CBC decrypt", bits);
+	}
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		sim_fill(sim_in, sizes[i]);
+		mbedtls_sha1_ret(sim_in, sizes[i], sim_out);
+		ce_ref_sha1(sim_in, sizes[i], ref);
+		SIM_CHECK(memcmp(sim_out, ref, 20) == 0, "mbedtls SHA-1 of %u", sizes[i]);
+		mbedtls_sha256_ret(sim_in, sizes[i], sim_out, 0);
+		ce_ref_sha256(sim_in, sizes[i], ref);
+		SIM_CHECK(memcmp(sim_out, ref, 32) == 0, "mbedtls SHA-256 of %u", sizes[i]);
+	}
+}
+
+static void test_ctr(void)
+{
+	static const uint32_t pieces[] = { 5, 100, 3, 16, 400, 1, 2000, 475 };
+	mbedtls_aes_context aes;
+	uint8_t key[32], nc[16], nc_ref[16], stream[16];
+	size_t off = 0, pos = 0;
+	uint32_t i;
+
+	sim_fill(key, 32);
+	memset(nc, 0, 16);
+	memset(nc + 12, 0xFF, 3);
+	nc[15] = 0xF0;		/* carries into the upper words on the way */
+	memcpy(nc_ref, nc, 16);
+	sim_fill(sim_in, 3000);
+
+	mbedtls_aes_init(&aes);
+	mbedtls_aes_setkey_enc(&aes, key, 256);
+	for (i = 0; i < sizeof(pieces) / sizeof(pieces[0]); i++) {
+		SIM_CHECK(mbedtls_aes_crypt_ctr(&aes, pieces[i], &off, nc, stream,
+		                                sim_in + pos, sim_out + pos) == 0, "ctr");
+		pos += pieces[i];
+	}
+	mbedtls_aes_free(&aes);
+	ce_ref_aes_ctr(key, 256, nc_ref, sim_in, sim_ref, pos);
+	SIM_CHECK(memcmp(sim_out, sim_ref, pos) == 0, "CTR of %u bytes in pieces", (uint32_t)pos);
+	SIM_CHECK(memcmp(nc, nc_ref, 16) == 0, "CTR counter");
+}
+
+static void test_clone(void)
+{
+	mbedtls_sha256_context a, b;
+	uint8_t d1[32], d2[32], ref[32];
+
+	sim_fill(sim_in, 3000);
+	mbedtls_sha256_init(&a);
+	mbedtls_sha256_init(&b);
+	mbedtls_sha256_starts_ret(&a, 0);
+	mbedtls_sha256_update_ret(&a, sim_in, 3);
+	mbedtls_sha256_update_ret(&a, sim_in + 3, 1200);
+	mbedtls_sha256_clone(&b, &a);
+	mbedtls_sha256_update_ret(&a, sim_in + 1203, 1797);
+	mbedtls_sha256_update_ret(&b, sim_in + 1203, 797);		/* interleaved */
+	mbedtls_sha256_finish_ret(&a, d1);
+	mbedtls_sha256_finish_ret(&b, d2);
+	ce_ref_sha256(sim_in, 3000, ref);
+	SIM_CHECK(memcmp(d1, ref, 32) == 0, "SHA-256 context");
+	ce_ref_sha256(sim_in, 2000, ref);
+	SIM_CHECK(memcmp(d2, ref, 32) == 0, "SHA-256 cloned context");
+	mbedtls_sha256_free(&a);
+	mbedtls_sha256_free(&b);
+}
+
+static int sim_test(void *arg)
+{
+	uint32_t dma_min[] = { 0xFFFFFFFF, 0, 1024 };
+	uint32_t dma_start[3];
+	uint32_t i;
+
+	HAL_CE_Init();
+	for (i = 0; i < 3; i++) {
+		ce_model_hash_dma_min = dma_min[i];
+		ce_model_reset_stat();
+		test_aes();
+		test_hash(0, 1);
+		test_hash(55, 55);
+		test_hash(64, 64);
+		test_hash(5000, 5000);
+		test_hash(5000, 700);
+		test_hash(16000, 100);
+		test_crc();
+		printf("hash dma from %u: %u register accesses, %u dma transfers, %u blocks\n",
+		       dma_min[i], ce_model_stat.reg_access, ce_model_stat.dma_start,
+		       ce_model_stat.blocks);
+		dma_start[i] = ce_model_stat.dma_start;
+	}
+	/* the cipher DMA runs are the same, more come from the hash and crc */
+	SIM_CHECK(dma_start[1] > dma_start[2] && dma_start[2] > dma_start[0], "hash dma not used");
+	test_prng();
+
+	test_alt();
+	SIM_CHECK(mbedtls_gcm_self_test(0) == 0, "gcm self test");
+	test_ctr();
+	test_clone();
+
+	printf("%s\n", sim_fail ? "FAILED" : "ok");
+	return sim_fail;
+}
+
+/******************************** bench *********************************/
+
+static const uint32_t bench_size[] = { 64, 256, 512, 1024, 2048, 4096, 16384 };
+
+#define BENCH_SIZES		(sizeof(bench_size) / sizeof(bench_size[0]))
+
+/* host cycles a byte of the software path, best of a few runs */
+static double bench_host(void (*fn)(uint32_t len), uint32_t len)
+{
+	uint64_t t, best = UINT64_MAX;
+	int i;
+
+	for (i = 0; i < 20; i++) {
+		t = __rdtsc();
+		fn(len);
+		t = __rdtsc() - t;
+		if (t < best)
+			best = t;
+	}
+	return (double)best / len;
+}
+
+static void bench_sw_aes(uint32_t len)
+{
+	uint8_t key[16] = { 0 }, iv[16] = { 0 };
+
+	ce_ref_aes(1, 1, key, 128, iv, sim_in, sim_out, len);
+}
+
+static void bench_sw_sha1(uint32_t len)
+{
+	ce_ref_sha1(sim_in, len, sim_out);
+}
+
+static void bench_sw_sha256(uint32_t len)
+{
+	ce_ref_sha256(sim_in, len, sim_out);
+}
+
+static void bench_ce_aes(uint32_t len)
+{
+	CE_AES_Config aes;
+
+	memset(&aes, 0, sizeof(aes));
+	aes.mode = CE_CRYPT_MODE_CBC;
+	aes.keysize = CE_CTL_AES_KEYSIZE_128BITS;
+	HAL_AES_Encrypt(&aes, sim_in, sim_out, len);
+}
+
+static void bench_ce_sha1(uint32_t len)
+{
+	mbedtls_sha1_ret(sim_in, len, sim_out);
+}
+
+static void bench_ce_sha256(uint32_t len)
+{
+	mbedtls_sha256_ret(sim_in, len, sim_out, 0);
+}
+
+static void bench_row(const char *name, void (*sw)(uint32_t len), void (*ce)(uint32_t len),
+                      uint32_t dma_min)
+{
+	char buf[32];
+	uint32_t i;
+
+	printf("%-22s", name);
+	for (i = 0; i < BENCH_SIZES; i++) {
+		if (sw) {
+			printf(" %10.3f", 1 / bench_host(sw, bench_size[i]));
+			continue;
+		}
+		ce_model_hash_dma_min = dma_min;
+		ce_model_reset_stat();
+		ce(bench_size[i]);
+		snprintf(buf, sizeof(buf), "%.2f/%.2f", (double)bench_size[i] / ce_model_stat.cycles,
+		         (double)bench_size[i] / (ce_model_stat.cycles - ce_model_stat.idle));
+		printf(" %10s", buf);
+	}
+	printf("\n");
+}
+
+static int sim_bench(void *arg)
+{
+	uint32_t i;
+
+	HAL_CE_Init();
+	sim_fill(sim_in, SIM_BUF_SIZE);
+
+	printf("bytes/cycle; software in host cycles, CE in modeled cycles as wall/cpu\n");
+	printf("%-22s", "");
+	for (i = 0; i < BENCH_SIZES; i++)
+		printf(" %10u", bench_size[i]);
+	printf("\n");
+
+	bench_row("AES-128-CBC sw host", bench_sw_aes, NULL, 0);
+	bench_row("AES-128-CBC CE", NULL, bench_ce_aes, 0);
+	bench_row("SHA-1 sw host", bench_sw_sha1, NULL, 0);
+	bench_row("SHA-1 CE by cpu", NULL, bench_ce_sha1, 0xFFFFFFFF);
+	bench_row("SHA-1 CE by dma", NULL, bench_ce_sha1, 0);
+	bench_row("SHA-256 sw host", bench_sw_sha256, NULL, 0);
+	bench_row("SHA-256 CE by cpu", NULL, bench_ce_sha256, 0xFFFFFFFF);
+	bench_row("SHA-256 CE by dma", NULL, bench_ce_sha256, 0);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	ce_model_init();
+	if (argc >= 2 && strcmp(argv[1], "test") == 0)
+		return ce_model_run(sim_test, NULL);
+	if (argc >= 2 && strcmp(argv[1], "bench") == 0)
+		return ce_model_run(sim_bench, NULL);
+
+	printf("usage: %s test\n"
+	       "       %s bench\n", argv[0], argv[0]);
+	return 2;
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Software AES, SHA-1 and SHA-256 under their own names, so they link next
+ * to the CE offload modules.
+ */
+
+#ifndef _CE_SIM_CE_SIM_SW_H_
+#define _CE_SIM_CE_SIM_SW_H_
+
+#define mbedtls_aes_context				sw_aes_context
+#define mbedtls_aes_xts_context			sw_aes_xts_context
+#define mbedtls_aes_init				sw_aes_init
+#define mbedtls_aes_free				sw_aes_free
+#define mbedtls_aes_setkey_enc			sw_aes_setkey_enc
+#define mbedtls_aes_setkey_dec			sw_aes_setkey_dec
+#define mbedtls_aes_crypt_ecb			sw_aes_crypt_ecb
+#define mbedtls_aes_crypt_cbc			sw_aes_crypt_cbc
+#define mbedtls_aes_crypt_ctr			sw_aes_crypt_ctr
+#define mbedtls_internal_aes_encrypt	sw_internal_aes_encrypt
+#define mbedtls_internal_aes_decrypt	sw_internal_aes_decrypt
+#define mbedtls_aes_encrypt				sw_aes_encrypt
+#define mbedtls_aes_decrypt				sw_aes_decrypt
+#define mbedtls_aes_self_test			sw_aes_self_test
+
+#define mbedtls_sha1_context			sw_sha1_context
+#define mbedtls_sha1_init				sw_sha1_init
+#define mbedtls_sha1_free				sw_sha1_free
+#define mbedtls_sha1_clone				sw_sha1_clone
+#define mbedtls_sha1_starts_ret			sw_sha1_starts_ret
+#define mbedtls_sha1_update_ret			sw_sha1_update_ret
+#define mbedtls_sha1_finish_ret			sw_sha1_finish_ret
+#define mbedtls_internal_sha1_process	sw_internal_sha1_process
+#define mbedtls_sha1_starts				sw_sha1_starts
+#define mbedtls_sha1_update				sw_sha1_update
+#define mbedtls_sha1_finish				sw_sha1_finish
+#define mbedtls_sha1_process			sw_sha1_process
+#define mbedtls_sha1_ret				sw_sha1_ret
+#define mbedtls_sha1					sw_sha1
+#define mbedtls_sha1_self_test			sw_sha1_self_test
+
+#define mbedtls_sha256_context			sw_sha256_context
+#define mbedtls_sha256_init				sw_sha256_init
+#define mbedtls_sha256_free				sw_sha256_free
+#define mbedtls_sha256_clone			sw_sha256_clone
+#define mbedtls_sha256_starts_ret		sw_sha256_starts_ret
+#define mbedtls_sha256_update_ret		sw_sha256_update_ret
+#define mbedtls_sha256_finish_ret		sw_sha256_finish_ret
+#define mbedtls_internal_sha256_process	sw_internal_sha256_process
+#define mbedtls_sha256_starts			sw_sha256_starts
+#define mbedtls_sha256_update			sw_sha256_update
+#define mbedtls_sha256_finish			sw_sha256_finish
+#define mbedtls_sha256_process			sw_sha256_process
+#define mbedtls_sha256_ret				sw_sha256_ret
+#define mbedtls_sha256					sw_sha256
+#define mbedtls_sha256_self_test		sw_sha256_self_test
+
+#endif /* _CE_SIM_CE_SIM_SW_H_ */
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* OS services of the driver, implemented by the model with their cost in cycles. */
+
+#ifndef _DRIVER_CHIP_PRIVATE_HAL_OS_H_
+#define _DRIVER_CHIP_PRIVATE_HAL_OS_H_
+
+#include <string.h>
+#include "driver/chip/hal_def.h"
+
+typedef struct {
+	int count;
+} HAL_Semaphore;
+
+typedef struct {
+	int locked;
+} HAL_Mutex;
+
+HAL_Status HAL_SemaphoreInit(HAL_Semaphore *sem, uint32_t initCount, uint32_t maxCount);
+HAL_Status HAL_SemaphoreDeinit(HAL_Semaphore *sem);
+HAL_Status HAL_SemaphoreWait(HAL_Semaphore *sem, uint32_t msec);
+HAL_Status HAL_SemaphoreRelease(HAL_Semaphore *sem);
+
+HAL_Status HAL_MutexInit(HAL_Mutex *mtx);
+HAL_Status HAL_MutexDeinit(HAL_Mutex *mtx);
+HAL_Status HAL_MutexLock(HAL_Mutex *mtx, uint32_t msec);
+HAL_Status HAL_MutexUnlock(HAL_Mutex *mtx);
+
+#define HAL_Memcpy(d, s, l)	memcpy(d, s, l)
+#define HAL_Memset(d, c, l)	memset(d, c, l)
+
+#endif /* _DRIVER_CHIP_PRIVATE_HAL_OS_H_ */
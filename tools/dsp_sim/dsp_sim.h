@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Helpers shared by the host tests of libdsp. */
+
+#ifndef _DSP_SIM_H_
+#define _DSP_SIM_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <x86intrin.h>
+
+#define SIM_FAIL(fmt, arg...)									\
+	do {														\
+		printf("FAIL %s():%d, " fmt "\n", __func__, __LINE__, ##arg);	\
+		exit(1);												\
+	} while (0)
+
+static inline uint64_t sim_cycles(void)
+{
+	return __rdtsc();
+}
+
+/* full scale sine of amp at freq, fs, into every channel */
+static inline void sim_sine(int16_t *pcm, uint32_t frames, uint32_t channels,
+                            double amp, double freq, double fs)
+{
+	uint32_t i, c;
+	int16_t v;
+
+	for (i = 0; i < frames; i++) {
+		v = (int16_t)lrint(amp * sin(2 * M_PI * freq * i / fs));
+		for (c = 0; c < channels; c++)
+			pcm[i * channels + c] = v;
+	}
+}
+
+/*
+ * THD+N in dB of n samples (every step-th of pcm) around a sine of freq, fs:
+ * the sine is fitted by least squares, amplitude and phase, and what is left
+ * is noise and distortion.
+ */
+static inline double sim_thdn(const int16_t *pcm, uint32_t n, uint32_t step,
+                              double freq, double fs)
+{
+	double ss = 0, cc = 0, sc = 0, ys = 0, yc = 0, det, a, b, w, y, r;
+	double err = 0, pwr = 0;
+	uint32_t i;
+
+	for (i = 0; i < n; i++) {
+		w = 2 * M_PI * freq * i / fs;
+		y = pcm[i * step];
+		ss += sin(w) * sin(w);
+		cc += cos(w) * cos(w);
+		sc += sin(w) * cos(w);
+		ys += y * sin(w);
+		yc += y * cos(w);
+	}
+	det = ss * cc - sc * sc;
+	a = (ys * cc - yc * sc) / det;
+	b = (yc * ss - ys * sc) / det;
+	for (i = 0; i < n; i++) {
+		w = 2 * M_PI * freq * i / fs;
+		r = a * sin(w) + b * cos(w);
+		y = pcm[i * step];
+		err += (y - r) * (y - r);
+		pwr += r * r;
+	}
+	return 10 * log10(err / pwr);
+}
+
+/* rms of n samples, every step-th of pcm, in dB of a full scale amp sine */
+static inline double sim_level(const int16_t *pcm, uint32_t n, uint32_t step, double amp)
+{
+	double sum = 0;
+	uint32_t i;
+
+	for (i = 0; i < n; i++)
+		sum += (double)pcm[i * step] * pcm[i * step];
+	return 10 * log10(sum / n / (amp * amp / 2) + 1e-20);
+}
+
+#endif /* _DSP_SIM_H_ */
@@ -0,0 +1,448 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host test and benchmark of the biquad equalizer, on the C path.
+ * biquad_eq.c is built in, for the filter design of the reference.
+ *
+ * usage: eq_sim test
+ *        eq_sim bench
+ *
+ * The test, at 48 kHz, checks:
+ *  - the response of a 10 band preset against the float design, 20 Hz to
+ *    20 kHz, and the gain of single bands where it is known,
+ *  - the SNR against the same cascade in double precision, for the preset
+ *    and for narrow low bands; the same cascade with Q15 coefficients and
+ *    16-bit states, as a dual 16-bit multiply (SMLAD) would run it, is printed
+ *    alongside,
+ *  - that a band switched in while running makes less high frequency
+ *    energy than switching it at once, and that the auto headroom keeps a
+ *    band boosted on the signal from clipping,
+ *  - that band changes in the middle of a ramp end bit-identical to the
+ *    same bands set before processing.
+ *
+ * The bench prints cycles per stereo frame for 1, 5 and 10 bands.
+ */
+
+#include "dsp_sim.h"
+#include "biquad_eq.c"
+
+#define SIM_FS			48000
+#define SIM_FRAMES		SIM_FS
+#define SIM_RESP_DB		0.05	/* from the design */
+#define SIM_SNR_DB		60.0
+#define SIM_CLICK_DB	(-70.0)	/* above 4 kHz, of the total, ramped */
+
+static const eq_core_prms_t sim_preset[10] = {
+	{  6,    60, 0.7f, LOWPASS_SHELVING },
+	{ -3,   120, 1.2f, BANDPASS_PEAK },
+	{  4,   250, 1.0f, BANDPASS_PEAK },
+	{ -2,   500, 1.0f, BANDPASS_PEAK },
+	{  3,  1000, 1.4f, BANDPASS_PEAK },
+	{ -4,  2000, 2.0f, BANDPASS_PEAK },
+	{  5,  4000, 1.0f, BANDPASS_PEAK },
+	{ -6,  8000, 0.9f, BANDPASS_PEAK },
+	{  2, 10000, 1.0f, BANDPASS_PEAK },
+	{ -4, 12000, 0.7f, HIHPASS_SHELVING },
+};
+
+static const eq_core_prms_t sim_low[3] = {
+	{  9, 40, 2.0f, BANDPASS_PEAK },
+	{ -6, 80, 4.0f, BANDPASS_PEAK },
+	{  6, 30, 0.7f, LOWPASS_SHELVING },
+};
+
+static biquad_eq_t sim_eq;
+static biquad_eq_t sim_eq2;
+static int16_t sim_pcm[SIM_FRAMES * 2];
+static int16_t sim_pcm2[SIM_FRAMES * 2];
+static int16_t sim_in[SIM_FRAMES];
+static double sim_out[SIM_FRAMES];
+static double sim_ref[SIM_FRAMES];
+static double sim_q15[SIM_FRAMES];
+
+static void sim_eq_set(biquad_eq_t *eq, uint32_t channels, const eq_core_prms_t *prms,
+                       uint32_t bands)
+{
+	uint32_t i;
+
+	biquad_eq_init(eq, SIM_FS, channels, bands);
+	for (i = 0; i < bands; i++) {
+		if (biquad_eq_set_band(eq, i, &prms[i]) != 0)
+			SIM_FAIL("band %u", i);
+	}
+	biquad_eq_set_preamp(eq, 0, 1);
+}
+
+/* |H| of the float design at f */
+static double sim_design_gain(const eq_core_prms_t *prms, uint32_t bands, double f)
+{
+	double w = 2 * M_PI * f / SIM_FS, nr, ni, dr, di, g = 1;
+	float c[5];
+	uint32_t i;
+
+	for (i = 0; i < bands; i++) {
+		biquad_design(&prms[i], SIM_FS, c);
+		nr = c[0] + c[1] * cos(w) + c[2] * cos(2 * w);
+		ni = -c[1] * sin(w) - c[2] * sin(2 * w);
+		dr = 1 + c[3] * cos(w) + c[4] * cos(2 * w);
+		di = -c[3] * sin(w) - c[4] * sin(2 * w);
+		g *= sqrt((nr * nr + ni * ni) / (dr * dr + di * di));
+	}
+	return g;
+}
+
+/* amplitude of the sine at f in n samples, least squares */
+static double sim_amp(const int16_t *pcm, uint32_t n, uint32_t step, double f)
+{
+	double ss = 0, cc = 0, sc = 0, ys = 0, yc = 0, det, a, b, w;
+	uint32_t i;
+
+	for (i = 0; i < n; i++) {
+		w = 2 * M_PI * f * i / SIM_FS;
+		ss += sin(w) * sin(w);
+		cc += cos(w) * cos(w);
+		sc += sin(w) * cos(w);
+		ys += pcm[i * step] * sin(w);
+		yc += pcm[i * step] * cos(w);
+	}
+	det = ss * cc - sc * sc;
+	a = (ys * cc - yc * sc) / det;
+	b = (yc * ss - ys * sc) / det;
+	return sqrt(a * a + b * b);
+}
+
+/* gain in dB of eq at f, from the second half second of a sine */
+static double sim_gain(biquad_eq_t *eq, double f)
+{
+	const double amp = 3000;
+
+	biquad_eq_reset(eq);
+	sim_sine(sim_pcm, SIM_FRAMES, eq->channels, amp, f, SIM_FS);
+	biquad_eq_process(eq, sim_pcm, SIM_FRAMES);
+	return 20 * log10(sim_amp(sim_pcm + SIM_FRAMES / 2 * eq->channels, SIM_FRAMES / 2,
+	                          eq->channels, f) / amp);
+}
+
+static void sim_test_response(void)
+{
+	static const struct {
+		eq_core_prms_t prms;
+		double f;
+		double db;
+	} single[] = {
+		{ { 12, 1000, 1.0f, BANDPASS_PEAK }, 1000, 12 },
+		{ { 12, 1000, 1.0f, BANDPASS_PEAK }, 20, 0 },
+		{ { -12, 60, 1.0f, BANDPASS_PEAK }, 60, -12 },
+		{ { 6, 200, 0.7f, LOWPASS_SHELVING }, 20, 6 },
+		{ { 6, 5000, 0.7f, HIHPASS_SHELVING }, 20000, 6 },
+	};
+	double f, pre, d, worst = 0;
+	uint32_t i;
+
+	sim_eq_set(&sim_eq, 1, sim_preset, 10);
+	pre = 20 * log10(sim_eq.preamp / 2147483648.0);
+	for (f = 20; f < 20000; f *= 1.1) {
+		d = fabs(sim_gain(&sim_eq, f) - pre - 20 * log10(sim_design_gain(sim_preset, 10, f)));
+		if (d > worst)
+			worst = d;
+	}
+	printf("10 band preset: peak %.2f dB, preamp %.2f dB, response within %.3f dB of the design\n",
+	       20 * log10(biquad_eq_peak_gain(&sim_eq)), pre, worst);
+	if (worst > SIM_RESP_DB)
+		SIM_FAIL("response %.3f dB off", worst);
+	if (fabs(pre + 20 * log10(biquad_eq_peak_gain(&sim_eq))) > 0.01)
+		SIM_FAIL("auto headroom %.2f dB", pre);
+
+	for (i = 0; i < sizeof(single) / sizeof(single[0]); i++) {
+		biquad_eq_init(&sim_eq, SIM_FS, 2, 1);
+		biquad_eq_set_band(&sim_eq, 0, &single[i].prms);
+		d = sim_gain(&sim_eq, single[i].f);
+		if (fabs(d - single[i].db) > 0.1)
+			SIM_FAIL("band %d of %.0f dB at %d Hz, %.2f dB at %.0f Hz",
+			         single[i].prms.type, single[i].prms.G, single[i].prms.fc, d, single[i].f);
+	}
+}
+
+/* the cascade in double, with the float coefficients */
+static void sim_run_double(const eq_core_prms_t *prms, uint32_t bands, double pre, double *out)
+{
+	double st[BIQUAD_EQ_BANDS_MAX][4] = { { 0 } }, x, y;
+	float c[BIQUAD_EQ_BANDS_MAX][5];
+	uint32_t i, k;
+
+	for (k = 0; k < bands; k++)
+		biquad_design(&prms[k], SIM_FS, c[k]);
+	for (i = 0; i < SIM_FRAMES; i++) {
+		x = sim_in[i] * pre;
+		for (k = 0; k < bands; k++) {
+			y = c[k][0] * x + c[k][1] * st[k][0] + c[k][2] * st[k][1] -
+			    c[k][3] * st[k][2] - c[k][4] * st[k][3];
+			st[k][1] = st[k][0];
+			st[k][0] = x;
+			st[k][3] = st[k][2];
+			st[k][2] = y;
+			x = y;
+		}
+		out[i] = x;
+	}
+}
+
+/* the cascade with Q15 coefficients (a shift per band) and 16-bit states */
+static void sim_run_q15(const eq_core_prms_t *prms, uint32_t bands, double pre, double *out)
+{
+	int16_t st[BIQUAD_EQ_BANDS_MAX][4] = { { 0 } }, q[BIQUAD_EQ_BANDS_MAX][5];
+	int32_t shift[BIQUAD_EQ_BANDS_MAX], q31[5], x, acc;
+	float c[5];
+	uint32_t i, k, j;
+
+	for (k = 0; k < bands; k++) {
+		biquad_design(&prms[k], SIM_FS, c);
+		biquad_quantize(c, q31, &shift[k]);
+		for (j = 0; j < 5; j++)
+			q[k][j] = (int16_t)((q31[j] + (1 << 15)) >> 16);
+	}
+	for (i = 0; i < SIM_FRAMES; i++) {
+		x = (int32_t)lrint(sim_in[i] * pre);
+		for (k = 0; k < bands; k++) {
+			acc = q[k][0] * x + q[k][1] * st[k][0] + q[k][2] * st[k][1] +
+			      q[k][3] * st[k][2] + q[k][4] * st[k][3];
+			st[k][1] = st[k][0];
+			st[k][0] = (int16_t)x;
+			st[k][3] = st[k][2];
+			x = dsp_sat16((acc + (1 << (14 - shift[k]))) >> (15 - shift[k]));
+			st[k][2] = (int16_t)x;
+		}
+		out[i] = x;
+	}
+}
+
+static double sim_snr(const double *ref, const double *x)
+{
+	double s = 0, e = 0;
+	uint32_t i;
+
+	for (i = SIM_FRAMES / 4; i < SIM_FRAMES; i++) {
+		s += ref[i] * ref[i];
+		e += (x[i] - ref[i]) * (x[i] - ref[i]);
+	}
+	return 10 * log10(s / e);
+}
+
+static void sim_test_snr(void)
+{
+	static const struct {
+		const char *name;
+		const eq_core_prms_t *prms;
+		uint32_t bands;
+		double f;
+	} test[] = {
+		{ "10 band preset, 1 kHz", sim_preset, 10, 997 },
+		{ "10 band preset, 100 Hz", sim_preset, 10, 101 },
+		{ "30-80 Hz bands, 50 Hz", sim_low, 3, 53 },
+		{ "30-80 Hz bands, 1 kHz", sim_low, 3, 997 },
+	};
+	double pre, snr, snr15;
+	uint32_t k, i;
+
+	printf("SNR against double, -20 dBFS sine    biquad_eq  q15/smlad\n");
+	for (k = 0; k < sizeof(test) / sizeof(test[0]); k++) {
+		sim_eq_set(&sim_eq, 1, test[k].prms, test[k].bands);
+		pre = sim_eq.preamp / 2147483648.0;
+		srand(1);
+		for (i = 0; i < SIM_FRAMES; i++) {
+			sim_in[i] = (int16_t)lrint(3276 * sin(2 * M_PI * test[k].f * i / SIM_FS) +
+			                           rand() / (double)RAND_MAX - 0.5);
+			sim_pcm[i] = sim_in[i];
+		}
+		biquad_eq_process(&sim_eq, sim_pcm, SIM_FRAMES);
+		for (i = 0; i < SIM_FRAMES; i++)
+			sim_out[i] = sim_pcm[i];
+		sim_run_double(test[k].prms, test[k].bands, pre, sim_ref);
+		sim_run_q15(test[k].prms, test[k].bands, pre, sim_q15);
+		snr = sim_snr(sim_ref, sim_out);
+		snr15 = sim_snr(sim_ref, sim_q15);
+		printf("  %-34s %6.1f dB  %6.1f dB\n", test[k].name, snr, snr15);
+		if (snr < SIM_SNR_DB)
+			SIM_FAIL("%s, SNR %.1f dB", test[k].name, snr);
+	}
+}
+
+/* energy above 4 kHz of 1024 samples around at, Hann window, dB of the total */
+static double sim_hf(const int16_t *pcm, uint32_t at)
+{
+	double hf = 0, total = 0, re, im, x, e;
+	uint32_t bin, i;
+
+	for (bin = 1; bin < 512; bin++) {
+		re = 0;
+		im = 0;
+		for (i = 0; i < 1024; i++) {
+			x = pcm[at - 512 + i] * (0.5 - 0.5 * cos(2 * M_PI * i / 1024));
+			re += x * cos(2 * M_PI * bin * i / 1024);
+			im -= x * sin(2 * M_PI * bin * i / 1024);
+		}
+		e = re * re + im * im;
+		total += e;
+		if (bin * SIM_FS / 1024 > 4000)
+			hf += e;
+	}
+	return 10 * log10(hf / total);
+}
+
+static void sim_test_switch(void)
+{
+	const eq_core_prms_t peak = { 12, 1000, 1.0f, BANDPASS_PEAK };
+	const uint32_t at = 4800;
+	double hf[2];
+	int ramp, i, step = 0, top = 0;
+
+	/* +12 dB at 1 kHz switched in on a 1 kHz sine, at once and ramped */
+	for (ramp = 0; ramp < 2; ramp++) {
+		biquad_eq_init(&sim_eq, SIM_FS, 1, 1);
+		sim_sine(sim_pcm, SIM_FRAMES, 1, 4000, 1000, SIM_FS);
+		biquad_eq_process(&sim_eq, sim_pcm, at);
+		if (!ramp)
+			sim_eq.running = 0;
+		biquad_eq_set_band(&sim_eq, 0, &peak);
+		sim_eq.running = 1;
+		biquad_eq_process(&sim_eq, sim_pcm + at, SIM_FRAMES - at);
+		hf[ramp] = sim_hf(sim_pcm, at);
+	}
+	printf("+12 dB band switched in: above 4 kHz %.1f dB at once, %.1f dB ramped\n",
+	       hf[0], hf[1]);
+	if (hf[1] > SIM_CLICK_DB || hf[1] > hf[0] - 10)
+		SIM_FAIL("ramped switch, %.1f dB", hf[1]);
+
+	/* the same with auto headroom on a sine near full scale, no clipping */
+	biquad_eq_init(&sim_eq, SIM_FS, 1, 2);
+	biquad_eq_set_preamp(&sim_eq, 0, 1);
+	sim_sine(sim_pcm, SIM_FRAMES * 2, 1, 8000, 1000, SIM_FS);
+	biquad_eq_process(&sim_eq, sim_pcm, at);
+	biquad_eq_set_band(&sim_eq, 1, &peak);
+	biquad_eq_process(&sim_eq, sim_pcm + at, SIM_FRAMES * 2 - at);
+	for (i = 1; i < SIM_FRAMES * 2; i++) {
+		if (abs(sim_pcm[i] - sim_pcm[i - 1]) > step)
+			step = abs(sim_pcm[i] - sim_pcm[i - 1]);
+		if (i > SIM_FRAMES && abs(sim_pcm[i]) > top)
+			top = abs(sim_pcm[i]);
+	}
+	printf("+12 dB band on a 8000 peak sine with auto headroom: peak %d, largest step %d\n",
+	       top, step);
+	if (top >= 32767 || step > 8000 * 2 * M_PI * 1000 / SIM_FS + 2)
+		SIM_FAIL("auto headroom, peak %d, step %d", top, step);
+}
+
+static void sim_test_ramp_end(void)
+{
+	const eq_core_prms_t p = { 18, 100, 0.7f, LOWPASS_SHELVING };
+	const eq_core_prms_t q = { -12, 3000, 3.0f, BANDPASS_PEAK };
+	uint32_t i;
+
+	for (i = 0; i < SIM_FRAMES * 2; i++)
+		sim_pcm[i] = sim_pcm2[i] = (int16_t)(800 * sin(i * 0.01) + 300 * sin(i * 0.4));
+
+	biquad_eq_init(&sim_eq, SIM_FS, 1, 2);
+	biquad_eq_process(&sim_eq, sim_pcm, 100);
+	biquad_eq_set_band(&sim_eq, 0, &p);
+	biquad_eq_process(&sim_eq, sim_pcm + 100, 500);
+	biquad_eq_set_band(&sim_eq, 1, &q);
+	biquad_eq_set_band(&sim_eq, 0, &q);
+	biquad_eq_process(&sim_eq, sim_pcm + 600, 1000);
+	biquad_eq_set_band(&sim_eq, 0, &p);
+	biquad_eq_process(&sim_eq, sim_pcm + 1600, SIM_FRAMES * 2 - 1600);
+
+	biquad_eq_init(&sim_eq2, SIM_FS, 1, 2);
+	biquad_eq_set_band(&sim_eq2, 0, &p);
+	biquad_eq_set_band(&sim_eq2, 1, &q);
+	biquad_eq_process(&sim_eq2, sim_pcm2, SIM_FRAMES * 2);
+
+	if (sim_eq.ramping)
+		SIM_FAIL("still ramping");
+	for (i = 0; i < 2; i++) {
+		if (memcmp(sim_eq.band[i].coef, sim_eq2.band[i].coef, sizeof(sim_eq.band[i].coef)) ||
+		    sim_eq.band[i].shift != sim_eq2.band[i].shift)
+			SIM_FAIL("band %u differs after the ramps", i);
+	}
+	if (sim_eq.preamp != sim_eq2.preamp)
+		SIM_FAIL("preamp differs after the ramps");
+	for (i = SIM_FRAMES * 2 - SIM_FRAMES / 8; i < SIM_FRAMES * 2; i++) {
+		if (sim_pcm[i] != sim_pcm2[i])
+			SIM_FAIL("output differs at %u: %d, %d", i, sim_pcm[i], sim_pcm2[i]);
+	}
+	printf("changes in the middle of ramps end as the bands set up front\n");
+}
+
+static int sim_test(void)
+{
+	sim_test_response();
+	sim_test_snr();
+	sim_test_switch();
+	sim_test_ramp_end();
+	printf("ok\n");
+	return 0;
+}
+
+static int sim_bench(void)
+{
+	static const uint32_t bands[] = { 1, 5, 10 };
+	const uint32_t runs = 20;
+	uint64_t t, best;
+	uint32_t k, r, i;
+
+	srand(1);
+	for (i = 0; i < SIM_FRAMES * 2; i++)
+		sim_pcm2[i] = (int16_t)(rand() % 8000 - 4000);
+
+	printf("bands  cycles per stereo frame\n");
+	for (k = 0; k < sizeof(bands) / sizeof(bands[0]); k++) {
+		sim_eq_set(&sim_eq, 2, sim_preset, bands[k]);
+		best = ~0ULL;
+		for (r = 0; r < runs; r++) {
+			memcpy(sim_pcm, sim_pcm2, sizeof(sim_pcm));
+			t = sim_cycles();
+			biquad_eq_process(&sim_eq, sim_pcm, SIM_FRAMES);
+			t = sim_cycles() - t;
+			if (t < best)
+				best = t;
+		}
+		printf("%5u  %8.1f\n", bands[k], (double)best / SIM_FRAMES);
+	}
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc >= 2 && !strcmp(argv[1], "test"))
+		return sim_test();
+	if (argc >= 2 && !strcmp(argv[1], "bench"))
+		return sim_bench();
+	printf("usage: %s test | bench\n", argv[0]);
+	return 1;
+}
@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host test and benchmark of the resampler, stereo, on the C path.
+ *
+ * usage: resampler_sim test
+ *        resampler_sim bench
+ *
+ * The test takes nine rate pairs and checks, for each:
+ *  - THD+N of a 1 kHz sine and of a sine at 0.35 of the lower rate,
+ *  - the response flat within 0.1 dB up to 0.75 of the lower Nyquist
+ *    frequency,
+ *  - going down, tones between the two Nyquist frequencies attenuated,
+ *  - output of random splits of the input and output buffers the same, bit for
+ *    bit, as of the whole buffer.
+ * Going down by more than RESAMPLER_TAPS_MAX / RESAMPLER_TAPS the filter is
+ * held at RESAMPLER_TAPS_MAX, shorter than the ratio asks, so its transition
+ * band is wider: 0.5 dB of pass band and 40 dB of stop band are checked then.
+ *
+ * The bench prints cycles per output sample and the 1 kHz THD+N, against
+ * linear interpolation.
+ */
+
+#include "dsp_sim.h"
+#include "audio/dsp/resampler.h"
+
+#define SIM_AMP			16000
+#define SIM_IN_FRAMES	16000
+#define SIM_OUT_FRAMES	(SIM_IN_FRAMES * RESAMPLER_RATE_MAX / RESAMPLER_RATE_MIN + 16)
+#define SIM_SETTLE		(RESAMPLER_TAPS_MAX * 2)	/* frames skipped at each end */
+
+#define SIM_THDN_MAX	(-60.0)
+#define SIM_FLAT_DB		0.1
+#define SIM_FLAT_TO		0.75
+#define SIM_STOP_DB		(-60.0)
+#define SIM_FLAT_DB_SHORT	0.5		/* filter held at RESAMPLER_TAPS_MAX */
+#define SIM_STOP_DB_SHORT	(-40.0)
+
+static const uint32_t sim_rates[][2] = {
+	{ 44100, 48000 },
+	{ 48000, 44100 },
+	{ 16000, 48000 },
+	{ 48000, 16000 },
+	{  8000, 44100 },
+	{ 44100,  8000 },
+	{ 22050, 48000 },
+	{ 32000, 44100 },
+	{ 11025, 16000 },
+};
+
+#define SIM_RATES	(sizeof(sim_rates) / sizeof(sim_rates[0]))
+
+static resampler_t sim_rs;
+static int16_t sim_in[SIM_IN_FRAMES * 2];
+static int16_t sim_out[SIM_OUT_FRAMES * 2];
+static int16_t sim_out2[SIM_OUT_FRAMES * 2];
+
+/* the whole input at once, the output frames */
+static uint32_t sim_convert(uint32_t in_rate, uint32_t out_rate, int16_t *out)
+{
+	uint32_t in_frames = SIM_IN_FRAMES, out_frames = SIM_OUT_FRAMES;
+
+	if (resampler_init(&sim_rs, in_rate, out_rate, 2) != 0)
+		SIM_FAIL("init %u -> %u", in_rate, out_rate);
+	resampler_process(&sim_rs, sim_in, &in_frames, out, &out_frames);
+	if (in_frames != SIM_IN_FRAMES)
+		SIM_FAIL("%u -> %u, %u of %u frames taken", in_rate, out_rate,
+		         in_frames, SIM_IN_FRAMES);
+	return out_frames;
+}
+
+static double sim_tone_thdn(uint32_t in_rate, uint32_t out_rate, double freq)
+{
+	uint32_t n;
+
+	sim_sine(sim_in, SIM_IN_FRAMES, 2, SIM_AMP, freq, in_rate);
+	n = sim_convert(in_rate, out_rate, sim_out);
+	return sim_thdn(sim_out + SIM_SETTLE * 2, n - 2 * SIM_SETTLE, 2, freq, out_rate);
+}
+
+static double sim_tone_level(uint32_t in_rate, uint32_t out_rate, double freq)
+{
+	uint32_t n;
+
+	sim_sine(sim_in, SIM_IN_FRAMES, 2, SIM_AMP, freq, in_rate);
+	n = sim_convert(in_rate, out_rate, sim_out);
+	return sim_level(sim_out + SIM_SETTLE * 2, n - 2 * SIM_SETTLE, 2, SIM_AMP);
+}
+
+static void sim_test_pair(uint32_t in_rate, uint32_t out_rate)
+{
+	double lo = (in_rate < out_rate ? in_rate : out_rate) / 2.0;
+	double thdn_1k, thdn_hi, freq, level, flat = 0, stop = -200;
+	uint32_t n, in_pos = 0, out_pos = 0, in_frames, out_frames, i, short_taps;
+
+	thdn_1k = sim_tone_thdn(in_rate, out_rate, 1000);
+	thdn_hi = sim_tone_thdn(in_rate, out_rate, 0.35 * lo * 2);
+
+	for (freq = 100; freq <= SIM_FLAT_TO * lo; freq += SIM_FLAT_TO * lo / 40) {
+		level = sim_tone_level(in_rate, out_rate, freq);
+		if (fabs(level) > fabs(flat))
+			flat = level;
+	}
+
+	if (in_rate > out_rate) {
+		for (freq = lo; freq < in_rate / 2.0; freq += lo / 50) {
+			level = sim_tone_level(in_rate, out_rate, freq);
+			if (level > stop)
+				stop = level;
+		}
+	}
+
+	sim_sine(sim_in, SIM_IN_FRAMES, 2, SIM_AMP, 1000, in_rate);
+	n = sim_convert(in_rate, out_rate, sim_out);
+	resampler_init(&sim_rs, in_rate, out_rate, 2);
+	do {	/* then what is left in the history, with no input */
+		in_frames = 1 + rand() % 300;
+		out_frames = 1 + rand() % 300;
+		if (in_frames > SIM_IN_FRAMES - in_pos)
+			in_frames = SIM_IN_FRAMES - in_pos;
+		if (out_frames > SIM_OUT_FRAMES - out_pos)
+			SIM_FAIL("%u -> %u, output overrun", in_rate, out_rate);
+		resampler_process(&sim_rs, sim_in + in_pos * 2, &in_frames,
+		                  sim_out2 + out_pos * 2, &out_frames);
+		in_pos += in_frames;
+		out_pos += out_frames;
+	} while (in_pos < SIM_IN_FRAMES || out_frames);
+
+	short_taps = (uint64_t)sim_rs.taps * out_rate < (uint64_t)RESAMPLER_TAPS * in_rate;
+	printf("%5u -> %5u taps %3u  THD+N 1k %6.1f dB, 0.35 fs %6.1f dB  flat %+.3f dB",
+	       in_rate, out_rate, sim_rs.taps, thdn_1k, thdn_hi, flat);
+	if (in_rate > out_rate)
+		printf("  stop %6.1f dB", stop);
+	printf("\n");
+
+	if (thdn_1k > SIM_THDN_MAX || thdn_hi > SIM_THDN_MAX)
+		SIM_FAIL("%u -> %u, THD+N", in_rate, out_rate);
+	if (fabs(flat) > (short_taps ? SIM_FLAT_DB_SHORT : SIM_FLAT_DB))
+		SIM_FAIL("%u -> %u, pass band %+.3f dB", in_rate, out_rate, flat);
+	if (stop > (short_taps ? SIM_STOP_DB_SHORT : SIM_STOP_DB))
+		SIM_FAIL("%u -> %u, stop band %.1f dB", in_rate, out_rate, stop);
+	if (out_pos != n)
+		SIM_FAIL("%u -> %u, %u frames in pieces, %u whole", in_rate, out_rate, out_pos, n);
+	for (i = 0; i < n * 2; i++) {
+		if (sim_out[i] != sim_out2[i])
+			SIM_FAIL("%u -> %u, pieces differ at sample %u", in_rate, out_rate, i);
+	}
+}
+
+static int sim_test(void)
+{
+	uint32_t i;
+
+	srand(1);
+	for (i = 0; i < SIM_RATES; i++)
+		sim_test_pair(sim_rates[i][0], sim_rates[i][1]);
+	printf("ok\n");
+	return 0;
+}
+
+/* linear interpolation between input frames, first channel */
+static uint32_t sim_linear(uint32_t in_rate, uint32_t out_rate, int16_t *out)
+{
+	uint32_t n = 0, i;
+	double x;
+
+	for (;;) {
+		x = (double)n * in_rate / out_rate;
+		i = (uint32_t)x;
+		if (i + 1 >= SIM_IN_FRAMES)
+			break;
+		out[n++] = (int16_t)lrint(sim_in[i * 2] + (sim_in[i * 2 + 2] - sim_in[i * 2]) * (x - i));
+	}
+	return n;
+}
+
+static int sim_bench(void)
+{
+	uint32_t i, k, n, in_frames, out_frames, best_rs_taps;
+	uint64_t t, best;
+	double thdn, thdn_lin;
+
+	printf("                 cycles per out sample   THD+N 1 kHz   linear\n");
+	for (i = 0; i < SIM_RATES; i++) {
+		sim_sine(sim_in, SIM_IN_FRAMES, 2, SIM_AMP, 1000, sim_rates[i][0]);
+		best = ~0ULL;
+		n = 0;
+		for (k = 0; k < 5; k++) {
+			resampler_init(&sim_rs, sim_rates[i][0], sim_rates[i][1], 2);
+			in_frames = SIM_IN_FRAMES;
+			out_frames = SIM_OUT_FRAMES;
+			t = sim_cycles();
+			resampler_process(&sim_rs, sim_in, &in_frames, sim_out, &out_frames);
+			t = sim_cycles() - t;
+			if (t < best)
+				best = t;
+			n = out_frames;
+		}
+		best_rs_taps = sim_rs.taps;
+		thdn = sim_thdn(sim_out + SIM_SETTLE * 2, n - 2 * SIM_SETTLE, 2, 1000, sim_rates[i][1]);
+		n = sim_linear(sim_rates[i][0], sim_rates[i][1], sim_out2);
+		thdn_lin = sim_thdn(sim_out2 + SIM_SETTLE, n - 2 * SIM_SETTLE, 1, 1000, sim_rates[i][1]);
+		printf("%5u -> %5u  %3u taps %8.1f         %8.1f dB   %6.1f dB\n",
+		       sim_rates[i][0], sim_rates[i][1], best_rs_taps,
+		       (double)best / (out_frames * 2), thdn, thdn_lin);
+	}
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc >= 2 && !strcmp(argv[1], "test"))
+		return sim_test();
+	if (argc >= 2 && !strcmp(argv[1], "bench"))
+		return sim_bench();
+	printf("usage: %s test | bench\n", argv[0]);
+	return 1;
+}
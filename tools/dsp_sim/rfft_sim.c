@@ -0,0 +1,300 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host test and benchmark of the real FFT, on the C path.
+ *
+ * usage: rfft_sim test
+ *        rfft_sim bench
+ *
+ * The test checks, against a DFT in double precision, for every size:
+ *  - the SNR of the Q31 and Q15 forward transforms of noise plus a tone,
+ *  - the SNR of the round trip back through the inverse,
+ * and at 1024 points:
+ *  - full scale DC and Nyquist inputs,
+ *  - random full scale Q15 input, every bin within a few LSB,
+ *  - the spurs of a tone on a bin.
+ *
+ * The bench prints cycles per transform, best of 2000.
+ */
+
+#include "dsp_sim.h"
+#include "audio/dsp/rfft.h"
+
+#define SIM_SNR_Q31		130.0	/* dB, forward and round trip */
+#define SIM_SNR_Q15_FWD	40.0
+#define SIM_SNR_Q15_INV	30.0
+#define SIM_SPUR_Q31	(-150.0)	/* dBc */
+#define SIM_SPUR_Q15	(-70.0)
+#define SIM_ERR_Q15		40		/* LSB, a bin of random full scale input */
+
+static double sim_x[RFFT_SIZE_MAX];
+static double sim_X[RFFT_SIZE_MAX];
+static double sim_cos[RFFT_SIZE_MAX];
+static int32_t sim_q31[RFFT_SIZE_MAX];
+static int16_t sim_q15[RFFT_SIZE_MAX];
+static int16_t sim_q15_in[RFFT_SIZE_MAX];
+
+/* X / n of x, packed as rfft packs it */
+static void sim_dft(const double *x, double *X, uint32_t n)
+{
+	double re, im;
+	uint32_t i, k;
+
+	for (i = 0; i < n; i++)
+		sim_cos[i] = cos(2 * M_PI * i / n);
+	for (k = 0; k <= n / 2; k++) {
+		re = 0;
+		im = 0;
+		for (i = 0; i < n; i++) {
+			re += x[i] * sim_cos[(uint64_t)k * i % n];
+			im -= x[i] * sim_cos[((uint64_t)k * i + 3 * n / 4) % n];
+		}
+		re /= n;
+		im /= n;
+		if (k == 0) {
+			X[0] = re;
+		} else if (k == n / 2) {
+			X[1] = re;
+		} else {
+			X[2 * k] = re;
+			X[2 * k + 1] = im;
+		}
+	}
+}
+
+static double sim_snr31(const int32_t *q, const double *ref, uint32_t n)
+{
+	double d, err = 0, pwr = 0;
+	uint32_t i;
+
+	for (i = 0; i < n; i++) {
+		d = q[i] / 2147483648.0 - ref[i];
+		err += d * d;
+		pwr += ref[i] * ref[i];
+	}
+	return 10 * log10(pwr / err);
+}
+
+static double sim_snr15(const int16_t *q, const double *ref, uint32_t n)
+{
+	double d, err = 0, pwr = 0;
+	uint32_t i;
+
+	for (i = 0; i < n; i++) {
+		d = q[i] / 32768.0 - ref[i];
+		err += d * d;
+		pwr += ref[i] * ref[i];
+	}
+	return 10 * log10(pwr / err);
+}
+
+static void sim_test_snr(uint32_t n)
+{
+	double fwd31, inv31, fwd15, inv15;
+	rfft_t fft;
+	uint32_t i;
+
+	if (rfft_init(&fft, n) != 0)
+		SIM_FAIL("init %u", n);
+	srand(n);
+	for (i = 0; i < n; i++)
+		sim_x[i] = (rand() / (double)RAND_MAX * 2 - 1) * 0.5 + 0.4 * sin(2 * M_PI * i * 37.3 / n);
+	sim_dft(sim_x, sim_X, n);
+
+	for (i = 0; i < n; i++)
+		sim_q31[i] = (int32_t)lrint(sim_x[i] * 2147483647.0);
+	rfft_q31(&fft, sim_q31);
+	fwd31 = sim_snr31(sim_q31, sim_X, n);
+	rifft_q31(&fft, sim_q31);
+	inv31 = sim_snr31(sim_q31, sim_x, n);
+
+	for (i = 0; i < n; i++)
+		sim_q15[i] = (int16_t)lrint(sim_x[i] * 32767.0);
+	rfft_q15(&fft, sim_q15);
+	fwd15 = sim_snr15(sim_q15, sim_X, n);
+	rifft_q15(&fft, sim_q15);
+	inv15 = sim_snr15(sim_q15, sim_x, n);
+
+	printf("%4u points  q31 forward %6.1f dB, round trip %6.1f dB  "
+	       "q15 forward %5.1f dB, round trip %5.1f dB\n", n, fwd31, inv31, fwd15, inv15);
+	if (fwd31 < SIM_SNR_Q31 || inv31 < SIM_SNR_Q31)
+		SIM_FAIL("%u points, q31", n);
+	if (fwd15 < SIM_SNR_Q15_FWD || inv15 < SIM_SNR_Q15_INV)
+		SIM_FAIL("%u points, q15", n);
+}
+
+/* worst spur of the magnitudes of q against the one of bin, dBc */
+static double sim_spur(double (*mag)(uint32_t), uint32_t n, uint32_t bin)
+{
+	double m, peak = 0, spur = 0;
+	uint32_t k;
+
+	for (k = 1; k < n / 2; k++) {
+		m = mag(k);
+		if (k == bin)
+			peak = m;
+		else if (m > spur)
+			spur = m;
+	}
+	return 20 * log10(spur / peak + 1e-30);
+}
+
+static double sim_mag31(uint32_t k)
+{
+	return hypot(sim_q31[2 * k], sim_q31[2 * k + 1]);
+}
+
+static double sim_mag15(uint32_t k)
+{
+	return hypot(sim_q15[2 * k], sim_q15[2 * k + 1]);
+}
+
+static void sim_test_edges(void)
+{
+	const uint32_t n = 1024, bin = 100;
+	double re, spur31, spur15;
+	uint32_t i, k, t, bad = 0;
+	rfft_t fft;
+
+	rfft_init(&fft, n);
+
+	for (i = 0; i < n; i++)
+		sim_q31[i] = INT32_MAX;
+	rfft_q31(&fft, sim_q31);
+	if (sim_q31[0] < INT32_MAX - 64 || abs(sim_q31[1]) > 64 ||
+	    abs(sim_q31[2]) > 64 || abs(sim_q31[3]) > 64)
+		SIM_FAIL("q31 DC: %d %d %d %d", sim_q31[0], sim_q31[1], sim_q31[2], sim_q31[3]);
+
+	for (i = 0; i < n; i++)
+		sim_q31[i] = (i & 1) ? INT32_MIN : INT32_MAX;
+	rfft_q31(&fft, sim_q31);
+	if (abs(sim_q31[0]) > 64 || sim_q31[1] < INT32_MAX - 64)
+		SIM_FAIL("q31 Nyquist: %d %d", sim_q31[0], sim_q31[1]);
+
+	for (i = 0; i < n; i++)
+		sim_q15[i] = (i & 1) ? -32768 : 32767;
+	rfft_q15(&fft, sim_q15);
+	if (abs(sim_q15[0]) > 1 || sim_q15[1] < 32766)
+		SIM_FAIL("q15 Nyquist: %d %d", sim_q15[0], sim_q15[1]);
+	rifft_q15(&fft, sim_q15);
+	for (i = 0; i < n; i++) {
+		if (abs(sim_q15[i] - ((i & 1) ? -32768 : 32767)) > 2)
+			SIM_FAIL("q15 Nyquist back, %d at %u", sim_q15[i], i);
+	}
+
+	for (i = 0; i < n; i++)
+		sim_cos[i] = cos(2 * M_PI * i / n);
+	for (t = 0; t < 20; t++) {
+		for (i = 0; i < n; i++)
+			sim_q15_in[i] = sim_q15[i] = (rand() & 1) ? 32767 : -32768;
+		rfft_q15(&fft, sim_q15);
+		for (k = 1; k < n / 2; k++) {
+			re = 0;
+			for (i = 0; i < n; i++)
+				re += sim_q15_in[i] * sim_cos[(uint64_t)k * i % n];
+			if (fabs(re / n - sim_q15[2 * k]) > SIM_ERR_Q15)
+				bad++;
+		}
+	}
+	printf("full scale DC and Nyquist right, random full scale q15: "
+	       "%u bins off by more than %d LSB\n", bad, SIM_ERR_Q15);
+	if (bad)
+		SIM_FAIL("%u bins", bad);
+
+	for (i = 0; i < n; i++)
+		sim_q15[i] = (int16_t)lrint(32000 * sin(2 * M_PI * bin * i / n));
+	rfft_q15(&fft, sim_q15);
+	spur15 = sim_spur(sim_mag15, n, bin);
+	for (i = 0; i < n; i++)
+		sim_q31[i] = (int32_t)lrint(2147483000.0 * sin(2 * M_PI * bin * i / n));
+	rfft_q31(&fft, sim_q31);
+	spur31 = sim_spur(sim_mag31, n, bin);
+	printf("tone on a bin, worst spur: q31 %.1f dBc, q15 %.1f dBc\n", spur31, spur15);
+	if (spur31 > SIM_SPUR_Q31 || spur15 > SIM_SPUR_Q15)
+		SIM_FAIL("spurs");
+}
+
+static int sim_test(void)
+{
+	uint32_t n;
+
+	for (n = RFFT_SIZE_MIN; n <= RFFT_SIZE_MAX; n *= 2)
+		sim_test_snr(n);
+	sim_test_edges();
+	printf("ok\n");
+	return 0;
+}
+
+#define SIM_BEST(runs, stmt)								\
+	({														\
+		uint64_t best_ = ~0ULL, t_;							\
+		int r_;												\
+		for (r_ = 0; r_ < (runs); r_++) {					\
+			t_ = sim_cycles();								\
+			stmt;											\
+			t_ = sim_cycles() - t_;							\
+			if (t_ < best_)									\
+				best_ = t_;									\
+		}													\
+		(double)best_;										\
+	})
+
+static int sim_bench(void)
+{
+	static int32_t data[RFFT_SIZE_MAX];
+	double fwd31, inv31, fwd15;
+	uint32_t n, i;
+	rfft_t fft;
+
+	for (i = 0; i < RFFT_SIZE_MAX; i++)
+		data[i] = (int32_t)(1e8 * sin(i * 0.1));
+
+	printf("points   rfft_q31  rifft_q31   rfft_q15  cycles, best of 2000\n");
+	for (n = RFFT_SIZE_MIN; n <= RFFT_SIZE_MAX; n *= 2) {
+		rfft_init(&fft, n);
+		fwd31 = SIM_BEST(2000, (memcpy(sim_q31, data, n * 4), rfft_q31(&fft, sim_q31)));
+		inv31 = SIM_BEST(2000, (memcpy(sim_q31, data, n * 4), rifft_q31(&fft, sim_q31)));
+		for (i = 0; i < n; i++)
+			sim_q15_in[i] = (int16_t)(data[i] >> 16);
+		fwd15 = SIM_BEST(2000, (memcpy(sim_q15, sim_q15_in, n * 2), rfft_q15(&fft, sim_q15)));
+		printf("%6u %10.0f %10.0f %10.0f\n", n, fwd31, inv31, fwd15);
+	}
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc >= 2 && !strcmp(argv[1], "test"))
+		return sim_test();
+	if (argc >= 2 && !strcmp(argv[1], "bench"))
+		return sim_bench();
+	printf("usage: %s test | bench\n", argv[0]);
+	return 1;
+}
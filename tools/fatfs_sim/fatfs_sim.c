@@ -0,0 +1,767 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host build of fatfs with the block cache of driver/blk_cache and the extent
+ * maps of ff.c, on a simulated SD card. ff.c, blk_cache.c and the RAM disk are built as for
+ * the chip, diskio.c is built in and SDMMC_*() are given here.
+ *
+ * usage: fatfs_sim test [iterations [seed]]
+ *        fatfs_sim bench
+ *
+ * The card is a 300M FAT32 volume with 4K clusters. It is volume "0:"
+ * through diskio.c and the cache, and volume "1:" through the RAM disk on the
+ * same memory, which shows what is on the card with no cache in between.
+ *
+ * The test first cuts a fragmented file whose extent map is built, gives its
+ * clusters to another file and grows it again. Then it runs random writes,
+ * reads, truncations, seeks past the end, syncs and reopens on 6 files (2
+ * more than the extent maps, so some go without one), checked against a copy
+ * in RAM. Open files are also opened again in the same FIL after a remount,
+ * which must not keep their old maps. From time to time
+ * "0:" is remounted with the cache on or off, the files are read through "1:"
+ * after a sync or an unmount, and a file is changed through "1:" while "0:"
+ * is unmounted: after the remount "0:" must read the new data, not what the
+ * cache held before.
+ *
+ * The bench gives the throughput of "0:" with and without the cache, in the
+ * time of an SD card model: 150 us per read command, 700 us per write
+ * command and 42 us per sector. It also gives the host time of random seeks
+ * in a fragmented file with and without an extent map.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fs/fatfs/ff.h"
+
+#define disk_read	diskio_read		/* counted by disk_read() below */
+#include "diskio.c"
+#undef disk_read
+
+#define SIM_FAIL(fmt, arg...)									\
+	do {														\
+		printf("FAIL %s():%d, " fmt "\n", __func__, __LINE__, ##arg);	\
+		exit(1);												\
+	} while (0)
+
+#define SIM_CK(x)												\
+	do {														\
+		FRESULT r_ = (x);										\
+		if (r_ != FR_OK)										\
+			SIM_FAIL("%s: %d", #x, r_);							\
+	} while (0)
+
+#define SIM_SECTOR		512
+#define SIM_SECTORS		(300 * 2048)	/* 300M */
+#define SIM_CLUSTER		8				/* sectors */
+#define SIM_RSVD		32
+
+static uint8_t *sim_card;
+
+struct sim_card_stat {
+	uint32_t	rd_cmd;
+	uint32_t	rd_sectors;
+	uint32_t	wr_cmd;
+	uint32_t	wr_sectors;
+	double		time_us;
+};
+
+static struct sim_card_stat sim_stat;
+
+static uint64_t sim_seed;
+
+static uint32_t sim_rand(void)
+{
+	sim_seed ^= sim_seed << 13;
+	sim_seed ^= sim_seed >> 7;
+	sim_seed ^= sim_seed << 17;
+	return (uint32_t)sim_seed;
+}
+
+/* SD card of diskio.c */
+
+DSTATUS SDMMC_initialize()
+{
+	return 0;
+}
+
+DSTATUS SDMMC_status()
+{
+	return 0;
+}
+
+DRESULT SDMMC_read(BYTE *buff, DWORD sector, UINT count)
+{
+	if (sector >= SIM_SECTORS || count > SIM_SECTORS - sector)
+		SIM_FAIL("read %u (%u) past the card end", sector, count);
+	memcpy(buff, sim_card + (size_t)sector * SIM_SECTOR, count * SIM_SECTOR);
+	sim_stat.rd_cmd++;
+	sim_stat.rd_sectors += count;
+	sim_stat.time_us += 150 + 42 * count;
+	return RES_OK;
+}
+
+DRESULT SDMMC_write(const BYTE *buff, DWORD sector, UINT count)
+{
+	if (sector >= SIM_SECTORS || count > SIM_SECTORS - sector)
+		SIM_FAIL("write %u (%u) past the card end", sector, count);
+	memcpy(sim_card + (size_t)sector * SIM_SECTOR, buff, count * SIM_SECTOR);
+	sim_stat.wr_cmd++;
+	sim_stat.wr_sectors += count;
+	sim_stat.time_us += 700 + 42 * count;
+	return RES_OK;
+}
+
+DRESULT SDMMC_ioctl(BYTE cmd, void *buff)
+{
+	switch (cmd) {
+	case CTRL_SYNC:
+		return RES_OK;
+	case GET_SECTOR_COUNT:
+		*(DWORD *)buff = SIM_SECTORS;
+		return RES_OK;
+	case GET_SECTOR_SIZE:
+		*(WORD *)buff = SIM_SECTOR;
+		return RES_OK;
+	case GET_BLOCK_SIZE:
+		*(DWORD *)buff = 1;
+		return RES_OK;
+	default:
+		return RES_PARERR;
+	}
+}
+
+static void sim_st16(uint8_t *p, uint16_t v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+}
+
+static void sim_st32(uint8_t *p, uint32_t v)
+{
+	sim_st16(p, v);
+	sim_st16(p + 2, v >> 16);
+}
+
+/* an empty FAT32 volume on the whole card, with no partition table */
+static void sim_format(void)
+{
+	uint8_t *bs = sim_card;
+	uint8_t *fsi = sim_card + SIM_SECTOR;
+	uint8_t *fat;
+	uint32_t fatsz, i;
+
+	fatsz = ((SIM_SECTORS / SIM_CLUSTER + 2) * 4 + SIM_SECTOR - 1) / SIM_SECTOR;
+	memset(sim_card, 0, (SIM_RSVD + 2 * fatsz + SIM_CLUSTER) * SIM_SECTOR);
+
+	memcpy(bs, "\xEB\x58\x90" "MSDOS5.0", 11);
+	sim_st16(bs + 11, SIM_SECTOR);
+	bs[13] = SIM_CLUSTER;
+	sim_st16(bs + 14, SIM_RSVD);
+	bs[16] = 2;								/* FATs */
+	bs[21] = 0xF8;							/* media */
+	sim_st16(bs + 24, 63);
+	sim_st16(bs + 26, 255);
+	sim_st32(bs + 32, SIM_SECTORS);
+	sim_st32(bs + 36, fatsz);
+	sim_st32(bs + 44, 2);					/* root directory cluster */
+	sim_st16(bs + 48, 1);					/* FSINFO sector */
+	bs[64] = 0x80;
+	bs[66] = 0x29;
+	sim_st32(bs + 67, 0x12345678);
+	memcpy(bs + 71, "NO NAME    FAT32   ", 19);
+	sim_st16(bs + 510, 0xAA55);
+
+	sim_st32(fsi, 0x41615252);
+	sim_st32(fsi + 484, 0x61417272);
+	sim_st32(fsi + 488, 0xFFFFFFFF);		/* free clusters unknown */
+	sim_st32(fsi + 492, 0xFFFFFFFF);
+	sim_st32(fsi + 508, 0xAA550000);
+
+	for (i = 0; i < 2; ++i) {
+		fat = sim_card + (SIM_RSVD + i * fatsz) * SIM_SECTOR;
+		sim_st32(fat, 0x0FFFFFF8);
+		sim_st32(fat + 4, 0x0FFFFFFF);
+		sim_st32(fat + 8, 0x0FFFFFFF);		/* root directory */
+	}
+}
+
+static FATFS sim_fs;
+static FATFS sim_ram_fs;
+
+static uint32_t sim_fat_reads;	/* FAT sectors read by ff.c from "0:" */
+
+DRESULT disk_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
+{
+	if (pdrv == DEV_MMC && sector >= sim_fs.fatbase &&
+	    sector < sim_fs.fatbase + sim_fs.fsize * sim_fs.n_fats)
+		sim_fat_reads += count;
+	return diskio_read(pdrv, buff, sector, count);
+}
+
+/* mount "0:" through the cache or straight to the card */
+static void sim_mount(int cache)
+{
+	if (mmc_cache.data != NULL)
+		mmc_cache_ready = 1;	/* disk_initialize() invalidates it */
+	SIM_CK(f_mount(&sim_fs, "0:", 1));
+	mmc_cache_ready = cache;
+}
+
+static void sim_unmount(void)
+{
+	SIM_CK(f_mount(NULL, "0:", 0));
+}
+
+static void sim_init(uint32_t seed)
+{
+	sim_seed = 0x9E3779B97F4A7C15ULL ^ seed;
+	if (sim_card == NULL)
+		sim_card = malloc((size_t)SIM_SECTORS * SIM_SECTOR);
+	if (sim_card == NULL)
+		SIM_FAIL("no mem");
+	sim_format();
+	RAM_disk_setup(sim_card, (DWORD)SIM_SECTORS * SIM_SECTOR);
+	memset(&sim_stat, 0, sizeof(sim_stat));
+}
+
+/* files under test and their copies in RAM */
+
+#define SIM_FILES		(_EXTMAP_FILES + 2)
+#define SIM_FILE_MAX	(600 * 1024)
+#define SIM_IO_MAX		(70 * 1024)
+
+struct sim_file {
+	FIL			fp;
+	int			open;
+	uint32_t	size;
+	uint8_t	   *copy;
+};
+
+static struct sim_file sim_file[SIM_FILES];
+static uint8_t sim_buf[SIM_IO_MAX];
+static long sim_iter;
+
+static void sim_path(char *path, const char *vol, int i)
+{
+	sprintf(path, "%s/f%d.bin", vol, i);
+}
+
+/* read a file in pieces of random sizes and compare it with its copy */
+static void sim_verify(const char *vol, int i)
+{
+	struct sim_file *f = &sim_file[i];
+	char path[16];
+	uint32_t pos, n;
+	UINT br;
+	FIL fp;
+
+	sim_path(path, vol, i);
+	SIM_CK(f_open(&fp, path, FA_READ));
+	if (f_size(&fp) != f->size)
+		SIM_FAIL("iter %ld: %s size %u, %u expected", sim_iter, path,
+		         (uint32_t)f_size(&fp), f->size);
+	for (pos = 0; pos < f->size; pos += n) {
+		n = 1 + sim_rand() % (sim_rand() % 4 ? 3000 : SIM_IO_MAX);
+		if (n > f->size - pos)
+			n = f->size - pos;
+		SIM_CK(f_read(&fp, sim_buf, n, &br));
+		if (br != n || memcmp(sim_buf, f->copy + pos, n) != 0)
+			SIM_FAIL("iter %ld: %s differs in %u..%u", sim_iter, path,
+			         pos, pos + n);
+	}
+	SIM_CK(f_close(&fp));
+}
+
+static void sim_verify_all(const char *vol)
+{
+	int i;
+
+	for (i = 0; i < SIM_FILES; ++i)
+		sim_verify(vol, i);
+}
+
+static void sim_close_all(void)
+{
+	int i;
+
+	for (i = 0; i < SIM_FILES; ++i) {
+		if (sim_file[i].open) {
+			SIM_CK(f_close(&sim_file[i].fp));
+			sim_file[i].open = 0;
+		}
+	}
+}
+
+/* what is on the card, read through "1:" */
+static void sim_verify_card(void)
+{
+	SIM_CK(f_mount(&sim_ram_fs, "1:", 1));
+	sim_verify_all("1:");
+	SIM_CK(f_mount(NULL, "1:", 0));
+}
+
+/* the card is changed while "0:" is unmounted, e.g. in a card reader */
+static void sim_change_card(void)
+{
+	struct sim_file *f;
+	char path[16];
+	uint32_t pos, n, k;
+	UINT bw;
+	FIL fp;
+
+	f = &sim_file[sim_rand() % SIM_FILES];
+	if (f->size == 0)
+		return;
+	pos = sim_rand() % f->size;
+	n = 1 + sim_rand() % 4096;
+	if (n > f->size - pos)
+		n = f->size - pos;
+	for (k = 0; k < n; ++k)
+		sim_buf[k] = sim_rand();
+
+	SIM_CK(f_mount(&sim_ram_fs, "1:", 1));
+	sim_path(path, "1:", f - sim_file);
+	SIM_CK(f_open(&fp, path, FA_WRITE));
+	SIM_CK(f_lseek(&fp, pos));
+	SIM_CK(f_write(&fp, sim_buf, n, &bw));
+	SIM_CK(f_close(&fp));
+	SIM_CK(f_mount(NULL, "1:", 0));
+	memcpy(f->copy + pos, sim_buf, n);
+}
+
+static void sim_write_at(struct sim_file *f, uint32_t pos, uint32_t n)
+{
+	uint32_t k;
+	UINT bw;
+
+	for (k = 0; k < n; ++k)
+		sim_buf[k] = sim_rand();
+	SIM_CK(f_lseek(&f->fp, pos));
+	SIM_CK(f_write(&f->fp, sim_buf, n, &bw));
+	if (bw != n)
+		SIM_FAIL("iter %ld: short write, %u of %u", sim_iter, bw, n);
+	memcpy(f->copy + pos, sim_buf, n);
+	if (pos + n > f->size)
+		f->size = pos + n;
+}
+
+/* read an open file at random places, backwards more than not */
+static void sim_read_back(struct sim_file *f)
+{
+	uint32_t pos, n;
+	UINT br;
+	int k;
+
+	for (k = 0; k < 64 && f->size; ++k) {
+		pos = sim_rand() % f->size;
+		n = 1 + sim_rand() % 5000;
+		if (n > f->size - pos)
+			n = f->size - pos;
+		SIM_CK(f_lseek(&f->fp, pos));
+		SIM_CK(f_read(&f->fp, sim_buf, n, &br));
+		if (br != n || memcmp(sim_buf, f->copy + pos, n) != 0)
+			SIM_FAIL("iter %ld: f%d differs in %u..%u", sim_iter,
+			         (int)(f - sim_file), pos, pos + n);
+	}
+}
+
+/*
+ * A file in 8 extents is read, so that its map is full, and cut to a third.
+ * The next cluster to allocate is reset to the top of the volume, as after a
+ * mount with no FSINFO hint: the other file takes the freed clusters, then
+ * the first one grows again on new ones. Both must read their own data.
+ */
+static void sim_test_truncate(void)
+{
+	struct sim_file *a = &sim_file[0];
+	struct sim_file *b = &sim_file[1];
+	uint32_t k;
+
+	for (k = 0; k < 8; ++k) {
+		sim_write_at(a, a->size, 40 * 1024);
+		sim_write_at(b, b->size, 4 * 1024);
+	}
+	sim_read_back(a);
+	SIM_CK(f_lseek(&a->fp, a->size / 3 + 123));
+	SIM_CK(f_truncate(&a->fp));
+	a->size = a->size / 3 + 123;
+	sim_read_back(a);
+
+	sim_fs.last_clst = 0;
+	for (k = 0; k < 4; ++k)
+		sim_write_at(b, b->size, 50 * 1024);
+	for (k = 0; k < 4; ++k)
+		sim_write_at(a, a->size, 50 * 1024);
+	sim_read_back(a);
+	sim_read_back(b);
+	SIM_CK(f_sync(&a->fp));
+	SIM_CK(f_sync(&b->fp));
+	sim_verify_card();
+}
+
+static void sim_test(long iters, uint32_t seed)
+{
+	struct sim_file *f;
+	char path[16];
+	uint32_t pos, n;
+	UINT br;
+	int i, op, cache = 1;
+	int remounts = 0, changes = 0;
+
+	sim_init(seed);
+	sim_mount(1);
+	for (i = 0; i < SIM_FILES; ++i) {
+		f = &sim_file[i];
+		f->copy = calloc(SIM_FILE_MAX, 1);
+		f->size = 0;
+		sim_path(path, "0:", i);
+		SIM_CK(f_open(&f->fp, path, FA_CREATE_ALWAYS | FA_READ | FA_WRITE));
+		f->open = 1;
+	}
+	sim_test_truncate();
+
+	for (sim_iter = 0; sim_iter < iters; ++sim_iter) {
+		f = &sim_file[sim_rand() % SIM_FILES];
+		op = sim_rand() % 100;
+		if (!f->open) {
+			sim_path(path, "0:", f - sim_file);
+			SIM_CK(f_open(&f->fp, path, FA_READ | FA_WRITE));
+			f->open = 1;
+		}
+
+		if (op < 30) {			/* write, up to the end */
+			pos = f->size ? sim_rand() % (f->size + 1) : 0;
+			n = 1 + sim_rand() % (sim_rand() % 4 ? 2000 : SIM_IO_MAX - 1);
+			if (n > SIM_FILE_MAX - pos)
+				n = SIM_FILE_MAX - pos;
+			if (n > 0)
+				sim_write_at(f, pos, n);
+		} else if (op < 60) {	/* read */
+			if (f->size == 0)
+				continue;
+			pos = sim_rand() % f->size;
+			n = 1 + sim_rand() % (sim_rand() % 4 ? 3000 : SIM_IO_MAX - 1);
+			if (n > f->size - pos)
+				n = f->size - pos;
+			SIM_CK(f_lseek(&f->fp, pos));
+			SIM_CK(f_read(&f->fp, sim_buf, n, &br));
+			if (br != n || memcmp(sim_buf, f->copy + pos, n) != 0)
+				SIM_FAIL("iter %ld: f%d differs in %u..%u", sim_iter,
+				         (int)(f - sim_file), pos, pos + n);
+		} else if (op < 65) {	/* truncate */
+			pos = f->size ? sim_rand() % (f->size + 1) : 0;
+			SIM_CK(f_lseek(&f->fp, pos));
+			SIM_CK(f_truncate(&f->fp));
+			f->size = pos;
+		} else if (op < 75) {	/* append */
+			n = 1 + sim_rand() % 300;
+			if (n <= SIM_FILE_MAX - f->size)
+				sim_write_at(f, f->size, n);
+		} else if (op < 80) {	/* seek past the end, which extends the file */
+			pos = f->size + sim_rand() % 5000;
+			if (pos > SIM_FILE_MAX)
+				continue;
+			SIM_CK(f_lseek(&f->fp, pos));
+			if (f_tell(&f->fp) != pos || f_size(&f->fp) != pos)
+				SIM_FAIL("iter %ld: seek to %u, at %u size %u", sim_iter,
+				         pos, (uint32_t)f_tell(&f->fp),
+				         (uint32_t)f_size(&f->fp));
+			/* the new part is not written, take what it reads */
+			SIM_CK(f_lseek(&f->fp, f->size));
+			SIM_CK(f_read(&f->fp, f->copy + f->size, pos - f->size, &br));
+			f->size = pos;
+		} else if (op < 88) {
+			SIM_CK(f_close(&f->fp));
+			f->open = 0;
+		} else if (op < 90) {	/* sync all, the card must have it all */
+			for (i = 0; i < SIM_FILES; ++i) {
+				if (sim_file[i].open)
+					SIM_CK(f_sync(&sim_file[i].fp));
+			}
+			sim_verify_card();
+		} else if (op < 92) {	/* reopen to append */
+			SIM_CK(f_close(&f->fp));
+			sim_path(path, "0:", f - sim_file);
+			SIM_CK(f_open(&f->fp, path, FA_OPEN_APPEND | FA_READ | FA_WRITE));
+			if (f_tell(&f->fp) != f->size)
+				SIM_FAIL("iter %ld: append at %u, size %u", sim_iter,
+				         (uint32_t)f_tell(&f->fp), f->size);
+			n = 1 + sim_rand() % 500;
+			if (n <= SIM_FILE_MAX - f->size)
+				sim_write_at(f, f->size, n);
+		} else if (op < 93) {	/* remount, the card maybe changed */
+			sim_close_all();
+			sim_unmount();
+			sim_verify_card();
+			if (sim_rand() % 2) {
+				sim_change_card();
+				changes++;
+			}
+			cache = sim_rand() % 4 != 0;
+			sim_mount(cache);
+			sim_verify_all("0:");
+			remounts++;
+		} else if (op < 95) {	/* remount under the open files */
+			for (i = 0; i < SIM_FILES; ++i) {
+				if (sim_file[i].open)
+					SIM_CK(f_sync(&sim_file[i].fp));
+			}
+			sim_unmount();
+			sim_mount(cache);
+			for (i = 0; i < SIM_FILES; ++i) {
+				if (!sim_file[i].open)
+					continue;
+				sim_path(path, "0:", i);
+				SIM_CK(f_open(&sim_file[i].fp, path, FA_READ | FA_WRITE));
+				sim_read_back(&sim_file[i]);
+			}
+			remounts++;
+		}
+	}
+
+	sim_close_all();
+	sim_unmount();
+	sim_verify_card();
+	printf("seed %u: %ld operations, %d remounts, %d card changes, "
+	       "cache hit %u miss %u, card rd %u wr %u commands: OK\n",
+	       seed, iters, remounts, changes, mmc_cache.stats.hit,
+	       mmc_cache.stats.miss, sim_stat.rd_cmd, sim_stat.wr_cmd);
+	for (i = 0; i < SIM_FILES; ++i)
+		free(sim_file[i].copy);
+}
+
+#define SIM_BENCH_SIZE	(2 * 1024 * 1024)
+
+struct sim_bench_res {
+	double		time_us;
+	uint32_t	cmd;
+};
+
+static struct sim_card_stat sim_bench_st;
+
+static void sim_bench_start(void)
+{
+	sim_bench_st = sim_stat;
+}
+
+static void sim_bench_end(struct sim_bench_res *res)
+{
+	res->time_us = sim_stat.time_us - sim_bench_st.time_us;
+	res->cmd = sim_stat.rd_cmd - sim_bench_st.rd_cmd +
+	           sim_stat.wr_cmd - sim_bench_st.wr_cmd;
+}
+
+static void sim_bench_seq(const char *path, uint32_t bs, int wr,
+                          struct sim_bench_res *res)
+{
+	uint32_t pos;
+	UINT n;
+	FIL fp;
+
+	sim_bench_start();
+	SIM_CK(f_open(&fp, path, wr ? FA_CREATE_ALWAYS | FA_WRITE : FA_READ));
+	for (pos = 0; pos < SIM_BENCH_SIZE; pos += bs) {
+		if (wr)
+			SIM_CK(f_write(&fp, sim_buf, bs, &n));
+		else
+			SIM_CK(f_read(&fp, sim_buf, bs, &n));
+		if (n != bs)
+			SIM_FAIL("%s: %u of %u at %u", path, n, bs, pos);
+	}
+	SIM_CK(f_close(&fp));
+	sim_bench_end(res);
+}
+
+static void sim_bench_rand(const char *path, int wr, struct sim_bench_res *res)
+{
+	UINT n;
+	FIL fp;
+	int i;
+
+	sim_bench_start();
+	SIM_CK(f_open(&fp, path, wr ? FA_WRITE : FA_READ));
+	for (i = 0; i < 2000; ++i) {
+		SIM_CK(f_lseek(&fp, sim_rand() % (SIM_BENCH_SIZE / 512) * 512));
+		if (wr)
+			SIM_CK(f_write(&fp, sim_buf, 512, &n));
+		else
+			SIM_CK(f_read(&fp, sim_buf, 512, &n));
+	}
+	SIM_CK(f_close(&fp));
+	sim_bench_end(res);
+}
+
+static void sim_bench_create(struct sim_bench_res *res)
+{
+	char path[32];
+	UINT n;
+	FIL fp;
+	int i;
+
+	SIM_CK(f_mkdir("0:/d"));
+	sim_bench_start();
+	for (i = 0; i < 300; ++i) {
+		sprintf(path, "0:/d/file%03d.txt", i);
+		SIM_CK(f_open(&fp, path, FA_CREATE_NEW | FA_WRITE));
+		SIM_CK(f_write(&fp, sim_buf, 200, &n));
+		SIM_CK(f_close(&fp));
+	}
+	sim_bench_end(res);
+}
+
+static double sim_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+ * Random seeks in a file of 6 extents of 96K, from its end (the chain is
+ * walked from the top without a map). The host time is the one of f_lseek()
+ * alone, best of 10 runs of 40000 seeks.
+ */
+static void sim_bench_seek(FIL *fp, const char *name)
+{
+	double t, best = 1e30;
+	uint32_t size = 6 * 96 * 1024;
+	int i, r;
+
+	sim_fat_reads = 0;
+	for (r = 0; r < 10; ++r) {
+		t = sim_now_ns();
+		for (i = 0; i < 20000; ++i) {
+			SIM_CK(f_lseek(fp, size));
+			SIM_CK(f_lseek(fp, sim_rand() % size));
+		}
+		t = (sim_now_ns() - t) / 40000;
+		if (t < best)
+			best = t;
+	}
+	printf("%-24s %6.0f ns per seek, %.2f FAT sectors read\n", name, best,
+	       sim_fat_reads / 400000.0);
+}
+
+/* the first file gets an extent map, the others fill the table */
+static void sim_bench_xmap(void)
+{
+	FIL fp[_EXTMAP_FILES + 1];
+	char path[16];
+	UINT n;
+	int i, k;
+
+	sim_init(1);
+	sim_mount(1);
+	for (i = 0; i <= _EXTMAP_FILES; ++i) {
+		sprintf(path, "0:/x%d.bin", i);
+		SIM_CK(f_open(&fp[i], path, FA_CREATE_ALWAYS | FA_READ | FA_WRITE));
+	}
+	for (k = 0; k < 6; ++k) {
+		SIM_CK(f_write(&fp[0], sim_buf, 48 * 1024, &n));
+		SIM_CK(f_write(&fp[0], sim_buf, 48 * 1024, &n));
+		SIM_CK(f_write(&fp[_EXTMAP_FILES], sim_buf, 48 * 1024, &n));
+		SIM_CK(f_write(&fp[_EXTMAP_FILES], sim_buf, 48 * 1024, &n));
+	}
+	sim_bench_seek(&fp[0], "seek, extent map");
+	sim_bench_seek(&fp[_EXTMAP_FILES], "seek, no map");
+	for (i = 0; i <= _EXTMAP_FILES; ++i)
+		SIM_CK(f_close(&fp[i]));
+	sim_unmount();
+}
+
+#define SIM_BENCH_NUM	8
+
+static const char *sim_bench_name[SIM_BENCH_NUM] = {
+	"seq write 2M by 512",
+	"seq read 2M by 512",
+	"seq write 2M by 4096",
+	"seq read 2M by 4096",
+	"rand read 512 x2000",
+	"rand write 512 x2000",
+	"create 300 files 200B",
+	NULL,
+};
+
+static void sim_bench_run(int cache, struct sim_bench_res *res)
+{
+	sim_init(1);
+	sim_mount(cache);
+	sim_bench_seq("0:/a.bin", 512, 1, &res[0]);
+	sim_bench_seq("0:/a.bin", 512, 0, &res[1]);
+	sim_bench_seq("0:/b.bin", 4096, 1, &res[2]);
+	sim_bench_seq("0:/b.bin", 4096, 0, &res[3]);
+	sim_bench_rand("0:/a.bin", 0, &res[4]);
+	sim_bench_rand("0:/a.bin", 1, &res[5]);
+	sim_bench_create(&res[6]);
+	sim_unmount();
+}
+
+static void sim_bench(void)
+{
+	struct sim_bench_res direct[SIM_BENCH_NUM], cached[SIM_BENCH_NUM];
+	int i;
+
+	for (i = 0; i < SIM_IO_MAX; ++i)
+		sim_buf[i] = i;
+	sim_bench_run(0, direct);
+	sim_bench_run(1, cached);
+
+	printf("%-24s %20s %20s\n", "", "direct", "blk_cache");
+	for (i = 0; i < 6; ++i) {
+		double mb = i < 4 ? SIM_BENCH_SIZE : 2000 * 512;
+
+		printf("%-24s %6.2f MB/s %5u cmd %6.2f MB/s %5u cmd\n",
+		       sim_bench_name[i], mb / direct[i].time_us, direct[i].cmd,
+		       mb / cached[i].time_us, cached[i].cmd);
+	}
+	printf("%-24s %6.0f files/s %3u cmd %6.0f files/s %3u cmd\n",
+	       sim_bench_name[6], 300e6 / direct[6].time_us, direct[6].cmd,
+	       300e6 / cached[6].time_us, cached[6].cmd);
+	sim_bench_xmap();
+}
+
+int main(int argc, char **argv)
+{
+	if (argc >= 2 && strcmp(argv[1], "test") == 0) {
+		sim_test(argc >= 3 ? atol(argv[2]) : 20000,
+		         argc >= 4 ? atoi(argv[3]) : 1);
+		return 0;
+	}
+	if (argc >= 2 && strcmp(argv[1], "bench") == 0) {
+		sim_bench();
+		return 0;
+	}
+	printf("usage: %s test [iterations [seed]] | bench\n", argv[0]);
+	return 1;
+}
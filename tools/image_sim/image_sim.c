@@ -0,0 +1,571 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host test of the image checks in image/image.c, on the flash simulator of
+ * tools/norfs_sim. image.c is built in, fdcm is the one of the ROM.
+ *
+ * usage: image_sim test [seed [cycles]]
+ *        image_sim bench
+ *
+ * The test checks image_checksum16() against the loop of the ROM at every
+ * alignment, then boots a synthesized image with image_check_sections_cached():
+ * the first boot reads all the data and records the image, the next ones only
+ * read the section headers. A changed header, an OTA to the other sequence, a
+ * bad body and power cuts while the record is written are checked too. A body
+ * bit flip is only found by a full check, as image_check_sections_cached()
+ * does not read the bodies of a recorded image; the scrub is there for that.
+ *
+ * The bench gives the flash reads and time of a full and a cached boot, and
+ * the host time of image_checksum16() against the loop of the ROM.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "flashsim.h"
+#include "image.c"
+
+#define SIM_FAIL(fmt, arg...)									\
+	do {														\
+		printf("FAIL %s():%d, " fmt "\n", __func__, __LINE__, ##arg);	\
+		exit(1);												\
+	} while (0)
+
+/*
+ * Flash layout: a 16K bootloader and image 0 up to 448K, the OTA area (16K)
+ * and image 1 from 448K, the record of validated images at 960K. The record
+ * area is 4K so that fdcm erases and rewrites it (every 500 writes or so)
+ * during the power cut test.
+ */
+#define SIM_BL_SIZE		(16 * 1024)
+#define SIM_IMG_MAX		(432)	/* KB, excluding the bootloader */
+#define SIM_OTA_ADDR	(448 * 1024)
+#define SIM_OTA_SIZE	(16 * 1024)
+#define SIM_CACHE_ADDR	(960 * 1024)
+#define SIM_CACHE_SIZE	(4 * 1024)
+
+#define SIM_SEC_NUM		(4)
+
+static const struct {
+	uint32_t	id;
+	uint32_t	size;
+} sim_sec[SIM_SEC_NUM] = {
+	{ IMAGE_APP_ID,      150 * 1024 + 6 },
+	{ IMAGE_APP_XIP_ID,  200 * 1024 + 1 },
+	{ IMAGE_WLAN_BL_ID,  2 * 1024 + 3 },
+	{ IMAGE_WLAN_FW_ID,  28 * 1024 },
+};
+
+/* the section offsets in the image, including the bootloader */
+static uint32_t sim_sec_off[SIM_SEC_NUM];
+
+static uint32_t sim_total;	/* bytes in all sections of an image */
+
+/* ROM parts used by image.c */
+
+static image_priv_t sim_priv;
+static image_cfg_t sim_cfg = { 0, IMAGE_STATE_VERIFIED };
+
+const image_ota_param_t *image_get_ota_param(void)
+{
+	return &sim_priv.iop;
+}
+
+int image_get_cfg(image_cfg_t *cfg)
+{
+	*cfg = sim_cfg;
+	return 0;
+}
+
+image_val_t image_check_header(section_header_t *sh)
+{
+	if (sh->magic_number != IMAGE_MAGIC_NUMBER)
+		return IMAGE_INVALID;
+	if (image_checksum16((uint8_t *)sh, IMAGE_HEADER_SIZE) != 0xFFFF)
+		return IMAGE_INVALID;
+	return IMAGE_VALID;
+}
+
+/* the loop of image_get_checksum() in the ROM */
+static uint16_t sim_rom_checksum16(uint8_t *data, uint32_t len)
+{
+	uint16_t chksum16 = 0;
+	uint32_t chksum32;
+	uint32_t *p32;
+	uint16_t *p16;
+
+	p32 = (uint32_t *)data;
+	while (len >= 4) {
+		chksum32 = *p32++;
+		len -= 4;
+		chksum16 += (uint16_t)chksum32;
+		chksum16 += (uint16_t)(chksum32 >> 16);
+	}
+	p16 = (uint16_t *)p32;
+	while (len >= 2) {
+		chksum16 += *p16++;
+		len -= 2;
+	}
+	if (len > 0)
+		chksum16 += *(uint8_t *)p16;
+	return chksum16;
+}
+
+static int sim_write(uint32_t addr, const void *buf, uint32_t size)
+{
+	return flash_write(0, addr, buf, size) == size ? 0 : -1;
+}
+
+static int sim_erase(uint32_t addr, uint32_t size)
+{
+	size = (size + FLASHSIM_SECTOR - 1) & ~(FLASHSIM_SECTOR - 1);
+	return flash_erase(0, addr, size);
+}
+
+/* the flash address of offset off of the image seq */
+static uint32_t sim_addr(image_seq_t seq, uint32_t off)
+{
+	return seq == 0 ? off : SIM_OTA_ADDR + SIM_OTA_SIZE + off - SIM_BL_SIZE;
+}
+
+static void sim_header(section_header_t *sh, uint32_t id, uint8_t *body,
+                       uint32_t size, uint32_t next_addr, uint32_t version)
+{
+	memset(sh, 0, sizeof(*sh));
+	sh->magic_number = IMAGE_MAGIC_NUMBER;
+	sh->version = version;
+	sh->data_size = size;
+	sh->body_len = size;
+	sh->next_addr = next_addr;
+	sh->id = id;
+	sh->data_chksum = 0xFFFF - image_checksum16(body, size);
+	sh->header_chksum = 0xFFFF - image_checksum16((uint8_t *)sh, sizeof(*sh));
+}
+
+/* the bootloader, with the OTA area and the image max size in priv[] */
+static void sim_write_bl(void)
+{
+	section_header_t sh;
+	uint8_t body[256];
+	uint32_t i;
+
+	for (i = 0; i < sizeof(body); ++i)
+		body[i] = flashsim_rand();
+	sim_header(&sh, IMAGE_BOOT_ID, body, sizeof(body), SIM_BL_SIZE, 2);
+	sh.priv[0] = 0 | (SIM_OTA_SIZE << 8);
+	sh.priv[1] = SIM_OTA_ADDR;
+	sh.priv[2] = (SIM_BL_SIZE / 1024 + SIM_IMG_MAX) | (IMAGE_INVALID_SIZE << 16);
+	sh.header_chksum = 0;
+	sh.header_chksum = 0xFFFF - image_checksum16((uint8_t *)&sh, sizeof(sh));
+	if (sim_erase(0, SIM_BL_SIZE) != 0 ||
+	    sim_write(0, &sh, sizeof(sh)) != 0 ||
+	    sim_write(IMAGE_HEADER_SIZE, body, sizeof(body)) != 0)
+		SIM_FAIL("write bootloader failed");
+}
+
+/*
+ * Erase the image seq and write a new one of random bodies, section by
+ * section as OTA does, version tells it in the headers. Stops at the first
+ * failed erase or program (power cut).
+ */
+static int sim_write_image(image_seq_t seq, uint32_t version)
+{
+	section_header_t sh;
+	uint8_t *body;
+	uint32_t next, i, j;
+	int ret = 0;
+
+	if (sim_erase(sim_addr(seq, SIM_BL_SIZE), SIM_IMG_MAX * 1024) != 0)
+		return -1;
+	for (i = 0; i < SIM_SEC_NUM && ret == 0; ++i) {
+		body = malloc(sim_sec[i].size);
+		for (j = 0; j < sim_sec[i].size; ++j)
+			body[j] = flashsim_rand();
+		next = i + 1 < SIM_SEC_NUM ? sim_sec_off[i + 1] : IMAGE_INVALID_ADDR;
+		sim_header(&sh, sim_sec[i].id, body, sim_sec[i].size, next, version);
+		if (sim_write(sim_addr(seq, sim_sec_off[i]), &sh, sizeof(sh)) != 0 ||
+		    sim_write(sim_addr(seq, sim_sec_off[i]) + IMAGE_HEADER_SIZE,
+		              body, sim_sec[i].size) != 0)
+			ret = -1;
+		free(body);
+	}
+	return ret;
+}
+
+static uint32_t sim_flip_addr;
+static uint8_t sim_flip_mask;
+
+/* flip a bit in the body of a section of the image seq, a bad download */
+static void sim_flip(image_seq_t seq, int sec)
+{
+	sim_flip_addr = sim_addr(seq, sim_sec_off[sec]) + IMAGE_HEADER_SIZE +
+	                flashsim_rand() % sim_sec[sec].size;
+	sim_flip_mask = 1 << (flashsim_rand() % 8);
+	flashsim_mem[sim_flip_addr] ^= sim_flip_mask;
+}
+
+static void sim_unflip(void)
+{
+	flashsim_mem[sim_flip_addr] ^= sim_flip_mask;
+}
+
+/* what a full check of the image seq must give, from the flash array */
+static image_val_t sim_ref_check(image_seq_t seq)
+{
+	section_header_t sh;
+	uint32_t addr = 0;
+	uint32_t off;
+	int n;
+
+	for (n = 0; n <= SIM_SEC_NUM; ++n) {
+		if (addr > FLASHSIM_SIZE - IMAGE_HEADER_SIZE)
+			return IMAGE_INVALID;
+		memcpy(&sh, flashsim_mem + addr, sizeof(sh));
+		if (sh.magic_number != IMAGE_MAGIC_NUMBER ||
+		    sim_rom_checksum16((uint8_t *)&sh, sizeof(sh)) != 0xFFFF ||
+		    sh.data_size > FLASHSIM_SIZE - addr - IMAGE_HEADER_SIZE)
+			return IMAGE_INVALID;
+		if ((uint16_t)(sh.data_chksum +
+		               sim_rom_checksum16(flashsim_mem + addr + IMAGE_HEADER_SIZE,
+		                                  sh.data_size)) != 0xFFFF)
+			return IMAGE_INVALID;
+		off = sh.next_addr;
+		if (off == IMAGE_INVALID_ADDR)
+			return IMAGE_VALID;
+		if (off < SIM_BL_SIZE || off >= SIM_BL_SIZE + SIM_IMG_MAX * 1024)
+			return IMAGE_INVALID;
+		addr = sim_addr(seq, off);
+	}
+	return IMAGE_INVALID;
+}
+
+static void sim_layout(void)
+{
+	uint32_t off = SIM_BL_SIZE;
+	int i;
+
+	sim_total = 0;
+	for (i = 0; i < SIM_SEC_NUM; ++i) {
+		sim_sec_off[i] = off;
+		off += (IMAGE_HEADER_SIZE + sim_sec[i].size + 1023) & ~1023;
+		sim_total += IMAGE_HEADER_SIZE + sim_sec[i].size;
+	}
+	if (off - SIM_BL_SIZE > SIM_IMG_MAX * 1024)
+		SIM_FAIL("image of %u bytes too big", off);
+}
+
+/* power on: image_init() and the record opened, as in the boot of the app */
+static void sim_boot(void)
+{
+	image_check_cache_deinit();
+	flashsim_power_on();
+	memset(&sim_priv, 0, sizeof(sim_priv));
+	if (image_init(0, 0, 0) != 0)
+		SIM_FAIL("image init failed");
+	if (image_check_cache_init(0, SIM_CACHE_ADDR, SIM_CACHE_SIZE) != 0)
+		SIM_FAIL("image check cache init failed");
+}
+
+/* a check, with the bytes it reads and the programs it makes */
+static image_val_t sim_check(image_seq_t seq, int cached, uint32_t *bytes,
+                             uint32_t *progs)
+{
+	struct flashsim_stat st = flashsim_stat;
+	image_val_t ret;
+
+	ret = cached ? image_check_sections_cached(seq) : image_check_sections(seq);
+	if (bytes)
+		*bytes = flashsim_stat.read_bytes - st.read_bytes;
+	if (progs)
+		*progs = flashsim_stat.prog_cnt - st.prog_cnt;
+	return ret;
+}
+
+
+#define SIM_HDR_BYTES	((SIM_SEC_NUM + 1) * IMAGE_HEADER_SIZE)
+
+static void sim_test_checksum(void)
+{
+	uint8_t *buf;
+	uint32_t off, len, i;
+
+	buf = malloc(8200);
+	for (i = 0; i < 8200; ++i)
+		buf[i] = flashsim_rand();
+	for (off = 0; off < 8; ++off) {
+		for (len = 0; len <= 8192; len += len < 300 ? 1 : 37) {
+			if (image_checksum16(buf + off, len) !=
+			    sim_rom_checksum16(buf + off, len))
+				SIM_FAIL("checksum16 off %u len %u: %#x, ROM %#x", off, len,
+				         image_checksum16(buf + off, len),
+				         sim_rom_checksum16(buf + off, len));
+		}
+	}
+	memset(buf, 0xFF, 8200);	/* the most carries */
+	if (image_checksum16(buf + 2, 8190) != sim_rom_checksum16(buf + 2, 8190))
+		SIM_FAIL("checksum16 of 0xFF");
+	free(buf);
+	printf("checksum16: same as ROM at offsets 0..7, lengths 0..8192\n");
+}
+
+/*
+ * A cached check, expecting its result and whether the bodies are read (all
+ * of them for a valid image, up to the bad one else)
+ */
+static void sim_expect(const char *what, image_seq_t seq, image_val_t val,
+                       int full)
+{
+	uint32_t bytes, progs;
+	image_val_t ret;
+
+	ret = sim_check(seq, 1, &bytes, &progs);
+	if (ret != val)
+		SIM_FAIL("%s: seq %u %s", what, seq, ret ? "valid" : "invalid");
+	if (full ? bytes <= SIM_HDR_BYTES || (val && bytes < sim_total) :
+	           bytes != SIM_HDR_BYTES)
+		SIM_FAIL("%s: seq %u read %u bytes", what, seq, bytes);
+	if (!full && progs != 0)
+		SIM_FAIL("%s: seq %u, %u programs", what, seq, progs);
+}
+
+static void sim_test_boots(void)
+{
+	uint32_t bytes;
+
+	sim_write_bl();
+	if (sim_write_image(0, 1) != 0)
+		SIM_FAIL("write image failed");
+	sim_boot();
+	sim_expect("first boot", 0, IMAGE_VALID, 1);
+	sim_boot();
+	sim_expect("second boot", 0, IMAGE_VALID, 0);
+	sim_expect("second check", 0, IMAGE_VALID, 0);
+
+	/* a new image in place has other headers: a full check */
+	sim_write_image(0, 2);
+	sim_expect("new image", 0, IMAGE_VALID, 1);
+	sim_boot();
+	sim_expect("new image, boot", 0, IMAGE_VALID, 0);
+
+	/* a new image with a bad body is never recorded */
+	sim_write_image(0, 3);
+	sim_flip(0, 1);
+	sim_expect("bad image", 0, IMAGE_INVALID, 1);
+	sim_boot();
+	sim_expect("bad image, boot", 0, IMAGE_INVALID, 1);
+	sim_unflip();
+	sim_expect("bad image fixed", 0, IMAGE_VALID, 1);
+
+	/* a bit flip in a recorded image is only found by the scrub */
+	sim_flip(0, 3);
+	sim_expect("flip, cached", 0, IMAGE_VALID, 0);
+	if (sim_check(0, 0, &bytes, NULL) != IMAGE_INVALID || bytes < sim_total)
+		SIM_FAIL("flip, scrub: not found");
+	sim_expect("flip, after scrub", 0, IMAGE_INVALID, 1);
+	sim_boot();
+	sim_expect("flip, boot", 0, IMAGE_INVALID, 1);
+	sim_unflip();
+	sim_expect("flip fixed", 0, IMAGE_VALID, 1);
+
+	/* OTA to image 1, image 0 stays recorded */
+	image_check_cache_clear(1);
+	sim_write_image(1, 5);
+	sim_expect("ota", 1, IMAGE_VALID, 1);
+	sim_expect("ota, image 0", 0, IMAGE_VALID, 0);
+	sim_boot();
+	sim_expect("ota, boot", 1, IMAGE_VALID, 0);
+	sim_expect("ota, boot, image 0", 0, IMAGE_VALID, 0);
+
+	/* without a record area, every check is a full one */
+	image_check_cache_deinit();
+	sim_expect("no record", 0, IMAGE_VALID, 1);
+	sim_expect("no record", 0, IMAGE_VALID, 1);
+	printf("boots: full check %u bytes, cached %u bytes\n",
+	       sim_total, (uint32_t)SIM_HDR_BYTES);
+}
+
+/*
+ * OTA, scrub and abandoned OTA on random sequences, with a power cut at a
+ * random erase or program, sometimes none. After each power on, a cached
+ * check of each image must give what a full check gives, and a valid image
+ * must be recorded by then (only its headers read by the next check).
+ */
+static void sim_test_cuts(int cycles)
+{
+	uint32_t ver = 10;
+	uint32_t progs;
+	image_seq_t seq;
+	image_val_t ref;
+	int c, action, cuts = 0;
+
+	for (c = 0; c < cycles; ++c) {
+		seq = flashsim_rand() % IMAGE_SEQ_NUM;
+		action = flashsim_rand() % 4;
+		flashsim_cut_at(flashsim_rand() % 4 ?
+		                (long)(flashsim_rand() % (action == 0 ? 140 : 8)) : -1);
+		switch (action) {
+		case 0:		/* OTA, sometimes a bad download */
+			image_check_cache_clear(seq);
+			if (sim_write_image(seq, ++ver) == 0 && flashsim_rand() % 3 == 0)
+				sim_flip(seq, flashsim_rand() % SIM_SEC_NUM);
+			image_check_sections_cached(seq);
+			break;
+		case 1:		/* scrub */
+			image_check_sections(seq);
+			break;
+		case 2:		/* OTA started and given up */
+			image_check_cache_clear(seq);
+			image_check_sections_cached(seq);
+			break;
+		default:	/* boot */
+			image_check_sections_cached(seq);
+			break;
+		}
+		cuts += flashsim_is_cut();
+		sim_boot();
+
+		for (seq = 0; seq < IMAGE_SEQ_NUM; ++seq) {
+			ref = sim_ref_check(seq);
+			if (sim_check(seq, 1, NULL, NULL) != ref)
+				SIM_FAIL("cycle %d: seq %u should be %s", c, seq,
+				         ref ? "valid" : "invalid");
+			if (ref == IMAGE_VALID) {
+				sim_expect("after cut", seq, IMAGE_VALID, 0);
+			} else if (sim_check(seq, 1, NULL, &progs) != IMAGE_INVALID ||
+			           progs != 0) {
+				SIM_FAIL("cycle %d: seq %u invalid, %u programs", c, seq,
+				         progs);
+			}
+		}
+	}
+	printf("power cuts: %d cycles, %d cuts, %u programs, %u erases\n",
+	       cycles, cuts, flashsim_stat.prog_cnt, flashsim_stat.erase_cnt);
+	if (flashsim_stat.prog_err)
+		SIM_FAIL("%u programs of a bit set", flashsim_stat.prog_err);
+}
+
+static void sim_test(uint32_t seed, int cycles)
+{
+	flashsim_init(seed);
+	sim_layout();
+	sim_test_checksum();
+	sim_test_boots();
+	sim_test_cuts(cycles);
+	image_check_cache_deinit();
+	printf("PASS seed %u\n", seed);
+}
+
+static double sim_now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/* the flash time is the one of the reads, as in flashsim.c */
+static void sim_bench_boot(const char *name, int full)
+{
+	struct flashsim_stat st;
+	uint32_t reads;
+	uint64_t bytes;
+
+	if (full)
+		image_check_cache_clear(0);
+	st = flashsim_stat;
+	if (image_check_sections_cached(0) != IMAGE_VALID)
+		SIM_FAIL("%s: invalid", name);
+	reads = flashsim_stat.read_cnt - st.read_cnt;
+	bytes = flashsim_stat.read_bytes - st.read_bytes;
+	printf("%-14s %3u reads %8llu bytes %7.2f ms, %u programs\n", name,
+	       reads, (unsigned long long)bytes, (reads * 1.0 + bytes * 0.05) / 1000,
+	       flashsim_stat.prog_cnt - st.prog_cnt);
+}
+
+/* best of 10 runs, each long enough for the clock */
+static double sim_bench_sum(uint16_t (*sum)(uint8_t *, uint32_t), uint8_t *buf,
+                            uint32_t len)
+{
+	volatile uint16_t s = 0;
+	double t, best = 1e30;
+	int i, r;
+
+	for (r = 0; r < 10; ++r) {
+		t = sim_now_us();
+		for (i = 0; i < 64; ++i)
+			s += sum(buf, len);
+		t = (sim_now_us() - t) / 64;
+		if (t < best)
+			best = t;
+	}
+	return best;
+}
+
+static void sim_bench(void)
+{
+	uint8_t *buf;
+	uint32_t i;
+
+	flashsim_init(1);
+	sim_layout();
+	sim_write_bl();
+	sim_write_image(0, 1);
+	sim_boot();
+	printf("image of %u sections, %u bytes, flash read at 20 MB/s\n",
+	       SIM_SEC_NUM, sim_total);
+	sim_bench_boot("full check", 1);
+	sim_bench_boot("cached check", 0);
+
+	buf = malloc(1024 * 1024);
+	for (i = 0; i < 1024 * 1024; ++i)
+		buf[i] = flashsim_rand();
+	printf("checksum16 of 1M on the host: %.1f us, ROM loop %.1f us\n",
+	       sim_bench_sum(image_checksum16, buf, 1024 * 1024),
+	       sim_bench_sum(sim_rom_checksum16, buf, 1024 * 1024));
+	free(buf);
+	image_check_cache_deinit();
+}
+
+int main(int argc, char **argv)
+{
+	if (argc >= 2 && strcmp(argv[1], "test") == 0) {
+		sim_test(argc >= 3 ? atoi(argv[2]) : 1,
+		         argc >= 4 ? atoi(argv[3]) : 2000);
+		return 0;
+	}
+	if (argc >= 2 && strcmp(argv[1], "bench") == 0) {
+		sim_bench();
+		return 0;
+	}
+	printf("usage: %s test [seed [cycles]] | bench\n", argv[0]);
+	return 1;
+}
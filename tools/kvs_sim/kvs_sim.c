@@ -0,0 +1,391 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Power-loss test of sysinfo saved in kvs, on the flash simulator of
+ * tools/norfs_sim. sysinfo.c and kvs.c are built in.
+ *
+ * usage: kvs_sim test [cycles [seed]]
+ *        kvs_sim full [cycles [seed]]
+ *
+ * Each cycle changes the station settings, the AP settings and the wlan mode
+ * to random versions and saves them, cutting the power at a random program
+ * or erase (sometimes not at all, sometimes again while mounting). After a
+ * power cut sysinfo is loaded again and checked: each group of fields that go
+ * together (SSID, PSK, DHCP and static address of an interface) must come
+ * from a single version, the one saved before or the one being saved.
+ *
+ * "full" runs kvs alone near its capacity: keys are written with random sizes
+ * until it refuses them, with power cuts. A refused write must leave every key
+ * as it was, and after a cut each key must read its old or its new value.
+ * Writes are not refused while less than half of the area is used.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "flashsim.h"
+#include "common/framework/sysinfo.h"
+#include "image/kvs.h"
+
+#define SIM_FAIL(fmt, arg...)									\
+	do {														\
+		printf("FAIL %s():%d, " fmt "\n", __func__, __LINE__, ##arg);	\
+		exit(1);												\
+	} while (0)
+
+/* a version of the settings, 0 for the defaults */
+struct sim_state {
+	uint32_t	sta;
+	uint32_t	ap;
+	uint32_t	mode;
+};
+
+static uint32_t sim_rand(uint32_t n)
+{
+	return flashsim_rand() % n;
+}
+
+static void sim_sta_param(uint32_t v, struct sysinfo *info)
+{
+	memset(&info->wlan_sta_param, 0, sizeof(info->wlan_sta_param));
+	memset(&info->netif_sta_param, 0, sizeof(info->netif_sta_param));
+	info->sta_use_dhcp = 1;
+	if (v == 0)
+		return;
+	info->wlan_sta_param.ssid_len =
+		snprintf((char *)info->wlan_sta_param.ssid, SYSINFO_SSID_LEN_MAX, "sta-%u", v);
+	snprintf((char *)info->wlan_sta_param.psk, SYSINFO_PSK_LEN_MAX, "psk-%u-%08x", v, v * 2654435761U);
+	info->sta_use_dhcp = v & 1;
+	IP4_ADDR(&info->netif_sta_param.ip_addr, 10, v >> 8 & 0xFF, v & 0xFF, 2);
+	IP4_ADDR(&info->netif_sta_param.net_mask, 255, 255, 255, 0);
+	IP4_ADDR(&info->netif_sta_param.gateway, 10, v >> 8 & 0xFF, v & 0xFF, 1);
+}
+
+static void sim_ap_param(uint32_t v, struct sysinfo *info)
+{
+	memset(&info->wlan_ap_param, 0, sizeof(info->wlan_ap_param));
+	IP4_ADDR(&info->netif_ap_param.ip_addr, 192, 168, 51, 1);
+	IP4_ADDR(&info->netif_ap_param.net_mask, 255, 255, 255, 0);
+	IP4_ADDR(&info->netif_ap_param.gateway, 192, 168, 51, 1);
+	if (v == 0)
+		return;
+	info->wlan_ap_param.ssid_len =
+		snprintf((char *)info->wlan_ap_param.ssid, SYSINFO_SSID_LEN_MAX, "ap-%u", v);
+	snprintf((char *)info->wlan_ap_param.psk, SYSINFO_PSK_LEN_MAX, "ap-psk-%u", v);
+	info->wlan_ap_param.channel = 1 + v % 13;
+	IP4_ADDR(&info->netif_ap_param.ip_addr, 172, 16, v & 0xFF, 1);
+	IP4_ADDR(&info->netif_ap_param.gateway, 172, 16, v & 0xFF, 1);
+}
+
+static void sim_set(const struct sim_state *st, struct sysinfo *info)
+{
+	sim_sta_param(st->sta, info);
+	sim_ap_param(st->ap, info);
+	info->wlan_mode = st->mode ? WLAN_MODE_HOSTAP : WLAN_MODE_STA;
+}
+
+/* version of a group read back, -1 if the fields come from different ones */
+static long sim_sta_version(const struct sysinfo *info)
+{
+	struct sysinfo ref;
+	unsigned int v = 0;
+
+	if (info->wlan_sta_param.ssid_len != 0 &&
+	    sscanf((const char *)info->wlan_sta_param.ssid, "sta-%u", &v) != 1)
+		return -1;
+	sim_sta_param(v, &ref);
+	if (memcmp(&ref.wlan_sta_param, &info->wlan_sta_param, sizeof(ref.wlan_sta_param)) ||
+	    memcmp(&ref.netif_sta_param, &info->netif_sta_param, sizeof(ref.netif_sta_param)) ||
+	    ref.sta_use_dhcp != info->sta_use_dhcp)
+		return -1;
+	return v;
+}
+
+static long sim_ap_version(const struct sysinfo *info)
+{
+	struct sysinfo ref;
+	unsigned int v = 0;
+
+	if (info->wlan_ap_param.ssid_len != 0 &&
+	    sscanf((const char *)info->wlan_ap_param.ssid, "ap-%u", &v) != 1)
+		return -1;
+	sim_ap_param(v, &ref);
+	if (memcmp(&ref.wlan_ap_param, &info->wlan_ap_param, sizeof(ref.wlan_ap_param)) ||
+	    memcmp(&ref.netif_ap_param, &info->netif_ap_param, sizeof(ref.netif_ap_param)))
+		return -1;
+	return v;
+}
+
+/* check the loaded sysinfo against the saved and the new versions */
+static void sim_check(const struct sim_state *old, const struct sim_state *new,
+                      struct sim_state *now, long cycle)
+{
+	struct sysinfo *info = sysinfo_get();
+	long sta, ap;
+
+	if (info == NULL)
+		SIM_FAIL("cycle %ld: no sysinfo", cycle);
+	sta = sim_sta_version(info);
+	ap = sim_ap_version(info);
+	if (sta < 0 || (sta != old->sta && sta != new->sta))
+		SIM_FAIL("cycle %ld: station settings mixed or lost (%ld, saved %u, new %u)",
+		         cycle, sta, old->sta, new->sta);
+	if (ap < 0 || (ap != old->ap && ap != new->ap))
+		SIM_FAIL("cycle %ld: AP settings mixed or lost (%ld, saved %u, new %u)",
+		         cycle, ap, old->ap, new->ap);
+	if (info->wlan_mode != (old->mode ? WLAN_MODE_HOSTAP : WLAN_MODE_STA) &&
+	    info->wlan_mode != (new->mode ? WLAN_MODE_HOSTAP : WLAN_MODE_STA))
+		SIM_FAIL("cycle %ld: wlan mode %d lost", cycle, info->wlan_mode);
+	now->sta = sta;
+	now->ap = ap;
+	now->mode = info->wlan_mode == WLAN_MODE_HOSTAP;
+}
+
+/* power on and load sysinfo, maybe cutting the power while mounting */
+static void sim_boot(long cycle)
+{
+	while (1) {
+		flashsim_power_on();
+		sysinfo_deinit();
+		if (sim_rand(4) == 0)
+			flashsim_cut_at(sim_rand(8));
+		if (sysinfo_init() == 0 && !flashsim_is_cut()) {
+			flashsim_cut_at(-1);
+			return;
+		}
+		if (!flashsim_is_cut())
+			SIM_FAIL("cycle %ld: sysinfo_init failed", cycle);
+	}
+}
+
+static int sim_test(long cycles, uint32_t seed)
+{
+	struct sim_state saved = { 0, 0, 0 }, new, now;
+	struct sysinfo *info;
+	long cycle, cuts = 0;
+	uint32_t version = 0;
+	int ret;
+
+	flashsim_init(seed);
+	sim_boot(0);
+	sim_check(&saved, &saved, &saved, 0);
+	for (cycle = 1; cycle <= cycles; cycle++) {
+		new = saved;
+		switch (sim_rand(4)) {
+		case 0:
+			new.sta = ++version;
+			break;
+		case 1:
+			new.ap = ++version;
+			break;
+		case 2:
+			new.mode = !new.mode;
+			break;
+		default:
+			new.sta = ++version;
+			new.ap = ++version;
+			new.mode = sim_rand(2);
+			break;
+		}
+		info = sysinfo_get();
+		sim_set(&new, info);
+		flashsim_cut_at(sim_rand(5) ? (long)sim_rand(40) : -1);
+		ret = sysinfo_save();
+		if (!flashsim_is_cut()) {
+			flashsim_cut_at(-1);
+			if (ret != 0)
+				SIM_FAIL("cycle %ld: sysinfo_save failed", cycle);
+			saved = new;
+			if (sim_rand(8) != 0)
+				continue;
+			sim_boot(cycle);		/* a clean reboot keeps everything */
+			sim_check(&saved, &saved, &now, cycle);
+			continue;
+		}
+		cuts++;
+		sim_boot(cycle);
+		sim_check(&saved, &new, &now, cycle);
+		saved = now;
+	}
+	printf("seed %u: %ld cycles, %ld power cuts, %u erases, ok\n",
+	       seed, cycles, cuts, flashsim_stat.erase_cnt);
+	return 0;
+}
+
+#define FULL_ADDR		(64 * 1024)
+#define FULL_SIZE		(4 * 4096)
+#define FULL_KEYS		16
+#define FULL_DATA_MAX	2048
+
+struct full_key {
+	uint32_t	ver;
+	uint16_t	size;		/* 0 if not set */
+};
+
+static uint8_t full_buf[FULL_DATA_MAX];
+
+static void full_data(int key, uint32_t ver, uint16_t size, uint8_t *data)
+{
+	uint32_t x = (key + 1) * 2654435761U ^ ver * 40503U;
+	uint16_t i;
+
+	for (i = 0; i < size; i++) {
+		x = x * 1103515245U + 12345U;
+		data[i] = x >> 16;
+	}
+}
+
+static int full_match(kvs_handle_t *hdl, int key, const struct full_key *k)
+{
+	uint8_t data[FULL_DATA_MAX];
+	char name[8];
+	int ret;
+
+	snprintf(name, sizeof(name), "k%d", key);
+	ret = kvs_get(hdl, name, full_buf, sizeof(full_buf));
+	if (k->size == 0)
+		return ret < 0;
+	if (ret != k->size)
+		return 0;
+	full_data(key, k->ver, k->size, data);
+	return memcmp(data, full_buf, k->size) == 0;
+}
+
+static kvs_handle_t *full_boot(long cycle)
+{
+	kvs_handle_t *hdl;
+
+	while (1) {
+		flashsim_power_on();
+		if (sim_rand(4) == 0)
+			flashsim_cut_at(sim_rand(8));
+		hdl = kvs_open(0, FULL_ADDR, FULL_SIZE, FULL_KEYS);
+		if (hdl != NULL && !flashsim_is_cut()) {
+			flashsim_cut_at(-1);
+			return hdl;
+		}
+		if (!flashsim_is_cut())
+			SIM_FAIL("cycle %ld: kvs_open failed", cycle);
+		if (hdl != NULL)
+			kvs_close(hdl);
+	}
+}
+
+/* bytes the records of the keys take */
+static uint32_t full_live(const struct full_key *keys)
+{
+	uint32_t live = 0;
+	int i;
+
+	for (i = 0; i < FULL_KEYS; i++) {
+		if (keys[i].size)
+			live += (8 + 3 + keys[i].size + 3) & ~3U;
+	}
+	return live;
+}
+
+static int sim_full(long cycles, uint32_t seed)
+{
+	struct full_key keys[FULL_KEYS], new;
+	kvs_handle_t *hdl;
+	uint8_t data[FULL_DATA_MAX];
+	char name[8];
+	long cycle, cuts = 0, refused = 0;
+	uint32_t version = 0;
+	int i, key, ret;
+
+	flashsim_init(seed);
+	memset(keys, 0, sizeof(keys));
+	hdl = full_boot(0);
+	for (cycle = 1; cycle <= cycles; cycle++) {
+		key = sim_rand(FULL_KEYS);
+		new.ver = ++version;
+		new.size = sim_rand(8) ? 1 + sim_rand(sim_rand(2) ? 256 : FULL_DATA_MAX) : 0;
+		full_data(key, new.ver, new.size, data);
+		snprintf(name, sizeof(name), "k%d", key);
+		flashsim_cut_at(sim_rand(5) ? (long)sim_rand(40) : -1);
+		if (new.size == 0)
+			ret = kvs_delete(hdl, name);
+		else
+			ret = kvs_set(hdl, name, data, new.size);
+		if (!flashsim_is_cut()) {
+			flashsim_cut_at(-1);
+			if (ret == 0) {
+				keys[key] = new;
+			} else if (full_live(keys) + new.size + 12 <= FULL_SIZE / 2) {
+				SIM_FAIL("cycle %ld: write refused, only %u bytes used",
+				         cycle, full_live(keys));
+			} else {
+				refused++;
+			}
+			for (i = 0; i < FULL_KEYS; i++) {
+				if (!full_match(hdl, i, &keys[i]))
+					SIM_FAIL("cycle %ld: key %d lost after a %s write",
+					         cycle, i, ret ? "refused" : "good");
+			}
+			if (ret == 0 && sim_rand(8) != 0)
+				continue;
+			kvs_close(hdl);
+			hdl = full_boot(cycle);
+		} else {
+			cuts++;
+			kvs_close(hdl);
+			hdl = full_boot(cycle);
+			if (full_match(hdl, key, &new))
+				keys[key] = new;
+		}
+		for (i = 0; i < FULL_KEYS; i++) {
+			if (!full_match(hdl, i, &keys[i]))
+				SIM_FAIL("cycle %ld: key %d (ver %u, %u bytes) lost",
+				         cycle, i, keys[i].ver, keys[i].size);
+		}
+	}
+	kvs_close(hdl);
+	printf("seed %u: %ld cycles, %ld power cuts, %ld refused, %u erases, ok\n",
+	       seed, cycles, cuts, refused, flashsim_stat.erase_cnt);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	long cycles;
+	uint32_t seed;
+
+	if (argc < 2 || (strcmp(argv[1], "test") && strcmp(argv[1], "full"))) {
+		printf("usage: %s test|full [cycles [seed]]\n", argv[0]);
+		return 2;
+	}
+	cycles = argc > 2 ? atol(argv[2]) : 2000;
+	seed = argc > 3 ? strtoul(argv[3], NULL, 0) : 1;
+	if (strcmp(argv[1], "full") == 0)
+		return sim_full(cycles, seed);
+	return sim_test(cycles, seed);
+}
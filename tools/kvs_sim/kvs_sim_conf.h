@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Project options of sysinfo on the host: kvs in a 16K area at 0 */
+
+#ifndef _KVS_SIM_CONF_H_
+#define _KVS_SIM_CONF_H_
+
+#define __CONFIG_WLAN_STA
+#define __CONFIG_LWIP_V1
+
+#define PRJCONF_NET_EN					1
+#define PRJCONF_CE_EN					0
+#define PRJCONF_MAC_ADDR_SOURCE			SYSINFO_MAC_ADDR_FLASH
+#define PRJCONF_SYSINFO_SAVE_TO_FLASH	1
+#define PRJCONF_SYSINFO_FLASH			0
+#define PRJCONF_SYSINFO_ADDR			0
+#define PRJCONF_SYSINFO_SIZE			(16 * 1024)
+#define PRJCONF_SYSINFO_CHECK_OVERLAP	0
+#define PRJCONF_SYSINFO_USE_KVS			1
+
+#endif /* _KVS_SIM_CONF_H_ */
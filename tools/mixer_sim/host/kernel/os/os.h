@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host OS layer on pthreads, the part of kernel/os the sound mixer uses.
+ * Threads are detached, OS_ThreadDelete() from the thread itself only marks
+ * it gone.
+ */
+
+#ifndef _KERNEL_OS_OS_H_
+#define _KERNEL_OS_OS_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+typedef enum {
+	OS_OK = 0,
+	OS_FAIL = -1,
+	OS_E_TIMEOUT = -2,
+} OS_Status;
+
+typedef enum {
+	OS_PRIORITY_IDLE = 0,
+	OS_PRIORITY_LOW,
+	OS_PRIORITY_BELOW_NORMAL,
+	OS_PRIORITY_NORMAL,
+	OS_PRIORITY_ABOVE_NORMAL,
+	OS_PRIORITY_HIGH,
+	OS_PRIORITY_REAL_TIME,
+} OS_Priority;
+
+#define OS_WAIT_FOREVER		0xffffffffU
+
+typedef uint32_t OS_Time_t;
+typedef void (*OS_ThreadEntry_t)(void *);
+
+typedef struct OS_Mutex {
+	pthread_mutex_t mutex;
+	int valid;
+} OS_Mutex_t;
+
+typedef struct OS_Semaphore {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	int count;
+} OS_Semaphore_t;
+
+typedef struct OS_Thread {
+	pthread_t thread;
+	volatile int valid;
+} OS_Thread_t;
+
+struct os_thread_start {
+	OS_ThreadEntry_t entry;
+	void *arg;
+};
+
+static inline OS_Status OS_MutexCreate(OS_Mutex_t *mutex)
+{
+	pthread_mutex_init(&mutex->mutex, NULL);
+	mutex->valid = 1;
+	return OS_OK;
+}
+
+static inline OS_Status OS_MutexDelete(OS_Mutex_t *mutex)
+{
+	pthread_mutex_destroy(&mutex->mutex);
+	mutex->valid = 0;
+	return OS_OK;
+}
+
+static inline OS_Status OS_MutexLock(OS_Mutex_t *mutex, OS_Time_t waitMS)
+{
+	pthread_mutex_lock(&mutex->mutex);
+	return OS_OK;
+}
+
+static inline OS_Status OS_MutexUnlock(OS_Mutex_t *mutex)
+{
+	pthread_mutex_unlock(&mutex->mutex);
+	return OS_OK;
+}
+
+static inline int OS_MutexIsValid(OS_Mutex_t *mutex)
+{
+	return mutex->valid;
+}
+
+static inline OS_Status OS_SemaphoreCreateBinary(OS_Semaphore_t *sem)
+{
+	pthread_mutex_init(&sem->mutex, NULL);
+	pthread_cond_init(&sem->cond, NULL);
+	sem->count = 0;
+	return OS_OK;
+}
+
+static inline OS_Status OS_SemaphoreDelete(OS_Semaphore_t *sem)
+{
+	pthread_cond_destroy(&sem->cond);
+	pthread_mutex_destroy(&sem->mutex);
+	return OS_OK;
+}
+
+static inline OS_Status OS_SemaphoreRelease(OS_Semaphore_t *sem)
+{
+	pthread_mutex_lock(&sem->mutex);
+	sem->count = 1;
+	pthread_cond_signal(&sem->cond);
+	pthread_mutex_unlock(&sem->mutex);
+	return OS_OK;
+}
+
+static inline OS_Status OS_SemaphoreWait(OS_Semaphore_t *sem, OS_Time_t waitMS)
+{
+	struct timespec ts;
+	OS_Status status;
+	int err = 0;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	if (waitMS != OS_WAIT_FOREVER) {
+		ts.tv_sec += waitMS / 1000;
+		ts.tv_nsec += (waitMS % 1000) * 1000000L;
+		if (ts.tv_nsec >= 1000000000L) {
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000L;
+		}
+	}
+
+	pthread_mutex_lock(&sem->mutex);
+	while (!sem->count && err != ETIMEDOUT) {
+		if (waitMS == OS_WAIT_FOREVER)
+			err = pthread_cond_wait(&sem->cond, &sem->mutex);
+		else
+			err = pthread_cond_timedwait(&sem->cond, &sem->mutex, &ts);
+	}
+	status = sem->count ? OS_OK : OS_E_TIMEOUT;
+	sem->count = 0;
+	pthread_mutex_unlock(&sem->mutex);
+	return status;
+}
+
+static void *os_thread_run(void *arg)
+{
+	struct os_thread_start start = *(struct os_thread_start *)arg;
+
+	free(arg);
+	start.entry(start.arg);
+	return NULL;
+}
+
+static inline OS_Status OS_ThreadCreate(OS_Thread_t *thread, const char *name,
+                                        OS_ThreadEntry_t entry, void *arg,
+                                        OS_Priority priority, uint32_t stackSize)
+{
+	struct os_thread_start *start = malloc(sizeof(*start));
+
+	if (start == NULL)
+		return OS_FAIL;
+	start->entry = entry;
+	start->arg = arg;
+	thread->valid = 1;
+	if (pthread_create(&thread->thread, NULL, os_thread_run, start) != 0) {
+		thread->valid = 0;
+		free(start);
+		return OS_FAIL;
+	}
+	pthread_detach(thread->thread);
+	return OS_OK;
+}
+
+static inline OS_Status OS_ThreadDelete(OS_Thread_t *thread)
+{
+	thread->valid = 0;
+	return OS_OK;
+}
+
+static inline int OS_ThreadIsValid(OS_Thread_t *thread)
+{
+	return thread->valid;
+}
+
+static inline void OS_ThreadSuspendScheduler(void)
+{
+}
+
+static inline void OS_ThreadResumeScheduler(void)
+{
+}
+
+static inline void OS_MSleep(OS_Time_t msec)
+{
+	usleep(msec * 1000);
+}
+
+#endif /* _KERNEL_OS_OS_H_ */
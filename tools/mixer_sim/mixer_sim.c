@@ -0,0 +1,448 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host test and benchmark of the sound mixer, on a fake sound card.
+ * sound_mixer.c is built in, so a period can be mixed without the thread and
+ * the card, and the state of the inputs is at hand.
+ *
+ * usage: mixer_sim test
+ *        mixer_sim bench
+ *
+ * The test checks the ducking level and times, that gains ramp without a
+ * step, that the sum saturates instead of wrapping, the format the card is
+ * opened at, and, with the mixer thread and a card paced at 8x real time,
+ * that every frame written comes out in whole periods while a tone opens
+ * and closes over the music.
+ *
+ * The bench times sound_mixer_mix() alone, per output frame, for the music
+ * alone, with a tone to convert and duck under, and with 4 inputs.
+ */
+
+#define __CONFIG_XPLAYER
+#define PRJCONF_SOUND_MIXER_EN	1
+
+#include "sound_mixer.c"
+
+#define SIM_FAIL(fmt, arg...)									\
+	do {														\
+		printf("FAIL %s():%d, " fmt "\n", __func__, __LINE__, ##arg);	\
+		exit(1);												\
+	} while (0)
+
+#define SIM_FRAME_MAX	(SOUND_MIXER_FIFO_SIZE / 2)
+
+/* the fake card, keeps what is written, at a pace if set */
+static short *card_cap;
+static unsigned int card_cap_max;
+static unsigned int card_frames;
+static unsigned int card_writes;
+static unsigned int card_bad_writes;	/* not a whole period */
+static unsigned int card_opens;
+static unsigned int card_channels;
+static unsigned int card_rate;
+static unsigned int card_pace_us;
+
+int snd_pcm_open(Snd_Card_Num card_num, Audio_Stream_Dir stream_dir, struct pcm_config *pcm_cfg)
+{
+	card_opens++;
+	card_channels = pcm_cfg->channels;
+	card_rate = pcm_cfg->rate;
+	return 0;
+}
+
+int snd_pcm_close(Snd_Card_Num card_num, Audio_Stream_Dir stream_dir)
+{
+	return 0;
+}
+
+int snd_pcm_write(Snd_Card_Num card_num, void *data, uint32_t count)
+{
+	unsigned int frames = count / (card_channels * sizeof(short));
+
+	card_writes++;
+	if (frames != SOUND_MIXER_PERIOD)
+		card_bad_writes++;
+	if (card_cap && card_frames + frames <= card_cap_max)
+		memcpy(card_cap + card_frames * card_channels, data, count);
+	card_frames += frames;
+	if (card_pace_us)
+		usleep(card_pace_us);
+	return count;
+}
+
+static double sim_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* a sine or square source */
+struct sim_src {
+	double freq;
+	double amp;
+	double phase;
+	unsigned int rate;
+	unsigned int channels;
+	int square;
+};
+
+static void sim_gen(struct sim_src *src, short *pcm, unsigned int frames)
+{
+	unsigned int i, c;
+	double v;
+
+	for (i = 0; i < frames; i++) {
+		v = src->amp * sin(src->phase);
+		if (src->square)
+			v = v >= 0 ? src->amp : -src->amp;
+		src->phase += 2 * M_PI * src->freq / src->rate;
+		for (c = 0; c < src->channels; c++)
+			pcm[i * src->channels + c] = (short)lrint(v);
+	}
+}
+
+/* fill the fifo of an input, without waiting */
+static void sim_top_up(SoundMixerInput *input, struct sim_src *src)
+{
+	static short pcm[SIM_FRAME_MAX];
+	unsigned int size = input->channels * sizeof(short);
+	unsigned int room = (SOUND_MIXER_FIFO_SIZE - (input->in - input->out)) / size;
+
+	if (room == 0)
+		return;
+	sim_gen(src, pcm, room);
+	sound_mixer_input_write(input, pcm, room * size);
+}
+
+/* a mixer without its thread, periods are mixed by calling sound_mixer_mix() */
+static SoundMixer *sim_mixer(void)
+{
+	SoundMixer *mixer = calloc(1, sizeof(SoundMixer));
+
+	mixer->duck = sound_mixer_db_to_gain(SOUND_MIXER_DUCK_DEFAULT);
+	mixer->duck_cur = SOUND_MIXER_UNITY;
+	OS_MutexCreate(&mixer->lock);
+	OS_MutexCreate(&mixer->card_lock);
+	OS_SemaphoreCreateBinary(&mixer->wake);
+	return mixer;
+}
+
+static void sim_mixer_free(SoundMixer *mixer)
+{
+	int i;
+
+	for (i = 0; i < SOUND_MIXER_INPUTS_MAX; i++) {
+		if (mixer->input[i])
+			sound_mixer_input_destroy(mixer->input[i]);
+	}
+	free(mixer);
+}
+
+/* rms of the first channel */
+static double sim_rms(const short *pcm, unsigned int frames, unsigned int channels)
+{
+	double sum = 0;
+	unsigned int i;
+
+	for (i = 0; i < frames; i++)
+		sum += (double)pcm[i * channels] * pcm[i * channels];
+	return sqrt(sum / frames);
+}
+
+static double sim_db(double a, double b)
+{
+	return 20 * log10(a / b);
+}
+
+/*
+ * Music 1 kHz alone, then a silent tone over it for ~1 s, then a -6 dB step of
+ * the music gain for 30 periods. The duck must reach its level in
+ * SOUND_MIXER_DUCK_ATTACK periods and come back in about
+ * SOUND_MIXER_DUCK_RELEASE, and no step between two samples may be larger
+ * than the steepest of the steady sine.
+ */
+static void sim_test_duck(void)
+{
+	static short out[400 * SOUND_MIXER_PERIOD * 2];
+	static short zero[SIM_FRAME_MAX];
+	const unsigned int period = SOUND_MIXER_PERIOD * 2;
+	SoundMixer *mixer = sim_mixer();
+	SoundMixerInput *music = sound_mixer_input_create(mixer, 0);
+	SoundMixerInput *tone = sound_mixer_input_create(mixer, SOUND_MIXER_DUCK_OTHERS);
+	struct sim_src src = { 1000, 8000, 0, 44100, 2, 0 };
+	double ref, ducked, slope;
+	int p, i, d, attack = 0, release = 0, step = 0;
+
+	sound_mixer_input_open(music, 44100, 2);
+	for (p = 0; p < 400; p++) {
+		if (p == 100)
+			sound_mixer_input_open(tone, 16000, 1);
+		if (p == 100 + 172)
+			tone->state = MIX_INPUT_CLOSING;
+		if (p >= 100 && tone->state == MIX_INPUT_OPEN)
+			sound_mixer_input_write(tone, zero, 2 * 93 + 2);
+		if (p == 200)
+			sound_mixer_input_set_gain(music, -6);
+		if (p == 230)
+			sound_mixer_input_set_gain(music, 0);
+		sim_top_up(music, &src);
+		sound_mixer_mix(mixer, out + p * period, SOUND_MIXER_PERIOD);
+	}
+
+	ref = sim_rms(out + 50 * period, 40 * SOUND_MIXER_PERIOD, 2);
+	ducked = sim_rms(out + 150 * period, 40 * SOUND_MIXER_PERIOD, 2);
+	for (p = 100; p < 200; p++) {
+		if (sim_db(sim_rms(out + p * period, SOUND_MIXER_PERIOD, 2), ref) > -11.5)
+			attack = p - 100 + 1;
+	}
+	for (p = 272; p < 400; p++) {
+		if (sim_db(sim_rms(out + p * period, SOUND_MIXER_PERIOD, 2), ref) < -0.5)
+			release = p - 272 + 1;
+	}
+	for (i = 2; i < 400 * period; i += 2) {
+		d = abs(out[i] - out[i - 2]);
+		if (d > step)
+			step = d;
+	}
+	slope = src.amp * 2 * M_PI * src.freq / src.rate;
+
+	printf("duck %.2f dB, attack %d periods (%.1f ms), release to -0.5 dB %d periods (%.0f ms)\n",
+	       sim_db(ducked, ref), attack, attack * SOUND_MIXER_PERIOD / 44.1,
+	       release, release * SOUND_MIXER_PERIOD / 44.1);
+	printf("largest step between samples %d, steady sine %.0f\n", step, slope);
+
+	if (fabs(sim_db(ducked, ref) - SOUND_MIXER_DUCK_DEFAULT) > 0.1)
+		SIM_FAIL("ducked by %.2f dB", sim_db(ducked, ref));
+	if (attack > SOUND_MIXER_DUCK_ATTACK)
+		SIM_FAIL("attack %d periods", attack);
+	if (release < SOUND_MIXER_DUCK_RELEASE / 2 || release > SOUND_MIXER_DUCK_RELEASE)
+		SIM_FAIL("release %d periods", release);
+	if (step > slope + 2)
+		SIM_FAIL("step %d between samples", step);
+	if (tone->state != MIX_INPUT_IDLE)
+		SIM_FAIL("tone not played out");
+	sim_mixer_free(mixer);
+}
+
+/* two full scale squares in phase must pin at full scale, not wrap */
+static void sim_test_saturation(void)
+{
+	SoundMixer *mixer = sim_mixer();
+	SoundMixerInput *a = sound_mixer_input_create(mixer, 0);
+	SoundMixerInput *b = sound_mixer_input_create(mixer, 0);
+	struct sim_src src_a = { 100, 32767, 0, 48000, 2, 1 };
+	struct sim_src src_b = { 100, 32767, 0, 48000, 2, 1 };
+	int p, i, pinned = 0, other = 0;
+
+	sound_mixer_input_open(a, 48000, 2);
+	sound_mixer_input_open(b, 48000, 2);
+	for (p = 0; p < 40; p++) {
+		sim_top_up(a, &src_a);
+		sim_top_up(b, &src_b);
+		sound_mixer_mix(mixer, mixer->out, SOUND_MIXER_PERIOD);
+		if (p < 3)		/* gains still ramping up */
+			continue;
+		for (i = 0; i < SOUND_MIXER_PERIOD * 2; i++) {
+			if (mixer->out[i] == 32767 || mixer->out[i] == -32768)
+				pinned++;
+			else
+				other++;
+		}
+	}
+	printf("saturation: %d samples pinned at full scale, %d not\n", pinned, other);
+	if (other)
+		SIM_FAIL("%d samples not at full scale", other);
+	sim_mixer_free(mixer);
+}
+
+/* the card follows the first input: music as is, a tone at the card rate */
+static void sim_test_format(void)
+{
+	SoundMixer *mixer = sim_mixer();
+	SoundMixerInput *music = sound_mixer_input_create(mixer, 0);
+	SoundMixerInput *tone = sound_mixer_input_create(mixer, SOUND_MIXER_DUCK_OTHERS);
+
+	sound_mixer_input_open(tone, 16000, 1);
+	sound_mixer_input_open(music, 44100, 2);
+	printf("tone first: card %u Hz %u ch, music converted %s\n",
+	       mixer->config.rate, mixer->config.channels, music->rs ? "yes" : "no");
+	if (mixer->config.rate != SOUND_MIXER_CARD_RATE || mixer->config.channels != 2 ||
+	    music->rs == NULL || tone->rs == NULL)
+		SIM_FAIL("tone first");
+	sim_mixer_free(mixer);
+
+	mixer = sim_mixer();
+	music = sound_mixer_input_create(mixer, 0);
+	tone = sound_mixer_input_create(mixer, SOUND_MIXER_DUCK_OTHERS);
+	sound_mixer_input_open(music, 44100, 2);
+	sound_mixer_input_open(tone, 16000, 1);
+	printf("music first: card %u Hz %u ch, tone converted %s\n",
+	       mixer->config.rate, mixer->config.channels, tone->rs ? "yes" : "no");
+	if (mixer->config.rate != 44100 || mixer->config.channels != 2 ||
+	    music->rs != NULL || tone->rs == NULL)
+		SIM_FAIL("music first");
+	sim_mixer_free(mixer);
+}
+
+static SoundMixerInput *sim_tone_input;
+
+/* 1 s into the music, 1 s of a 16 kHz mono tone */
+static void *sim_tone_task(void *arg)
+{
+	static short pcm[512];
+	struct sim_src src = { 500, 4000, 0, 16000, 1, 1 };
+	int i;
+
+	usleep(1000000 / 8);
+	sound_mixer_input_open(sim_tone_input, 16000, 1);
+	for (i = 0; i < 16000 / 512; i++) {
+		sim_gen(&src, pcm, 512);
+		sound_mixer_input_write(sim_tone_input, pcm, sizeof(pcm));
+	}
+	sound_mixer_input_close(sim_tone_input);
+	return NULL;
+}
+
+/* 3 s of music through the mixer thread, a tone over it from another thread */
+static void sim_test_threads(void)
+{
+	static short pcm[4096];
+	struct sim_src src = { 1000, 8000, 0, 44100, 2, 0 };
+	const unsigned int frames = 44100 * 3;
+	SoundMixer *mixer;
+	SoundMixerInput *music;
+	unsigned int written = 0;
+	pthread_t thread;
+	double start;
+
+	card_cap_max = 44100 * 4;
+	card_cap = malloc(card_cap_max * 2 * sizeof(short));
+	card_frames = card_writes = card_bad_writes = card_opens = 0;
+	card_pace_us = SOUND_MIXER_PERIOD * 1000000 / 44100 / 8;
+
+	mixer = sound_mixer_ref();
+	music = sound_mixer_input_create(mixer, 0);
+	sim_tone_input = sound_mixer_input_create(mixer, SOUND_MIXER_DUCK_OTHERS);
+	sound_mixer_input_open(music, 44100, 2);
+
+	start = sim_now();
+	pthread_create(&thread, NULL, sim_tone_task, NULL);
+	while (written < frames) {
+		sim_gen(&src, pcm, 2048);
+		sound_mixer_input_write(music, pcm, sizeof(pcm));
+		written += 2048;
+	}
+	pthread_join(thread, NULL);
+	sound_mixer_input_close(music);
+	printf("threads: %u frames in, %u out in %u writes (%u not a period), "
+	       "%.2f s for %.2f s of audio at 8x\n", written, card_frames, card_writes,
+	       card_bad_writes, sim_now() - start, card_frames / 44100.0 / 8);
+
+	if (card_bad_writes)
+		SIM_FAIL("%u writes not a period", card_bad_writes);
+	if (card_frames < written)
+		SIM_FAIL("%u frames of music in, %u out", written, card_frames);
+	if (card_opens != 1)
+		SIM_FAIL("card opened %u times", card_opens);
+
+	sound_mixer_input_destroy(sim_tone_input);
+	sound_mixer_input_destroy(music);
+	sound_mixer_unref(mixer);
+	free(card_cap);
+	card_cap = NULL;
+	card_pace_us = 0;
+}
+
+static int sim_test(void)
+{
+	sim_test_duck();
+	sim_test_saturation();
+	sim_test_format();
+	sim_test_threads();
+	printf("ok\n");
+	return 0;
+}
+
+static int sim_bench(void)
+{
+	static const struct {
+		const char *name;
+		int inputs;
+		struct sim_src src[SOUND_MIXER_INPUTS_MAX];
+	} bench[] = {
+		{ "music 44.1k stereo alone", 1, {
+			{ 1000, 8000, 0, 44100, 2, 0 } } },
+		{ "+ tone 16k mono, converted, ducking", 2, {
+			{ 1000, 8000, 0, 44100, 2, 0 }, { 500, 4000, 0, 16000, 1, 0 } } },
+		{ "4 inputs, 44.1k/16k/8k/48k", 4, {
+			{ 1000, 8000, 0, 44100, 2, 0 }, { 500, 4000, 0, 16000, 1, 0 },
+			{ 300, 4000, 0, 8000, 1, 0 }, { 700, 4000, 0, 48000, 2, 0 } } },
+	};
+	const unsigned int periods = 20000;
+	struct sim_src src[SOUND_MIXER_INPUTS_MAX];
+	SoundMixerInput *input[SOUND_MIXER_INPUTS_MAX];
+	SoundMixer *mixer;
+	unsigned int k, p;
+	int i;
+	double t, start;
+
+	printf("%-38s %s\n", "", "ns per output frame");
+	for (k = 0; k < sizeof(bench) / sizeof(bench[0]); k++) {
+		mixer = sim_mixer();
+		for (i = 0; i < bench[k].inputs; i++) {
+			src[i] = bench[k].src[i];
+			input[i] = sound_mixer_input_create(mixer, i == 1 ? SOUND_MIXER_DUCK_OTHERS : 0);
+			sound_mixer_input_open(input[i], src[i].rate, src[i].channels);
+		}
+		t = 0;
+		for (p = 0; p < periods; p++) {
+			for (i = 0; i < bench[k].inputs; i++)
+				sim_top_up(input[i], &src[i]);
+			start = sim_now();
+			sound_mixer_mix(mixer, mixer->out, SOUND_MIXER_PERIOD);
+			t += sim_now() - start;
+		}
+		printf("%-38s %8.1f\n", bench[k].name, t * 1e9 / ((double)periods * SOUND_MIXER_PERIOD));
+		sim_mixer_free(mixer);
+	}
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc >= 2 && !strcmp(argv[1], "test"))
+		return sim_test();
+	if (argc >= 2 && !strcmp(argv[1], "bench"))
+		return sim_bench();
+	printf("usage: %s test | bench\n", argv[0]);
+	return 1;
+}
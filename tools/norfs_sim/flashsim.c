@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "image/flash.h"
+#include "flashsim.h"
+
+uint8_t flashsim_mem[FLASHSIM_SIZE];
+struct flashsim_stat flashsim_stat;
+
+static uint64_t s_rand;
+static long s_op;
+static long s_cut_op = -1;
+static int s_cut;
+
+uint32_t flashsim_rand(void)
+{
+	s_rand ^= s_rand << 13;
+	s_rand ^= s_rand >> 7;
+	s_rand ^= s_rand << 17;
+	return (uint32_t)s_rand;
+}
+
+void flashsim_init(uint32_t seed)
+{
+	s_rand = 0x9E3779B97F4A7C15ULL ^ seed;
+	memset(flashsim_mem, 0xFF, sizeof(flashsim_mem));
+	memset(&flashsim_stat, 0, sizeof(flashsim_stat));
+	flashsim_power_on();
+}
+
+void flashsim_cut_at(long op)
+{
+	s_op = 0;
+	s_cut_op = op;
+}
+
+int flashsim_is_cut(void)
+{
+	return s_cut;
+}
+
+void flashsim_power_on(void)
+{
+	s_cut = 0;
+	s_cut_op = -1;
+}
+
+/* 0 to go on, 1 if the power is off, 2 if it goes off during this operation */
+static int flashsim_power(void)
+{
+	if (s_cut)
+		return 1;
+	if (s_cut_op >= 0 && s_op++ == s_cut_op) {
+		s_cut = 1;
+		return 2;
+	}
+	return 0;
+}
+
+static void flashsim_prog(uint32_t addr, const uint8_t *buf, uint32_t size)
+{
+	uint32_t i;
+
+	for (i = 0; i < size; ++i) {
+		if ((flashsim_mem[addr + i] & buf[i]) != buf[i]) {
+			if (flashsim_stat.prog_err++ == 0)
+				printf("flashsim: program of a bit set at %#x\n", addr + i);
+		}
+		flashsim_mem[addr + i] &= buf[i];
+	}
+}
+
+uint32_t flash_rw(uint32_t flash, uint32_t addr, void *buf, uint32_t size, int do_write)
+{
+	uint32_t n, end;
+
+	if (addr >= FLASHSIM_SIZE || size > FLASHSIM_SIZE - addr)
+		return 0;
+
+	if (!do_write) {
+		memcpy(buf, flashsim_mem + addr, size);
+		flashsim_stat.read_cnt++;
+		flashsim_stat.read_bytes += size;
+		flashsim_stat.time_us += 1.0 + size * 0.05;
+		return size;
+	}
+
+	switch (flashsim_power()) {
+	case 1:
+		return 0;
+	case 2:
+		/* part of the data, and some bits of the next byte */
+		n = flashsim_rand() % (size + 1);
+		flashsim_prog(addr, buf, n);
+		if (n < size)
+			flashsim_mem[addr + n] &= ((uint8_t *)buf)[n] | (uint8_t)flashsim_rand();
+		return 0;
+	default:
+		break;
+	}
+
+	flashsim_prog(addr, buf, size);
+	flashsim_stat.prog_cnt++;
+	flashsim_stat.prog_bytes += size;
+	for (end = addr + size; addr < end; addr = n) {
+		n = (addr / 256 + 1) * 256;		/* page by page */
+		if (n > end)
+			n = end;
+		flashsim_stat.time_us += 30.0 + (n - addr) * 2.6;
+	}
+	return size;
+}
+
+int32_t flash_get_erase_block(uint32_t flash, uint32_t addr, uint32_t size)
+{
+	return FLASHSIM_SECTOR;
+}
+
+int flash_erase(uint32_t flash, uint32_t addr, uint32_t size)
+{
+	uint32_t n, i;
+
+	if ((addr | size) & (FLASHSIM_SECTOR - 1) ||
+	    addr >= FLASHSIM_SIZE || size > FLASHSIM_SIZE - addr)
+		return -1;
+
+	for (; size; addr += FLASHSIM_SECTOR, size -= FLASHSIM_SECTOR) {
+		switch (flashsim_power()) {
+		case 1:
+			return -1;
+		case 2:
+			/* erased in part, some bits of the rest set */
+			n = flashsim_rand() % (FLASHSIM_SECTOR + 1);
+			memset(flashsim_mem + addr, 0xFF, n);
+			for (i = 0; i < 64; ++i)
+				flashsim_mem[addr + flashsim_rand() % FLASHSIM_SECTOR] |= (uint8_t)flashsim_rand();
+			return -1;
+		default:
+			break;
+		}
+		memset(flashsim_mem + addr, 0xFF, FLASHSIM_SECTOR);
+		flashsim_stat.erase_cnt++;
+		flashsim_stat.time_us += 45000.0;
+	}
+	return 0;
+}
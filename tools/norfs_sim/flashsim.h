@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _NORFS_SIM_FLASHSIM_H_
+#define _NORFS_SIM_FLASHSIM_H_
+
+#include <stdint.h>
+
+/*
+ * SPI NOR flash in RAM, behind flash_read()/flash_write()/flash_erase() of
+ * image/flash.h. Programming only clears bits, setting one is counted as an
+ * error. A power cut can be set at the n-th program or erase: that operation
+ * is left half done (some bytes written, the next one partly, or a sector
+ * partly erased) and every later program and erase fails, until
+ * flashsim_power_on().
+ *
+ * Time is counted with typical figures of a 4-line SPI NOR: 0.7 ms to program
+ * a 256 bytes page, 45 ms to erase a 4K sector and 20 MB/s to read.
+ */
+
+#define FLASHSIM_SIZE		(1024 * 1024)
+#define FLASHSIM_SECTOR		(4 * 1024)
+
+struct flashsim_stat {
+	uint32_t	read_cnt;
+	uint32_t	prog_cnt;
+	uint32_t	erase_cnt;
+	uint32_t	prog_err;	/* programs that needed a bit set */
+	uint64_t	read_bytes;
+	uint64_t	prog_bytes;
+	double		time_us;
+};
+
+extern uint8_t flashsim_mem[FLASHSIM_SIZE];
+extern struct flashsim_stat flashsim_stat;
+
+void flashsim_init(uint32_t seed);
+void flashsim_cut_at(long op);	/* -1 for no power cut */
+int flashsim_is_cut(void);
+void flashsim_power_on(void);
+uint32_t flashsim_rand(void);
+
+#endif /* _NORFS_SIM_FLASHSIM_H_ */
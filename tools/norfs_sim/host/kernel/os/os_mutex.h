@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Single task on the host, the norfs lock does nothing. */
+
+#ifndef _KERNEL_OS_OS_MUTEX_H_
+#define _KERNEL_OS_OS_MUTEX_H_
+
+#include <stdint.h>
+
+typedef enum {
+	OS_OK = 0,
+	OS_FAIL = -1,
+} OS_Status;
+
+#define OS_WAIT_FOREVER		0xffffffffU
+
+typedef struct OS_Mutex {
+	int valid;
+} OS_Mutex_t;
+
+static inline OS_Status OS_MutexCreate(OS_Mutex_t *mutex)
+{
+	mutex->valid = 1;
+	return OS_OK;
+}
+
+static inline OS_Status OS_MutexDelete(OS_Mutex_t *mutex)
+{
+	mutex->valid = 0;
+	return OS_OK;
+}
+
+static inline OS_Status OS_MutexLock(OS_Mutex_t *mutex, uint32_t waitMS)
+{
+	return OS_OK;
+}
+
+static inline OS_Status OS_MutexUnlock(OS_Mutex_t *mutex)
+{
+	return OS_OK;
+}
+
+static inline int OS_MutexIsValid(OS_Mutex_t *mutex)
+{
+	return mutex->valid;
+}
+
+#endif /* _KERNEL_OS_OS_MUTEX_H_ */
@@ -0,0 +1,532 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Power-loss test and small-file benchmark of fs/norfs on the flash
+ * simulator. norfs.c is built in, so its state is checked between the
+ * operations as well.
+ *
+ * usage: norfs_sim test [blocks [cycles [seed]]]
+ *        norfs_sim bench
+ *
+ * The test runs random operations on a set of files, cuts the power at a
+ * random program or erase, mounts again (sometimes cutting the power while
+ * mounting too) and checks every file against a model: files not being
+ * changed are intact, the one being changed is either the old or the new
+ * version (a write in place may leave some chunks of each). Any failure other
+ * than after a power cut ends the test, NORFS_ERR_NOSPC included as the data
+ * is kept below 40% of the area.
+ */
+
+#include <time.h>
+
+#include "norfs.c"
+#include "flashsim.h"
+
+#define SIM_FILES		16
+#define SIM_DATA_MAX	(6 * 1024)
+#define SIM_PIECE_MAX	(1500)
+
+enum {
+	SIM_OP_WRITE,		/* write a new version, truncating the file */
+	SIM_OP_REPLACE,		/* write a new version to "tmp", rename it over */
+	SIM_OP_APPEND,
+	SIM_OP_PATCH,		/* write in place */
+	SIM_OP_TRUNCATE,
+	SIM_OP_REMOVE,
+	SIM_OP_FILL,		/* fill the area up, then remove the filler */
+	SIM_OP_NUM,
+};
+
+struct sim_file {
+	int			exist;
+	uint32_t	len;
+	uint8_t		data[SIM_DATA_MAX];
+};
+
+static struct sim_file sim_file[SIM_FILES];
+static struct sim_file sim_new;		/* version written by the current operation */
+static uint8_t sim_buf[SIM_DATA_MAX + 1];
+static uint32_t sim_limit;			/* bytes of data kept at most */
+
+#define SIM_FAIL(fmt, arg...)									\
+	do {														\
+		printf("FAIL %s():%d, " fmt "\n", __func__, __LINE__, ##arg);	\
+		exit(1);												\
+	} while (0)
+
+static void sim_name(char *name, int idx)
+{
+	sprintf(name, "dir/file%02d", idx);
+}
+
+static uint32_t sim_rand(uint32_t n)
+{
+	return n ? flashsim_rand() % n : 0;
+}
+
+/* read a whole file to sim_buf, return its length or NORFS_ERR_* */
+static int sim_load(norfs_t *fs, const char *name)
+{
+	norfs_file_t *file;
+	uint32_t len = 0;
+	int ret;
+
+	ret = norfs_open(fs, &file, name, NORFS_O_READ);
+	if (ret != 0)
+		return ret;
+	while ((ret = norfs_read(file, sim_buf + len, 1 + sim_rand(SIM_PIECE_MAX))) > 0) {
+		len += ret;
+		if (len > SIM_DATA_MAX)
+			SIM_FAIL("%s is too long", name);
+	}
+	if (ret == 0 && len != norfs_size(file))
+		SIM_FAIL("%s: read %u of %u", name, len, norfs_size(file));
+	norfs_close(file);
+	return ret < 0 ? ret : (int)len;
+}
+
+static int sim_write(norfs_file_t *file, const uint8_t *data, uint32_t len)
+{
+	uint32_t n;
+	int ret;
+
+	while (len) {
+		n = 1 + sim_rand(SIM_PIECE_MAX);
+		if (n > len)
+			n = len;
+		ret = norfs_write(file, data, n);
+		if (ret != (int)n)
+			return ret < 0 ? ret : NORFS_ERR_NOSPC;
+		data += n;
+		len -= n;
+	}
+	return 0;
+}
+
+static int sim_write_file(norfs_t *fs, const char *name, const uint8_t *data, uint32_t len)
+{
+	norfs_file_t *file;
+	int ret, err;
+
+	ret = norfs_open(fs, &file, name, NORFS_O_WRITE | NORFS_O_CREAT | NORFS_O_TRUNC);
+	if (ret != 0)
+		return ret;
+	ret = sim_write(file, data, len);
+	err = norfs_close(file);
+	return ret ? ret : err;
+}
+
+static uint32_t sim_total(void)
+{
+	uint32_t i, total = 0;
+
+	for (i = 0; i < SIM_FILES; ++i) {
+		if (sim_file[i].exist)
+			total += sim_file[i].len;
+	}
+	return total;
+}
+
+/* live bytes, tombstones and the reserve */
+static void sim_check_state(norfs_t *fs, int mounted)
+{
+	struct norfs_node *node;
+	uint32_t *live, i, j, oldest = 0xFFFFFFFF, free_cnt = 0;
+
+	live = calloc(fs->blk_cnt, sizeof(*live));
+	for (i = 0; i < fs->node_cnt; ++i) {
+		node = fs->node[i];
+		live[NORFS_LOC_BLK(node->inode)] += NORFS_REC_SIZE(NORFS_LOC_LEN(node->inode));
+		for (j = 0; j < node->chunk_max; ++j) {
+			if (node->chunk[j])
+				live[NORFS_LOC_BLK(node->chunk[j])] += NORFS_REC_SIZE(NORFS_LOC_LEN(node->chunk[j]));
+		}
+	}
+	for (i = 0; i < fs->blk_cnt; ++i) {
+		if (fs->blk[i].state != NORFS_BLK_USED)
+			free_cnt++;
+		else if (fs->blk[i].seq < oldest)
+			oldest = fs->blk[i].seq;
+		if (fs->blk[i].state == NORFS_BLK_USED && fs->blk[i].live != live[i])
+			SIM_FAIL("block %u live %u, counted %u", i, fs->blk[i].live, live[i]);
+		if (fs->blk[i].state != NORFS_BLK_USED && live[i])
+			SIM_FAIL("block %u not in use holds %u live bytes", i, live[i]);
+	}
+	free(live);
+	if (fs->free_cnt != free_cnt)
+		SIM_FAIL("%u free blocks, counted %u", fs->free_cnt, free_cnt);
+
+	/* no tombstone outlives the blocks that may hold the file deleted */
+	if (fs->tomb_cnt > 2 * NORFS_TOMB_MAX)
+		SIM_FAIL("%u tombstones", fs->tomb_cnt);
+	for (i = 0; i < fs->tomb_cnt; ++i) {
+		if (fs->tomb[i].seq <= oldest)
+			SIM_FAIL("tombstone of %u kept, seq %u", fs->tomb[i].id, fs->tomb[i].seq);
+		if (fs->tomb[i].blk >= fs->blk_cnt ||
+		    fs->blk[fs->tomb[i].blk].state != NORFS_BLK_USED)
+			SIM_FAIL("tombstone of %u in block %u", fs->tomb[i].id, fs->tomb[i].blk);
+	}
+	if (mounted && fs->free_cnt < NORFS_GC_RESERVE)
+		SIM_FAIL("%u free blocks after mount", fs->free_cnt);
+	if (flashsim_stat.prog_err)
+		SIM_FAIL("%u programs of erased bits", flashsim_stat.prog_err);
+}
+
+static void sim_check_files(norfs_t *fs)
+{
+	char name[NORFS_NAME_MAX + 1];
+	uint32_t i, index = 0, cnt = 0;
+	int len;
+
+	for (i = 0; i < SIM_FILES; ++i) {
+		sim_name(name, i);
+		len = sim_load(fs, name);
+		if (!sim_file[i].exist) {
+			if (len != NORFS_ERR_NOENT)
+				SIM_FAIL("%s exists, %d", name, len);
+			continue;
+		}
+		cnt++;
+		if (len != (int)sim_file[i].len || memcmp(sim_buf, sim_file[i].data, len))
+			SIM_FAIL("%s differs, %d bytes of %u", name, len, sim_file[i].len);
+	}
+	while (norfs_readdir(fs, &index, name, NULL) == 0)
+		cnt--;
+	if (cnt)
+		SIM_FAIL("%d files too many listed", -(int)cnt);
+}
+
+/* run an operation on file idx, the new version of it is left in sim_new */
+static int sim_op(norfs_t *fs, int op, int idx)
+{
+	struct sim_file *f = &sim_file[idx];
+	norfs_file_t *file;
+	char name[NORFS_NAME_MAX + 1];
+	uint32_t i, pos, len, max;
+	int ret, err;
+
+	sim_name(name, idx);
+	sim_new = *f;
+	max = sim_limit / 4 < SIM_DATA_MAX ? sim_limit / 4 : SIM_DATA_MAX;
+
+	switch (op) {
+	case SIM_OP_WRITE:
+	case SIM_OP_REPLACE:
+		sim_new.exist = 1;
+		sim_new.len = sim_rand(max + 1);
+		for (i = 0; i < sim_new.len; ++i)
+			sim_new.data[i] = flashsim_rand();
+		if (op == SIM_OP_WRITE)
+			return sim_write_file(fs, name, sim_new.data, sim_new.len);
+		ret = sim_write_file(fs, "tmp", sim_new.data, sim_new.len);
+		return ret ? ret : norfs_rename(fs, "tmp", name);
+	case SIM_OP_APPEND:
+	case SIM_OP_PATCH:
+		pos = op == SIM_OP_APPEND ? f->len : sim_rand(f->len + 1);
+		len = sim_rand(max / 2 + 1);
+		if (pos + len > SIM_DATA_MAX)
+			len = SIM_DATA_MAX - pos;
+		for (i = 0; i < len; ++i)
+			sim_new.data[pos + i] = flashsim_rand();
+		if (pos + len > sim_new.len)
+			sim_new.len = pos + len;
+		ret = norfs_open(fs, &file, name, NORFS_O_RDWR |
+		                 (op == SIM_OP_APPEND ? NORFS_O_APPEND : 0));
+		if (ret != 0)
+			return ret;
+		norfs_seek(file, pos);
+		ret = sim_write(file, sim_new.data + pos, len);
+		err = norfs_close(file);
+		return ret ? ret : err;
+	case SIM_OP_TRUNCATE:
+		sim_new.len = sim_rand(f->len + 1);
+		ret = norfs_open(fs, &file, name, NORFS_O_WRITE);
+		if (ret != 0)
+			return ret;
+		norfs_seek(file, sim_new.len);
+		ret = norfs_truncate(file);
+		err = norfs_close(file);
+		return ret ? ret : err;
+	case SIM_OP_REMOVE:
+		sim_new.exist = 0;
+		return norfs_remove(fs, name);
+	case SIM_OP_FILL:
+		ret = norfs_open(fs, &file, "fill", NORFS_O_WRITE | NORFS_O_CREAT | NORFS_O_TRUNC);
+		if (ret != 0)
+			return ret;
+		while ((ret = sim_write(file, sim_file[idx].data, SIM_DATA_MAX)) == 0)
+			;
+		err = norfs_close(file);
+		if (ret != NORFS_ERR_NOSPC || (err != 0 && err != NORFS_ERR_NOSPC))
+			return ret ? ret : err;
+		/* a full file system can still delete */
+		return norfs_remove(fs, "fill");
+	default:
+		return NORFS_ERR_INVAL;
+	}
+}
+
+/* after a power cut in an operation, take what is left of the file */
+static void sim_accept(norfs_t *fs, int op, int idx)
+{
+	struct sim_file *f = &sim_file[idx];
+	char name[NORFS_NAME_MAX + 1];
+	uint32_t i;
+	int len, ok;
+
+	sim_name(name, idx);
+	len = sim_load(fs, name);
+	if (len == NORFS_ERR_NOENT) {
+		ok = !f->exist || !sim_new.exist;
+		if (!ok)
+			SIM_FAIL("%s lost by op %d", name, op);
+		f->exist = 0;
+		return;
+	}
+	if (len < 0)
+		SIM_FAIL("%s: %d", name, len);
+
+	ok = (f->exist && len == (int)f->len && memcmp(sim_buf, f->data, len) == 0) ||
+	     (sim_new.exist && len == (int)sim_new.len && memcmp(sim_buf, sim_new.data, len) == 0);
+	if (!ok && op == SIM_OP_WRITE) {
+		/* truncated, then part of the new version written */
+		ok = len <= (int)sim_new.len && memcmp(sim_buf, sim_new.data, len) == 0;
+	} else if (!ok && (op == SIM_OP_APPEND || op == SIM_OP_PATCH)) {
+		ok = len >= (int)f->len && len <= (int)sim_new.len;
+		for (i = 0; ok && i < (uint32_t)len; ++i)
+			ok = sim_buf[i] == sim_new.data[i] || (i < f->len && sim_buf[i] == f->data[i]);
+	}
+	if (!ok)
+		SIM_FAIL("%s after op %d: %d bytes, was %u, to be %u", name, op, len, f->len, sim_new.len);
+
+	f->exist = 1;
+	f->len = len;
+	memcpy(f->data, sim_buf, len);
+}
+
+static norfs_t *sim_mount(uint32_t size)
+{
+	norfs_t *fs;
+
+	/* sometimes the power goes off again while recovering */
+	if (sim_rand(4) == 0) {
+		flashsim_cut_at(sim_rand(8));
+		fs = norfs_mount(0, 0, size);
+		if (fs)
+			norfs_unmount(fs);
+		flashsim_power_on();
+	}
+	fs = norfs_mount(0, 0, size);
+	if (fs == NULL)
+		SIM_FAIL("mount");
+	sim_check_state(fs, 1);
+	return fs;
+}
+
+static int sim_test(uint32_t blk_cnt, uint32_t cycles, uint32_t seed)
+{
+	uint32_t size = blk_cnt * NORFS_BLOCK_SIZE;
+	uint32_t cyc, cuts = 0, ops = 0;
+	struct norfs_info info;
+	norfs_t *fs;
+	int op, idx, ret;
+
+	if (blk_cnt < 4 || size > FLASHSIM_SIZE)
+		SIM_FAIL("%u blocks", blk_cnt);
+	flashsim_init(seed);
+	memset(sim_file, 0, sizeof(sim_file));
+	sim_limit = (blk_cnt - 2) * NORFS_BLK_CAP * 2 / 5;
+	fs = sim_mount(size);
+
+	for (cyc = 0; cyc < cycles; ++cyc) {
+		flashsim_cut_at(sim_rand(400));
+		for (;;) {
+			op = sim_rand(SIM_OP_NUM * 8);
+			op = op < SIM_OP_NUM * 8 - 1 ? op % SIM_OP_FILL : SIM_OP_FILL;
+			idx = sim_rand(SIM_FILES);
+			if (sim_total() > sim_limit && op != SIM_OP_TRUNCATE && op != SIM_OP_FILL)
+				op = SIM_OP_REMOVE;
+			if (op != SIM_OP_WRITE && op != SIM_OP_REPLACE && !sim_file[idx].exist)
+				continue;
+			ret = sim_op(fs, op, idx);
+			if (flashsim_is_cut())
+				break;
+			if (ret != 0)
+				SIM_FAIL("op %d on file %d: %d, %u bytes in use", op, idx, ret, sim_total());
+			sim_check_state(fs, 0);
+			if (op != SIM_OP_FILL)
+				sim_file[idx] = sim_new;
+			ops++;
+		}
+		cuts++;
+
+		if (norfs_unmount(fs) != 0)
+			SIM_FAIL("unmount");
+		flashsim_power_on();
+		fs = sim_mount(size);
+		if (op != SIM_OP_FILL)
+			sim_accept(fs, op, idx);
+		norfs_remove(fs, "tmp");
+		norfs_remove(fs, "fill");
+		sim_check_files(fs);
+		sim_check_state(fs, 0);
+	}
+
+	norfs_info(fs, &info);
+	printf("%u blocks: %u cycles, %u power cuts, %u operations, %u reclaims since mount, "
+	       "erase %u..%u, %u tombstones: OK\n", blk_cnt, cycles, cuts, ops,
+	       info.gc_cnt, info.erase_min, info.erase_max, fs->tomb_cnt);
+	norfs_unmount(fs);
+	return 0;
+}
+
+/*
+ * Benchmark
+ */
+
+static norfs_t *bench_fs;
+static uint8_t bench_buf[1024];
+
+static void bench_write(const char *name, uint32_t len)
+{
+	if (sim_write_file(bench_fs, name, bench_buf, len) != 0)
+		SIM_FAIL("write %s", name);
+}
+
+static void bench_read(const char *name)
+{
+	norfs_file_t *file;
+
+	if (norfs_open(bench_fs, &file, name, NORFS_O_READ) != 0)
+		SIM_FAIL("open %s", name);
+	norfs_read(file, bench_buf, sizeof(bench_buf));
+	norfs_close(file);
+}
+
+static double bench_now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/*
+ * The time of an operation is the flash time of the simulator plus the host
+ * time of the code, the only part left for operations served from RAM (stat).
+ */
+#define BENCH(title, cnt, bytes, body)										\
+	do {																	\
+		struct flashsim_stat s0 = flashsim_stat;							\
+		double t, th;														\
+		uint32_t i;															\
+		th = bench_now_us();												\
+		for (i = 0; i < (cnt); ++i) {										\
+			body;															\
+		}																	\
+		th = bench_now_us() - th;											\
+		t = flashsim_stat.time_us - s0.time_us;								\
+		printf("%-32s %8.0f ops/s %9.2f us/op (host %5.2f)  write amp %5.2f  %5.1f erases/kop\n", \
+		       title, (cnt) / ((t + th) / 1e6), (t + th) / (cnt), th / (cnt),	\
+		       (bytes) ? (double)(flashsim_stat.prog_bytes - s0.prog_bytes) / ((double)(bytes) * (cnt)) : 0, \
+		       (flashsim_stat.erase_cnt - s0.erase_cnt) * 1000.0 / (cnt));	\
+	} while (0)
+
+static int sim_bench(void)
+{
+	char name[NORFS_NAME_MAX + 1];
+	struct norfs_info info;
+	norfs_file_t *file;
+	double t;
+	uint32_t i;
+
+	flashsim_init(1);
+	for (i = 0; i < sizeof(bench_buf); ++i)
+		bench_buf[i] = flashsim_rand();
+	bench_fs = norfs_mount(0, 0, FLASHSIM_SIZE);
+	if (bench_fs == NULL)
+		SIM_FAIL("mount");
+
+	/* a quarter of the area holds data never changed */
+	for (i = 0; i < 40; ++i) {
+		sprintf(name, "static/%u", i);
+		bench_write(name, 6000);
+	}
+
+	BENCH("create 128B file", 2000, 128,
+	      (sprintf(name, "cfg/%u", i % 200), bench_write(name, 128)));
+	BENCH("update 256B file, tmp + rename", 2000, 256,
+	      (sprintf(name, "cfg/%u", sim_rand(200)), bench_write("tmp", 256),
+	       norfs_rename(bench_fs, "tmp", name)));
+	BENCH("read 256B file, 6 hot", 5000, 0,
+	      (sprintf(name, "cfg/%u", sim_rand(6)), bench_read(name)));
+	BENCH("read 256B file, 200 random", 5000, 0,
+	      (sprintf(name, "cfg/%u", sim_rand(200)), bench_read(name)));
+	BENCH("stat", 200000, 0,
+	      (sprintf(name, "cfg/%u", sim_rand(200)), norfs_stat(bench_fs, name, NULL)));
+	if (norfs_open(bench_fs, &file, "log", NORFS_O_WRITE | NORFS_O_CREAT | NORFS_O_APPEND) != 0)
+		SIM_FAIL("open log");
+	BENCH("append 64B + sync", 5000, 64,
+	      (norfs_write(file, bench_buf, 64), norfs_sync(file)));
+	norfs_close(file);
+	BENCH("remove + create 1K file", 2000, 1024,
+	      (sprintf(name, "cfg/%u", sim_rand(200)), norfs_remove(bench_fs, name),
+	       bench_write(name, 1024)));
+
+	for (i = 0; i < 100000; ++i) {
+		sprintf(name, "cfg/%u", sim_rand(200));
+		bench_write(name, 64 + sim_rand(400));
+	}
+	norfs_info(bench_fs, &info);
+	printf("after 100000 updates: erase %u..%u, %u files\n",
+	       info.erase_min, info.erase_max, info.file_cnt);
+
+	norfs_unmount(bench_fs);
+	t = flashsim_stat.time_us;
+	bench_fs = norfs_mount(0, 0, FLASHSIM_SIZE);
+	printf("mount %.1f ms\n", (flashsim_stat.time_us - t) / 1000);
+	norfs_unmount(bench_fs);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc >= 2 && strcmp(argv[1], "test") == 0) {
+		return sim_test(argc > 2 ? strtoul(argv[2], NULL, 0) : 64,
+		                argc > 3 ? strtoul(argv[3], NULL, 0) : 2000,
+		                argc > 4 ? strtoul(argv[4], NULL, 0) : 1);
+	}
+	if (argc >= 2 && strcmp(argv[1], "bench") == 0)
+		return sim_bench();
+
+	printf("usage: %s test [blocks [cycles [seed]]]\n"
+	       "       %s bench\n", argv[0], argv[0]);
+	return 2;
+}
@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+#
+# Decode the binary stdout of __CONFIG_LIBC_STDIO_DEFERRED (after
+# stdio_deferred_set_binary(1)) back to text.
+#
+# usage: stdio_decode.py <image.elf> [capture|-]
+#   e.g. stdio_decode.py out/xr_system.elf /dev/ttyUSB0
+#
+# Records are framed as 0xFE 'L' <header> <format> <arguments>, see
+# src/libc/wrap_stdio.c. The format is either inline or an address which is
+# looked up in the elf, so it must be the image running on the target.
+# Anything between frames (console echo etc.) is passed through.
+#
+
+import re
+import struct
+import sys
+
+REC_LOG = 0xA5
+REC_FMT_INLINE = 0x01
+REC_TRUNCATED = 0x02
+SYNC = b'\xfeL'
+
+# cortex-m sizes: (bytes, struct code)
+ARG_TYPES = {
+    'int': (4, 'i'), 'long': (4, 'i'), 'llong': (8, 'q'), 'size': (4, 'I'),
+    'ptrdiff': (4, 'i'), 'intmax': (8, 'q'), 'double': (8, 'd'),
+    'ldouble': (8, 'd'), 'ptr': (4, 'I'),
+}
+
+SPEC_RE = re.compile(r'%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d*))?(hh|h|ll|l|q|j|z|t|L)?(.|$)')
+
+
+class Elf(object):
+    def __init__(self, path):
+        self.sections = []
+        with open(path, 'rb') as f:
+            data = f.read()
+        if data[:4] != b'\x7fELF' or data[4] != 1:
+            raise ValueError('%s: not an elf32 file' % path)
+        shoff, = struct.unpack_from('<I', data, 0x20)
+        shentsize, shnum = struct.unpack_from('<HH', data, 0x2e)
+        for i in range(shnum):
+            (name, stype, flags, addr, offset, size) = \
+                struct.unpack_from('<IIIIII', data, shoff + i * shentsize)
+            if stype == 1 and flags & 0x2 and size:  # PROGBITS, ALLOC
+                self.sections.append((addr, size, data[offset:offset + size]))
+
+    def string(self, addr):
+        for base, size, body in self.sections:
+            if base <= addr < base + size:
+                end = body.find(b'\0', addr - base)
+                return body[addr - base:end].decode('latin-1')
+        return None
+
+
+def convert(flags, width, prec, mod, conv, size, value):
+    if conv == 'p':
+        return '0x%x' % value
+    if conv in 'aA':
+        return float(value).hex()
+    spec = '%' + flags + (width or '') + ('.' + prec if prec is not None else '')
+    if conv in 'diouxX':
+        bits = {'hh': 8, 'h': 16}.get(mod, size * 8)
+        value &= (1 << bits) - 1
+        if conv in 'di' and value >> (bits - 1):
+            value -= 1 << bits
+    if conv == 'u':
+        conv = 'd'
+    return (spec + conv) % value
+
+
+def replay(fmt, args, truncated):
+    out = []
+    pos = 0
+    for m in SPEC_RE.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, width, prec, mod, conv = m.groups()
+        if conv == '%' and not (flags or width or prec or mod):
+            out.append('%')
+            continue
+        try:
+            if width == '*':
+                width = str(struct.unpack_from('<i', args)[0])
+                args = args[4:]
+            if prec == '*':
+                prec = str(struct.unpack_from('<i', args)[0])
+                args = args[4:]
+            if conv == 'n':
+                continue
+            if conv == 's' and mod != 'l':
+                end = args.index(b'\0')
+                value = args[:end].decode('latin-1')
+                args = args[end + 1:]
+                spec = '%' + flags + (width or '') + ('.' + prec if prec is not None else '')
+                out.append((spec + 's') % value)
+                continue
+            if conv in 'diouxXc':
+                kind = {'l': 'long', 'll': 'llong', 'q': 'llong', 'j': 'intmax',
+                        'z': 'size', 't': 'ptrdiff'}.get(mod, 'int')
+            elif conv in 'eEfFgGaA':
+                kind = 'ldouble' if mod == 'L' else 'double'
+            elif conv in 'ps':
+                kind = 'ptr'
+            else:
+                out.append(m.group(0))
+                continue
+            size, code = ARG_TYPES[kind]
+            value, = struct.unpack_from('<' + code, args)
+            args = args[size:]
+            out.append(convert(flags, width, prec, mod, conv, size, value))
+        except (struct.error, ValueError):
+            return ''.join(out) + ('...' if truncated else '')
+    out.append(fmt[pos:])
+    return ''.join(out)
+
+
+def decode(elf, stream, write):
+    buf = b''
+    while True:
+        chunk = stream.read(1) if stream.isatty() else stream.read(4096)
+        if not chunk:
+            break
+        buf += chunk
+        while True:
+            i = buf.find(SYNC)
+            if i < 0:
+                keep = 1 if buf.endswith(SYNC[:1]) else 0
+                write(buf[:len(buf) - keep].decode('latin-1'))
+                buf = buf[len(buf) - keep:]
+                break
+            write(buf[:i].decode('latin-1'))
+            buf = buf[i:]
+            if len(buf) < 2 + 8:
+                break
+            hdr, = struct.unpack_from('<I', buf, 2)
+            size = hdr >> 16
+            if hdr & 0xff != REC_LOG or size < 8 or size & 3:
+                write(buf[:1].decode('latin-1'))
+                buf = buf[1:]
+                continue
+            if len(buf) < 2 + size:
+                break
+            rec = buf[2:2 + size]
+            buf = buf[2 + size:]
+            flags = (hdr >> 8) & 0xff
+            if flags & REC_FMT_INLINE:
+                end = rec.index(b'\0', 4)
+                fmt = rec[4:end].decode('latin-1')
+                args = rec[end + 1:]
+            else:
+                addr, = struct.unpack_from('<I', rec, 4)
+                fmt = elf.string(addr)
+                args = rec[8:]
+                if fmt is None:
+                    write('<unknown format 0x%08x>\n' % addr)
+                    continue
+            write(replay(fmt, args, flags & REC_TRUNCATED))
+    write(buf.decode('latin-1'))
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        sys.stderr.write('usage: %s <image.elf> [capture|-]\n' % sys.argv[0])
+        return 1
+    elf = Elf(sys.argv[1])
+    if len(sys.argv) == 2 or sys.argv[2] == '-':
+        stream = sys.stdin.buffer
+    else:
+        stream = open(sys.argv[2], 'rb')
+
+    def write(text):
+        sys.stdout.write(text)
+        sys.stdout.flush()
+
+    try:
+        decode(elf, stream, write)
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
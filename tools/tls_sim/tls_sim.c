@@ -0,0 +1,332 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * TLS loopback test of the variable length record buffers
+ * (MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH).
+ *
+ * usage: tls_sim [max_len]
+ *
+ * A client and a server are connected through memory pipes. For each cipher
+ * suite, with and without encrypt-then-MAC, the buffers are shrunk before
+ * every transfer and records of every length up to max_len are sent both
+ * ways, so that each record lands at every position relative to the end of
+ * the grown input buffer, with and without a 2 KB max_fragment_length. The library allocates from guard pages, with the
+ * end of each block against an inaccessible page: reading past a buffer
+ * (e.g. the CBC padding check looking past a record) stops the test.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "mbedtls/platform.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/certs.h"
+#include "mbedtls/x509_crt.h"
+#include "mbedtls/pk.h"
+
+/* Allocations end against a PROT_NONE page */
+typedef struct {
+	size_t map_len;
+	size_t size;
+} guard_hdr_t;
+
+static size_t page_size;
+
+static void *guard_calloc(size_t n, size_t size)
+{
+	size_t len, map_len;
+	unsigned char *map;
+	guard_hdr_t *hdr;
+
+	if (n != 0 && size > (size_t)-1 / n)
+		return NULL;
+	len = (n * size + 15) & ~(size_t)15;
+	map_len = (len + sizeof(guard_hdr_t) + page_size - 1) / page_size * page_size
+	          + page_size;
+	map = mmap(NULL, map_len, PROT_READ | PROT_WRITE,
+	           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (map == MAP_FAILED)
+		return NULL;
+	if (mprotect(map + map_len - page_size, page_size, PROT_NONE) != 0) {
+		munmap(map, map_len);
+		return NULL;
+	}
+	hdr = (guard_hdr_t *)(map + map_len - page_size - len) - 1;
+	hdr->map_len = map_len;
+	hdr->size = len;
+	return hdr + 1;
+}
+
+static void guard_free(void *p)
+{
+	guard_hdr_t *hdr;
+	unsigned char *map;
+
+	if (p == NULL)
+		return;
+	hdr = (guard_hdr_t *)p - 1;
+	map = (unsigned char *)p + hdr->size + page_size - hdr->map_len;
+	munmap(map, hdr->map_len);
+}
+
+/* Memory pipes */
+typedef struct {
+	unsigned char buf[1 << 17];
+	size_t rd, wr;
+} pipe_t;
+
+typedef struct {
+	pipe_t *tx, *rx;
+} endpoint_t;
+
+static pipe_t c2s, s2c;
+
+static int pipe_send(void *ctx, const unsigned char *buf, size_t len)
+{
+	pipe_t *p = ((endpoint_t *)ctx)->tx;
+
+	if (len > sizeof(p->buf) - p->wr)
+		len = sizeof(p->buf) - p->wr;
+	if (len == 0)
+		return MBEDTLS_ERR_SSL_WANT_WRITE;
+	memcpy(p->buf + p->wr, buf, len);
+	p->wr += len;
+	return (int)len;
+}
+
+static int pipe_recv(void *ctx, unsigned char *buf, size_t len)
+{
+	pipe_t *p = ((endpoint_t *)ctx)->rx;
+	size_t avail = p->wr - p->rd;
+
+	if (avail == 0)
+		return MBEDTLS_ERR_SSL_WANT_READ;
+	if (len > avail)
+		len = avail;
+	memcpy(buf, p->buf + p->rd, len);
+	p->rd += len;
+	if (p->rd == p->wr)
+		p->rd = p->wr = 0;
+	return (int)len;
+}
+
+static unsigned int rnd_state = 1;
+
+static int rnd(void *ctx, unsigned char *out, size_t len)
+{
+	(void)ctx;
+	while (len--) {
+		rnd_state = rnd_state * 1103515245 + 12345;
+		*out++ = (unsigned char)(rnd_state >> 16);
+	}
+	return 0;
+}
+
+static unsigned char tx_data[20000], rx_data[20000];
+
+/* Case being run, reported when a guard page is hit */
+static int cur_suite, cur_etm, cur_mfl;
+static size_t cur_len;
+
+static void guard_hit(int sig)
+{
+	char msg[128];
+	int n;
+
+	(void)sig;
+	n = snprintf(msg, sizeof(msg), "guard page hit: %s etm %d mfl %d, %u bytes\n",
+	             mbedtls_ssl_get_ciphersuite_name(cur_suite), cur_etm, cur_mfl,
+	             (unsigned)cur_len);
+	if (n > 0)
+		(void)write(STDOUT_FILENO, msg, (size_t)n);
+	_exit(1);
+}
+
+static int transfer(mbedtls_ssl_context *tx, mbedtls_ssl_context *rx, size_t len)
+{
+	size_t sent = 0, got = 0;
+	int ret;
+
+	rnd(NULL, tx_data, len);
+	while (got < len) {
+		if (sent < len) {
+			ret = mbedtls_ssl_write(tx, tx_data + sent, len - sent);
+			if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+				printf("write -0x%04x\n", -ret);
+				return -1;
+			}
+			if (ret > 0)
+				sent += ret;
+		}
+		ret = mbedtls_ssl_read(rx, rx_data + got, len - got);
+		if (ret == MBEDTLS_ERR_SSL_WANT_READ)
+			continue;
+		if (ret <= 0) {
+			printf("read -0x%04x\n", -ret);
+			return -1;
+		}
+		got += ret;
+	}
+	if (memcmp(tx_data, rx_data, len) != 0) {
+		printf("data mismatch\n");
+		return -1;
+	}
+	return 0;
+}
+
+static int run(int suite, int etm, int mfl, size_t max_len)
+{
+	int suites[2] = { suite, 0 };
+	endpoint_t cli_ep = { &c2s, &s2c }, srv_ep = { &s2c, &c2s };
+	mbedtls_ssl_context cli, srv;
+	mbedtls_ssl_config cli_conf, srv_conf;
+	mbedtls_x509_crt crt;
+	mbedtls_pk_context key;
+	size_t len, min_in = (size_t)-1, max_in = 0;
+	int cli_ret = 1, srv_ret = 1, ret = -1;
+
+	c2s.rd = c2s.wr = s2c.rd = s2c.wr = 0;
+	mbedtls_x509_crt_init(&crt);
+	mbedtls_pk_init(&key);
+	mbedtls_ssl_config_init(&cli_conf);
+	mbedtls_ssl_config_init(&srv_conf);
+	mbedtls_ssl_init(&cli);
+	mbedtls_ssl_init(&srv);
+
+	if (mbedtls_x509_crt_parse(&crt, (const unsigned char *)mbedtls_test_srv_crt_ec,
+	                           mbedtls_test_srv_crt_ec_len) != 0 ||
+	    mbedtls_pk_parse_key(&key, (const unsigned char *)mbedtls_test_srv_key_ec,
+	                         mbedtls_test_srv_key_ec_len, NULL, 0) != 0) {
+		printf("test certificate\n");
+		goto out;
+	}
+	mbedtls_ssl_config_defaults(&cli_conf, MBEDTLS_SSL_IS_CLIENT,
+	                            MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+	mbedtls_ssl_config_defaults(&srv_conf, MBEDTLS_SSL_IS_SERVER,
+	                            MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+	mbedtls_ssl_conf_rng(&cli_conf, rnd, NULL);
+	mbedtls_ssl_conf_rng(&srv_conf, rnd, NULL);
+	mbedtls_ssl_conf_authmode(&cli_conf, MBEDTLS_SSL_VERIFY_NONE);
+	mbedtls_ssl_conf_ciphersuites(&cli_conf, suites);
+	mbedtls_ssl_conf_encrypt_then_mac(&cli_conf, etm ? MBEDTLS_SSL_ETM_ENABLED
+	                                                 : MBEDTLS_SSL_ETM_DISABLED);
+	mbedtls_ssl_conf_max_frag_len(&cli_conf, (unsigned char)mfl);
+	if (mbedtls_ssl_conf_own_cert(&srv_conf, &crt, &key) != 0 ||
+	    mbedtls_ssl_setup(&cli, &cli_conf) != 0 ||
+	    mbedtls_ssl_setup(&srv, &srv_conf) != 0) {
+		printf("setup\n");
+		goto out;
+	}
+	mbedtls_ssl_set_bio(&cli, &cli_ep, pipe_send, pipe_recv, NULL);
+	mbedtls_ssl_set_bio(&srv, &srv_ep, pipe_send, pipe_recv, NULL);
+
+	while (cli_ret != 0 || srv_ret != 0) {
+		if (cli_ret != 0) {
+			cli_ret = mbedtls_ssl_handshake(&cli);
+			if (cli_ret != 0 && cli_ret != MBEDTLS_ERR_SSL_WANT_READ) {
+				printf("client handshake -0x%04x\n", -cli_ret);
+				goto out;
+			}
+		}
+		if (srv_ret != 0) {
+			srv_ret = mbedtls_ssl_handshake(&srv);
+			if (srv_ret != 0 && srv_ret != MBEDTLS_ERR_SSL_WANT_READ) {
+				printf("server handshake -0x%04x\n", -srv_ret);
+				goto out;
+			}
+		}
+	}
+
+	cur_suite = suite;
+	cur_etm = etm;
+	cur_mfl = mfl;
+	for (len = 1; len <= max_len; len++) {
+		cur_len = len;
+		mbedtls_ssl_shrink_buffers(&cli);
+		mbedtls_ssl_shrink_buffers(&srv);
+		if (srv.in_buf_len < min_in)
+			min_in = srv.in_buf_len;
+		if (transfer(&cli, &srv, len) != 0 || transfer(&srv, &cli, len) != 0) {
+			printf("transfer of %u bytes\n", (unsigned)len);
+			goto out;
+		}
+		if (srv.in_buf_len > max_in)
+			max_in = srv.in_buf_len;
+	}
+	printf("%-40s etm %d mfl %d: 1..%u bytes, input buffer %u..%u\n",
+	       mbedtls_ssl_get_ciphersuite(&cli), etm, mfl, (unsigned)max_len,
+	       (unsigned)min_in, (unsigned)max_in);
+	ret = 0;
+
+out:
+	mbedtls_ssl_free(&cli);
+	mbedtls_ssl_free(&srv);
+	mbedtls_ssl_config_free(&cli_conf);
+	mbedtls_ssl_config_free(&srv_conf);
+	mbedtls_x509_crt_free(&crt);
+	mbedtls_pk_free(&key);
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	static const int suites[] = {
+		MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_CBC_SHA256,
+		MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_256_CBC_SHA,
+		MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+	};
+	size_t max_len = argc > 1 ? strtoul(argv[1], NULL, 0) : 5000;
+	unsigned int i;
+	int etm, mfl;
+
+	if (max_len == 0 || max_len > sizeof(tx_data)) {
+		printf("max_len 1..%u\n", (unsigned)sizeof(tx_data));
+		return 2;
+	}
+	page_size = (size_t)sysconf(_SC_PAGESIZE);
+	signal(SIGSEGV, guard_hit);
+	mbedtls_platform_set_calloc_free(guard_calloc, guard_free);
+
+	for (i = 0; i < sizeof(suites) / sizeof(suites[0]); i++) {
+		for (etm = 0; etm <= 1; etm++) {
+			for (mfl = MBEDTLS_SSL_MAX_FRAG_LEN_NONE;
+			     mfl <= MBEDTLS_SSL_MAX_FRAG_LEN_2048; mfl += 3) {
+				if (run(suites[i], etm, mfl, max_len) != 0)
+					return 1;
+			}
+		}
+	}
+	printf("ok\n");
+	return 0;
+}
@@ -0,0 +1,505 @@
+/*
+ * Copyright (C) 2017 XRADIO TECHNOLOGY CO., LTD. All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *    1. Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the
+ *       distribution.
+ *    3. Neither the name of XRADIO TECHNOLOGY CO., LTD. nor the names of
+ *       its contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *  OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Host benchmark of the shared trust store (mbedtls_trust_store_get()).
+ *
+ * usage: trust_bench [threads] [handshakes] [latency_ms]
+ *
+ * parse: cost of the CA bundle, the own certificate and key, parsed for each
+ * connection as the clients did before, against a store lookup, which hashes
+ * the same input with SHA-256. The CA bundle is also parsed from DER in place
+ * (param.ca_in_place). Heap is the memory held by the parsed objects.
+ *
+ * handshake: the threads run handshakes with client authentication, all of
+ * them on one CA chain and one certificate/key per side, the way connections
+ * share a store. The certificates are locked through
+ * mbedtls_ssl_conf_cert_lock(), as mbedtls_trust_store_attach() does, and
+ * then, for comparison, around the whole handshake. Each flight waits
+ * latency_ms for the link, during which the other threads can run, as the
+ * clients sleep in their handshake loops on the device.
+ *
+ * The store itself (src/net/mbedtls-2.16.0/mbedtls.c) needs the RTOS, so the
+ * benchmark does its work with the library directly.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "mbedtls/platform.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/certs.h"
+#include "mbedtls/x509_crt.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/sha256.h"
+
+#define MAX_THREADS     16
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/* Allocator counting the bytes in use */
+static pthread_mutex_t heap_mutex = PTHREAD_MUTEX_INITIALIZER;
+static size_t heap_used;
+
+static void *cnt_calloc(size_t n, size_t size)
+{
+	size_t *p;
+
+	if (n != 0 && size > ((size_t)-1 - 16) / n)
+		return NULL;
+	p = calloc(1, n * size + 16);
+	if (p == NULL)
+		return NULL;
+	p[0] = n * size;
+	pthread_mutex_lock(&heap_mutex);
+	heap_used += p[0];
+	pthread_mutex_unlock(&heap_mutex);
+	return (unsigned char *)p + 16;
+}
+
+static void cnt_free(void *ptr)
+{
+	size_t *p;
+
+	if (ptr == NULL)
+		return;
+	p = (size_t *)((unsigned char *)ptr - 16);
+	pthread_mutex_lock(&heap_mutex);
+	heap_used -= p[0];
+	pthread_mutex_unlock(&heap_mutex);
+	free(p);
+}
+
+/* Credentials of a connection, as in mbedtls_trust_param */
+typedef struct {
+	mbedtls_x509_crt   ca;
+	mbedtls_x509_crt   cert;
+	mbedtls_pk_context key;
+} creds_t;
+
+static void creds_init(creds_t *c)
+{
+	mbedtls_x509_crt_init(&c->ca);
+	mbedtls_x509_crt_init(&c->cert);
+	mbedtls_pk_init(&c->key);
+}
+
+static void creds_free(creds_t *c)
+{
+	mbedtls_x509_crt_free(&c->ca);
+	mbedtls_x509_crt_free(&c->cert);
+	mbedtls_pk_free(&c->key);
+}
+
+static int creds_parse(creds_t *c, const char *cert, size_t cert_len,
+                       const char *key, size_t key_len)
+{
+	if (mbedtls_x509_crt_parse(&c->ca, (const unsigned char *)mbedtls_test_cas_pem,
+	                           mbedtls_test_cas_pem_len) != 0 ||
+	    mbedtls_x509_crt_parse(&c->cert, (const unsigned char *)cert, cert_len) != 0 ||
+	    mbedtls_pk_parse_key(&c->key, (const unsigned char *)key, key_len, NULL, 0) != 0)
+		return -1;
+	return 0;
+}
+
+/* The CA bundle as concatenated DER, as stored in flash */
+static unsigned char ca_der[8192];
+static size_t ca_der_len;
+static struct {
+	size_t off, len;
+} ca_der_crt[8];
+static int ca_der_num;
+
+static int ca_der_make(void)
+{
+	mbedtls_x509_crt ca, *crt;
+
+	mbedtls_x509_crt_init(&ca);
+	if (mbedtls_x509_crt_parse(&ca, (const unsigned char *)mbedtls_test_cas_pem,
+	                           mbedtls_test_cas_pem_len) != 0) {
+		mbedtls_x509_crt_free(&ca);
+		return -1;
+	}
+	for (crt = &ca; crt != NULL && crt->raw.len != 0; crt = crt->next) {
+		if (ca_der_num == sizeof(ca_der_crt) / sizeof(ca_der_crt[0]) ||
+		    crt->raw.len > sizeof(ca_der) - ca_der_len)
+			break;
+		memcpy(ca_der + ca_der_len, crt->raw.p, crt->raw.len);
+		ca_der_crt[ca_der_num].off = ca_der_len;
+		ca_der_crt[ca_der_num].len = crt->raw.len;
+		ca_der_len += crt->raw.len;
+		ca_der_num++;
+	}
+	mbedtls_x509_crt_free(&ca);
+	return 0;
+}
+
+static int bench_parse(int iters)
+{
+	creds_t c;
+	mbedtls_x509_crt ca;
+	unsigned char digest[32];
+	size_t base, conn_heap = 0, der_heap = 0;
+	uint64_t t;
+	double conn_us, der_us, lookup_us;
+	int i, j, n;
+
+	if (ca_der_make() != 0) {
+		printf("test certificates\n");
+		return -1;
+	}
+
+	/* Per connection: PEM bundle, own certificate and key */
+	t = now_ns();
+	for (i = 0; i < iters; i++) {
+		base = heap_used;
+		creds_init(&c);
+		if (creds_parse(&c, mbedtls_test_cli_crt_ec, mbedtls_test_cli_crt_ec_len,
+		                mbedtls_test_cli_key_ec, mbedtls_test_cli_key_ec_len) != 0) {
+			printf("parse\n");
+			creds_free(&c);
+			return -1;
+		}
+		conn_heap = heap_used - base;
+		creds_free(&c);
+	}
+	conn_us = (now_ns() - t) / 1000.0 / iters;
+
+	/* CA bundle from DER in place */
+	t = now_ns();
+	for (i = 0; i < iters; i++) {
+		base = heap_used;
+		mbedtls_x509_crt_init(&ca);
+		for (j = 0; j < ca_der_num; j++) {
+			if (mbedtls_x509_crt_parse_der_nocopy(&ca, ca_der + ca_der_crt[j].off,
+			                                      ca_der_crt[j].len) != 0) {
+				printf("parse in place\n");
+				mbedtls_x509_crt_free(&ca);
+				return -1;
+			}
+		}
+		der_heap = heap_used - base;
+		mbedtls_x509_crt_free(&ca);
+	}
+	der_us = (now_ns() - t) / 1000.0 / iters;
+
+	/* Store lookup: digest of the input */
+	t = now_ns();
+	for (i = 0; i < iters * 10; i++) {
+		mbedtls_sha256_context sha;
+
+		mbedtls_sha256_init(&sha);
+		mbedtls_sha256_starts_ret(&sha, 0);
+		mbedtls_sha256_update_ret(&sha, (const unsigned char *)mbedtls_test_cas_pem,
+		                          mbedtls_test_cas_pem_len);
+		mbedtls_sha256_update_ret(&sha, (const unsigned char *)mbedtls_test_cli_crt_ec,
+		                          mbedtls_test_cli_crt_ec_len);
+		mbedtls_sha256_update_ret(&sha, (const unsigned char *)mbedtls_test_cli_key_ec,
+		                          mbedtls_test_cli_key_ec_len);
+		mbedtls_sha256_finish_ret(&sha, digest);
+		mbedtls_sha256_free(&sha);
+	}
+	lookup_us = (now_ns() - t) / 1000.0 / (iters * 10);
+
+	printf("parse: CA bundle of %d certificates (%u bytes PEM, %u DER), "
+	       "EC certificate and key\n", ca_der_num,
+	       (unsigned)mbedtls_test_cas_pem_len, (unsigned)ca_der_len);
+	printf("  %-32s %9.1f us %7u bytes\n", "per connection (PEM)", conn_us,
+	       (unsigned)conn_heap);
+	printf("  %-32s %9.1f us %7u bytes\n", "CA bundle, DER in place", der_us,
+	       (unsigned)der_heap);
+	printf("  %-32s %9.1f us %7u bytes\n", "store lookup (SHA-256)", lookup_us, 0);
+	printf("  %-12s %14s %14s %14s\n", "connections", "heap before", "heap store",
+	       "saved");
+	for (n = 1; n <= 8; n *= 2)
+		printf("  %-12d %14u %14u %14u\n", n, (unsigned)(conn_heap * n),
+		       (unsigned)conn_heap, (unsigned)(conn_heap * (n - 1)));
+	return 0;
+}
+
+/* Memory pipes, one pair per thread */
+typedef struct {
+	unsigned char buf[1 << 14];
+	size_t rd, wr;
+} pipe_t;
+
+typedef struct {
+	pipe_t *tx, *rx;
+} endpoint_t;
+
+static int pipe_send(void *ctx, const unsigned char *buf, size_t len)
+{
+	pipe_t *p = ((endpoint_t *)ctx)->tx;
+
+	if (len > sizeof(p->buf) - p->wr)
+		len = sizeof(p->buf) - p->wr;
+	if (len == 0)
+		return MBEDTLS_ERR_SSL_WANT_WRITE;
+	memcpy(p->buf + p->wr, buf, len);
+	p->wr += len;
+	return (int)len;
+}
+
+static int pipe_recv(void *ctx, unsigned char *buf, size_t len)
+{
+	pipe_t *p = ((endpoint_t *)ctx)->rx;
+	size_t avail = p->wr - p->rd;
+
+	if (avail == 0)
+		return MBEDTLS_ERR_SSL_WANT_READ;
+	if (len > avail)
+		len = avail;
+	memcpy(buf, p->buf + p->rd, len);
+	p->rd += len;
+	if (p->rd == p->wr)
+		p->rd = p->wr = 0;
+	return (int)len;
+}
+
+static int rnd(void *ctx, unsigned char *out, size_t len)
+{
+	unsigned int *state = ctx;
+
+	while (len--) {
+		*state = *state * 1103515245 + 12345;
+		*out++ = (unsigned char)(*state >> 16);
+	}
+	return 0;
+}
+
+/* Shared credentials and their lock, as mbedtls_trust_store_use() */
+static creds_t srv_creds, cli_creds;
+static pthread_mutex_t use_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t use_start, use_total, use_max;
+static unsigned int use_cnt;
+
+static void cert_lock(void *p, int lock)
+{
+	uint64_t t;
+
+	(void)p;
+	if (lock) {
+		pthread_mutex_lock(&use_mutex);
+		use_start = now_ns();
+	} else {
+		t = now_ns() - use_start;
+		use_total += t;
+		if (t > use_max)
+			use_max = t;
+		use_cnt++;
+		pthread_mutex_unlock(&use_mutex);
+	}
+}
+
+typedef struct {
+	pthread_t    thread;
+	pipe_t       c2s, s2c;
+	unsigned int rnd_state;
+	int          handshakes;
+	int          whole;         /* lock around the whole handshake */
+	int          latency_ms;
+	int          ret;
+	uint64_t     hs_total;
+} worker_t;
+
+static int handshake(worker_t *w)
+{
+	static const int suites[] = {
+		MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256, 0
+	};
+	endpoint_t cli_ep = { &w->c2s, &w->s2c }, srv_ep = { &w->s2c, &w->c2s };
+	mbedtls_ssl_context cli, srv;
+	mbedtls_ssl_config cli_conf, srv_conf;
+	int cli_ret = 1, srv_ret = 1, ret = -1;
+
+	w->c2s.rd = w->c2s.wr = w->s2c.rd = w->s2c.wr = 0;
+	mbedtls_ssl_config_init(&cli_conf);
+	mbedtls_ssl_config_init(&srv_conf);
+	mbedtls_ssl_init(&cli);
+	mbedtls_ssl_init(&srv);
+
+	mbedtls_ssl_config_defaults(&cli_conf, MBEDTLS_SSL_IS_CLIENT,
+	                            MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+	mbedtls_ssl_config_defaults(&srv_conf, MBEDTLS_SSL_IS_SERVER,
+	                            MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+	mbedtls_ssl_conf_rng(&cli_conf, rnd, &w->rnd_state);
+	mbedtls_ssl_conf_rng(&srv_conf, rnd, &w->rnd_state);
+	mbedtls_ssl_conf_ciphersuites(&cli_conf, suites);
+	mbedtls_ssl_conf_authmode(&cli_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+	mbedtls_ssl_conf_authmode(&srv_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+	mbedtls_ssl_conf_ca_chain(&cli_conf, &cli_creds.ca, NULL);
+	mbedtls_ssl_conf_ca_chain(&srv_conf, &srv_creds.ca, NULL);
+	if (!w->whole) {
+		mbedtls_ssl_conf_cert_lock(&cli_conf, cert_lock, NULL);
+		mbedtls_ssl_conf_cert_lock(&srv_conf, cert_lock, NULL);
+	}
+	if (mbedtls_ssl_conf_own_cert(&cli_conf, &cli_creds.cert, &cli_creds.key) != 0 ||
+	    mbedtls_ssl_conf_own_cert(&srv_conf, &srv_creds.cert, &srv_creds.key) != 0 ||
+	    mbedtls_ssl_setup(&cli, &cli_conf) != 0 ||
+	    mbedtls_ssl_setup(&srv, &srv_conf) != 0 ||
+	    mbedtls_ssl_set_hostname(&cli, "localhost") != 0) {
+		printf("setup\n");
+		goto out;
+	}
+	mbedtls_ssl_set_bio(&cli, &cli_ep, pipe_send, pipe_recv, NULL);
+	mbedtls_ssl_set_bio(&srv, &srv_ep, pipe_send, pipe_recv, NULL);
+
+	if (w->whole)
+		cert_lock(NULL, 1);
+	while (cli_ret != 0 || srv_ret != 0) {
+		struct timespec link = { 0, w->latency_ms * 1000000L };
+
+		nanosleep(&link, NULL);
+		if (cli_ret != 0) {
+			cli_ret = mbedtls_ssl_handshake(&cli);
+			if (cli_ret != 0 && cli_ret != MBEDTLS_ERR_SSL_WANT_READ) {
+				printf("client handshake -0x%04x\n", -cli_ret);
+				break;
+			}
+		}
+		if (srv_ret != 0) {
+			srv_ret = mbedtls_ssl_handshake(&srv);
+			if (srv_ret != 0 && srv_ret != MBEDTLS_ERR_SSL_WANT_READ) {
+				printf("server handshake -0x%04x\n", -srv_ret);
+				break;
+			}
+		}
+	}
+	if (w->whole)
+		cert_lock(NULL, 0);
+	if (cli_ret == 0 && srv_ret == 0)
+		ret = 0;
+
+out:
+	mbedtls_ssl_free(&cli);
+	mbedtls_ssl_free(&srv);
+	mbedtls_ssl_config_free(&cli_conf);
+	mbedtls_ssl_config_free(&srv_conf);
+	return ret;
+}
+
+static void *worker(void *arg)
+{
+	worker_t *w = arg;
+	uint64_t t;
+	int i;
+
+	w->ret = 0;
+	for (i = 0; i < w->handshakes; i++) {
+		t = now_ns();
+		if (handshake(w) != 0) {
+			w->ret = -1;
+			break;
+		}
+		w->hs_total += now_ns() - t;
+	}
+	return NULL;
+}
+
+static int bench_handshake(int threads, int handshakes, int latency_ms, int whole)
+{
+	static worker_t workers[MAX_THREADS];
+	uint64_t t, hs_total = 0;
+	int i, ret = 0;
+
+	use_total = use_max = 0;
+	use_cnt = 0;
+	t = now_ns();
+	for (i = 0; i < threads; i++) {
+		memset(&workers[i], 0, sizeof(workers[i]));
+		workers[i].rnd_state = i + 1;
+		workers[i].handshakes = handshakes;
+		workers[i].whole = whole;
+		workers[i].latency_ms = latency_ms;
+		pthread_create(&workers[i].thread, NULL, worker, &workers[i]);
+	}
+	for (i = 0; i < threads; i++) {
+		pthread_join(workers[i].thread, NULL);
+		if (workers[i].ret != 0)
+			ret = -1;
+		hs_total += workers[i].hs_total;
+	}
+	t = now_ns() - t;
+	if (ret != 0)
+		return ret;
+
+	printf("  %-22s %8.1f hs/s %8.2f ms/hs %8.2f ms held/hs %6.1f%% %8.2f ms max\n",
+	       whole ? "lock whole handshake" : "lock per operation",
+	       threads * handshakes / (t / 1e9), hs_total / 1e6 / (threads * handshakes),
+	       use_total / 1e6 / (threads * handshakes), 100.0 * use_total / hs_total,
+	       use_max / 1e6);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	int threads = argc > 1 ? atoi(argv[1]) : 4;
+	int handshakes = argc > 2 ? atoi(argv[2]) : 50;
+	int latency_ms = argc > 3 ? atoi(argv[3]) : 10;
+
+	if (threads < 1 || threads > MAX_THREADS || handshakes < 1 ||
+	    latency_ms < 0 || latency_ms > 999) {
+		printf("usage: trust_bench [threads 1..%d] [handshakes] [latency_ms 0..999]\n",
+		       MAX_THREADS);
+		return 2;
+	}
+	mbedtls_platform_set_calloc_free(cnt_calloc, cnt_free);
+
+	if (bench_parse(200) != 0)
+		return 1;
+
+	creds_init(&srv_creds);
+	creds_init(&cli_creds);
+	if (creds_parse(&srv_creds, mbedtls_test_srv_crt_ec, mbedtls_test_srv_crt_ec_len,
+	                mbedtls_test_srv_key_ec, mbedtls_test_srv_key_ec_len) != 0 ||
+	    creds_parse(&cli_creds, mbedtls_test_cli_crt_ec, mbedtls_test_cli_crt_ec_len,
+	                mbedtls_test_cli_key_ec, mbedtls_test_cli_key_ec_len) != 0) {
+		printf("test certificates\n");
+		return 1;
+	}
+	printf("handshake: %d threads x %d, %d ms per flight, ECDHE-ECDSA with client "
+	       "authentication, shared CA chain, certificates and keys\n",
+	       threads, handshakes, latency_ms);
+	if (bench_handshake(threads, handshakes, latency_ms, 0) != 0 ||
+	    bench_handshake(threads, handshakes, latency_ms, 1) != 0)
+		return 1;
+	creds_free(&srv_creds);
+	creds_free(&cli_creds);
+	printf("ok\n");
+	return 0;
+}